@@ -0,0 +1,335 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "../Interfaces/IAsyncFileSystem.h"
+#include "../Interfaces/ILogManager.h"
+#include "../Interfaces/IMemoryManager.h"
+
+struct AsyncReadRequest
+{
+	String				mFileName;
+	uint64_t			mOffset;
+	uint64_t			mSize;
+	volatile uint64_t	mBytesRead;
+	void*				pDestination;
+	bool				mOwnsDestination;
+	AsyncReadPriority	mPriority;
+	AsyncReadCallback	pCallback;
+	void*				pUserData;
+	volatile AsyncReadStatus	mStatus;
+	volatile bool		mCancelRequested;
+};
+
+// The last file is kept open per I/O thread since bundles are usually read range by range
+struct AsyncReadFileCache
+{
+	String		mFileName;
+	FileHandle	pHandle;
+};
+
+static FileHandle OpenCached(AsyncReadFileCache* pCache, const String& fileName)
+{
+	if (pCache->pHandle && pCache->mFileName == fileName)
+		return pCache->pHandle;
+
+	if (pCache->pHandle)
+		_closeFile(pCache->pHandle);
+
+	pCache->pHandle = _openFile(fileName.c_str(), "rb");
+	pCache->mFileName = pCache->pHandle ? fileName : String();
+	return pCache->pHandle;
+}
+
+static AsyncReadStatus ExecuteRequest(AsyncReadRequest* pRequest, AsyncReadFileCache* pCache)
+{
+	FileHandle handle = OpenCached(pCache, pRequest->mFileName);
+	if (!handle)
+	{
+		LOGERRORF("Could not open file %s", pRequest->mFileName.c_str());
+		return ASYNC_READ_STATUS_FAILED;
+	}
+
+	if (pRequest->mSize == ASYNC_READ_WHOLE_FILE)
+	{
+		uint64_t fileSize = FileSystem::GetFileSize64(handle);
+		pRequest->mSize = fileSize > pRequest->mOffset ? fileSize - pRequest->mOffset : 0;
+	}
+
+	if (!pRequest->pDestination)
+	{
+		pRequest->pDestination = conf_malloc((size_t)pRequest->mSize);
+		pRequest->mOwnsDestination = true;
+	}
+
+	if (!_seekFile64(handle, (int64_t)pRequest->mOffset, SEEK_SET))
+	{
+		LOGERRORF("Could not seek to %llu in file %s", (unsigned long long)pRequest->mOffset, pRequest->mFileName.c_str());
+		return ASYNC_READ_STATUS_FAILED;
+	}
+
+	uint8_t* pDst = (uint8_t*)pRequest->pDestination;
+	while (pRequest->mBytesRead < pRequest->mSize)
+	{
+		if (pRequest->mCancelRequested)
+			return ASYNC_READ_STATUS_CANCELED;
+
+		uint64_t chunkSize = min(pRequest->mSize - pRequest->mBytesRead, (uint64_t)ASYNC_READ_CHUNK_SIZE);
+		size_t bytesRead = _readFile(pDst + pRequest->mBytesRead, (size_t)chunkSize, handle);
+		pRequest->mBytesRead += bytesRead;
+		if (bytesRead != chunkSize)
+		{
+			LOGERRORF("Read past the end of file %s (%llu of %llu bytes)", pRequest->mFileName.c_str(),
+				(unsigned long long)pRequest->mBytesRead, (unsigned long long)pRequest->mSize);
+			return ASYNC_READ_STATUS_FAILED;
+		}
+	}
+
+	return ASYNC_READ_STATUS_COMPLETED;
+}
+
+AsyncFileQueue::AsyncFileQueue() :
+	mThreadCount(0),
+	mActiveCount(0),
+	mShutDown(false)
+{
+}
+
+AsyncFileQueue::~AsyncFileQueue()
+{
+	Exit();
+}
+
+void AsyncFileQueue::Init(uint32_t threadCount)
+{
+	ASSERT(mThreadCount == 0);
+	mThreadCount = clamp(threadCount, 1U, (uint32_t)ASYNC_READ_MAX_THREADS);
+	mShutDown = false;
+
+	for (uint32_t i = 0; i < mThreadCount; ++i)
+	{
+		mThreadItems[i].pFunc = ProcessRequests;
+		mThreadItems[i].pData = this;
+		mThreads[i] = _createThread(&mThreadItems[i]);
+	}
+}
+
+void AsyncFileQueue::Exit()
+{
+	if (!mThreadCount)
+		return;
+
+	// Drop everything which has not started yet, the I/O threads finish their current chunk
+	tinystl::vector<AsyncReadRequest*> canceled;
+	{
+		MutexLock lock(mMutex);
+		for (uint32_t i = 0; i < ASYNC_READ_PRIORITY_COUNT; ++i)
+		{
+			canceled.insert(canceled.end(), mQueues[i].begin(), mQueues[i].end());
+			mQueues[i].clear();
+		}
+		mShutDown = true;
+	}
+	for (uint32_t i = 0; i < (uint32_t)canceled.size(); ++i)
+		Finish(canceled[i], ASYNC_READ_STATUS_CANCELED);
+
+	mWorkCondition.SetAll();
+	for (uint32_t i = 0; i < mThreadCount; ++i)
+		_destroyThread(mThreads[i]);
+
+	mThreadCount = 0;
+}
+
+AsyncReadHandle AsyncFileQueue::Submit(const AsyncReadDesc* pDesc)
+{
+	ASSERT(mThreadCount && "AsyncFileQueue::Init has to be called before submitting requests");
+	ASSERT(pDesc->pFileName);
+	ASSERT(pDesc->mPriority < ASYNC_READ_PRIORITY_COUNT);
+	// The queue cannot know the capacity of a user buffer
+	ASSERT(!pDesc->pDestination || pDesc->mSize != ASYNC_READ_WHOLE_FILE);
+
+	AsyncReadRequest* pRequest = conf_placement_new<AsyncReadRequest>(conf_calloc(1, sizeof(AsyncReadRequest)));
+	pRequest->mFileName = FileSystem::FixPath(pDesc->pFileName, pDesc->mRoot);
+	pRequest->mOffset = pDesc->mOffset;
+	pRequest->mSize = pDesc->mSize;
+	pRequest->pDestination = pDesc->pDestination;
+	pRequest->mPriority = pDesc->mPriority;
+	pRequest->pCallback = pDesc->pCallback;
+	pRequest->pUserData = pDesc->pUserData;
+	pRequest->mStatus = ASYNC_READ_STATUS_PENDING;
+
+	{
+		MutexLock lock(mMutex);
+		mQueues[pDesc->mPriority].push_back(pRequest);
+	}
+	mWorkCondition.Set();
+
+	return pRequest;
+}
+
+bool AsyncFileQueue::Cancel(AsyncReadHandle handle)
+{
+	{
+		MutexLock lock(mMutex);
+		if (handle->mStatus == ASYNC_READ_STATUS_IN_PROGRESS)
+		{
+			handle->mCancelRequested = true;
+			return true;
+		}
+		if (handle->mStatus != ASYNC_READ_STATUS_PENDING)
+			return false;
+
+		tinystl::vector<AsyncReadRequest*>& queue = mQueues[handle->mPriority];
+		for (AsyncReadRequest** it = queue.begin(); it != queue.end(); ++it)
+		{
+			if (*it == handle)
+			{
+				queue.erase(it);
+				break;
+			}
+		}
+		// Keeps a racing I/O thread from picking it up while the callback runs outside the lock
+		handle->mStatus = ASYNC_READ_STATUS_IN_PROGRESS;
+	}
+
+	Finish(handle, ASYNC_READ_STATUS_CANCELED);
+	return true;
+}
+
+AsyncReadStatus AsyncFileQueue::GetStatus(AsyncReadHandle handle)
+{
+	MutexLock lock(mMutex);
+	return handle->mStatus;
+}
+
+AsyncReadStatus AsyncFileQueue::Wait(AsyncReadHandle handle)
+{
+	MutexLock lock(mMutex);
+	while (handle->mStatus == ASYNC_READ_STATUS_PENDING || handle->mStatus == ASYNC_READ_STATUS_IN_PROGRESS)
+		mDoneCondition.Wait(mMutex);
+	return handle->mStatus;
+}
+
+void AsyncFileQueue::WaitIdle()
+{
+	MutexLock lock(mMutex);
+	while (mActiveCount || GetPendingCountUnlocked())
+		mDoneCondition.Wait(mMutex);
+}
+
+uint64_t AsyncFileQueue::GetBytesRead(AsyncReadHandle handle)
+{
+	return handle->mBytesRead;
+}
+
+void* AsyncFileQueue::GetData(AsyncReadHandle handle)
+{
+	MutexLock lock(mMutex);
+	return handle->pDestination;
+}
+
+void AsyncFileQueue::Release(AsyncReadHandle handle)
+{
+	Wait(handle);
+
+	if (handle->mOwnsDestination)
+		conf_free(handle->pDestination);
+	handle->~AsyncReadRequest();
+	conf_free(handle);
+}
+
+uint32_t AsyncFileQueue::GetPendingCount()
+{
+	MutexLock lock(mMutex);
+	return GetPendingCountUnlocked();
+}
+
+uint32_t AsyncFileQueue::GetPendingCountUnlocked() const
+{
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < ASYNC_READ_PRIORITY_COUNT; ++i)
+		count += (uint32_t)mQueues[i].size();
+	return count;
+}
+
+AsyncReadRequest* AsyncFileQueue::PopRequest()
+{
+	for (uint32_t i = ASYNC_READ_PRIORITY_COUNT; i-- > 0;)
+	{
+		tinystl::vector<AsyncReadRequest*>& queue = mQueues[i];
+		if (!queue.empty())
+		{
+			AsyncReadRequest* pRequest = queue[0];
+			queue.erase(queue.begin());
+			return pRequest;
+		}
+	}
+	return NULL;
+}
+
+void AsyncFileQueue::Finish(AsyncReadRequest* pRequest, AsyncReadStatus status)
+{
+	// The callback runs before the status becomes final so Wait / Release cannot free the request underneath it
+	if (pRequest->pCallback)
+		pRequest->pCallback(pRequest, status, pRequest->pUserData);
+
+	{
+		MutexLock lock(mMutex);
+		pRequest->mStatus = status;
+	}
+	// Wait and WaitIdle can block on different threads at the same time
+	mDoneCondition.SetAll();
+}
+
+void AsyncFileQueue::ProcessRequests(void* pData)
+{
+	AsyncFileQueue* pQueue = (AsyncFileQueue*)pData;
+	AsyncReadFileCache cache;
+	cache.pHandle = NULL;
+
+	for (;;)
+	{
+		AsyncReadRequest* pRequest = NULL;
+		{
+			MutexLock lock(pQueue->mMutex);
+			while (!pQueue->mShutDown && (pRequest = pQueue->PopRequest()) == NULL)
+				pQueue->mWorkCondition.Wait(pQueue->mMutex);
+			if (!pRequest)
+				break;
+			pRequest->mStatus = ASYNC_READ_STATUS_IN_PROGRESS;
+			++pQueue->mActiveCount;
+		}
+
+		AsyncReadStatus status = ExecuteRequest(pRequest, &cache);
+		pQueue->Finish(pRequest, status);
+
+		{
+			MutexLock lock(pQueue->mMutex);
+			--pQueue->mActiveCount;
+		}
+		pQueue->mDoneCondition.SetAll();
+	}
+
+	if (cache.pHandle)
+		_closeFile(cache.pHandle);
+}
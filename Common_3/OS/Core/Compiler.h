@@ -32,7 +32,8 @@
 #define UNREF_PARAM(x) (x)
 #else
 //Add more compilers and platforms as we need them
-#define UNREF_PARAM(x) (x)
+//GCC and Clang warn about a bare (x) statement, the void cast silences both warnings
+#define UNREF_PARAM(x) ((void)(x))
 #endif
 
 
@@ -0,0 +1,445 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "ContentHash.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CRC32C_HARDWARE 1
+#include <nmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CRC32C_TARGET_SSE42
+#else
+#include <cpuid.h>
+#define CRC32C_TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
+#else
+#define CRC32C_HARDWARE 0
+#endif
+
+#include "../Interfaces/ILogManager.h"
+#include "../Interfaces/IMemoryManager.h"
+
+/************************************************************************/
+// CRC32C
+/************************************************************************/
+#define CRC32C_POLY 0x82F63B78U
+// Interleaved hardware path: three independent streams of CRC32C_LONG (then CRC32C_SHORT) bytes hide the
+// three cycle latency of the crc32 instruction, the partial results are combined with a zero shift table
+#define CRC32C_LONG 8192U
+#define CRC32C_SHORT 256U
+
+static uint32_t gf2MatrixTimes(const uint32_t* pMat, uint32_t vec)
+{
+	uint32_t sum = 0;
+	while (vec)
+	{
+		if (vec & 1)
+			sum ^= *pMat;
+		vec >>= 1;
+		++pMat;
+	}
+	return sum;
+}
+
+static void gf2MatrixSquare(uint32_t* pSquare, const uint32_t* pMat)
+{
+	for (uint32_t n = 0; n < 32; ++n)
+		pSquare[n] = gf2MatrixTimes(pMat, pMat[n]);
+}
+
+// Operator which appends len zero bytes to a raw CRC32C register
+static void Crc32cZerosOperator(uint32_t* pEven, size_t len)
+{
+	uint32_t odd[32];
+	odd[0] = CRC32C_POLY;
+	uint32_t row = 1;
+	for (uint32_t n = 1; n < 32; ++n)
+	{
+		odd[n] = row;
+		row <<= 1;
+	}
+
+	// Two and four zero bits
+	gf2MatrixSquare(pEven, odd);
+	gf2MatrixSquare(odd, pEven);
+
+	// Square for every further power of two, the last square lands in even or odd depending on the bit count
+	do
+	{
+		gf2MatrixSquare(pEven, odd);
+		len >>= 1;
+		if (len == 0)
+			return;
+		gf2MatrixSquare(odd, pEven);
+		len >>= 1;
+	} while (len);
+
+	for (uint32_t n = 0; n < 32; ++n)
+		pEven[n] = odd[n];
+}
+
+static void Crc32cZerosTable(uint32_t pZeros[4][256], size_t len)
+{
+	uint32_t op[32];
+	Crc32cZerosOperator(op, len);
+	for (uint32_t n = 0; n < 256; ++n)
+	{
+		pZeros[0][n] = gf2MatrixTimes(op, n);
+		pZeros[1][n] = gf2MatrixTimes(op, n << 8);
+		pZeros[2][n] = gf2MatrixTimes(op, n << 16);
+		pZeros[3][n] = gf2MatrixTimes(op, n << 24);
+	}
+}
+
+static inline uint32_t Crc32cShift(const uint32_t pZeros[4][256], uint32_t crc)
+{
+	return pZeros[0][crc & 0xff] ^ pZeros[1][(crc >> 8) & 0xff] ^ pZeros[2][(crc >> 16) & 0xff] ^ pZeros[3][crc >> 24];
+}
+
+struct Crc32cTables
+{
+	Crc32cTables()
+	{
+		for (uint32_t n = 0; n < 256; ++n)
+		{
+			uint32_t crc = n;
+			for (uint32_t k = 0; k < 8; ++k)
+				crc = crc & 1 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+			mSlice[0][n] = crc;
+		}
+		for (uint32_t n = 0; n < 256; ++n)
+		{
+			uint32_t crc = mSlice[0][n];
+			for (uint32_t k = 1; k < 8; ++k)
+			{
+				crc = mSlice[0][crc & 0xff] ^ (crc >> 8);
+				mSlice[k][n] = crc;
+			}
+		}
+
+		Crc32cZerosTable(mLong, CRC32C_LONG);
+		Crc32cZerosTable(mShort, CRC32C_SHORT);
+
+#if CRC32C_HARDWARE
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		mHardware = (info[2] & (1 << 20)) != 0;
+#else
+		unsigned eax, ebx, ecx, edx;
+		mHardware = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_2);
+#endif
+#else
+		mHardware = false;
+#endif
+	}
+
+	uint32_t	mSlice[8][256];
+	uint32_t	mLong[4][256];
+	uint32_t	mShort[4][256];
+	bool		mHardware;
+};
+
+static const Crc32cTables gCrc32cTables;
+static bool gCrc32cHardware = gCrc32cTables.mHardware;
+
+// Slicing by 8 on the raw (non inverted) register
+static uint32_t Crc32cSoftware(uint32_t crc, const uint8_t* pData, size_t size)
+{
+	const uint32_t (*slice)[256] = gCrc32cTables.mSlice;
+
+	while (size && ((uintptr_t)pData & 7))
+	{
+		crc = slice[0][(crc ^ *pData++) & 0xff] ^ (crc >> 8);
+		--size;
+	}
+
+	while (size >= 8)
+	{
+		uint32_t lo, hi;
+		memcpy(&lo, pData, 4);
+		memcpy(&hi, pData + 4, 4);
+		lo ^= crc;
+		crc = slice[7][lo & 0xff] ^ slice[6][(lo >> 8) & 0xff] ^ slice[5][(lo >> 16) & 0xff] ^ slice[4][lo >> 24] ^
+			slice[3][hi & 0xff] ^ slice[2][(hi >> 8) & 0xff] ^ slice[1][(hi >> 16) & 0xff] ^ slice[0][hi >> 24];
+		pData += 8;
+		size -= 8;
+	}
+
+	while (size--)
+		crc = slice[0][(crc ^ *pData++) & 0xff] ^ (crc >> 8);
+
+	return crc;
+}
+
+#if CRC32C_HARDWARE
+CRC32C_TARGET_SSE42 static uint32_t Crc32cHardware(uint32_t crc, const uint8_t* pData, size_t size)
+{
+	while (size && ((uintptr_t)pData & 7))
+	{
+		crc = _mm_crc32_u8(crc, *pData++);
+		--size;
+	}
+
+	uint64_t crc0 = crc;
+
+	const size_t blockSizes[2] = { CRC32C_LONG, CRC32C_SHORT };
+	const uint32_t (*zeros[2])[256] = { gCrc32cTables.mLong, gCrc32cTables.mShort };
+	for (uint32_t b = 0; b < 2; ++b)
+	{
+		const size_t blockSize = blockSizes[b];
+		while (size >= blockSize * 3)
+		{
+			uint64_t crc1 = 0, crc2 = 0;
+			const uint8_t* pEnd = pData + blockSize;
+			do
+			{
+				uint64_t v0, v1, v2;
+				memcpy(&v0, pData, 8);
+				memcpy(&v1, pData + blockSize, 8);
+				memcpy(&v2, pData + blockSize * 2, 8);
+				crc0 = _mm_crc32_u64(crc0, v0);
+				crc1 = _mm_crc32_u64(crc1, v1);
+				crc2 = _mm_crc32_u64(crc2, v2);
+				pData += 8;
+			} while (pData < pEnd);
+			crc0 = Crc32cShift(zeros[b], (uint32_t)crc0) ^ (uint32_t)crc1;
+			crc0 = Crc32cShift(zeros[b], (uint32_t)crc0) ^ (uint32_t)crc2;
+			pData += blockSize * 2;
+			size -= blockSize * 3;
+		}
+	}
+
+	while (size >= 8)
+	{
+		uint64_t v;
+		memcpy(&v, pData, 8);
+		crc0 = _mm_crc32_u64(crc0, v);
+		pData += 8;
+		size -= 8;
+	}
+
+	crc = (uint32_t)crc0;
+	while (size--)
+		crc = _mm_crc32_u8(crc, *pData++);
+
+	return crc;
+}
+#endif
+
+uint32_t Crc32c(const void* pData, size_t size, uint32_t crc)
+{
+	crc = ~crc;
+#if CRC32C_HARDWARE
+	if (gCrc32cHardware)
+		return ~Crc32cHardware(crc, (const uint8_t*)pData, size);
+#endif
+	return ~Crc32cSoftware(crc, (const uint8_t*)pData, size);
+}
+
+bool IsCrc32cHardwareAccelerated()
+{
+	return gCrc32cHardware;
+}
+
+bool SetCrc32cHardwareAccelerated(bool enable)
+{
+	gCrc32cHardware = enable && gCrc32cTables.mHardware;
+	return gCrc32cHardware;
+}
+
+/************************************************************************/
+// XXHash64
+/************************************************************************/
+static const uint64_t XXH_PRIME64_1 = 11400714785074694791ULL;
+static const uint64_t XXH_PRIME64_2 = 14029467366897019727ULL;
+static const uint64_t XXH_PRIME64_3 = 1609587929392839161ULL;
+static const uint64_t XXH_PRIME64_4 = 9650029242287828579ULL;
+static const uint64_t XXH_PRIME64_5 = 2870177450012600261ULL;
+
+static inline uint64_t Rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+static inline uint64_t Read64(const uint8_t* p)
+{
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint32_t Read32(const uint8_t* p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint64_t XXHRound(uint64_t acc, uint64_t input)
+{
+	acc += input * XXH_PRIME64_2;
+	acc = Rotl64(acc, 31);
+	return acc * XXH_PRIME64_1;
+}
+
+static inline uint64_t XXHMergeRound(uint64_t acc, uint64_t val)
+{
+	acc ^= XXHRound(0, val);
+	return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+static inline uint64_t XXHAvalanche(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= XXH_PRIME64_2;
+	h ^= h >> 29;
+	h *= XXH_PRIME64_3;
+	h ^= h >> 32;
+	return h;
+}
+
+static uint64_t XXHFinalize(uint64_t h, const uint8_t* p, size_t size)
+{
+	while (size >= 8)
+	{
+		h ^= XXHRound(0, Read64(p));
+		h = Rotl64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+		p += 8;
+		size -= 8;
+	}
+	if (size >= 4)
+	{
+		h ^= (uint64_t)Read32(p) * XXH_PRIME64_1;
+		h = Rotl64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+		p += 4;
+		size -= 4;
+	}
+	while (size--)
+	{
+		h ^= (*p++) * XXH_PRIME64_5;
+		h = Rotl64(h, 11) * XXH_PRIME64_1;
+	}
+	return XXHAvalanche(h);
+}
+
+// Consumes all complete 32 byte stripes and returns the number of bytes used
+static size_t XXHConsumeStripes(uint64_t* pLanes, const uint8_t* p, size_t size)
+{
+	uint64_t v1 = pLanes[0], v2 = pLanes[1], v3 = pLanes[2], v4 = pLanes[3];
+	const uint8_t* pStart = p;
+	const uint8_t* pLimit = p + (size & ~(size_t)31);
+	while (p < pLimit)
+	{
+		v1 = XXHRound(v1, Read64(p));
+		v2 = XXHRound(v2, Read64(p + 8));
+		v3 = XXHRound(v3, Read64(p + 16));
+		v4 = XXHRound(v4, Read64(p + 24));
+		p += 32;
+	}
+	pLanes[0] = v1; pLanes[1] = v2; pLanes[2] = v3; pLanes[3] = v4;
+	return (size_t)(p - pStart);
+}
+
+uint64_t XXHash64(const void* pData, size_t size, uint64_t seed)
+{
+	ContentHasher hasher(seed);
+	hasher.Update(pData, size);
+	return hasher.Digest64();
+}
+
+void ContentHasher::Reset(uint64_t seed)
+{
+	mSeed = seed;
+	mLanes[0] = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+	mLanes[1] = seed + XXH_PRIME64_2;
+	mLanes[2] = seed;
+	mLanes[3] = seed - XXH_PRIME64_1;
+	mTotalSize = 0;
+	mBufferSize = 0;
+}
+
+void ContentHasher::Update(const void* pData, size_t size)
+{
+	const uint8_t* p = (const uint8_t*)pData;
+	mTotalSize += size;
+
+	if (mBufferSize)
+	{
+		size_t fill = min((size_t)(32 - mBufferSize), size);
+		memcpy(mBuffer + mBufferSize, p, fill);
+		mBufferSize += (uint32_t)fill;
+		p += fill;
+		size -= fill;
+		if (mBufferSize < 32)
+			return;
+		XXHConsumeStripes(mLanes, mBuffer, 32);
+		mBufferSize = 0;
+	}
+
+	size_t used = XXHConsumeStripes(mLanes, p, size);
+	memcpy(mBuffer, p + used, size - used);
+	mBufferSize = (uint32_t)(size - used);
+}
+
+uint64_t ContentHasher::Digest64() const
+{
+	uint64_t h;
+	if (mTotalSize >= 32)
+	{
+		h = Rotl64(mLanes[0], 1) + Rotl64(mLanes[1], 7) + Rotl64(mLanes[2], 12) + Rotl64(mLanes[3], 18);
+		h = XXHMergeRound(h, mLanes[0]);
+		h = XXHMergeRound(h, mLanes[1]);
+		h = XXHMergeRound(h, mLanes[2]);
+		h = XXHMergeRound(h, mLanes[3]);
+	}
+	else
+	{
+		h = mSeed + XXH_PRIME64_5;
+	}
+	h += mTotalSize;
+	return XXHFinalize(h, mBuffer, mBufferSize);
+}
+
+Hash128 ContentHasher::Digest128() const
+{
+	// Second digest merges the lanes in reverse with swapped rotations so both halves depend on every lane
+	uint64_t h;
+	if (mTotalSize >= 32)
+	{
+		h = Rotl64(mLanes[3], 1) + Rotl64(mLanes[2], 7) + Rotl64(mLanes[1], 12) + Rotl64(mLanes[0], 18);
+		h = XXHMergeRound(h, mLanes[3]);
+		h = XXHMergeRound(h, mLanes[2]);
+		h = XXHMergeRound(h, mLanes[1]);
+		h = XXHMergeRound(h, mLanes[0]);
+	}
+	else
+	{
+		h = (mSeed ^ XXH_PRIME64_3) + XXH_PRIME64_4;
+	}
+	h += mTotalSize * XXH_PRIME64_5;
+
+	Hash128 result;
+	result.mLow = Digest64();
+	result.mHigh = XXHFinalize(h, mBuffer, mBufferSize);
+	return result;
+}
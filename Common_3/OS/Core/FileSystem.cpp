@@ -23,15 +23,17 @@
 */
 
 #include "../Interfaces/IFileSystem.h"
+#include "../../ThirdParty/OpenSource/TinySTL/unordered_map.h"
 #include "../Math/FloatUtil.h"
 #include "../Interfaces/ILogManager.h"
 #include "../Interfaces/IMemoryManager.h"
 
-#ifdef __APPLE__
+#if defined(__APPLE__) || defined(LINUX)
 #include <unistd.h>
 #include <limits.h>  // for UINT_MAX
 #include <sys/stat.h>  // for mkdir
 #include <sys/errno.h> // for errno
+#include <sys/wait.h>  // for wait
 #endif
 #ifdef _WIN32
 #include  <io.h>
@@ -54,8 +56,6 @@ static const char* pszFileAccessFlags[] =
 
 extern const char* pszRoots[];
 
-static inline unsigned SDBMHash(unsigned hash, unsigned char c) { return c + (hash << 6) + (hash << 16) - hash; }
-
 /************************************************************************/
 // Deserializer implementation
 /************************************************************************/
@@ -80,6 +80,26 @@ unsigned Deserializer::GetChecksum()
 	return 0;
 }
 
+Hash128 Deserializer::GetContentHash()
+{
+	unsigned oldPos = mPosition;
+	ContentHasher hasher;
+	uint8_t* block = (uint8_t*)conf_malloc(CONTENT_HASH_BLOCK_SIZE);
+
+	Seek(0);
+	while (!IsEof())
+	{
+		unsigned readBytes = Read(block, CONTENT_HASH_BLOCK_SIZE);
+		if (!readBytes)
+			break;
+		hasher.Update(block, readBytes);
+	}
+
+	conf_free(block);
+	Seek(oldPos);
+	return hasher.Digest128();
+}
+
 int64_t Deserializer::ReadInt64()
 {
 	int64_t ret;
@@ -331,7 +351,7 @@ bool Serializer::WriteString(const String& value)
 	const char* chars = value.c_str();
 	// Count length to the first zero, because ReadString() does the same
 	unsigned length = c_strlen(chars);
-	return Write(chars, length) == length + 1;
+	return Write(chars, length + 1) == length + 1;
 }
 
 bool Serializer::WriteFileID(const String& value)
@@ -540,16 +560,18 @@ unsigned File::GetChecksum()
 
 	unsigned oldPos = mPosition;
 	mChecksum = 0;
+	uint8_t* block = (uint8_t*)conf_malloc(CONTENT_HASH_BLOCK_SIZE);
 
 	Seek(0);
 	while (!IsEof())
 	{
-		unsigned char block[1024];
-		unsigned readBytes = Read(block, 1024);
-		for (unsigned i = 0; i < readBytes; ++i)
-			mChecksum = SDBMHash(mChecksum, block[i]);
+		unsigned readBytes = Read(block, CONTENT_HASH_BLOCK_SIZE);
+		if (!readBytes)
+			break;
+		mChecksum = Crc32c(block, readBytes, mChecksum);
 	}
 
+	conf_free(block);
 	Seek(oldPos);
 	return mChecksum;
 }
@@ -659,8 +681,22 @@ unsigned MemoryBuffer::Write(const void* data, unsigned size)
 	return size;
 }
 
+unsigned MemoryBuffer::GetChecksum()
+{
+	return Crc32c(pBuffer, mSize);
+}
+
+Hash128 MemoryBuffer::GetContentHash()
+{
+	ContentHasher hasher;
+	hasher.Update(pBuffer, mSize);
+	return hasher.Digest128();
+}
+
 String FileSystem::mModifiedRootPaths[FSRoot::FSR_Count] = { "" };
 String FileSystem::mProgramDir = "";
+// Manifest key -> absolute path of the cooked file
+static tinystl::unordered_map<String, String> gCookedPaths;
 
 void FileSystem::SetRootPath(FSRoot root, const String& rootPath)
 {
@@ -688,6 +724,15 @@ unsigned FileSystem::GetFileSize(FileHandle handle)
 	return (unsigned)length;
 }
     
+uint64_t FileSystem::GetFileSize64(FileHandle handle)
+{
+	int64_t curPos = _tellFile64(handle);
+	_seekFile64(handle, 0, SEEK_END);
+	int64_t length = _tellFile64(handle);
+	_seekFile64(handle, curPos, SEEK_SET);
+	return (uint64_t)length;
+}
+
 bool FileSystem::FileExists(const String& _fileName, FSRoot _root)
 {
 	String fileName = FileSystem::FixPath(_fileName, _root);
@@ -995,3 +1040,62 @@ bool FileSystem::Delete(const String& fileName)
 	return remove(GetNativePath(fileName).c_str()) == 0;
 #endif
 }
+
+bool FileSystem::Rename(const String& oldName, const String& newName)
+{
+#ifdef _WIN32
+	return MoveFileExA(GetNativePath(oldName).c_str(), GetNativePath(newName).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return rename(GetNativePath(oldName).c_str(), GetNativePath(newName).c_str()) == 0;
+#endif
+}
+
+bool FileSystem::LoadCookManifest(const String& fileName, FSRoot root)
+{
+	File file;
+	if (!file.Open(fileName, FM_ReadBinary, root))
+		return false;
+
+	if (file.ReadUInt() != COOK_MANIFEST_MAGIC || file.ReadUInt() != COOK_MANIFEST_VERSION)
+	{
+		LOGERRORF("Cook manifest %s is invalid or was written by a different version", file.GetName().c_str());
+		return false;
+	}
+
+	// Cooked files live next to the manifest
+	String cacheDir = GetPath(file.GetName());
+	unsigned entryCount = file.ReadUInt();
+	for (unsigned i = 0; i < entryCount && !file.IsEof(); ++i)
+	{
+		String key = file.ReadString();
+		String cookedName = file.ReadString();
+		file.ReadInt64(); // content key
+		file.ReadInt64();
+		file.ReadInt64(); // source stamp
+		gCookedPaths[key] = cacheDir + cookedName;
+	}
+
+	LOGINFOF("Loaded cook manifest %s with %u entries", file.GetName().c_str(), entryCount);
+	return true;
+}
+
+void FileSystem::ClearCookManifest()
+{
+	gCookedPaths.clear();
+}
+
+String FileSystem::GetCookedPath(const String& fileName, FSRoot root)
+{
+	if (gCookedPaths.empty())
+		return String();
+
+	tinystl::unordered_map<String, String>::iterator it = gCookedPaths.find(GetCookManifestKey(fileName, root));
+	return it != gCookedPaths.end() ? it->second : String();
+}
+
+String FileSystem::GetCookManifestKey(const String& fileName, FSRoot root)
+{
+	String key;
+	key.sprintf("%d:%s", (int)root, GetInternalPath(fileName).c_str());
+	return key;
+}
@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "RadixSort.h"
+#include "../Interfaces/IThread.h"
+#include "../../ThirdParty/OpenSource/TinySTL/vector.h"
+#include <string.h>
+#include "../Interfaces/ILogManager.h"
+#include "../Interfaces/IMemoryManager.h"
+
+#define RADIX_SORT_BITS 8
+#define RADIX_SORT_BUCKETS (1 << RADIX_SORT_BITS)
+#define RADIX_SORT_PASSES (32 / RADIX_SORT_BITS)
+// Insertion sort beats the histogram setup below this size
+#define RADIX_SORT_INSERTION_THRESHOLD 64
+// Smallest slice worth a thread pool round trip per pass
+#define RADIX_SORT_MIN_TASK_SIZE 16384
+
+// Maps the float bits to an unsigned integer with the same ordering: negative values get every bit flipped, positive
+// values only the sign bit. Descending order inverts the whole key, which keeps ties in input order.
+static inline uint32_t FloatToKey(float value, uint32_t invert)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	const uint32_t mask = (uint32_t)(-(int32_t)(bits >> 31)) | 0x80000000u;
+	return bits ^ mask ^ invert;
+}
+
+static inline float KeyToFloat(uint32_t key, uint32_t invert)
+{
+	key ^= invert;
+	const uint32_t mask = ((key >> 31) - 1) | 0x80000000u;
+	const uint32_t bits = key ^ mask;
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static inline uint32_t GetDigit(uint32_t key, uint32_t shift)
+{
+	return (key >> shift) & (RADIX_SORT_BUCKETS - 1);
+}
+
+static void InsertionSort(uint32_t* pKeys, uint32_t* pValues, uint32_t count)
+{
+	for (uint32_t i = 1; i < count; ++i)
+	{
+		const uint32_t key = pKeys[i];
+		const uint32_t value = pValues[i];
+		uint32_t j = i;
+		for (; j > 0 && pKeys[j - 1] > key; --j)
+		{
+			pKeys[j] = pKeys[j - 1];
+			pValues[j] = pValues[j - 1];
+		}
+		pKeys[j] = key;
+		pValues[j] = value;
+	}
+}
+
+static void Scatter(const uint32_t* pSrcKeys, const uint32_t* pSrcValues, uint32_t* pDstKeys, uint32_t* pDstValues,
+	uint32_t begin, uint32_t end, uint32_t shift, uint32_t* pOffsets)
+{
+	for (uint32_t i = begin; i < end; ++i)
+	{
+		const uint32_t key = pSrcKeys[i];
+		const uint32_t pos = pOffsets[GetDigit(key, shift)]++;
+		pDstKeys[pos] = key;
+		pDstValues[pos] = pSrcValues[i];
+	}
+}
+
+void RadixSort(float* pKeys, uint32_t* pValues, float* pTempKeys, uint32_t* pTempValues, uint32_t count, RadixSortOrder order)
+{
+	if (count < 2)
+		return;
+	ASSERT(pKeys && pValues && pTempKeys && pTempValues);
+
+	// The key arrays hold the flipped integer keys until the final conversion back to floats
+	const uint32_t invert = order == RADIX_SORT_DESCENDING ? ~0u : 0u;
+	uint32_t* keys = (uint32_t*)pKeys;
+
+	if (count <= RADIX_SORT_INSERTION_THRESHOLD)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+			keys[i] = FloatToKey(pKeys[i], invert);
+		InsertionSort(keys, pValues, count);
+		for (uint32_t i = 0; i < count; ++i)
+			pKeys[i] = KeyToFloat(keys[i], invert);
+		return;
+	}
+
+	// All digit histograms are built in the same read as the key conversion
+	uint32_t histograms[RADIX_SORT_PASSES][RADIX_SORT_BUCKETS] = {};
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const uint32_t key = FloatToKey(pKeys[i], invert);
+		keys[i] = key;
+		for (uint32_t p = 0; p < RADIX_SORT_PASSES; ++p)
+			++histograms[p][GetDigit(key, p * RADIX_SORT_BITS)];
+	}
+
+	uint32_t* pSrcKeys = keys;
+	uint32_t* pSrcValues = pValues;
+	uint32_t* pDstKeys = (uint32_t*)pTempKeys;
+	uint32_t* pDstValues = pTempValues;
+	for (uint32_t p = 0; p < RADIX_SORT_PASSES; ++p)
+	{
+		const uint32_t shift = p * RADIX_SORT_BITS;
+		if (histograms[p][GetDigit(pSrcKeys[0], shift)] == count)
+			continue;
+
+		uint32_t offsets[RADIX_SORT_BUCKETS];
+		uint32_t sum = 0;
+		for (uint32_t d = 0; d < RADIX_SORT_BUCKETS; ++d)
+		{
+			offsets[d] = sum;
+			sum += histograms[p][d];
+		}
+		Scatter(pSrcKeys, pSrcValues, pDstKeys, pDstValues, 0, count, shift, offsets);
+
+		uint32_t* pTemp = pSrcKeys; pSrcKeys = pDstKeys; pDstKeys = pTemp;
+		pTemp = pSrcValues; pSrcValues = pDstValues; pDstValues = pTemp;
+	}
+
+	if (pSrcKeys != keys)
+		memcpy(pValues, pSrcValues, count * sizeof(uint32_t));
+	for (uint32_t i = 0; i < count; ++i)
+		pKeys[i] = KeyToFloat(pSrcKeys[i], invert);
+}
+
+typedef enum RadixSortPhase
+{
+	RADIX_SORT_PHASE_CONVERT = 0,
+	RADIX_SORT_PHASE_HISTOGRAM,
+	RADIX_SORT_PHASE_SCATTER,
+	RADIX_SORT_PHASE_RESOLVE,
+} RadixSortPhase;
+
+typedef struct RadixSortJob
+{
+	float*			pFloatKeys;
+	uint32_t*		pValues;
+	uint32_t*		pSrcKeys;
+	uint32_t*		pSrcValues;
+	uint32_t*		pDstKeys;
+	uint32_t*		pDstValues;
+	// Per task digit histograms. The convert phase fills all passes, the histogram phase only the first row.
+	uint32_t		(*pHistograms)[RADIX_SORT_PASSES][RADIX_SORT_BUCKETS];
+	uint32_t		(*pOffsets)[RADIX_SORT_BUCKETS];
+	uint32_t		mCount;
+	uint32_t		mTaskCount;
+	uint32_t		mInvert;
+	uint32_t		mShift;
+	RadixSortPhase	mPhase;
+} RadixSortJob;
+
+typedef struct RadixSortTask
+{
+	RadixSortJob*	pJob;
+	uint32_t		mIndex;
+} RadixSortTask;
+
+static void RadixSortTaskFunc(void* pData)
+{
+	const RadixSortTask* pTask = (const RadixSortTask*)pData;
+	const RadixSortJob* pJob = pTask->pJob;
+	const uint32_t begin = (uint32_t)((uint64_t)pJob->mCount * pTask->mIndex / pJob->mTaskCount);
+	const uint32_t end = (uint32_t)((uint64_t)pJob->mCount * (pTask->mIndex + 1) / pJob->mTaskCount);
+	uint32_t (*histograms)[RADIX_SORT_BUCKETS] = pJob->pHistograms[pTask->mIndex];
+
+	switch (pJob->mPhase)
+	{
+	case RADIX_SORT_PHASE_CONVERT:
+		memset(histograms, 0, sizeof(pJob->pHistograms[0]));
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			const uint32_t key = FloatToKey(pJob->pFloatKeys[i], pJob->mInvert);
+			pJob->pSrcKeys[i] = key;
+			for (uint32_t p = 0; p < RADIX_SORT_PASSES; ++p)
+				++histograms[p][GetDigit(key, p * RADIX_SORT_BITS)];
+		}
+		break;
+	case RADIX_SORT_PHASE_HISTOGRAM:
+		memset(histograms[0], 0, sizeof(histograms[0]));
+		for (uint32_t i = begin; i < end; ++i)
+			++histograms[0][GetDigit(pJob->pSrcKeys[i], pJob->mShift)];
+		break;
+	case RADIX_SORT_PHASE_SCATTER:
+		Scatter(pJob->pSrcKeys, pJob->pSrcValues, pJob->pDstKeys, pJob->pDstValues, begin, end, pJob->mShift, pJob->pOffsets[pTask->mIndex]);
+		break;
+	case RADIX_SORT_PHASE_RESOLVE:
+		// Converts back to floats, and moves the payload home when the last pass wrote to the scratch arrays
+		if (pJob->pSrcValues != pJob->pValues)
+			memcpy(pJob->pValues + begin, pJob->pSrcValues + begin, (end - begin) * sizeof(uint32_t));
+		for (uint32_t i = begin; i < end; ++i)
+			pJob->pFloatKeys[i] = KeyToFloat(pJob->pSrcKeys[i], pJob->mInvert);
+		break;
+	}
+}
+
+static void RunRadixSortPhase(RadixSortJob* pJob, RadixSortPhase phase, RadixSortTask* pTasks, WorkItem* pWorkItems, ThreadPool* pThreadPool)
+{
+	pJob->mPhase = phase;
+	for (uint32_t i = 0; i < pJob->mTaskCount; ++i)
+	{
+		pWorkItems[i].pFunc = RadixSortTaskFunc;
+		pWorkItems[i].pData = &pTasks[i];
+		pThreadPool->AddWorkItem(&pWorkItems[i]);
+	}
+
+	// The calling thread takes part in the work and returns once every slice is done
+	pThreadPool->Complete(0);
+}
+
+void RadixSortParallel(float* pKeys, uint32_t* pValues, float* pTempKeys, uint32_t* pTempValues, uint32_t count,
+	ThreadPool* pThreadPool, uint32_t taskCount, RadixSortOrder order)
+{
+	if (pThreadPool)
+		taskCount = min(taskCount, count / RADIX_SORT_MIN_TASK_SIZE);
+	if (!pThreadPool || taskCount < 2)
+	{
+		RadixSort(pKeys, pValues, pTempKeys, pTempValues, count, order);
+		return;
+	}
+	ASSERT(pKeys && pValues && pTempKeys && pTempValues);
+
+	tinystl::vector<RadixSortTask> tasks(taskCount);
+	tinystl::vector<WorkItem> workItems(taskCount);
+	uint32_t (*histograms)[RADIX_SORT_PASSES][RADIX_SORT_BUCKETS] =
+		(uint32_t (*)[RADIX_SORT_PASSES][RADIX_SORT_BUCKETS])conf_malloc(taskCount * sizeof(*histograms));
+	uint32_t (*offsets)[RADIX_SORT_BUCKETS] = (uint32_t (*)[RADIX_SORT_BUCKETS])conf_malloc(taskCount * sizeof(*offsets));
+
+	RadixSortJob job = {};
+	job.pFloatKeys = pKeys;
+	job.pValues = pValues;
+	job.pSrcKeys = (uint32_t*)pKeys;
+	job.pSrcValues = pValues;
+	job.pDstKeys = (uint32_t*)pTempKeys;
+	job.pDstValues = pTempValues;
+	job.pHistograms = histograms;
+	job.pOffsets = offsets;
+	job.mCount = count;
+	job.mTaskCount = taskCount;
+	job.mInvert = order == RADIX_SORT_DESCENDING ? ~0u : 0u;
+	for (uint32_t i = 0; i < taskCount; ++i)
+	{
+		tasks[i].pJob = &job;
+		tasks[i].mIndex = i;
+	}
+
+	RunRadixSortPhase(&job, RADIX_SORT_PHASE_CONVERT, tasks.data(), workItems.data(), pThreadPool);
+
+	bool firstPass = true;
+	for (uint32_t p = 0; p < RADIX_SORT_PASSES; ++p)
+	{
+		const uint32_t shift = p * RADIX_SORT_BITS;
+		const uint32_t digit = GetDigit(job.pSrcKeys[0], shift);
+		uint32_t digitCount = 0;
+		for (uint32_t t = 0; t < taskCount; ++t)
+			digitCount += histograms[t][p][digit];
+		if (digitCount == count)
+			continue;
+
+		// Slices only keep their conversion histograms until the first scatter moves keys between them
+		job.mShift = shift;
+		const uint32_t row = firstPass ? p : 0;
+		if (!firstPass)
+			RunRadixSortPhase(&job, RADIX_SORT_PHASE_HISTOGRAM, tasks.data(), workItems.data(), pThreadPool);
+
+		// Slices write their share of each bucket in slice order, which keeps the sort stable
+		uint32_t sum = 0;
+		for (uint32_t d = 0; d < RADIX_SORT_BUCKETS; ++d)
+		{
+			for (uint32_t t = 0; t < taskCount; ++t)
+			{
+				offsets[t][d] = sum;
+				sum += histograms[t][row][d];
+			}
+		}
+		RunRadixSortPhase(&job, RADIX_SORT_PHASE_SCATTER, tasks.data(), workItems.data(), pThreadPool);
+
+		uint32_t* pTemp = job.pSrcKeys; job.pSrcKeys = job.pDstKeys; job.pDstKeys = pTemp;
+		pTemp = job.pSrcValues; job.pSrcValues = job.pDstValues; job.pDstValues = pTemp;
+		firstPass = false;
+	}
+
+	RunRadixSortPhase(&job, RADIX_SORT_PHASE_RESOLVE, tasks.data(), workItems.data(), pThreadPool);
+
+	conf_free(offsets);
+	conf_free(histograms);
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../Interfaces/IOperatingSystem.h"
+
+class ThreadPool;
+
+typedef enum RadixSortOrder
+{
+	/// Smallest key first (front to back for view depth keys)
+	RADIX_SORT_ASCENDING = 0,
+	/// Largest key first (back to front for view depth keys)
+	RADIX_SORT_DESCENDING,
+} RadixSortOrder;
+
+/// Stable LSD radix sort of float keys carrying a 32 bit payload, usually an index into the sorted objects.
+/// Keys are flipped into order preserving unsigned integers and sorted 8 bits per pass; passes where every key has the
+/// same digit are skipped. Equal keys keep their input order in both sort orders. -0.0 sorts before +0.0 and NaNs sort
+/// past the infinities on the side of their sign bit.
+/// pTempKeys/pTempValues are scratch arrays of count elements. The result is returned in pKeys/pValues.
+void RadixSort(float* pKeys, uint32_t* pValues, float* pTempKeys, uint32_t* pTempValues, uint32_t count,
+	RadixSortOrder order = RADIX_SORT_ASCENDING);
+
+/// Same sort with the arrays partitioned into taskCount slices: every pass builds per slice digit histograms and
+/// scatters the slices concurrently on pThreadPool. The output is identical to RadixSort.
+/// The calling thread joins the work through ThreadPool::Complete(0), so the pool should have no unrelated work pending.
+/// Falls back to RadixSort without a pool, with a single task or for arrays too small to be worth splitting.
+void RadixSortParallel(float* pKeys, uint32_t* pValues, float* pTempKeys, uint32_t* pTempValues, uint32_t count,
+	ThreadPool* pThreadPool, uint32_t taskCount, RadixSortOrder order = RADIX_SORT_ASCENDING);
@@ -24,6 +24,7 @@
 
 #include "Image.h"
 #include "../Interfaces/ILogManager.h"
+#include "../Interfaces/IThread.h"
 #include "../../ThirdParty/OpenSource/Nothings/stb_image.h"
 #include "../../ThirdParty/OpenSource/Nothings/stb_image_resize.h"
 #include "../../ThirdParty/OpenSource/Nothings/stb_image_write.h"
@@ -898,7 +899,79 @@ bool Image::Uncompress()
   return true;
 }
 
-bool Image::Unpack() {
+// --- HDR PIXEL CONVERSION ---
+
+// Below this many pixels per task the pool overhead outweighs the conversion itself
+#define HDR_CONVERSION_MIN_TASK_PIXELS 16384
+
+typedef struct HdrConversionTask
+{
+  const ubyte*      pSrc;
+  ubyte*            pDst;
+  ImageFormat::Enum mSrcFormat;
+  ImageFormat::Enum mDstFormat;
+  uint              mBegin;
+  uint              mEnd;
+} HdrConversionTask;
+
+static bool iIsHdrConversion(const ImageFormat::Enum srcFormat, const ImageFormat::Enum dstFormat) {
+  const bool floatRGB = (srcFormat == ImageFormat::RGB32F || srcFormat == ImageFormat::RGBA32F);
+  const bool toFloatRGB = (dstFormat == ImageFormat::RGB32F || dstFormat == ImageFormat::RGBA32F);
+  return (srcFormat == ImageFormat::RGBE8 && toFloatRGB) ||
+    (floatRGB && (dstFormat == ImageFormat::RGBE8 || dstFormat == ImageFormat::RGB9E5));
+}
+
+static void iConvertHdrPixelsTask(void* pData) {
+  const HdrConversionTask* pTask = (const HdrConversionTask*)pData;
+  const size_t count = pTask->mEnd - pTask->mBegin;
+
+  if (pTask->mSrcFormat == ImageFormat::RGBE8) {
+    const uint channels = ImageFormat::GetChannelCount(pTask->mDstFormat);
+    rgbeToRGB(pTask->pSrc + 4 * (size_t)pTask->mBegin, (float*)pTask->pDst + channels * (size_t)pTask->mBegin, channels, count);
+  }
+  else {
+    const uint channels = ImageFormat::GetChannelCount(pTask->mSrcFormat);
+    const float* pSrc = (const float*)pTask->pSrc + channels * (size_t)pTask->mBegin;
+    unsigned int* pDst = (unsigned int*)pTask->pDst + pTask->mBegin;
+    if (pTask->mDstFormat == ImageFormat::RGBE8)
+      rgbToRGBE8(pSrc, channels, pDst, count);
+    else
+      rgbToRGB9E5(pSrc, channels, pDst, count);
+  }
+}
+
+// Converts pixelCount pixels between the formats accepted by iIsHdrConversion, split into slices on pThreadPool.
+// The results do not depend on the slicing, so they match the single threaded path exactly.
+static void iConvertHdrPixels(const ubyte* pSrc, const ImageFormat::Enum srcFormat, ubyte* pDst, const ImageFormat::Enum dstFormat,
+  const uint pixelCount, ThreadPool* pThreadPool) {
+  uint taskCount = pThreadPool ? (pThreadPool->GetNumThreads() + 1) * 4 : 1;
+  taskCount = min(taskCount, pixelCount / HDR_CONVERSION_MIN_TASK_PIXELS);
+  if (taskCount < 2) {
+    HdrConversionTask task = { pSrc, pDst, srcFormat, dstFormat, 0, pixelCount };
+    iConvertHdrPixelsTask(&task);
+    return;
+  }
+
+  tinystl::vector<HdrConversionTask> tasks(taskCount);
+  tinystl::vector<WorkItem> workItems(taskCount);
+  for (uint i = 0; i < taskCount; i++) {
+    HdrConversionTask& task = tasks[i];
+    task.pSrc = pSrc;
+    task.pDst = pDst;
+    task.mSrcFormat = srcFormat;
+    task.mDstFormat = dstFormat;
+    task.mBegin = (uint)((uint64_t)pixelCount * i / taskCount);
+    task.mEnd = (uint)((uint64_t)pixelCount * (i + 1) / taskCount);
+    workItems[i].pFunc = iConvertHdrPixelsTask;
+    workItems[i].pData = &task;
+    pThreadPool->AddWorkItem(&workItems[i]);
+  }
+
+  // The calling thread takes part in the work and returns once every slice is done
+  pThreadPool->Complete(0);
+}
+
+bool Image::Unpack(ThreadPool* pThreadPool) {
   int pixelCount = GetNumberOfPixels(0, mMipMapCount);
 
   ubyte *newPixels;
@@ -906,9 +979,7 @@ bool Image::Unpack() {
     mFormat = ImageFormat::RGB32F;
     newPixels = (unsigned char*)conf_malloc(sizeof(unsigned char) * GetMipMappedSize(0, mMipMapCount));
 
-    for (int i = 0; i < pixelCount; i++) {
-      ((vec3 *)newPixels)[i] = rgbeToRGB(pData + 4 * i);
-    }
+    iConvertHdrPixels(pData, ImageFormat::RGBE8, newPixels, mFormat, pixelCount, pThreadPool);
   }
   else if (mFormat == ImageFormat::RGB565) {
     mFormat = ImageFormat::RGB8;
@@ -1034,9 +1105,13 @@ uint Image::GetMipMappedSize(const uint firstMipMapLevel, uint nMipMapLevels, Im
 
 uint Image::GetMipMappedSize(uint w, uint h, uint d, uint startMip, uint nMipMapLevels, ImageFormat::Enum srcFormat)
 {
-	w >>= startMip;
-	h >>= startMip;
-	d >>= startMip;
+	// Depth 0 marks a cube map. The loop below changes d, so remember it up front
+	const bool isCube = (d == 0);
+	if (isCube) d = 1;
+
+	w = max(w >> startMip, 1u);
+	h = max(h >> startMip, 1u);
+	d = max(d >> startMip, 1u);
 
 	// PVR formats get special case
 	if ((srcFormat >= ImageFormat::PVR_2BPP) && (srcFormat <= ImageFormat::PVR_4BPPA))
@@ -1104,16 +1179,16 @@ uint Image::GetMipMappedSize(uint w, uint h, uint d, uint startMip, uint nMipMap
 		size *= ImageFormat::GetBytesPerPixel(srcFormat);
 	}
 
-	return (d == 0) ? 6 * size : size;
+	return isCube ? 6 * size : size;
 }
 
 // Load Image Data form mData functions
 
-bool Image::iLoadDDSFromMemory(const char* memory, uint32_t memSize, const bool useMipMaps, memoryAllocationFunc pAllocator, void* pUserData)
+bool Image::iLoadDDSHeaderFromMemory(const char* memory, uint32_t memSize, const bool useMipMaps, uint32_t* pDataOffset)
 {
   DDSHeader header;
 
-  if (memory == nullptr || memSize == 0)
+  if (memory == nullptr || memSize < sizeof(header))
     return false;
 
   MemoryBuffer file(memory, (unsigned)memSize);
@@ -1213,6 +1288,24 @@ bool Image::iLoadDDSFromMemory(const char* memory, uint32_t memSize, const bool
     }
   }
 
+  if (pDataOffset)
+    *pDataOffset = sizeof(DDSHeader) + (header.mPixelFormat.mDWFourCC == MAKE_CHAR4('D', 'X', '1', '0') ? sizeof(DDSHeaderDX10) : 0);
+
+  return true;
+}
+
+bool Image::iLoadDDSFromMemory(const char* memory, uint32_t memSize, const bool useMipMaps, memoryAllocationFunc pAllocator, void* pUserData)
+{
+  uint32_t dataOffset = 0;
+  if (!iLoadDDSHeaderFromMemory(memory, memSize, useMipMaps, &dataOffset))
+    return false;
+
+  DDSHeader header;
+  memcpy(&header, memory, sizeof(header));
+
+  MemoryBuffer file(memory, (unsigned)memSize);
+  file.Seek(dataOffset);
+
   int size = GetMipMappedSize(0, mMipMapCount);
 
   if (pAllocator)
@@ -1831,13 +1924,18 @@ bool Image::loadImage(const char *fileName, bool useMipmaps, memoryAllocationFun
   // clear current image
   Clear();
 
-  const char *extension = strrchr(fileName, '.');
+  // Read the cooked output instead when the loaded cook manifest has one, and pick the loader from its container
+  String cookedPath = FileSystem::GetCookedPath(fileName, root);
+  const char *extension = strrchr(cookedPath.isEmpty() ? fileName : cookedPath.c_str(), '.');
   if (extension == NULL)
     return false;
 
   // open file
   File file = {};
-  file.Open (fileName, FM_ReadBinary, root);
+  if (cookedPath.isEmpty())
+    file.Open (fileName, FM_ReadBinary, root);
+  else
+    file.Open (cookedPath, FM_ReadBinary, FSR_Absolute);
   if (!file.IsOpen())
   {
     ErrorMsg("\"%s\": Image file not found.", fileName);
@@ -1906,28 +2004,13 @@ bool Image::loadImage(const char *fileName, bool useMipmaps, memoryAllocationFun
   return loaded;
 }
 
-bool Image::Convert(const ImageFormat::Enum newFormat) {
+bool Image::Convert(const ImageFormat::Enum newFormat, ThreadPool* pThreadPool) {
   ubyte *newPixels;
   uint nPixels = GetNumberOfPixels(0, mMipMapCount) * mArrayCount;
  
-  if (mFormat == ImageFormat::RGBE8 && (newFormat == ImageFormat::RGB32F || newFormat == ImageFormat::RGBA32F)) {
+  if (iIsHdrConversion(mFormat, newFormat)) {
     newPixels = (ubyte*)conf_malloc(sizeof(ubyte) * GetMipMappedSize(0, mMipMapCount, newFormat) * mArrayCount);
-    float *dest = (float *)newPixels;
-
-    bool writeAlpha = (newFormat == ImageFormat::RGBA32F);
-    ubyte *src = pData;
-    do {
-      *((vec3 *)dest) = rgbeToRGB(src);
-      if (writeAlpha) {
-        dest[3] = 1.0f;
-        dest += 4;
-      }
-      else {
-        dest += 3;
-      }
-      src += 4;
-    } while (--nPixels);
-    
+    iConvertHdrPixels(pData, mFormat, newPixels, newFormat, nPixels, pThreadPool);
   }
   else {
     if (!ImageFormat::IsPlainFormat(mFormat) || !(ImageFormat::IsPlainFormat(newFormat) || newFormat == ImageFormat::RGB10A2 || newFormat == ImageFormat::RGBE8 || newFormat == ImageFormat::RGB9E5))
@@ -1951,6 +2034,14 @@ bool Image::Convert(const ImageFormat::Enum newFormat) {
         src += 3;
       } while (--nPixels);
     }
+    else if (mFormat >= ImageFormat::R32F && mFormat <= ImageFormat::RGBA32F && newFormat == mFormat - ImageFormat::R32F + ImageFormat::R16F) {
+      // Fast path for float->half with the same channels
+      floatToHalf((const float *)src, (half *)dest, nPixels * ImageFormat::GetChannelCount(mFormat));
+    }
+    else if (mFormat >= ImageFormat::R16F && mFormat <= ImageFormat::RGBA16F && newFormat == mFormat - ImageFormat::R16F + ImageFormat::R32F) {
+      // Fast path for half->float with the same channels
+      halfToFloat((const half *)src, (float *)dest, nPixels * ImageFormat::GetChannelCount(mFormat));
+    }
     else {
       int srcSize = ImageFormat::GetBytesPerPixel(mFormat);
       int nSrcChannels = ImageFormat::GetChannelCount(mFormat);
@@ -57,6 +57,8 @@ namespace ImageFormat
   ImageFormat::Enum GetFormatFromString(char *string);
 };
 
+class ThreadPool;
+
 typedef void*(*memoryAllocationFunc)(class Image* pImage, uint64_t memoryRequirement, void* pUserData);
 
 class Image
@@ -88,9 +90,10 @@ public:
   bool GetColorRange(float &min, float &max);
   bool Normalize();
   bool Uncompress();
-  bool Unpack();
+  // HDR conversions (RGBE8 <-> RGB(A)32F, RGB(A)32F -> RGB9E5) are split across pThreadPool when one is given
+  bool Unpack(ThreadPool* pThreadPool = NULL);
 
-  bool Convert(const ImageFormat::Enum newFormat);
+  bool Convert(const ImageFormat::Enum newFormat, ThreadPool* pThreadPool = NULL);
   bool GenerateMipMaps(const uint32_t mipMaps = ALL_MIPLEVELS);
 
   uint GetArrayCount() const { return mArrayCount; }
@@ -108,6 +111,9 @@ public:
   bool IsRenderTarget() const { return mIsRendertarget; }
 
   // Image Format Loading from mData
+  // Fills in dimensions, format and mip count from a DDS header without loading any pixels.
+  // pDataOffset receives the file offset of the first mip level
+  bool iLoadDDSHeaderFromMemory(const char* memory, uint32_t memsize, const bool useMipMaps, uint32_t* pDataOffset = NULL);
   bool iLoadDDSFromMemory(const char* memory, uint32_t memsize, const bool useMipMaps, memoryAllocationFunc pAllocator = NULL, void* pUserData = NULL);
   bool iLoadPVRFromMemory(const char* memory, uint32_t memsize, const bool useMipmaps, memoryAllocationFunc pAllocator = NULL, void* pUserData = NULL);
   bool iLoadKTXFromMemory(const char* memory, uint32_t memsize, const bool useMipmaps, memoryAllocationFunc pAllocator = NULL, void* pUserData = NULL);
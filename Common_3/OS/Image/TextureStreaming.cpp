@@ -0,0 +1,532 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "TextureStreaming.h"
+#include "../Interfaces/ILogManager.h"
+#include "../Interfaces/IMemoryManager.h"
+
+#define NO_PENDING_MIP (~0u)
+
+/************************************************************************/
+// Residency Planner
+/************************************************************************/
+struct MipCandidate
+{
+	float		mImportance;
+	uint32_t	mTexture;
+};
+
+// Most important first, ties broken by id so planning does not depend on qsort stability
+static int CompareCandidates(const void* pLhs, const void* pRhs)
+{
+	const MipCandidate* pA = (const MipCandidate*)pLhs;
+	const MipCandidate* pB = (const MipCandidate*)pRhs;
+	if (pA->mImportance != pB->mImportance)
+		return pA->mImportance > pB->mImportance ? -1 : 1;
+	return pA->mTexture < pB->mTexture ? -1 : (pA->mTexture > pB->mTexture ? 1 : 0);
+}
+
+static inline uint32_t GetMipDimension(uint32_t size, uint32_t mip)
+{
+	return max(size >> mip, 1u);
+}
+
+void TextureResidencyPlanner::Init(const TextureResidencyDesc* pDesc)
+{
+	ASSERT(pDesc);
+	mDesc = *pDesc;
+	mTextures.clear();
+	mFreeIds.clear();
+	memset(&mStatistics, 0, sizeof(mStatistics));
+	mStatistics.mBudgetBytes = mDesc.mBudgetBytes;
+	mFrameIndex = 0;
+	mPendingCount = 0;
+}
+
+void TextureResidencyPlanner::Exit()
+{
+	mTextures.clear();
+	mFreeIds.clear();
+	memset(&mStatistics, 0, sizeof(mStatistics));
+	mPendingCount = 0;
+}
+
+uint64_t TextureResidencyPlanner::GetRangeSize(const TextureState& texture, uint32_t firstMip, uint32_t mipCount) const
+{
+	uint64_t size = 0;
+	for (uint32_t mip = firstMip; mip < firstMip + mipCount; ++mip)
+		size += texture.mMipSizes[mip];
+	return size;
+}
+
+uint64_t TextureResidencyPlanner::GetTailSize(const TextureState& texture) const
+{
+	return GetRangeSize(texture, texture.mTailMip, texture.mMipCount - texture.mTailMip);
+}
+
+// Screen pixels per texel of the mip. Higher values mean the mip is more visible per byte
+float TextureResidencyPlanner::GetImportance(const TextureState& texture, uint32_t mip) const
+{
+	return texture.mCoverage / (float)texture.mTexels[mip];
+}
+
+bool TextureResidencyPlanner::IsEvictable(const TextureState& texture) const
+{
+	return texture.mActive && texture.mPendingMip == NO_PENDING_MIP && texture.mResidentMip < texture.mTailMip;
+}
+
+StreamedTextureId TextureResidencyPlanner::FindEvictionCandidate(StreamedTextureId excludeId) const
+{
+	StreamedTextureId candidate = TEXTURE_STREAMING_INVALID_ID;
+	float candidateImportance = 0.0f;
+	for (uint32_t id = 0; id < (uint32_t)mTextures.size(); ++id)
+	{
+		const TextureState& texture = mTextures[id];
+		if (id == excludeId || !IsEvictable(texture))
+			continue;
+
+		float importance = GetImportance(texture, texture.mResidentMip);
+		if (candidate == TEXTURE_STREAMING_INVALID_ID || importance < candidateImportance)
+		{
+			candidate = id;
+			candidateImportance = importance;
+		}
+	}
+	return candidate;
+}
+
+void TextureResidencyPlanner::IssueLoad(StreamedTextureId id, uint32_t firstMip, uint32_t mipCount, tinystl::vector<MipRequest>* pRequests)
+{
+	TextureState& texture = mTextures[id];
+	uint64_t size = GetRangeSize(texture, firstMip, mipCount);
+	texture.mPendingMip = firstMip;
+	texture.mPendingMipCount = mipCount;
+	mStatistics.mPendingBytes += size;
+	++mPendingCount;
+
+	MipRequest request = { id, MIP_REQUEST_LOAD, firstMip, mipCount, size };
+	pRequests->push_back(request);
+}
+
+void TextureResidencyPlanner::Evict(StreamedTextureId id, tinystl::vector<MipRequest>* pRequests)
+{
+	TextureState& texture = mTextures[id];
+	uint64_t size = texture.mMipSizes[texture.mResidentMip];
+	mStatistics.mResidentBytes -= size;
+	mStatistics.mEvictedBytes += size;
+
+	MipRequest request = { id, MIP_REQUEST_EVICT, texture.mResidentMip, 1, size };
+	pRequests->push_back(request);
+	++texture.mResidentMip;
+}
+
+StreamedTextureId TextureResidencyPlanner::AddTexture(const StreamedTextureDesc* pDesc)
+{
+	ASSERT(pDesc);
+	if (!pDesc->mWidth || !pDesc->mHeight || !pDesc->mMipCount || pDesc->mMipCount > TEXTURE_STREAMING_MAX_MIPS)
+	{
+		LOGERRORF("Texture of size %ux%u with %u mips can not be streamed", pDesc->mWidth, pDesc->mHeight, pDesc->mMipCount);
+		return TEXTURE_STREAMING_INVALID_ID;
+	}
+
+	TextureState texture = {};
+	texture.mWidth = pDesc->mWidth;
+	texture.mHeight = pDesc->mHeight;
+	texture.mMipCount = pDesc->mMipCount;
+	texture.mTailMip = pDesc->mMipCount - 1;
+	for (uint32_t mip = 0; mip < pDesc->mMipCount; ++mip)
+	{
+		uint32_t width = GetMipDimension(pDesc->mWidth, mip);
+		uint32_t height = GetMipDimension(pDesc->mHeight, mip);
+		texture.mMipSizes[mip] = Image::GetMipMappedSize(pDesc->mWidth, pDesc->mHeight, 1, mip, 1, pDesc->mFormat);
+		texture.mTexels[mip] = (uint64_t)width * height;
+		if (mip < texture.mTailMip && width <= mDesc.mTailSize && height <= mDesc.mTailSize)
+			texture.mTailMip = mip;
+	}
+	texture.mResidentMip = texture.mMipCount;
+	texture.mPendingMip = NO_PENDING_MIP;
+	texture.mDesiredMip = texture.mTailMip;
+	texture.mLastUsedFrame = mFrameIndex;
+	texture.mActive = true;
+
+	mStatistics.mTailBytes += GetTailSize(texture);
+	if (mStatistics.mTailBytes > mDesc.mBudgetBytes)
+		LOGWARNINGF("Mip tails alone (%llu bytes) exceed the texture streaming budget", (unsigned long long)mStatistics.mTailBytes);
+
+	StreamedTextureId id;
+	if (mFreeIds.size())
+	{
+		id = mFreeIds.back();
+		mFreeIds.pop_back();
+		mTextures[id] = texture;
+	}
+	else
+	{
+		id = (StreamedTextureId)mTextures.size();
+		mTextures.push_back(texture);
+	}
+	++mStatistics.mTextureCount;
+	return id;
+}
+
+void TextureResidencyPlanner::RemoveTexture(StreamedTextureId id)
+{
+	if (id >= mTextures.size() || !mTextures[id].mActive)
+		return;
+
+	TextureState& texture = mTextures[id];
+	mStatistics.mResidentBytes -= GetRangeSize(texture, texture.mResidentMip, texture.mMipCount - texture.mResidentMip);
+	if (texture.mPendingMip != NO_PENDING_MIP)
+	{
+		mStatistics.mPendingBytes -= GetRangeSize(texture, texture.mPendingMip, texture.mPendingMipCount);
+		--mPendingCount;
+	}
+	mStatistics.mTailBytes -= GetTailSize(texture);
+	--mStatistics.mTextureCount;
+
+	texture.mActive = false;
+	mFreeIds.push_back(id);
+}
+
+void TextureResidencyPlanner::ReportUsage(StreamedTextureId id, float screenPixelCoverage)
+{
+	if (id >= mTextures.size() || !mTextures[id].mActive)
+		return;
+
+	TextureState& texture = mTextures[id];
+	if (texture.mLastUsedFrame != mFrameIndex || screenPixelCoverage > texture.mCoverage)
+		texture.mCoverage = screenPixelCoverage;
+	texture.mLastUsedFrame = mFrameIndex;
+}
+
+uint32_t TextureResidencyPlanner::ComputeDesiredMip(uint32_t width, uint32_t height, uint32_t mipCount, float screenPixelCoverage, float mipBias)
+{
+	if (screenPixelCoverage <= 0.0f)
+		return mipCount - 1;
+
+	// Every mip quarters the texel count, so the matching level is half the log2 of texels per pixel
+	float mip = 0.5f * log2f((float)width * (float)height / screenPixelCoverage) + mipBias;
+	if (mip <= 0.0f)
+		return 0;
+	return min((uint32_t)mip, mipCount - 1);
+}
+
+void TextureResidencyPlanner::Update(tinystl::vector<MipRequest>* pRequests)
+{
+	ASSERT(pRequests);
+
+	mStatistics.mBudgetBytes = mDesc.mBudgetBytes;
+	mStatistics.mSatisfiedCount = 0;
+
+	// Tails first: they are the smallest mips, needed before anything else can be sampled and exempt from the budget
+	for (uint32_t id = 0; id < (uint32_t)mTextures.size(); ++id)
+	{
+		TextureState& texture = mTextures[id];
+		if (!texture.mActive)
+			continue;
+
+		if (mFrameIndex - texture.mLastUsedFrame > mDesc.mUnusedFrameCount)
+			texture.mCoverage = 0.0f;
+		texture.mDesiredMip = ComputeDesiredMip(texture.mWidth, texture.mHeight, texture.mMipCount, texture.mCoverage, mDesc.mMipBias);
+		texture.mDesiredMip = min(max(texture.mDesiredMip, texture.mMaxDetailMip), texture.mTailMip);
+		if (texture.mResidentMip <= texture.mDesiredMip)
+			++mStatistics.mSatisfiedCount;
+
+		if (texture.mResidentMip == texture.mMipCount && texture.mPendingMip == NO_PENDING_MIP && texture.mMaxDetailMip <= texture.mTailMip)
+			IssueLoad(id, texture.mTailMip, texture.mMipCount - texture.mTailMip, pRequests);
+	}
+
+	// A lowered budget is enforced right away, least important mips go first
+	while (mStatistics.mResidentBytes + mStatistics.mPendingBytes > mDesc.mBudgetBytes)
+	{
+		StreamedTextureId victim = FindEvictionCandidate(TEXTURE_STREAMING_INVALID_ID);
+		if (victim == TEXTURE_STREAMING_INVALID_ID)
+			break;
+		Evict(victim, pRequests);
+	}
+
+	tinystl::vector<MipCandidate> candidates;
+	for (uint32_t id = 0; id < (uint32_t)mTextures.size(); ++id)
+	{
+		const TextureState& texture = mTextures[id];
+		if (!texture.mActive || texture.mPendingMip != NO_PENDING_MIP || texture.mResidentMip > texture.mTailMip)
+			continue;
+		if (texture.mResidentMip <= texture.mDesiredMip || texture.mResidentMip - 1 < texture.mMaxDetailMip)
+			continue;
+
+		MipCandidate candidate = { GetImportance(texture, texture.mResidentMip - 1), id };
+		candidates.push_back(candidate);
+	}
+	if (candidates.size() > 1)
+		qsort(candidates.data(), candidates.size(), sizeof(MipCandidate), CompareCandidates);
+
+	uint64_t loadBytes = 0;
+	uint64_t budget = mDesc.mBudgetBytes;
+	tinystl::vector<StreamedTextureId> victims;
+	for (uint32_t i = 0; i < (uint32_t)candidates.size(); ++i)
+	{
+		if (mPendingCount >= mDesc.mMaxPendingLoads)
+			break;
+
+		const MipCandidate& candidate = candidates[i];
+		TextureState& texture = mTextures[candidate.mTexture];
+		uint32_t mip = texture.mResidentMip - 1;
+		uint64_t size = texture.mMipSizes[mip];
+		if (loadBytes && loadBytes + size > mDesc.mMaxLoadBytesPerUpdate)
+			break;
+
+		// Only evict mips that are clearly less important than the one being loaded. Victims are picked
+		// tentatively and dropped again if they can not free enough memory
+		uint64_t used = mStatistics.mResidentBytes + mStatistics.mPendingBytes;
+		uint64_t freed = 0;
+		victims.clear();
+		while (used - freed + size > budget)
+		{
+			StreamedTextureId victim = FindEvictionCandidate(candidate.mTexture);
+			if (victim == TEXTURE_STREAMING_INVALID_ID)
+				break;
+			TextureState& victimTexture = mTextures[victim];
+			if (GetImportance(victimTexture, victimTexture.mResidentMip) * mDesc.mEvictionHysteresis >= candidate.mImportance)
+				break;
+			freed += victimTexture.mMipSizes[victimTexture.mResidentMip];
+			++victimTexture.mResidentMip;
+			victims.push_back(victim);
+		}
+
+		bool fits = used - freed + size <= budget;
+		for (uint32_t v = (uint32_t)victims.size(); v > 0; --v)
+			--mTextures[victims[v - 1]].mResidentMip;
+		if (!fits)
+			continue;
+
+		for (uint32_t v = 0; v < (uint32_t)victims.size(); ++v)
+			Evict(victims[v], pRequests);
+		IssueLoad(candidate.mTexture, mip, 1, pRequests);
+		loadBytes += size;
+	}
+
+	++mFrameIndex;
+}
+
+void TextureResidencyPlanner::OnMipLoaded(StreamedTextureId id, uint32_t firstMip)
+{
+	if (id >= mTextures.size() || !mTextures[id].mActive || mTextures[id].mPendingMip != firstMip)
+		return;
+
+	TextureState& texture = mTextures[id];
+	uint64_t size = GetRangeSize(texture, firstMip, texture.mPendingMipCount);
+	mStatistics.mPendingBytes -= size;
+	mStatistics.mResidentBytes += size;
+	mStatistics.mLoadedBytes += size;
+	texture.mResidentMip = firstMip;
+	texture.mPendingMip = NO_PENDING_MIP;
+	--mPendingCount;
+}
+
+void TextureResidencyPlanner::OnMipLoadFailed(StreamedTextureId id, uint32_t firstMip)
+{
+	if (id >= mTextures.size() || !mTextures[id].mActive || mTextures[id].mPendingMip != firstMip)
+		return;
+
+	TextureState& texture = mTextures[id];
+	mStatistics.mPendingBytes -= GetRangeSize(texture, firstMip, texture.mPendingMipCount);
+	texture.mMaxDetailMip = firstMip + texture.mPendingMipCount;
+	texture.mPendingMip = NO_PENDING_MIP;
+	--mPendingCount;
+}
+
+void TextureResidencyPlanner::SetBudget(uint64_t budgetBytes)
+{
+	mDesc.mBudgetBytes = budgetBytes;
+	mStatistics.mBudgetBytes = budgetBytes;
+}
+
+uint32_t TextureResidencyPlanner::GetResidentMip(StreamedTextureId id) const
+{
+	return (id < mTextures.size() && mTextures[id].mActive) ? mTextures[id].mResidentMip : 0;
+}
+
+uint32_t TextureResidencyPlanner::GetDesiredMip(StreamedTextureId id) const
+{
+	return (id < mTextures.size() && mTextures[id].mActive) ? mTextures[id].mDesiredMip : 0;
+}
+
+/************************************************************************/
+// Streamer
+/************************************************************************/
+// Large enough for the DDS header including the DX10 extension
+#define DDS_MAX_HEADER_SIZE 148
+
+void TextureStreamer::Init(const TextureStreamerDesc* pDesc)
+{
+	ASSERT(pDesc && pDesc->pFileQueue);
+	mDesc = *pDesc;
+	mPlanner.Init(&mDesc.mResidency);
+}
+
+void TextureStreamer::Exit()
+{
+	for (uint32_t i = 0; i < (uint32_t)mPendingReads.size(); ++i)
+	{
+		mDesc.pFileQueue->Cancel(mPendingReads[i].pHandle);
+		mDesc.pFileQueue->Release(mPendingReads[i].pHandle);
+	}
+	mPendingReads.clear();
+	mFiles.clear();
+	mRequests.clear();
+	mPlanner.Exit();
+}
+
+StreamedTextureId TextureStreamer::AddTexture(const char* fileName, FSRoot root, Image* pOutHeader)
+{
+	String path = FileSystem::GetCookedPath(fileName, root);
+	if (path.size() == 0)
+		path = FileSystem::FixPath(fileName, root);
+
+	File file;
+	if (!file.Open(path, FM_ReadBinary, FSR_Absolute))
+	{
+		LOGERRORF("Could not open texture %s for streaming", path.c_str());
+		return TEXTURE_STREAMING_INVALID_ID;
+	}
+	char header[DDS_MAX_HEADER_SIZE];
+	unsigned headerSize = file.Read(header, sizeof(header));
+	file.Close();
+
+	Image image;
+	Image* pImage = pOutHeader ? pOutHeader : &image;
+	uint32_t dataOffset = 0;
+	if (!pImage->iLoadDDSHeaderFromMemory(header, headerSize, true, &dataOffset))
+		return TEXTURE_STREAMING_INVALID_ID;
+
+	// Cube maps and volumes interleave their mips per face or slice, so mips are not contiguous ranges
+	if (pImage->IsCube() || pImage->Is3D() || pImage->GetMipMapCount() > TEXTURE_STREAMING_MAX_MIPS)
+		return TEXTURE_STREAMING_INVALID_ID;
+
+	StreamedTextureDesc desc;
+	desc.mWidth = pImage->GetWidth();
+	desc.mHeight = pImage->GetHeight();
+	desc.mMipCount = pImage->GetMipMapCount();
+	desc.mFormat = pImage->getFormat();
+	StreamedTextureId id = mPlanner.AddTexture(&desc);
+	if (id == TEXTURE_STREAMING_INVALID_ID)
+		return id;
+
+	if (id >= mFiles.size())
+		mFiles.resize(id + 1);
+
+	StreamedFile& streamedFile = mFiles[id];
+	streamedFile.mFileName = path;
+	streamedFile.mMipCount = desc.mMipCount;
+	uint64_t offset = dataOffset;
+	for (uint32_t mip = 0; mip < desc.mMipCount; ++mip)
+	{
+		streamedFile.mMipOffsets[mip] = offset;
+		streamedFile.mMipSizes[mip] = Image::GetMipMappedSize(desc.mWidth, desc.mHeight, 1, mip, 1, desc.mFormat);
+		offset += streamedFile.mMipSizes[mip];
+	}
+	streamedFile.mActive = true;
+	return id;
+}
+
+void TextureStreamer::RemoveTexture(StreamedTextureId id)
+{
+	if (id >= mFiles.size() || !mFiles[id].mActive)
+		return;
+
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < (uint32_t)mPendingReads.size(); ++i)
+	{
+		if (mPendingReads[i].mTexture == id)
+		{
+			mDesc.pFileQueue->Cancel(mPendingReads[i].pHandle);
+			mDesc.pFileQueue->Release(mPendingReads[i].pHandle);
+			continue;
+		}
+		mPendingReads[count++] = mPendingReads[i];
+	}
+	mPendingReads.resize(count);
+
+	mPlanner.RemoveTexture(id);
+	mFiles[id].mFileName = String();
+	mFiles[id].mActive = false;
+}
+
+void TextureStreamer::Update()
+{
+	// Deliver in submission order so the planner sees the same sequence as long as the reads finish in time
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < (uint32_t)mPendingReads.size(); ++i)
+	{
+		PendingRead& read = mPendingReads[i];
+		AsyncReadStatus status = mDesc.pFileQueue->GetStatus(read.pHandle);
+		if (status == ASYNC_READ_STATUS_PENDING || status == ASYNC_READ_STATUS_IN_PROGRESS)
+		{
+			mPendingReads[count++] = read;
+			continue;
+		}
+
+		if (status == ASYNC_READ_STATUS_COMPLETED)
+		{
+			if (mDesc.pMipLoaded)
+			{
+				mDesc.pMipLoaded(read.mTexture, read.mFirstMip, read.mMipCount, mDesc.pFileQueue->GetData(read.pHandle),
+					mDesc.pFileQueue->GetBytesRead(read.pHandle), mDesc.pUserData);
+			}
+			mPlanner.OnMipLoaded(read.mTexture, read.mFirstMip);
+		}
+		else
+		{
+			LOGERRORF("Failed to stream mips %u-%u of %s", read.mFirstMip, read.mFirstMip + read.mMipCount - 1, mFiles[read.mTexture].mFileName.c_str());
+			mPlanner.OnMipLoadFailed(read.mTexture, read.mFirstMip);
+		}
+		mDesc.pFileQueue->Release(read.pHandle);
+	}
+	mPendingReads.resize(count);
+
+	mRequests.clear();
+	mPlanner.Update(&mRequests);
+	for (uint32_t i = 0; i < (uint32_t)mRequests.size(); ++i)
+	{
+		const MipRequest& request = mRequests[i];
+		const StreamedFile& streamedFile = mFiles[request.mTexture];
+		if (request.mType == MIP_REQUEST_EVICT)
+		{
+			if (mDesc.pMipEvicted)
+				mDesc.pMipEvicted(request.mTexture, request.mFirstMip + 1, mDesc.pUserData);
+			continue;
+		}
+
+		AsyncReadDesc readDesc;
+		readDesc.pFileName = streamedFile.mFileName.c_str();
+		readDesc.mRoot = FSR_Absolute;
+		readDesc.mOffset = streamedFile.mMipOffsets[request.mFirstMip];
+		readDesc.mSize = request.mSize;
+		// A texture without its tail can not be sampled at all
+		readDesc.mPriority = request.mFirstMip + request.mMipCount == streamedFile.mMipCount ? ASYNC_READ_PRIORITY_HIGH : ASYNC_READ_PRIORITY_NORMAL;
+
+		PendingRead read = { request.mTexture, request.mFirstMip, request.mMipCount, mDesc.pFileQueue->Submit(&readDesc) };
+		mPendingReads.push_back(read);
+	}
+}
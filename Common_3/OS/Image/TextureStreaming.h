@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "Image.h"
+#include "../Interfaces/IAsyncFileSystem.h"
+#include "../../ThirdParty/OpenSource/TinySTL/vector.h"
+
+#define TEXTURE_STREAMING_MAX_MIPS 16
+#define TEXTURE_STREAMING_INVALID_ID (~0u)
+
+typedef uint32_t StreamedTextureId;
+
+struct StreamedTextureDesc
+{
+	uint32_t			mWidth = 0;
+	uint32_t			mHeight = 0;
+	uint32_t			mMipCount = 1;
+	ImageFormat::Enum	mFormat = ImageFormat::None;
+};
+
+struct TextureResidencyDesc
+{
+	/// Hard limit for resident plus in flight mips. Only the mip tails may exceed it
+	uint64_t	mBudgetBytes = 256ULL << 20;
+	/// Upper bound of bytes requested per Update so streaming does not starve other I/O
+	uint64_t	mMaxLoadBytesPerUpdate = 16ULL << 20;
+	/// Mips whose width and height are both at or below this size form the tail which is loaded on registration and never evicted
+	uint32_t	mTailSize = 64;
+	uint32_t	mMaxPendingLoads = 32;
+	/// Textures not reported for this many updates are treated as invisible
+	uint32_t	mUnusedFrameCount = 30;
+	/// Added to the mip computed from screen coverage, positive values save memory
+	float		mMipBias = 0.0f;
+	/// A loaded mip is only evicted for a load that is at least this much more important
+	float		mEvictionHysteresis = 2.0f;
+};
+
+enum MipRequestType
+{
+	MIP_REQUEST_LOAD = 0,
+	MIP_REQUEST_EVICT,
+};
+
+/// Loads cover [mFirstMip, mFirstMip + mMipCount). Evictions drop mFirstMip, the texture keeps mFirstMip + 1 onwards
+struct MipRequest
+{
+	StreamedTextureId	mTexture;
+	MipRequestType		mType;
+	uint32_t			mFirstMip;
+	uint32_t			mMipCount;
+	uint64_t			mSize;
+};
+
+struct TextureResidencyStatistics
+{
+	uint64_t	mBudgetBytes;
+	uint64_t	mResidentBytes;
+	uint64_t	mPendingBytes;
+	uint64_t	mTailBytes;
+	uint64_t	mLoadedBytes;
+	uint64_t	mEvictedBytes;
+	uint32_t	mTextureCount;
+	/// Textures whose desired mip is resident
+	uint32_t	mSatisfiedCount;
+};
+
+/// CPU side mip residency planner. It does no I/O and never touches the GPU so the same sequence of
+/// AddTexture / ReportUsage / Update / OnMipLoaded calls always produces the same requests.
+/// Mips are streamed one level at a time from the smallest to the largest, highest screen space priority first.
+/// Resident and in flight mips never exceed the budget, lower priority mips are evicted to make room.
+class TextureResidencyPlanner
+{
+public:
+	void Init(const TextureResidencyDesc* pDesc);
+	void Exit();
+
+	StreamedTextureId AddTexture(const StreamedTextureDesc* pDesc);
+	void RemoveTexture(StreamedTextureId id);
+
+	/// Screen coverage of the texture in pixels this frame. Multiple reports per frame keep the largest one
+	void ReportUsage(StreamedTextureId id, float screenPixelCoverage);
+	/// Appends the loads and evictions for this frame to pRequests and advances the frame
+	void Update(tinystl::vector<MipRequest>* pRequests);
+	void OnMipLoaded(StreamedTextureId id, uint32_t firstMip);
+	/// Releases the reservation of a failed load. The texture will not request that mip again
+	void OnMipLoadFailed(StreamedTextureId id, uint32_t firstMip);
+
+	void SetBudget(uint64_t budgetBytes);
+	/// First resident mip, the mip count when nothing is resident yet
+	uint32_t GetResidentMip(StreamedTextureId id) const;
+	uint32_t GetDesiredMip(StreamedTextureId id) const;
+	const TextureResidencyStatistics& GetStatistics() const { return mStatistics; }
+
+	/// Most detailed mip needed to cover screenPixelCoverage pixels without undersampling
+	static uint32_t ComputeDesiredMip(uint32_t width, uint32_t height, uint32_t mipCount, float screenPixelCoverage, float mipBias = 0.0f);
+
+private:
+	struct TextureState
+	{
+		uint64_t	mMipSizes[TEXTURE_STREAMING_MAX_MIPS];
+		uint64_t	mTexels[TEXTURE_STREAMING_MAX_MIPS];
+		uint32_t	mWidth;
+		uint32_t	mHeight;
+		uint32_t	mMipCount;
+		uint32_t	mTailMip;
+		uint32_t	mResidentMip;
+		uint32_t	mPendingMip;
+		uint32_t	mPendingMipCount;
+		/// Mips below this failed to load and are not requested again
+		uint32_t	mMaxDetailMip;
+		uint32_t	mDesiredMip;
+		uint32_t	mLastUsedFrame;
+		float		mCoverage;
+		bool		mActive;
+	};
+
+	uint64_t GetTailSize(const TextureState& texture) const;
+	uint64_t GetRangeSize(const TextureState& texture, uint32_t firstMip, uint32_t mipCount) const;
+	float GetImportance(const TextureState& texture, uint32_t mip) const;
+	bool IsEvictable(const TextureState& texture) const;
+	void IssueLoad(StreamedTextureId id, uint32_t firstMip, uint32_t mipCount, tinystl::vector<MipRequest>* pRequests);
+	void Evict(StreamedTextureId id, tinystl::vector<MipRequest>* pRequests);
+	/// Least important evictable texture other than excludeId, TEXTURE_STREAMING_INVALID_ID if there is none
+	StreamedTextureId FindEvictionCandidate(StreamedTextureId excludeId) const;
+
+	TextureResidencyDesc			mDesc;
+	tinystl::vector<TextureState>	mTextures;
+	tinystl::vector<uint32_t>		mFreeIds;
+	TextureResidencyStatistics		mStatistics;
+	uint32_t						mFrameIndex;
+	uint32_t						mPendingCount;
+};
+
+/// Called from TextureStreamer::Update once the data of [firstMip, firstMip + mipCount) arrived.
+/// pData holds the levels back to back in DDS order and is only valid during the callback
+typedef void(*TextureMipLoadedCallback)(StreamedTextureId id, uint32_t firstMip, uint32_t mipCount, const void* pData, uint64_t size, void* pUserData);
+/// Called from TextureStreamer::Update after the texture dropped every mip above newFirstMip
+typedef void(*TextureMipEvictedCallback)(StreamedTextureId id, uint32_t newFirstMip, void* pUserData);
+
+struct TextureStreamerDesc
+{
+	TextureResidencyDesc		mResidency;
+	AsyncFileQueue*				pFileQueue = NULL;
+	TextureMipLoadedCallback	pMipLoaded = NULL;
+	TextureMipEvictedCallback	pMipEvicted = NULL;
+	void*						pUserData = NULL;
+};
+
+/// Streams the mips of 2D DDS textures through an AsyncFileQueue as decided by a TextureResidencyPlanner.
+/// Uploading the delivered mips and clamping the sampled mip range is left to the caller.
+class TextureStreamer
+{
+public:
+	void Init(const TextureStreamerDesc* pDesc);
+	/// Cancels every read still in flight
+	void Exit();
+
+	/// Reads the DDS header and queues the mip tail. Returns TEXTURE_STREAMING_INVALID_ID for files that can not be streamed
+	/// (cube maps, volumes and non DDS files) so the caller can fall back to Image::loadImage
+	StreamedTextureId AddTexture(const char* fileName, FSRoot root = FSR_Textures, Image* pOutHeader = NULL);
+	void RemoveTexture(StreamedTextureId id);
+	void ReportUsage(StreamedTextureId id, float screenPixelCoverage) { mPlanner.ReportUsage(id, screenPixelCoverage); }
+
+	/// Delivers finished reads, then plans and submits the next ones. Callbacks are invoked from this call
+	void Update();
+
+	TextureResidencyPlanner* GetPlanner() { return &mPlanner; }
+
+private:
+	struct StreamedFile
+	{
+		String		mFileName;
+		uint64_t	mMipOffsets[TEXTURE_STREAMING_MAX_MIPS];
+		uint64_t	mMipSizes[TEXTURE_STREAMING_MAX_MIPS];
+		uint32_t	mMipCount;
+		bool		mActive;
+	};
+
+	struct PendingRead
+	{
+		StreamedTextureId	mTexture;
+		uint32_t			mFirstMip;
+		uint32_t			mMipCount;
+		AsyncReadHandle		pHandle;
+	};
+
+	TextureStreamerDesc				mDesc;
+	TextureResidencyPlanner			mPlanner;
+	tinystl::vector<StreamedFile>	mFiles;
+	tinystl::vector<PendingRead>	mPendingReads;
+	tinystl::vector<MipRequest>		mRequests;
+};
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../Interfaces/IFileSystem.h"
+#include "../Interfaces/IThread.h"
+
+// Large reads are split into chunks so cancellation does not have to wait for the whole range
+#define ASYNC_READ_CHUNK_SIZE (4ULL << 20)
+#define ASYNC_READ_MAX_THREADS 8
+// Read the remainder of the file starting at mOffset
+#define ASYNC_READ_WHOLE_FILE (~0ULL)
+
+enum AsyncReadPriority
+{
+	ASYNC_READ_PRIORITY_LOW = 0,
+	ASYNC_READ_PRIORITY_NORMAL,
+	ASYNC_READ_PRIORITY_HIGH,
+	/// Data needed to finish the current frame
+	ASYNC_READ_PRIORITY_CRITICAL,
+	ASYNC_READ_PRIORITY_COUNT,
+};
+
+enum AsyncReadStatus
+{
+	ASYNC_READ_STATUS_PENDING = 0,
+	ASYNC_READ_STATUS_IN_PROGRESS,
+	ASYNC_READ_STATUS_COMPLETED,
+	ASYNC_READ_STATUS_FAILED,
+	ASYNC_READ_STATUS_CANCELED,
+};
+
+typedef struct AsyncReadRequest* AsyncReadHandle;
+/// Called on the I/O thread once the request completed, failed or got canceled
+typedef void(*AsyncReadCallback)(AsyncReadHandle handle, AsyncReadStatus status, void* pUserData);
+
+struct AsyncReadDesc
+{
+	const char*			pFileName = NULL;
+	FSRoot				mRoot = FSR_OtherFiles;
+	uint64_t			mOffset = 0;
+	/// Number of bytes to read or ASYNC_READ_WHOLE_FILE
+	uint64_t			mSize = ASYNC_READ_WHOLE_FILE;
+	/// Must stay valid until the request finished. When NULL the queue allocates the buffer (see GetData)
+	void*				pDestination = NULL;
+	AsyncReadPriority	mPriority = ASYNC_READ_PRIORITY_NORMAL;
+	AsyncReadCallback	pCallback = NULL;
+	void*				pUserData = NULL;
+};
+
+/// Queued asynchronous file reads backed by dedicated I/O threads.
+/// Offsets and sizes are 64 bit so ranges inside files larger than 4GB can be read.
+/// Requests are served highest priority first, FIFO within a priority. Every handle returned by Submit must be released.
+class AsyncFileQueue
+{
+public:
+	AsyncFileQueue();
+	~AsyncFileQueue();
+
+	void Init(uint32_t threadCount = 1);
+	/// Cancels everything still pending and joins the I/O threads
+	void Exit();
+
+	AsyncReadHandle Submit(const AsyncReadDesc* pDesc);
+	/// Pending requests are dropped, requests in progress stop at the next chunk boundary.
+	/// Returns false if the request already finished
+	bool Cancel(AsyncReadHandle handle);
+	AsyncReadStatus GetStatus(AsyncReadHandle handle);
+	/// Blocks until the request finished and returns its final status
+	AsyncReadStatus Wait(AsyncReadHandle handle);
+	/// Blocks until every submitted request finished
+	void WaitIdle();
+	uint64_t GetBytesRead(AsyncReadHandle handle);
+	/// Destination of the request (the queue owned buffer when no destination was given)
+	void* GetData(AsyncReadHandle handle);
+	/// Waits for the request and frees it together with a queue owned buffer
+	void Release(AsyncReadHandle handle);
+
+	uint32_t GetPendingCount();
+
+	static void ProcessRequests(void* pQueue);
+
+private:
+	uint32_t GetPendingCountUnlocked() const;
+	AsyncReadRequest* PopRequest();
+	void Finish(AsyncReadRequest* pRequest, AsyncReadStatus status);
+
+	tinystl::vector<AsyncReadRequest*>	mQueues[ASYNC_READ_PRIORITY_COUNT];
+	ThreadHandle						mThreads[ASYNC_READ_MAX_THREADS];
+	WorkItem							mThreadItems[ASYNC_READ_MAX_THREADS];
+	uint32_t							mThreadCount;
+	uint32_t							mActiveCount;
+	Mutex								mMutex;
+	ConditionVariable					mWorkCondition;
+	ConditionVariable					mDoneCondition;
+	volatile bool						mShutDown;
+};
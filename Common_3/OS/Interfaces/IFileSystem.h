@@ -27,6 +27,7 @@
 //#define USE_VFS
 
 #include "../Interfaces/IOperatingSystem.h"
+#include "../Core/ContentHash.h"
 #include "../../ThirdParty/OpenSource/TinySTL/string.h"
 #include "../../ThirdParty/OpenSource/TinySTL/vector.h"
 
@@ -49,6 +50,9 @@ void _flushFile(FileHandle handle);
 size_t _readFile(void *buffer, size_t byteCount, FileHandle handle);
 bool _seekFile(FileHandle handle, long offset, int origin);
 long _tellFile(FileHandle handle);
+/// 64 bit variants for files larger than 2GB
+bool _seekFile64(FileHandle handle, int64_t offset, int origin);
+int64_t _tellFile64(FileHandle handle);
 size_t _writeFile(const void *buffer, size_t byteCount, FileHandle handle);
 size_t _getFileLastModifiedTime(const char* _fileName);
 
@@ -136,6 +140,11 @@ enum FSRoot {
 	FSR_Count
 };
 
+/// Manifest written by the asset cook pipeline next to its content addressed cache
+#define COOK_MANIFEST_FILE_NAME "CookManifest.bin"
+#define COOK_MANIFEST_MAGIC 0x4E414D43 // 'CMAN'
+#define COOK_MANIFEST_VERSION 2
+
 enum SeekDir
 {
 	SEEK_DIR_BEGIN = 0,
@@ -154,7 +163,10 @@ public:
 	virtual unsigned Read(void* dest, unsigned size) = 0;
 	virtual unsigned Seek(unsigned position, SeekDir seekDir = SEEK_DIR_BEGIN) = 0;
 	virtual const String& GetName() const = 0;
+	/// CRC32C of the whole stream
 	virtual unsigned GetChecksum();
+	/// 128 bit XXHash64 style digest of the whole stream, suitable as a cache / asset identity key
+	virtual Hash128 GetContentHash();
 
 	unsigned GetPosition() const { return mPosition; }
 	unsigned GetSize() const { return mSize; }
@@ -257,6 +269,9 @@ public:
 	unsigned Seek(unsigned position, SeekDir seekDir = SEEK_DIR_BEGIN) override;
 	unsigned Write(const void* data, unsigned size) override;
 
+	unsigned GetChecksum() override;
+	Hash128 GetContentHash() override;
+
 	unsigned char* GetData() { return pBuffer; }
 	bool IsReadOnly() { return mReadOnly; }
 
@@ -271,6 +286,7 @@ class FileSystem
 {
 public:
 	static unsigned	GetFileSize(FileHandle handle);
+	static uint64_t	GetFileSize64(FileHandle handle);
 	// Allows to modify root paths at runtime
 	static void		SetRootPath(FSRoot root, const String& rootPath);
 	// Reverts back to App static defined pszRoots[]
@@ -304,6 +320,17 @@ public:
 	static bool		CreateDir(const String& pathName);
 	static int		SystemRun(const String& fileName, const tinystl::vector<String>& arguments, String stdOut = "");
 	static bool		Delete(const String& fileName);
+	// Replaces newName if it exists. Atomic when both files are on the same volume
+	static bool		Rename(const String& oldName, const String& newName);
+
+	// File::Open never redirects to cooked outputs. Loaders which understand the cooked format (Image::loadImage,
+	// TextureStreamer, AssimpImporter::ReadMesh callers) look them up through GetCookedPath once a manifest is loaded
+	static bool		LoadCookManifest(const String& fileName, FSRoot root);
+	static void		ClearCookManifest();
+	// Returns the absolute path of the cooked output of a source file or an empty string
+	static String	GetCookedPath(const String& fileName, FSRoot root);
+	// Manifest entries are keyed by root and root relative path so they do not depend on the working directory
+	static String	GetCookManifestKey(const String& fileName, FSRoot root);
 
 private:
 	// The following root paths are the ones that were modified at run-time
@@ -68,13 +68,19 @@ struct MutexLock
 	Mutex& mMutex;
 };
 
+/// Passed to ConditionVariable::Wait to block until the variable is set
+#define TIMEOUT_INFINITE (~0U)
+
 struct ConditionVariable
 {
 	ConditionVariable();
 	~ConditionVariable();
 
-	void Wait(const Mutex& mutex, unsigned md);
+	void Wait(const Mutex& mutex, unsigned md = TIMEOUT_INFINITE);
+	/// Wakes one waiting thread
 	void Set();
+	/// Wakes every waiting thread
+	void SetAll();
 
 #ifdef _WIN32
 	void* pHandle;
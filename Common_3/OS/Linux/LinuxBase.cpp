@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#ifdef LINUX
+
+#include <ctime>
+
+#include "../Interfaces/IOperatingSystem.h"
+#include "../Interfaces/ILogManager.h"
+#include "../Interfaces/ITimeManager.h"
+#include "../Interfaces/IMemoryManager.h"
+
+// Only the platform services used by the CPU side libraries and tools live here.
+// Window and input handling still need an X11/Wayland backend.
+
+static bool gAppRunning = true;
+
+bool isRunning()
+{
+	return gAppRunning;
+}
+
+void requestShutDown()
+{
+	gAppRunning = false;
+}
+
+/************************************************************************/
+// Input handling
+/************************************************************************/
+
+// TODO: Implement keyboard, mouse and gamepad input together with the window backend
+float2 getMousePosition()
+{
+	return float2(0.0f, 0.0f);
+}
+
+bool getKeyDown(int /*key*/)
+{
+	return false;
+}
+
+bool getKeyUp(int /*key*/)
+{
+	return false;
+}
+
+bool getJoystickButtonDown(int /*button*/)
+{
+	return false;
+}
+
+bool getJoystickButtonUp(int /*button*/)
+{
+	return false;
+}
+
+/************************************************************************/
+// Time Related Functions
+/************************************************************************/
+
+// Monotonic clock in microseconds, unaffected by wall clock adjustments
+static int64_t getMonotonicUSec()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+unsigned getSystemTime()
+{
+	return (unsigned)(getMonotonicUSec() / 1000);
+}
+
+unsigned getTimeSinceStart()
+{
+	return (unsigned)time(NULL);
+}
+
+// Unlike the Windows performance counter getUSec already returns microseconds, HiresTimer relies on that
+int64_t getUSec()
+{
+	return getMonotonicUSec();
+}
+
+int64_t getMSec()
+{
+	return getMonotonicUSec() / 1000;
+}
+
+int64_t getTimerFrequency()
+{
+	return 1000000LL;
+}
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#ifdef LINUX
+
+#include "../Interfaces/IFileSystem.h"
+#include "../Interfaces/ILogManager.h"
+#include "../Interfaces/IOperatingSystem.h"
+#include "../Interfaces/IMemoryManager.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <pwd.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+FileHandle _openFile(const char* filename, const char* flags)
+{
+	FILE* fp = fopen(filename, flags);
+	return fp;
+}
+
+void _closeFile(FileHandle handle)
+{
+	fclose((::FILE*)handle);
+}
+
+void _flushFile(FileHandle handle)
+{
+	fflush((::FILE*)handle);
+}
+
+size_t _readFile(void *buffer, size_t byteCount, FileHandle handle)
+{
+	return fread(buffer, 1, byteCount, (::FILE*)handle);
+}
+
+bool _seekFile(FileHandle handle, long offset, int origin)
+{
+	return fseek((::FILE*)handle, offset, origin) == 0;
+}
+
+long _tellFile(FileHandle handle)
+{
+	return ftell((::FILE*)handle);
+}
+
+bool _seekFile64(FileHandle handle, int64_t offset, int origin)
+{
+	return fseeko((::FILE*)handle, (off_t)offset, origin) == 0;
+}
+
+int64_t _tellFile64(FileHandle handle)
+{
+	return (int64_t)ftello((::FILE*)handle);
+}
+
+// Writes the buffer as one element, so 1 means everything was written. File::Write relies on this like on Windows
+size_t _writeFile(const void *buffer, size_t byteCount, FileHandle handle)
+{
+	return fwrite(buffer, byteCount, 1, (::FILE*)handle);
+}
+
+size_t _getFileLastModifiedTime(const char* _fileName)
+{
+	struct stat fileInfo;
+
+	if (!stat(_fileName, &fileInfo))
+	{
+		return (size_t)fileInfo.st_mtime;
+	}
+	else
+	{
+		// return an impossible large mod time as the file doesn't exist
+		return ~0;
+	}
+}
+
+static String getHomeDir()
+{
+	const char* home = getenv("HOME");
+	if (!home || !home[0])
+	{
+		struct passwd* pw = getpwuid(getuid());
+		home = pw ? pw->pw_dir : "";
+	}
+	return String(home);
+}
+
+String _getCurrentDir()
+{
+	char cwd[PATH_MAX] = "";
+	if (!getcwd(cwd, sizeof(cwd)))
+		cwd[0] = 0;
+	return String(cwd);
+}
+
+String _getExePath()
+{
+	char exeName[PATH_MAX];
+	ssize_t length = readlink("/proc/self/exe", exeName, sizeof(exeName) - 1);
+	exeName[length > 0 ? length : 0] = 0;
+	return String(exeName);
+}
+
+String _getAppPrefsDir(const char *org, const char *app)
+{
+	// Follow the XDG base directory spec: $XDG_CONFIG_HOME/org/app, defaulting to ~/.config/org/app
+	const char* configHome = getenv("XDG_CONFIG_HOME");
+	String path = (configHome && configHome[0]) ? String(configHome) : getHomeDir() + "/.config";
+
+	// The config home itself may not exist yet on a fresh account
+	if (mkdir(path.c_str(), S_IRWXU) != 0 && errno != EEXIST)
+		return String();
+
+	const char* subDirs[] = { org, app };
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		path += "/";
+		path += subDirs[i];
+		if (mkdir(path.c_str(), S_IRWXU) != 0 && errno != EEXIST)
+			return String();
+	}
+
+	path += "/";
+	return path;
+}
+
+String _getUserDocumentsDir()
+{
+	String home = getHomeDir();
+	String documents = home + "/Documents";
+
+	struct stat st;
+	if (stat(documents.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+		return documents;
+
+	return home;
+}
+
+void _setCurrentDir(const char* path)
+{
+	if (chdir(path) != 0)
+		LOGERRORF("Failed to change the current directory to %s", path);
+}
+
+#endif
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#ifdef LINUX
+
+#include <stdarg.h>
+#include <unistd.h>
+
+// interfaces
+#include "../Interfaces/IOperatingSystem.h"
+#include "../Interfaces/ILogManager.h"
+#include "../Interfaces/IMemoryManager.h"
+
+// Formats "file(line)\tmessage" into buf
+static void formatMessage(char* buf, unsigned bufferSize, int line, const char* file, const char* string, va_list arglist)
+{
+	// put source code file name at the begin
+	snprintf(buf, bufferSize, "%s", file);
+	// put line positoin in code
+	snprintf(buf + strlen(buf), bufferSize - strlen(buf), "(%d)\t", line);
+	vsnprintf(buf + strlen(buf), bufferSize - strlen(buf), string, arglist);
+}
+
+void _ErrorMsg(int line, const char *file, const char *string, ...)
+{
+	ASSERT(string);
+	//Eval the string
+	const unsigned BUFFER_SIZE = 65536;
+	char buf[BUFFER_SIZE];
+
+	va_list arglist;
+	va_start(arglist, string);
+	formatMessage(buf, BUFFER_SIZE, line, file, string, arglist);
+	va_end(arglist);
+
+	// no message box on a headless machine, errors go to stderr
+	fprintf(stderr, "Error: %s\n", buf);
+}
+
+void _WarningMsg(int line, const char *file, const char *string, ...)
+{
+	ASSERT(string);
+	//Eval the string
+	const unsigned BUFFER_SIZE = 65536;
+	char buf[BUFFER_SIZE];
+
+	va_list arglist;
+	va_start(arglist, string);
+	formatMessage(buf, BUFFER_SIZE, line, file, string, arglist);
+	va_end(arglist);
+
+	fprintf(stderr, "Warning: %s\n", buf);
+}
+
+void _InfoMsg(int line, const char *file, const char *string, ...)
+{
+	ASSERT(string);
+	//Eval the string
+	const unsigned BUFFER_SIZE = 65536;
+	char buf[BUFFER_SIZE];
+
+	va_list arglist;
+	va_start(arglist, string);
+	formatMessage(buf, BUFFER_SIZE, line, file, string, arglist);
+	va_end(arglist);
+
+	_OutputDebugString(buf);
+}
+
+void _OutputDebugString(const char *str, ...)
+{
+	UNREF_PARAM(str);
+#ifdef _DEBUG
+	const unsigned BUFFER_SIZE = 4096;
+	char buf[BUFFER_SIZE];
+
+	va_list arglist;
+	va_start(arglist, str);
+	vsnprintf(buf, BUFFER_SIZE, str, arglist);
+	va_end(arglist);
+
+	// stderr keeps debug output apart from tool output piped through stdout
+	fprintf(stderr, "%s\n", buf);
+#endif
+}
+
+void _FailedAssert(const char *file, int line, const char *statement)
+{
+	static bool debug = true;
+
+	if (debug) {
+		fprintf(stderr, "Failed: (%s)\n\nFile: %s\nLine: %d\n\n", statement, file, line);
+		fflush(stderr);
+	}
+}
+
+void _PrintUnicode(const String& str, bool error)
+{
+	FILE* out = error ? stderr : stdout;
+	fputs(str.c_str(), out);
+	// Flush interactive output right away, redirected output is flushed by the C runtime
+	if (isatty(fileno(out)))
+		fflush(out);
+}
+
+void _PrintUnicodeLine(const String& str, bool error)
+{
+	// Terminals do not break lines between messages the way the Windows debug output does
+	_PrintUnicode(str + "\n", error);
+}
+
+#endif
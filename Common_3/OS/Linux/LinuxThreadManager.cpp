@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#ifdef LINUX
+
+#include <time.h>
+#include <unistd.h>
+
+#include "../Interfaces/IThread.h"
+#include "../Interfaces/IOperatingSystem.h"
+#include "../Interfaces/ILogManager.h"
+#include "../Interfaces/IMemoryManager.h"
+
+void* ThreadFunctionStatic(void* data)
+{
+	WorkItem* pItem = (WorkItem*)data;
+	pItem->pFunc(pItem->pData);
+	return 0;
+}
+
+Mutex::Mutex()
+{
+	pthread_mutex_init(&pHandle, NULL);
+}
+
+Mutex::~Mutex()
+{
+	pthread_mutex_destroy(&pHandle);
+}
+
+void Mutex::Acquire()
+{
+	pthread_mutex_lock(&pHandle);
+}
+
+void Mutex::Release()
+{
+	pthread_mutex_unlock(&pHandle);
+}
+
+ConditionVariable::ConditionVariable()
+{
+	int res = pthread_cond_init(&pHandle, NULL);
+	ASSERT(res == 0);
+	UNREF_PARAM(res);
+}
+
+ConditionVariable::~ConditionVariable()
+{
+	pthread_cond_destroy(&pHandle);
+}
+
+void ConditionVariable::Wait(const Mutex& mutex, unsigned ms)
+{
+	pthread_mutex_t* mutexHandle = (pthread_mutex_t*)&mutex.pHandle;
+	if (ms == TIMEOUT_INFINITE)
+	{
+		pthread_cond_wait(&pHandle, mutexHandle);
+		return;
+	}
+
+	// pthread_cond_timedwait takes an absolute CLOCK_REALTIME deadline
+	timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += ms / 1000;
+	ts.tv_nsec += (long)(ms % 1000) * 1000000;
+	if (ts.tv_nsec >= 1000000000)
+	{
+		ts.tv_sec += 1;
+		ts.tv_nsec -= 1000000000;
+	}
+
+	pthread_cond_timedwait(&pHandle, mutexHandle, &ts);
+}
+
+void ConditionVariable::Set()
+{
+	pthread_cond_signal(&pHandle);
+}
+
+void ConditionVariable::SetAll()
+{
+	pthread_cond_broadcast(&pHandle);
+}
+
+ThreadID Thread::mainThreadID;
+
+void Thread::SetMainThread()
+{
+	mainThreadID = GetCurrentThreadID();
+}
+
+ThreadID Thread::GetCurrentThreadID()
+{
+	return pthread_self();
+}
+
+bool Thread::IsMainThread()
+{
+	return pthread_equal(GetCurrentThreadID(), mainThreadID) != 0;
+}
+
+ThreadHandle _createThread(WorkItem* pData)
+{
+	pthread_t handle;
+	int res = pthread_create(&handle, NULL, ThreadFunctionStatic, pData);
+	ASSERT(res == 0);
+	UNREF_PARAM(res);
+	return (ThreadHandle)handle;
+}
+
+void _destroyThread(ThreadHandle handle)
+{
+	ASSERT(handle != 0);
+	// Wait for the thread function to return so the pool can free what it uses
+	pthread_join(handle, NULL);
+}
+
+void _joinThread(ThreadHandle handle)
+{
+	pthread_join(handle, NULL);
+}
+
+void Thread::Sleep(unsigned mSec)
+{
+	usleep(mSec * 1000);
+}
+
+// threading class (Static functions)
+unsigned int Thread::GetNumCPUCores(void)
+{
+	long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	return ncpu > 0 ? (unsigned int)ncpu : 1;
+}
+
+#endif
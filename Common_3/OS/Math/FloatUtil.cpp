@@ -50,4 +50,151 @@ float saturate(const float x)
 
 float sCurve(const float t) {
 	return t * t * (3 - 2 * t);
-}
\ No newline at end of file
+}
+/************************************************************************/
+// Batch HDR packing
+/************************************************************************/
+#if !VECTORMATH_MODE_SCALAR
+static inline __m128i select(const __m128 mask, const __m128i a, const __m128i b) {
+	const __m128i m = _mm_castps_si128(mask);
+	return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+
+// Loads 4 pixels of channelCount floats as r, g, b vectors, negative and NaN components become 0 like the scalar path
+static inline void loadRGB4(const float* pSrc, uint32_t channelCount, __m128& r, __m128& g, __m128& b) {
+	__m128 p0, p1, p2, p3;
+	if (channelCount == 4) {
+		p0 = _mm_loadu_ps(pSrc);
+		p1 = _mm_loadu_ps(pSrc + 4);
+		p2 = _mm_loadu_ps(pSrc + 8);
+		p3 = _mm_loadu_ps(pSrc + 12);
+	}
+	else {
+		p0 = _mm_loadu_ps(pSrc);
+		p1 = _mm_loadu_ps(pSrc + 3);
+		p2 = _mm_loadu_ps(pSrc + 6);
+		// Do not read past the last pixel
+		p3 = _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(pSrc + 9)), _mm_load_ss(pSrc + 11));
+	}
+	_MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+	r = _mm_max_ps(p0, _mm_setzero_ps());
+	g = _mm_max_ps(p1, _mm_setzero_ps());
+	b = _mm_max_ps(p2, _mm_setzero_ps());
+}
+
+// frexpf(v) * 2^bias / v is exactly 2^(bias - ex) for normal v, built straight from the exponent bits
+static inline __m128 sharedExponentScale(const __m128i biasedExponent, const int bias) {
+	return _mm_castsi128_ps(_mm_slli_epi32(_mm_sub_epi32(_mm_set1_epi32(253 + bias), biasedExponent), 23));
+}
+
+static inline __m128i rgbToRGBE8x4(const __m128 r, const __m128 g, const __m128 b) {
+	const __m128 v = _mm_max_ps(_mm_max_ps(r, g), b);
+	const __m128i exponent = _mm_srli_epi32(_mm_castps_si128(v), 23);
+	const __m128 m = sharedExponentScale(exponent, 8);
+
+	__m128i packed = _mm_cvttps_epi32(_mm_mul_ps(m, r));
+	packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_cvttps_epi32(_mm_mul_ps(m, g)), 8));
+	packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_cvttps_epi32(_mm_mul_ps(m, b)), 16));
+	packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_add_epi32(exponent, _mm_set1_epi32(2)), 24));
+	return select(_mm_cmplt_ps(v, _mm_set1_ps(1e-32f)), _mm_setzero_si128(), packed);
+}
+
+static inline __m128i rgbToRGB9E5x4(const __m128 r, const __m128 g, const __m128 b) {
+	const __m128 v = _mm_max_ps(_mm_max_ps(r, g), b);
+	const __m128i exponent = _mm_srli_epi32(_mm_castps_si128(v), 23);
+	const __m128 m = sharedExponentScale(exponent, 9);
+
+	__m128i packed = _mm_cvttps_epi32(_mm_mul_ps(m, r));
+	packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_cvttps_epi32(_mm_mul_ps(m, g)), 9));
+	packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_cvttps_epi32(_mm_mul_ps(m, b)), 18));
+	packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_sub_epi32(exponent, _mm_set1_epi32(111)), 27));
+
+	// Out of range: the maximum exponent, components at or above 65536 saturate
+	const __m128 limit = _mm_set1_ps(65536.0f);
+	const __m128 scale = _mm_set1_ps(1.0f / 128.0f);
+	const __m128i saturated = _mm_set1_epi32(0x1FF);
+	__m128i clamped = select(_mm_cmplt_ps(r, limit), _mm_cvttps_epi32(_mm_mul_ps(r, scale)), saturated);
+	clamped = _mm_or_si128(clamped, _mm_slli_epi32(select(_mm_cmplt_ps(g, limit), _mm_cvttps_epi32(_mm_mul_ps(g, scale)), saturated), 9));
+	clamped = _mm_or_si128(clamped, _mm_slli_epi32(select(_mm_cmplt_ps(b, limit), _mm_cvttps_epi32(_mm_mul_ps(b, scale)), saturated), 18));
+	clamped = _mm_or_si128(clamped, _mm_set1_epi32(31 << 27));
+
+	packed = select(_mm_cmplt_ps(v, limit), packed, clamped);
+	return select(_mm_cmplt_ps(v, _mm_set1_ps(1.52587890625e-5f)), _mm_setzero_si128(), packed);
+}
+#endif
+
+void rgbeToRGB(const unsigned char* pRGBE, float* pDst, uint32_t channelCount, size_t pixelCount) {
+	size_t i = 0;
+#if !VECTORMATH_MODE_SCALAR
+	const __m128i byteMask = _mm_set1_epi32(0xFF);
+	const __m128i minExponent = _mm_set1_epi32(10);
+	for (; i + 4 <= pixelCount; i += 4, pRGBE += 16, pDst += 4 * channelCount) {
+		const __m128i rgbe = _mm_loadu_si128((const __m128i*)pRGBE);
+		const __m128i e = _mm_srli_epi32(rgbe, 24);
+		// 2^(e - 136) is denormal for e < 10, so it is applied as 2^max(e - 136, -126) * 2^min(e - 10, 0).
+		// Both products are exact, which gives the same result as the single scalar multiply.
+		const __m128i small = _mm_cmpgt_epi32(minExponent, e);
+		const __m128 scale0 = _mm_castsi128_ps(_mm_slli_epi32(_mm_sub_epi32(select(_mm_castsi128_ps(small), minExponent, e), _mm_set1_epi32(9)), 23));
+		const __m128 scale1 = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(select(_mm_castsi128_ps(small), e, minExponent), _mm_set1_epi32(117)), 23));
+		const __m128 zero = _mm_castsi128_ps(_mm_cmpeq_epi32(e, _mm_setzero_si128()));
+
+		__m128 r = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(rgbe, byteMask)), scale0), scale1);
+		__m128 g = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(rgbe, 8), byteMask)), scale0), scale1);
+		__m128 b = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(rgbe, 16), byteMask)), scale0), scale1);
+		r = _mm_andnot_ps(zero, r);
+		g = _mm_andnot_ps(zero, g);
+		b = _mm_andnot_ps(zero, b);
+		__m128 a = _mm_set1_ps(1.0f);
+		_MM_TRANSPOSE4_PS(r, g, b, a);
+
+		if (channelCount == 4) {
+			_mm_storeu_ps(pDst, r);
+			_mm_storeu_ps(pDst + 4, g);
+			_mm_storeu_ps(pDst + 8, b);
+			_mm_storeu_ps(pDst + 12, a);
+		}
+		else {
+			// Each store overwrites the first float of the next pixel before that pixel is written, the last one stops at the end
+			_mm_storeu_ps(pDst, r);
+			_mm_storeu_ps(pDst + 3, g);
+			_mm_storeu_ps(pDst + 6, b);
+			_mm_storel_pi((__m64*)(pDst + 9), a);
+			_mm_store_ss(pDst + 11, _mm_movehl_ps(a, a));
+		}
+	}
+#endif
+	for (; i < pixelCount; ++i, pRGBE += 4, pDst += channelCount) {
+		const vec3 rgb = rgbeToRGB((unsigned char*)pRGBE);
+		pDst[0] = rgb.getX();
+		pDst[1] = rgb.getY();
+		pDst[2] = rgb.getZ();
+		if (channelCount == 4)
+			pDst[3] = 1.0f;
+	}
+}
+
+void rgbToRGBE8(const float* pSrc, uint32_t channelCount, unsigned int* pDst, size_t pixelCount) {
+	size_t i = 0;
+#if !VECTORMATH_MODE_SCALAR
+	for (; i + 4 <= pixelCount; i += 4, pSrc += 4 * channelCount, pDst += 4) {
+		__m128 r, g, b;
+		loadRGB4(pSrc, channelCount, r, g, b);
+		_mm_storeu_si128((__m128i*)pDst, rgbToRGBE8x4(r, g, b));
+	}
+#endif
+	for (; i < pixelCount; ++i, pSrc += channelCount)
+		*pDst++ = rgbToRGBE8(vec3(pSrc[0], pSrc[1], pSrc[2]));
+}
+
+void rgbToRGB9E5(const float* pSrc, uint32_t channelCount, unsigned int* pDst, size_t pixelCount) {
+	size_t i = 0;
+#if !VECTORMATH_MODE_SCALAR
+	for (; i + 4 <= pixelCount; i += 4, pSrc += 4 * channelCount, pDst += 4) {
+		__m128 r, g, b;
+		loadRGB4(pSrc, channelCount, r, g, b);
+		_mm_storeu_si128((__m128i*)pDst, rgbToRGB9E5x4(r, g, b));
+	}
+#endif
+	for (; i < pixelCount; ++i, pSrc += channelCount)
+		*pDst++ = rgbToRGB9E5(vec3(pSrc[0], pSrc[1], pSrc[2]));
+}
@@ -27,6 +27,7 @@
 
 #include <math.h>
 #include <stdint.h>
+#include <stddef.h>
 #ifdef _ANDROID
 #include "../../Common_2/Code/Renderer/Android/AndroidDefines.h"
 #endif
@@ -238,8 +239,12 @@ inline vec3 rgbeToRGB(unsigned char *rgbe)
 inline unsigned int rgbToRGBE8(const vec3 &rgb)
 {
 	//This is bad usage of vec3, causing movement of data between registers
-	float v = max(rgb.getX(), rgb.getY());
-	v = max(v, (float)rgb.getZ());
+	// Negative and NaN components are stored as 0
+	const float x = max((float)rgb.getX(), 0.0f);
+	const float y = max((float)rgb.getY(), 0.0f);
+	const float z = max((float)rgb.getZ(), 0.0f);
+	float v = max(x, y);
+	v = max(v, z);
 
 	if (v < 1e-32f) {
 		return 0;
@@ -248,9 +253,9 @@ inline unsigned int rgbToRGBE8(const vec3 &rgb)
 		int ex;
 		float m = frexpf(v, &ex) * 256.0f / v;
 
-		unsigned int r = (unsigned int)(m * rgb.getX());
-		unsigned int g = (unsigned int)(m * rgb.getY());
-		unsigned int b = (unsigned int)(m * rgb.getZ());
+		unsigned int r = (unsigned int)(m * x);
+		unsigned int g = (unsigned int)(m * y);
+		unsigned int b = (unsigned int)(m * z);
 		unsigned int e = (unsigned int)(ex + 128);
 
 		return r | (g << 8) | (b << 16) | (e << 24);
@@ -259,8 +264,12 @@ inline unsigned int rgbToRGBE8(const vec3 &rgb)
 inline unsigned int rgbToRGB9E5(const vec3 &rgb)
 {
 	//This is bad usage of vec3, causing movement of data between registers
-	float v = max(rgb.getX(), rgb.getY());
-	v = max(v, (float)rgb.getZ());
+	// Negative and NaN components are stored as 0
+	const float x = max((float)rgb.getX(), 0.0f);
+	const float y = max((float)rgb.getY(), 0.0f);
+	const float z = max((float)rgb.getZ(), 0.0f);
+	float v = max(x, y);
+	v = max(v, z);
 
 	if (v < 1.52587890625e-5f) {
 		return 0;
@@ -269,23 +278,30 @@ inline unsigned int rgbToRGB9E5(const vec3 &rgb)
 		int ex;
 		float m = frexpf(v, &ex) * 512.0f / v;
 
-		unsigned int r = (unsigned int)(m * rgb.getX());
-		unsigned int g = (unsigned int)(m * rgb.getY());
-		unsigned int b = (unsigned int)(m * rgb.getZ());
+		unsigned int r = (unsigned int)(m * x);
+		unsigned int g = (unsigned int)(m * y);
+		unsigned int b = (unsigned int)(m * z);
 		unsigned int e = (unsigned int)(ex + 15);
 
 		return r | (g << 9) | (b << 18) | (e << 27);
 	}
 	else {
-		unsigned int r = (rgb.getX() < 65536) ? (unsigned int)(rgb.getX() * (1.0f / 128.0f)) : 0x1FF;
-		unsigned int g = (rgb.getY() < 65536) ? (unsigned int)(rgb.getY() * (1.0f / 128.0f)) : 0x1FF;
-		unsigned int b = (rgb.getZ() < 65536) ? (unsigned int)(rgb.getZ() * (1.0f / 128.0f)) : 0x1FF;
+		unsigned int r = (x < 65536) ? (unsigned int)(x * (1.0f / 128.0f)) : 0x1FF;
+		unsigned int g = (y < 65536) ? (unsigned int)(y * (1.0f / 128.0f)) : 0x1FF;
+		unsigned int b = (z < 65536) ? (unsigned int)(z * (1.0f / 128.0f)) : 0x1FF;
 		unsigned int e = 31;
 
 		return r | (g << 9) | (b << 18) | (e << 27);
 	}
 }
 
+// Batch versions of rgbeToRGB, rgbToRGBE8 and rgbToRGB9E5 for whole images, bit identical to the per pixel versions
+// for finite input. Float pixels are tightly packed with channelCount (3 or 4) floats: alpha is ignored when packing
+// and written as 1 when unpacking.
+void rgbeToRGB(const unsigned char* pRGBE, float* pDst, uint32_t channelCount, size_t pixelCount);
+void rgbToRGBE8(const float* pSrc, uint32_t channelCount, unsigned int* pDst, size_t pixelCount);
+void rgbToRGB9E5(const float* pSrc, uint32_t channelCount, unsigned int* pDst, size_t pixelCount);
+
 
 inline vec3 min(const vec3 &a, const vec3 &b)
 {
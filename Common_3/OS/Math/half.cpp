@@ -22,8 +22,74 @@
  * under the License.
 */
 
+
 #include "./half.h"
 
+#include <stdint.h>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define HALF_SSE2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define HALF_TARGET_F16C
+#else
+#include <cpuid.h>
+#define HALF_TARGET_F16C __attribute__((target("avx,f16c")))
+#endif
+#else
+#define HALF_SSE2 0
+#endif
+
+// Round to nearest even. Values from 65520 up overflow to Inf, NaNs keep the top of their payload and get the quiet bit.
+static inline unsigned short floatBitsToHalf(uint32_t i) {
+	const uint32_t sign = (i >> 16) & 0x8000;
+	uint32_t a = i & 0x7FFFFFFF;
+
+	if (a >= 0x47800000) {
+		// INF / NAN / overflow
+		if (a > 0x7F800000)
+			return (unsigned short)(sign | 0x7E00 | ((a >> 13) & 0x03FF));
+		return (unsigned short)(sign | 0x7C00);
+	}
+	if (a < 0x38800000) {
+		// Denorm: adding 0.5 moves the half mantissa into the low bits of the float, the FPU does the rounding
+		union {
+			uint32_t u;
+			float f;
+		};
+		u = a;
+		f += 0.5f;
+		return (unsigned short)(sign | (u - 0x3F000000));
+	}
+
+	// Rebias the exponent and round, a mantissa carry steps into the exponent (up to INF)
+	a += 0xC8000FFF + ((a >> 13) & 1);
+	return (unsigned short)(sign | (a >> 13));
+}
+
+// Exact. NaNs keep their payload and get the quiet bit, like F16C.
+static inline uint32_t halfBitsToFloat(unsigned short h) {
+	const uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+	const uint32_t a = h & 0x7FFF;
+
+	if (a >= 0x7C00) {
+		// INF / NAN
+		return sign | 0x7F800000 | ((a & 0x03FF) << 13) | (a > 0x7C00 ? 0x00400000 : 0);
+	}
+	if (a < 0x0400) {
+		// +/- 0 and denorm: m * 2^-24 is exact and does not depend on denormals-are-zero
+		union {
+			uint32_t u;
+			float f;
+		};
+		f = (float)a * (1.0f / 16777216.0f);
+		return sign | u;
+	}
+
+	return sign | ((a << 13) + 0x38000000);
+}
+
 half::half(const float x) {
 	union {
 		float floatI;
@@ -31,39 +97,7 @@ half::half(const float x) {
 	};
 	floatI = x;
 
-	//	unsigned int i = *((unsigned int *) &mX);
-	int e = ((i >> 23) & 0xFF) - 112;
-	int m = i & 0x007FFFFF;
-
-	sh = (i >> 16) & 0x8000;
-	if (e <= 0) {
-		// Denorm
-		m = ((m | 0x00800000) >> (1 - e)) + 0x1000;
-		sh |= (m >> 13);
-	}
-	else if (e == 143) {
-		sh |= 0x7C00;
-		if (m != 0) {
-			// NAN
-			m >>= 13;
-			sh |= m | (m == 0);
-		}
-	}
-	else {
-		m += 0x1000;
-		if (m & 0x00800000) {
-			// Mantissa overflow
-			m = 0;
-			e++;
-		}
-		if (e >= 31) {
-			// Exponent overflow
-			sh |= 0x7C00;
-		}
-		else {
-			sh |= (e << 10) | (m >> 13);
-		}
-	}
+	sh = floatBitsToHalf(i);
 }
 
 half::operator float() const {
@@ -72,29 +106,149 @@ half::operator float() const {
 		float result;
 	};
 
-	s = (sh & 0x8000) << 16;
-	unsigned int e = (sh >> 10) & 0x1F;
-	unsigned int m = sh & 0x03FF;
-
-	if (e == 0) {
-		// +/- 0
-		if (m == 0) return result;
-
-		// Denorm
-		while ((m & 0x0400) == 0) {
-			m += m;
-			e--;
-		}
-		e++;
-		m &= ~0x0400;
+	s = halfBitsToFloat(sh);
+
+	return result;
+}
+
+#if HALF_SSE2
+static inline __m128i select(const __m128i mask, const __m128i a, const __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// SSE2 version of floatBitsToHalf, the results are in the low 16 bits of each lane
+static inline __m128i floatToHalf4(const __m128 x) {
+	const __m128i i = _mm_castps_si128(x);
+	const __m128i a = _mm_and_si128(i, _mm_set1_epi32(0x7FFFFFFF));
+	const __m128i sign = _mm_srli_epi32(_mm_and_si128(i, _mm_set1_epi32(0x80000000)), 16);
+
+	const __m128i odd = _mm_and_si128(_mm_srli_epi32(a, 13), _mm_set1_epi32(1));
+	const __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(a, _mm_set1_epi32(0xC8000FFF)), odd), 13);
+	const __m128i denorm = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(a), _mm_set1_ps(0.5f))), _mm_set1_epi32(0x3F000000));
+	const __m128i nan = _mm_or_si128(_mm_set1_epi32(0x7E00), _mm_and_si128(_mm_srli_epi32(a, 13), _mm_set1_epi32(0x03FF)));
+	const __m128i special = select(_mm_cmpgt_epi32(a, _mm_set1_epi32(0x7F800000)), nan, _mm_set1_epi32(0x7C00));
+
+	__m128i r = select(_mm_cmpgt_epi32(_mm_set1_epi32(0x38800000), a), denorm, normal);
+	r = select(_mm_cmpgt_epi32(a, _mm_set1_epi32(0x477FFFFF)), special, r);
+	return _mm_or_si128(r, sign);
+}
+
+// SSE2 version of halfBitsToFloat, the halves are in the low 16 bits of each lane
+static inline __m128 halfToFloat4(const __m128i h) {
+	const __m128i a = _mm_and_si128(h, _mm_set1_epi32(0x7FFF));
+	const __m128i sign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16);
+
+	const __m128i normal = _mm_add_epi32(_mm_slli_epi32(a, 13), _mm_set1_epi32(0x38000000));
+	const __m128i denorm = _mm_castps_si128(_mm_mul_ps(_mm_cvtepi32_ps(a), _mm_set1_ps(1.0f / 16777216.0f)));
+	const __m128i quiet = _mm_and_si128(_mm_cmpgt_epi32(a, _mm_set1_epi32(0x7C00)), _mm_set1_epi32(0x00400000));
+	const __m128i special = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(a, 13), _mm_set1_epi32(0x70000000)), quiet);
+
+	__m128i r = select(_mm_cmpgt_epi32(_mm_set1_epi32(0x0400), a), denorm, normal);
+	r = select(_mm_cmpgt_epi32(a, _mm_set1_epi32(0x7BFF)), special, r);
+	return _mm_castsi128_ps(_mm_or_si128(r, sign));
+}
+
+static void floatToHalfSSE2(const float* pSrc, half* pDst, size_t count) {
+	for (; count >= 8; count -= 8, pSrc += 8, pDst += 8) {
+		const __m128i lo = floatToHalf4(_mm_loadu_ps(pSrc));
+		const __m128i hi = floatToHalf4(_mm_loadu_ps(pSrc + 4));
+		// Sign extend so the signed saturating pack keeps all 16 bits
+		const __m128i packed = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(lo, 16), 16), _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16));
+		_mm_storeu_si128((__m128i*)pDst, packed);
 	}
-	else if (e == 31) {
-		// INF / NAN
-		s |= 0x7F800000 | (m << 13);
-		return result;
+	for (; count; --count)
+		*pDst++ = *pSrc++;
+}
+
+static void halfToFloatSSE2(const half* pSrc, float* pDst, size_t count) {
+	for (; count >= 8; count -= 8, pSrc += 8, pDst += 8) {
+		const __m128i h = _mm_loadu_si128((const __m128i*)pSrc);
+		_mm_storeu_ps(pDst, halfToFloat4(_mm_unpacklo_epi16(h, _mm_setzero_si128())));
+		_mm_storeu_ps(pDst + 4, halfToFloat4(_mm_unpackhi_epi16(h, _mm_setzero_si128())));
 	}
+	for (; count; --count)
+		*pDst++ = *pSrc++;
+}
 
-	s |= ((e + 112) << 23) | (m << 13);
+HALF_TARGET_F16C static void floatToHalfF16C(const float* pSrc, half* pDst, size_t count) {
+	for (; count >= 8; count -= 8, pSrc += 8, pDst += 8)
+		_mm_storeu_si128((__m128i*)pDst, _mm256_cvtps_ph(_mm256_loadu_ps(pSrc), _MM_FROUND_TO_NEAREST_INT));
+	for (; count; --count)
+		*pDst++ = *pSrc++;
+}
 
-	return result;
-}
\ No newline at end of file
+HALF_TARGET_F16C static void halfToFloatF16C(const half* pSrc, float* pDst, size_t count) {
+	for (; count >= 8; count -= 8, pSrc += 8, pDst += 8)
+		_mm256_storeu_ps(pDst, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)pSrc)));
+	for (; count; --count)
+		*pDst++ = *pSrc++;
+}
+
+// F16C instructions are VEX encoded, so the OS has to save the AVX state as well
+static bool hasF16C() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	const unsigned ecx = (unsigned)info[2];
+#else
+	unsigned eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return false;
+#endif
+	const unsigned required = (1u << 27) | (1u << 28) | (1u << 29);	// OSXSAVE, AVX, F16C
+	if ((ecx & required) != required)
+		return false;
+#if defined(_MSC_VER)
+	return (_xgetbv(0) & 6) == 6;
+#else
+	unsigned xcr0, xcr0High;
+	__asm__ volatile("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+	return (xcr0 & 6) == 6;
+#endif
+}
+
+static const HalfConversionPath gHalfSupportedPath = hasF16C() ? HALF_CONVERSION_F16C : HALF_CONVERSION_SSE2;
+#else
+static const HalfConversionPath gHalfSupportedPath = HALF_CONVERSION_SCALAR;
+#endif
+
+static HalfConversionPath gHalfPath = gHalfSupportedPath;
+
+HalfConversionPath setHalfConversionPath(HalfConversionPath path) {
+	gHalfPath = path < gHalfSupportedPath ? path : gHalfSupportedPath;
+	return gHalfPath;
+}
+
+HalfConversionPath getHalfConversionPath() {
+	return gHalfPath;
+}
+
+void floatToHalf(const float* pSrc, half* pDst, size_t count) {
+#if HALF_SSE2
+	if (gHalfPath == HALF_CONVERSION_F16C) {
+		floatToHalfF16C(pSrc, pDst, count);
+		return;
+	}
+	if (gHalfPath == HALF_CONVERSION_SSE2) {
+		floatToHalfSSE2(pSrc, pDst, count);
+		return;
+	}
+#endif
+	for (; count; --count)
+		*pDst++ = *pSrc++;
+}
+
+void halfToFloat(const half* pSrc, float* pDst, size_t count) {
+#if HALF_SSE2
+	if (gHalfPath == HALF_CONVERSION_F16C) {
+		halfToFloatF16C(pSrc, pDst, count);
+		return;
+	}
+	if (gHalfPath == HALF_CONVERSION_SSE2) {
+		halfToFloatSSE2(pSrc, pDst, count);
+		return;
+	}
+#endif
+	for (; count; --count)
+		*pDst++ = *pSrc++;
+}
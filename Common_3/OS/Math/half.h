@@ -24,6 +24,8 @@
 #ifndef _CFX_HALF_
 #define _CFX_HALF_
 
+#include <stddef.h>
+
 struct half {
 	unsigned short sh;
 
@@ -32,4 +34,22 @@ struct half {
 	operator float() const;
 };
 
+// Bulk conversions for vertex streams and images. They give the same bits as the per value conversions above
+// (round to nearest even, denormals kept, NaN payloads kept and quieted), which match F16C and GPU conversions.
+// F16C is used when the CPU supports it, SSE2 otherwise on x64.
+void floatToHalf(const float* pSrc, half* pDst, size_t count);
+void halfToFloat(const half* pSrc, float* pDst, size_t count);
+
+// Instruction sets of the bulk conversions. The best one the CPU supports is used by default.
+enum HalfConversionPath {
+	HALF_CONVERSION_SCALAR,
+	HALF_CONVERSION_SSE2,
+	HALF_CONVERSION_F16C,
+};
+
+// Forces a lower path, to compare the paths against each other. Returns the path that is used from now on,
+// requests above what the CPU supports are clamped. Not thread safe, call it while no conversion is running.
+HalfConversionPath setHalfConversionPath(HalfConversionPath path);
+HalfConversionPath getHalfConversionPath();
+
 #endif
\ No newline at end of file
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "DistanceField.h"
+#include "../Interfaces/IThread.h"
+#include "../../ThirdParty/OpenSource/TinySTL/vector.h"
+#include <math.h>
+#include "../Interfaces/ILogManager.h"
+#include "../Interfaces/IMemoryManager.h"
+
+// Quadratic segments are split until the chord deviates less than this from the curve
+#define DISTANCE_FIELD_FLATTEN_TOLERANCE (1.0f / 16.0f)
+#define DISTANCE_FIELD_MAX_SUBDIVISIONS 64
+
+typedef struct DistanceFieldLine
+{
+	float mX0, mY0;
+	float mX1, mY1;
+	float mMinX, mMinY;
+	float mMaxX, mMaxY;
+} DistanceFieldLine;
+
+typedef struct DistanceFieldCrossing
+{
+	float	mX;
+	int		mWinding;
+} DistanceFieldCrossing;
+
+typedef struct DistanceFieldScratch
+{
+	tinystl::vector<DistanceFieldLine>		mLines;
+	tinystl::vector<uint32_t>				mRowLines;
+	tinystl::vector<DistanceFieldCrossing>	mCrossings;
+} DistanceFieldScratch;
+
+typedef struct DistanceFieldTask
+{
+	const DistanceFieldDesc*	pDescs;
+	uint32_t					mBegin;
+	uint32_t					mEnd;
+} DistanceFieldTask;
+
+static void AddLine(tinystl::vector<DistanceFieldLine>& lines, float x0, float y0, float x1, float y1)
+{
+	if (x0 == x1 && y0 == y1)
+		return;
+
+	DistanceFieldLine line;
+	line.mX0 = x0;
+	line.mY0 = y0;
+	line.mX1 = x1;
+	line.mY1 = y1;
+	line.mMinX = min(x0, x1);
+	line.mMinY = min(y0, y1);
+	line.mMaxX = max(x0, x1);
+	line.mMaxY = max(y0, y1);
+	lines.push_back(line);
+}
+
+static void FlattenOutline(const DistanceFieldDesc* pDesc, tinystl::vector<DistanceFieldLine>& lines)
+{
+	lines.clear();
+	for (uint32_t i = 0; i < pDesc->mSegmentCount; ++i)
+	{
+		const DistanceFieldSegment& seg = pDesc->pSegments[i];
+		if (!seg.mQuadratic)
+		{
+			AddLine(lines, seg.mX0, seg.mY0, seg.mX1, seg.mY1);
+			continue;
+		}
+
+		// The chord of a quadratic piece deviates at most |P0 - 2C + P1| / (8 n^2) from the curve for n uniform pieces
+		const float ddx = seg.mX0 - 2.0f * seg.mCX + seg.mX1;
+		const float ddy = seg.mY0 - 2.0f * seg.mCY + seg.mY1;
+		const float deviation = sqrtf(ddx * ddx + ddy * ddy);
+		uint32_t pieces = (uint32_t)ceilf(sqrtf(deviation / (8.0f * DISTANCE_FIELD_FLATTEN_TOLERANCE)));
+		pieces = min(max(pieces, 1U), (uint32_t)DISTANCE_FIELD_MAX_SUBDIVISIONS);
+
+		float px = seg.mX0;
+		float py = seg.mY0;
+		for (uint32_t p = 1; p <= pieces; ++p)
+		{
+			const float t = (float)p / (float)pieces;
+			const float it = 1.0f - t;
+			const float x = it * it * seg.mX0 + 2.0f * it * t * seg.mCX + t * t * seg.mX1;
+			const float y = it * it * seg.mY0 + 2.0f * it * t * seg.mCY + t * t * seg.mY1;
+			AddLine(lines, px, py, x, y);
+			px = x;
+			py = y;
+		}
+	}
+}
+
+static inline float DistanceSqToLine(const DistanceFieldLine& line, float x, float y)
+{
+	const float dx = line.mX1 - line.mX0;
+	const float dy = line.mY1 - line.mY0;
+	float t = ((x - line.mX0) * dx + (y - line.mY0) * dy) / (dx * dx + dy * dy);
+	t = min(max(t, 0.0f), 1.0f);
+	const float ex = line.mX0 + t * dx - x;
+	const float ey = line.mY0 + t * dy - y;
+	return ex * ex + ey * ey;
+}
+
+static void GenerateDistanceFieldWithScratch(const DistanceFieldDesc* pDesc, DistanceFieldScratch* pScratch)
+{
+	ASSERT(pDesc->pDst && pDesc->mSpread > 0.0f);
+
+	tinystl::vector<DistanceFieldLine>& lines = pScratch->mLines;
+	tinystl::vector<uint32_t>& rowLines = pScratch->mRowLines;
+	tinystl::vector<DistanceFieldCrossing>& crossings = pScratch->mCrossings;
+	FlattenOutline(pDesc, lines);
+
+	const float spread = pDesc->mSpread;
+	const float spreadSq = spread * spread;
+	const float scale = DISTANCE_FIELD_EDGE_VALUE / spread;
+
+	for (uint32_t y = 0; y < pDesc->mHeight; ++y)
+	{
+		const float py = (float)y + 0.5f;
+		unsigned char* pRow = pDesc->pDst + y * pDesc->mStride;
+
+		// Lines closer than the spread to this row, and where the row crosses the outline
+		rowLines.clear();
+		crossings.clear();
+		for (uint32_t i = 0; i < lines.size(); ++i)
+		{
+			const DistanceFieldLine& line = lines[i];
+			if (line.mMinY - spread <= py && py <= line.mMaxY + spread)
+				rowLines.push_back(i);
+
+			// Half open in y so a vertex shared by two lines is counted once
+			if ((line.mY0 <= py && py < line.mY1) || (line.mY1 <= py && py < line.mY0))
+			{
+				DistanceFieldCrossing crossing;
+				crossing.mX = line.mX0 + (py - line.mY0) * (line.mX1 - line.mX0) / (line.mY1 - line.mY0);
+				crossing.mWinding = line.mY1 > line.mY0 ? 1 : -1;
+				crossings.push_back(crossing);
+			}
+		}
+
+		// Crossings are few per row, insertion sort them by x
+		for (uint32_t i = 1; i < crossings.size(); ++i)
+		{
+			const DistanceFieldCrossing crossing = crossings[i];
+			uint32_t j = i;
+			for (; j > 0 && crossings[j - 1].mX > crossing.mX; --j)
+				crossings[j] = crossings[j - 1];
+			crossings[j] = crossing;
+		}
+
+		int winding = 0;
+		uint32_t nextCrossing = 0;
+		for (uint32_t x = 0; x < pDesc->mWidth; ++x)
+		{
+			const float px = (float)x + 0.5f;
+			while (nextCrossing < crossings.size() && crossings[nextCrossing].mX <= px)
+				winding += crossings[nextCrossing++].mWinding;
+
+			float distanceSq = spreadSq;
+			for (uint32_t i = 0; i < rowLines.size(); ++i)
+			{
+				const DistanceFieldLine& line = lines[rowLines[i]];
+				if (px < line.mMinX - spread || px > line.mMaxX + spread)
+					continue;
+				distanceSq = min(distanceSq, DistanceSqToLine(line, px, py));
+			}
+
+			const float distance = sqrtf(distanceSq);
+			const float value = DISTANCE_FIELD_EDGE_VALUE + (winding != 0 ? distance : -distance) * scale;
+			pRow[x] = (unsigned char)min(max(value + 0.5f, 0.0f), 255.0f);
+		}
+	}
+}
+
+void GenerateDistanceField(const DistanceFieldDesc* pDesc)
+{
+	DistanceFieldScratch scratch;
+	GenerateDistanceFieldWithScratch(pDesc, &scratch);
+}
+
+static void DistanceFieldTaskFunc(void* pData)
+{
+	const DistanceFieldTask* pTask = (const DistanceFieldTask*)pData;
+	DistanceFieldScratch scratch;
+	for (uint32_t i = pTask->mBegin; i < pTask->mEnd; ++i)
+		GenerateDistanceFieldWithScratch(&pTask->pDescs[i], &scratch);
+}
+
+void GenerateDistanceFieldsParallel(const DistanceFieldDesc* pDescs, uint32_t count, ThreadPool* pThreadPool, uint32_t taskCount)
+{
+	taskCount = min(taskCount, count);
+	if (!pThreadPool || taskCount < 2)
+	{
+		DistanceFieldTask task = { pDescs, 0, count };
+		DistanceFieldTaskFunc(&task);
+		return;
+	}
+
+	tinystl::vector<DistanceFieldTask> tasks(taskCount);
+	tinystl::vector<WorkItem> workItems(taskCount);
+	for (uint32_t i = 0; i < taskCount; ++i)
+	{
+		tasks[i].pDescs = pDescs;
+		tasks[i].mBegin = (uint32_t)((uint64_t)count * i / taskCount);
+		tasks[i].mEnd = (uint32_t)((uint64_t)count * (i + 1) / taskCount);
+		workItems[i].pFunc = DistanceFieldTaskFunc;
+		workItems[i].pData = &tasks[i];
+		pThreadPool->AddWorkItem(&workItems[i]);
+	}
+
+	// The calling thread takes part in the work and returns once every field is done
+	pThreadPool->Complete(0);
+}
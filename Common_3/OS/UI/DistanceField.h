@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../Interfaces/IOperatingSystem.h"
+
+class ThreadPool;
+
+/// Encoded value of the glyph outline. Texels above it are inside the glyph.
+#define DISTANCE_FIELD_EDGE_VALUE 127.5f
+
+/// One piece of a closed outline in the pixel space of the destination field (y down, texel centers at +0.5).
+/// Quadratic segments go from (mX0, mY0) to (mX1, mY1) through the control point (mCX, mCY); lines ignore the control point.
+typedef struct DistanceFieldSegment
+{
+	float		mX0, mY0;
+	float		mCX, mCY;
+	float		mX1, mY1;
+	bool		mQuadratic;
+} DistanceFieldSegment;
+
+typedef struct DistanceFieldDesc
+{
+	/// Outline segments. Contours must be closed; inside is decided by the non-zero winding rule like TrueType does.
+	const DistanceFieldSegment*	pSegments;
+	uint32_t					mSegmentCount;
+	/// Destination texels, one byte each.
+	unsigned char*				pDst;
+	uint32_t					mWidth;
+	uint32_t					mHeight;
+	uint32_t					mStride;
+	/// Distance in texels which maps to the full 0..255 range around DISTANCE_FIELD_EDGE_VALUE. Farther texels saturate.
+	float						mSpread;
+} DistanceFieldDesc;
+
+/// Writes the signed distance from every texel center to the outline: DISTANCE_FIELD_EDGE_VALUE on the outline,
+/// growing inside and shrinking outside. Quadratic segments are flattened to lines within 1/16 texel.
+/// Sampled with bilinear filtering and thresholded at 0.5, the field reproduces the outline at any scale.
+void GenerateDistanceField(const DistanceFieldDesc* pDesc);
+
+/// Generates count independent fields as taskCount tasks on pThreadPool. The destinations must not overlap.
+/// The calling thread joins the work through ThreadPool::Complete(0), so the pool should have no unrelated work pending.
+/// Falls back to GenerateDistanceField in a loop without a pool or with a single task.
+void GenerateDistanceFieldsParallel(const DistanceFieldDesc* pDescs, uint32_t count, ThreadPool* pThreadPool, uint32_t taskCount);
@@ -27,16 +27,48 @@
 #include "../Interfaces/IFileSystem.h"
 
 #include "UIRenderer.h"
+#include "DistanceField.h"
+#include "../Interfaces/IThread.h"
 #include "../../Renderer/IRenderer.h"
 #include "../Image/Image.h"
 
 #include "../../ThirdParty/OpenSource/TinySTL/vector.h"
+#include "../../ThirdParty/OpenSource/TinySTL/unordered_map.h"
+
+#ifndef FONTSTASH_MAX_ATLAS_SIZE
+#define FONTSTASH_MAX_ATLAS_SIZE 4096
+#endif
+
+// stb_truetype takes a scanline as wide as the glyph and the flattened outline from this buffer and crashes when it runs
+// out, the default of 16000 bytes only covers glyphs up to roughly 800 pixels. Leave room for the widest glyph the atlas holds.
+#ifndef FONS_SCRATCH_BUF_SIZE
+#define FONS_SCRATCH_BUF_SIZE (FONTSTASH_MAX_ATLAS_SIZE * 8 + 64 * 1024)
+#endif
+
 // include Fontstash (should be after MemoryTracking so that it also detects memory free/remove in fontstash)
 #define FONTSTASH_IMPLEMENTATION
 #include "../../ThirdParty/OpenSource/Fontstash/src/fontstash.h"
 
 #include "../Interfaces/IMemoryManager.h"
 
+// Distance field glyphs are generated once at this pixel height and scaled to every text size
+#ifndef FONTSTASH_SDF_BASE_SIZE
+#define FONTSTASH_SDF_BASE_SIZE 32.0f
+#endif
+// Distance in texels at the base size covered by the field on each side of the outline; also the glyph padding
+#define FONTSTASH_SDF_SPREAD 4
+
+// One atlas entry per glyph in distance field mode
+struct DistanceFieldGlyph
+{
+	int		mGlyphIndex;
+	// Atlas rectangle including the spread padding, empty for glyphs without outline
+	short	mAtlasX0, mAtlasY0, mAtlasX1, mAtlasY1;
+	// Same rectangle relative to the pen position on the baseline, in pixels at FONTSTASH_SDF_BASE_SIZE
+	float	mX0, mY0, mX1, mY1;
+	float	mAdvance;
+};
+
 class _Impl_FontStash
 {
 public:
@@ -47,6 +79,11 @@ public:
 		height = 0; 
 		renderer = NULL;
 		fontStashContext = NULL;
+		textureUpdates = 0;
+		atlasFullReported = false;
+		distanceField = false;
+		pThreadPool = NULL;
+		resetDirtyRect();
 	}
 
 	~_Impl_FontStash() 
@@ -61,21 +98,19 @@ public:
 			conf_free(fontBuffers[i]);
 	}
 
-	void init(UIRenderer* _renderer, int width_, int height_)
+	void init(UIRenderer* _renderer, int width_, int height_, bool distanceField_)
 	{
 		// set renderer
 		renderer = _renderer;
+		distanceField = distanceField_;
 
-		// create image
-		img.Create(ImageFormat::R8, width_, height_, 1, 1, 1);
-		
 		// init state objects
 		//if ((textSamplerState = renderer->addSamplerState(NEAREST, CLAMP, CLAMP, CLAMP)) == SS_NONE) return;
 		//if ((textBlendState = renderer->addBlendState(SRC_ALPHA, ONE_MINUS_SRC_ALPHA, SRC_ALPHA, ONE_MINUS_SRC_ALPHA)) == BS_NONE) return;
 		//if ((textDepthTest = renderer->addDepthState(false, false)) == DS_NONE) return;
 		//if ((textRasterizerState = renderer->addRasterizerState(CULL_NONE, 0, 0.0f, SOLID, false, true)) == RS_NONE) return;
 
-		// create FONS context
+		// create FONS context (this also creates the image through fonsImplementationGenerateTexture)
 		FONSparams params;
 		memset(&params, 0, sizeof(params));
 		params.width = width_;
@@ -89,6 +124,312 @@ public:
 		params.userPtr = this;
 
 		fontStashContext = fonsCreateInternal(&params);
+		fonsSetErrorCallback(fontStashContext, fonsImplementationHandleError, this);
+	}
+
+	void resetDirtyRect()
+	{
+		dirtyRect[0] = width;
+		dirtyRect[1] = height;
+		dirtyRect[2] = 0;
+		dirtyRect[3] = 0;
+	}
+
+	// Copies the union of all regions modified since the last update from the fontstash into the image and rebuilds the texture once.
+	void updateTexture()
+	{
+		// Push glyphs which were rasterized without being drawn (prewarm) into the dirty rect
+		int dirty[4];
+		if (fonsValidateTexture(fontStashContext, dirty))
+			fonsImplementationModifyTexture(this, dirty, NULL);
+
+		if (dirtyRect[0] >= dirtyRect[2] || dirtyRect[1] >= dirtyRect[3])
+			return;
+
+		int atlasWidth, atlasHeight;
+		const unsigned char* data = fonsGetTextureData(fontStashContext, &atlasWidth, &atlasHeight);
+		ASSERT(atlasWidth == width && atlasHeight == height);
+		img.loadFromMemoryXY(data + dirtyRect[0] + dirtyRect[1] * width, dirtyRect[0], dirtyRect[1], dirtyRect[2], dirtyRect[3], width);
+		resetDirtyRect();
+
+		// TODO: Update the GPU texture instead of changing the CPU texture and rebuilding it on GPU.
+		Texture* oldTex = tex;
+
+		// R8 mode
+		//addTexture2d(renderer, width, height, SampleCount::SAMPLE_COUNT_1, img.getFormat(), img.GetMipMapCount(), NULL, false, TextureUsage::TEXTURE_USAGE_SAMPLED_IMAGE, &tex);
+		tex = renderer->addTexture(&img, 0);
+		++textureUpdates;
+
+		// NOTE: deleting the texture afterwards seems to fix a driver bug on Intel where it would reuse the old contents of img, causing the texture not to update.
+		if (oldTex)
+		{
+			renderer->removeTexture(oldTex);
+			//removeTexture(renderer, oldTex);
+		}
+	}
+
+	uint32_t prewarmCodepoint(FONSfont* font, unsigned int codepoint, const short* isizes, uint32_t sizeCount, short iblur)
+	{
+		uint32_t failed = 0;
+		for (uint32_t i = 0; i < sizeCount; ++i)
+		{
+			// The atlas grows one step per failed allocation, large glyphs may need several
+			int atlasWidth = width, atlasHeight = height;
+			while (fons__getGlyph(fontStashContext, font, codepoint, isizes[i], iblur) == NULL)
+			{
+				if (atlasWidth == width && atlasHeight == height)
+				{
+					++failed;
+					break;
+				}
+				atlasWidth = width;
+				atlasHeight = height;
+			}
+		}
+		return failed;
+	}
+
+	// Packs a rectangle into the atlas, growing it as far as FONTSTASH_MAX_ATLAS_SIZE allows.
+	bool addAtlasRect(int rectWidth, int rectHeight, int* pX, int* pY)
+	{
+		while (fons__atlasAddRect(fontStashContext->atlas, rectWidth, rectHeight, pX, pY) == 0)
+		{
+			const int atlasWidth = width, atlasHeight = height;
+			fonsImplementationHandleError(this, FONS_ATLAS_FULL, 0);
+			if (atlasWidth == width && atlasHeight == height)
+				return false;
+		}
+		return true;
+	}
+
+	// Converts the TrueType outline of a glyph to distance field segments relative to (originX, originY) in scaled pixels.
+	void appendGlyphOutline(FONSfont* font, int glyphIndex, float scale, float originX, float originY, tinystl::vector<DistanceFieldSegment>& segments)
+	{
+		// stb_truetype allocates the shape from the fontstash scratch buffer
+		fontStashContext->nscratch = 0;
+		stbtt_vertex* pVertices = NULL;
+		const int vertexCount = stbtt_GetGlyphShape(&font->font.font, glyphIndex, &pVertices);
+
+		DistanceFieldSegment segment = {};
+		float startX = 0.0f, startY = 0.0f, x = 0.0f, y = 0.0f;
+		for (int i = 0; i < vertexCount; ++i)
+		{
+			const stbtt_vertex& v = pVertices[i];
+			const float vx = v.x * scale - originX;
+			const float vy = -v.y * scale - originY;
+			if (v.type == STBTT_vmove)
+			{
+				// Close the previous contour in case the font left it open
+				if (i > 0 && (x != startX || y != startY))
+				{
+					segment = { x, y, 0.0f, 0.0f, startX, startY, false };
+					segments.push_back(segment);
+				}
+				startX = vx;
+				startY = vy;
+			}
+			else if (v.type == STBTT_vline)
+			{
+				segment = { x, y, 0.0f, 0.0f, vx, vy, false };
+				segments.push_back(segment);
+			}
+			else if (v.type == STBTT_vcurve)
+			{
+				segment = { x, y, v.cx * scale - originX, -v.cy * scale - originY, vx, vy, true };
+				segments.push_back(segment);
+			}
+			x = vx;
+			y = vy;
+		}
+		if (vertexCount > 0 && (x != startX || y != startY))
+		{
+			segment = { x, y, 0.0f, 0.0f, startX, startY, false };
+			segments.push_back(segment);
+		}
+
+		stbtt_FreeShape(&font->font.font, pVertices);
+	}
+
+	// Generates the distance fields of all codepoints which are not in the atlas yet. Returns the number of glyphs which did not fit.
+	uint32_t addDistanceFieldGlyphs(int fontID, const uint32_t* codepoints, uint32_t codepointCount)
+	{
+		FONSfont* font = fontStashContext->fonts[fontID];
+		const float scale = fons__tt_getPixelHeightScale(&font->font, FONTSTASH_SDF_BASE_SIZE);
+		const int pad = FONTSTASH_SDF_SPREAD;
+
+		uint32_t failed = 0;
+		pendingGlyphs.clear();
+		pendingSegmentOffsets.clear();
+		pendingSegments.clear();
+		for (uint32_t i = 0; i < codepointCount; ++i)
+		{
+			const uint64_t key = ((uint64_t)fontID << 32) | codepoints[i];
+			if (sdfGlyphLookup.find(key).node)
+				continue;
+
+			int advance, lsb, x0, y0, x1, y1;
+			const int glyphIndex = fons__tt_getGlyphIndex(&font->font, codepoints[i]);
+			fons__tt_buildGlyphBitmap(&font->font, glyphIndex, FONTSTASH_SDF_BASE_SIZE, scale, &advance, &lsb, &x0, &y0, &x1, &y1);
+
+			DistanceFieldGlyph glyph = {};
+			glyph.mGlyphIndex = glyphIndex;
+			glyph.mAdvance = advance * scale;
+			if (x1 > x0 && y1 > y0)
+			{
+				const int glyphWidth = x1 - x0 + pad * 2;
+				const int glyphHeight = y1 - y0 + pad * 2;
+				int gx, gy;
+				// Not cached, a later draw tries again once the atlas has room.
+				// The extra texel keeps bilinear filtering from reaching into the neighbour at the left and top edge.
+				if (!addAtlasRect(glyphWidth + 1, glyphHeight + 1, &gx, &gy))
+				{
+					++failed;
+					continue;
+				}
+				++gx;
+				++gy;
+				glyph.mAtlasX0 = (short)gx;
+				glyph.mAtlasY0 = (short)gy;
+				glyph.mAtlasX1 = (short)(gx + glyphWidth);
+				glyph.mAtlasY1 = (short)(gy + glyphHeight);
+				glyph.mX0 = (float)(x0 - pad);
+				glyph.mY0 = (float)(y0 - pad);
+				glyph.mX1 = (float)(x1 + pad);
+				glyph.mY1 = (float)(y1 + pad);
+
+				pendingGlyphs.push_back((uint32_t)sdfGlyphs.size());
+				pendingSegmentOffsets.push_back((uint32_t)pendingSegments.size());
+				appendGlyphOutline(font, glyphIndex, scale, glyph.mX0, glyph.mY0, pendingSegments);
+			}
+			sdfGlyphLookup.insert({ key, (uint32_t)sdfGlyphs.size() });
+			sdfGlyphs.push_back(glyph);
+		}
+
+		if (pendingGlyphs.empty())
+			return failed;
+
+		// Growing the atlas moves the texture data, so the destinations are resolved after all glyphs are placed
+		pendingSegmentOffsets.push_back((uint32_t)pendingSegments.size());
+		tinystl::vector<DistanceFieldDesc> descs(pendingGlyphs.size());
+		for (uint32_t i = 0; i < pendingGlyphs.size(); ++i)
+		{
+			const DistanceFieldGlyph& glyph = sdfGlyphs[pendingGlyphs[i]];
+			descs[i].pSegments = pendingSegments.data() + pendingSegmentOffsets[i];
+			descs[i].mSegmentCount = pendingSegmentOffsets[i + 1] - pendingSegmentOffsets[i];
+			descs[i].pDst = fontStashContext->texData + glyph.mAtlasX0 + glyph.mAtlasY0 * width;
+			descs[i].mWidth = glyph.mAtlasX1 - glyph.mAtlasX0;
+			descs[i].mHeight = glyph.mAtlasY1 - glyph.mAtlasY0;
+			descs[i].mStride = width;
+			descs[i].mSpread = (float)FONTSTASH_SDF_SPREAD;
+		}
+
+		const uint32_t taskCount = pThreadPool ? (pThreadPool->GetNumThreads() + 1) * 4 : 1;
+		GenerateDistanceFieldsParallel(descs.data(), (uint32_t)descs.size(), pThreadPool, taskCount);
+
+		for (uint32_t i = 0; i < pendingGlyphs.size(); ++i)
+		{
+			const DistanceFieldGlyph& glyph = sdfGlyphs[pendingGlyphs[i]];
+			int rect[4] = { glyph.mAtlasX0, glyph.mAtlasY0, glyph.mAtlasX1, glyph.mAtlasY1 };
+			fonsImplementationModifyTexture(this, rect, NULL);
+		}
+		return failed;
+	}
+
+	void decodeCodepoints(const char* message, const char* end)
+	{
+		unsigned int utf8state = 0;
+		unsigned int codepoint;
+		pendingCodepoints.clear();
+		for (const char* str = message; str != end; ++str)
+		{
+			if (fons__decutf8(&utf8state, &codepoint, *(const unsigned char*)str))
+			{
+				if (utf8state == FONS_UTF8_REJECT)
+					break;
+				continue;
+			}
+			pendingCodepoints.push_back(codepoint);
+		}
+	}
+
+	// Distance field counterpart of fonsDrawText/fonsTextBounds for left/top aligned text. Emits the quads when draw is set.
+	float distanceFieldText(const char* message, const char* end, float x, float y, int fontID, unsigned int color, float size, float spacing, float* pOutBounds, bool draw)
+	{
+		FONScontext* fs = fontStashContext;
+		if (fontID < 0 || fontID >= fs->nfonts || fs->fonts[fontID]->data == NULL)
+			return x;
+		FONSfont* font = fs->fonts[fontID];
+
+		// Make sure all glyphs are in the atlas before the first quad, a later atlas resize would invalidate the texture coordinates
+		decodeCodepoints(message, end);
+		addDistanceFieldGlyphs(fontID, pendingCodepoints.data(), (uint32_t)pendingCodepoints.size());
+
+		// FONS_ALIGN_LEFT | FONS_ALIGN_TOP like the bitmap path
+		y += font->ascender * size;
+
+		const float scale = size / FONTSTASH_SDF_BASE_SIZE;
+		const float kernScale = fons__tt_getPixelHeightScale(&font->font, size);
+		const float pad = (float)FONTSTASH_SDF_SPREAD;
+		float minx = x, maxx = x, miny = y, maxy = y;
+		const float startx = x;
+		int prevGlyphIndex = -1;
+		for (uint32_t i = 0; i < pendingCodepoints.size(); ++i)
+		{
+			tinystl::unordered_hash_node<uint64_t, uint32_t>* pNode = sdfGlyphLookup.find(((uint64_t)fontID << 32) | pendingCodepoints[i]).node;
+			if (!pNode)
+			{
+				prevGlyphIndex = -1;
+				continue;
+			}
+			const DistanceFieldGlyph& glyph = sdfGlyphs[pNode->second];
+
+			if (prevGlyphIndex != -1)
+				x += fons__tt_getGlyphKernAdvance(&font->font, prevGlyphIndex, glyph.mGlyphIndex) * kernScale + spacing;
+			prevGlyphIndex = glyph.mGlyphIndex;
+
+			if (glyph.mAtlasX1 > glyph.mAtlasX0)
+			{
+				// Positions are not snapped to pixels so animated sizes scale smoothly
+				const float x0 = x + glyph.mX0 * scale;
+				const float y0 = y + glyph.mY0 * scale;
+				const float x1 = x + glyph.mX1 * scale;
+				const float y1 = y + glyph.mY1 * scale;
+				minx = min(minx, x0 + pad * scale);
+				maxx = max(maxx, x1 - pad * scale);
+				miny = min(miny, y0 + pad * scale);
+				maxy = max(maxy, y1 - pad * scale);
+
+				if (draw)
+				{
+					const float s0 = glyph.mAtlasX0 * fs->itw;
+					const float t0 = glyph.mAtlasY0 * fs->ith;
+					const float s1 = glyph.mAtlasX1 * fs->itw;
+					const float t1 = glyph.mAtlasY1 * fs->ith;
+					if (fs->nverts + 6 > FONS_VERTEX_COUNT)
+						fons__flush(fs);
+
+					fons__vertex(fs, x0, y0, s0, t0, color);
+					fons__vertex(fs, x1, y1, s1, t1, color);
+					fons__vertex(fs, x1, y0, s1, t0, color);
+
+					fons__vertex(fs, x0, y0, s0, t0, color);
+					fons__vertex(fs, x0, y1, s0, t1, color);
+					fons__vertex(fs, x1, y1, s1, t1, color);
+				}
+			}
+			x += glyph.mAdvance * scale;
+		}
+		if (draw)
+			fons__flush(fs);
+
+		if (pOutBounds)
+		{
+			pOutBounds[0] = minx;
+			pOutBounds[1] = miny;
+			pOutBounds[2] = maxx;
+			pOutBounds[3] = maxy;
+		}
+		return x - startx;
 	}
 
 	static int fonsImplementationGenerateTexture(void* userPtr, int width, int height);
@@ -96,6 +437,7 @@ public:
 	static void fonsImplementationModifyTexture(void* userPtr, int* rect, const unsigned char* data);
 	static void fonsImplementationRenderText(void* userPtr, const float* verts, const float* tcoords, const unsigned int* colors, int nverts);
 	static void fonsImplementationRemoveTexture(void* userPtr);
+	static void fonsImplementationHandleError(void* userPtr, int error, int val);
 
 	FONScontext* fontStashContext;
 
@@ -105,14 +447,29 @@ public:
 	int width, height;
 	UIRenderer* renderer;
 
+	// Union of the atlas regions not yet copied to img / uploaded to tex
+	int dirtyRect[4];
+	uint32_t textureUpdates;
+	bool atlasFullReported;
+
+	// Distance field mode: glyphs are looked up by font ID << 32 | codepoint
+	bool distanceField;
+	ThreadPool* pThreadPool;
+	tinystl::vector<DistanceFieldGlyph> sdfGlyphs;
+	tinystl::unordered_map<uint64_t, uint32_t> sdfGlyphLookup;
+	tinystl::vector<uint32_t> pendingCodepoints;
+	tinystl::vector<uint32_t> pendingGlyphs;
+	tinystl::vector<uint32_t> pendingSegmentOffsets;
+	tinystl::vector<DistanceFieldSegment> pendingSegments;
+
 	tinystl::vector<void*> fontBuffers;
 };
 
 
-Fontstash::Fontstash(UIRenderer* renderer, int width, int height)
+Fontstash::Fontstash(UIRenderer* renderer, int width, int height, bool distanceField)
 {
 	impl = conf_placement_new<_Impl_FontStash>(conf_calloc(1, sizeof(_Impl_FontStash)));
-	impl->init(renderer, width, height);
+	impl->init(renderer, width, height, distanceField);
 }
 
 Fontstash::~Fontstash()
@@ -126,7 +483,8 @@ int Fontstash::defineFont(const char* identification, const char* filename)
 	FONScontext* fs=impl->fontStashContext;
 
 	File file = File();
-	file.Open(filename, FileMode::FM_ReadBinary, FSRoot::FSR_Textures);
+	if (!file.Open(filename, FileMode::FM_ReadBinary, FSRoot::FSR_Textures))
+		return FONS_INVALID;
 	unsigned bytes = file.GetSize();
 	void* buffer = conf_malloc(bytes);
 	file.Read(buffer, bytes);
@@ -142,7 +500,8 @@ int Fontstash::defineFont(const char* identification, const char* filename, FSRo
 	FONScontext* fs=impl->fontStashContext;
 
 	File file = {};
-	file.Open(filename, FileMode::FM_ReadBinary, root);
+	if (!file.Open(filename, FileMode::FM_ReadBinary, root))
+		return FONS_INVALID;
 	unsigned bytes = file.GetSize();
 	void* buffer = conf_malloc(bytes);
 	file.Read(buffer, bytes);
@@ -161,6 +520,12 @@ int Fontstash::getFontID(const char* identification)
 
 void Fontstash::drawText(const char* message, float x, float y, int fontID, unsigned int color/*=0xffffffff*/, float size/*=16.0f*/, float spacing/*=3.0f*/, float blur/*=0.0f*/)
 {
+	if (impl->distanceField)
+	{
+		impl->distanceFieldText(message, message + strlen(message), x, y, fontID, color, size, spacing, NULL, true);
+		return;
+	}
+
 	FONScontext* fs=impl->fontStashContext;
 	fonsSetSize(fs, size);
 	fonsSetFont(fs, fontID);
@@ -181,6 +546,9 @@ float Fontstash::measureText(float* out_bounds, const char* message, int message
 	if(out_bounds == nullptr)
 		return 0;
 
+	if (impl->distanceField)
+		return impl->distanceFieldText(message, message + messageLength, x, y, fontID, color, size, spacing, out_bounds, false);
+
 	FONScontext* fs=impl->fontStashContext;
 	fonsSetSize(fs, size);
 	fonsSetFont(fs, fontID);
@@ -192,6 +560,108 @@ float Fontstash::measureText(float* out_bounds, const char* message, int message
 
 }
 
+uint32_t Fontstash::prewarm(const char* message, int fontID, const float* sizes, uint32_t sizeCount, float blur/*=0.0f*/)
+{
+	return prewarm(message, (int)strlen(message), fontID, sizes, sizeCount, blur);
+}
+
+uint32_t Fontstash::prewarm(const char* message, int messageLength, int fontID, const float* sizes, uint32_t sizeCount, float blur/*=0.0f*/)
+{
+	FONScontext* fs=impl->fontStashContext;
+	if (fontID < 0 || fontID >= fs->nfonts || fs->fonts[fontID]->data == NULL)
+		return 0;
+
+	if (impl->distanceField)
+	{
+		impl->decodeCodepoints(message, message + messageLength);
+		return impl->addDistanceFieldGlyphs(fontID, impl->pendingCodepoints.data(), impl->pendingCodepoints.size());
+	}
+
+	// same size quantization as fonsDrawText
+	short isizes[16];
+	uint32_t failed = 0;
+	for (uint32_t s = 0; s < sizeCount; s += 16)
+	{
+		uint32_t count = (sizeCount - s < 16) ? sizeCount - s : 16;
+		for (uint32_t i = 0; i < count; ++i)
+			isizes[i] = (short)(sizes[s + i] * 10.0f);
+
+		unsigned int utf8state = 0;
+		unsigned int codepoint;
+		for (const char* str = message; str != message + messageLength; ++str)
+		{
+			if (fons__decutf8(&utf8state, &codepoint, *(const unsigned char*)str))
+				continue;
+			failed += impl->prewarmCodepoint(fs->fonts[fontID], codepoint, isizes, count, (short)blur);
+		}
+	}
+	return failed;
+}
+
+uint32_t Fontstash::prewarm(const uint32_t* codepoints, uint32_t codepointCount, int fontID, const float* sizes, uint32_t sizeCount, float blur/*=0.0f*/)
+{
+	FONScontext* fs=impl->fontStashContext;
+	if (fontID < 0 || fontID >= fs->nfonts || fs->fonts[fontID]->data == NULL)
+		return 0;
+
+	if (impl->distanceField)
+		return impl->addDistanceFieldGlyphs(fontID, codepoints, codepointCount);
+
+	short isizes[16];
+	uint32_t failed = 0;
+	for (uint32_t s = 0; s < sizeCount; s += 16)
+	{
+		uint32_t count = (sizeCount - s < 16) ? sizeCount - s : 16;
+		for (uint32_t i = 0; i < count; ++i)
+			isizes[i] = (short)(sizes[s + i] * 10.0f);
+
+		for (uint32_t i = 0; i < codepointCount; ++i)
+			failed += impl->prewarmCodepoint(fs->fonts[fontID], codepoints[i], isizes, count, (short)blur);
+	}
+	return failed;
+}
+
+void Fontstash::updateTexture()
+{
+	impl->updateTexture();
+}
+
+void Fontstash::setThreadPool(ThreadPool* pThreadPool)
+{
+	impl->pThreadPool = pThreadPool;
+}
+
+void Fontstash::getAtlasStats(FontstashAtlasStats* pOutStats)
+{
+	FONScontext* fs=impl->fontStashContext;
+	FontstashAtlasStats stats = {};
+	stats.mWidth = (uint32_t)fs->params.width;
+	stats.mHeight = (uint32_t)fs->params.height;
+	stats.mTextureUpdates = impl->textureUpdates;
+
+	for (int i = 0; i < fs->nfonts; ++i)
+	{
+		const FONSfont* font = fs->fonts[i];
+		stats.mGlyphCount += (uint32_t)font->nglyphs;
+		for (int g = 0; g < font->nglyphs; ++g)
+			stats.mGlyphPixels += (uint32_t)((font->glyphs[g].x1 - font->glyphs[g].x0) * (font->glyphs[g].y1 - font->glyphs[g].y0));
+	}
+
+	stats.mGlyphCount += (uint32_t)impl->sdfGlyphs.size();
+	for (uint32_t g = 0; g < impl->sdfGlyphs.size(); ++g)
+	{
+		const DistanceFieldGlyph& glyph = impl->sdfGlyphs[g];
+		stats.mGlyphPixels += (uint32_t)((glyph.mAtlasX1 - glyph.mAtlasX0) * (glyph.mAtlasY1 - glyph.mAtlasY0));
+	}
+
+	const FONSatlas* atlas = fs->atlas;
+	for (int i = 0; i < atlas->nnodes; ++i)
+		stats.mSkylinePixels += (uint32_t)(atlas->nodes[i].width * atlas->nodes[i].y);
+
+	stats.mOccupancy = (float)stats.mGlyphPixels / (float)(stats.mWidth * stats.mHeight);
+	*pOutStats = stats;
+}
+
 // --  FONS renderer implementation --
 int _Impl_FontStash::fonsImplementationGenerateTexture(void* userPtr, int width, int height)
 {
@@ -199,20 +669,14 @@ int _Impl_FontStash::fonsImplementationGenerateTexture(void* userPtr, int width,
 	ctx->width = width;
 	ctx->height = height;
 
-	Texture* oldTex = ctx->tex;
-
-
-	// R8 mode
-	//addTexture2d(ctx->renderer, width, height, SampleCount::SAMPLE_COUNT_1, ctx->img.getFormat(), ctx->img.GetMipMapCount(), NULL, false, TextureUsage::TEXTURE_USAGE_SAMPLED_IMAGE, &ctx->tex);
-	ctx->tex = ctx->renderer->addTexture(&ctx->img, 0);
-	
-	// Create may be called multiple times, delete existing texture.
-	// NOTE: deleting the texture afterwards seems to fix a driver bug on Intel where it would reuse the old contents of ctx->img, causing the texture not to update.
-	if (oldTex)
-	{
-		ctx->renderer->removeTexture(oldTex);
-		//removeTexture(ctx->renderer, oldTex);
-	}
+	// Create may be called multiple times (resize, reset). Fontstash marks the surviving glyphs dirty afterwards,
+	// so the image only has to match the new size; the texture is rebuilt by the next updateTexture.
+	ctx->img.Destroy();
+	ctx->img.Create(ImageFormat::R8, width, height, 1, 1, 1);
+	ctx->dirtyRect[0] = 0;
+	ctx->dirtyRect[1] = 0;
+	ctx->dirtyRect[2] = width;
+	ctx->dirtyRect[3] = height;
 
 	return 1;
 }
@@ -225,12 +689,15 @@ int _Impl_FontStash::fonsImplementationResizeTexture(void* userPtr, int width, i
 
 void _Impl_FontStash::fonsImplementationModifyTexture(void* userPtr, int* rect, const unsigned char* data)
 {
+	UNREF_PARAM(data);
 	_Impl_FontStash* ctx = (_Impl_FontStash*)userPtr;
 
-	// TODO: Update the GPU texture instead of changing the CPU texture and rebuilding it on GPU.
-	ctx->img.loadFromMemoryXY(data + rect[0] + rect[1]*ctx->width, rect[0], rect[1], rect[2], rect[3], ctx->width);
-
-	fonsImplementationGenerateTexture(userPtr, ctx->width, ctx->height);		// rebuild texture
+	// Only accumulate the region here. Fontstash flushes after every drawText, so copying and
+	// rebuilding the texture per call would rebuild it many times per frame.
+	ctx->dirtyRect[0] = fons__mini(ctx->dirtyRect[0], rect[0]);
+	ctx->dirtyRect[1] = fons__mini(ctx->dirtyRect[1], rect[1]);
+	ctx->dirtyRect[2] = fons__maxi(ctx->dirtyRect[2], rect[2]);
+	ctx->dirtyRect[3] = fons__maxi(ctx->dirtyRect[3], rect[3]);
 }
 
 void _Impl_FontStash::fonsImplementationRenderText(void* userPtr, const float* verts, const float* tcoords, const unsigned int* colors, int nverts)
@@ -239,6 +706,7 @@ void _Impl_FontStash::fonsImplementationRenderText(void* userPtr, const float* v
 	ASSERT(nverts <= (sizeof(vtx)/sizeof(vtx[0])));
 
 	_Impl_FontStash* ctx = (_Impl_FontStash*)userPtr;
+	ctx->updateTexture();
 	if (ctx->tex == NULL) return;
 
 	// build vertices
@@ -256,7 +724,10 @@ void _Impl_FontStash::fonsImplementationRenderText(void* userPtr, const float* v
 	for(int i=0; i<4; i++)
 		color[i] = ((float)colorByte[i])/255.0f;
 
-	ctx->renderer->drawTexturedR8AsAlpha(PrimitiveTopology::PRIMITIVE_TOPO_TRI_LIST, vtx, nverts, ctx->tex, &color);
+	if (ctx->distanceField)
+		ctx->renderer->drawTexturedR8AsDistanceField(PrimitiveTopology::PRIMITIVE_TOPO_TRI_LIST, vtx, nverts, ctx->tex, &color);
+	else
+		ctx->renderer->drawTexturedR8AsAlpha(PrimitiveTopology::PRIMITIVE_TOPO_TRI_LIST, vtx, nverts, ctx->tex, &color);
 }
 
 void _Impl_FontStash::fonsImplementationRemoveTexture(void* userPtr)
@@ -269,3 +740,29 @@ void _Impl_FontStash::fonsImplementationRemoveTexture(void* userPtr)
 		ctx->tex = NULL;
 	}
 }
+
+void _Impl_FontStash::fonsImplementationHandleError(void* userPtr, int error, int val)
+{
+	UNREF_PARAM(val);
+	_Impl_FontStash* ctx = (_Impl_FontStash*)userPtr;
+	if (error != FONS_ATLAS_FULL)
+		return;
+
+	// Grow the shorter side so the atlas stays close to square; fontstash retries the glyph afterwards.
+	int newWidth = ctx->width;
+	int newHeight = ctx->height;
+	if (newWidth <= newHeight)
+		newWidth *= 2;
+	else
+		newHeight *= 2;
+
+	if (newWidth > FONTSTASH_MAX_ATLAS_SIZE || newHeight > FONTSTASH_MAX_ATLAS_SIZE)
+	{
+		if (!ctx->atlasFullReported)
+			LOGWARNINGF("Fontstash atlas is full at %dx%d, glyphs which do not fit are dropped", ctx->width, ctx->height);
+		ctx->atlasFullReported = true;
+		return;
+	}
+
+	fonsExpandAtlas(ctx->fontStashContext, newWidth, newHeight);
+}
@@ -27,10 +27,31 @@
 #include "../Interfaces/IFileSystem.h"
 #include "../Math/MathTypes.h"
 
+//! Packing statistics of a fontstash glyph atlas.
+struct FontstashAtlasStats
+{
+	uint32_t	mWidth;
+	uint32_t	mHeight;
+	//! Number of glyphs (codepoint/size/blur combinations) resident in the atlas.
+	uint32_t	mGlyphCount;
+	//! Pixels covered by glyph rectangles, including their padding.
+	uint32_t	mGlyphPixels;
+	//! Pixels below the skyline of the packer. The difference to mGlyphPixels is space lost to packing.
+	uint32_t	mSkylinePixels;
+	//! Number of times the atlas texture was uploaded to the GPU.
+	uint32_t	mTextureUpdates;
+	//! mGlyphPixels / (mWidth * mHeight)
+	float		mOccupancy;
+};
+
+class ThreadPool;
+
 class Fontstash 
 {
 public:
-	Fontstash(class UIRenderer* renderer, int width, int height);
+	//! In distance field mode every glyph is stored once as a signed distance field and scaled to the requested text size,
+	//! instead of rasterizing a bitmap per size. Blur is ignored in this mode.
+	Fontstash(class UIRenderer* renderer, int width, int height, bool distanceField = false);
 	~Fontstash();
 
 	//! Makes a font available to the font stash.
@@ -49,6 +70,25 @@ public:
 	//! Measure text boundaries. Results will be written to out_bounds (x,y,x2,y2).
 	float measureText(float* out_bounds, const char* message, float x, float y, int fontID, unsigned int color=0xffffffff, float size=16.0f, float spacing=0.0f, float blur=0.0f);
 	float measureText(float* out_bounds, const char* message, int messageLength, float x, float y, int fontID, unsigned int color=0xffffffff, float size=16.0f, float spacing=0.0f, float blur=0.0f);
+
+	//! Rasterize the glyphs of a UTF-8 string (or a codepoint list) into the atlas at each of the given sizes without drawing anything.
+	//! - Use this at load time for known character sets (e.g. a localization table) to avoid rasterization hitches the first time a string is shown.
+	//! - The atlas grows on demand up to FONTSTASH_MAX_ATLAS_SIZE. Returns the number of glyphs that could not be placed.
+	//! - New glyphs are only staged on the CPU. They are uploaded by the next updateTexture() or the next draw, whichever comes first.
+	//! - In distance field mode the sizes are ignored, one entry per glyph serves them all.
+	uint32_t prewarm(const char* message, int fontID, const float* sizes, uint32_t sizeCount, float blur=0.0f);
+	uint32_t prewarm(const char* message, int messageLength, int fontID, const float* sizes, uint32_t sizeCount, float blur=0.0f);
+	uint32_t prewarm(const uint32_t* codepoints, uint32_t codepointCount, int fontID, const float* sizes, uint32_t sizeCount, float blur=0.0f);
+
+	//! Upload all glyphs rasterized since the last update to the GPU as a single texture update.
+	//! Call once per frame after prewarming the frame's text, before recording the first draw that uses the fontstash.
+	void updateTexture();
+
+	//! Distance fields of glyphs added together (prewarm, or one drawText) are generated on this pool. NULL generates them on the calling thread.
+	void setThreadPool(ThreadPool* pThreadPool);
+
+	//! Query how densely the atlas is packed.
+	void getAtlasStats(FontstashAtlasStats* pOutStats);
 protected:
 	class _Impl_FontStash* impl;
 };
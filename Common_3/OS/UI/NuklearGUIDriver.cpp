@@ -413,6 +413,17 @@ void NuklearGUIDriver::draw(nk_command_buffer* q/*=0*/, Texture* renderTarget/*
 	static const int CircleEdgeCount = 10;
 	
 	const struct nk_command *cmd;
+	/* rasterize the glyphs of all text commands first so new glyphs reach the font atlas in one texture update */
+	nk_foreach(cmd, &impl->context)
+	{
+		if (cmd->type != NK_COMMAND_TEXT)
+			continue;
+		const struct nk_command_text *r = (const struct nk_command_text*)cmd;
+		_Impl_NuklearGUIDriver::Font* font = (_Impl_NuklearGUIDriver::Font*)r->font->userdata.ptr;
+		impl->fontstash->prewarm(r->string, r->length, font->fontID, &r->font->height, 1);
+	}
+	impl->fontstash->updateTexture();
+
 	/* iterate over and execute each draw command except the text */
 	nk_foreach(cmd, &impl->context)
 	{
@@ -29,6 +29,8 @@
 #include "../Interfaces/IFileSystem.h"
 #include "../Interfaces/IOperatingSystem.h"
 
+#include <ctype.h>
+
 #define NK_INCLUDE_DEFAULT_ALLOCATOR
 #include "../../ThirdParty/OpenSource/NuklearUI/nuklear.h"
 #include "../Interfaces/IMemoryManager.h"
@@ -203,17 +205,15 @@ UIProperty::UIProperty(const char* description, bool& value) :
 {
 }
 
-// TODO: must fix this in order to work on all compilers due to the callback function UIButtonFn
-#ifdef _WIN32
+// Function pointers only convert to void* explicitly on GCC and Clang
 UIProperty::UIProperty(const char* description, UIButtonFn fn, void* userdata) :
 		description(description),
 		type(UI_PROPERTY_BUTTON),
 		flags(FLAG_VISIBLE),
-		source(fn)
+		source((void*)fn)
 {
 	settings.pUserData = userdata;
 }
-#endif
 
 UIProperty::UIProperty(const char* description, char* value, unsigned int length) :
 		description(description),
@@ -324,32 +324,77 @@ int UIProperty::enumComputeIndex() const
 UI::UI()
 {
 	onPropertyChanged = 0;
+	emptyPropertySlots = 0;
+	propertyIndexDirty = false;
+}
+
+// Case insensitive FNV-1a, only ASCII letters are folded like stricmp does in the C locale
+static uint32_t hashPropertyName(const char* name, size_t length)
+{
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < length; ++i)
+	{
+		hash ^= (uint32_t)tolower((unsigned char)name[i]);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// Compares a name that is not null terminated against a null terminated description
+static bool propertyNameEquals(const char* name, size_t length, const char* description)
+{
+	for (size_t i = 0; i < length; ++i)
+	{
+		if (description[i] == '\0' || tolower((unsigned char)name[i]) != tolower((unsigned char)description[i]))
+			return false;
+	}
+	return description[length] == '\0';
+}
+
+static bool isPropertySpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
 }
 
 void UI::clearProperties()
 {
 	properties.clear();
+	propertyHashes.clear();
+	emptyPropertySlots = 0;
+	propertyIndexDirty = true;
 }
 
 void UI::removeProperty(unsigned int idx)
 {
 	UIProperty& prop = properties[idx];
+	if (prop.source != NULL)
+		++emptyPropertySlots;
 	prop.source = NULL;
+	propertyIndexDirty = true;
 }
 
 unsigned int UI::addProperty(const UIProperty& prop)
 {
+	const uint32_t hash = hashPropertyName(prop.description, strlen(prop.description));
+	propertyIndexDirty = true;
+
 	// Try first to fill empty property slot
-	for (unsigned int i = 0; i < properties.getCount(); i++)
+	for (unsigned int i = 0; emptyPropertySlots && i < properties.getCount(); i++)
 	{
 		UIProperty& prop_slot = properties[i];
 		if (prop_slot.source != NULL)
 			continue;
 
 		prop_slot = prop;
+		propertyHashes[i] = hash;
+		if (prop.source != NULL)
+			--emptyPropertySlots;
 		return i;
 	}
 
+	propertyHashes.push_back(hash);
+	if (prop.source == NULL)
+		++emptyPropertySlots;
 	return properties.add(prop);
 }
 
@@ -369,107 +414,191 @@ void UI::changedProperty(unsigned int idx)
 		onPropertyChanged(idx);
 }
 
-bool UI::loadProperties(const char* filename)
+void UI::buildPropertyIndex()
 {
-	File file = {};file.Open(filename, FileMode::FM_ReadBinary, FSRoot::FSR_OtherFiles);
-	if (!file.IsOpen())
+	// Keep the table at most half full so probe sequences stay short
+	uint32_t bucketCount = 16;
+	while (bucketCount < properties.getCount() * 2)
+		bucketCount *= 2;
+
+	propertyIndex.clear();
+	propertyIndex.resize(bucketCount, 0);
+
+	// Properties are inserted in order so the first of several properties with the same description is found first,
+	// like the linear search this replaces did
+	const uint32_t mask = bucketCount - 1;
+	for (uint32_t i = 0; i < properties.getCount(); ++i)
 	{
-		return false;
+		if (properties[i].source == NULL)
+			continue;
+
+		uint32_t bucket = propertyHashes[i] & mask;
+		while (propertyIndex[bucket] != 0)
+			bucket = (bucket + 1) & mask;
+		propertyIndex[bucket] = i + 1;
 	}
 
-	unsigned totalBytes = file.GetSize();
-	char* buffer = (char*)conf_malloc(totalBytes);
-	file.Read(buffer, totalBytes);
-	file.Close();
+	propertyIndexDirty = false;
+}
 
-	char ident[1024];
-	char setTo[1024];
-	char* start = buffer;
-	char* current = start;
-	while (true)
+static int findPropertyInIndex(const tinystl::vector<uint32_t>& index, const tinystl::vector<uint32_t>& hashes,
+	const tinystl::vector<UIProperty>& properties, const char* name, size_t length)
+{
+	const uint32_t hash = hashPropertyName(name, length);
+	const uint32_t mask = (uint32_t)index.size() - 1;
+	for (uint32_t bucket = hash & mask; index[bucket] != 0; bucket = (bucket + 1) & mask)
 	{
-		while (*current != '=' && *current != '\0')
-			++current;
-		if (*current == '\0')
-			break;
+		const uint32_t propertyID = index[bucket] - 1;
+		if (hashes[propertyID] == hash && propertyNameEquals(name, length, properties[propertyID].description))
+			return (int)propertyID;
+	}
+	return -1;
+}
+
+int UI::findProperty(const char* description)
+{
+	if (propertyIndexDirty || propertyIndex.empty())
+		buildPropertyIndex();
+
+	return findPropertyInIndex(propertyIndex, propertyHashes, properties, description, strlen(description));
+}
+
+unsigned int UI::parseProperties(const char* text, size_t length)
+{
+	if (propertyIndexDirty || propertyIndex.empty())
+		buildPropertyIndex();
 
-		// copy ident
-		memcpy(ident, start, current - start);
-		ident[current - start] = 0;
+	const char* current = text;
+	const char* end = text + length;
 
-		// go to next char
-		++current;
-		start = current;
+	// Skip the UTF-8 byte order mark written by some editors
+	if (length >= 3 && (unsigned char)text[0] == 0xEF && (unsigned char)text[1] == 0xBB && (unsigned char)text[2] == 0xBF)
+		current += 3;
 
-		// find null char, or a new line character (\r or \n)
-		while (*current != '\r' && *current != '\n' && *current != '\0')
-			++current;
+	unsigned int applied = 0;
+	while (current < end)
+	{
+		const char* lineEnd = (const char*)memchr(current, '\n', end - current);
+		if (!lineEnd)
+			lineEnd = end;
+		const char* separator = (const char*)memchr(current, '=', lineEnd - current);
 
-		// copy set to
-		memcpy(setTo, start, current - start);
-		setTo[current - start] = 0;
+		const char* ident = current;
+		current = lineEnd + 1;
 
-		// load current property
-		int propertyID = -1;
-		for (uint i = 0; i < getPropertyCount(); i++) // TODO: linear search - slow - add a hash map/binary tree here if performance issue.
+		// Lines without a value are ignored
+		if (!separator)
+			continue;
+
+		// The description keeps its inner spaces, only the line ending is trimmed from the value
+		const char* identEnd = separator;
+		const char* value = separator + 1;
+		const char* valueEnd = lineEnd;
+		while (valueEnd > value && isPropertySpace(valueEnd[-1]))
+			--valueEnd;
+
+		const int propertyID = findPropertyInIndex(propertyIndex, propertyHashes, properties, ident, identEnd - ident);
+		if (propertyID == -1)
+			continue;
+
+		UIProperty& prop = properties[propertyID];
+		const size_t valueLength = valueEnd - value;
+
+		// Numbers are copied out since the text is not null terminated, anything longer than this is not a number
+		char number[64];
+		const bool isNumber = valueLength > 0 && valueLength < sizeof(number);
+		if (isNumber)
 		{
-			if (stricmp(getProperty(i).description, ident) == 0)
-			{
-				propertyID = i;
-				break;
-			}
+			memcpy(number, value, valueLength);
+			number[valueLength] = '\0';
 		}
+		char* numberEnd = NULL;
 
-		// if property found, parse the data
-		if (propertyID != -1)
+		switch (prop.type)
 		{
-			switch (getProperty(propertyID).type)
-			{
-			case UI_PROPERTY_FLOAT:
-				*(float*)getProperty(propertyID).source = (float)atof(setTo);
-				break;
-			case UI_PROPERTY_INT:
-				*(int*)getProperty(propertyID).source = atoi(setTo);
+		case UI_PROPERTY_FLOAT:
+		{
+			if (!isNumber)
 				break;
-			case UI_PROPERTY_UINT:
-				*(unsigned int*)getProperty(propertyID).source = atoi(setTo);
+			const float f = strtof(number, &numberEnd);
+			if (numberEnd != number)
+			{
+				*(float*)prop.source = f;
+				++applied;
+			}
+			break;
+		}
+		case UI_PROPERTY_INT:
+		{
+			if (!isNumber)
 				break;
-			case UI_PROPERTY_BOOL:
-				if (stricmp(setTo, "true") == 0 || stricmp(setTo, "1") == 0)
-					*(bool*)getProperty(propertyID).source = true;
-				else
-					*(bool*)getProperty(propertyID).source = false;
+			const long i = strtol(number, &numberEnd, 10);
+			if (numberEnd != number)
+			{
+				*(int*)prop.source = (int)i;
+				++applied;
+			}
+			break;
+		}
+		case UI_PROPERTY_UINT:
+		{
+			if (!isNumber)
 				break;
-			case UI_PROPERTY_ENUM:
-				ASSERT(getProperty(propertyID).settings.eByteSize == 4); // does not support other enums than those that are 4 bytes in size (yet)
-				for (int i = 0; getProperty(propertyID).settings.eNames[i] != 0; i++)
+			const unsigned long u = strtoul(number, &numberEnd, 10);
+			if (numberEnd != number)
+			{
+				*(unsigned int*)prop.source = (unsigned int)u;
+				++applied;
+			}
+			break;
+		}
+		case UI_PROPERTY_BOOL:
+			*(bool*)prop.source = propertyNameEquals(value, valueLength, "true") || propertyNameEquals(value, valueLength, "1");
+			++applied;
+			break;
+		case UI_PROPERTY_ENUM:
+			ASSERT(prop.settings.eByteSize == 4); // does not support other enums than those that are 4 bytes in size (yet)
+			for (int i = 0; prop.settings.eNames[i] != 0; i++)
+			{
+				if (propertyNameEquals(value, valueLength, prop.settings.eNames[i]))
 				{
-					if (stricmp(getProperty(propertyID).settings.eNames[i], setTo) == 0)
-					{
-						*(int*)getProperty(propertyID).source = ((const int*)getProperty(propertyID).settings.eValues)[i];
-					}
+					*(int*)prop.source = ((const int*)prop.settings.eValues)[i];
+					++applied;
+					break;
 				}
-
-				break;
-			case UI_PROPERTY_BUTTON:
-			case UI_PROPERTY_TEXTINPUT:
-				break;
 			}
+			break;
+		case UI_PROPERTY_BUTTON:
+		case UI_PROPERTY_TEXTINPUT:
+			break;
 		}
+	}
 
-		// check if this was the last segment
-		if (*current == '\0')
-			break;
+	return applied;
+}
 
-		// check if this was a \r, we'll need to skip another character. (getting past \r\n) - for sanity, we're ignoring old style Mac files that only have \r as line ending)
-		if (*current == '\r')
-			++current;
+bool UI::loadProperties(const char* filename)
+{
+	File file = {};file.Open(filename, FileMode::FM_ReadBinary, FSRoot::FSR_OtherFiles);
+	if (!file.IsOpen())
+	{
+		return false;
+	}
 
-		// go to next char
-		++current;
-		start = current;
+	unsigned totalBytes = file.GetSize();
+	if (totalBytes == 0)
+	{
+		file.Close();
+		return true;
 	}
 
+	char* buffer = (char*)conf_malloc(totalBytes);
+	totalBytes = file.Read(buffer, totalBytes);
+	file.Close();
+
+	parseProperties(buffer, totalBytes);
+
+	conf_free(buffer);
 	return true;
 }
 
@@ -477,45 +606,61 @@ bool UI::saveProperties(const char* filename)
 {
 	File file = {};
 	file.Open(filename, FileMode::FM_WriteBinary, FSRoot::FSR_OtherFiles);
-	if (!file.IsOpen() == 0)
-	{
-		file.Close();
+	if (!file.IsOpen())
 		return false;
-	}
 
+	// The whole file is formatted in memory and written at once
+	tinystl::vector<char> text;
+	text.reserve(properties.getCount() * 32);
 	for (unsigned int i = 0; i < getPropertyCount(); i++)
 	{
-		file.Write((void*)getProperty(i).description, (unsigned)strlen(getProperty(i).description));
-		file.Write((void*)"=", 1);
+		const UIProperty& prop = getProperty(i);
+		if (prop.source == NULL)
+			continue;
+
 		const uint32_t maxSize = 200;
 		char display[maxSize];
-		switch (getProperty(i).type)
+		switch (prop.type)
 		{
 		case UI_PROPERTY_FLOAT:
-			snprintf(display, maxSize, "%.3f", *(float*)getProperty(i).source);
+			// Enough digits for the value to survive a save / load round trip
+			snprintf(display, maxSize, "%.9g", *(float*)prop.source);
 			break;
 		case UI_PROPERTY_INT:
-			snprintf(display, maxSize, "%d", *(int*)getProperty(i).source);
+			snprintf(display, maxSize, "%d", *(int*)prop.source);
 			break;
 		case UI_PROPERTY_UINT:
-			snprintf(display, maxSize, "%u", *(unsigned int*)getProperty(i).source);
+			snprintf(display, maxSize, "%u", *(unsigned int*)prop.source);
 			break;
 		case UI_PROPERTY_BOOL:
-			snprintf(display, maxSize, "%s", (*(bool*)getProperty(i).source) ? "true" : "false");
+			snprintf(display, maxSize, "%s", (*(bool*)prop.source) ? "true" : "false");
 			break;
 		case UI_PROPERTY_ENUM:
-			ASSERT(getProperty(i).enumComputeIndex() != -1);
-			snprintf(display, maxSize, "%s", getProperty(i).settings.eNames[getProperty(i).enumComputeIndex()]);
+		{
+			const int enumIndex = prop.enumComputeIndex();
+			ASSERT(enumIndex != -1);
+			if (enumIndex == -1)
+				continue;
+			snprintf(display, maxSize, "%s", prop.settings.eNames[enumIndex]);
+			break;
+		}
 		case UI_PROPERTY_BUTTON:
 		case UI_PROPERTY_TEXTINPUT:
-			break;
+		default:
+			continue;
 		}
-		file.Write(display, (unsigned)strlen(display));
-		file.Write((void*)"\r\n", 2);
+
+		static const char separator[] = "=";
+		static const char lineEnd[] = "\r\n";
+		text.insert(text.end(), prop.description, prop.description + strlen(prop.description));
+		text.insert(text.end(), separator, separator + 1);
+		text.insert(text.end(), display, display + strlen(display));
+		text.insert(text.end(), lineEnd, lineEnd + 2);
 	}
 
+	const unsigned written = text.empty() ? 0 : file.Write(text.data(), (unsigned)text.size());
 	file.Close();
-	return true;
+	return written == (unsigned)text.size();
 }
 
 void UI::setPropertyFlag(unsigned int propertyId, UIProperty::FLAG flag, bool state)
@@ -45,15 +45,28 @@ public:
 	void clearProperties();
 	void removeProperty(unsigned int idx);
 
+	// Returns the index of the first property with the given description (case insensitive), or -1 if there is none.
+	// Descriptions are hashed when the property is added, they must not be changed through getProperty afterwards.
+	int findProperty(const char* description);
+
 	void setOnPropertyChanged(PropertyChangedCallback clb) { onPropertyChanged = clb; }
 	bool saveProperties(const char* filename);
 	bool loadProperties(const char* filename);
+	// Applies "description=value" lines, one property per line. Returns the number of properties that were set.
+	unsigned int parseProperties(const char* text, size_t length);
 
 	void setPropertyFlag(unsigned int propertyId, UIProperty::FLAG flag, bool state);
 
 protected:
+	void buildPropertyIndex();
+
 	PropertyChangedCallback onPropertyChanged;
 	tinystl::vector<UIProperty> properties;
+	// Open addressing hash table of property index + 1 (0 marks an empty bucket), rebuilt lazily after properties change
+	tinystl::vector<uint32_t> propertyIndex;
+	tinystl::vector<uint32_t> propertyHashes;
+	unsigned int emptyPropertySlots;
+	bool propertyIndexDirty;
 };
 
 class UIAppComponentBase
@@ -205,7 +205,7 @@ void cmdUIDrawGUI(struct Cmd* pCmd, UIManager* pUIManager, Gui* pGui)
 
 void cmdUIDrawGpuProfileData(Cmd* pCmd, struct UIManager* pUIManager, vec2& startPos, const GpuProfileDrawDesc* pDrawDesc, struct GpuProfiler* pGpuProfiler, GpuTimerTree* pRoot)
 {
-#if defined(DIRECT3D12) || defined(VULKAN)
+#if defined(DIRECT3D12) || defined(VULKAN) || defined(NULL_RENDERER)
 	if (!pRoot)
 		return;
 
@@ -235,7 +235,7 @@ void cmdUIDrawGpuProfileData(Cmd* pCmd, struct UIManager* pUIManager, vec2& star
 
 void cmdUIDrawGpuProfileData(Cmd* pCmd, struct UIManager* pUIManager, const vec2& startPos, struct GpuProfiler* pGpuProfiler, const GpuProfileDrawDesc* pDrawDesc)
 {
-#if defined(DIRECT3D12) || defined(VULKAN)
+#if defined(DIRECT3D12) || defined(VULKAN) || defined(NULL_RENDERER)
 	vec2 pos = startPos;
 	cmdUIDrawText(pCmd, pUIManager, startPos, "-----GPU Times-----");
 	pos.setY(pos.getY() + (pDrawDesc ? pDrawDesc->mHeightOffset : pUIManager->mSettings.mDefaultGpuProfileDrawDesc.mHeightOffset));
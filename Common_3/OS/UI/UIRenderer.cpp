@@ -62,6 +62,7 @@ UIRenderer::UIRenderer(Renderer* renderer) :
 	pRootSignaturePlainMesh(NULL),
 	/// Texture mesh pipeline data
 	pBuiltinTextShader(NULL),
+	pBuiltinTextSdfShader(NULL),
 	pBuiltinTextureShader(NULL),
 	pRootSignatureTextureMesh(NULL),
 	/// Default states
@@ -84,6 +85,7 @@ UIRenderer::UIRenderer(Renderer* renderer) :
 	String psPlainFile = "builtin_plain";
 	String vsTexturedFile = "builtin_textured";
 	String psTexturedRedAlphaFile = "builtin_textured_red_alpha";
+	String psTexturedDistanceFieldFile = "builtin_textured_distance_field";
 	String psTexturedFile = "builtin_textured";
 
 	String vsPlain = builtin_plain;
@@ -91,7 +93,8 @@ UIRenderer::UIRenderer(Renderer* renderer) :
 	String vsTextured = builtin_textured;
 	String psTextured = builtin_textured;
 	String psTexturedRedAlpha = builtin_textured_red_alpha;
-#elif defined (VULKAN)
+	String psTexturedDistanceField = builtin_textured_distance_field;
+#elif defined (VULKAN) || defined(NULL_RENDERER)
 	vsEntryPoint = "main";
 	psEntryPoint = "main";
 	String vsPlainFile = "builtin_plain.vert";
@@ -99,6 +102,7 @@ UIRenderer::UIRenderer(Renderer* renderer) :
 	String vsTexturedFile = "builtin_textured.vert";
 	String psTexturedFile = "builtin_textured.frag";
 	String psTexturedRedAlphaFile = "builtin_textured_red_alpha.frag";
+	String psTexturedDistanceFieldFile = "builtin_textured_distance_field.frag";
 
 	String vsPlain;
 	vsPlain.resize(sizeof(builtin_plain_vert));
@@ -115,6 +119,9 @@ UIRenderer::UIRenderer(Renderer* renderer) :
 	String psTexturedRedAlpha;
 	psTexturedRedAlpha.resize(sizeof(builtin_textured_red_alpha_frag));
 	memcpy(psTexturedRedAlpha.begin(), builtin_textured_red_alpha_frag, sizeof(builtin_textured_red_alpha_frag));
+	String psTexturedDistanceField;
+	psTexturedDistanceField.resize(sizeof(builtin_textured_distance_field_frag));
+	memcpy(psTexturedDistanceField.begin(), builtin_textured_distance_field_frag, sizeof(builtin_textured_distance_field_frag));
 #endif
 
 	ShaderDesc plainShader = {
@@ -127,6 +134,11 @@ UIRenderer::UIRenderer(Renderer* renderer) :
 		{ vsTexturedFile, vsTextured, vsEntryPoint },
 		{ psTexturedRedAlphaFile, psTexturedRedAlpha, psEntryPoint }
 	};
+	ShaderDesc texSdfShader = {
+		SHADER_STAGE_VERT | SHADER_STAGE_FRAG,
+		{ vsTexturedFile, vsTextured, vsEntryPoint },
+		{ psTexturedDistanceFieldFile, psTexturedDistanceField, psEntryPoint }
+	};
 	ShaderDesc textureShader = {
 		SHADER_STAGE_VERT | SHADER_STAGE_FRAG,
 		{ vsTexturedFile, vsTextured, vsEntryPoint },
@@ -135,6 +147,7 @@ UIRenderer::UIRenderer(Renderer* renderer) :
 
 	addShader(pRenderer, &plainShader, &pBuiltinPlainShader);
 	addShader(pRenderer, &texShader, &pBuiltinTextShader);
+	addShader(pRenderer, &texSdfShader, &pBuiltinTextSdfShader);
 	addShader(pRenderer, &textureShader, &pBuiltinTextureShader);
 
 	addSampler(pRenderer, &pDefaultSampler);
@@ -185,6 +198,7 @@ UIRenderer::~UIRenderer()
 
 	removeShader(pRenderer, pBuiltinPlainShader);
 	removeShader(pRenderer, pBuiltinTextShader);
+	removeShader(pRenderer, pBuiltinTextSdfShader);
 	removeShader(pRenderer, pBuiltinTextureShader);
 
 	for (PipelineMapNode& node : mPipelinePlainMesh)
@@ -197,6 +211,7 @@ UIRenderer::~UIRenderer()
 
 			removePipeline(pRenderer, mPipelinePlainMesh[hash][i]);
 			removePipeline(pRenderer, mPipelineTextMesh[hash][i]);
+			removePipeline(pRenderer, mPipelineTextSdfMesh[hash][i]);
 			removePipeline(pRenderer, mPipelineTextureMesh[hash][i]);
 		}
 	}
@@ -282,6 +297,7 @@ void UIRenderer::beginRender(Cmd* pCmd, uint32_t renderTargetCount, RenderTarget
 
 		PipelineVector pipelinePlainMesh = PipelineVector(PrimitiveTopology::PRIMITIVE_TOPO_COUNT);
 		PipelineVector pipelineTextMesh = PipelineVector(PrimitiveTopology::PRIMITIVE_TOPO_COUNT);
+		PipelineVector pipelineTextSdfMesh = PipelineVector(PrimitiveTopology::PRIMITIVE_TOPO_COUNT);
 		PipelineVector pipelineTextureMesh = PipelineVector(PrimitiveTopology::PRIMITIVE_TOPO_COUNT);
 
 		for (uint32_t i = 0; i < PrimitiveTopology::PRIMITIVE_TOPO_COUNT; ++i)
@@ -301,18 +317,23 @@ void UIRenderer::beginRender(Cmd* pCmd, uint32_t renderTargetCount, RenderTarget
 			vertexLayout.mAttribCount = 2;
 			addPipeline(pRenderer, &pipelineDesc, &pipelineTextMesh[i]);
 
+			pipelineDesc.pShaderProgram = pBuiltinTextSdfShader;
+			addPipeline(pRenderer, &pipelineDesc, &pipelineTextSdfMesh[i]);
+
 			pipelineDesc.pShaderProgram = pBuiltinTextureShader;
 			addPipeline(pRenderer, &pipelineDesc, &pipelineTextureMesh[i]);
 		}
 
 		pCurrentPipelinePlainMesh = &mPipelinePlainMesh.insert({ hash, pipelinePlainMesh }).first->second;
 		pCurrentPipelineTextMesh = &mPipelineTextMesh.insert({ hash, pipelineTextMesh }).first->second;
+		pCurrentPipelineTextSdfMesh = &mPipelineTextSdfMesh.insert({ hash, pipelineTextSdfMesh }).first->second;
 		pCurrentPipelineTextureMesh = &mPipelineTextureMesh.insert({ hash, pipelineTextureMesh }).first->second;
 	}
 	else
 	{
 		pCurrentPipelinePlainMesh = &mPipelinePlainMesh[hash];
 		pCurrentPipelineTextMesh = &mPipelineTextMesh[hash];
+		pCurrentPipelineTextSdfMesh = &mPipelineTextSdfMesh[hash];
 		pCurrentPipelineTextureMesh = &mPipelineTextureMesh[hash];
 	}
 
@@ -330,9 +351,9 @@ void UIRenderer::onWindowResize(const struct WindowResizeEventData* pData)
 	gWindowHeight = getRectHeight(pData->rect);
 }
 
-uint32_t UIRenderer::addFontstash(uint32_t width, uint32_t height)
+uint32_t UIRenderer::addFontstash(uint32_t width, uint32_t height, bool distanceField)
 {
-	mFontStashes.push_back(conf_placement_new<Fontstash>(conf_calloc(1, sizeof(Fontstash)), this, (int)width, (int)height));
+	mFontStashes.push_back(conf_placement_new<Fontstash>(conf_calloc(1, sizeof(Fontstash)), this, (int)width, (int)height, distanceField));
 	return mFontStashes.getCount() - 1;
 }
 
@@ -392,7 +413,17 @@ void UIRenderer::removeFont(int fontID)
 void UIRenderer::drawTexturedR8AsAlpha(PrimitiveTopology primitives, TexVertex* pVertices, const uint32_t nVertices, Texture* pTexture, const float4* pColor)
 {
 	ASSERT(primitives != PRIMITIVE_TOPO_PATCH_LIST && "Primitive type not supported for UI rendering");
+	drawTexturedR8(pCurrentPipelineTextMesh->operator[](primitives), pVertices, nVertices, pTexture, pColor);
+}
+
+void UIRenderer::drawTexturedR8AsDistanceField(PrimitiveTopology primitives, TexVertex* pVertices, const uint32_t nVertices, Texture* pTexture, const float4* pColor)
+{
+	ASSERT(primitives != PRIMITIVE_TOPO_PATCH_LIST && "Primitive type not supported for UI rendering");
+	drawTexturedR8(pCurrentPipelineTextSdfMesh->operator[](primitives), pVertices, nVertices, pTexture, pColor);
+}
 
+void UIRenderer::drawTexturedR8(Pipeline* pPipeline, TexVertex* pVertices, const uint32_t nVertices, Texture* pTexture, const float4* pColor)
+{
 	uint32_t vertexDataSize = sizeof(TexVertex) * nVertices;
 	float4 scaleBias2D(2.0f / (float)gWindowWidth, -2.0f / (float)gWindowHeight, -1.0f, 1.0f);
 	float uniBuffer[6] = { scaleBias2D.getX(), scaleBias2D.getY(), scaleBias2D.getZ(), scaleBias2D.getW(), (float)pTexture->mDesc.mWidth, (float)pTexture->mDesc.mHeight };
@@ -417,7 +448,7 @@ void UIRenderer::drawTexturedR8AsAlpha(PrimitiveTopology primitives, TexVertex*
 	params[1].mOffset = ps.mOffset;
 	params[2].pName = "uTex0";
 	params[2].ppTextures = &pTexture;
-	cmdBindPipeline(pCurrentCmd, pCurrentPipelineTextMesh->operator[](primitives));
+	cmdBindPipeline(pCurrentCmd, pPipeline);
 	cmdBindDescriptors(pCurrentCmd, pRootSignatureTextureMesh, 3, params);
 	cmdBindVertexBuffer(pCurrentCmd, 1, &buffer);
 	cmdDraw(pCurrentCmd, nVertices, 0);
@@ -54,6 +54,8 @@ public:
 	~UIRenderer();
 
 	void		drawTexturedR8AsAlpha(PrimitiveTopology primitives, TexVertex *vertices, const uint32_t nVertices, Texture* texture, const float4* color);
+	/// Reconstructs antialiased coverage from a signed distance field texture (outline at 0.5), at any magnification.
+	void		drawTexturedR8AsDistanceField(PrimitiveTopology primitives, TexVertex *vertices, const uint32_t nVertices, Texture* texture, const float4* color);
 	void		drawTextured(PrimitiveTopology primitives, TexVertex* vertices, const uint32_t nVertices, Texture* texture, const float4* color);
 	void		drawPlain(PrimitiveTopology primitives, float2* vertices, const uint32_t nVertices, const float4* color);
 
@@ -65,12 +67,14 @@ public:
 	Texture*	addTexture(Image* image, uint32_t flags);
 	void		removeTexture(Texture* tex);
 	
-	uint32_t	addFontstash(uint32_t width, uint32_t height);
+	uint32_t	addFontstash(uint32_t width, uint32_t height, bool distanceField = false);
 	Fontstash*	getFontstash(uint32_t fontID);
 
 	int			addFont(const char* filename, const char* fontName = "", FSRoot root = FSRoot::FSR_Builtin_Fonts);
 	
 private:
+	void		drawTexturedR8(Pipeline* pPipeline, TexVertex *vertices, const uint32_t nVertices, Texture* texture, const float4* color);
+
 	using PipelineVector = tinystl::vector <Pipeline*>;
 	using PipelineMap = tinystl::unordered_map<uint64_t, PipelineVector>;
 	using PipelineMapNode = tinystl::unordered_hash_node<uint64_t, PipelineVector>;
@@ -84,9 +88,11 @@ private:
 
 	/// Texture mesh pipeline data
 	Shader*							pBuiltinTextShader;
+	Shader*							pBuiltinTextSdfShader;
 	Shader*							pBuiltinTextureShader;
 	RootSignature*					pRootSignatureTextureMesh;
 	PipelineMap						mPipelineTextMesh;
+	PipelineMap						mPipelineTextSdfMesh;
 	PipelineMap						mPipelineTextureMesh;
 
 	/// Default states
@@ -111,5 +117,6 @@ private:
 	Cmd*							pCurrentCmd;
 	PipelineVector*					pCurrentPipelinePlainMesh;
 	PipelineVector*					pCurrentPipelineTextMesh;
+	PipelineVector*					pCurrentPipelineTextSdfMesh;
 	PipelineVector*					pCurrentPipelineTextureMesh;
 };
@@ -125,7 +125,32 @@ float4 PSMain(PsIn In) : SV_Target
     return float4(1.0, 1.0, 1.0, uTex0.Sample(uSampler0, In.texCoord).r) * color;
 };
 )";
-#elif defined(VULKAN)
+
+const char* builtin_textured_distance_field = R"(
+struct PsIn
+{
+	float4 position: SV_Position;
+	float2 texCoord: TEXCOORD0;
+	float4 ScaledTexCoord: TEXCOORD1;
+};
+
+Texture2D uTex0: register(t2);
+SamplerState uSampler0: register(s3);
+
+cbuffer uniformBlockPS : register(b1)
+{
+	float4 color;
+};
+
+float4 PSMain(PsIn In) : SV_Target
+{
+    // Outline at 0.5, antialiased over one screen pixel
+    float dist = uTex0.Sample(uSampler0, In.texCoord).r;
+    float width = fwidth(dist) * 0.5;
+    return float4(1.0, 1.0, 1.0, smoothstep(0.5 - width, 0.5 + width, dist)) * color;
+};
+)";
+#elif defined(VULKAN) || defined(NULL_RENDERER)
 /*
 #version 450 core
 
@@ -416,6 +441,68 @@ const uint32_t builtin_textured_red_alpha_frag[] = {
 	0x00000022,0x0005008e,0x00000007,0x00000024,0x00000023,0x0000001b,0x0003003e,0x00000009,
 	0x00000024,0x000100fd,0x00010038
 };
+
+/*
+#version 450 core
+
+layout (location = 0) in vec2 texcoord;
+
+layout (location = 0) out vec4 oColor;
+
+layout (set=0, binding=1) uniform uniformBlockPS
+{
+uniform vec4 color;
+};
+
+layout (set=0, binding=2) uniform texture2D uTex0;
+layout (set=0, binding=3) uniform sampler uSampler0;
+
+void main(void)
+{
+float dist = texture(sampler2D(uTex0, uSampler0), texcoord).r;
+float width = fwidth(dist) * 0.5;
+oColor = smoothstep(0.5 - width, 0.5 + width, dist) * color;
+}
+*/
+#pragma once
+const uint32_t builtin_textured_distance_field_frag[] = {
+	0x07230203,0x00010000,0x00080002,0x0000002b,0x00000000,0x00020011,0x00000001,0x0006000b,
+	0x00000001,0x4c534c47,0x6474732e,0x3035342e,0x00000000,0x0003000e,0x00000000,0x00000001,
+	0x0007000f,0x00000004,0x00000004,0x6e69616d,0x00000000,0x00000009,0x00000016,0x00030010,
+	0x00000004,0x00000007,0x00030003,0x00000002,0x000001c2,0x00040005,0x00000004,0x6e69616d,
+	0x00000000,0x00040005,0x00000009,0x6c6f436f,0x0000726f,0x00040005,0x0000000c,0x78655475,
+	0x00000030,0x00050005,0x00000010,0x6d615375,0x72656c70,0x00000030,0x00050005,0x00000016,
+	0x63786574,0x64726f6f,0x00000000,0x00060005,0x0000001c,0x66696e75,0x426d726f,0x6b636f6c,
+	0x00005350,0x00050006,0x0000001c,0x00000000,0x6f6c6f63,0x00000072,0x00030005,0x0000001e,
+	0x00000000,0x00040047,0x00000009,0x0000001e,0x00000000,0x00040047,0x0000000c,0x00000022,
+	0x00000000,0x00040047,0x0000000c,0x00000021,0x00000002,0x00040047,0x00000010,0x00000022,
+	0x00000000,0x00040047,0x00000010,0x00000021,0x00000003,0x00040047,0x00000016,0x0000001e,
+	0x00000000,0x00050048,0x0000001c,0x00000000,0x00000023,0x00000000,0x00030047,0x0000001c,
+	0x00000002,0x00040047,0x0000001e,0x00000022,0x00000000,0x00040047,0x0000001e,0x00000021,
+	0x00000001,0x00020013,0x00000002,0x00030021,0x00000003,0x00000002,0x00030016,0x00000006,
+	0x00000020,0x00040017,0x00000007,0x00000006,0x00000004,0x00040020,0x00000008,0x00000003,
+	0x00000007,0x0004003b,0x00000008,0x00000009,0x00000003,0x00090019,0x0000000a,0x00000006,
+	0x00000001,0x00000000,0x00000000,0x00000000,0x00000001,0x00000000,0x00040020,0x0000000b,
+	0x00000000,0x0000000a,0x0004003b,0x0000000b,0x0000000c,0x00000000,0x0002001a,0x0000000e,
+	0x00040020,0x0000000f,0x00000000,0x0000000e,0x0004003b,0x0000000f,0x00000010,0x00000000,
+	0x0003001b,0x00000012,0x0000000a,0x00040017,0x00000014,0x00000006,0x00000002,0x00040020,
+	0x00000015,0x00000001,0x00000014,0x0004003b,0x00000015,0x00000016,0x00000001,0x00040015,
+	0x00000019,0x00000020,0x00000000,0x0004002b,0x00000019,0x0000001a,0x00000000,0x0003001e,
+	0x0000001c,0x00000007,0x00040020,0x0000001d,0x00000002,0x0000001c,0x0004003b,0x0000001d,
+	0x0000001e,0x00000002,0x00040015,0x0000001f,0x00000020,0x00000001,0x0004002b,0x0000001f,
+	0x00000020,0x00000000,0x00040020,0x00000021,0x00000002,0x00000007,0x0004002b,0x00000006,
+	0x00000027,0x3f000000,0x00050036,0x00000002,0x00000004,0x00000000,0x00000003,0x000200f8,
+	0x00000005,0x0004003d,0x0000000a,0x0000000d,0x0000000c,0x0004003d,0x0000000e,0x00000011,
+	0x00000010,0x00050056,0x00000012,0x00000013,0x0000000d,0x00000011,0x0004003d,0x00000014,
+	0x00000017,0x00000016,0x00050057,0x00000007,0x00000018,0x00000013,0x00000017,0x00050051,
+	0x00000006,0x0000001b,0x00000018,0x00000000,0x00050041,0x00000021,0x00000022,0x0000001e,
+	0x00000020,0x0004003d,0x00000007,0x00000023,0x00000022,0x000400d1,0x00000006,0x00000025,
+	0x0000001b,0x00050085,0x00000006,0x00000026,0x00000025,0x00000027,0x00050083,0x00000006,
+	0x00000028,0x00000027,0x00000026,0x00050081,0x00000006,0x00000029,0x00000027,0x00000026,
+	0x0008000c,0x00000006,0x0000002a,0x00000001,0x00000031,0x00000028,0x00000029,0x0000001b,
+	0x0005008e,0x00000007,0x00000024,0x00000023,0x0000002a,0x0003003e,0x00000009,0x00000024,
+	0x000100fd,0x00010038
+};
 #elif defined(METAL)
 const char* builtin_plain = R"(
 #include <metal_stdlib>
@@ -515,4 +602,27 @@ fragment float4 PSMain(PsIn In [[stage_in]], texture2d<float,access::sample> uTe
 	return float4(1.0, 1.0, 1.0, uTex0.sample(uSampler0, In.texCoord).r) * uniformBlockPS.color;
 };
 )";
+
+const char* builtin_textured_distance_field = R"(
+#include <metal_stdlib>
+using namespace metal;
+
+struct PsIn {
+	float4 position [[position]];
+	float2 texCoord;
+	float4 ScaledTexCoord;
+};
+
+struct UniformBlock0
+{
+	float4 color;
+};
+
+fragment float4 PSMain(PsIn In [[stage_in]], texture2d<float,access::sample> uTex0 [[texture(2)]], sampler uSampler0 [[sampler(3)]], constant UniformBlock0& uniformBlockPS [[buffer(1)]]) {
+	// Outline at 0.5, antialiased over one screen pixel
+	float dist = uTex0.sample(uSampler0, In.texCoord).r;
+	float width = fwidth(dist) * 0.5;
+	return float4(1.0, 1.0, 1.0, smoothstep(0.5 - width, 0.5 + width, dist)) * uniformBlockPS.color;
+};
+)";
 #endif
\ No newline at end of file
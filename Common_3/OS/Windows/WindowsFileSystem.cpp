@@ -61,6 +61,16 @@ long _tellFile(FileHandle handle)
 	return ftell((::FILE*)handle);
 }
 
+bool _seekFile64(FileHandle handle, int64_t offset, int origin)
+{
+	return _fseeki64((::FILE*)handle, offset, origin) == 0;
+}
+
+int64_t _tellFile64(FileHandle handle)
+{
+	return (int64_t)_ftelli64((::FILE*)handle);
+}
+
 size_t _writeFile(const void *buffer, size_t byteCount, FileHandle handle)
 {
 	return fwrite(buffer, byteCount, 1, (::FILE*)handle);
@@ -62,6 +62,16 @@ long _tellFile(FileHandle handle)
   return ftell((::FILE*)handle);
 }
 
+bool _seekFile64(FileHandle handle, int64_t offset, int origin)
+{
+  return fseeko((::FILE*)handle, (off_t)offset, origin) == 0;
+}
+
+int64_t _tellFile64(FileHandle handle)
+{
+  return (int64_t)ftello((::FILE*)handle);
+}
+
 size_t _writeFile(const void *buffer, size_t byteCount, FileHandle handle)
 {
   return fwrite(buffer, 1, byteCount, (::FILE*)handle);
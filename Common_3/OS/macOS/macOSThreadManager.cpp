@@ -75,11 +75,17 @@ void* ThreadFunctionStatic(void* data)
   
   void ConditionVariable::Wait(const Mutex &mutex, unsigned int ms)
   {
+      pthread_mutex_t* mutexHandle = (pthread_mutex_t*)&mutex.pHandle;
+      if (ms == TIMEOUT_INFINITE)
+      {
+          pthread_cond_wait(&pHandle, mutexHandle);
+          return;
+      }
+      
       timespec ts;
       ts.tv_sec = 0;
       ts.tv_nsec = ms*1000;
       
-      pthread_mutex_t* mutexHandle = (pthread_mutex_t*)&mutex.pHandle;
       pthread_cond_timedwait(&pHandle, mutexHandle, &ts);
   }
   
@@ -88,6 +94,11 @@ void* ThreadFunctionStatic(void* data)
       pthread_cond_signal(&pHandle);
   }
   
+  void ConditionVariable::SetAll()
+  {
+      pthread_cond_broadcast(&pHandle);
+  }
+  
 ThreadID Thread::mainThreadID;
 
 /*	void Thread::SetPriority(int priority)
@@ -123,7 +134,13 @@ bool Thread::IsMainThread()
   void _destroyThread(ThreadHandle handle)
   {
       assert(handle!=nullptr);
-      // thread is destroyed automatically when function exitsß
+      // Wait for the thread function to return so the caller can free what it uses
+      pthread_join(handle,NULL);
+  }
+  
+  void _joinThread(ThreadHandle handle)
+  {
+      pthread_join(handle,NULL);
   }
   
 void Thread::Sleep(unsigned mSec)
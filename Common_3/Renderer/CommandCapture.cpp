@@ -0,0 +1,3520 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Unqualified calls made in this file go to the backend, the capture wrappers are in CommandCaptureLayer
+#define COMMAND_CAPTURE_IMPLEMENTATION
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "CommandCapture.h"
+#include "../OS/Core/ContentHash.h"
+#include "../OS/Interfaces/ILogManager.h"
+#include "../OS/Interfaces/IOperatingSystem.h"
+#include "../OS/Interfaces/IThread.h"
+#include "../OS/Interfaces/IMemoryManager.h"
+
+extern void addBuffer(Renderer* pRenderer, const BufferDesc* desc, Buffer** pp_buffer);
+extern void removeBuffer(Renderer* pRenderer, Buffer* p_buffer);
+extern void mapBuffer(Renderer* pRenderer, Buffer* pBuffer, ReadRange* pRange);
+extern void unmapBuffer(Renderer* pRenderer, Buffer* pBuffer);
+extern void addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** pp_texture);
+extern void removeTexture(Renderer* pRenderer, Texture*p_texture);
+extern void cmdUpdateBuffer(Cmd* p_cmd, uint64_t srcOffset, uint64_t dstOffset, uint64_t size, Buffer* p_src_buffer, Buffer* p_buffer);
+extern void cmdUpdateSubresources(Cmd* pCmd, uint32_t startSubresource, uint32_t numSubresources, SubresourceDataDesc* pSubresources, Buffer* pIntermediate, uint64_t intermediateOffset, Texture* pTexture);
+extern void addQueryHeap(Renderer* pRenderer, const QueryHeapDesc* pDesc, QueryHeap** ppQueryHeap);
+extern void removeQueryHeap(Renderer* pRenderer, QueryHeap* pQueryHeap);
+extern void cmdBeginQuery(Cmd* pCmd, QueryHeap* pQueryHeap, QueryDesc* pQuery);
+extern void cmdEndQuery(Cmd* pCmd, QueryHeap* pQueryHeap, QueryDesc* pQuery);
+extern void cmdResolveQuery(Cmd* pCmd, QueryHeap* pQueryHeap, Buffer* pReadbackBuffer, uint32_t startQuery, uint32_t queryCount);
+
+/************************************************************************/
+// File format
+/************************************************************************/
+// The file starts with COMMAND_CAPTURE_MAGIC and COMMAND_CAPTURE_VERSION (little endian uint32_t each) followed by
+// records: op (uint8_t), payload size (uint32_t), payload. The payload is described by the signature of the op:
+//   u  unsigned LEB128 varint          i  signed varint (zigzag)         f  float, raw 32 bits
+//   o  object id (varint), 0 is NULL   s  string: varint length + 1, characters and '\0' (0 is a NULL string)
+//   b  blob: varint size and bytes     [...] varint count followed by count repetitions of the group
+// Object ids are handed out in creation order starting at 1, so captures of the same call sequence are identical.
+#define COMMAND_CAPTURE_MAGIC		0x50434346U	// "FCCP"
+#define COMMAND_CAPTURE_VERSION		1U
+#define COMMAND_CAPTURE_RECORD_HEADER_SIZE	5U
+/// Pending records are written to the file once they exceed this size, on queuePresent and in endCommandCapture
+#define COMMAND_CAPTURE_FLUSH_SIZE	(1024U * 1024U)
+/// Granularity at which CPU visible buffers are compared against the last captured contents
+#define COMMAND_CAPTURE_PAGE_SIZE	4096U
+
+typedef enum CaptureCategory
+{
+	CAPTURE_CATEGORY_RESOURCE = 0,
+	CAPTURE_CATEGORY_COMMAND,
+	CAPTURE_CATEGORY_QUEUE,
+} CaptureCategory;
+
+// Op, API call, timing category, payload signature
+#define COMMAND_CAPTURE_OPS(OP) \
+	OP(INIT_RENDERER,					initRenderer,					RESOURCE,	"suoooo") \
+	OP(REMOVE_RENDERER,					removeRenderer,					RESOURCE,	"o") \
+	OP(ADD_FENCE,						addFence,						RESOURCE,	"ouo") \
+	OP(REMOVE_FENCE,					removeFence,					RESOURCE,	"oo") \
+	OP(ADD_SEMAPHORE,					addSemaphore,					RESOURCE,	"oo") \
+	OP(REMOVE_SEMAPHORE,				removeSemaphore,				RESOURCE,	"oo") \
+	OP(ADD_QUEUE,						addQueue,						RESOURCE,	"ouuuo") \
+	OP(REMOVE_QUEUE,					removeQueue,					RESOURCE,	"o") \
+	OP(ADD_SWAP_CHAIN,					addSwapChain,					RESOURCE,	"oouuuuuuffffuuo[oo]") \
+	OP(REMOVE_SWAP_CHAIN,				removeSwapChain,				RESOURCE,	"oo") \
+	OP(ADD_CMD_POOL,					addCmdPool,						RESOURCE,	"oou[u]o") \
+	OP(REMOVE_CMD_POOL,					removeCmdPool,					RESOURCE,	"oo") \
+	OP(ADD_CMD,							addCmd,							RESOURCE,	"ouo") \
+	OP(REMOVE_CMD,						removeCmd,						RESOURCE,	"oo") \
+	OP(ADD_CMD_N,						addCmd_n,						RESOURCE,	"ouo[o]") \
+	OP(REMOVE_CMD_N,					removeCmd_n,					RESOURCE,	"oo[o]") \
+	OP(ADD_RENDER_TARGET,				addRenderTarget,				RESOURCE,	"ouuuuuuuuuuffffuuuoo") \
+	OP(REMOVE_RENDER_TARGET,			removeRenderTarget,				RESOURCE,	"oo") \
+	OP(ADD_SAMPLER,						addSampler,						RESOURCE,	"ouuuuuuffo") \
+	OP(REMOVE_SAMPLER,					removeSampler,					RESOURCE,	"oo") \
+	OP(ADD_SHADER,						addShader,						RESOURCE,	"o[usbs[ss]s]o") \
+	OP(REMOVE_SHADER,					removeShader,					RESOURCE,	"oo") \
+	OP(ADD_ROOT_SIGNATURE,				addRootSignature,				RESOURCE,	"o[o][[u][so][s]]o") \
+	OP(REMOVE_ROOT_SIGNATURE,			removeRootSignature,			RESOURCE,	"oo") \
+	OP(ADD_PIPELINE,					addPipeline,					RESOURCE,	"ooo[[usuuuu]][o]ouoooo") \
+	OP(ADD_COMPUTE_PIPELINE,			addComputePipeline,				RESOURCE,	"oooo") \
+	OP(REMOVE_PIPELINE,					removePipeline,					RESOURCE,	"oo") \
+	OP(ADD_BLEND_STATE,					addBlendState,					RESOURCE,	"uuuuuuiiuo") \
+	OP(REMOVE_BLEND_STATE,				removeBlendState,				RESOURCE,	"o") \
+	OP(ADD_DEPTH_STATE,					addDepthState,					RESOURCE,	"ouuuuuuuuuuuuuuo") \
+	OP(REMOVE_DEPTH_STATE,				removeDepthState,				RESOURCE,	"o") \
+	OP(ADD_RASTERIZER_STATE,			addRasterizerState,				RESOURCE,	"uifuuuo") \
+	OP(REMOVE_RASTERIZER_STATE,			removeRasterizerState,			RESOURCE,	"o") \
+	OP(ADD_BUFFER,						addBuffer,						RESOURCE,	"ouuuuuuuuuuouuo") \
+	OP(REMOVE_BUFFER,					removeBuffer,					RESOURCE,	"oo") \
+	OP(MAP_BUFFER,						mapBuffer,						RESOURCE,	"oo[uu]") \
+	OP(UNMAP_BUFFER,					unmapBuffer,					RESOURCE,	"oo") \
+	OP(BUFFER_DATA,						bufferData,						RESOURCE,	"oub") \
+	OP(ADD_TEXTURE,						addTexture,						RESOURCE,	"ouuuuuuuuuuuuffffuuuuo") \
+	OP(REMOVE_TEXTURE,					removeTexture,					RESOURCE,	"oo") \
+	OP(ADD_QUERY_HEAP,					addQueryHeap,					RESOURCE,	"ouuo") \
+	OP(REMOVE_QUERY_HEAP,				removeQueryHeap,				RESOURCE,	"oo") \
+	OP(ADD_INDIRECT_COMMAND_SIGNATURE,	addIndirectCommandSignature,	RESOURCE,	"ooo[uuuu]o") \
+	OP(REMOVE_INDIRECT_COMMAND_SIGNATURE, removeIndirectCommandSignature, RESOURCE,	"oo") \
+	OP(BEGIN_CMD,						beginCmd,						COMMAND,	"o") \
+	OP(END_CMD,							endCmd,							COMMAND,	"o") \
+	OP(CMD_BEGIN_RENDER,				cmdBeginRender,					COMMAND,	"o[o]o[[ffffu]ffffuu]") \
+	OP(CMD_END_RENDER,					cmdEndRender,					COMMAND,	"o[o]o") \
+	OP(CMD_SET_VIEWPORT,				cmdSetViewport,					COMMAND,	"offffff") \
+	OP(CMD_SET_SCISSOR,					cmdSetScissor,					COMMAND,	"ouuuu") \
+	OP(CMD_BIND_PIPELINE,				cmdBindPipeline,				COMMAND,	"oo") \
+	OP(CMD_BIND_DESCRIPTORS,			cmdBindDescriptors,				COMMAND,	"oo[suuu[o]b]") \
+	OP(CMD_BIND_INDEX_BUFFER,			cmdBindIndexBuffer,				COMMAND,	"oo") \
+	OP(CMD_BIND_VERTEX_BUFFER,			cmdBindVertexBuffer,			COMMAND,	"o[o]") \
+	OP(CMD_DRAW,						cmdDraw,						COMMAND,	"ouu") \
+	OP(CMD_DRAW_INSTANCED,				cmdDrawInstanced,				COMMAND,	"ouuu") \
+	OP(CMD_DRAW_INDEXED,				cmdDrawIndexed,					COMMAND,	"ouu") \
+	OP(CMD_DRAW_INDEXED_INSTANCED,		cmdDrawIndexedInstanced,		COMMAND,	"ouuu") \
+	OP(CMD_DISPATCH,					cmdDispatch,					COMMAND,	"ouuu") \
+	OP(CMD_RESOURCE_BARRIER,			cmdResourceBarrier,				COMMAND,	"o[ouu][ouu]u") \
+	OP(CMD_SYNCHRONIZE_RESOURCES,		cmdSynchronizeResources,		COMMAND,	"o[o][o]u") \
+	OP(CMD_FLUSH_BARRIERS,				cmdFlushBarriers,				COMMAND,	"o") \
+	OP(CMD_UPDATE_BUFFER,				cmdUpdateBuffer,				COMMAND,	"ouuuoo") \
+	OP(CMD_UPDATE_SUBRESOURCES,			cmdUpdateSubresources,			COMMAND,	"ou[uuuuuuuuuu]ouo") \
+	OP(CMD_BEGIN_QUERY,					cmdBeginQuery,					COMMAND,	"oou") \
+	OP(CMD_END_QUERY,					cmdEndQuery,					COMMAND,	"oou") \
+	OP(CMD_RESOLVE_QUERY,				cmdResolveQuery,				COMMAND,	"ooouu") \
+	OP(CMD_EXECUTE_INDIRECT,			cmdExecuteIndirect,				COMMAND,	"oououou") \
+	OP(CMD_BEGIN_DEBUG_MARKER,			cmdBeginDebugMarker,			COMMAND,	"offfs") \
+	OP(CMD_END_DEBUG_MARKER,			cmdEndDebugMarker,				COMMAND,	"o") \
+	OP(CMD_ADD_DEBUG_MARKER,			cmdAddDebugMarker,				COMMAND,	"offfs") \
+	OP(ACQUIRE_NEXT_IMAGE,				acquireNextImage,				QUEUE,		"oooou") \
+	OP(QUEUE_SUBMIT,					queueSubmit,					QUEUE,		"o[o]o[o][o]") \
+	OP(QUEUE_PRESENT,					queuePresent,					QUEUE,		"oou[o]") \
+	OP(WAIT_FOR_FENCES,					waitForFences,					QUEUE,		"o[o]") \
+	OP(GET_FENCE_STATUS,				getFenceStatus,					QUEUE,		"ou")
+
+#define COMMAND_CAPTURE_OP_ENUM(op, call, category, signature) CAPTURE_OP_##op,
+typedef enum CaptureOp
+{
+	COMMAND_CAPTURE_OPS(COMMAND_CAPTURE_OP_ENUM)
+	CAPTURE_OP_COUNT,
+} CaptureOp;
+#undef COMMAND_CAPTURE_OP_ENUM
+
+typedef struct CaptureOpInfo
+{
+	const char*		pName;
+	CaptureCategory	mCategory;
+	const char*		pSignature;
+} CaptureOpInfo;
+
+#define COMMAND_CAPTURE_OP_INFO(op, call, category, signature) { #call, CAPTURE_CATEGORY_##category, signature },
+static const CaptureOpInfo gCaptureOps[CAPTURE_OP_COUNT] =
+{
+	COMMAND_CAPTURE_OPS(COMMAND_CAPTURE_OP_INFO)
+};
+#undef COMMAND_CAPTURE_OP_INFO
+
+static inline uint64_t pointerKey(const void* ptr)
+{
+	return (uint64_t)(uintptr_t)ptr;
+}
+
+// Root constant sizes are reflected as a dword count on D3D12 and in bytes everywhere else
+static uint32_t getRootConstantSize(const DescriptorInfo* pDesc)
+{
+#if defined(DIRECT3D12)
+	return pDesc->mDesc.size * sizeof(uint32_t);
+#else
+	return pDesc->mDesc.size;
+#endif
+}
+
+// Vulkan and the null backend return the start of the range from mapBuffer, D3D12 and Metal the start of the buffer
+static void getMappedRange(const Buffer* pBuffer, const ReadRange* pRange, uint64_t* pBegin, uint64_t* pEnd)
+{
+#if defined(VULKAN) || defined(NULL_RENDERER)
+	if (pRange)
+	{
+		*pBegin = pRange->mOffset;
+		*pEnd = pRange->mOffset + pRange->mSize;
+		return;
+	}
+#else
+	UNREF_PARAM(pRange);
+#endif
+	*pBegin = 0;
+	*pEnd = pBuffer->mDesc.mSize;
+}
+
+static const DescriptorInfo* findDescriptor(const RootSignature* pRootSignature, const DescriptorData* pParam)
+{
+	if (!pRootSignature)
+		return NULL;
+
+	uint32_t index = pParam->mIndex;
+	if (index == (uint32_t)-1 && pParam->pName)
+	{
+		tinystl::unordered_map<uint32_t, uint32_t>::const_iterator it = pRootSignature->pDescriptorNameToIndexMap.find(tinystl::hash(pParam->pName));
+		if (it.node)
+			index = it.node->second;
+	}
+
+	return index < pRootSignature->mDescriptorCount ? &pRootSignature->pDescriptors[index] : NULL;
+}
+/************************************************************************/
+// Capture state
+/************************************************************************/
+typedef struct CapturedBuffer
+{
+	Buffer*		pBuffer;
+	uint32_t	mId;
+	/// Buffer range accessible through pCpuMappedAddress, empty while the buffer is not mapped
+	uint64_t	mMappedBegin;
+	uint64_t	mMappedEnd;
+	uint32_t	mPageCount;
+	/// Hash of each page as last written to the file, 0 if the page was never captured
+	uint64_t*	pPageHashes;
+} CapturedBuffer;
+
+typedef struct ObjectIdOverride
+{
+	uint64_t	mKey;
+	uint32_t	mId;
+} ObjectIdOverride;
+
+typedef struct CommandCapture
+{
+	Mutex										mMutex;
+	File										mFile;
+	/// Records not written to the file yet
+	tinystl::vector<uint8_t>					mData;
+	size_t										mRecordStart;
+	uint32_t									mNextId;
+	tinystl::unordered_map<uint64_t, uint32_t>	mIds;
+	/// Ids hidden by an add call returning an existing object (e.g. a deduplicated pipeline), restored on remove
+	tinystl::vector<ObjectIdOverride>			mHiddenIds;
+	tinystl::vector<CapturedBuffer>				mBuffers;
+	uint32_t									mUnknownObjectCount;
+	bool										mWriteFailed;
+} CommandCapture;
+
+static CommandCapture* pCommandCapture = NULL;
+
+static void flushCapture(CommandCapture* pCapture)
+{
+	if (pCapture->mData.empty())
+		return;
+
+	unsigned size = (unsigned)pCapture->mData.size();
+	if (pCapture->mFile.Write(pCapture->mData.data(), size) != size && !pCapture->mWriteFailed)
+	{
+		LOGERRORF("Failed to write command capture %s", pCapture->mFile.GetName().c_str());
+		pCapture->mWriteFailed = true;
+	}
+	pCapture->mData.clear();
+}
+/************************************************************************/
+// Record writing (caller holds mMutex)
+/************************************************************************/
+static void writeBytes(const void* pData, size_t size)
+{
+	if (!size)
+		return;
+	tinystl::vector<uint8_t>& data = pCommandCapture->mData;
+	size_t offset = data.size();
+	data.resize(offset + size);
+	memcpy(data.data() + offset, pData, size);
+}
+
+static void writeU(uint64_t value)
+{
+	uint8_t bytes[10];
+	uint32_t count = 0;
+	while (value >= 0x80)
+	{
+		bytes[count++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	bytes[count++] = (uint8_t)value;
+	writeBytes(bytes, count);
+}
+
+static void writeI(int64_t value)
+{
+	writeU(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+static void writeF(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	uint8_t bytes[4] = { (uint8_t)bits, (uint8_t)(bits >> 8), (uint8_t)(bits >> 16), (uint8_t)(bits >> 24) };
+	writeBytes(bytes, sizeof(bytes));
+}
+
+static void writeClearValue(const ClearValue& value)
+{
+	writeF(value.r);
+	writeF(value.g);
+	writeF(value.b);
+	writeF(value.a);
+}
+
+static void writeS(const char* pString, size_t length)
+{
+	if (!pString)
+	{
+		writeU(0);
+		return;
+	}
+	writeU(length + 1);
+	writeBytes(pString, length);
+	writeBytes("", 1);
+}
+
+static void writeS(const char* pString)
+{
+	writeS(pString, pString ? strlen(pString) : 0);
+}
+
+static void writeS(const tinystl::string& string)
+{
+	writeS(string.c_str(), string.size());
+}
+
+static void writeB(const void* pData, size_t size)
+{
+	writeU(pData ? size : 0);
+	if (pData)
+		writeBytes(pData, size);
+}
+
+static uint32_t getObjectId(const void* pObject)
+{
+	if (!pObject)
+		return 0;
+
+	tinystl::unordered_map<uint64_t, uint32_t>::const_iterator it = pCommandCapture->mIds.find(pointerKey(pObject));
+	if (it.node)
+		return it.node->second;
+
+	// Created before the capture started or outside of the API
+	if (!pCommandCapture->mUnknownObjectCount++)
+		LOGWARNING("Command capture references objects created before beginCommandCapture, they are replayed as NULL");
+	return 0;
+}
+
+static void writeObject(const void* pObject)
+{
+	writeU(getObjectId(pObject));
+}
+
+static void writeNewObject(const void* pObject)
+{
+	if (!pObject)
+	{
+		writeU(0);
+		return;
+	}
+
+	uint64_t key = pointerKey(pObject);
+	tinystl::unordered_map<uint64_t, uint32_t>::iterator it = pCommandCapture->mIds.find(key);
+	if (it.node)
+	{
+		pCommandCapture->mHiddenIds.push_back({ key, it.node->second });
+		it.node->second = pCommandCapture->mNextId;
+	}
+	else
+	{
+		pCommandCapture->mIds.insert({ key, pCommandCapture->mNextId });
+	}
+	writeU(pCommandCapture->mNextId++);
+}
+
+static void releaseObject(const void* pObject)
+{
+	if (!pObject)
+		return;
+
+	uint64_t key = pointerKey(pObject);
+	tinystl::unordered_map<uint64_t, uint32_t>::iterator it = pCommandCapture->mIds.find(key);
+	if (!it.node)
+		return;
+
+	tinystl::vector<ObjectIdOverride>& hidden = pCommandCapture->mHiddenIds;
+	for (size_t i = hidden.size(); i-- > 0;)
+	{
+		if (hidden[i].mKey == key)
+		{
+			it.node->second = hidden[i].mId;
+			hidden.erase(hidden.begin() + i);
+			return;
+		}
+	}
+	pCommandCapture->mIds.erase(it);
+}
+
+static void beginRecord(CaptureOp op)
+{
+	tinystl::vector<uint8_t>& data = pCommandCapture->mData;
+	pCommandCapture->mRecordStart = data.size();
+	data.resize(data.size() + COMMAND_CAPTURE_RECORD_HEADER_SIZE);
+	data[pCommandCapture->mRecordStart] = (uint8_t)op;
+}
+
+static void endRecord()
+{
+	tinystl::vector<uint8_t>& data = pCommandCapture->mData;
+	size_t start = pCommandCapture->mRecordStart;
+	uint32_t size = (uint32_t)(data.size() - start - COMMAND_CAPTURE_RECORD_HEADER_SIZE);
+	for (uint32_t i = 0; i < 4; ++i)
+		data[start + 1 + i] = (uint8_t)(size >> (i * 8));
+
+	if (data.size() >= COMMAND_CAPTURE_FLUSH_SIZE)
+		flushCapture(pCommandCapture);
+}
+
+// Holds the capture lock for the lifetime of one record
+struct CaptureRecord
+{
+	CaptureRecord(CaptureOp op) : mLock(pCommandCapture->mMutex) { beginRecord(op); }
+	~CaptureRecord() { endRecord(); }
+
+	MutexLock mLock;
+};
+/************************************************************************/
+// CPU visible buffer contents
+/************************************************************************/
+static CapturedBuffer* findCapturedBuffer(const Buffer* pBuffer)
+{
+	for (uint32_t i = 0; i < (uint32_t)pCommandCapture->mBuffers.size(); ++i)
+		if (pCommandCapture->mBuffers[i].pBuffer == pBuffer)
+			return &pCommandCapture->mBuffers[i];
+	return NULL;
+}
+
+static void writeBufferData(const CapturedBuffer* pBuffer, uint64_t begin, uint64_t end)
+{
+	beginRecord(CAPTURE_OP_BUFFER_DATA);
+	writeU(pBuffer->mId);
+	writeU(begin);
+	writeB((const uint8_t*)pBuffer->pBuffer->pCpuMappedAddress + (begin - pBuffer->mMappedBegin), (size_t)(end - begin));
+	endRecord();
+}
+
+// Writes the pages that changed since they were last captured as BUFFER_DATA records, coalescing adjacent pages.
+// Pages that were never captured and are still zero are skipped, fresh allocations are zero on replay as well.
+static void captureBufferContents(CapturedBuffer* pBuffer)
+{
+	const uint8_t* pMapped = (const uint8_t*)pBuffer->pBuffer->pCpuMappedAddress;
+	if (!pMapped || pBuffer->mMappedBegin >= pBuffer->mMappedEnd)
+		return;
+
+	static const uint8_t zeroPage[COMMAND_CAPTURE_PAGE_SIZE] = {};
+	uint64_t runBegin = 0;
+	uint64_t runEnd = 0;
+	for (uint64_t page = pBuffer->mMappedBegin / COMMAND_CAPTURE_PAGE_SIZE; page < pBuffer->mPageCount; ++page)
+	{
+		uint64_t begin = max(page * COMMAND_CAPTURE_PAGE_SIZE, pBuffer->mMappedBegin);
+		uint64_t end = min((page + 1) * COMMAND_CAPTURE_PAGE_SIZE, pBuffer->mMappedEnd);
+		if (begin >= end)
+			break;
+
+		const uint8_t* pPage = pMapped + (begin - pBuffer->mMappedBegin);
+		uint64_t hash = XXHash64(pPage, (size_t)(end - begin)) | 1;
+		uint64_t previous = pBuffer->pPageHashes[page];
+		bool changed = previous ? previous != hash : memcmp(pPage, zeroPage, (size_t)(end - begin)) != 0;
+		if (changed)
+		{
+			pBuffer->pPageHashes[page] = hash;
+			if (runEnd != begin)
+			{
+				if (runEnd > runBegin)
+					writeBufferData(pBuffer, runBegin, runEnd);
+				runBegin = begin;
+			}
+			runEnd = end;
+		}
+	}
+
+	if (runEnd > runBegin)
+		writeBufferData(pBuffer, runBegin, runEnd);
+}
+
+static void trackBuffer(Buffer* pBuffer)
+{
+	ResourceMemoryUsage usage = pBuffer->mDesc.mMemoryUsage;
+	// Readback buffers are written by the GPU, nothing to restore on replay
+	if (usage != RESOURCE_MEMORY_USAGE_CPU_ONLY && usage != RESOURCE_MEMORY_USAGE_CPU_TO_GPU)
+		return;
+
+	CapturedBuffer buffer = {};
+	buffer.pBuffer = pBuffer;
+	buffer.mId = getObjectId(pBuffer);
+	// Persistently mapped buffers are accessible right after creation
+	if (pBuffer->pCpuMappedAddress)
+		getMappedRange(pBuffer, NULL, &buffer.mMappedBegin, &buffer.mMappedEnd);
+	buffer.mPageCount = (uint32_t)((pBuffer->mDesc.mSize + COMMAND_CAPTURE_PAGE_SIZE - 1) / COMMAND_CAPTURE_PAGE_SIZE);
+	buffer.pPageHashes = (uint64_t*)conf_calloc(max(buffer.mPageCount, 1U), sizeof(uint64_t));
+	pCommandCapture->mBuffers.push_back(buffer);
+}
+
+static void untrackBuffer(const Buffer* pBuffer)
+{
+	tinystl::vector<CapturedBuffer>& buffers = pCommandCapture->mBuffers;
+	for (uint32_t i = 0; i < (uint32_t)buffers.size(); ++i)
+	{
+		if (buffers[i].pBuffer == pBuffer)
+		{
+			conf_free(buffers[i].pPageHashes);
+			buffers[i] = buffers.back();
+			buffers.pop_back();
+			return;
+		}
+	}
+}
+/************************************************************************/
+// Capture interface
+/************************************************************************/
+void beginCommandCapture(const char* pFileName, FSRoot root)
+{
+	ASSERT(pFileName);
+	if (pCommandCapture)
+	{
+		LOGWARNING("beginCommandCapture called while a capture is active");
+		return;
+	}
+
+	CommandCapture* pCapture = conf_placement_new<CommandCapture>(conf_calloc(1, sizeof(CommandCapture)));
+	if (!pCapture->mFile.Open(pFileName, FM_WriteBinary, root))
+	{
+		LOGERRORF("Could not open command capture file %s", pFileName);
+		pCapture->~CommandCapture();
+		conf_free(pCapture);
+		return;
+	}
+
+	pCapture->mNextId = 1;
+	uint32_t header[2] = { COMMAND_CAPTURE_MAGIC, COMMAND_CAPTURE_VERSION };
+	pCapture->mData.resize(sizeof(header));
+	memcpy(pCapture->mData.data(), header, sizeof(header));
+	pCommandCapture = pCapture;
+	LOGINFOF("Command capture started: %s", pFileName);
+}
+
+void endCommandCapture()
+{
+	CommandCapture* pCapture = pCommandCapture;
+	if (!pCapture)
+		return;
+
+	{
+		MutexLock lock(pCapture->mMutex);
+		flushCapture(pCapture);
+		pCapture->mFile.Close();
+		pCommandCapture = NULL;
+	}
+
+	for (uint32_t i = 0; i < (uint32_t)pCapture->mBuffers.size(); ++i)
+		conf_free(pCapture->mBuffers[i].pPageHashes);
+	pCapture->~CommandCapture();
+	conf_free(pCapture);
+	LOGINFO("Command capture finished");
+}
+
+bool isCommandCaptureActive()
+{
+	return pCommandCapture != NULL;
+}
+/************************************************************************/
+// Capture wrappers
+/************************************************************************/
+// Stages in ShaderDesc member order. Files store the index as the stage bits differ on Metal
+static const ShaderStage gShaderStages[] =
+{
+	SHADER_STAGE_VERT,
+	SHADER_STAGE_FRAG,
+#if defined(METAL)
+	SHADER_STAGE_NONE,
+	SHADER_STAGE_NONE,
+	SHADER_STAGE_NONE,
+#else
+	SHADER_STAGE_GEOM,
+	SHADER_STAGE_HULL,
+	SHADER_STAGE_DOMN,
+#endif
+	SHADER_STAGE_COMP,
+};
+#define SHADER_DESC_STAGE_COUNT (uint32_t)(sizeof(gShaderStages) / sizeof(gShaderStages[0]))
+
+static ShaderStageDesc* getShaderStageDesc(ShaderDesc* pDesc, uint32_t index)
+{
+	ShaderStageDesc* pStages[SHADER_DESC_STAGE_COUNT] = { &pDesc->mVert, &pDesc->mFrag, &pDesc->mGeom, &pDesc->mHull, &pDesc->mDomain, &pDesc->mComp };
+	return pStages[index];
+}
+
+static int compareStrings(const void* pLhs, const void* pRhs)
+{
+	return strcmp(*(const char* const*)pLhs, *(const char* const*)pRhs);
+}
+
+static void writeDebugMarker(CaptureOp op, Cmd* pCmd, float r, float g, float b, const char* pName)
+{
+	CaptureRecord record(op);
+	writeObject(pCmd);
+	writeF(r);
+	writeF(g);
+	writeF(b);
+	writeS(pName);
+}
+
+// Each wrapper has the name of the API function it records (see CommandCaptureLayer.h) and forwards the call to the
+// backend through the global namespace (::). Object creation is recorded after the backend call so the new object
+// can be given its id, everything else is recorded before it is forwarded.
+namespace CommandCaptureLayer {
+
+void initRenderer(const char* app_name, const RendererDesc* p_settings, Renderer** ppRenderer)
+{
+	::initRenderer(app_name, p_settings, ppRenderer);
+	if (!pCommandCapture)
+		return;
+
+	Renderer* pRenderer = *ppRenderer;
+	CaptureRecord record(CAPTURE_OP_INIT_RENDERER);
+	writeS(app_name);
+	writeU(p_settings->mShaderTarget);
+	writeNewObject(pRenderer);
+	writeNewObject(pRenderer ? pRenderer->pDefaultBlendState : NULL);
+	writeNewObject(pRenderer ? pRenderer->pDefaultDepthState : NULL);
+	writeNewObject(pRenderer ? pRenderer->pDefaultRasterizerState : NULL);
+}
+
+void removeRenderer(Renderer* pRenderer)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_RENDERER);
+		writeObject(pRenderer);
+		releaseObject(pRenderer->pDefaultBlendState);
+		releaseObject(pRenderer->pDefaultDepthState);
+		releaseObject(pRenderer->pDefaultRasterizerState);
+		releaseObject(pRenderer);
+	}
+	::removeRenderer(pRenderer);
+}
+
+void addFence(Renderer* pRenderer, Fence** pp_fence, uint64 mFenceValue)
+{
+	::addFence(pRenderer, pp_fence, mFenceValue);
+	if (!pCommandCapture)
+		return;
+
+	CaptureRecord record(CAPTURE_OP_ADD_FENCE);
+	writeObject(pRenderer);
+	writeU(mFenceValue);
+	writeNewObject(*pp_fence);
+}
+
+void removeFence(Renderer* pRenderer, Fence* p_fence)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_FENCE);
+		writeObject(pRenderer);
+		writeObject(p_fence);
+		releaseObject(p_fence);
+	}
+	::removeFence(pRenderer, p_fence);
+}
+
+void addSemaphore(Renderer* pRenderer, Semaphore** pp_semaphore)
+{
+	::addSemaphore(pRenderer, pp_semaphore);
+	if (!pCommandCapture)
+		return;
+
+	CaptureRecord record(CAPTURE_OP_ADD_SEMAPHORE);
+	writeObject(pRenderer);
+	writeNewObject(*pp_semaphore);
+}
+
+void removeSemaphore(Renderer* pRenderer, Semaphore* p_semaphore)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_SEMAPHORE);
+		writeObject(pRenderer);
+		writeObject(p_semaphore);
+		releaseObject(p_semaphore);
+	}
+	::removeSemaphore(pRenderer, p_semaphore);
+}
+
+void addQueue(Renderer* pRenderer, QueueDesc* pQDesc, Queue** ppQueue)
+{
+	::addQueue(pRenderer, pQDesc, ppQueue);
+	if (!pCommandCapture)
+		return;
+
+	CaptureRecord record(CAPTURE_OP_ADD_QUEUE);
+	writeObject(pRenderer);
+	writeU(pQDesc->mFlag);
+	writeU(pQDesc->mPriority);
+	writeU(pQDesc->mType);
+	writeNewObject(*ppQueue);
+}
+
+void removeQueue(Queue* pQueue)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_QUEUE);
+		writeObject(pQueue);
+		releaseObject(pQueue);
+	}
+	::removeQueue(pQueue);
+}
+
+void addSwapChain(Renderer* pRenderer, const SwapChainDesc* p_desc, SwapChain** pp_swap_chain)
+{
+	::addSwapChain(pRenderer, p_desc, pp_swap_chain);
+	if (!pCommandCapture)
+		return;
+
+	SwapChain* pSwapChain = *pp_swap_chain;
+	CaptureRecord record(CAPTURE_OP_ADD_SWAP_CHAIN);
+	// The window handle is supplied by the replay
+	writeObject(pRenderer);
+	writeObject(p_desc->pQueue);
+	writeU(p_desc->mImageCount);
+	writeU(p_desc->mWidth);
+	writeU(p_desc->mHeight);
+	writeU(p_desc->mSampleCount);
+	writeU(p_desc->mSampleQuality);
+	writeU(p_desc->mColorFormat);
+	writeClearValue(p_desc->mColorClearValue);
+	writeU(p_desc->mSrgb);
+	writeU(p_desc->mEnableVsync);
+	writeNewObject(pSwapChain);
+	uint32_t imageCount = pSwapChain ? pSwapChain->mDesc.mImageCount : 0;
+	writeU(imageCount);
+	for (uint32_t i = 0; i < imageCount; ++i)
+	{
+		writeNewObject(pSwapChain->ppSwapchainRenderTargets[i]);
+		writeNewObject(pSwapChain->ppSwapchainRenderTargets[i]->pTexture);
+	}
+}
+
+void removeSwapChain(Renderer* pRenderer, SwapChain* p_swap_chain)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_SWAP_CHAIN);
+		writeObject(pRenderer);
+		writeObject(p_swap_chain);
+		for (uint32_t i = 0; i < p_swap_chain->mDesc.mImageCount; ++i)
+		{
+			releaseObject(p_swap_chain->ppSwapchainRenderTargets[i]->pTexture);
+			releaseObject(p_swap_chain->ppSwapchainRenderTargets[i]);
+		}
+		releaseObject(p_swap_chain);
+	}
+	::removeSwapChain(pRenderer, p_swap_chain);
+}
+
+void addCmdPool(Renderer* pRenderer, Queue* p_queue, bool transient, CmdPool** pp_CmdPool, CmdPoolDesc* cmdPoolDesc)
+{
+	::addCmdPool(pRenderer, p_queue, transient, pp_CmdPool, cmdPoolDesc);
+	if (!pCommandCapture)
+		return;
+
+	CaptureRecord record(CAPTURE_OP_ADD_CMD_POOL);
+	writeObject(pRenderer);
+	writeObject(p_queue);
+	writeU(transient);
+	writeU(cmdPoolDesc ? 1 : 0);
+	if (cmdPoolDesc)
+		writeU(cmdPoolDesc->mCmdPoolType);
+	writeNewObject(*pp_CmdPool);
+}
+
+void removeCmdPool(Renderer* pRenderer, CmdPool* p_CmdPool)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_CMD_POOL);
+		writeObject(pRenderer);
+		writeObject(p_CmdPool);
+		releaseObject(p_CmdPool);
+	}
+	::removeCmdPool(pRenderer, p_CmdPool);
+}
+
+void addCmd(CmdPool* p_CmdPool, bool secondary, Cmd** pp_cmd)
+{
+	::addCmd(p_CmdPool, secondary, pp_cmd);
+	if (!pCommandCapture)
+		return;
+
+	CaptureRecord record(CAPTURE_OP_ADD_CMD);
+	writeObject(p_CmdPool);
+	writeU(secondary);
+	writeNewObject(*pp_cmd);
+}
+
+void removeCmd(CmdPool* p_CmdPool, Cmd* p_cmd)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_CMD);
+		writeObject(p_CmdPool);
+		writeObject(p_cmd);
+		releaseObject(p_cmd);
+	}
+	::removeCmd(p_CmdPool, p_cmd);
+}
+
+void addCmd_n(CmdPool* p_CmdPool, bool secondary, uint32_t cmd_count, Cmd*** ppp_cmd)
+{
+	::addCmd_n(p_CmdPool, secondary, cmd_count, ppp_cmd);
+	if (!pCommandCapture)
+		return;
+
+	// The array itself gets an id as removeCmd_n has to be handed the same array on replay
+	Cmd** ppCmds = *ppp_cmd;
+	CaptureRecord record(CAPTURE_OP_ADD_CMD_N);
+	writeObject(p_CmdPool);
+	writeU(secondary);
+	writeNewObject(ppCmds);
+	writeU(cmd_count);
+	for (uint32_t i = 0; i < cmd_count; ++i)
+		writeNewObject(ppCmds[i]);
+}
+
+void removeCmd_n(CmdPool* p_CmdPool, uint32_t cmd_count, Cmd** pp_cmd)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_CMD_N);
+		writeObject(p_CmdPool);
+		writeObject(pp_cmd);
+		writeU(cmd_count);
+		for (uint32_t i = 0; i < cmd_count; ++i)
+		{
+			writeObject(pp_cmd[i]);
+			releaseObject(pp_cmd[i]);
+		}
+		releaseObject(pp_cmd);
+	}
+	::removeCmd_n(p_CmdPool, cmd_count, pp_cmd);
+}
+
+void addRenderTarget(Renderer* pRenderer, const RenderTargetDesc* p_desc, RenderTarget** pp_render_target, void* pNativeHandle)
+{
+	::addRenderTarget(pRenderer, p_desc, pp_render_target, pNativeHandle);
+	if (!pCommandCapture)
+		return;
+
+	// Native handles cannot be replayed, the render target is recreated from its description
+	RenderTarget* pRenderTarget = *pp_render_target;
+	CaptureRecord record(CAPTURE_OP_ADD_RENDER_TARGET);
+	writeObject(pRenderer);
+	writeU(p_desc->mType);
+	writeU(p_desc->mFlags);
+	writeU(p_desc->mWidth);
+	writeU(p_desc->mHeight);
+	writeU(p_desc->mDepth);
+	writeU(p_desc->mBaseArrayLayer);
+	writeU(p_desc->mArraySize);
+	writeU(p_desc->mBaseMipLevel);
+	writeU(p_desc->mSampleCount);
+	writeU(p_desc->mFormat);
+	writeClearValue(p_desc->mClearValue);
+	writeU(p_desc->mUsage);
+	writeU(p_desc->mSampleQuality);
+	writeU(p_desc->mSrgb);
+	writeNewObject(pRenderTarget);
+	writeNewObject(pRenderTarget ? pRenderTarget->pTexture : NULL);
+}
+
+void removeRenderTarget(Renderer* pRenderer, RenderTarget* p_render_target)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_RENDER_TARGET);
+		writeObject(pRenderer);
+		writeObject(p_render_target);
+		releaseObject(p_render_target->pTexture);
+		releaseObject(p_render_target);
+	}
+	::removeRenderTarget(pRenderer, p_render_target);
+}
+
+void addSampler(Renderer* pRenderer, Sampler** pp_sampler, FilterType minFilter, FilterType magFilter, MipMapMode mipMapMode,
+	AddressMode addressU, AddressMode addressV, AddressMode addressW, float mipLosBias, float maxAnisotropy)
+{
+	::addSampler(pRenderer, pp_sampler, minFilter, magFilter, mipMapMode, addressU, addressV, addressW, mipLosBias, maxAnisotropy);
+	if (!pCommandCapture)
+		return;
+
+	CaptureRecord record(CAPTURE_OP_ADD_SAMPLER);
+	writeObject(pRenderer);
+	writeU(minFilter);
+	writeU(magFilter);
+	writeU(mipMapMode);
+	writeU(addressU);
+	writeU(addressV);
+	writeU(addressW);
+	writeF(mipLosBias);
+	writeF(maxAnisotropy);
+	writeNewObject(*pp_sampler);
+}
+
+void removeSampler(Renderer* pRenderer, Sampler* p_sampler)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_SAMPLER);
+		writeObject(pRenderer);
+		writeObject(p_sampler);
+		releaseObject(p_sampler);
+	}
+	::removeSampler(pRenderer, p_sampler);
+}
+
+void addShader(Renderer* pRenderer, const ShaderDesc* p_desc, Shader** p_shader_program)
+{
+	::addShader(pRenderer, p_desc, p_shader_program);
+	if (!pCommandCapture)
+		return;
+
+	CaptureRecord record(CAPTURE_OP_ADD_SHADER);
+	writeObject(pRenderer);
+	uint32_t stageCount = 0;
+	for (uint32_t i = 0; i < SHADER_DESC_STAGE_COUNT; ++i)
+		stageCount += (p_desc->mStages & gShaderStages[i]) ? 1 : 0;
+	writeU(stageCount);
+	for (uint32_t i = 0; i < SHADER_DESC_STAGE_COUNT; ++i)
+	{
+		if (!(p_desc->mStages & gShaderStages[i]))
+			continue;
+
+		const ShaderStageDesc* pStage = getShaderStageDesc((ShaderDesc*)p_desc, i);
+		writeU(i);
+		writeS(pStage->mName);
+		writeB(pStage->mCode.c_str(), pStage->mCode.size());
+		writeS(pStage->mEntryPoint);
+		writeU(pStage->mMacros.size());
+		for (uint32_t m = 0; m < (uint32_t)pStage->mMacros.size(); ++m)
+		{
+			writeS(pStage->mMacros[m].definition);
+			writeS(pStage->mMacros[m].value);
+		}
+#if defined(VULKAN)
+		writeS(pStage->mCompileFlags);
+#else
+		writeS(NULL);
+#endif
+	}
+	writeNewObject(*p_shader_program);
+}
+
+void removeShader(Renderer* pRenderer, Shader* p_shader_program)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_SHADER);
+		writeObject(pRenderer);
+		writeObject(p_shader_program);
+		releaseObject(p_shader_program);
+	}
+	::removeShader(pRenderer, p_shader_program);
+}
+
+void addRootSignature(Renderer* pRenderer, uint32_t num_shaders, Shader* const* pp_shaders, RootSignature** pp_root_signature, const RootSignatureDesc* pRootDesc)
+{
+	::addRootSignature(pRenderer, num_shaders, pp_shaders, pp_root_signature, pRootDesc);
+	if (!pCommandCapture)
+		return;
+
+	CaptureRecord record(CAPTURE_OP_ADD_ROOT_SIGNATURE);
+	writeObject(pRenderer);
+	writeU(num_shaders);
+	for (uint32_t i = 0; i < num_shaders; ++i)
+		writeObject(pp_shaders[i]);
+	writeU(pRootDesc ? 1 : 0);
+	if (pRootDesc)
+	{
+		writeU(DESCRIPTOR_TYPE_COUNT);
+		for (uint32_t i = 0; i < DESCRIPTOR_TYPE_COUNT; ++i)
+			writeU(pRootDesc->mMaxBindlessDescriptors[i]);
+
+		// Hash map iteration order depends on the build, write the static samplers sorted by name
+		tinystl::vector<const char*> names;
+		for (tinystl::unordered_map<tinystl::string, Sampler*>::const_iterator it = pRootDesc->mStaticSamplers.begin(); it != pRootDesc->mStaticSamplers.end(); ++it)
+			names.push_back(it->first.c_str());
+		if (names.size() > 1)
+			qsort(names.data(), names.size(), sizeof(const char*), compareStrings);
+		writeU(names.size());
+		for (uint32_t i = 0; i < (uint32_t)names.size(); ++i)
+		{
+			writeS(names[i]);
+			writeObject(pRootDesc->mStaticSamplers.find(names[i]).node->second);
+		}
+#if defined(VULKAN)
+		writeU(pRootDesc->mDynamicUniformBuffers.size());
+		for (uint32_t i = 0; i < (uint32_t)pRootDesc->mDynamicUniformBuffers.size(); ++i)
+			writeS(pRootDesc->mDynamicUniformBuffers[i]);
+#else
+		writeU(0);
+#endif
+	}
+	writeNewObject(*pp_root_signature);
+}
+
+void removeRootSignature(Renderer* pRenderer, RootSignature* pRootSignature)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_ROOT_SIGNATURE);
+		writeObject(pRenderer);
+		writeObject(pRootSignature);
+		releaseObject(pRootSignature);
+	}
+	::removeRootSignature(pRenderer, pRootSignature);
+}
+
+void addPipeline(Renderer* pRenderer, const GraphicsPipelineDesc* p_pipeline_settings, Pipeline** pp_pipeline)
+{
+	::addPipeline(pRenderer, p_pipeline_settings, pp_pipeline);
+	if (!pCommandCapture)
+		return;
+
+	const GraphicsPipelineDesc* pDesc = p_pipeline_settings;
+	CaptureRecord record(CAPTURE_OP_ADD_PIPELINE);
+	writeObject(pRenderer);
+	writeObject(pDesc->pShaderProgram);
+	writeObject(pDesc->pRootSignature);
+	writeU(pDesc->pVertexLayout ? 1 : 0);
+	if (pDesc->pVertexLayout)
+	{
+		writeU(pDesc->pVertexLayout->mAttribCount);
+		for (uint32_t i = 0; i < pDesc->pVertexLayout->mAttribCount; ++i)
+		{
+			const VertexAttrib* pAttrib = &pDesc->pVertexLayout->mAttribs[i];
+			writeU(pAttrib->mSemantic);
+			writeS(pAttrib->mSemanticName, min(pAttrib->mSemanticNameLength, (uint32_t)MAX_SEMANTIC_NAME_LENGTH));
+			writeU(pAttrib->mFormat);
+			writeU(pAttrib->mBinding);
+			writeU(pAttrib->mLocation);
+			writeU(pAttrib->mOffset);
+		}
+	}
+	writeU(pDesc->mRenderTargetCount);
+	for (uint32_t i = 0; i < pDesc->mRenderTargetCount; ++i)
+		writeObject(pDesc->ppRenderTargets[i]);
+	writeObject(pDesc->pDepthStencil);
+	writeU(pDesc->mPrimitiveTopo);
+	writeObject(pDesc->pBlendState);
+	writeObject(pDesc->pDepthState);
+	writeObject(pDesc->pRasterizerState);
+	writeNewObject(*pp_pipeline);
+}
+
+void addComputePipeline(Renderer* pRenderer, const ComputePipelineDesc* p_pipeline_settings, Pipeline** p_pipeline)
+{
+	::addComputePipeline(pRenderer, p_pipeline_settings, p_pipeline);
+	if (!pCommandCapture)
+		return;
+
+	CaptureRecord record(CAPTURE_OP_ADD_COMPUTE_PIPELINE);
+	writeObject(pRenderer);
+	writeObject(p_pipeline_settings->pShaderProgram);
+	writeObject(p_pipeline_settings->pRootSignature);
+	writeNewObject(*p_pipeline);
+}
+
+void removePipeline(Renderer* pRenderer, Pipeline* p_pipeline)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_PIPELINE);
+		writeObject(pRenderer);
+		writeObject(p_pipeline);
+		releaseObject(p_pipeline);
+	}
+	::removePipeline(pRenderer, p_pipeline);
+}
+
+void addBlendState(BlendState** ppBlendState, BlendConstant srcFactor, BlendConstant destFactor, BlendConstant srcAlphaFactor,
+	BlendConstant destAlphaFactor, BlendMode blendMode, BlendMode blendAlphaMode, const int mask, const int MRTRenderTargetNumber, const bool alphaToCoverage)
+{
+	::addBlendState(ppBlendState, srcFactor, destFactor, srcAlphaFactor, destAlphaFactor, blendMode, blendAlphaMode, mask, MRTRenderTargetNumber, alphaToCoverage);
+	if (!pCommandCapture)
+		return;
+
+	CaptureRecord record(CAPTURE_OP_ADD_BLEND_STATE);
+	writeU(srcFactor);
+	writeU(destFactor);
+	writeU(srcAlphaFactor);
+	writeU(destAlphaFactor);
+	writeU(blendMode);
+	writeU(blendAlphaMode);
+	writeI(mask);
+	writeI(MRTRenderTargetNumber);
+	writeU(alphaToCoverage);
+	writeNewObject(*ppBlendState);
+}
+
+void removeBlendState(BlendState* pBlendState)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_BLEND_STATE);
+		writeObject(pBlendState);
+		releaseObject(pBlendState);
+	}
+	::removeBlendState(pBlendState);
+}
+
+void addDepthState(Renderer* pRenderer, DepthState** ppDepthState, const bool depthTest, const bool depthWrite,
+	const CompareMode depthFunc, const bool stencilTest, const uint8 stencilReadMask, const uint8 stencilWriteMask,
+	const CompareMode stencilFrontFunc, const StencilOp stencilFrontFail, const StencilOp depthFrontFail, const StencilOp stencilFrontPass,
+	const CompareMode stencilBackFunc, const StencilOp stencilBackFail, const StencilOp depthBackFail, const StencilOp stencilBackPass)
+{
+	::addDepthState(pRenderer, ppDepthState, depthTest, depthWrite, depthFunc, stencilTest, stencilReadMask, stencilWriteMask,
+		stencilFrontFunc, stencilFrontFail, depthFrontFail, stencilFrontPass, stencilBackFunc, stencilBackFail, depthBackFail, stencilBackPass);
+	if (!pCommandCapture)
+		return;
+
+	CaptureRecord record(CAPTURE_OP_ADD_DEPTH_STATE);
+	writeObject(pRenderer);
+	writeU(depthTest);
+	writeU(depthWrite);
+	writeU(depthFunc);
+	writeU(stencilTest);
+	writeU(stencilReadMask);
+	writeU(stencilWriteMask);
+	writeU(stencilFrontFunc);
+	writeU(stencilFrontFail);
+	writeU(depthFrontFail);
+	writeU(stencilFrontPass);
+	writeU(stencilBackFunc);
+	writeU(stencilBackFail);
+	writeU(depthBackFail);
+	writeU(stencilBackPass);
+	writeNewObject(*ppDepthState);
+}
+
+void removeDepthState(DepthState* pDepthState)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_DEPTH_STATE);
+		writeObject(pDepthState);
+		releaseObject(pDepthState);
+	}
+	::removeDepthState(pDepthState);
+}
+
+void addRasterizerState(RasterizerState** ppRasterizerState, const CullMode cullMode, const int depthBias,
+	const float slopeScaledDepthBias, const FillMode fillMode, const bool multiSample, const bool scissor)
+{
+	::addRasterizerState(ppRasterizerState, cullMode, depthBias, slopeScaledDepthBias, fillMode, multiSample, scissor);
+	if (!pCommandCapture)
+		return;
+
+	CaptureRecord record(CAPTURE_OP_ADD_RASTERIZER_STATE);
+	writeU(cullMode);
+	writeI(depthBias);
+	writeF(slopeScaledDepthBias);
+	writeU(fillMode);
+	writeU(multiSample);
+	writeU(scissor);
+	writeNewObject(*ppRasterizerState);
+}
+
+void removeRasterizerState(RasterizerState* pRasterizerState)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_RASTERIZER_STATE);
+		writeObject(pRasterizerState);
+		releaseObject(pRasterizerState);
+	}
+	::removeRasterizerState(pRasterizerState);
+}
+
+void addBuffer(Renderer* pRenderer, const BufferDesc* desc, Buffer** pp_buffer)
+{
+	::addBuffer(pRenderer, desc, pp_buffer);
+	if (!pCommandCapture)
+		return;
+
+	// Fields which do not apply to the usage are often left uninitialized by the application. They are written as 0
+	// so the capture only depends on what the backend reads.
+	bool cpuAccessible = desc->mMemoryUsage == RESOURCE_MEMORY_USAGE_CPU_ONLY || desc->mMemoryUsage == RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+	bool indexBuffer = (desc->mUsage & BUFFER_USAGE_INDEX) != 0;
+	bool vertexBuffer = (desc->mUsage & BUFFER_USAGE_VERTEX) != 0;
+	bool storageBuffer = (desc->mUsage & (BUFFER_USAGE_STORAGE_SRV | BUFFER_USAGE_STORAGE_UAV)) != 0;
+	CaptureRecord record(CAPTURE_OP_ADD_BUFFER);
+	writeObject(pRenderer);
+	writeU(desc->mUsage);
+	writeU(desc->mSize);
+	writeU(desc->mMemoryUsage);
+	writeU(desc->mFlags);
+	writeU(cpuAccessible ? 0 : desc->mStartState);
+	writeU(indexBuffer ? desc->mIndexType : 0);
+	writeU(vertexBuffer ? desc->mVertexStride : 0);
+	writeU(storageBuffer ? desc->mFirstElement : 0);
+	writeU(storageBuffer ? desc->mElementCount : 0);
+	writeU(storageBuffer ? desc->mStructStride : 0);
+	writeObject(storageBuffer ? desc->pCounterBuffer : NULL);
+	writeU(storageBuffer ? desc->mFormat : 0);
+	writeU(storageBuffer ? desc->mFeatures : 0);
+	writeNewObject(*pp_buffer);
+	if (*pp_buffer)
+		trackBuffer(*pp_buffer);
+}
+
+void removeBuffer(Renderer* pRenderer, Buffer* p_buffer)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_BUFFER);
+		writeObject(pRenderer);
+		writeObject(p_buffer);
+		untrackBuffer(p_buffer);
+		releaseObject(p_buffer);
+	}
+	::removeBuffer(pRenderer, p_buffer);
+}
+
+void mapBuffer(Renderer* pRenderer, Buffer* pBuffer, ReadRange* pRange)
+{
+	::mapBuffer(pRenderer, pBuffer, pRange);
+	if (!pCommandCapture)
+		return;
+
+	CaptureRecord record(CAPTURE_OP_MAP_BUFFER);
+	writeObject(pRenderer);
+	writeObject(pBuffer);
+	writeU(pRange ? 1 : 0);
+	if (pRange)
+	{
+		writeU(pRange->mOffset);
+		writeU(pRange->mSize);
+	}
+
+	CapturedBuffer* pCaptured = findCapturedBuffer(pBuffer);
+	if (pCaptured)
+		getMappedRange(pBuffer, pRange, &pCaptured->mMappedBegin, &pCaptured->mMappedEnd);
+}
+
+void unmapBuffer(Renderer* pRenderer, Buffer* pBuffer)
+{
+	if (pCommandCapture)
+	{
+		MutexLock lock(pCommandCapture->mMutex);
+		// Whatever was written through this mapping has to reach the file before the memory becomes inaccessible
+		CapturedBuffer* pCaptured = findCapturedBuffer(pBuffer);
+		if (pCaptured)
+		{
+			captureBufferContents(pCaptured);
+			pCaptured->mMappedBegin = pCaptured->mMappedEnd = 0;
+		}
+
+		beginRecord(CAPTURE_OP_UNMAP_BUFFER);
+		writeObject(pRenderer);
+		writeObject(pBuffer);
+		endRecord();
+	}
+	::unmapBuffer(pRenderer, pBuffer);
+}
+
+void addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** pp_texture)
+{
+	::addTexture(pRenderer, pDesc, pp_texture);
+	if (!pCommandCapture)
+		return;
+
+	// Textures are created from their description only, native handles are not replayed
+	CaptureRecord record(CAPTURE_OP_ADD_TEXTURE);
+	writeObject(pRenderer);
+	writeU(pDesc->mType);
+	writeU(pDesc->mFlags);
+	writeU(pDesc->mWidth);
+	writeU(pDesc->mHeight);
+	writeU(pDesc->mDepth);
+	writeU(pDesc->mBaseArrayLayer);
+	writeU(pDesc->mArraySize);
+	writeU(pDesc->mBaseMipLevel);
+	writeU(pDesc->mMipLevels);
+	writeU(pDesc->mSampleCount);
+	writeU(pDesc->mSampleQuality);
+	writeU(pDesc->mFormat);
+	writeClearValue(pDesc->mClearValue);
+	writeU(pDesc->mUsage);
+	writeU(pDesc->mStartState);
+	writeU(pDesc->mSrgb);
+	writeU(pDesc->mHostVisible);
+	writeNewObject(*pp_texture);
+}
+
+void removeTexture(Renderer* pRenderer, Texture* p_texture)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_TEXTURE);
+		writeObject(pRenderer);
+		writeObject(p_texture);
+		releaseObject(p_texture);
+	}
+	::removeTexture(pRenderer, p_texture);
+}
+
+void addQueryHeap(Renderer* pRenderer, const QueryHeapDesc* pDesc, QueryHeap** ppQueryHeap)
+{
+	::addQueryHeap(pRenderer, pDesc, ppQueryHeap);
+	if (!pCommandCapture)
+		return;
+
+	CaptureRecord record(CAPTURE_OP_ADD_QUERY_HEAP);
+	writeObject(pRenderer);
+	writeU(pDesc->mType);
+	writeU(pDesc->mQueryCount);
+	writeNewObject(*ppQueryHeap);
+}
+
+void removeQueryHeap(Renderer* pRenderer, QueryHeap* pQueryHeap)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_QUERY_HEAP);
+		writeObject(pRenderer);
+		writeObject(pQueryHeap);
+		releaseObject(pQueryHeap);
+	}
+	::removeQueryHeap(pRenderer, pQueryHeap);
+}
+
+void addIndirectCommandSignature(Renderer* pRenderer, const CommandSignatureDesc* p_desc, CommandSignature** ppCommandSignature)
+{
+	::addIndirectCommandSignature(pRenderer, p_desc, ppCommandSignature);
+	if (!pCommandCapture)
+		return;
+
+	CaptureRecord record(CAPTURE_OP_ADD_INDIRECT_COMMAND_SIGNATURE);
+	writeObject(pRenderer);
+	writeObject(p_desc->pCmdPool);
+	writeObject(p_desc->pRootSignature);
+	writeU(p_desc->mIndirectArgCount);
+	for (uint32_t i = 0; i < p_desc->mIndirectArgCount; ++i)
+	{
+		writeU(p_desc->pArgDescs[i].mType);
+		writeU(p_desc->pArgDescs[i].mRootParameterIndex);
+		writeU(p_desc->pArgDescs[i].mCount);
+		writeU(p_desc->pArgDescs[i].mDivisor);
+	}
+	writeNewObject(*ppCommandSignature);
+}
+
+void removeIndirectCommandSignature(Renderer* pRenderer, CommandSignature* pCommandSignature)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_REMOVE_INDIRECT_COMMAND_SIGNATURE);
+		writeObject(pRenderer);
+		writeObject(pCommandSignature);
+		releaseObject(pCommandSignature);
+	}
+	::removeIndirectCommandSignature(pRenderer, pCommandSignature);
+}
+
+void beginCmd(Cmd* p_cmd)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_BEGIN_CMD);
+		writeObject(p_cmd);
+	}
+	::beginCmd(p_cmd);
+}
+
+void endCmd(Cmd* p_cmd)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_END_CMD);
+		writeObject(p_cmd);
+	}
+	::endCmd(p_cmd);
+}
+
+void cmdBeginRender(Cmd* p_cmd, uint32_t render_target_count, RenderTarget** pp_render_targets, RenderTarget* p_depth_stencil, const LoadActionsDesc* loadActions)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_BEGIN_RENDER);
+		writeObject(p_cmd);
+		writeU(render_target_count);
+		for (uint32_t i = 0; i < render_target_count; ++i)
+			writeObject(pp_render_targets[i]);
+		writeObject(p_depth_stencil);
+		writeU(loadActions ? 1 : 0);
+		if (loadActions)
+		{
+			writeU(MAX_RENDER_TARGET_ATTACHMENTS);
+			for (uint32_t i = 0; i < MAX_RENDER_TARGET_ATTACHMENTS; ++i)
+			{
+				writeClearValue(loadActions->mClearColorValues[i]);
+				writeU(loadActions->mLoadActionsColor[i]);
+			}
+			writeClearValue(loadActions->mClearDepth);
+			writeU(loadActions->mLoadActionDepth);
+			writeU(loadActions->mLoadActionStencil);
+		}
+	}
+	::cmdBeginRender(p_cmd, render_target_count, pp_render_targets, p_depth_stencil, loadActions);
+}
+
+void cmdEndRender(Cmd* p_cmd, uint32_t render_target_count, RenderTarget** pp_render_targets, RenderTarget* p_depth_stencil)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_END_RENDER);
+		writeObject(p_cmd);
+		writeU(render_target_count);
+		for (uint32_t i = 0; i < render_target_count; ++i)
+			writeObject(pp_render_targets[i]);
+		writeObject(p_depth_stencil);
+	}
+	::cmdEndRender(p_cmd, render_target_count, pp_render_targets, p_depth_stencil);
+}
+
+void cmdSetViewport(Cmd* p_cmd, float x, float y, float width, float height, float min_depth, float max_depth)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_SET_VIEWPORT);
+		writeObject(p_cmd);
+		writeF(x);
+		writeF(y);
+		writeF(width);
+		writeF(height);
+		writeF(min_depth);
+		writeF(max_depth);
+	}
+	::cmdSetViewport(p_cmd, x, y, width, height, min_depth, max_depth);
+}
+
+void cmdSetScissor(Cmd* p_cmd, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_SET_SCISSOR);
+		writeObject(p_cmd);
+		writeU(x);
+		writeU(y);
+		writeU(width);
+		writeU(height);
+	}
+	::cmdSetScissor(p_cmd, x, y, width, height);
+}
+
+void cmdBindPipeline(Cmd* p_cmd, Pipeline* p_pipeline)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_BIND_PIPELINE);
+		writeObject(p_cmd);
+		writeObject(p_pipeline);
+	}
+	::cmdBindPipeline(p_cmd, p_pipeline);
+}
+
+void cmdBindDescriptors(Cmd* pCmd, RootSignature* pRootSignature, uint32_t numDescriptors, DescriptorData* pDescParams)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_BIND_DESCRIPTORS);
+		writeObject(pCmd);
+		writeObject(pRootSignature);
+		writeU(numDescriptors);
+		for (uint32_t i = 0; i < numDescriptors; ++i)
+		{
+			const DescriptorData* pParam = &pDescParams[i];
+			writeS(pParam->pName);
+			writeU(pParam->mIndex == (uint32_t)-1 ? 0 : (uint64_t)pParam->mIndex + 1);
+			writeU(pParam->mCount);
+			writeU(pParam->mOffset);
+
+			// The union member in use follows from the descriptor type. Unknown descriptors are rejected by the
+			// backend, only their name / index is kept.
+			const DescriptorInfo* pDesc = findDescriptor(pRootSignature, pParam);
+			bool rootConstant = pDesc && pDesc->mDesc.type == DESCRIPTOR_TYPE_ROOT_CONSTANT;
+			uint32_t resourceCount = (pDesc && !rootConstant && pParam->ppTextures) ? pParam->mCount : 0;
+			writeU(resourceCount);
+			for (uint32_t r = 0; r < resourceCount; ++r)
+				writeObject(pParam->ppTextures[r]);
+			writeB(rootConstant ? pParam->pRootConstant : NULL, rootConstant ? getRootConstantSize(pDesc) : 0);
+		}
+	}
+	::cmdBindDescriptors(pCmd, pRootSignature, numDescriptors, pDescParams);
+}
+
+void cmdBindIndexBuffer(Cmd* p_cmd, Buffer* p_buffer)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_BIND_INDEX_BUFFER);
+		writeObject(p_cmd);
+		writeObject(p_buffer);
+	}
+	::cmdBindIndexBuffer(p_cmd, p_buffer);
+}
+
+void cmdBindVertexBuffer(Cmd* p_cmd, uint32_t buffer_count, Buffer** pp_buffers)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_BIND_VERTEX_BUFFER);
+		writeObject(p_cmd);
+		writeU(buffer_count);
+		for (uint32_t i = 0; i < buffer_count; ++i)
+			writeObject(pp_buffers[i]);
+	}
+	::cmdBindVertexBuffer(p_cmd, buffer_count, pp_buffers);
+}
+
+void cmdDraw(Cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_DRAW);
+		writeObject(p_cmd);
+		writeU(vertex_count);
+		writeU(first_vertex);
+	}
+	::cmdDraw(p_cmd, vertex_count, first_vertex);
+}
+
+void cmdDrawInstanced(Cmd* pCmd, uint32_t vertexCount, uint32_t firstVertex, uint32_t instanceCount)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_DRAW_INSTANCED);
+		writeObject(pCmd);
+		writeU(vertexCount);
+		writeU(firstVertex);
+		writeU(instanceCount);
+	}
+	::cmdDrawInstanced(pCmd, vertexCount, firstVertex, instanceCount);
+}
+
+void cmdDrawIndexed(Cmd* p_cmd, uint32_t index_count, uint32_t first_index)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_DRAW_INDEXED);
+		writeObject(p_cmd);
+		writeU(index_count);
+		writeU(first_index);
+	}
+	::cmdDrawIndexed(p_cmd, index_count, first_index);
+}
+
+void cmdDrawIndexedInstanced(Cmd* pCmd, uint32_t indexCount, uint32_t firstIndex, uint32_t instanceCount)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_DRAW_INDEXED_INSTANCED);
+		writeObject(pCmd);
+		writeU(indexCount);
+		writeU(firstIndex);
+		writeU(instanceCount);
+	}
+	::cmdDrawIndexedInstanced(pCmd, indexCount, firstIndex, instanceCount);
+}
+
+void cmdDispatch(Cmd* p_cmd, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_DISPATCH);
+		writeObject(p_cmd);
+		writeU(group_count_x);
+		writeU(group_count_y);
+		writeU(group_count_z);
+	}
+	::cmdDispatch(p_cmd, group_count_x, group_count_y, group_count_z);
+}
+
+void cmdResourceBarrier(Cmd* p_cmd, uint32_t buffer_barrier_count, BufferBarrier* p_buffer_barriers, uint32_t texture_barrier_count, TextureBarrier* p_texture_barriers, bool batch)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_RESOURCE_BARRIER);
+		writeObject(p_cmd);
+		writeU(buffer_barrier_count);
+		for (uint32_t i = 0; i < buffer_barrier_count; ++i)
+		{
+			writeObject(p_buffer_barriers[i].pBuffer);
+			writeU(p_buffer_barriers[i].mNewState);
+			writeU(p_buffer_barriers[i].mSplit);
+		}
+		writeU(texture_barrier_count);
+		for (uint32_t i = 0; i < texture_barrier_count; ++i)
+		{
+			writeObject(p_texture_barriers[i].pTexture);
+			writeU(p_texture_barriers[i].mNewState);
+			writeU(p_texture_barriers[i].mSplit);
+		}
+		writeU(batch);
+	}
+	::cmdResourceBarrier(p_cmd, buffer_barrier_count, p_buffer_barriers, texture_barrier_count, p_texture_barriers, batch);
+}
+
+void cmdSynchronizeResources(Cmd* p_cmd, uint32_t buffer_count, Buffer** p_buffers, uint32_t texture_count, Texture** p_textures, bool batch)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_SYNCHRONIZE_RESOURCES);
+		writeObject(p_cmd);
+		writeU(buffer_count);
+		for (uint32_t i = 0; i < buffer_count; ++i)
+			writeObject(p_buffers[i]);
+		writeU(texture_count);
+		for (uint32_t i = 0; i < texture_count; ++i)
+			writeObject(p_textures[i]);
+		writeU(batch);
+	}
+	::cmdSynchronizeResources(p_cmd, buffer_count, p_buffers, texture_count, p_textures, batch);
+}
+
+void cmdFlushBarriers(Cmd* p_cmd)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_FLUSH_BARRIERS);
+		writeObject(p_cmd);
+	}
+	::cmdFlushBarriers(p_cmd);
+}
+
+void cmdUpdateBuffer(Cmd* p_cmd, uint64_t srcOffset, uint64_t dstOffset, uint64_t size, Buffer* p_src_buffer, Buffer* p_buffer)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_UPDATE_BUFFER);
+		writeObject(p_cmd);
+		writeU(srcOffset);
+		writeU(dstOffset);
+		writeU(size);
+		writeObject(p_src_buffer);
+		writeObject(p_buffer);
+	}
+	::cmdUpdateBuffer(p_cmd, srcOffset, dstOffset, size, p_src_buffer, p_buffer);
+}
+
+void cmdUpdateSubresources(Cmd* pCmd, uint32_t startSubresource, uint32_t numSubresources, SubresourceDataDesc* pSubresources, Buffer* pIntermediate, uint64_t intermediateOffset, Texture* pTexture)
+{
+	if (pCommandCapture)
+	{
+		// Both layouts of SubresourceDataDesc are stored, the fields of the other backends are written as 0.
+		// D3D12 and Metal point pData into the mapped intermediate buffer, which is stored as an offset.
+		CaptureRecord record(CAPTURE_OP_CMD_UPDATE_SUBRESOURCES);
+		writeObject(pCmd);
+		writeU(startSubresource);
+		writeU(numSubresources);
+		for (uint32_t i = startSubresource; i < startSubresource + numSubresources; ++i)
+		{
+			const SubresourceDataDesc* pSubresource = &pSubresources[i];
+#if defined(DIRECT3D12) || defined(METAL)
+			for (uint32_t field = 0; field < 7; ++field)
+				writeU(0);
+			writeU(pSubresource->mRowPitch);
+			writeU(pSubresource->mSlicePitch);
+			writeU((uint64_t)((const uint8_t*)pSubresource->pData - (const uint8_t*)pIntermediate->pCpuMappedAddress));
+#else
+			writeU(pSubresource->mMipLevel);
+			writeU(pSubresource->mArrayLayer);
+			writeU(pSubresource->mWidth);
+			writeU(pSubresource->mHeight);
+			writeU(pSubresource->mDepth);
+			writeU(pSubresource->mArraySize);
+			writeU(pSubresource->mBufferOffset);
+			for (uint32_t field = 0; field < 3; ++field)
+				writeU(0);
+#endif
+		}
+		writeObject(pIntermediate);
+		writeU(intermediateOffset);
+		writeObject(pTexture);
+	}
+	::cmdUpdateSubresources(pCmd, startSubresource, numSubresources, pSubresources, pIntermediate, intermediateOffset, pTexture);
+}
+
+void cmdBeginQuery(Cmd* pCmd, QueryHeap* pQueryHeap, QueryDesc* pQuery)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_BEGIN_QUERY);
+		writeObject(pCmd);
+		writeObject(pQueryHeap);
+		writeU(pQuery->mIndex);
+	}
+	::cmdBeginQuery(pCmd, pQueryHeap, pQuery);
+}
+
+void cmdEndQuery(Cmd* pCmd, QueryHeap* pQueryHeap, QueryDesc* pQuery)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_END_QUERY);
+		writeObject(pCmd);
+		writeObject(pQueryHeap);
+		writeU(pQuery->mIndex);
+	}
+	::cmdEndQuery(pCmd, pQueryHeap, pQuery);
+}
+
+void cmdResolveQuery(Cmd* pCmd, QueryHeap* pQueryHeap, Buffer* pReadbackBuffer, uint32_t startQuery, uint32_t queryCount)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_RESOLVE_QUERY);
+		writeObject(pCmd);
+		writeObject(pQueryHeap);
+		writeObject(pReadbackBuffer);
+		writeU(startQuery);
+		writeU(queryCount);
+	}
+	::cmdResolveQuery(pCmd, pQueryHeap, pReadbackBuffer, startQuery, queryCount);
+}
+
+void cmdExecuteIndirect(Cmd* pCmd, CommandSignature* pCommandSignature, uint maxCommandCount, Buffer* pIndirectBuffer, uint64_t bufferOffset, Buffer* pCounterBuffer, uint64_t counterBufferOffset)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_EXECUTE_INDIRECT);
+		writeObject(pCmd);
+		writeObject(pCommandSignature);
+		writeU(maxCommandCount);
+		writeObject(pIndirectBuffer);
+		writeU(bufferOffset);
+		writeObject(pCounterBuffer);
+		writeU(counterBufferOffset);
+	}
+	::cmdExecuteIndirect(pCmd, pCommandSignature, maxCommandCount, pIndirectBuffer, bufferOffset, pCounterBuffer, counterBufferOffset);
+}
+
+void cmdBeginDebugMarker(Cmd* pCmd, float r, float g, float b, const char* pName)
+{
+	if (pCommandCapture)
+		writeDebugMarker(CAPTURE_OP_CMD_BEGIN_DEBUG_MARKER, pCmd, r, g, b, pName);
+	::cmdBeginDebugMarker(pCmd, r, g, b, pName);
+}
+
+void cmdBeginDebugMarkerf(Cmd* pCmd, float r, float g, float b, const char* pFormat, ...)
+{
+	// Formatted markers are recorded and forwarded with the formatted string
+	va_list argptr;
+	va_start(argptr, pFormat);
+	char buffer[65536];
+	vsnprintf(buffer, sizeof(buffer), pFormat, argptr);
+	va_end(argptr);
+	CommandCaptureLayer::cmdBeginDebugMarker(pCmd, r, g, b, buffer);
+}
+
+void cmdEndDebugMarker(Cmd* pCmd)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_CMD_END_DEBUG_MARKER);
+		writeObject(pCmd);
+	}
+	::cmdEndDebugMarker(pCmd);
+}
+
+void cmdAddDebugMarker(Cmd* pCmd, float r, float g, float b, const char* pName)
+{
+	if (pCommandCapture)
+		writeDebugMarker(CAPTURE_OP_CMD_ADD_DEBUG_MARKER, pCmd, r, g, b, pName);
+	::cmdAddDebugMarker(pCmd, r, g, b, pName);
+}
+
+void cmdAddDebugMarkerf(Cmd* pCmd, float r, float g, float b, const char* pFormat, ...)
+{
+	va_list argptr;
+	va_start(argptr, pFormat);
+	char buffer[65536];
+	vsnprintf(buffer, sizeof(buffer), pFormat, argptr);
+	va_end(argptr);
+	CommandCaptureLayer::cmdAddDebugMarker(pCmd, r, g, b, buffer);
+}
+
+void acquireNextImage(Renderer* pRenderer, SwapChain* p_swap_chain, Semaphore* p_signal_semaphore, Fence* p_fence, uint32_t* p_image_index)
+{
+	::acquireNextImage(pRenderer, p_swap_chain, p_signal_semaphore, p_fence, p_image_index);
+	if (!pCommandCapture)
+		return;
+
+	CaptureRecord record(CAPTURE_OP_ACQUIRE_NEXT_IMAGE);
+	writeObject(pRenderer);
+	writeObject(p_swap_chain);
+	writeObject(p_signal_semaphore);
+	writeObject(p_fence);
+	writeU(*p_image_index);
+}
+
+void queueSubmit(Queue* p_queue, uint32_t cmd_count, Cmd** pp_cmds, Fence* pFence, uint32_t wait_semaphore_count, Semaphore** pp_wait_semaphores, uint32_t signal_semaphore_count, Semaphore** pp_signal_semaphores)
+{
+	if (pCommandCapture)
+	{
+		MutexLock lock(pCommandCapture->mMutex);
+		// Contents of mapped buffers the submitted work may read
+		for (uint32_t i = 0; i < (uint32_t)pCommandCapture->mBuffers.size(); ++i)
+			captureBufferContents(&pCommandCapture->mBuffers[i]);
+
+		beginRecord(CAPTURE_OP_QUEUE_SUBMIT);
+		writeObject(p_queue);
+		writeU(cmd_count);
+		for (uint32_t i = 0; i < cmd_count; ++i)
+			writeObject(pp_cmds[i]);
+		writeObject(pFence);
+		writeU(wait_semaphore_count);
+		for (uint32_t i = 0; i < wait_semaphore_count; ++i)
+			writeObject(pp_wait_semaphores[i]);
+		writeU(signal_semaphore_count);
+		for (uint32_t i = 0; i < signal_semaphore_count; ++i)
+			writeObject(pp_signal_semaphores[i]);
+		endRecord();
+	}
+	::queueSubmit(p_queue, cmd_count, pp_cmds, pFence, wait_semaphore_count, pp_wait_semaphores, signal_semaphore_count, pp_signal_semaphores);
+}
+
+void queuePresent(Queue* p_queue, SwapChain* p_swap_chain, uint32_t swap_chain_image_index, uint32_t wait_semaphore_count, Semaphore** pp_wait_semaphores)
+{
+	if (pCommandCapture)
+	{
+		MutexLock lock(pCommandCapture->mMutex);
+		beginRecord(CAPTURE_OP_QUEUE_PRESENT);
+		writeObject(p_queue);
+		writeObject(p_swap_chain);
+		writeU(swap_chain_image_index);
+		writeU(wait_semaphore_count);
+		for (uint32_t i = 0; i < wait_semaphore_count; ++i)
+			writeObject(pp_wait_semaphores[i]);
+		endRecord();
+		// Complete frames are on disk if the application does not shut down cleanly
+		flushCapture(pCommandCapture);
+	}
+	::queuePresent(p_queue, p_swap_chain, swap_chain_image_index, wait_semaphore_count, pp_wait_semaphores);
+}
+
+void waitForFences(Queue* p_queue, uint32_t fence_count, Fence** pp_fences)
+{
+	if (pCommandCapture)
+	{
+		CaptureRecord record(CAPTURE_OP_WAIT_FOR_FENCES);
+		writeObject(p_queue);
+		writeU(fence_count);
+		for (uint32_t i = 0; i < fence_count; ++i)
+			writeObject(pp_fences[i]);
+	}
+	::waitForFences(p_queue, fence_count, pp_fences);
+}
+
+void getFenceStatus(Fence* p_fence, FenceStatus* p_fence_status)
+{
+	::getFenceStatus(p_fence, p_fence_status);
+	if (!pCommandCapture)
+		return;
+
+	// The status is informational only, replay polls the fence without acting on the result
+	CaptureRecord record(CAPTURE_OP_GET_FENCE_STATUS);
+	writeObject(p_fence);
+	writeU(*p_fence_status);
+}
+
+} // namespace CommandCaptureLayer
+/************************************************************************/
+// Record reading
+/************************************************************************/
+typedef struct CaptureReader
+{
+	const uint8_t*	pData;
+	const uint8_t*	pEnd;
+	bool			mError;
+} CaptureReader;
+
+static uint64_t readU(CaptureReader* pReader)
+{
+	uint64_t value = 0;
+	for (uint32_t shift = 0; shift < 64 && pReader->pData < pReader->pEnd; shift += 7)
+	{
+		uint8_t byte = *pReader->pData++;
+		value |= (uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return value;
+	}
+	pReader->mError = true;
+	return 0;
+}
+
+static uint32_t readU32(CaptureReader* pReader)
+{
+	uint64_t value = readU(pReader);
+	if (value > UINT32_MAX)
+		pReader->mError = true;
+	return (uint32_t)value;
+}
+
+static int64_t readI(CaptureReader* pReader)
+{
+	uint64_t value = readU(pReader);
+	return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static float readF(CaptureReader* pReader)
+{
+	if (pReader->pEnd - pReader->pData < 4)
+	{
+		pReader->mError = true;
+		return 0.0f;
+	}
+	const uint8_t* pBytes = pReader->pData;
+	uint32_t bits = (uint32_t)pBytes[0] | ((uint32_t)pBytes[1] << 8) | ((uint32_t)pBytes[2] << 16) | ((uint32_t)pBytes[3] << 24);
+	pReader->pData += 4;
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static ClearValue readClearValue(CaptureReader* pReader)
+{
+	ClearValue value;
+	value.r = readF(pReader);
+	value.g = readF(pReader);
+	value.b = readF(pReader);
+	value.a = readF(pReader);
+	return value;
+}
+
+// Strings are read in place, the file stores the terminating '\0'
+static const char* readS(CaptureReader* pReader)
+{
+	uint64_t length = readU(pReader);
+	if (!length)
+		return NULL;
+	if ((uint64_t)(pReader->pEnd - pReader->pData) < length || pReader->pData[length - 1] != '\0')
+	{
+		pReader->mError = true;
+		return NULL;
+	}
+	const char* pString = (const char*)pReader->pData;
+	pReader->pData += length;
+	return pString;
+}
+
+static const uint8_t* readB(CaptureReader* pReader, uint32_t* pSize)
+{
+	uint64_t size = readU(pReader);
+	*pSize = 0;
+	if ((uint64_t)(pReader->pEnd - pReader->pData) < size)
+	{
+		pReader->mError = true;
+		return NULL;
+	}
+	const uint8_t* pBlob = size ? pReader->pData : NULL;
+	pReader->pData += size;
+	*pSize = (uint32_t)size;
+	return pBlob;
+}
+
+// All fields of the record have to be consumed, anything else means the file does not match the op signature
+static bool endRead(CaptureReader* pReader)
+{
+	if (pReader->pData != pReader->pEnd)
+		pReader->mError = true;
+	return !pReader->mError;
+}
+
+typedef struct CaptureRecordHeader
+{
+	CaptureOp		mOp;
+	const uint8_t*	pPayload;
+	uint32_t		mSize;
+} CaptureRecordHeader;
+
+static bool loadCaptureFile(const char* pFileName, FSRoot root, tinystl::vector<uint8_t>* pData)
+{
+	if (!FileSystem::FileExists(pFileName, root))
+	{
+		LOGERRORF("Command capture %s not found", pFileName);
+		return false;
+	}
+
+	File file;
+	if (!file.Open(pFileName, FM_ReadBinary, root))
+		return false;
+
+	pData->resize(file.GetSize());
+	unsigned bytesRead = pData->size() ? file.Read(pData->data(), (unsigned)pData->size()) : 0;
+	file.Close();
+
+	uint32_t header[2] = {};
+	if (bytesRead != pData->size() || bytesRead < sizeof(header))
+	{
+		LOGERRORF("Could not read command capture %s", pFileName);
+		return false;
+	}
+
+	memcpy(header, pData->data(), sizeof(header));
+	if (header[0] != COMMAND_CAPTURE_MAGIC || header[1] != COMMAND_CAPTURE_VERSION)
+	{
+		LOGERRORF("%s is not a command capture of version %u", pFileName, COMMAND_CAPTURE_VERSION);
+		return false;
+	}
+	return true;
+}
+
+// Splits the file into records and validates the framing so later passes can rely on it
+static bool readRecordHeaders(const tinystl::vector<uint8_t>& data, tinystl::vector<CaptureRecordHeader>* pRecords)
+{
+	const uint8_t* pRecord = data.data() + 2 * sizeof(uint32_t);
+	const uint8_t* pEnd = data.data() + data.size();
+	while (pRecord < pEnd)
+	{
+		if (pEnd - pRecord < (ptrdiff_t)COMMAND_CAPTURE_RECORD_HEADER_SIZE || pRecord[0] >= CAPTURE_OP_COUNT)
+		{
+			LOGERRORF("Corrupt command capture record %u", (uint32_t)pRecords->size());
+			return false;
+		}
+
+		CaptureRecordHeader header;
+		header.mOp = (CaptureOp)pRecord[0];
+		header.mSize = (uint32_t)pRecord[1] | ((uint32_t)pRecord[2] << 8) | ((uint32_t)pRecord[3] << 16) | ((uint32_t)pRecord[4] << 24);
+		header.pPayload = pRecord + COMMAND_CAPTURE_RECORD_HEADER_SIZE;
+		if ((uint64_t)(pEnd - header.pPayload) < header.mSize)
+		{
+			LOGERRORF("Command capture is truncated at record %u (%s)", (uint32_t)pRecords->size(), gCaptureOps[header.mOp].pName);
+			return false;
+		}
+
+		pRecords->push_back(header);
+		pRecord = header.pPayload + header.mSize;
+	}
+	return true;
+}
+/************************************************************************/
+// Listing
+/************************************************************************/
+static void appendText(tinystl::vector<char>& text, const char* pFormat, ...)
+{
+	char buffer[256];
+	va_list argptr;
+	va_start(argptr, pFormat);
+	int length = vsnprintf(buffer, sizeof(buffer), pFormat, argptr);
+	va_end(argptr);
+	if (length > 0)
+		text.insert(text.end(), buffer, buffer + min((size_t)length, sizeof(buffer) - 1));
+}
+
+static const char* findGroupEnd(const char* pSignature)
+{
+	uint32_t depth = 1;
+	for (; *pSignature; ++pSignature)
+	{
+		if (*pSignature == '[')
+			++depth;
+		else if (*pSignature == ']' && !--depth)
+			return pSignature + 1;
+	}
+	return pSignature;
+}
+
+// Decodes the fields of one signature level, stopping at the end of the signature or of the enclosing group
+static void listFields(CaptureReader* pReader, const char* pSignature, tinystl::vector<char>& text)
+{
+	for (; *pSignature && *pSignature != ']' && !pReader->mError; ++pSignature)
+	{
+		switch (*pSignature)
+		{
+			case 'u': appendText(text, " %llu", (unsigned long long)readU(pReader)); break;
+			case 'i': appendText(text, " %lld", (long long)readI(pReader)); break;
+			case 'f': appendText(text, " %g", readF(pReader)); break;
+			case 'o':
+			{
+				uint32_t id = readU32(pReader);
+				if (id)
+					appendText(text, " #%u", id);
+				else
+					appendText(text, " null");
+				break;
+			}
+			case 's':
+			{
+				const char* pString = readS(pReader);
+				if (pString)
+				{
+					appendText(text, " \"");
+					text.insert(text.end(), pString, pString + strlen(pString));
+					appendText(text, "\"");
+				}
+				else
+				{
+					appendText(text, " null");
+				}
+				break;
+			}
+			case 'b':
+			{
+				// Contents are summarized by size and hash
+				uint32_t size = 0;
+				const uint8_t* pBlob = readB(pReader, &size);
+				appendText(text, " <%u bytes %016llx>", size, (unsigned long long)(size ? XXHash64(pBlob, size) : 0));
+				break;
+			}
+			case '[':
+			{
+				const char* pGroupEnd = findGroupEnd(pSignature + 1);
+				uint64_t count = readU(pReader);
+				appendText(text, " [");
+				for (uint64_t i = 0; i < count && !pReader->mError; ++i)
+				{
+					if (i)
+						appendText(text, " |");
+					listFields(pReader, pSignature + 1, text);
+				}
+				appendText(text, " ]");
+				pSignature = pGroupEnd - 1;
+				break;
+			}
+			default:
+				pReader->mError = true;
+				break;
+		}
+	}
+}
+
+static bool writeCaptureListing(const tinystl::vector<CaptureRecordHeader>& records, const CommandReplayDesc* pDesc)
+{
+	File file;
+	if (!file.Open(pDesc->pListingFileName, FM_Write, pDesc->mListingRoot))
+	{
+		LOGERRORF("Could not open command capture listing %s", pDesc->pListingFileName);
+		return false;
+	}
+
+	bool result = true;
+	tinystl::vector<char> text;
+	for (uint32_t i = 0; i < (uint32_t)records.size() && result; ++i)
+	{
+		const CaptureRecordHeader& record = records[i];
+		CaptureReader reader = { record.pPayload, record.pPayload + record.mSize, false };
+		appendText(text, "%u %s", i, gCaptureOps[record.mOp].pName);
+		listFields(&reader, gCaptureOps[record.mOp].pSignature, text);
+		appendText(text, "\n");
+		if (!endRead(&reader))
+		{
+			LOGERRORF("Command capture record %u (%s) does not match its signature", i, gCaptureOps[record.mOp].pName);
+			result = false;
+		}
+
+		if (text.size() >= COMMAND_CAPTURE_FLUSH_SIZE || i + 1 == (uint32_t)records.size() || !result)
+		{
+			file.Write(text.data(), (unsigned)text.size());
+			text.clear();
+		}
+	}
+
+	file.Close();
+	return result;
+}
+/************************************************************************/
+// Replay
+/************************************************************************/
+typedef struct ReplayObject
+{
+	void*		pObject;
+	/// Buffer range accessible through pCpuMappedAddress
+	uint64_t	mMappedBegin;
+	uint64_t	mMappedEnd;
+	/// Swapchain image returned by the last acquireNextImage of the replay
+	uint32_t	mImageIndex;
+} ReplayObject;
+
+typedef struct CommandReplay
+{
+	const CommandReplayDesc*		pDesc;
+	CommandReplayStats*				pStats;
+	/// Objects by capture id, id 0 is NULL
+	tinystl::vector<ReplayObject>	mObjects;
+} CommandReplay;
+
+static ReplayObject* getReplayObject(CommandReplay* pReplay, uint32_t id)
+{
+	return (id && id < pReplay->mObjects.size()) ? &pReplay->mObjects[id] : NULL;
+}
+
+template <typename T>
+static T* readObject(CommandReplay* pReplay, CaptureReader* pReader, uint32_t* pId = NULL)
+{
+	uint32_t id = readU32(pReader);
+	if (pId)
+		*pId = id;
+	ReplayObject* pObject = getReplayObject(pReplay, id);
+	return pObject ? (T*)pObject->pObject : NULL;
+}
+
+// Objects the call cannot do without, a NULL here means the capture missed their creation
+template <typename T>
+static T* readRequiredObject(CommandReplay* pReplay, CaptureReader* pReader, uint32_t* pId = NULL)
+{
+	T* pObject = readObject<T>(pReplay, pReader, pId);
+	if (!pObject)
+		pReader->mError = true;
+	return pObject;
+}
+
+template <typename T>
+static void readObjects(CommandReplay* pReplay, CaptureReader* pReader, tinystl::vector<T*>& objects)
+{
+	uint32_t count = readU32(pReader);
+	for (uint32_t i = 0; i < count && !pReader->mError; ++i)
+		objects.push_back(readObject<T>(pReplay, pReader));
+}
+
+static void setReplayObject(CommandReplay* pReplay, uint32_t id, void* pObject)
+{
+	if (!id)
+		return;
+	if (id >= pReplay->mObjects.size())
+		pReplay->mObjects.resize(id + 1, ReplayObject());
+
+	ReplayObject object = {};
+	object.pObject = pObject;
+	object.mImageIndex = UINT32_MAX;
+	pReplay->mObjects[id] = object;
+}
+
+// Calls are re-issued through the capture wrappers, so replaying while a capture is active records the replay again
+static bool replayRecord(CommandReplay* pReplay, CaptureOp op, CaptureReader* pReader)
+{
+	CaptureReader* r = pReader;
+	switch (op)
+	{
+		case CAPTURE_OP_INIT_RENDERER:
+		{
+			const char* pAppName = readS(r);
+			RendererDesc settings = {};
+			settings.mShaderTarget = (ShaderTarget)readU32(r);
+			uint32_t ids[4];
+			for (uint32_t i = 0; i < 4; ++i)
+				ids[i] = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			Renderer* pRenderer = NULL;
+			CommandCaptureLayer::initRenderer(pAppName ? pAppName : "", &settings, &pRenderer);
+			if (!pRenderer)
+				return false;
+			setReplayObject(pReplay, ids[0], pRenderer);
+			setReplayObject(pReplay, ids[1], pRenderer->pDefaultBlendState);
+			setReplayObject(pReplay, ids[2], pRenderer->pDefaultDepthState);
+			setReplayObject(pReplay, ids[3], pRenderer->pDefaultRasterizerState);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_RENDERER:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removeRenderer(pRenderer);
+			return true;
+		}
+		case CAPTURE_OP_ADD_FENCE:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			uint64_t value = readU(r);
+			uint32_t id = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			Fence* pFence = NULL;
+			CommandCaptureLayer::addFence(pRenderer, &pFence, value);
+			setReplayObject(pReplay, id, pFence);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_FENCE:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			Fence* pFence = readRequiredObject<Fence>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removeFence(pRenderer, pFence);
+			return true;
+		}
+		case CAPTURE_OP_ADD_SEMAPHORE:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			uint32_t id = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			Semaphore* pSemaphore = NULL;
+			CommandCaptureLayer::addSemaphore(pRenderer, &pSemaphore);
+			setReplayObject(pReplay, id, pSemaphore);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_SEMAPHORE:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			Semaphore* pSemaphore = readRequiredObject<Semaphore>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removeSemaphore(pRenderer, pSemaphore);
+			return true;
+		}
+		case CAPTURE_OP_ADD_QUEUE:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			QueueDesc desc = {};
+			desc.mFlag = (QueueFlag)readU32(r);
+			desc.mPriority = (QueuePriority)readU32(r);
+			desc.mType = (CmdPoolType)readU32(r);
+			uint32_t id = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			Queue* pQueue = NULL;
+			CommandCaptureLayer::addQueue(pRenderer, &desc, &pQueue);
+			setReplayObject(pReplay, id, pQueue);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_QUEUE:
+		{
+			Queue* pQueue = readRequiredObject<Queue>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removeQueue(pQueue);
+			return true;
+		}
+		case CAPTURE_OP_ADD_SWAP_CHAIN:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			SwapChainDesc desc = {};
+			desc.pWindow = pReplay->pDesc->pWindow;
+			desc.pQueue = readRequiredObject<Queue>(pReplay, r);
+			desc.mImageCount = readU32(r);
+			desc.mWidth = readU32(r);
+			desc.mHeight = readU32(r);
+			desc.mSampleCount = (SampleCount)readU32(r);
+			desc.mSampleQuality = readU32(r);
+			desc.mColorFormat = (ImageFormat::Enum)readU32(r);
+			desc.mColorClearValue = readClearValue(r);
+			desc.mSrgb = readU(r) != 0;
+			desc.mEnableVsync = readU(r) != 0;
+			uint32_t id = readU32(r);
+			tinystl::vector<uint32_t> imageIds;
+			uint32_t imageCount = readU32(r);
+			for (uint32_t i = 0; i < imageCount * 2 && !r->mError; ++i)
+				imageIds.push_back(readU32(r));
+			if (!endRead(r))
+				return false;
+
+			SwapChain* pSwapChain = NULL;
+			CommandCaptureLayer::addSwapChain(pRenderer, &desc, &pSwapChain);
+			if (!pSwapChain)
+				return false;
+			setReplayObject(pReplay, id, pSwapChain);
+			for (uint32_t i = 0; i < imageCount && i < pSwapChain->mDesc.mImageCount; ++i)
+			{
+				setReplayObject(pReplay, imageIds[i * 2], pSwapChain->ppSwapchainRenderTargets[i]);
+				setReplayObject(pReplay, imageIds[i * 2 + 1], pSwapChain->ppSwapchainRenderTargets[i]->pTexture);
+			}
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_SWAP_CHAIN:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			SwapChain* pSwapChain = readRequiredObject<SwapChain>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removeSwapChain(pRenderer, pSwapChain);
+			return true;
+		}
+		case CAPTURE_OP_ADD_CMD_POOL:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			Queue* pQueue = readRequiredObject<Queue>(pReplay, r);
+			bool transient = readU(r) != 0;
+			CmdPoolDesc desc = {};
+			bool hasDesc = readU(r) != 0;
+			if (hasDesc)
+				desc.mCmdPoolType = (CmdPoolType)readU32(r);
+			uint32_t id = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			CmdPool* pCmdPool = NULL;
+			CommandCaptureLayer::addCmdPool(pRenderer, pQueue, transient, &pCmdPool, hasDesc ? &desc : NULL);
+			setReplayObject(pReplay, id, pCmdPool);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_CMD_POOL:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			CmdPool* pCmdPool = readRequiredObject<CmdPool>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removeCmdPool(pRenderer, pCmdPool);
+			return true;
+		}
+		case CAPTURE_OP_ADD_CMD:
+		{
+			CmdPool* pCmdPool = readRequiredObject<CmdPool>(pReplay, r);
+			bool secondary = readU(r) != 0;
+			uint32_t id = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			Cmd* pCmd = NULL;
+			CommandCaptureLayer::addCmd(pCmdPool, secondary, &pCmd);
+			setReplayObject(pReplay, id, pCmd);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_CMD:
+		{
+			CmdPool* pCmdPool = readRequiredObject<CmdPool>(pReplay, r);
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removeCmd(pCmdPool, pCmd);
+			return true;
+		}
+		case CAPTURE_OP_ADD_CMD_N:
+		{
+			CmdPool* pCmdPool = readRequiredObject<CmdPool>(pReplay, r);
+			bool secondary = readU(r) != 0;
+			uint32_t arrayId = readU32(r);
+			tinystl::vector<uint32_t> ids;
+			uint32_t count = readU32(r);
+			for (uint32_t i = 0; i < count && !r->mError; ++i)
+				ids.push_back(readU32(r));
+			if (!endRead(r))
+				return false;
+
+			Cmd** ppCmds = NULL;
+			CommandCaptureLayer::addCmd_n(pCmdPool, secondary, count, &ppCmds);
+			setReplayObject(pReplay, arrayId, ppCmds);
+			for (uint32_t i = 0; i < count; ++i)
+				setReplayObject(pReplay, ids[i], ppCmds[i]);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_CMD_N:
+		{
+			CmdPool* pCmdPool = readRequiredObject<CmdPool>(pReplay, r);
+			Cmd** ppCmds = readObject<Cmd*>(pReplay, r);
+			tinystl::vector<Cmd*> cmds;
+			readObjects(pReplay, r, cmds);
+			if (!endRead(r))
+				return false;
+
+			// Arrays allocated outside of addCmd_n cannot be handed to removeCmd_n
+			if (ppCmds)
+			{
+				CommandCaptureLayer::removeCmd_n(pCmdPool, (uint32_t)cmds.size(), ppCmds);
+			}
+			else
+			{
+				for (uint32_t i = 0; i < (uint32_t)cmds.size(); ++i)
+					if (cmds[i])
+						CommandCaptureLayer::removeCmd(pCmdPool, cmds[i]);
+			}
+			return true;
+		}
+		case CAPTURE_OP_ADD_RENDER_TARGET:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			RenderTargetDesc desc = {};
+			desc.mType = (RenderTargetType)readU32(r);
+			desc.mFlags = (TextureCreationFlags)readU32(r);
+			desc.mWidth = readU32(r);
+			desc.mHeight = readU32(r);
+			desc.mDepth = readU32(r);
+			desc.mBaseArrayLayer = readU32(r);
+			desc.mArraySize = readU32(r);
+			desc.mBaseMipLevel = readU32(r);
+			desc.mSampleCount = (SampleCount)readU32(r);
+			desc.mFormat = (ImageFormat::Enum)readU32(r);
+			desc.mClearValue = readClearValue(r);
+			desc.mUsage = (RenderTargetUsage)readU32(r);
+			desc.mSampleQuality = readU32(r);
+			desc.mSrgb = readU(r) != 0;
+			uint32_t id = readU32(r);
+			uint32_t textureId = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			RenderTarget* pRenderTarget = NULL;
+			CommandCaptureLayer::addRenderTarget(pRenderer, &desc, &pRenderTarget, NULL);
+			if (!pRenderTarget)
+				return false;
+			setReplayObject(pReplay, id, pRenderTarget);
+			setReplayObject(pReplay, textureId, pRenderTarget->pTexture);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_RENDER_TARGET:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			RenderTarget* pRenderTarget = readRequiredObject<RenderTarget>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removeRenderTarget(pRenderer, pRenderTarget);
+			return true;
+		}
+		case CAPTURE_OP_ADD_SAMPLER:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			FilterType minFilter = (FilterType)readU32(r);
+			FilterType magFilter = (FilterType)readU32(r);
+			MipMapMode mipMapMode = (MipMapMode)readU32(r);
+			AddressMode addressU = (AddressMode)readU32(r);
+			AddressMode addressV = (AddressMode)readU32(r);
+			AddressMode addressW = (AddressMode)readU32(r);
+			float mipLodBias = readF(r);
+			float maxAnisotropy = readF(r);
+			uint32_t id = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			Sampler* pSampler = NULL;
+			CommandCaptureLayer::addSampler(pRenderer, &pSampler, minFilter, magFilter, mipMapMode, addressU, addressV, addressW, mipLodBias, maxAnisotropy);
+			setReplayObject(pReplay, id, pSampler);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_SAMPLER:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			Sampler* pSampler = readRequiredObject<Sampler>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removeSampler(pRenderer, pSampler);
+			return true;
+		}
+		case CAPTURE_OP_ADD_SHADER:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			ShaderDesc desc = {};
+			uint32_t stageCount = readU32(r);
+			for (uint32_t i = 0; i < stageCount && !r->mError; ++i)
+			{
+				uint32_t index = readU32(r);
+				if (index >= SHADER_DESC_STAGE_COUNT || gShaderStages[index] == SHADER_STAGE_NONE)
+				{
+					LOGERRORF("Shader stage %u of the capture is not supported by this renderer", index);
+					return false;
+				}
+
+				ShaderStageDesc* pStage = getShaderStageDesc(&desc, index);
+				desc.mStages |= gShaderStages[index];
+				const char* pName = readS(r);
+				pStage->mName = pName ? pName : "";
+				uint32_t codeSize = 0;
+				const uint8_t* pCode = readB(r, &codeSize);
+				pStage->mCode.resize(codeSize);
+				if (codeSize)
+					memcpy(pStage->mCode.begin(), pCode, codeSize);
+				const char* pEntryPoint = readS(r);
+				pStage->mEntryPoint = pEntryPoint ? pEntryPoint : "";
+				uint32_t macroCount = readU32(r);
+				for (uint32_t m = 0; m < macroCount && !r->mError; ++m)
+				{
+					const char* pDefinition = readS(r);
+					const char* pValue = readS(r);
+					ShaderMacro macro = { pDefinition ? pDefinition : "", pValue ? pValue : "" };
+					pStage->mMacros.push_back(macro);
+				}
+				const char* pCompileFlags = readS(r);
+#if defined(VULKAN)
+				pStage->mCompileFlags = pCompileFlags ? pCompileFlags : "";
+#else
+				UNREF_PARAM(pCompileFlags);
+#endif
+			}
+			uint32_t id = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			Shader* pShader = NULL;
+			CommandCaptureLayer::addShader(pRenderer, &desc, &pShader);
+			setReplayObject(pReplay, id, pShader);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_SHADER:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			Shader* pShader = readRequiredObject<Shader>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removeShader(pRenderer, pShader);
+			return true;
+		}
+		case CAPTURE_OP_ADD_ROOT_SIGNATURE:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			tinystl::vector<Shader*> shaders;
+			readObjects(pReplay, r, shaders);
+			RootSignatureDesc rootDesc;
+			bool hasDesc = readU(r) != 0;
+			if (hasDesc)
+			{
+				uint32_t typeCount = readU32(r);
+				for (uint32_t i = 0; i < typeCount && !r->mError; ++i)
+				{
+					uint32_t maxDescriptors = readU32(r);
+					if (i < DESCRIPTOR_TYPE_COUNT)
+						rootDesc.mMaxBindlessDescriptors[i] = maxDescriptors;
+				}
+				uint32_t samplerCount = readU32(r);
+				for (uint32_t i = 0; i < samplerCount && !r->mError; ++i)
+				{
+					const char* pName = readS(r);
+					Sampler* pSampler = readRequiredObject<Sampler>(pReplay, r);
+					if (pName)
+						rootDesc.mStaticSamplers[pName] = pSampler;
+				}
+				uint32_t dynamicBufferCount = readU32(r);
+				for (uint32_t i = 0; i < dynamicBufferCount && !r->mError; ++i)
+				{
+					const char* pName = readS(r);
+#if defined(VULKAN)
+					if (pName)
+						rootDesc.mDynamicUniformBuffers.push_back(pName);
+#else
+					UNREF_PARAM(pName);
+#endif
+				}
+			}
+			uint32_t id = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			RootSignature* pRootSignature = NULL;
+			CommandCaptureLayer::addRootSignature(pRenderer, (uint32_t)shaders.size(), shaders.data(), &pRootSignature, hasDesc ? &rootDesc : NULL);
+			setReplayObject(pReplay, id, pRootSignature);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_ROOT_SIGNATURE:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			RootSignature* pRootSignature = readRequiredObject<RootSignature>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removeRootSignature(pRenderer, pRootSignature);
+			return true;
+		}
+		case CAPTURE_OP_ADD_PIPELINE:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			GraphicsPipelineDesc desc = {};
+			desc.pShaderProgram = readRequiredObject<Shader>(pReplay, r);
+			desc.pRootSignature = readRequiredObject<RootSignature>(pReplay, r);
+			VertexLayout vertexLayout = {};
+			if (readU(r))
+			{
+				vertexLayout.mAttribCount = readU32(r);
+				if (vertexLayout.mAttribCount > MAX_VERTEX_ATTRIBS)
+					return false;
+				for (uint32_t i = 0; i < vertexLayout.mAttribCount && !r->mError; ++i)
+				{
+					VertexAttrib* pAttrib = &vertexLayout.mAttribs[i];
+					pAttrib->mSemantic = (ShaderSemantic)readU32(r);
+					const char* pSemanticName = readS(r);
+					if (pSemanticName)
+					{
+						pAttrib->mSemanticNameLength = (uint32_t)min(strlen(pSemanticName), (size_t)MAX_SEMANTIC_NAME_LENGTH);
+						memcpy(pAttrib->mSemanticName, pSemanticName, pAttrib->mSemanticNameLength);
+					}
+					pAttrib->mFormat = (ImageFormat::Enum)readU32(r);
+					pAttrib->mBinding = readU32(r);
+					pAttrib->mLocation = readU32(r);
+					pAttrib->mOffset = readU32(r);
+				}
+				desc.pVertexLayout = &vertexLayout;
+			}
+			tinystl::vector<RenderTarget*> renderTargets;
+			readObjects(pReplay, r, renderTargets);
+			desc.ppRenderTargets = renderTargets.data();
+			desc.mRenderTargetCount = (uint32_t)renderTargets.size();
+			desc.pDepthStencil = readObject<RenderTarget>(pReplay, r);
+			desc.mPrimitiveTopo = (PrimitiveTopology)readU32(r);
+			desc.pBlendState = readObject<BlendState>(pReplay, r);
+			desc.pDepthState = readObject<DepthState>(pReplay, r);
+			desc.pRasterizerState = readObject<RasterizerState>(pReplay, r);
+			uint32_t id = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			Pipeline* pPipeline = NULL;
+			CommandCaptureLayer::addPipeline(pRenderer, &desc, &pPipeline);
+			setReplayObject(pReplay, id, pPipeline);
+			return true;
+		}
+		case CAPTURE_OP_ADD_COMPUTE_PIPELINE:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			ComputePipelineDesc desc = {};
+			desc.pShaderProgram = readRequiredObject<Shader>(pReplay, r);
+			desc.pRootSignature = readRequiredObject<RootSignature>(pReplay, r);
+			uint32_t id = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			Pipeline* pPipeline = NULL;
+			CommandCaptureLayer::addComputePipeline(pRenderer, &desc, &pPipeline);
+			setReplayObject(pReplay, id, pPipeline);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_PIPELINE:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			Pipeline* pPipeline = readRequiredObject<Pipeline>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removePipeline(pRenderer, pPipeline);
+			return true;
+		}
+		case CAPTURE_OP_ADD_BLEND_STATE:
+		{
+			BlendConstant srcFactor = (BlendConstant)readU32(r);
+			BlendConstant destFactor = (BlendConstant)readU32(r);
+			BlendConstant srcAlphaFactor = (BlendConstant)readU32(r);
+			BlendConstant destAlphaFactor = (BlendConstant)readU32(r);
+			BlendMode blendMode = (BlendMode)readU32(r);
+			BlendMode blendAlphaMode = (BlendMode)readU32(r);
+			int mask = (int)readI(r);
+			int renderTargetNumber = (int)readI(r);
+			bool alphaToCoverage = readU(r) != 0;
+			uint32_t id = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			BlendState* pBlendState = NULL;
+			CommandCaptureLayer::addBlendState(&pBlendState, srcFactor, destFactor, srcAlphaFactor, destAlphaFactor, blendMode, blendAlphaMode, mask, renderTargetNumber, alphaToCoverage);
+			setReplayObject(pReplay, id, pBlendState);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_BLEND_STATE:
+		{
+			BlendState* pBlendState = readRequiredObject<BlendState>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removeBlendState(pBlendState);
+			return true;
+		}
+		case CAPTURE_OP_ADD_DEPTH_STATE:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			bool depthTest = readU(r) != 0;
+			bool depthWrite = readU(r) != 0;
+			CompareMode depthFunc = (CompareMode)readU32(r);
+			bool stencilTest = readU(r) != 0;
+			uint8 stencilReadMask = (uint8)readU32(r);
+			uint8 stencilWriteMask = (uint8)readU32(r);
+			CompareMode stencilFrontFunc = (CompareMode)readU32(r);
+			StencilOp stencilFrontFail = (StencilOp)readU32(r);
+			StencilOp depthFrontFail = (StencilOp)readU32(r);
+			StencilOp stencilFrontPass = (StencilOp)readU32(r);
+			CompareMode stencilBackFunc = (CompareMode)readU32(r);
+			StencilOp stencilBackFail = (StencilOp)readU32(r);
+			StencilOp depthBackFail = (StencilOp)readU32(r);
+			StencilOp stencilBackPass = (StencilOp)readU32(r);
+			uint32_t id = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			DepthState* pDepthState = NULL;
+			CommandCaptureLayer::addDepthState(pRenderer, &pDepthState, depthTest, depthWrite, depthFunc, stencilTest, stencilReadMask, stencilWriteMask,
+				stencilFrontFunc, stencilFrontFail, depthFrontFail, stencilFrontPass, stencilBackFunc, stencilBackFail, depthBackFail, stencilBackPass);
+			setReplayObject(pReplay, id, pDepthState);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_DEPTH_STATE:
+		{
+			DepthState* pDepthState = readRequiredObject<DepthState>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removeDepthState(pDepthState);
+			return true;
+		}
+		case CAPTURE_OP_ADD_RASTERIZER_STATE:
+		{
+			CullMode cullMode = (CullMode)readU32(r);
+			int depthBias = (int)readI(r);
+			float slopeScaledDepthBias = readF(r);
+			FillMode fillMode = (FillMode)readU32(r);
+			bool multiSample = readU(r) != 0;
+			bool scissor = readU(r) != 0;
+			uint32_t id = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			RasterizerState* pRasterizerState = NULL;
+			CommandCaptureLayer::addRasterizerState(&pRasterizerState, cullMode, depthBias, slopeScaledDepthBias, fillMode, multiSample, scissor);
+			setReplayObject(pReplay, id, pRasterizerState);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_RASTERIZER_STATE:
+		{
+			RasterizerState* pRasterizerState = readRequiredObject<RasterizerState>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removeRasterizerState(pRasterizerState);
+			return true;
+		}
+		case CAPTURE_OP_ADD_BUFFER:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			BufferDesc desc;
+			desc.mUsage = (BufferUsage)readU32(r);
+			desc.mSize = readU(r);
+			desc.mMemoryUsage = (ResourceMemoryUsage)readU32(r);
+			desc.mFlags = (BufferCreationFlags)readU32(r);
+			desc.mStartState = (ResourceState)readU32(r);
+			desc.mIndexType = (IndexType)readU32(r);
+			desc.mVertexStride = readU32(r);
+			desc.mFirstElement = readU(r);
+			desc.mElementCount = readU(r);
+			desc.mStructStride = readU(r);
+			desc.pCounterBuffer = readObject<Buffer>(pReplay, r);
+			desc.mFormat = (ImageFormat::Enum)readU32(r);
+			desc.mFeatures = (BufferFeatureFlags)readU32(r);
+			uint32_t id = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			Buffer* pBuffer = NULL;
+			CommandCaptureLayer::addBuffer(pRenderer, &desc, &pBuffer);
+			if (!pBuffer)
+				return false;
+			setReplayObject(pReplay, id, pBuffer);
+			if (pBuffer->pCpuMappedAddress && id)
+				getMappedRange(pBuffer, NULL, &pReplay->mObjects[id].mMappedBegin, &pReplay->mObjects[id].mMappedEnd);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_BUFFER:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			Buffer* pBuffer = readRequiredObject<Buffer>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removeBuffer(pRenderer, pBuffer);
+			return true;
+		}
+		case CAPTURE_OP_MAP_BUFFER:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			uint32_t id = 0;
+			Buffer* pBuffer = readRequiredObject<Buffer>(pReplay, r, &id);
+			ReadRange range = {};
+			bool hasRange = readU(r) != 0;
+			if (hasRange)
+			{
+				range.mOffset = readU(r);
+				range.mSize = readU(r);
+			}
+			if (!endRead(r))
+				return false;
+
+			CommandCaptureLayer::mapBuffer(pRenderer, pBuffer, hasRange ? &range : NULL);
+			getMappedRange(pBuffer, hasRange ? &range : NULL, &pReplay->mObjects[id].mMappedBegin, &pReplay->mObjects[id].mMappedEnd);
+			return true;
+		}
+		case CAPTURE_OP_UNMAP_BUFFER:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			uint32_t id = 0;
+			Buffer* pBuffer = readRequiredObject<Buffer>(pReplay, r, &id);
+			if (!endRead(r))
+				return false;
+
+			CommandCaptureLayer::unmapBuffer(pRenderer, pBuffer);
+			pReplay->mObjects[id].mMappedBegin = pReplay->mObjects[id].mMappedEnd = 0;
+			return true;
+		}
+		case CAPTURE_OP_BUFFER_DATA:
+		{
+			uint32_t id = 0;
+			Buffer* pBuffer = readRequiredObject<Buffer>(pReplay, r, &id);
+			uint64_t offset = readU(r);
+			uint32_t size = 0;
+			const uint8_t* pData = readB(r, &size);
+			if (!endRead(r))
+				return false;
+
+			// Written through the current mapping, buffers which are not mapped anymore are mapped temporarily
+			ReplayObject* pObject = &pReplay->mObjects[id];
+			bool mapped = pBuffer->pCpuMappedAddress != NULL;
+			uint64_t mappedBegin = mapped ? pObject->mMappedBegin : 0;
+			uint64_t mappedEnd = mapped ? pObject->mMappedEnd : pBuffer->mDesc.mSize;
+			if (offset < mappedBegin || offset + size > mappedEnd)
+			{
+				LOGERRORF("Captured data [%llu, %llu) is outside of the mapped range of the buffer", (unsigned long long)offset, (unsigned long long)(offset + size));
+				return false;
+			}
+
+			if (!mapped)
+				mapBuffer(pBuffer->pRenderer, pBuffer, NULL);
+			memcpy((uint8_t*)pBuffer->pCpuMappedAddress + (offset - mappedBegin), pData, size);
+			if (!mapped)
+				unmapBuffer(pBuffer->pRenderer, pBuffer);
+			pReplay->pStats->mUploadedBytes += size;
+			return true;
+		}
+		case CAPTURE_OP_ADD_TEXTURE:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			TextureDesc desc = {};
+			desc.mType = (TextureType)readU32(r);
+			desc.mFlags = (TextureCreationFlags)readU32(r);
+			desc.mWidth = readU32(r);
+			desc.mHeight = readU32(r);
+			desc.mDepth = readU32(r);
+			desc.mBaseArrayLayer = readU32(r);
+			desc.mArraySize = readU32(r);
+			desc.mBaseMipLevel = readU32(r);
+			desc.mMipLevels = readU32(r);
+			desc.mSampleCount = (SampleCount)readU32(r);
+			desc.mSampleQuality = readU32(r);
+			desc.mFormat = (ImageFormat::Enum)readU32(r);
+			desc.mClearValue = readClearValue(r);
+			desc.mUsage = (TextureUsage)readU32(r);
+			desc.mStartState = (ResourceState)readU32(r);
+			desc.mSrgb = readU(r) != 0;
+			desc.mHostVisible = readU(r) != 0;
+			uint32_t id = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			Texture* pTexture = NULL;
+			CommandCaptureLayer::addTexture(pRenderer, &desc, &pTexture);
+			setReplayObject(pReplay, id, pTexture);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_TEXTURE:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			Texture* pTexture = readRequiredObject<Texture>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removeTexture(pRenderer, pTexture);
+			return true;
+		}
+		case CAPTURE_OP_ADD_QUERY_HEAP:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			QueryHeapDesc desc = {};
+			desc.mType = (QueryType)readU32(r);
+			desc.mQueryCount = readU32(r);
+			uint32_t id = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			QueryHeap* pQueryHeap = NULL;
+			CommandCaptureLayer::addQueryHeap(pRenderer, &desc, &pQueryHeap);
+			setReplayObject(pReplay, id, pQueryHeap);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_QUERY_HEAP:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			QueryHeap* pQueryHeap = readRequiredObject<QueryHeap>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removeQueryHeap(pRenderer, pQueryHeap);
+			return true;
+		}
+		case CAPTURE_OP_ADD_INDIRECT_COMMAND_SIGNATURE:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			CommandSignatureDesc desc = {};
+			desc.pCmdPool = readObject<CmdPool>(pReplay, r);
+			desc.pRootSignature = readObject<RootSignature>(pReplay, r);
+			tinystl::vector<IndirectArgumentDescriptor> arguments;
+			uint32_t argumentCount = readU32(r);
+			for (uint32_t i = 0; i < argumentCount && !r->mError; ++i)
+			{
+				IndirectArgumentDescriptor argument = {};
+				argument.mType = (IndirectArgumentType)readU32(r);
+				argument.mRootParameterIndex = readU32(r);
+				argument.mCount = readU32(r);
+				argument.mDivisor = readU32(r);
+				arguments.push_back(argument);
+			}
+			desc.mIndirectArgCount = (uint32_t)arguments.size();
+			desc.pArgDescs = arguments.data();
+			uint32_t id = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			CommandSignature* pCommandSignature = NULL;
+			CommandCaptureLayer::addIndirectCommandSignature(pRenderer, &desc, &pCommandSignature);
+			setReplayObject(pReplay, id, pCommandSignature);
+			return true;
+		}
+		case CAPTURE_OP_REMOVE_INDIRECT_COMMAND_SIGNATURE:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			CommandSignature* pCommandSignature = readRequiredObject<CommandSignature>(pReplay, r);
+			if (!endRead(r))
+				return false;
+			CommandCaptureLayer::removeIndirectCommandSignature(pRenderer, pCommandSignature);
+			return true;
+		}
+		case CAPTURE_OP_BEGIN_CMD:
+		case CAPTURE_OP_END_CMD:
+		case CAPTURE_OP_CMD_FLUSH_BARRIERS:
+		case CAPTURE_OP_CMD_END_DEBUG_MARKER:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			if (!endRead(r))
+				return false;
+
+			if (op == CAPTURE_OP_BEGIN_CMD)
+				CommandCaptureLayer::beginCmd(pCmd);
+			else if (op == CAPTURE_OP_END_CMD)
+				CommandCaptureLayer::endCmd(pCmd);
+			else if (op == CAPTURE_OP_CMD_FLUSH_BARRIERS)
+				CommandCaptureLayer::cmdFlushBarriers(pCmd);
+			else
+				CommandCaptureLayer::cmdEndDebugMarker(pCmd);
+			return true;
+		}
+		case CAPTURE_OP_CMD_BEGIN_RENDER:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			tinystl::vector<RenderTarget*> renderTargets;
+			readObjects(pReplay, r, renderTargets);
+			RenderTarget* pDepthStencil = readObject<RenderTarget>(pReplay, r);
+			LoadActionsDesc loadActions = {};
+			bool hasLoadActions = readU(r) != 0;
+			if (hasLoadActions)
+			{
+				uint32_t attachmentCount = readU32(r);
+				for (uint32_t i = 0; i < attachmentCount && !r->mError; ++i)
+				{
+					ClearValue clearValue = readClearValue(r);
+					LoadActionType loadAction = (LoadActionType)readU32(r);
+					if (i < MAX_RENDER_TARGET_ATTACHMENTS)
+					{
+						loadActions.mClearColorValues[i] = clearValue;
+						loadActions.mLoadActionsColor[i] = loadAction;
+					}
+				}
+				loadActions.mClearDepth = readClearValue(r);
+				loadActions.mLoadActionDepth = (LoadActionType)readU32(r);
+				loadActions.mLoadActionStencil = (LoadActionType)readU32(r);
+			}
+			if (!endRead(r))
+				return false;
+
+			CommandCaptureLayer::cmdBeginRender(pCmd, (uint32_t)renderTargets.size(), renderTargets.data(), pDepthStencil, hasLoadActions ? &loadActions : NULL);
+			return true;
+		}
+		case CAPTURE_OP_CMD_END_RENDER:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			tinystl::vector<RenderTarget*> renderTargets;
+			readObjects(pReplay, r, renderTargets);
+			RenderTarget* pDepthStencil = readObject<RenderTarget>(pReplay, r);
+			if (!endRead(r))
+				return false;
+
+			CommandCaptureLayer::cmdEndRender(pCmd, (uint32_t)renderTargets.size(), renderTargets.data(), pDepthStencil);
+			return true;
+		}
+		case CAPTURE_OP_CMD_SET_VIEWPORT:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			float viewport[6];
+			for (uint32_t i = 0; i < 6; ++i)
+				viewport[i] = readF(r);
+			if (!endRead(r))
+				return false;
+
+			CommandCaptureLayer::cmdSetViewport(pCmd, viewport[0], viewport[1], viewport[2], viewport[3], viewport[4], viewport[5]);
+			return true;
+		}
+		case CAPTURE_OP_CMD_SET_SCISSOR:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			uint32_t scissor[4];
+			for (uint32_t i = 0; i < 4; ++i)
+				scissor[i] = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			CommandCaptureLayer::cmdSetScissor(pCmd, scissor[0], scissor[1], scissor[2], scissor[3]);
+			return true;
+		}
+		case CAPTURE_OP_CMD_BIND_PIPELINE:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			Pipeline* pPipeline = readRequiredObject<Pipeline>(pReplay, r);
+			if (!endRead(r))
+				return false;
+
+			CommandCaptureLayer::cmdBindPipeline(pCmd, pPipeline);
+			return true;
+		}
+		case CAPTURE_OP_CMD_BIND_DESCRIPTORS:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			RootSignature* pRootSignature = readRequiredObject<RootSignature>(pReplay, r);
+			uint32_t paramCount = readU32(r);
+			tinystl::vector<DescriptorData> params;
+			// Resources of all params, pointers into the array are assigned once it stopped growing
+			tinystl::vector<void*> resources;
+			tinystl::vector<uint32_t> resourceCounts;
+			for (uint32_t i = 0; i < paramCount && !r->mError; ++i)
+			{
+				DescriptorData param;
+				param.pName = readS(r);
+				uint32_t index = readU32(r);
+				param.mIndex = index ? index - 1 : (uint32_t)-1;
+				param.mCount = readU32(r);
+				param.mOffset = readU(r);
+				uint32_t resourceCount = readU32(r);
+				for (uint32_t j = 0; j < resourceCount && !r->mError; ++j)
+					resources.push_back(readObject<void>(pReplay, r));
+				uint32_t rootConstantSize = 0;
+				param.pRootConstant = (void*)readB(r, &rootConstantSize);
+				resourceCounts.push_back(resourceCount);
+				params.push_back(param);
+			}
+			if (!endRead(r))
+				return false;
+
+			for (uint32_t i = 0, firstResource = 0; i < (uint32_t)params.size(); firstResource += resourceCounts[i++])
+				if (resourceCounts[i])
+					params[i].ppTextures = (Texture**)&resources[firstResource];
+			CommandCaptureLayer::cmdBindDescriptors(pCmd, pRootSignature, (uint32_t)params.size(), params.data());
+			return true;
+		}
+		case CAPTURE_OP_CMD_BIND_INDEX_BUFFER:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			Buffer* pBuffer = readRequiredObject<Buffer>(pReplay, r);
+			if (!endRead(r))
+				return false;
+
+			CommandCaptureLayer::cmdBindIndexBuffer(pCmd, pBuffer);
+			return true;
+		}
+		case CAPTURE_OP_CMD_BIND_VERTEX_BUFFER:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			tinystl::vector<Buffer*> buffers;
+			readObjects(pReplay, r, buffers);
+			if (!endRead(r))
+				return false;
+
+			CommandCaptureLayer::cmdBindVertexBuffer(pCmd, (uint32_t)buffers.size(), buffers.data());
+			return true;
+		}
+		case CAPTURE_OP_CMD_DRAW:
+		case CAPTURE_OP_CMD_DRAW_INDEXED:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			uint32_t count = readU32(r);
+			uint32_t first = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			if (op == CAPTURE_OP_CMD_DRAW)
+				CommandCaptureLayer::cmdDraw(pCmd, count, first);
+			else
+				CommandCaptureLayer::cmdDrawIndexed(pCmd, count, first);
+			return true;
+		}
+		case CAPTURE_OP_CMD_DRAW_INSTANCED:
+		case CAPTURE_OP_CMD_DRAW_INDEXED_INSTANCED:
+		case CAPTURE_OP_CMD_DISPATCH:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			uint32_t args[3];
+			for (uint32_t i = 0; i < 3; ++i)
+				args[i] = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			if (op == CAPTURE_OP_CMD_DRAW_INSTANCED)
+				CommandCaptureLayer::cmdDrawInstanced(pCmd, args[0], args[1], args[2]);
+			else if (op == CAPTURE_OP_CMD_DRAW_INDEXED_INSTANCED)
+				CommandCaptureLayer::cmdDrawIndexedInstanced(pCmd, args[0], args[1], args[2]);
+			else
+				CommandCaptureLayer::cmdDispatch(pCmd, args[0], args[1], args[2]);
+			return true;
+		}
+		case CAPTURE_OP_CMD_RESOURCE_BARRIER:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			tinystl::vector<BufferBarrier> bufferBarriers;
+			uint32_t bufferBarrierCount = readU32(r);
+			for (uint32_t i = 0; i < bufferBarrierCount && !r->mError; ++i)
+			{
+				BufferBarrier barrier = {};
+				barrier.pBuffer = readRequiredObject<Buffer>(pReplay, r);
+				barrier.mNewState = (ResourceState)readU32(r);
+				barrier.mSplit = readU(r) != 0;
+				bufferBarriers.push_back(barrier);
+			}
+			tinystl::vector<TextureBarrier> textureBarriers;
+			uint32_t textureBarrierCount = readU32(r);
+			for (uint32_t i = 0; i < textureBarrierCount && !r->mError; ++i)
+			{
+				TextureBarrier barrier = {};
+				barrier.pTexture = readRequiredObject<Texture>(pReplay, r);
+				barrier.mNewState = (ResourceState)readU32(r);
+				barrier.mSplit = readU(r) != 0;
+				textureBarriers.push_back(barrier);
+			}
+			bool batch = readU(r) != 0;
+			if (!endRead(r))
+				return false;
+
+			CommandCaptureLayer::cmdResourceBarrier(pCmd, (uint32_t)bufferBarriers.size(), bufferBarriers.data(), (uint32_t)textureBarriers.size(), textureBarriers.data(), batch);
+			return true;
+		}
+		case CAPTURE_OP_CMD_SYNCHRONIZE_RESOURCES:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			tinystl::vector<Buffer*> buffers;
+			readObjects(pReplay, r, buffers);
+			tinystl::vector<Texture*> textures;
+			readObjects(pReplay, r, textures);
+			bool batch = readU(r) != 0;
+			if (!endRead(r))
+				return false;
+
+			CommandCaptureLayer::cmdSynchronizeResources(pCmd, (uint32_t)buffers.size(), buffers.data(), (uint32_t)textures.size(), textures.data(), batch);
+			return true;
+		}
+		case CAPTURE_OP_CMD_UPDATE_BUFFER:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			uint64_t srcOffset = readU(r);
+			uint64_t dstOffset = readU(r);
+			uint64_t size = readU(r);
+			Buffer* pSrcBuffer = readRequiredObject<Buffer>(pReplay, r);
+			Buffer* pBuffer = readRequiredObject<Buffer>(pReplay, r);
+			if (!endRead(r))
+				return false;
+
+			CommandCaptureLayer::cmdUpdateBuffer(pCmd, srcOffset, dstOffset, size, pSrcBuffer, pBuffer);
+			return true;
+		}
+		case CAPTURE_OP_CMD_UPDATE_SUBRESOURCES:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			uint32_t startSubresource = readU32(r);
+			uint32_t numSubresources = readU32(r);
+			uint64_t fields[10];
+			tinystl::vector<uint64_t> subresourceFields;
+			for (uint32_t i = 0; i < numSubresources && !r->mError; ++i)
+			{
+				for (uint32_t field = 0; field < 10; ++field)
+					fields[field] = readU(r);
+				subresourceFields.insert(subresourceFields.end(), fields, fields + 10);
+			}
+			Buffer* pIntermediate = readRequiredObject<Buffer>(pReplay, r);
+			uint64_t intermediateOffset = readU(r);
+			Texture* pTexture = readRequiredObject<Texture>(pReplay, r);
+			if (!endRead(r))
+				return false;
+
+			// Subresources before startSubresource are not read by the backend
+			tinystl::vector<SubresourceDataDesc> subresources(startSubresource + numSubresources);
+			memset(subresources.data(), 0, subresources.size() * sizeof(SubresourceDataDesc));
+			for (uint32_t i = 0; i < numSubresources; ++i)
+			{
+				const uint64_t* pFields = &subresourceFields[i * 10];
+				SubresourceDataDesc* pSubresource = &subresources[startSubresource + i];
+#if defined(DIRECT3D12) || defined(METAL)
+				pSubresource->mRowPitch = (uint32_t)pFields[7];
+				pSubresource->mSlicePitch = (uint32_t)pFields[8];
+				pSubresource->pData = (uint8_t*)pIntermediate->pCpuMappedAddress + pFields[9];
+#else
+				pSubresource->mMipLevel = (uint32_t)pFields[0];
+				pSubresource->mArrayLayer = (uint32_t)pFields[1];
+				pSubresource->mWidth = (uint32_t)pFields[2];
+				pSubresource->mHeight = (uint32_t)pFields[3];
+				pSubresource->mDepth = (uint32_t)pFields[4];
+				pSubresource->mArraySize = (uint32_t)pFields[5];
+				pSubresource->mBufferOffset = pFields[6];
+#endif
+			}
+
+			CommandCaptureLayer::cmdUpdateSubresources(pCmd, startSubresource, numSubresources, subresources.data(), pIntermediate, intermediateOffset, pTexture);
+			return true;
+		}
+		case CAPTURE_OP_CMD_BEGIN_QUERY:
+		case CAPTURE_OP_CMD_END_QUERY:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			QueryHeap* pQueryHeap = readRequiredObject<QueryHeap>(pReplay, r);
+			QueryDesc query = {};
+			query.mIndex = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			if (op == CAPTURE_OP_CMD_BEGIN_QUERY)
+				CommandCaptureLayer::cmdBeginQuery(pCmd, pQueryHeap, &query);
+			else
+				CommandCaptureLayer::cmdEndQuery(pCmd, pQueryHeap, &query);
+			return true;
+		}
+		case CAPTURE_OP_CMD_RESOLVE_QUERY:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			QueryHeap* pQueryHeap = readRequiredObject<QueryHeap>(pReplay, r);
+			Buffer* pReadbackBuffer = readRequiredObject<Buffer>(pReplay, r);
+			uint32_t startQuery = readU32(r);
+			uint32_t queryCount = readU32(r);
+			if (!endRead(r))
+				return false;
+
+			CommandCaptureLayer::cmdResolveQuery(pCmd, pQueryHeap, pReadbackBuffer, startQuery, queryCount);
+			return true;
+		}
+		case CAPTURE_OP_CMD_EXECUTE_INDIRECT:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			CommandSignature* pCommandSignature = readRequiredObject<CommandSignature>(pReplay, r);
+			uint32_t maxCommandCount = readU32(r);
+			Buffer* pIndirectBuffer = readRequiredObject<Buffer>(pReplay, r);
+			uint64_t bufferOffset = readU(r);
+			Buffer* pCounterBuffer = readObject<Buffer>(pReplay, r);
+			uint64_t counterBufferOffset = readU(r);
+			if (!endRead(r))
+				return false;
+
+			CommandCaptureLayer::cmdExecuteIndirect(pCmd, pCommandSignature, maxCommandCount, pIndirectBuffer, bufferOffset, pCounterBuffer, counterBufferOffset);
+			return true;
+		}
+		case CAPTURE_OP_CMD_BEGIN_DEBUG_MARKER:
+		case CAPTURE_OP_CMD_ADD_DEBUG_MARKER:
+		{
+			Cmd* pCmd = readRequiredObject<Cmd>(pReplay, r);
+			float red = readF(r);
+			float green = readF(r);
+			float blue = readF(r);
+			const char* pName = readS(r);
+			if (!endRead(r))
+				return false;
+
+			if (op == CAPTURE_OP_CMD_BEGIN_DEBUG_MARKER)
+				CommandCaptureLayer::cmdBeginDebugMarker(pCmd, red, green, blue, pName ? pName : "");
+			else
+				CommandCaptureLayer::cmdAddDebugMarker(pCmd, red, green, blue, pName ? pName : "");
+			return true;
+		}
+		case CAPTURE_OP_ACQUIRE_NEXT_IMAGE:
+		{
+			Renderer* pRenderer = readRequiredObject<Renderer>(pReplay, r);
+			uint32_t id = 0;
+			SwapChain* pSwapChain = readRequiredObject<SwapChain>(pReplay, r, &id);
+			Semaphore* pSemaphore = readObject<Semaphore>(pReplay, r);
+			Fence* pFence = readObject<Fence>(pReplay, r);
+			readU32(r);
+			if (!endRead(r))
+				return false;
+
+			// The image order is up to the presentation engine, queuePresent hands back what was acquired here
+			uint32_t imageIndex = 0;
+			CommandCaptureLayer::acquireNextImage(pRenderer, pSwapChain, pSemaphore, pFence, &imageIndex);
+			pReplay->mObjects[id].mImageIndex = imageIndex;
+			return true;
+		}
+		case CAPTURE_OP_QUEUE_SUBMIT:
+		{
+			Queue* pQueue = readRequiredObject<Queue>(pReplay, r);
+			tinystl::vector<Cmd*> cmds;
+			readObjects(pReplay, r, cmds);
+			Fence* pFence = readObject<Fence>(pReplay, r);
+			tinystl::vector<Semaphore*> waitSemaphores;
+			readObjects(pReplay, r, waitSemaphores);
+			tinystl::vector<Semaphore*> signalSemaphores;
+			readObjects(pReplay, r, signalSemaphores);
+			if (!endRead(r))
+				return false;
+
+			CommandCaptureLayer::queueSubmit(pQueue, (uint32_t)cmds.size(), cmds.data(), pFence, (uint32_t)waitSemaphores.size(), waitSemaphores.data(),
+				(uint32_t)signalSemaphores.size(), signalSemaphores.data());
+			++pReplay->pStats->mSubmitCount;
+			return true;
+		}
+		case CAPTURE_OP_QUEUE_PRESENT:
+		{
+			Queue* pQueue = readRequiredObject<Queue>(pReplay, r);
+			uint32_t id = 0;
+			SwapChain* pSwapChain = readRequiredObject<SwapChain>(pReplay, r, &id);
+			uint32_t imageIndex = readU32(r);
+			tinystl::vector<Semaphore*> waitSemaphores;
+			readObjects(pReplay, r, waitSemaphores);
+			if (!endRead(r))
+				return false;
+
+			if (pReplay->mObjects[id].mImageIndex != UINT32_MAX)
+				imageIndex = pReplay->mObjects[id].mImageIndex;
+			CommandCaptureLayer::queuePresent(pQueue, pSwapChain, imageIndex, (uint32_t)waitSemaphores.size(), waitSemaphores.data());
+			++pReplay->pStats->mPresentCount;
+			return true;
+		}
+		case CAPTURE_OP_WAIT_FOR_FENCES:
+		{
+			Queue* pQueue = readRequiredObject<Queue>(pReplay, r);
+			tinystl::vector<Fence*> fences;
+			readObjects(pReplay, r, fences);
+			if (!endRead(r))
+				return false;
+
+			CommandCaptureLayer::waitForFences(pQueue, (uint32_t)fences.size(), fences.data());
+			return true;
+		}
+		case CAPTURE_OP_GET_FENCE_STATUS:
+		{
+			Fence* pFence = readRequiredObject<Fence>(pReplay, r);
+			readU32(r);
+			if (!endRead(r))
+				return false;
+
+			FenceStatus status;
+			CommandCaptureLayer::getFenceStatus(pFence, &status);
+			return true;
+		}
+		default:
+			return false;
+	}
+}
+
+bool replayCommandCapture(const CommandReplayDesc* pDesc, CommandReplayStats* pStats)
+{
+	ASSERT(pDesc);
+	ASSERT(pDesc->pFileName);
+
+	CommandReplayStats stats = {};
+	tinystl::vector<uint8_t> data;
+	tinystl::vector<CaptureRecordHeader> records;
+	bool result = loadCaptureFile(pDesc->pFileName, pDesc->mRoot, &data) && readRecordHeaders(data, &records);
+	if (result)
+	{
+		stats.mRecordCount = (uint32_t)records.size();
+		for (uint32_t i = 0; i < (uint32_t)records.size(); ++i)
+			stats.mCommandCount += gCaptureOps[records[i].mOp].mCategory == CAPTURE_CATEGORY_COMMAND ? 1 : 0;
+	}
+
+	if (result && pDesc->pListingFileName)
+		result = writeCaptureListing(records, pDesc);
+
+	if (result && !pDesc->mListingOnly)
+	{
+		CommandReplay replay = {};
+		replay.pDesc = pDesc;
+		replay.pStats = &stats;
+		replay.mObjects.resize(1, ReplayObject());
+
+		// Calls are mostly shorter than the timer resolution, so time is taken for each run of records of the same
+		// category instead of for every call
+		uint64_t* pCategoryTimes[] = { &stats.mResourceTimeUSec, &stats.mCommandTimeUSec, &stats.mQueueTimeUSec };
+		CaptureCategory category = CAPTURE_CATEGORY_RESOURCE;
+		int64_t runStart = getUSec();
+		for (uint32_t i = 0; i < (uint32_t)records.size() && result; ++i)
+		{
+			const CaptureRecordHeader& record = records[i];
+			if (gCaptureOps[record.mOp].mCategory != category)
+			{
+				int64_t now = getUSec();
+				*pCategoryTimes[category] += (uint64_t)(now - runStart);
+				runStart = now;
+				category = gCaptureOps[record.mOp].mCategory;
+			}
+
+			CaptureReader reader = { record.pPayload, record.pPayload + record.mSize, false };
+			if (!replayRecord(&replay, record.mOp, &reader))
+			{
+				LOGERRORF("Command replay failed at record %u (%s)", i, gCaptureOps[record.mOp].pName);
+				result = false;
+			}
+		}
+		*pCategoryTimes[category] += (uint64_t)(getUSec() - runStart);
+	}
+
+	if (pStats)
+		*pStats = stats;
+	return result;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "IRenderer.h"
+#include "../OS/Interfaces/IFileSystem.h"
+
+/************************************************************************/
+// Command stream capture
+/************************************************************************/
+/// Building with ENABLE_COMMAND_CAPTURE routes the API calls made outside the renderer backends through
+/// the capture layer (see CommandCaptureLayer.h). While a capture is active, object creation, cmd* calls, submits
+/// and the contents of CPU visible buffers are serialized into a binary file. Objects are stored as ids assigned
+/// in creation order, so the file holds no addresses and the same call sequence always produces the same bytes.
+/// Start the capture before initRenderer so the file holds the full object history.
+void beginCommandCapture(const char* pFileName, FSRoot root);
+/// Writes the pending records and closes the capture file
+void endCommandCapture();
+bool isCommandCaptureActive();
+
+/************************************************************************/
+// Replay
+/************************************************************************/
+typedef struct CommandReplayDesc
+{
+	/// Capture file written by beginCommandCapture
+	const char*		pFileName;
+	FSRoot			mRoot;
+	/// Window handed to swapchains created during replay. May be NULL for headless backends (NULL_RENDERER)
+	WindowsDesc*	pWindow;
+	/// Optional text listing with one line per record. Objects are printed as ids and uploaded data as hashes,
+	/// so listings of two captures can be diffed directly
+	const char*		pListingFileName;
+	FSRoot			mListingRoot;
+	/// Write the listing without re-issuing any call
+	bool			mListingOnly;
+} CommandReplayDesc;
+
+typedef struct CommandReplayStats
+{
+	uint32_t	mRecordCount;
+	/// Number of cmd* calls
+	uint32_t	mCommandCount;
+	uint32_t	mSubmitCount;
+	uint32_t	mPresentCount;
+	/// Bytes restored into CPU visible buffers
+	uint64_t	mUploadedBytes;
+	/// CPU time spent in the re-issued calls (microseconds): cmd* recording, queue operations, object creation / destruction
+	uint64_t	mCommandTimeUSec;
+	uint64_t	mQueueTimeUSec;
+	uint64_t	mResourceTimeUSec;
+} CommandReplayStats;
+
+/// Re-issues all calls of a capture in file order against the backend this code is built with.
+/// Replay runs on the calling thread and is deterministic: calls are issued in the same order with the same
+/// arguments every time. Calls go through the capture layer, so a replay made while a capture is active writes
+/// the same records as the capture being replayed. Returns false if the file is missing, has the wrong version or is truncated.
+bool replayCommandCapture(const CommandReplayDesc* pDesc, CommandReplayStats* pStats);
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+// Declarations of API functions recorded by the capture layer are placed between COMMAND_CAPTURE_LAYER_BEGIN and
+// COMMAND_CAPTURE_LAYER_END: in IRenderer.h and in every file that declares such a function itself.
+// Building with ENABLE_COMMAND_CAPTURE puts them into the CommandCaptureLayer namespace everywhere except in the
+// renderer backends and the capture layer. CommandCapture.cpp defines each of them, records the call and forwards it
+// to the backend function of the same name in the global namespace. The using directive keeps unqualified calls
+// working. No name is redefined, so members named like an API function (UIRenderer::addTexture) are not affected.
+//
+// Rules when adding an API function:
+//  - declare it inside the markers only if CommandCapture.cpp has a wrapper for it, everything else stays global
+//  - backends keep defining all functions in the global namespace
+#if defined(ENABLE_COMMAND_CAPTURE) && !defined(RENDERER_IMPLEMENTATION) && !defined(COMMAND_CAPTURE_IMPLEMENTATION)
+#define COMMAND_CAPTURE_LAYER_BEGIN	namespace CommandCaptureLayer {
+#define COMMAND_CAPTURE_LAYER_END	} using namespace CommandCaptureLayer;
+#else
+#define COMMAND_CAPTURE_LAYER_BEGIN
+#define COMMAND_CAPTURE_LAYER_END
+#endif
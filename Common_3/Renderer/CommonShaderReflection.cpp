@@ -23,7 +23,9 @@
 */
 
 #include "IRenderer.h"
+#include "../OS/Interfaces/IFileSystem.h"
 #include "../OS/Interfaces/ILogManager.h"
+#include "../OS/Core/ContentHash.h"
 
 #include "../../Common_3/OS/Interfaces/IMemoryManager.h"
 
@@ -75,6 +77,56 @@ static bool ShaderVariableCmp(ShaderVariable* a, ShaderVariable* b)
 	return isSame;
 }
 
+// Hashes cover exactly the fields compared by ShaderResourceCmp / ShaderVariableCmp so equal entries always collide
+static uint64_t ShaderResourceHash(const ShaderResource* pResource)
+{
+	const uint64_t seed = ((uint64_t)pResource->type << 32 | pResource->set) ^ ((uint64_t)pResource->reg << 32 | pResource->size) * 0x9E3779B97F4A7C15ull;
+#ifdef RESOURCE_NAME_CHECK
+	return XXHash64(pResource->name, pResource->name_size, seed);
+#else
+	return XXHash64(&seed, sizeof(seed));
+#endif
+}
+
+static uint64_t ShaderVariableHash(const ShaderVariable* pVariable)
+{
+	const uint64_t seed = (uint64_t)pVariable->offset << 32 | pVariable->size;
+	return XXHash64(pVariable->name, pVariable->name_size, seed);
+}
+
+// Open hash table of indices into a merged array. Entries with equal hashes are chained through mNext
+// and resolved with the full compare function, so hash collisions never merge distinct entries
+struct MergeTable
+{
+	tinystl::unordered_map<uint64_t, uint32_t>	mHeads;
+	tinystl::vector<uint32_t>					mNext;
+};
+
+template <typename T, bool (*Cmp)(T*, T*)>
+static uint32_t FindOrAdd(MergeTable* pTable, tinystl::vector<T*>* pUnique, T* pEntry, uint64_t hash, bool* pAdded)
+{
+	tinystl::unordered_hash_node<uint64_t, uint32_t>* pHead = pTable->mHeads.find(hash).node;
+	for (uint32_t k = pHead ? pHead->second : ~0u; k != ~0u; k = pTable->mNext[k])
+	{
+		if (Cmp(pEntry, (*pUnique)[k]))
+		{
+			*pAdded = false;
+			return k;
+		}
+	}
+
+	const uint32_t index = (uint32_t)pUnique->size();
+	pUnique->push_back(pEntry);
+	// New entries become the head of their chain
+	pTable->mNext.push_back(pHead ? pHead->second : ~0u);
+	if (pHead)
+		pHead->second = index;
+	else
+		pTable->mHeads.insert({ hash, index });
+	*pAdded = true;
+	return index;
+}
+
 
 void destroyShaderReflection(ShaderReflection* pReflection)
 {
@@ -124,20 +176,38 @@ void createPipelineReflection(ShaderReflection* pReflection, uint32_t stageCount
 	}
 
 	// Combine all shaders
-	// this will have a large amount of looping
-	// 1. count number of resources
+	// Resources and variables are deduplicated across stages through hash tables. Merged entries keep the
+	// order in which they were first encountered (stage order, then declaration order within the stage)
 	uint32_t vertexStageIndex = ~0u;
 	ShaderResource* pResources = NULL;
 	uint32_t resourceCount = 0;
 	ShaderVariable* pVariables = NULL;
 	uint32_t variableCount = 0;
 
-	//Should we be using dynamic arrays for these? Perhaps we can add std::vector
-	// like functionality?
-	ShaderResource* uniqueResources[512];
-	ShaderStage     shaderUsage[512];
-	ShaderVariable* uniqueVariable[512];
-	ShaderResource* uniqueVariableParent[512];
+	uint32_t totalResourceCount = 0;
+	uint32_t totalVariableCount = 0;
+	for (uint32_t i = 0; i < stageCount; ++i)
+	{
+		totalResourceCount += pReflection[i].mShaderResourceCount;
+		totalVariableCount += pReflection[i].mVariableCount;
+	}
+
+	tinystl::vector<ShaderResource*> uniqueResources;
+	tinystl::vector<ShaderStage> shaderUsage;
+	tinystl::vector<ShaderVariable*> uniqueVariable;
+	tinystl::vector<uint32_t> uniqueVariableParent;
+	// Index of each stage resource in the merged array, used to remap variable parents
+	tinystl::vector<uint32_t> resourceRemap(totalResourceCount);
+	MergeTable resourceTable;
+	MergeTable variableTable;
+	uniqueResources.reserve(totalResourceCount);
+	shaderUsage.reserve(totalResourceCount);
+	resourceTable.mNext.reserve(totalResourceCount);
+	uniqueVariable.reserve(totalVariableCount);
+	uniqueVariableParent.reserve(totalVariableCount);
+	variableTable.mNext.reserve(totalVariableCount);
+
+	uint32_t remapOffset = 0;
 	for (uint32_t i = 0; i < stageCount; ++i)
 	{
 		ShaderReflection* pSrcRef = pReflection + i;
@@ -148,61 +218,39 @@ void createPipelineReflection(ShaderReflection* pReflection, uint32_t stageCount
 			vertexStageIndex = i;
 		}
 
-		//Loop through all shader resources
+		//Loop through all shader resources. If the resource was already added from a different shader stage,
+		// add the shader stage to the shader stage mask of that resource instead.
 		for (uint32_t j = 0; j < pSrcRef->mShaderResourceCount; ++j)
 		{
-			bool unique = true;
-
-			//Go through all already added shader resources to see if this shader
-			// resource was already added from a different shader stage. If we find a
-			// duplicate shader resource, we add the shader stage to the shader stage
-			// mask of that resource instead.
-			for (uint32_t k = 0; k < resourceCount; ++k)
-			{
-				unique = !ShaderResourceCmp(&pSrcRef->pShaderResources[j], uniqueResources[k]);
-				if (unique == false)
-				{
-					// update shader usage
-					// NOT SURE
-					//shaderUsage[k] = (ShaderStage)(shaderUsage[k] & pSrcRef->pShaderResources[j].used_stages);
-					shaderUsage[k] |= pSrcRef->pShaderResources[j].used_stages;
-					break;
-				}
-			}
-
-			//If it's unique, we add it to the list of shader resourceas
-			if (unique == true)
-			{
-				shaderUsage[resourceCount] = pSrcRef->pShaderResources[j].used_stages;
-				uniqueResources[resourceCount] = &pSrcRef->pShaderResources[j];
-				resourceCount++;
-			}
+			ShaderResource* pResource = &pSrcRef->pShaderResources[j];
+			bool added = false;
+			const uint32_t index = FindOrAdd<ShaderResource, ShaderResourceCmp>(&resourceTable, &uniqueResources, pResource, ShaderResourceHash(pResource), &added);
+			if (added)
+				shaderUsage.push_back(pResource->used_stages);
+			else
+				shaderUsage[index] = (ShaderStage)(shaderUsage[index] | pResource->used_stages);
+			resourceRemap[remapOffset + j] = index;
 		}
 
-		//Loop through all shader variables (constant/uniform buffer members)
+		//Loop through all shader variables (constant/uniform buffer members). Duplicates from other stages are dropped.
 		for (uint32_t j = 0; j < pSrcRef->mVariableCount; ++j)
 		{
-			bool unique = true;
-			//Go through all already added shader variables to see if this shader
-			// variable was already added from a different shader stage. If we find a 
-			// duplicate shader variables, we don't add it.
-			for (uint32_t k = 0; k < variableCount; ++k)
+			ShaderVariable* pVariable = &pSrcRef->pVariables[j];
+			bool added = false;
+			FindOrAdd<ShaderVariable, ShaderVariableCmp>(&variableTable, &uniqueVariable, pVariable, ShaderVariableHash(pVariable), &added);
+			if (added)
 			{
-				unique = !ShaderVariableCmp(&pSrcRef->pVariables[j], uniqueVariable[k]);
-				if (unique == false)
-					break;
-			}
-
-			//If it's unique we add it to the list of shader variables
-			if (unique)
-			{
-				uniqueVariableParent[variableCount] = &pSrcRef->pShaderResources[pSrcRef->pVariables[j].parent_index];
-				uniqueVariable[variableCount] = &pSrcRef->pVariables[j];
-				variableCount++;
+				const uint32_t parent = pVariable->parent_index;
+				uniqueVariableParent.push_back(parent < pSrcRef->mShaderResourceCount ? resourceRemap[remapOffset + parent] : parent);
 			}
 		}
+
+		remapOffset += pSrcRef->mShaderResourceCount;
 	}
 
+	resourceCount = (uint32_t)uniqueResources.size();
+	variableCount = (uint32_t)uniqueVariable.size();
+
 	//Copy over the shader resources in a dynamic array of the correct size
 	if (resourceCount)
 	{
@@ -223,16 +271,7 @@ void createPipelineReflection(ShaderReflection* pReflection, uint32_t stageCount
 		for (uint32_t i = 0; i < variableCount; ++i)
 		{
 			pVariables[i] = *uniqueVariable[i];
-			ShaderResource* parentResource = uniqueVariableParent[i];
-			// look for parent
-			for (uint32_t j = 0; j < resourceCount; ++j)
-			{
-				if (ShaderResourceCmp(&pResources[j], parentResource))
-				{
-					pVariables[i].parent_index = j;
-					break;
-				}
-			}
+			pVariables[i].parent_index = uniqueVariableParent[i];
 		}
 	}
 
@@ -262,3 +301,302 @@ void destroyPipelineReflection(PipelineReflection* pReflection)
 	conf_free(pReflection->pVariables);
 }
 
+/************************************************************************/
+// Reflection cache
+/************************************************************************/
+typedef struct ShaderReflectionCacheHeader
+{
+	uint32_t	mMagic;
+	uint32_t	mVersion;
+	uint32_t	mHeaderSize;
+	uint32_t	mDataChecksum;
+	uint64_t	mCodeHash;
+	uint64_t	mDataSize;
+	uint32_t	mShaderStage;
+	uint32_t	mNamePoolSize;
+	uint32_t	mVertexInputCount;
+	uint32_t	mShaderResourceCount;
+	uint32_t	mVariableCount;
+	uint32_t	mNumThreadsPerGroup[3];
+	uint32_t	mNumControlPoint;
+	uint32_t	mPadding;
+} ShaderReflectionCacheHeader;
+
+typedef struct VertexInputRecord
+{
+	uint32_t	mSize;
+	uint32_t	mNameOffset;
+	uint32_t	mNameSize;
+} VertexInputRecord;
+
+typedef struct ShaderResourceRecord
+{
+	uint32_t	mType;
+	uint32_t	mSet;
+	uint32_t	mReg;
+	uint32_t	mSize;
+	uint32_t	mUsedStages;
+	uint32_t	mNameOffset;
+	uint32_t	mNameSize;
+} ShaderResourceRecord;
+
+typedef struct ShaderVariableRecord
+{
+	uint32_t	mParentIndex;
+	uint32_t	mOffset;
+	uint32_t	mSize;
+	uint32_t	mNameOffset;
+	uint32_t	mNameSize;
+} ShaderVariableRecord;
+
+static uint64_t getShaderReflectionDataSize(uint32_t vertexInputCount, uint32_t resourceCount, uint32_t variableCount, uint32_t namePoolSize)
+{
+	return (uint64_t)vertexInputCount * sizeof(VertexInputRecord) +
+		(uint64_t)resourceCount * sizeof(ShaderResourceRecord) +
+		(uint64_t)variableCount * sizeof(ShaderVariableRecord) +
+		namePoolSize;
+}
+
+static uint32_t getNameOffset(const ShaderReflection* pReflection, const char* pName)
+{
+	// Every reflection name points into the name pool of its reflection
+	ASSERT(pName >= pReflection->pNamePool && pName < pReflection->pNamePool + pReflection->mNamePoolSize);
+	return (uint32_t)(pName - pReflection->pNamePool);
+}
+
+static bool isNameInPool(uint32_t nameOffset, uint32_t nameSize, uint32_t namePoolSize)
+{
+	// Names are nul terminated inside the pool
+	return (uint64_t)nameOffset + nameSize < namePoolSize;
+}
+
+uint64_t getShaderReflectionBlobSize(const ShaderReflection* pReflection)
+{
+	ASSERT(pReflection);
+	return sizeof(ShaderReflectionCacheHeader) + getShaderReflectionDataSize(pReflection->mVertexInputsCount,
+		pReflection->mShaderResourceCount, pReflection->mVariableCount, pReflection->mNamePoolSize);
+}
+
+void writeShaderReflectionBlob(const ShaderReflection* pReflection, uint64_t codeHash, void* pBlob)
+{
+	ASSERT(pReflection);
+	ASSERT(pBlob);
+
+	ShaderReflectionCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	header.mMagic = SHADER_REFLECTION_CACHE_MAGIC;
+	header.mVersion = SHADER_REFLECTION_CACHE_VERSION;
+	header.mHeaderSize = sizeof(ShaderReflectionCacheHeader);
+	header.mCodeHash = codeHash;
+	header.mDataSize = getShaderReflectionDataSize(pReflection->mVertexInputsCount,
+		pReflection->mShaderResourceCount, pReflection->mVariableCount, pReflection->mNamePoolSize);
+	header.mShaderStage = (uint32_t)pReflection->mShaderStage;
+	header.mNamePoolSize = pReflection->mNamePoolSize;
+	header.mVertexInputCount = pReflection->mVertexInputsCount;
+	header.mShaderResourceCount = pReflection->mShaderResourceCount;
+	header.mVariableCount = pReflection->mVariableCount;
+	memcpy(header.mNumThreadsPerGroup, pReflection->mNumThreadsPerGroup, sizeof(header.mNumThreadsPerGroup));
+	header.mNumControlPoint = pReflection->mNumControlPoint;
+
+	uint8_t* pData = (uint8_t*)pBlob + sizeof(header);
+	uint8_t* pCurrent = pData;
+
+	for (uint32_t i = 0; i < pReflection->mVertexInputsCount; ++i)
+	{
+		const VertexInput* pInput = &pReflection->pVertexInputs[i];
+		VertexInputRecord record = { pInput->size, getNameOffset(pReflection, pInput->name), pInput->name_size };
+		memcpy(pCurrent, &record, sizeof(record));
+		pCurrent += sizeof(record);
+	}
+
+	for (uint32_t i = 0; i < pReflection->mShaderResourceCount; ++i)
+	{
+		const ShaderResource* pResource = &pReflection->pShaderResources[i];
+		ShaderResourceRecord record = { (uint32_t)pResource->type, pResource->set, pResource->reg, pResource->size,
+			(uint32_t)pResource->used_stages, getNameOffset(pReflection, pResource->name), pResource->name_size };
+		memcpy(pCurrent, &record, sizeof(record));
+		pCurrent += sizeof(record);
+	}
+
+	for (uint32_t i = 0; i < pReflection->mVariableCount; ++i)
+	{
+		const ShaderVariable* pVariable = &pReflection->pVariables[i];
+		ShaderVariableRecord record = { pVariable->parent_index, pVariable->offset, pVariable->size,
+			getNameOffset(pReflection, pVariable->name), pVariable->name_size };
+		memcpy(pCurrent, &record, sizeof(record));
+		pCurrent += sizeof(record);
+	}
+
+	if (pReflection->mNamePoolSize)
+		memcpy(pCurrent, pReflection->pNamePool, pReflection->mNamePoolSize);
+
+	header.mDataChecksum = Crc32c(pData, (size_t)header.mDataSize);
+	memcpy(pBlob, &header, sizeof(header));
+}
+
+bool readShaderReflectionBlob(const void* pBlob, uint64_t blobSize, uint64_t codeHash, ShaderReflection* pOutReflection)
+{
+	ASSERT(pOutReflection);
+	memset(pOutReflection, 0, sizeof(*pOutReflection));
+
+	if (!pBlob || blobSize < sizeof(ShaderReflectionCacheHeader))
+		return false;
+
+	ShaderReflectionCacheHeader header;
+	memcpy(&header, pBlob, sizeof(header));
+	if (header.mMagic != SHADER_REFLECTION_CACHE_MAGIC || header.mVersion != SHADER_REFLECTION_CACHE_VERSION ||
+		header.mHeaderSize != sizeof(ShaderReflectionCacheHeader))
+		return false;
+	// Stale cache, the byte code was recompiled since the reflection was written
+	if (header.mCodeHash != codeHash)
+		return false;
+	if (header.mDataSize != getShaderReflectionDataSize(header.mVertexInputCount, header.mShaderResourceCount, header.mVariableCount, header.mNamePoolSize) ||
+		header.mDataSize > blobSize - sizeof(ShaderReflectionCacheHeader))
+	{
+		LOGWARNING("Shader reflection cache is truncated");
+		return false;
+	}
+
+	const uint8_t* pData = (const uint8_t*)pBlob + sizeof(ShaderReflectionCacheHeader);
+	if (Crc32c(pData, (size_t)header.mDataSize) != header.mDataChecksum)
+	{
+		LOGWARNING("Shader reflection cache checksum mismatch");
+		return false;
+	}
+
+	const uint8_t* pVertexInputRecords = pData;
+	const uint8_t* pResourceRecords = pVertexInputRecords + header.mVertexInputCount * sizeof(VertexInputRecord);
+	const uint8_t* pVariableRecords = pResourceRecords + header.mShaderResourceCount * sizeof(ShaderResourceRecord);
+	const char* pNames = (const char*)(pVariableRecords + header.mVariableCount * sizeof(ShaderVariableRecord));
+
+	// Validate all name ranges before allocating anything
+	for (uint32_t i = 0; i < header.mVertexInputCount; ++i)
+	{
+		VertexInputRecord record;
+		memcpy(&record, pVertexInputRecords + i * sizeof(record), sizeof(record));
+		if (!isNameInPool(record.mNameOffset, record.mNameSize, header.mNamePoolSize))
+			return false;
+	}
+	for (uint32_t i = 0; i < header.mShaderResourceCount; ++i)
+	{
+		ShaderResourceRecord record;
+		memcpy(&record, pResourceRecords + i * sizeof(record), sizeof(record));
+		if (!isNameInPool(record.mNameOffset, record.mNameSize, header.mNamePoolSize))
+			return false;
+	}
+	for (uint32_t i = 0; i < header.mVariableCount; ++i)
+	{
+		ShaderVariableRecord record;
+		memcpy(&record, pVariableRecords + i * sizeof(record), sizeof(record));
+		if (!isNameInPool(record.mNameOffset, record.mNameSize, header.mNamePoolSize) ||
+			(record.mParentIndex != (uint32_t)-1 && record.mParentIndex >= header.mShaderResourceCount))
+			return false;
+	}
+
+	char* namePool = NULL;
+	if (header.mNamePoolSize)
+	{
+		namePool = (char*)conf_malloc(header.mNamePoolSize);
+		memcpy(namePool, pNames, header.mNamePoolSize);
+	}
+
+	VertexInput* pVertexInputs = NULL;
+	if (header.mVertexInputCount)
+	{
+		pVertexInputs = (VertexInput*)conf_malloc(sizeof(VertexInput) * header.mVertexInputCount);
+		for (uint32_t i = 0; i < header.mVertexInputCount; ++i)
+		{
+			VertexInputRecord record;
+			memcpy(&record, pVertexInputRecords + i * sizeof(record), sizeof(record));
+			pVertexInputs[i].size = record.mSize;
+			pVertexInputs[i].name = namePool + record.mNameOffset;
+			pVertexInputs[i].name_size = record.mNameSize;
+		}
+	}
+
+	ShaderResource* pResources = NULL;
+	if (header.mShaderResourceCount)
+	{
+		pResources = (ShaderResource*)conf_calloc(header.mShaderResourceCount, sizeof(ShaderResource));
+		for (uint32_t i = 0; i < header.mShaderResourceCount; ++i)
+		{
+			ShaderResourceRecord record;
+			memcpy(&record, pResourceRecords + i * sizeof(record), sizeof(record));
+			pResources[i].type = (DescriptorType)record.mType;
+			pResources[i].set = record.mSet;
+			pResources[i].reg = record.mReg;
+			pResources[i].size = record.mSize;
+			pResources[i].used_stages = (ShaderStage)record.mUsedStages;
+			pResources[i].name = namePool + record.mNameOffset;
+			pResources[i].name_size = record.mNameSize;
+		}
+	}
+
+	ShaderVariable* pVariables = NULL;
+	if (header.mVariableCount)
+	{
+		pVariables = (ShaderVariable*)conf_malloc(sizeof(ShaderVariable) * header.mVariableCount);
+		for (uint32_t i = 0; i < header.mVariableCount; ++i)
+		{
+			ShaderVariableRecord record;
+			memcpy(&record, pVariableRecords + i * sizeof(record), sizeof(record));
+			pVariables[i].parent_index = record.mParentIndex;
+			pVariables[i].offset = record.mOffset;
+			pVariables[i].size = record.mSize;
+			pVariables[i].name = namePool + record.mNameOffset;
+			pVariables[i].name_size = record.mNameSize;
+		}
+	}
+
+	pOutReflection->mShaderStage = (ShaderStage)header.mShaderStage;
+	pOutReflection->pNamePool = namePool;
+	pOutReflection->mNamePoolSize = header.mNamePoolSize;
+	pOutReflection->pVertexInputs = pVertexInputs;
+	pOutReflection->mVertexInputsCount = header.mVertexInputCount;
+	pOutReflection->pShaderResources = pResources;
+	pOutReflection->mShaderResourceCount = header.mShaderResourceCount;
+	pOutReflection->pVariables = pVariables;
+	pOutReflection->mVariableCount = header.mVariableCount;
+	memcpy(pOutReflection->mNumThreadsPerGroup, header.mNumThreadsPerGroup, sizeof(header.mNumThreadsPerGroup));
+	pOutReflection->mNumControlPoint = header.mNumControlPoint;
+	return true;
+}
+
+bool loadShaderReflectionFile(const char* filePath, uint64_t codeHash, ShaderReflection* pOutReflection)
+{
+	ASSERT(filePath);
+	ASSERT(pOutReflection);
+	memset(pOutReflection, 0, sizeof(*pOutReflection));
+
+	if (!FileSystem::FileExists(filePath, FSR_Absolute))
+		return false;
+
+	File file;
+	if (!file.Open(filePath, FM_ReadBinary, FSR_Absolute))
+		return false;
+
+	tinystl::vector<uint8_t> blob(file.GetSize());
+	unsigned bytesRead = blob.size() ? file.Read(blob.data(), (unsigned)blob.size()) : 0;
+	file.Close();
+
+	return readShaderReflectionBlob(blob.data(), bytesRead, codeHash, pOutReflection);
+}
+
+bool saveShaderReflectionFile(const char* filePath, uint64_t codeHash, const ShaderReflection* pReflection)
+{
+	ASSERT(filePath);
+	ASSERT(pReflection);
+
+	tinystl::vector<uint8_t> blob((size_t)getShaderReflectionBlobSize(pReflection));
+	writeShaderReflectionBlob(pReflection, codeHash, blob.data());
+
+	File file;
+	if (!file.Open(filePath, FM_WriteBinary, FSR_Absolute))
+	{
+		LOGWARNINGF("Could not write shader reflection cache %s", filePath);
+		return false;
+	}
+	unsigned written = file.Write(blob.data(), (unsigned)blob.size());
+	file.Close();
+	return written == blob.size();
+}
@@ -888,9 +888,22 @@ namespace RENDERER_CPP_NAMESPACE {
 		}
 	}
 
-	const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const char* pResName, uint32_t* pIndex)
+	const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const DescriptorData* pParam, uint32_t* pIndex)
 	{
-		DescriptorNameToIndexMap::const_iterator it = pRootSignature->pDescriptorNameToIndexMap.find(tinystl::hash(pResName));
+		// Slot resolved up front through getDescriptorIndexFromName - no string hashing required
+		if (pParam->mIndex != (uint32_t)-1)
+		{
+			if (pParam->mIndex >= pRootSignature->mDescriptorCount)
+			{
+				LOGERRORF("Invalid descriptor index (%u). Root signature has (%u) descriptors", pParam->mIndex, pRootSignature->mDescriptorCount);
+				return NULL;
+			}
+
+			*pIndex = pParam->mIndex;
+			return &pRootSignature->pDescriptors[pParam->mIndex];
+		}
+
+		DescriptorNameToIndexMap::const_iterator it = pRootSignature->pDescriptorNameToIndexMap.find(tinystl::hash(pParam->pName));
 		if (it.node)
 		{
 			*pIndex = it.node->second;
@@ -898,11 +911,24 @@ namespace RENDERER_CPP_NAMESPACE {
 		}
 		else
 		{
-			LOGERRORF("Invalid descriptor param (%s)", pResName);
+			LOGERRORF("Invalid descriptor param (%s)", pParam->pName);
 			return NULL;
 		}
 	}
 
+	uint32_t getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName)
+	{
+		ASSERT(pRootSignature);
+		ASSERT(pName);
+
+		DescriptorNameToIndexMap::const_iterator it = pRootSignature->pDescriptorNameToIndexMap.find(tinystl::hash(pName));
+		if (it.node)
+			return it.node->second;
+
+		LOGERRORF("Invalid descriptor param (%s)", pName);
+		return (uint32_t)-1;
+	}
+
 #define MAX_DYNAMIC_VIEW_DESCRIPTORS_PER_FRAME gGpuDescriptorHeapProperties[0].mMaxDescriptors / 16
 #define MAX_DYNAMIC_SAMPLER_DESCRIPTORS_PER_FRAME gGpuDescriptorHeapProperties[1].mMaxDescriptors / 16
 
@@ -951,16 +977,18 @@ namespace RENDERER_CPP_NAMESPACE {
 			const DescriptorData* pParam = &pDescParams[i];
 
 			ASSERT(pParam);
-			if (!pParam->pName)
+			if (!pParam->pName && pParam->mIndex == (uint32_t)-1)
 			{
-				LOGERRORF("Name of Descriptor at index (%u) is NULL", i);
+				LOGERRORF("Name and index of Descriptor at index (%u) are both unset", i);
 				return;
 			}
 
 			uint32_t descIndex = ~0u;
-			const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pParam->pName, &descIndex);
+			const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pParam, &descIndex);
 			if (!pDesc)
 				continue;
+			// Name used for error reporting. pParam->pName may be NULL when binding by index
+			const char* pDescName = pDesc->mDesc.name;
 
 			// Find the update frequency of the descriptor
 			const DescriptorUpdateFrequency setIndex = pDesc->mUpdateFrquency;
@@ -970,7 +998,7 @@ namespace RENDERER_CPP_NAMESPACE {
 			{
 				if (!pParam->pRootConstant)
 				{
-					LOGERRORF("Root constant (%s) is NULL", pParam->pName);
+					LOGERRORF("Root constant (%s) is NULL", pDescName);
 					continue;
 				}
 				if (pRootSignature->mPipelineType == PIPELINE_TYPE_COMPUTE)
@@ -991,7 +1019,7 @@ namespace RENDERER_CPP_NAMESPACE {
 			{
 				if (!pParam->ppBuffers[0])
 				{
-					LOGERRORF("Root descriptor CBV (%s) is NULL", pParam->pName);
+					LOGERRORF("Root descriptor CBV (%s) is NULL", pDescName);
 					continue;
 				}
 				D3D12_GPU_VIRTUAL_ADDRESS cbv = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
@@ -1038,18 +1066,18 @@ namespace RENDERER_CPP_NAMESPACE {
 			case DESCRIPTOR_TYPE_SAMPLER:
 				if (pDesc->mIndexInParent == -1)
 				{
-					LOGERRORF("Trying to bind a static sampler (%s). All static samplers must be bound in addRootSignature through RootSignatureDesc::mStaticSamplers", pParam->pName);
+					LOGERRORF("Trying to bind a static sampler (%s). All static samplers must be bound in addRootSignature through RootSignatureDesc::mStaticSamplers", pDescName);
 					continue;
 				}
 				if (!pParam->ppSamplers)
 				{
-					LOGERRORF("Sampler descriptor (%s) is NULL", pParam->pName);
+					LOGERRORF("Sampler descriptor (%s) is NULL", pDescName);
 					return;
 				}
 				for (uint32_t j = 0; j < pParam->mCount; ++j)
 				{
 					if (!pParam->ppSamplers[j]) {
-						LOGERRORF("Sampler descriptor (%s) at array index (%u) is NULL", pParam->pName, j);
+						LOGERRORF("Sampler descriptor (%s) at array index (%u) is NULL", pDescName, j);
 						return;
 					}
 					pHash[setIndex] = tinystl::hash_state(&pParam->ppSamplers[j]->mSamplerId, 1, pHash[setIndex]);
@@ -1060,7 +1088,7 @@ namespace RENDERER_CPP_NAMESPACE {
 			{
 				if (!pParam->ppTextures)
 				{
-					LOGERRORF("Texture descriptor (%s) is NULL", pParam->pName);
+					LOGERRORF("Texture descriptor (%s) is NULL", pDescName);
 					return;
 				}
 				D3D12_CPU_DESCRIPTOR_HANDLE* handlePtr = &pm->pViewDescriptorHandles[setIndex][pDesc->mHandleIndex];
@@ -1070,7 +1098,7 @@ namespace RENDERER_CPP_NAMESPACE {
 #ifdef _DEBUG
 					if (!pParam->ppTextures[j])
 					{
-						LOGERRORF("Texture descriptor (%s) at array index (%u) is NULL", pParam->pName, j);
+						LOGERRORF("Texture descriptor (%s) at array index (%u) is NULL", pDescName, j);
 						return;
 					}
 #endif
@@ -1087,14 +1115,14 @@ namespace RENDERER_CPP_NAMESPACE {
 			case DESCRIPTOR_TYPE_RW_TEXTURE:
 				if (!pParam->ppTextures)
 				{
-					LOGERRORF("Texture descriptor (%s) is NULL", pParam->pName);
+					LOGERRORF("Texture descriptor (%s) is NULL", pDescName);
 					return;
 				}
 				for (uint32_t j = 0; j < pParam->mCount; ++j)
 				{
 					if (!pParam->ppBuffers[j])
 					{
-						LOGERRORF("Texture descriptor (%s) at array index (%u) is NULL", pParam->pName, j);
+						LOGERRORF("Texture descriptor (%s) at array index (%u) is NULL", pDescName, j);
 						return;
 					}
 					pHash[setIndex] = tinystl::hash_state(&pParam->ppTextures[j]->mTextureId, 1, pHash[setIndex]);
@@ -1110,14 +1138,14 @@ namespace RENDERER_CPP_NAMESPACE {
 			case DESCRIPTOR_TYPE_BUFFER:
 				if (!pParam->ppBuffers)
 				{
-					LOGERRORF("Buffer descriptor (%s) is NULL", pParam->pName);
+					LOGERRORF("Buffer descriptor (%s) is NULL", pDescName);
 					return;
 				}
 				for (uint32_t j = 0; j < pParam->mCount; ++j)
 				{
 					if (!pParam->ppBuffers[j])
 					{
-						LOGERRORF("Buffer descriptor (%s) at array index (%u) is NULL", pParam->pName, j);
+						LOGERRORF("Buffer descriptor (%s) at array index (%u) is NULL", pDescName, j);
 						return;
 					}
 					pHash[setIndex] = tinystl::hash_state(&pParam->ppBuffers[j]->mBufferId, 1, pHash[setIndex]);
@@ -1140,14 +1168,14 @@ namespace RENDERER_CPP_NAMESPACE {
 			case DESCRIPTOR_TYPE_RW_BUFFER:
 				if (!pParam->ppBuffers)
 				{
-					LOGERRORF("Buffer descriptor (%s) is NULL", pParam->pName);
+					LOGERRORF("Buffer descriptor (%s) is NULL", pDescName);
 					return;
 				}
 				for (uint32_t j = 0; j < pParam->mCount; ++j)
 				{
 					if (!pParam->ppBuffers[j])
 					{
-						LOGERRORF("Buffer descriptor (%s) at array index (%u) is NULL", pParam->pName, j);
+						LOGERRORF("Buffer descriptor (%s) at array index (%u) is NULL", pDescName, j);
 						return;
 					}
 					pHash[setIndex] = tinystl::hash_state(&pParam->ppBuffers[j]->mBufferId, 1, pHash[setIndex]);
@@ -1163,14 +1191,14 @@ namespace RENDERER_CPP_NAMESPACE {
 			case DESCRIPTOR_TYPE_UNIFORM_BUFFER:
 				if (!pParam->ppBuffers)
 				{
-					LOGERRORF("Buffer descriptor (%s) is NULL", pParam->pName);
+					LOGERRORF("Buffer descriptor (%s) is NULL", pDescName);
 					return;
 				}
 				for (uint32_t j = 0; j < pParam->mCount; ++j)
 				{
 					if (!pParam->ppBuffers[j])
 					{
-						LOGERRORF("Buffer descriptor (%s) at array index (%u) is NULL", pParam->pName, j);
+						LOGERRORF("Buffer descriptor (%s) at array index (%u) is NULL", pDescName, j);
 						return;
 					}
 					pHash[setIndex] = tinystl::hash_state(&pParam->ppBuffers[j]->mBufferId, 1, pHash[setIndex]);
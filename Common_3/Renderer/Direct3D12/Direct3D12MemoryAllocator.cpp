@@ -93,6 +93,19 @@ void resourceAllocCalculateStats(
 		allocator->CalculateStats(pStats);
 }
 
+void resourceAllocPlanDefragmentation(
+	ResourceAllocator* allocator,
+	uint32_t memoryTypeIndex,
+	UINT64 maxBytesToMove,
+	uint32_t maxMoves,
+	tinystl::vector<AllocatorDefragmentationMove>* pMoves,
+	DefragmentationStats* pStats)
+{
+	ASSERT(allocator && pMoves && pStats);
+	RESOURCE_DEBUG_GLOBAL_MUTEX_LOCK
+		allocator->PlanDefragmentation(memoryTypeIndex, maxBytesToMove, maxMoves, pMoves, pStats);
+}
+
 
 //#if RESOURCE_STATS_STRING_ENABLED
 
@@ -717,26 +730,11 @@ void* ResourceAllocation::GetMappedData() const
 	}
 }
 
-struct AllocatorSuballocationItemSizeLess
-{
-	bool operator()(
-		const AllocatorSuballocationList::iterator lhs,
-		const AllocatorSuballocationList::iterator rhs) const
-	{
-		return lhs->size < rhs->size;
-	}
-	bool operator()(
-		const AllocatorSuballocationList::iterator lhs,
-		UINT64 rhsSize) const
-	{
-		return lhs->size < rhsSize;
-	}
-};
-
 AllocatorBlock::AllocatorBlock(ResourceAllocator* hAllocator) :
 	m_MemoryTypeIndex(UINT32_MAX),
 	m_BlockVectorType(RESOURCE_BLOCK_VECTOR_TYPE_COUNT),
 	m_hMemory(NULL),
+	m_hResource(NULL),
 	m_Size(0),
 	m_PersistentMap(false),
 	m_pMappedData(RESOURCE_NULL),
@@ -768,7 +766,7 @@ void AllocatorBlock::Init(
 	m_SumFreeSize = newSize;
 
 	m_Suballocations.clear();
-	m_FreeSuballocationsBySize.clear();
+	m_FreeSuballocations.Reset();
 
 	AllocatorSuballocation suballoc = {};
 	suballoc.offset = 0;
@@ -778,7 +776,7 @@ void AllocatorBlock::Init(
 	m_Suballocations.push_back(suballoc);
 	AllocatorSuballocationList::iterator suballocItem = m_Suballocations.end();
 	--suballocItem;
-	m_FreeSuballocationsBySize.push_back(suballocItem);
+	RegisterFreeSuballocation(suballocItem);
 }
 
 void AllocatorBlock::Init(
@@ -801,7 +799,7 @@ void AllocatorBlock::Init(
 	m_SumFreeSize = newSize;
 
 	m_Suballocations.clear();
-	m_FreeSuballocationsBySize.clear();
+	m_FreeSuballocations.Reset();
 
 	AllocatorSuballocation suballoc = {};
 	suballoc.offset = 0;
@@ -811,7 +809,7 @@ void AllocatorBlock::Init(
 	m_Suballocations.push_back(suballoc);
 	AllocatorSuballocationList::iterator suballocItem = m_Suballocations.end();
 	--suballocItem;
-	m_FreeSuballocationsBySize.push_back(suballocItem);
+	RegisterFreeSuballocation(suballocItem);
 }
 
 void AllocatorBlock::Destroy(ResourceAllocator* allocator)
@@ -839,7 +837,7 @@ void AllocatorBlock::Destroy(ResourceAllocator* allocator)
 
 bool AllocatorBlock::Validate() const
 {
-	if ((m_hMemory == NULL) ||
+	if ((m_hMemory == NULL && m_hResource == NULL) ||
 		(m_Size == 0) ||
 		m_Suballocations.empty())
 	{
@@ -853,8 +851,8 @@ bool AllocatorBlock::Validate() const
 	// Expected sum size of free suballocations as calculated from traversing their list.
 	UINT64 calculatedSumFreeSize = 0;
 	// Expected number of free suballocations that should be registered in
-	// m_FreeSuballocationsBySize calculated from traversing their list.
-	size_t freeSuballocationsToRegister = 0;
+	// m_FreeSuballocations calculated from traversing their list.
+	uint32_t freeSuballocationsToRegister = 0;
 	// True if previous visisted suballocation was free.
 	bool prevFree = false;
 
@@ -878,6 +876,16 @@ bool AllocatorBlock::Validate() const
 		}
 		prevFree = currFree;
 
+		// Only free suballocations are owned by nothing, only they can be linked into m_FreeSuballocations.
+		if ((subAlloc.allocation == RESOURCE_NULL) != currFree)
+		{
+			return false;
+		}
+		if (!currFree && (subAlloc.pPrevFree != RESOURCE_NULL || subAlloc.pNextFree != RESOURCE_NULL))
+		{
+			return false;
+		}
+
 		if (currFree)
 		{
 			calculatedSumFreeSize += subAlloc.size;
@@ -891,30 +899,17 @@ bool AllocatorBlock::Validate() const
 		calculatedOffset += subAlloc.size;
 	}
 
-	// Number of free suballocations registered in m_FreeSuballocationsBySize doesn't
+	// Number of free suballocations registered in m_FreeSuballocations doesn't
 	// match expected one.
-	if (m_FreeSuballocationsBySize.size() != freeSuballocationsToRegister)
+	if (m_FreeSuballocations.GetCount() != freeSuballocationsToRegister)
 	{
 		return false;
 	}
 
-	UINT64 lastSize = 0;
-	for (size_t i = 0; i < m_FreeSuballocationsBySize.size(); ++i)
+	// Every registered suballocation must sit in the bin of its size.
+	if (!m_FreeSuballocations.Validate())
 	{
-		AllocatorSuballocationList::iterator suballocItem = m_FreeSuballocationsBySize[i];
-
-		// Only free suballocations can be registered in m_FreeSuballocationsBySize.
-		if (suballocItem->type != RESOURCE_SUBALLOCATION_TYPE_FREE)
-		{
-			return false;
-		}
-		// They must be sorted by size ascending.
-		if (suballocItem->size < lastSize)
-		{
-			return false;
-		}
-
-		lastSize = suballocItem->size;
+		return false;
 	}
 
 	// Check if totals match calculacted values.
@@ -981,44 +976,80 @@ bool AllocatorBlock::CreateAllocationRequest(
 	}
 	*/
 
-	// New algorithm, efficiently searching freeSuballocationsBySize.
-	const size_t freeSuballocCount = m_FreeSuballocationsBySize.size();
-	if (freeSuballocCount > 0)
+	// New algorithm, searching the two-level segregated fit bins of m_FreeSuballocations.
+	if (m_FreeSuballocations.GetCount() > 0)
 	{
 		if (RESOURCE_BEST_FIT)
 		{
-			// Find first free suballocation with size not less than allocSize.
-			AllocatorSuballocationList::iterator* const it = AllocatorBinaryFindFirstNotLess(
-				m_FreeSuballocationsBySize.data(),
-				m_FreeSuballocationsBySize.data() + freeSuballocCount,
-				allocSize,
-				AllocatorSuballocationItemSizeLess());
-			size_t index = it - m_FreeSuballocationsBySize.data();
-			for (; index < freeSuballocCount; ++index)
+			// Tightest bin first, placed resources are usually aligned already.
+			AllocatorSuballocationList::iterator suballocItem;
+			AllocatorListItem<AllocatorSuballocation>* pItem = m_FreeSuballocations.FindFree(allocSize);
+			if (pItem != RESOURCE_NULL)
 			{
-				UINT64 offset = 0;
-				const AllocatorSuballocationList::iterator suballocItem = m_FreeSuballocationsBySize[index];
-				if (CheckAllocation(bufferImageGranularity, allocSize, allocAlignment, allocType, suballocItem, &offset))
+				suballocItem = m_Suballocations.from_item(pItem);
+				if (CheckAllocation(bufferImageGranularity, allocSize, allocAlignment, allocType, suballocItem, &pAllocationRequest->offset))
 				{
 					pAllocationRequest->freeSuballocationItem = suballocItem;
-					pAllocationRequest->offset = offset;
 					return true;
 				}
 			}
+
+			// Anything in these bins fits even with worst case alignment padding and margins,
+			// unless bufferImageGranularity gets in the way.
+			const UINT64 alignment = RESOURCE_MAX(allocAlignment, static_cast<UINT64>(RESOURCE_DEBUG_ALIGNMENT));
+			pItem = m_FreeSuballocations.FindFree(allocSize + alignment - 1 + 2 * RESOURCE_DEBUG_MARGIN);
+			if (pItem != RESOURCE_NULL)
+			{
+				suballocItem = m_Suballocations.from_item(pItem);
+				if (CheckAllocation(bufferImageGranularity, allocSize, allocAlignment, allocType, suballocItem, &pAllocationRequest->offset))
+				{
+					pAllocationRequest->freeSuballocationItem = suballocItem;
+					return true;
+				}
+			}
+
+			// Whether the remaining ones fit depends on their offset. Check them all,
+			// starting from the bin that holds allocSize.
+			uint32_t fl, sl;
+			tlsfMapInsert(allocSize, &fl, &sl);
+			while (m_FreeSuballocations.FindBin(&fl, &sl))
+			{
+				if (CheckFreeList(m_FreeSuballocations.GetHead(fl, sl), bufferImageGranularity, allocSize, allocAlignment, allocType, pAllocationRequest))
+				{
+					return true;
+				}
+				if (++sl == TLSF_SL_COUNT)
+				{
+					sl = 0;
+					++fl;
+				}
+			}
 		}
 		else
 		{
 			// Search staring from biggest suballocations.
-			for (size_t index = freeSuballocCount; index--; )
+			uint32_t fl, sl;
+			bool found = m_FreeSuballocations.GetLastBin(&fl, &sl);
+			while (found)
 			{
-				UINT64 offset = 0;
-				const AllocatorSuballocationList::iterator suballocItem = m_FreeSuballocationsBySize[index];
-				if (CheckAllocation(bufferImageGranularity, allocSize, allocAlignment, allocType, suballocItem, &offset))
+				if (CheckFreeList(m_FreeSuballocations.GetHead(fl, sl), bufferImageGranularity, allocSize, allocAlignment, allocType, pAllocationRequest))
 				{
-					pAllocationRequest->freeSuballocationItem = suballocItem;
-					pAllocationRequest->offset = offset;
 					return true;
 				}
+				if (sl > 0)
+				{
+					--sl;
+				}
+				else if (fl > 0)
+				{
+					--fl;
+					sl = TLSF_SL_COUNT - 1;
+				}
+				else
+				{
+					break;
+				}
+				found = m_FreeSuballocations.FindBinReverse(&fl, &sl);
 			}
 		}
 	}
@@ -1026,6 +1057,28 @@ bool AllocatorBlock::CreateAllocationRequest(
 	return false;
 }
 
+bool AllocatorBlock::CheckFreeList(
+	AllocatorListItem<AllocatorSuballocation>* pHead,
+	UINT64 bufferImageGranularity,
+	UINT64 allocSize,
+	UINT64 allocAlignment,
+	AllocatorSuballocationType allocType,
+	AllocatorAllocationRequest* pAllocationRequest)
+{
+	for (AllocatorListItem<AllocatorSuballocation>* pItem = pHead; pItem != RESOURCE_NULL; pItem = pItem->Value.pNextFree)
+	{
+		UINT64 offset = 0;
+		const AllocatorSuballocationList::iterator suballocItem = m_Suballocations.from_item(pItem);
+		if (CheckAllocation(bufferImageGranularity, allocSize, allocAlignment, allocType, suballocItem, &offset))
+		{
+			pAllocationRequest->freeSuballocationItem = suballocItem;
+			pAllocationRequest->offset = offset;
+			return true;
+		}
+	}
+	return false;
+}
+
 bool AllocatorBlock::CheckAllocation(
 	UINT64 bufferImageGranularity,
 	UINT64 allocSize,
@@ -1140,10 +1193,11 @@ bool AllocatorBlock::IsEmpty() const
 	return (m_Suballocations.size() == 1) && (m_FreeCount == 1);
 }
 
-void AllocatorBlock::Alloc(
+AllocatorSuballocationList::iterator AllocatorBlock::Alloc(
 	const AllocatorAllocationRequest& request,
 	AllocatorSuballocationType type,
-	UINT64 allocSize)
+	UINT64 allocSize,
+	ResourceAllocation* hAllocation)
 {
 	ASSERT(request.freeSuballocationItem != m_Suballocations.end());
 	AllocatorSuballocation& suballoc = *request.freeSuballocationItem;
@@ -1155,13 +1209,14 @@ void AllocatorBlock::Alloc(
 	ASSERT(suballoc.size >= paddingBegin + allocSize);
 	const UINT64 paddingEnd = suballoc.size - paddingBegin - allocSize;
 
-	// Unregister this free suballocation from m_FreeSuballocationsBySize and update
+	// Unregister this free suballocation from m_FreeSuballocations and update
 	// it to become used.
 	UnregisterFreeSuballocation(request.freeSuballocationItem);
 
 	suballoc.offset = request.offset;
 	suballoc.size = allocSize;
 	suballoc.type = type;
+	suballoc.allocation = hAllocation;
 
 	// If there are any free bytes remaining at the end, insert new free suballocation after current one.
 	if (paddingEnd)
@@ -1200,6 +1255,8 @@ void AllocatorBlock::Alloc(
 		++m_FreeCount;
 	}
 	m_SumFreeSize -= allocSize;
+
+	return request.freeSuballocationItem;
 }
 
 void AllocatorBlock::FreeSuballocation(AllocatorSuballocationList::iterator suballocItem)
@@ -1207,6 +1264,7 @@ void AllocatorBlock::FreeSuballocation(AllocatorSuballocationList::iterator suba
 	// Change this suballocation to be marked as free.
 	AllocatorSuballocation& suballoc = *suballocItem;
 	suballoc.type = RESOURCE_SUBALLOCATION_TYPE_FREE;
+	suballoc.allocation = RESOURCE_NULL;
 
 	// Update totals.
 	++m_FreeCount;
@@ -1251,20 +1309,12 @@ void AllocatorBlock::FreeSuballocation(AllocatorSuballocationList::iterator suba
 
 void AllocatorBlock::Free(const ResourceAllocation* allocation)
 {
-	const UINT64 allocationOffset = allocation->GetOffset();
-	for (AllocatorSuballocationList::iterator suballocItem = m_Suballocations.begin();
-		suballocItem != m_Suballocations.end();
-		++suballocItem)
-	{
-		AllocatorSuballocation& suballoc = *suballocItem;
-		if (suballoc.offset == allocationOffset)
-		{
-			FreeSuballocation(suballocItem);
-			RESOURCE_HEAVY_ASSERT(Validate());
-			return;
-		}
-	}
-	ASSERT(0 && "Not found!");
+	// The allocation remembers its suballocation, no need to search for the offset.
+	AllocatorSuballocationList::iterator suballocItem = m_Suballocations.from_item(allocation->GetSuballocation());
+	ASSERT(suballocItem != m_Suballocations.end());
+	ASSERT(suballocItem->allocation == allocation && suballocItem->offset == allocation->GetOffset());
+	FreeSuballocation(suballocItem);
+	RESOURCE_HEAVY_ASSERT(Validate());
 }
 
 //#if RESOURCE_STATS_STRING_ENABLED
@@ -1329,20 +1379,7 @@ void AllocatorBlock::RegisterFreeSuballocation(AllocatorSuballocationList::itera
 
 	if (item->size >= RESOURCE_MIN_FREE_SUBALLOCATION_SIZE_TO_REGISTER)
 	{
-		if (m_FreeSuballocationsBySize.empty())
-		{
-			m_FreeSuballocationsBySize.push_back(item);
-		}
-		else
-		{
-			AllocatorSuballocationList::iterator* const it = AllocatorBinaryFindFirstNotLess(
-				m_FreeSuballocationsBySize.data(),
-				m_FreeSuballocationsBySize.data() + m_FreeSuballocationsBySize.size(),
-				item,
-				AllocatorSuballocationItemSizeLess());
-			size_t index = it - m_FreeSuballocationsBySize.data();
-			VectorInsert(m_FreeSuballocationsBySize, index, item);
-		}
+		m_FreeSuballocations.Insert(AllocatorSuballocationList::item(item));
 	}
 }
 
@@ -1353,23 +1390,7 @@ void AllocatorBlock::UnregisterFreeSuballocation(AllocatorSuballocationList::ite
 
 	if (item->size >= RESOURCE_MIN_FREE_SUBALLOCATION_SIZE_TO_REGISTER)
 	{
-		AllocatorSuballocationList::iterator* const it = AllocatorBinaryFindFirstNotLess(
-			m_FreeSuballocationsBySize.data(),
-			m_FreeSuballocationsBySize.data() + m_FreeSuballocationsBySize.size(),
-			item,
-			AllocatorSuballocationItemSizeLess());
-		for (size_t index = it - m_FreeSuballocationsBySize.data();
-			index < m_FreeSuballocationsBySize.size();
-			++index)
-		{
-			if (m_FreeSuballocationsBySize[index] == item)
-			{
-				VectorRemove(m_FreeSuballocationsBySize, index);
-				return;
-			}
-			ASSERT((m_FreeSuballocationsBySize[index]->size == item->size) && "Not found.");
-		}
-		ASSERT(0 && "Not found.");
+		m_FreeSuballocations.Remove(AllocatorSuballocationList::item(item));
 	}
 }
 
@@ -1607,6 +1628,69 @@ void AllocatorBlockVector::AddStats(AllocatorStats* pStats, uint32_t memTypeInde
 	}
 }
 
+void AllocatorBlockVector::PlanDefragmentation(
+	UINT64 maxBytesToMove,
+	uint32_t maxMoves,
+	AllocatorVector< AllocatorDefragmentationMove >* pMoves,
+	DefragmentationStats* pStats) const
+{
+	// Mirror the blocks. RESOURCE_DEBUG_MARGIN is not kept between moved allocations.
+	AllocatorVector< uint64_t > blockSizes(m_Blocks.size());
+	AllocatorVector< DefragmentationAllocation > allocations;
+	for (uint32_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex)
+	{
+		const AllocatorBlock* const pBlock = m_Blocks[blockIndex];
+		blockSizes[blockIndex] = pBlock->m_Size;
+		for (AllocatorSuballocationList::const_iterator suballocItem = pBlock->m_Suballocations.cbegin();
+			suballocItem != pBlock->m_Suballocations.cend();
+			++suballocItem)
+		{
+			if (suballocItem->type == RESOURCE_SUBALLOCATION_TYPE_FREE)
+			{
+				continue;
+			}
+
+			DefragmentationAllocation allocation = {};
+			allocation.mBlockIndex = blockIndex;
+			allocation.mOffset = suballocItem->offset;
+			allocation.mSize = suballocItem->size;
+			allocation.mAlignment = RESOURCE_MAX(suballocItem->allocation->GetAlignment(), static_cast<UINT64>(RESOURCE_DEBUG_ALIGNMENT));
+			allocation.pUserData = suballocItem->allocation;
+			allocation.mMovable = true;
+			allocations.push_back(allocation);
+		}
+	}
+
+	DefragmentationPlanDesc desc = {};
+	desc.pBlockSizes = blockSizes.data();
+	desc.mBlockCount = (uint32_t)blockSizes.size();
+	desc.pAllocations = allocations.data();
+	desc.mAllocationCount = (uint32_t)allocations.size();
+	desc.mMaxBytesToMove = maxBytesToMove;
+	desc.mMaxMoves = maxMoves;
+
+	AllocatorVector< DefragmentationMove > moves;
+	planDefragmentation(&desc, &moves, pStats);
+
+	for (uint32_t i = 0; i < moves.size(); ++i)
+	{
+		const DefragmentationMove& move = moves[i];
+		const AllocatorBlock* const pSrcBlock = m_Blocks[move.mSrcBlockIndex];
+		const AllocatorBlock* const pDstBlock = m_Blocks[move.mDstBlockIndex];
+
+		AllocatorDefragmentationMove blockMove = {};
+		blockMove.allocation = (ResourceAllocation*)move.pUserData;
+		blockMove.srcDeviceMemory = pSrcBlock->m_hMemory;
+		blockMove.srcResource = pSrcBlock->m_hMemory ? RESOURCE_NULL : pSrcBlock->m_hResource;
+		blockMove.srcOffset = move.mSrcOffset;
+		blockMove.dstDeviceMemory = pDstBlock->m_hMemory;
+		blockMove.dstResource = pDstBlock->m_hMemory ? RESOURCE_NULL : pDstBlock->m_hResource;
+		blockMove.dstOffset = move.mDstOffset;
+		blockMove.size = move.mSize;
+		pMoves->push_back(blockMove);
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Allocator_T
 
@@ -1727,10 +1811,12 @@ HRESULT ResourceAllocator::AllocateMemoryOfType(
 						m_HasEmptyBlock[memTypeIndex] = false;
 					}
 					// Allocate from this pBlock.
-					pBlock->Alloc(allocRequest, suballocType, vkMemReq.SizeInBytes);
 					*pAllocation = resourceAlloc_new(ResourceAllocation);
+					AllocatorSuballocationList::iterator suballocItem =
+						pBlock->Alloc(allocRequest, suballocType, vkMemReq.SizeInBytes, *pAllocation);
 					(*pAllocation)->InitBlockAllocation(
 						pBlock,
+						AllocatorSuballocationList::item(suballocItem),
 						allocRequest.offset,
 						vkMemReq.Alignment,
 						vkMemReq.SizeInBytes,
@@ -1845,10 +1931,12 @@ HRESULT ResourceAllocator::AllocateMemoryOfType(
 				AllocatorAllocationRequest allocRequest = {};
 				allocRequest.freeSuballocationItem = pBlock->m_Suballocations.begin();
 				allocRequest.offset = 0;
-				pBlock->Alloc(allocRequest, suballocType, vkMemReq.SizeInBytes);
 				*pAllocation = resourceAlloc_new(ResourceAllocation);
+				AllocatorSuballocationList::iterator suballocItem =
+					pBlock->Alloc(allocRequest, suballocType, vkMemReq.SizeInBytes, *pAllocation);
 				(*pAllocation)->InitBlockAllocation(
 					pBlock,
+					AllocatorSuballocationList::item(suballocItem),
 					allocRequest.offset,
 					vkMemReq.Alignment,
 					vkMemReq.SizeInBytes,
@@ -1942,10 +2030,12 @@ HRESULT ResourceAllocator::AllocateMemoryOfType(
 				AllocatorAllocationRequest allocRequest = {};
 				allocRequest.freeSuballocationItem = pBlock->m_Suballocations.begin();
 				allocRequest.offset = 0;
-				pBlock->Alloc(allocRequest, suballocType, vkMemReq.SizeInBytes);
 				*pAllocation = resourceAlloc_new(ResourceAllocation);
+				AllocatorSuballocationList::iterator suballocItem =
+					pBlock->Alloc(allocRequest, suballocType, vkMemReq.SizeInBytes, *pAllocation);
 				(*pAllocation)->InitBlockAllocation(
 					pBlock,
+					AllocatorSuballocationList::item(suballocItem),
 					allocRequest.offset,
 					vkMemReq.Alignment,
 					vkMemReq.SizeInBytes,
@@ -2111,6 +2201,64 @@ void ResourceAllocator::CalculateStats(AllocatorStats* pStats)
 		AllocatorPostprocessCalcStatInfo(pStats->memoryHeap[i]);
 }
 
+void ResourceAllocator::PlanDefragmentation(
+	uint32_t memTypeIndex,
+	UINT64 maxBytesToMove,
+	uint32_t maxMoves,
+	AllocatorVector< AllocatorDefragmentationMove >* pMoves,
+	DefragmentationStats* pStats)
+{
+	ASSERT(memTypeIndex < GetMemoryTypeCount());
+	pMoves->clear();
+	memset(pStats, 0, sizeof(DefragmentationStats));
+
+	AllocatorMutexLock lock(m_BlocksMutex[memTypeIndex], m_UseMutex);
+
+	// Moves keep the free bytes of every BlockVector, so their fragmentation
+	// is merged weighted by free bytes.
+	UINT64 sumFreeSize = 0;
+	double fragmentationBefore = 0.0;
+	double fragmentationAfter = 0.0;
+	for (uint32_t blockVectorType = 0; blockVectorType < RESOURCE_BLOCK_VECTOR_TYPE_COUNT; ++blockVectorType)
+	{
+		const AllocatorBlockVector* const pBlockVector = m_pBlockVectors[memTypeIndex][blockVectorType];
+		ASSERT(pBlockVector);
+
+		const bool bytesLeft = (maxBytesToMove == 0) || (pStats->mBytesMoved < maxBytesToMove);
+		const bool movesLeft = (maxMoves == 0) || (pStats->mMoveCount < maxMoves);
+		if (pBlockVector->IsEmpty() || !bytesLeft || !movesLeft)
+		{
+			continue;
+		}
+
+		DefragmentationStats blockVectorStats;
+		pBlockVector->PlanDefragmentation(
+			maxBytesToMove ? maxBytesToMove - pStats->mBytesMoved : 0,
+			maxMoves ? maxMoves - pStats->mMoveCount : 0,
+			pMoves,
+			&blockVectorStats);
+
+		UINT64 blockVectorFreeSize = 0;
+		for (size_t blockIndex = 0; blockIndex < pBlockVector->m_Blocks.size(); ++blockIndex)
+		{
+			blockVectorFreeSize += pBlockVector->m_Blocks[blockIndex]->m_SumFreeSize;
+		}
+
+		sumFreeSize += blockVectorFreeSize;
+		fragmentationBefore += (double)blockVectorStats.mFragmentationBefore * (double)blockVectorFreeSize;
+		fragmentationAfter += (double)blockVectorStats.mFragmentationAfter * (double)blockVectorFreeSize;
+		pStats->mBytesMoved += blockVectorStats.mBytesMoved;
+		pStats->mMoveCount += blockVectorStats.mMoveCount;
+		pStats->mBlocksFreed += blockVectorStats.mBlocksFreed;
+	}
+
+	if (sumFreeSize > 0)
+	{
+		pStats->mFragmentationBefore = (float)(fragmentationBefore / (double)sumFreeSize);
+		pStats->mFragmentationAfter = (float)(fragmentationAfter / (double)sumFreeSize);
+	}
+}
+
 static const uint32_t RESOURCE_VENDOR_ID_AMD = 4098;
 
 void ResourceAllocator::UnmapPersistentlyMappedMemory()
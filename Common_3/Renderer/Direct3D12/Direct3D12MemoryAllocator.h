@@ -25,6 +25,7 @@
 #ifndef RESOURCE_RESOURCE_H
 #define RESOURCE_RESOURCE_H
 
+#include "../TlsfAllocator.h"
 #include "../../OS/Interfaces/IMemoryManager.h"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -405,6 +406,40 @@ different than before calling resourceAllocUnmapPersistentlyMappedMemory().
 */
 HRESULT resourceAllocMapPersistentlyMappedMemory(ResourceAllocator* allocator);
 
+/** \brief One step of a defragmentation plan.
+
+A block is backed either by a heap holding placed resources or by a single buffer resource holding suballocated
+buffers. The handle of the other kind is null.
+*/
+typedef struct AllocatorDefragmentationMove
+{
+	ResourceAllocation* allocation;
+	ID3D12Heap* srcDeviceMemory;
+	ID3D12Resource* srcResource;
+	UINT64 srcOffset;
+	ID3D12Heap* dstDeviceMemory;
+	ID3D12Resource* dstResource;
+	UINT64 dstOffset;
+	UINT64 size;
+} AllocatorDefragmentationMove;
+
+/** \brief Plans a defragmentation of the blocks of one memory type without touching any memory.
+
+Allocations of the least used blocks are moved into holes of the more used ones, everything else is compacted
+towards the beginning of its block. The allocator state is not changed: the caller recreates each resource at the
+destination, copies the data in the order of pMoves and then frees and replaces the allocations.
+
+@param maxBytesToMove 0 means no limit.
+@param maxMoves 0 means no limit.
+*/
+void resourceAllocPlanDefragmentation(
+	ResourceAllocator* allocator,
+	uint32_t memoryTypeIndex,
+	UINT64 maxBytesToMove,
+	uint32_t maxMoves,
+	tinystl::vector<AllocatorDefragmentationMove>* pMoves,
+	DefragmentationStats* pStats);
+
 ////////////////////////////////////////////////////////////////////////////////
 /** \defgroup layer3 Layer 3 Creating Buffers and Images
 @{
@@ -1440,6 +1475,10 @@ public:
 	void erase(iterator it) { m_RawList.Remove(it.m_pItem); }
 	iterator insert(iterator it, const T& value) { return iterator(&m_RawList, m_RawList.InsertBefore(it.m_pItem, value)); }
 
+	// Items stay at the same address until erased, so they can be kept instead of searching for an element.
+	static AllocatorListItem<T>* item(iterator it) { return it.m_pItem; }
+	iterator from_item(AllocatorListItem<T>* pItem) { return iterator(&m_RawList, pItem); }
+
 private:
 	AllocatorRawList<T> m_RawList;
 };
@@ -1454,6 +1493,7 @@ private:
 ////////////////////////////////////////////////////////////////////////////////
 
 class AllocatorBlock;
+struct AllocatorSuballocation;
 
 enum RESOURCE_BLOCK_VECTOR_TYPE
 {
@@ -1481,6 +1521,8 @@ struct BlockAllocation
 {
 	AllocatorBlock* m_Block;
 	UINT64 m_Offset;
+	// Suballocation in m_Block->m_Suballocations backing this allocation.
+	AllocatorListItem<AllocatorSuballocation>* m_pSuballocation;
 };
 
 struct ResourceAllocation
@@ -1500,6 +1542,7 @@ public:
 
 	void InitBlockAllocation(
 		AllocatorBlock* block,
+		AllocatorListItem<AllocatorSuballocation>* suballocation,
 		UINT64 offset,
 		UINT64 alignment,
 		UINT64 size,
@@ -1515,16 +1558,19 @@ public:
 		m_SuballocationType = suballocationType;
 		m_BlockAllocation.m_Block = block;
 		m_BlockAllocation.m_Offset = offset;
+		m_BlockAllocation.m_pSuballocation = suballocation;
 	}
 
 	void ChangeBlockAllocation(
 		AllocatorBlock* block,
+		AllocatorListItem<AllocatorSuballocation>* suballocation,
 		UINT64 offset)
 	{
 		ASSERT(block != RESOURCE_NULL);
 		ASSERT(m_Type == ALLOCATION_TYPE_BLOCK);
 		m_BlockAllocation.m_Block = block;
 		m_BlockAllocation.m_Offset = offset;
+		m_BlockAllocation.m_pSuballocation = suballocation;
 	}
 
 	void InitOwnAllocation(
@@ -1558,6 +1604,11 @@ public:
 		ASSERT(m_Type == ALLOCATION_TYPE_BLOCK);
 		return m_BlockAllocation.m_Block;
 	}
+	AllocatorListItem<AllocatorSuballocation>* GetSuballocation() const
+	{
+		ASSERT(m_Type == ALLOCATION_TYPE_BLOCK);
+		return m_BlockAllocation.m_pSuballocation;
+	}
 	UINT64 GetOffset() const
 	{
 		return (m_Type == ALLOCATION_TYPE_BLOCK) ? m_BlockAllocation.m_Offset : 0;
@@ -1617,10 +1668,25 @@ struct AllocatorSuballocation
 	UINT64 offset;
 	UINT64 size;
 	AllocatorSuballocationType type;
+	// Owner of a used suballocation, null for free ones.
+	ResourceAllocation* allocation;
+	// Links in the free list of AllocatorBlock::m_FreeSuballocations while registered.
+	AllocatorListItem<AllocatorSuballocation>* pPrevFree;
+	AllocatorListItem<AllocatorSuballocation>* pNextFree;
 };
 
 typedef AllocatorList< AllocatorSuballocation > AllocatorSuballocationList;
 
+struct AllocatorSuballocationTlsfTraits
+{
+	typedef AllocatorListItem<AllocatorSuballocation> Node;
+	static uint64_t GetSize(const Node* pNode) { return pNode->Value.size; }
+	static Node* GetPrevFree(const Node* pNode) { return pNode->Value.pPrevFree; }
+	static Node* GetNextFree(const Node* pNode) { return pNode->Value.pNextFree; }
+	static void SetPrevFree(Node* pNode, Node* pPrev) { pNode->Value.pPrevFree = pPrev; }
+	static void SetNextFree(Node* pNode, Node* pNext) { pNode->Value.pNextFree = pNext; }
+};
+
 // Parameters of an allocation.
 struct AllocatorAllocationRequest
 {
@@ -1643,9 +1709,9 @@ public:
 	uint32_t m_FreeCount;
 	UINT64 m_SumFreeSize;
 	AllocatorSuballocationList m_Suballocations;
-	// Suballocations that are free and have size greater than certain threshold.
-	// Sorted by size, ascending.
-	AllocatorVector< AllocatorSuballocationList::iterator > m_FreeSuballocationsBySize;
+	// Suballocations that are free and have size greater than certain threshold,
+	// binned by size (two-level segregated fit).
+	TlsfFreeLists< AllocatorSuballocationTlsfTraits > m_FreeSuballocations;
 
 	AllocatorBlock(ResourceAllocator* hAllocator);
 
@@ -1699,11 +1765,12 @@ public:
 	bool IsEmpty() const;
 
 	// Makes actual allocation based on request. Request must already be checked
-	// and valid.
-	void Alloc(
+	// and valid. Returns the suballocation now owned by hAllocation.
+	AllocatorSuballocationList::iterator Alloc(
 		const AllocatorAllocationRequest& request,
 		AllocatorSuballocationType type,
-		UINT64 allocSize);
+		UINT64 allocSize,
+		ResourceAllocation* hAllocation);
 
 	// Frees suballocation assigned to given memory region.
 	void Free(const ResourceAllocation* allocation);
@@ -1718,11 +1785,18 @@ private:
 	// Releases given suballocation, making it free. Merges it with adjacent free
 	// suballocations if applicable.
 	void FreeSuballocation(AllocatorSuballocationList::iterator suballocItem);
-	// Given free suballocation, it inserts it into sorted list of
-	// m_FreeSuballocationsBySize if it's suitable.
+	// Checks the free suballocations linked from pHead in order, fills pAllocationRequest
+	// with the first one that fits.
+	bool CheckFreeList(
+		AllocatorListItem<AllocatorSuballocation>* pHead,
+		UINT64 bufferImageGranularity,
+		UINT64 allocSize,
+		UINT64 allocAlignment,
+		AllocatorSuballocationType allocType,
+		AllocatorAllocationRequest* pAllocationRequest);
+	// Given free suballocation, it inserts it into m_FreeSuballocations if it's suitable.
 	void RegisterFreeSuballocation(AllocatorSuballocationList::iterator item);
-	// Given free suballocation, it removes it from sorted list of
-	// m_FreeSuballocationsBySize if it's suitable.
+	// Given free suballocation, it removes it from m_FreeSuballocations if it's suitable.
 	void UnregisterFreeSuballocation(AllocatorSuballocationList::iterator item);
 };
 
@@ -1756,6 +1830,13 @@ struct AllocatorBlockVector
 	// Adds statistics of this BlockVector to pStats.
 	void AddStats(AllocatorStats* pStats, uint32_t memTypeIndex, uint32_t memHeapIndex) const;
 
+	// Appends moves defragmenting this BlockVector to pMoves. Moves never cross into another BlockVector.
+	void PlanDefragmentation(
+		UINT64 maxBytesToMove,
+		uint32_t maxMoves,
+		AllocatorVector< AllocatorDefragmentationMove >* pMoves,
+		DefragmentationStats* pStats) const;
+
 #if RESOURCE_STATS_STRING_ENABLED
 	void PrintDetailedMap(class AllocatorStringBuilder& sb) const;
 #endif
@@ -1833,6 +1914,13 @@ struct ResourceAllocator
 
 	void CalculateStats(AllocatorStats* pStats);
 
+	void PlanDefragmentation(
+		uint32_t memTypeIndex,
+		UINT64 maxBytesToMove,
+		uint32_t maxMoves,
+		AllocatorVector< AllocatorDefragmentationMove >* pMoves,
+		DefragmentationStats* pStats);
+
 #if RESOURCE_STATS_STRING_ENABLED
 	void PrintDetailedMap(class AllocatorStringBuilder& sb);
 #endif
@@ -31,6 +31,8 @@
 #include "../OS/Interfaces/IMemoryManager.h"
 
 extern void getTimestampFrequency(Queue* pQueue, double* pFrequency);
+
+COMMAND_CAPTURE_LAYER_BEGIN
 extern void addQueryHeap(Renderer* pRenderer, const QueryHeapDesc* pDesc, QueryHeap** ppQueryHeap);
 extern void removeQueryHeap(Renderer* pRenderer, QueryHeap* pQueryHeap);
 extern void cmdBeginQuery(Cmd* pCmd, QueryHeap* pQueryHeap, QueryDesc* pQuery);
@@ -39,8 +41,13 @@ extern void cmdResolveQuery(Cmd* pCmd, QueryHeap* pQueryHeap, Buffer* pReadbackB
 
 extern void mapBuffer(Renderer* pRenderer, Buffer* pBuffer, ReadRange* pRange /* = NULL */);
 extern void unmapBuffer(Renderer* pRenderer, Buffer* pBuffer);
+COMMAND_CAPTURE_LAYER_END
+
+#if !defined(_WIN32) && !defined(MAX_PATH)
+#define MAX_PATH 260
+#endif
 
-#if defined(DIRECT3D12) || defined(VULKAN)
+#if defined(DIRECT3D12) || defined(VULKAN) || defined(NULL_RENDERER)
 void clearChildren(GpuTimerTree* pRoot)
 {
 	if (!pRoot)
@@ -128,7 +135,7 @@ void addGpuProfiler(Renderer* pRenderer, Queue* pQueue, GpuProfiler** ppGpuProfi
 {
 	GpuProfiler* pGpuProfiler = (GpuProfiler*)conf_calloc(1, sizeof(*pGpuProfiler));
 
-#if defined(DIRECT3D12) || defined(VULKAN)
+#if defined(DIRECT3D12) || defined(VULKAN) || defined(NULL_RENDERER)
 	QueryHeapDesc queryHeapDesc = { QUERY_TYPE_TIMESTAMP, maxTimers * 2 };
 
 	for (uint32_t i = 0; i < GpuProfiler::NUM_OF_FRAMES; ++i)
@@ -166,7 +173,7 @@ void addGpuProfiler(Renderer* pRenderer, Queue* pQueue, GpuProfiler** ppGpuProfi
 
 void removeGpuProfiler(Renderer* pRenderer, GpuProfiler* pGpuProfiler)
 {
-#if defined(DIRECT3D12) || defined(VULKAN)
+#if defined(DIRECT3D12) || defined(VULKAN) || defined(NULL_RENDERER)
 	for (uint32_t i = 0; i < GpuProfiler::NUM_OF_FRAMES; ++i)
 	{
 		removeResource(pGpuProfiler->pReadbackBuffer[i]);
@@ -189,7 +196,7 @@ void removeGpuProfiler(Renderer* pRenderer, GpuProfiler* pGpuProfiler)
 
 void cmdBeginGpuTimestampQuery(Cmd* pCmd, struct GpuProfiler* pGpuProfiler, const char* pName, bool addMarker, const float3& color)
 {
-#if defined(DIRECT3D12) || defined(VULKAN)
+#if defined(DIRECT3D12) || defined(VULKAN) || defined(NULL_RENDERER)
 
 	// hash name
 	char buffer[MAX_PATH];
@@ -241,7 +248,7 @@ void cmdBeginGpuTimestampQuery(Cmd* pCmd, struct GpuProfiler* pGpuProfiler, cons
 
 void cmdEndGpuTimestampQuery(Cmd* pCmd, struct GpuProfiler* pGpuProfiler, GpuTimer** ppGpuTimer)
 {
-#if defined(DIRECT3D12) || defined(VULKAN)
+#if defined(DIRECT3D12) || defined(VULKAN) || defined(NULL_RENDERER)
 	// Record cpu time
 	pGpuProfiler->pCurrentNode->mGpuTimer.mEndCpuTime = getUSec();
 
@@ -263,7 +270,7 @@ void cmdEndGpuTimestampQuery(Cmd* pCmd, struct GpuProfiler* pGpuProfiler, GpuTim
 
 void cmdBeginGpuFrameProfile(Cmd* pCmd, GpuProfiler* pGpuProfiler)
 {
-#if defined(DIRECT3D12) || defined(VULKAN)
+#if defined(DIRECT3D12) || defined(VULKAN) || defined(NULL_RENDERER)
 	// resolve last frame
 	cmdResolveQuery(pCmd, 
 		pGpuProfiler->pQueryHeap[pGpuProfiler->mBufferIndex],
@@ -297,7 +304,7 @@ void cmdBeginGpuFrameProfile(Cmd* pCmd, GpuProfiler* pGpuProfiler)
 
 void cmdEndGpuFrameProfile(Cmd* pCmd, GpuProfiler* pGpuProfiler)
 {
-#if defined(DIRECT3D12) || defined(VULKAN)
+#if defined(DIRECT3D12) || defined(VULKAN) || defined(NULL_RENDERER)
 	cmdEndGpuTimestampQuery(pCmd, pGpuProfiler);
 
 	for (uint32_t i = 0; i < pGpuProfiler->mRoot.mChildren.getCount(); ++i)
@@ -291,8 +291,8 @@ typedef enum DescriptorType {
 	DESCRIPTOR_TYPE_UNIFORM_BUFFER,
 	/// Push constant / Root constant
 	DESCRIPTOR_TYPE_ROOT_CONSTANT,
-#if defined(VULKAN)
-	/// Subpass input (descriptor type only available in Vulkan)
+#if defined(VULKAN) || defined(NULL_RENDERER)
+	/// Subpass input (descriptor type only available in Vulkan and the null renderer which reflects the same SPIR-V)
     DESCRIPTOR_TYPE_INPUT_ATTACHMENT,
 #endif
 	DESCRIPTOR_TYPE_COUNT,
@@ -584,6 +584,9 @@ typedef struct QueryHeap
 #elif defined(VULKAN)
 	VkQueryPool			pVkQueryPool;
 #elif defined(METAL)
+#elif defined(NULL_RENDERER)
+	/// Query results written when the command buffer is executed in queueSubmit
+	uint64_t*			pNullQueryData;
 #endif
 } QueryHeap;
 
@@ -673,6 +676,9 @@ typedef struct Buffer {
     struct ResourceAllocation*          pMtlAllocation;
 	/// Native handle of the underlying resource
     id<MTLBuffer>                       mtlBuffer;
+#elif defined(NULL_RENDERER)
+	/// System memory backing the buffer. pCpuMappedAddress points into it while the buffer is mapped
+	uint8_t*                            pNullMemory;
 #endif
 } Buffer;
 
@@ -790,6 +796,9 @@ typedef struct Texture {
 	id<MTLTexture>						mtlTexture;
 	MTLPixelFormat						mtlPixelFormat;
 	bool								mIsCompressed;
+#elif defined(NULL_RENDERER)
+	/// System memory backing the texture. Subresources are tightly packed mip by mip, see getNullSubresourceOffset
+	uint8_t*							pNullMemory;
 #endif
 } Texture;
 
@@ -859,6 +868,16 @@ typedef struct Sampler {
 #elif defined(METAL)
 	/// Native handle of the underlying resource
     id<MTLSamplerState>             mtlSamplerState;
+#elif defined(NULL_RENDERER)
+	/// Creation parameters of the sampler
+	FilterType						mMinFilter;
+	FilterType						mMagFilter;
+	MipMapMode						mMipMapMode;
+	AddressMode						mAddressU;
+	AddressMode						mAddressV;
+	AddressMode						mAddressW;
+	float							mMipLodBias;
+	float							mMaxAnisotropy;
 #endif
 } Sampler;
 
@@ -890,6 +909,9 @@ typedef struct DescriptorInfo {
 	uint32_t					mDynamicUniformIndex;
 	uint32_t					mHandleIndex;
 #elif defined(METAL)
+#elif defined(NULL_RENDERER)
+	/// Index of the first array element in the binding table of this update frequency
+	uint32_t					mHandleIndex;
 #endif
 } DescriptorInfo;
 
@@ -991,6 +1013,9 @@ typedef struct RootSignature
 
 	VkPipelineLayout							pPipelineLayout;
 #elif defined(METAL)
+#elif defined(NULL_RENDERER)
+	/// Array of descriptor set layouts of size DESCRIPTOR_UPDATE_FREQ_COUNT
+	DescriptorSetLayout*						pDescriptorSetLayouts;
 #endif
 
 	using ThreadLocalDescriptorManager = tinystl::unordered_map<ThreadID, struct DescriptorManager*>;
@@ -1009,9 +1034,10 @@ typedef struct DescriptorData
 			ppTextures(NULL) {}
     
 	/// User can either set name of descriptor or index (index in pRootSignature->pDescriptors array)
+	/// If mIndex is set it takes precedence and the per call name hash lookup is skipped
     /// Name of descriptor
     const char*     pName;
-	/// Index of descriptor
+	/// Index of descriptor. Resolve once per root signature with getDescriptorIndexFromName
 	uint32_t		mIndex;
     /// Number of resources in the descriptor(applies to array of textures, buffers,...)
     uint32_t        mCount;
@@ -1094,6 +1120,9 @@ typedef struct Cmd {
 	Buffer*									selectedIndexBuffer;
     Shader*                                 pShader;
     RenderTarget*                           pRenderTarget;
+#elif defined(NULL_RENDERER)
+	/// Commands recorded between beginCmd and endCmd. Kept after queueSubmit so they can be inspected
+	struct NullCommandStream*				pNullStream;
 #endif
 } Cmd;
 
@@ -1123,6 +1152,8 @@ typedef struct Fence {
     dispatch_semaphore_t                pMtlSemaphore;
     bool                                mSubmitted;
     bool                                mCompleted;
+#elif defined(NULL_RENDERER)
+	bool								mSubmitted;
 #endif
 } Fence;
 
@@ -1149,6 +1180,8 @@ typedef struct Semaphore {
 	bool								mSignaled;
 #elif defined(METAL)
 	dispatch_semaphore_t                pMtlSemaphore;
+#elif defined(NULL_RENDERER)
+	bool								mSignaled;
 #endif
 } Semaphore;
 
@@ -1164,6 +1197,9 @@ typedef struct Queue {
 #elif defined(METAL)
     id<MTLCommandQueue>		mtlCommandQueue;
     dispatch_semaphore_t	pMtlSemaphore;
+#elif defined(NULL_RENDERER)
+	/// Number of queueSubmit calls executed on this queue
+	uint64_t				mNullSubmitCount;
 #endif
 } Queue;
 
@@ -1203,6 +1239,8 @@ typedef struct Shader {
 
 	uint32_t				mNumThreadsPerGroup[3];
 	uint32_t				mNumControlPoint;
+	/// Hash of the byte code and entry point of every stage, keys the pipeline cache. Zero if the backend does not compute it
+	uint64_t				mContentHash;
 
 
 #if defined(VULKAN)
@@ -1253,6 +1291,16 @@ typedef struct BlendState
     };
     BlendStateData						blendStatePerRenderTarget[MAX_RENDER_TARGET_ATTACHMENTS];
     bool								alphaToCoverage;
+#elif defined(NULL_RENDERER)
+	BlendConstant						mSrcFactor;
+	BlendConstant						mDestFactor;
+	BlendConstant						mSrcAlphaFactor;
+	BlendConstant						mDestAlphaFactor;
+	BlendMode							mBlendMode;
+	BlendMode							mBlendAlphaMode;
+	int									mMask;
+	int									mRenderTargetMask;
+	bool								mAlphaToCoverage;
 #endif
 } BlendState;
 
@@ -1272,6 +1320,21 @@ typedef struct DepthState
 	float						MaxDepthBounds;
 #elif defined(METAL)
     id<MTLDepthStencilState>	mtlDepthState;
+#elif defined(NULL_RENDERER)
+	bool						mDepthTest;
+	bool						mDepthWrite;
+	CompareMode					mDepthFunc;
+	bool						mStencilTest;
+	uint8						mStencilReadMask;
+	uint8						mStencilWriteMask;
+	CompareMode					mStencilFrontFunc;
+	StencilOp					mStencilFrontFail;
+	StencilOp					mDepthFrontFail;
+	StencilOp					mStencilFrontPass;
+	CompareMode					mStencilBackFunc;
+	StencilOp					mStencilBackFail;
+	StencilOp					mDepthBackFail;
+	StencilOp					mStencilBackPass;
 #endif
 } DepthState;
 
@@ -1296,6 +1359,13 @@ typedef struct RasterizerState
     float					depthBias;
     bool					scissorEnable;
     bool					multisampleEnable;
+#elif defined(NULL_RENDERER)
+	CullMode				mCullMode;
+	int						mDepthBias;
+	float					mSlopeScaledDepthBias;
+	FillMode				mFillMode;
+	bool					mMultiSample;
+	bool					mScissor;
 #endif
 } RasterizerState;
 
@@ -1344,6 +1414,9 @@ typedef struct Pipeline {
 	PipelineType					mType;
 #if defined(VULKAN)
 	VkPipeline						pVkPipeline;
+	/// Identical pipeline descs share one Pipeline, it is destroyed once every addPipeline got its removePipeline
+	uint64_t						mPipelineHash;
+	uint32_t						mRefCount;
 #elif defined(DIRECT3D12)
 	ID3D12PipelineState*			pDxPipelineState;
 	D3D_PRIMITIVE_TOPOLOGY			mDxPrimitiveTopology;
@@ -1425,6 +1498,11 @@ typedef struct SwapChain
     MTKView*                pMTKView;
     id<MTLCommandBuffer>    presentCommandBuffer;
     id<MTLCommandQueue>     presentCommandQueue;
+#elif defined(NULL_RENDERER)
+	/// Image handed out by the last acquireNextImage
+	uint32_t				mImageIndex;
+	/// Number of queuePresent calls
+	uint64_t				mPresentCount;
 #endif
 } SwapChain;
 
@@ -1443,6 +1521,9 @@ typedef struct RendererDesc {
 	StringList						mDeviceLayers;
 	StringList						mDeviceExtensions;
 	PFN_vkDebugReportCallbackEXT	pVkDebugFn;
+	/// Pipeline cache file relative to FSR_OtherFiles, NULL uses PIPELINE_CACHE_FILE_NAME
+	const char*						pPipelineCacheFileName;
+	bool							mDisablePipelineCache;
 #elif defined(DIRECT3D12)
 	D3D_FEATURE_LEVEL				mDxFeatureLevel;
 #elif defined(METAL)
@@ -1529,6 +1610,9 @@ typedef struct Renderer {
 
 	struct VmaAllocator_T*				pVmaAllocator;
 	struct DescriptorStoreHeap*			pDescriptorPool;
+	VkPipelineCache						pPipelineCache;
+	/// Live pipelines by desc hash for deduplicating addPipeline calls
+	struct PipelineRegistry*			pPipelineRegistry;
 
 	// These are the extensions that we have loaded
 	const char* gVkInstanceExtensions[MAX_INSTANCE_EXTENSIONS];
@@ -1540,6 +1624,9 @@ typedef struct Renderer {
     CAMetalLayer*						mMetalLayer;
 #endif
     struct ResourceAllocator*           pResourceAllocator;
+#elif defined(NULL_RENDERER)
+	/// Live resource and memory counters of the null device
+	struct NullDeviceStats*				pNullStats;
 #endif
 
 	// Default states used if user does not specify them in pipeline creation
@@ -1584,9 +1671,14 @@ typedef struct CommandSignature
 	VkIndirectCommandsTokenNVX*			pTokens;
 #elif defined(METAL)
 	IndirectArgumentType				mDrawType;
+#elif defined(NULL_RENDERER)
+	IndirectArgumentType				mDrawType;
 #endif
 }CommandSignature;
 
+// Functions declared between COMMAND_CAPTURE_LAYER_BEGIN / END are recorded by the capture layer, see CommandCapture.h
+#include "CommandCaptureLayer.h"
+
 #if defined(VULKAN)
 #define ApiExport //extern "C"
 #else
@@ -1599,6 +1691,7 @@ typedef struct CommandSignature
 //If false is passed or the platform does not support HDR a non HDR format is returned.
 ApiExport ImageFormat::Enum getRecommendedSwapchainFormat(bool hintHDR);
 
+COMMAND_CAPTURE_LAYER_BEGIN
 // API functions
 // allocates memory and initializes the renderer -> returns pRenderer
 //
@@ -1626,12 +1719,15 @@ ApiExport void removeCmd(CmdPool* p_CmdPool, Cmd* p_cmd);
 ApiExport void addCmd_n(CmdPool* p_CmdPool, bool secondary, uint32_t cmd_count, Cmd*** ppp_cmd);
 ApiExport void removeCmd_n(CmdPool* p_CmdPool, uint32_t cmd_count, Cmd** pp_cmd);
 
+COMMAND_CAPTURE_LAYER_END
+
 //
 // All buffer, texture loading handled by resource system -> IResourceLoader.*
 //
 
 ApiExport uint32_t calculateVertexLayoutStride(const VertexLayout* p_vertex_layout);
 
+COMMAND_CAPTURE_LAYER_BEGIN
 ApiExport void addRenderTarget(Renderer* pRenderer, const RenderTargetDesc* p_desc, RenderTarget** pp_render_target, void* pNativeHandle = NULL);
 ApiExport void removeRenderTarget(Renderer* pRenderer, RenderTarget* p_render_target);
 ApiExport void addSampler(Renderer* pRenderer, Sampler** pp_sampler, FilterType minFilter = FILTER_LINEAR, FilterType magFilter = FILTER_LINEAR, MipMapMode mipMapMode = MIPMAP_MODE_LINEAR, AddressMode addressU = ADDRESS_MODE_CLAMP_TO_BORDER, AddressMode addressV = ADDRESS_MODE_CLAMP_TO_BORDER, AddressMode addressW = ADDRESS_MODE_CLAMP_TO_BORDER, float mipLosBias = 0.0f, float maxAnisotropy = 0.0f);
@@ -1644,6 +1740,11 @@ ApiExport void removeShader(Renderer* pRenderer, Shader* p_shader_program);
 // pipeline functions
 ApiExport void addRootSignature(Renderer* pRenderer, uint32_t num_shaders, Shader* const* pp_shaders, RootSignature** pp_root_signature, const RootSignatureDesc* pRootDesc = NULL);
 ApiExport void removeRootSignature(Renderer* pRenderer, RootSignature* pRootSignature);
+COMMAND_CAPTURE_LAYER_END
+/// Returns the index of the descriptor named pName in pRootSignature or (uint32_t)-1 if it does not exist
+/// Store the result in DescriptorData::mIndex to bind by slot instead of by name
+ApiExport uint32_t getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName);
+COMMAND_CAPTURE_LAYER_BEGIN
 ApiExport void addPipeline(Renderer* pRenderer, const GraphicsPipelineDesc* p_pipeline_settings, Pipeline** pp_pipeline);
 ApiExport void addComputePipeline(Renderer* pRenderer, const ComputePipelineDesc* p_pipeline_settings, Pipeline** p_pipeline);
 ApiExport void removePipeline(Renderer* pRenderer, Pipeline* p_pipeline);
@@ -1723,6 +1824,7 @@ ApiExport void waitForFences(Queue* p_queue, uint32_t fence_count, Fence** pp_fe
 ////Color is in XRGB format (X being padding) 0xff0000 -> red, 0x00ff00 -> green, 0x0000ff -> blue
 //ApiExport void queuePushDebugMarker(Queue* pQueue, uint32_t color, const char* name, ...);
 //ApiExport void queuePopDebugMarker(Queue* pQueue);
+COMMAND_CAPTURE_LAYER_END
 
 ApiExport void getRawTextureHandle(Renderer* pRenderer, Texture* p_texture, void** pp_handle);
 
@@ -1730,9 +1832,11 @@ ApiExport void getRawTextureHandle(Renderer* pRenderer, Texture* p_texture, void
 ApiExport bool isImageFormatSupported(ImageFormat::Enum format);
 
 //indirect Draw functions
+COMMAND_CAPTURE_LAYER_BEGIN
 ApiExport void addIndirectCommandSignature(Renderer* pRenderer, const CommandSignatureDesc* p_desc, CommandSignature** ppCommandSignature);
 ApiExport void removeIndirectCommandSignature(Renderer* pRenderer, CommandSignature* pCommandSignature);
 ApiExport void cmdExecuteIndirect(Cmd* pCmd, CommandSignature* pCommandSignature, uint maxCommandCount, Buffer* pIndirectBuffer, uint64_t bufferOffset, Buffer* pCounterBuffer, uint64_t counterBufferOffset);
+COMMAND_CAPTURE_LAYER_END
 /************************************************************************/
 // Stats Info Interface
 /************************************************************************/
@@ -1741,10 +1845,12 @@ void freeMemoryStats(Renderer* pRenderer, char* stats);
 /************************************************************************/
 // Debug Marker Interface
 /************************************************************************/
+COMMAND_CAPTURE_LAYER_BEGIN
 void cmdBeginDebugMarker(Cmd* pCmd, float r, float g, float b, const char* pName);
 void cmdBeginDebugMarkerf(Cmd* pCmd, float r, float g, float b, const char* pFormat, ...);
 void cmdEndDebugMarker(Cmd* pCmd);
 
 void cmdAddDebugMarker(Cmd* pCmd, float r, float g, float b, const char* pName);
 void cmdAddDebugMarkerf(Cmd* pCmd, float r, float g, float b, const char* pFormat, ...);
+COMMAND_CAPTURE_LAYER_END
 /************************************************************************/
@@ -143,5 +143,21 @@ void destroyShaderReflection(ShaderReflection* pReflection);
 void createPipelineReflection(ShaderReflection* pReflection, uint32_t stageCount, PipelineReflection* pOutReflection);
 void destroyPipelineReflection(PipelineReflection* pReflection);
 
-//void serializeReflection(File* pInFile, Reflection* pReflection);
-//void deserializeReflection(File* pOutFile, Reflection* pReflection);
+/************************************************************************/
+// Reflection cache
+// Stage reflection serialized to a compact blob so it does not need to be rebuilt from the byte code on every load.
+// The blob is keyed by a hash of the byte code it was reflected from and is discarded if the code changed.
+// Names are stored as offsets into the name pool. Platform specific fields (Metal) are not stored.
+/************************************************************************/
+#define SHADER_REFLECTION_CACHE_MAGIC 0x46525346 // 'FSRF'
+/// Bump when the blob layout or the reflection rules change
+#define SHADER_REFLECTION_CACHE_VERSION 1
+
+uint64_t getShaderReflectionBlobSize(const ShaderReflection* pReflection);
+void writeShaderReflectionBlob(const ShaderReflection* pReflection, uint64_t codeHash, void* pBlob);
+/// Returns false if the blob is corrupt, of a different version or was created from different byte code
+bool readShaderReflectionBlob(const void* pBlob, uint64_t blobSize, uint64_t codeHash, ShaderReflection* pOutReflection);
+
+/// File paths are absolute (FSR_Absolute)
+bool loadShaderReflectionFile(const char* filePath, uint64_t codeHash, ShaderReflection* pOutReflection);
+bool saveShaderReflectionFile(const char* filePath, uint64_t codeHash, const ShaderReflection* pReflection);
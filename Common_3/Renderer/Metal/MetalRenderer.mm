@@ -522,9 +522,22 @@ namespace RENDERER_CPP_NAMESPACE {
         }
     }
     
-    const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const char* pResName, uint32_t* pIndex)
+    const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const DescriptorData* pParam, uint32_t* pIndex)
     {
-        DescriptorNameToIndexMap::const_iterator it = pRootSignature->pDescriptorNameToIndexMap.find(tinystl::hash(pResName));
+        // Slot resolved up front through getDescriptorIndexFromName - no string hashing required
+        if (pParam->mIndex != (uint32_t)-1)
+        {
+            if (pParam->mIndex >= pRootSignature->mDescriptorCount)
+            {
+                LOGERRORF("Invalid descriptor index (%u). Root signature has (%u) descriptors", pParam->mIndex, pRootSignature->mDescriptorCount);
+                return NULL;
+            }
+            
+            *pIndex = pParam->mIndex;
+            return &pRootSignature->pDescriptors[pParam->mIndex];
+        }
+        
+        DescriptorNameToIndexMap::const_iterator it = pRootSignature->pDescriptorNameToIndexMap.find(tinystl::hash(pParam->pName));
         if (it.node)
         {
             *pIndex = it.node->second;
@@ -532,11 +545,24 @@ namespace RENDERER_CPP_NAMESPACE {
         }
         else
         {
-            LOGERRORF("Invalid descriptor param (%s)", pResName);
+            LOGERRORF("Invalid descriptor param (%s)", pParam->pName);
             return NULL;
         }
     }
     
+    uint32_t getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName)
+    {
+        ASSERT(pRootSignature);
+        ASSERT(pName);
+        
+        DescriptorNameToIndexMap::const_iterator it = pRootSignature->pDescriptorNameToIndexMap.find(tinystl::hash(pName));
+        if (it.node)
+            return it.node->second;
+        
+        LOGERRORF("Invalid descriptor param (%s)", pName);
+        return (uint32_t)-1;
+    }
+    
     void reset_bound_resources(DescriptorManager* pManager)
     {
         for (uint32_t i = 0; i < pManager->pRootSignature->mDescriptorCount; ++i)
@@ -605,21 +631,22 @@ namespace RENDERER_CPP_NAMESPACE {
         {
             const DescriptorData* pParam = &pDescParams[paramIdx];
             ASSERT(pParam);
-            if (!pParam->pName)
+            if (!pParam->pName && pParam->mIndex == (uint32_t)-1)
             {
-                LOGERRORF("Name of Descriptor at index (%u) is NULL", paramIdx);
+                LOGERRORF("Name and index of Descriptor at index (%u) are both unset", paramIdx);
                 return;
             }
             
-            uint32_t hash = tinystl::hash(pParam->pName);
             uint32_t descIndex = -1;
-            const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pParam->pName, &descIndex);
+            const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pParam, &descIndex);
             if (!pDesc)
                 continue;
+            // Name used for error reporting. pParam->pName may be NULL when binding by index
+            const char* pDescName = pDesc->mDesc.name;
             
             // Replace the default DescriptorData by the new data pased into this function.
-            pManager->pDescriptorDataArray[descIndex].pName = pParam->pName;
-            pManager->pDescriptorDataArray[descIndex].mIndex = pParam->mIndex;
+            // The name stays the copy made in add_descriptor_manager since pParam->pName is optional
+            pManager->pDescriptorDataArray[descIndex].mIndex = descIndex;
             pManager->pDescriptorDataArray[descIndex].mCount = pParam->mCount;
             pManager->pDescriptorDataArray[descIndex].mOffset = pParam->mOffset;
             switch(pDesc->mDesc.type)
@@ -627,34 +654,37 @@ namespace RENDERER_CPP_NAMESPACE {
                 case DESCRIPTOR_TYPE_RW_TEXTURE:
                 case DESCRIPTOR_TYPE_TEXTURE:
                     if (!pParam->ppTextures) {
-                        LOGERRORF("Texture descriptor (%s) is NULL", pParam->pName);
+                        LOGERRORF("Texture descriptor (%s) is NULL", pDescName);
                         return;
                     }
                     pManager->pDescriptorDataArray[descIndex].ppTextures = pParam->ppTextures;
                     break;
                 case DESCRIPTOR_TYPE_SAMPLER:
                     if (!pParam->ppSamplers) {
-                        LOGERRORF("Sampler descriptor (%s) is NULL", pParam->pName);
+                        LOGERRORF("Sampler descriptor (%s) is NULL", pDescName);
                         return;
                     }
                     pManager->pDescriptorDataArray[descIndex].ppSamplers = pParam->ppSamplers;
                     break;
                 case DESCRIPTOR_TYPE_ROOT_CONSTANT:
                     if (!pParam->pRootConstant) {
-                        LOGERRORF("RootConstant array (%s) is NULL", pParam->pName);
+                        LOGERRORF("RootConstant array (%s) is NULL", pDescName);
                         return;
                     }
                     pManager->pDescriptorDataArray[descIndex].pRootConstant = pParam->pRootConstant;
                     
                     // Check if this rootConstant has previously been bound.
-                    if (pManager->mRootConstantBindingCountMap.find(hash).node) pManager->mRootConstantBindingCountMap[hash]++;
-                    else pManager->mRootConstantBindingCountMap[hash] = 0;
+                    {
+                        uint32_t hash = tinystl::hash(pManager->pDescriptorDataArray[descIndex].pName);
+                        if (pManager->mRootConstantBindingCountMap.find(hash).node) pManager->mRootConstantBindingCountMap[hash]++;
+                        else pManager->mRootConstantBindingCountMap[hash] = 0;
+                    }
                     break;
                 case DESCRIPTOR_TYPE_UNIFORM_BUFFER:
                 case DESCRIPTOR_TYPE_RW_BUFFER:
                 case DESCRIPTOR_TYPE_BUFFER:
                     if (!pParam->ppBuffers) {
-                        LOGERRORF("Buffer descriptor (%s) is NULL", pParam->pName);
+                        LOGERRORF("Buffer descriptor (%s) is NULL", pDescName);
                         return;
                     }
                     pManager->pDescriptorDataArray[descIndex].ppBuffers = pParam->ppBuffers;
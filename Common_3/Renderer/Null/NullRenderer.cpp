@@ -0,0 +1,1820 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#ifdef NULL_RENDERER
+
+#define RENDERER_IMPLEMENTATION
+
+#if defined(__cplusplus) && defined(RENDERER_CPP_NAMESPACE)
+namespace RENDERER_CPP_NAMESPACE {
+#endif
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "../IRenderer.h"
+#include "NullRenderer.h"
+#include "../PipelineCache.h"
+#include "../../ThirdParty/OpenSource/TinySTL/hash.h"
+#include "../../OS/Core/ContentHash.h"
+#include "../../OS/Interfaces/ILogManager.h"
+#include "../../OS/Interfaces/IMemoryManager.h"
+
+	// =================================================================================================
+	// IMPLEMENTATION
+	// =================================================================================================
+
+#if defined(RENDERER_IMPLEMENTATION)
+
+#define SAFE_FREE(p_var)		\
+    if(p_var) {               \
+       conf_free((void*)p_var);      \
+    }
+
+#if defined(__cplusplus)  
+#define DECLARE_ZERO(type, var) \
+            type var = {};                        
+#else
+#define DECLARE_ZERO(type, var) \
+            type var = {0};                        
+#endif
+
+	// Matches the minUniformBufferOffsetAlignment of most desktop GPUs so buffer sizes come out the same as on Vulkan
+	#define NULL_UNIFORM_BUFFER_ALIGNMENT 256U
+	#define NULL_MAX_ROOT_SIGNATURE_DWORDS 64U
+	// Timestamps are written in microseconds
+	#define NULL_TIMESTAMP_FREQUENCY 1e6
+
+	static volatile uint64_t gBufferIds = 0;
+	static volatile uint64_t gTextureIds = 0;
+	static volatile uint64_t gSamplerIds = 0;
+
+	static const char* gNullCommandNames[NULL_CMD_COUNT] =
+	{
+		"BeginRender",
+		"EndRender",
+		"SetViewport",
+		"SetScissor",
+		"BindPipeline",
+		"BindDescriptor",
+		"BindRootConstant",
+		"BindIndexBuffer",
+		"BindVertexBuffer",
+		"Draw",
+		"DrawInstanced",
+		"DrawIndexed",
+		"DrawIndexedInstanced",
+		"Dispatch",
+		"ExecuteIndirect",
+		"ResourceBarrier",
+		"SynchronizeResources",
+		"FlushBarriers",
+		"UpdateBuffer",
+		"UpdateSubresources",
+		"BeginQuery",
+		"EndQuery",
+		"ResolveQuery",
+		"BeginDebugMarker",
+		"EndDebugMarker",
+		"AddDebugMarker",
+	};
+
+	const char* getNullCommandName(NullCommandType type)
+	{
+		ASSERT(type < NULL_CMD_COUNT);
+		return gNullCommandNames[type];
+	}
+	/************************************************************************/
+	// Command recording
+	/************************************************************************/
+	// Appends a command to the stream of pCmd. The returned pointer is valid until the next record call
+	static NullCommand* record_command(Cmd* pCmd, NullCommandType type, uint32_t objectCount = 0, const void* const* ppObjects = NULL, const void* pData = NULL, uint32_t dataSize = 0)
+	{
+		ASSERT(pCmd);
+		NullCommandStream* pStream = pCmd->pNullStream;
+
+		NullCommand command = {};
+		command.mType = type;
+		command.mObjectOffset = (uint32_t)pStream->mObjects.size();
+		command.mObjectCount = objectCount;
+		command.mDataOffset = (uint32_t)pStream->mData.size();
+		command.mDataSize = dataSize;
+
+		for (uint32_t i = 0; i < objectCount; ++i)
+			pStream->mObjects.push_back(ppObjects[i]);
+
+		if (dataSize)
+		{
+			pStream->mData.resize(pStream->mData.size() + dataSize);
+			memcpy(pStream->mData.data() + command.mDataOffset, pData, dataSize);
+		}
+
+		pStream->mCommands.push_back(command);
+		return &pStream->mCommands.back();
+	}
+
+	static void record_debug_marker(Cmd* pCmd, NullCommandType type, float r, float g, float b, const char* pName)
+	{
+		NullCommand* pCommand = record_command(pCmd, type, 0, NULL, pName, pName ? (uint32_t)strlen(pName) + 1 : 0);
+		pCommand->mFloatArgs[0] = r;
+		pCommand->mFloatArgs[1] = g;
+		pCommand->mFloatArgs[2] = b;
+	}
+	/************************************************************************/
+	// Resource memory
+	/************************************************************************/
+	static uint32_t util_get_layer_count(const TextureDesc* pDesc)
+	{
+		uint32_t arraySize = pDesc->mArraySize ? pDesc->mArraySize : 1;
+		return pDesc->mType == TEXTURE_TYPE_CUBE ? arraySize * 6 : arraySize;
+	}
+
+	uint64_t getNullSubresourceSize(const Texture* pTexture, uint32_t mipLevel)
+	{
+		const TextureDesc* pDesc = &pTexture->mDesc;
+		// Depth 0 would mark a cube map in Image::GetMipMappedSize. Faces are separate layers here
+		return Image::GetMipMappedSize(pDesc->mWidth, pDesc->mHeight, pDesc->mDepth ? pDesc->mDepth : 1, mipLevel, 1, pDesc->mFormat);
+	}
+
+	uint64_t getNullSubresourceOffset(const Texture* pTexture, uint32_t mipLevel, uint32_t arrayLayer)
+	{
+		const uint32_t layerCount = util_get_layer_count(&pTexture->mDesc);
+		ASSERT(arrayLayer <= layerCount);
+
+		uint64_t offset = 0;
+		for (uint32_t mip = 0; mip < mipLevel; ++mip)
+			offset += layerCount * getNullSubresourceSize(pTexture, mip);
+
+		if (arrayLayer)
+			offset += arrayLayer * getNullSubresourceSize(pTexture, mipLevel);
+
+		return offset;
+	}
+
+	static void track_memory(Renderer* pRenderer, int32_t bufferCount, int64_t bufferMemory, int32_t textureCount, int64_t textureMemory)
+	{
+		NullDeviceStats* pStats = pRenderer->pNullStats;
+		MutexLock lock(pStats->mMutex);
+		pStats->mBufferCount += bufferCount;
+		pStats->mBufferMemory += bufferMemory;
+		pStats->mTextureCount += textureCount;
+		pStats->mTextureMemory += textureMemory;
+	}
+	/************************************************************************/
+	// Command execution
+	/************************************************************************/
+	static void execute_update_subresources(const NullCommandStream* pStream, const NullCommand* pCommand)
+	{
+		const Buffer* pIntermediate = (const Buffer*)pStream->mObjects[pCommand->mObjectOffset];
+		const Texture* pTexture = (const Texture*)pStream->mObjects[pCommand->mObjectOffset + 1];
+		const SubresourceDataDesc* pSubresources = (const SubresourceDataDesc*)(pStream->mData.data() + pCommand->mDataOffset);
+		const uint32_t subresourceCount = (uint32_t)pCommand->mArgs[0];
+
+		for (uint32_t i = 0; i < subresourceCount; ++i)
+		{
+			const SubresourceDataDesc* pRes = &pSubresources[i];
+			const uint64_t layerSize = Image::GetMipMappedSize(pRes->mWidth, pRes->mHeight, pRes->mDepth ? pRes->mDepth : 1, 0, 1, pTexture->mDesc.mFormat);
+			ASSERT(layerSize <= getNullSubresourceSize(pTexture, pRes->mMipLevel));
+
+			// Layers of one region are tightly packed one after the other in the intermediate buffer
+			for (uint32_t layer = 0; layer < pRes->mArraySize; ++layer)
+			{
+				const uint64_t srcOffset = pRes->mBufferOffset + layer * layerSize;
+				const uint64_t dstOffset = getNullSubresourceOffset(pTexture, pRes->mMipLevel, pRes->mArrayLayer + layer);
+				ASSERT(srcOffset + layerSize <= pIntermediate->mDesc.mSize);
+				ASSERT(dstOffset + layerSize <= pTexture->mTextureSize);
+				memcpy(pTexture->pNullMemory + dstOffset, pIntermediate->pNullMemory + srcOffset, layerSize);
+			}
+		}
+	}
+
+	// Only transfers and queries have side effects. Everything else is left in the stream for inspection
+	static void execute_command_stream(const NullCommandStream* pStream)
+	{
+		for (uint32_t i = 0; i < (uint32_t)pStream->mCommands.size(); ++i)
+		{
+			const NullCommand* pCommand = &pStream->mCommands[i];
+			const void* const* ppObjects = pStream->mObjects.data() + pCommand->mObjectOffset;
+
+			switch (pCommand->mType)
+			{
+			case NULL_CMD_UPDATE_BUFFER:
+			{
+				const Buffer* pSrcBuffer = (const Buffer*)ppObjects[0];
+				const Buffer* pBuffer = (const Buffer*)ppObjects[1];
+				memcpy(pBuffer->pNullMemory + pCommand->mArgs[1], pSrcBuffer->pNullMemory + pCommand->mArgs[0], pCommand->mArgs[2]);
+				break;
+			}
+			case NULL_CMD_UPDATE_SUBRESOURCES:
+				execute_update_subresources(pStream, pCommand);
+				break;
+			case NULL_CMD_BEGIN_QUERY:
+			case NULL_CMD_END_QUERY:
+			{
+				const QueryHeap* pQueryHeap = (const QueryHeap*)ppObjects[0];
+				if (pQueryHeap->mDesc.mType == QUERY_TYPE_TIMESTAMP)
+					pQueryHeap->pNullQueryData[pCommand->mArgs[0]] = (uint64_t)getUSec();
+				break;
+			}
+			case NULL_CMD_RESOLVE_QUERY:
+			{
+				const QueryHeap* pQueryHeap = (const QueryHeap*)ppObjects[0];
+				const Buffer* pReadbackBuffer = (const Buffer*)ppObjects[1];
+				ASSERT(pCommand->mArgs[1] * sizeof(uint64_t) <= pReadbackBuffer->mDesc.mSize);
+				// Same as vkCmdCopyQueryPoolResults with dstOffset 0
+				memcpy(pReadbackBuffer->pNullMemory, pQueryHeap->pNullQueryData + pCommand->mArgs[0], pCommand->mArgs[1] * sizeof(uint64_t));
+				break;
+			}
+			default:
+				break;
+			}
+		}
+	}
+	/************************************************************************/
+	// Create default resources to be used a null descriptors in case user does not specify some descriptors
+	/************************************************************************/
+	void create_default_resources(Renderer* pRenderer)
+	{
+		addBlendState(&pRenderer->pDefaultBlendState, BC_ONE, BC_ZERO, BC_ONE, BC_ZERO);
+		addDepthState(pRenderer, &pRenderer->pDefaultDepthState, false, true);
+		addRasterizerState(&pRenderer->pDefaultRasterizerState, CullMode::CULL_MODE_BACK);
+	}
+
+	void destroy_default_resources(Renderer* pRenderer)
+	{
+		removeBlendState(pRenderer->pDefaultBlendState);
+		removeDepthState(pRenderer->pDefaultDepthState);
+		removeRasterizerState(pRenderer->pDefaultRasterizerState);
+	}
+
+	ImageFormat::Enum getRecommendedSwapchainFormat(bool hintHDR)
+	{
+		UNREF_PARAM(hintHDR);
+		return ImageFormat::BGRA8;
+	}
+	// -------------------------------------------------------------------------------------------------
+	// API functions
+	// -------------------------------------------------------------------------------------------------
+	void initRenderer(const char *app_name, const RendererDesc * settings, Renderer** ppRenderer)
+	{
+		Renderer* pRenderer = (Renderer*)conf_calloc(1, sizeof(*pRenderer));
+		ASSERT(pRenderer);
+
+		// Copy settings
+		memcpy(&(pRenderer->mSettings), settings, sizeof(*settings));
+
+		pRenderer->mNumOfGPUs = 1;
+		pRenderer->mGpuSettings[0].mUniformBufferAlignment = NULL_UNIFORM_BUFFER_ALIGNMENT;
+		pRenderer->mGpuSettings[0].mMaxVertexInputBindings = MAX_VERTEX_BINDINGS;
+		pRenderer->mGpuSettings[0].mMultiDrawIndirect = true;
+		pRenderer->mGpuSettings[0].mMaxRootSignatureDWORDS = NULL_MAX_ROOT_SIGNATURE_DWORDS;
+		pRenderer->pActiveGpuSettings = &pRenderer->mGpuSettings[0];
+
+		pRenderer->pNullStats = (NullDeviceStats*)conf_calloc(1, sizeof(*pRenderer->pNullStats));
+		conf_placement_new<NullDeviceStats>(pRenderer->pNullStats);
+
+		LOGINFOF("Null renderer initialized for (%s)", app_name);
+
+		create_default_resources(pRenderer);
+
+		// Renderer is good! Assign it to result!
+		*(ppRenderer) = pRenderer;
+	}
+
+	void removeRenderer(Renderer* pRenderer)
+	{
+		ASSERT(pRenderer);
+
+		destroy_default_resources(pRenderer);
+
+		NullDeviceStats* pStats = pRenderer->pNullStats;
+		if (pStats->mBufferCount || pStats->mTextureCount)
+			LOGWARNINGF("Null renderer removed with (%u) buffers and (%u) textures still alive", pStats->mBufferCount, pStats->mTextureCount);
+
+		pStats->~NullDeviceStats();
+		SAFE_FREE(pStats);
+
+		// Free all the renderer components!
+		SAFE_FREE(pRenderer);
+	}
+
+	void addFence(Renderer* pRenderer, Fence** ppFence, uint64 mFenceValue)
+	{
+		UNREF_PARAM(mFenceValue);
+		ASSERT(pRenderer);
+
+		Fence* pFence = (Fence*)conf_calloc(1, sizeof(*pFence));
+		ASSERT(pFence);
+
+		pFence->pRenderer = pRenderer;
+		pFence->mSubmitted = false;
+
+		*ppFence = pFence;
+	}
+
+	void removeFence(Renderer *pRenderer, Fence* pFence)
+	{
+		UNREF_PARAM(pRenderer);
+		ASSERT(pRenderer);
+		ASSERT(pFence);
+
+		SAFE_FREE(pFence);
+	}
+
+	void addSemaphore(Renderer *pRenderer, Semaphore** ppSemaphore)
+	{
+		UNREF_PARAM(pRenderer);
+		ASSERT(pRenderer);
+
+		Semaphore* pSemaphore = (Semaphore*)conf_calloc(1, sizeof(*pSemaphore));
+		ASSERT(pSemaphore);
+
+		*ppSemaphore = pSemaphore;
+	}
+
+	void removeSemaphore(Renderer *pRenderer, Semaphore* pSemaphore)
+	{
+		UNREF_PARAM(pRenderer);
+		ASSERT(pRenderer);
+		ASSERT(pSemaphore);
+
+		SAFE_FREE(pSemaphore);
+	}
+
+	void addQueue(Renderer* pRenderer, QueueDesc* pDesc, Queue** ppQueue)
+	{
+		ASSERT(pDesc != NULL);
+
+		Queue* pQueue = (Queue*)conf_calloc(1, sizeof(*pQueue));
+		ASSERT(pQueue);
+
+		pQueue->pRenderer = pRenderer;
+		pQueue->mQueueDesc = *pDesc;
+
+		*ppQueue = pQueue;
+	}
+
+	void removeQueue(Queue* pQueue)
+	{
+		ASSERT(pQueue != NULL);
+		SAFE_FREE(pQueue);
+	}
+
+	void addCmdPool(Renderer *pRenderer, Queue* pQueue, bool transient, CmdPool** ppCmdPool, CmdPoolDesc * pCmdPoolDesc)
+	{
+		UNREF_PARAM(transient);
+		ASSERT(pRenderer);
+
+		CmdPool* pCmdPool = (CmdPool*)conf_calloc(1, sizeof(*pCmdPool));
+		ASSERT(pCmdPool);
+
+		if (pCmdPoolDesc == NULL)
+		{
+			pCmdPool->mCmdPoolDesc = { pQueue->mQueueDesc.mType };
+		}
+		else
+		{
+			pCmdPool->mCmdPoolDesc = *pCmdPoolDesc;
+		}
+
+		pCmdPool->pRenderer = pRenderer;
+		pCmdPool->pQueue = pQueue;
+
+		*ppCmdPool = pCmdPool;
+	}
+
+	void removeCmdPool(Renderer *pRenderer, CmdPool* pCmdPool)
+	{
+		UNREF_PARAM(pRenderer);
+		ASSERT(pRenderer);
+		ASSERT(pCmdPool);
+
+		SAFE_FREE(pCmdPool);
+	}
+
+	void addCmd(CmdPool* pCmdPool, bool secondary, Cmd** ppCmd)
+	{
+		UNREF_PARAM(secondary);
+		ASSERT(pCmdPool);
+
+		Cmd* pCmd = (Cmd*)conf_calloc(1, sizeof(*pCmd));
+		ASSERT(pCmd);
+
+		pCmd->pCmdPool = pCmdPool;
+
+		pCmd->pNullStream = (NullCommandStream*)conf_calloc(1, sizeof(*pCmd->pNullStream));
+		conf_placement_new<NullCommandStream>(pCmd->pNullStream);
+
+		*ppCmd = pCmd;
+	}
+
+	void removeCmd(CmdPool* pCmdPool, Cmd* pCmd)
+	{
+		UNREF_PARAM(pCmdPool);
+		ASSERT(pCmdPool);
+		ASSERT(pCmd);
+
+		pCmd->pNullStream->~NullCommandStream();
+		SAFE_FREE(pCmd->pNullStream);
+
+		SAFE_FREE(pCmd);
+	}
+
+	void addCmd_n(CmdPool *pCmdPool, bool secondary, uint32_t cmdCount, Cmd*** pppCmd)
+	{
+		ASSERT(pppCmd);
+
+		Cmd** ppCmd = (Cmd**)conf_calloc(cmdCount, sizeof(*ppCmd));
+		ASSERT(ppCmd);
+
+		for (uint32_t i = 0; i < cmdCount; ++i) {
+			addCmd(pCmdPool, secondary, &(ppCmd[i]));
+		}
+
+		*pppCmd = ppCmd;
+	}
+
+	void removeCmd_n(CmdPool *pCmdPool, uint32_t cmdCount, Cmd** ppCmd)
+	{
+		ASSERT(ppCmd);
+
+		for (uint32_t i = 0; i < cmdCount; ++i) {
+			removeCmd(pCmdPool, ppCmd[i]);
+		}
+
+		SAFE_FREE(ppCmd);
+	}
+
+	void addSwapChain(Renderer* pRenderer, const SwapChainDesc* pDesc, SwapChain** ppSwapChain)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pDesc);
+
+		SwapChain* pSwapChain = (SwapChain*)conf_calloc(1, sizeof(*pSwapChain));
+		ASSERT(pSwapChain);
+
+		pSwapChain->mDesc = *pDesc;
+		if (!pSwapChain->mDesc.mImageCount)
+			pSwapChain->mDesc.mImageCount = 2;
+		// First acquireNextImage hands out image 0
+		pSwapChain->mImageIndex = pSwapChain->mDesc.mImageCount - 1;
+
+		RenderTargetDesc descColor = {};
+		descColor.mType = RENDER_TARGET_TYPE_2D;
+		descColor.mUsage = RENDER_TARGET_USAGE_COLOR;
+		descColor.mWidth = pSwapChain->mDesc.mWidth;
+		descColor.mHeight = pSwapChain->mDesc.mHeight;
+		descColor.mDepth = 1;
+		descColor.mArraySize = 1;
+		descColor.mFormat = pSwapChain->mDesc.mColorFormat;
+		descColor.mSrgb = pSwapChain->mDesc.mSrgb;
+		descColor.mClearValue = pSwapChain->mDesc.mColorClearValue;
+		descColor.mSampleCount = SAMPLE_COUNT_1;
+		descColor.mSampleQuality = 0;
+
+		pSwapChain->ppSwapchainRenderTargets = (RenderTarget**)conf_calloc(pSwapChain->mDesc.mImageCount, sizeof(*pSwapChain->ppSwapchainRenderTargets));
+
+		for (uint32_t i = 0; i < pSwapChain->mDesc.mImageCount; ++i) {
+			addRenderTarget(pRenderer, &descColor, &pSwapChain->ppSwapchainRenderTargets[i]);
+		}
+
+		*ppSwapChain = pSwapChain;
+	}
+
+	void removeSwapChain(Renderer* pRenderer, SwapChain* pSwapChain)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pSwapChain);
+
+		for (uint32_t i = 0; i < pSwapChain->mDesc.mImageCount; ++i)
+		{
+			removeRenderTarget(pRenderer, pSwapChain->ppSwapchainRenderTargets[i]);
+		}
+
+		SAFE_FREE(pSwapChain->ppSwapchainRenderTargets);
+		SAFE_FREE(pSwapChain);
+	}
+
+	void addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** pp_buffer)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pDesc);
+		ASSERT(pDesc->mSize > 0);
+
+		Buffer* pBuffer = (Buffer*)conf_calloc(1, sizeof(*pBuffer));
+		ASSERT(pBuffer);
+
+		pBuffer->pRenderer = pRenderer;
+		pBuffer->mDesc = *pDesc;
+
+		// Align the buffer size to multiples of the dynamic uniform buffer minimum size
+		if (pBuffer->mDesc.mUsage & BUFFER_USAGE_UNIFORM)
+		{
+			uint64_t minAlignment = pRenderer->pActiveGpuSettings->mUniformBufferAlignment;
+			pBuffer->mDesc.mSize = round_up_64(pBuffer->mDesc.mSize, minAlignment);
+		}
+
+		// Zero initialized so uninitialized reads are deterministic
+		pBuffer->pNullMemory = (uint8_t*)conf_calloc((size_t)pBuffer->mDesc.mSize, sizeof(uint8_t));
+		ASSERT(pBuffer->pNullMemory);
+
+		if (pBuffer->mDesc.mFlags & BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT)
+			pBuffer->pCpuMappedAddress = pBuffer->pNullMemory;
+
+		pBuffer->mCurrentState = RESOURCE_STATE_UNDEFINED;
+		pBuffer->mBufferId = (++gBufferIds << 8U) + Thread::GetCurrentThreadID();
+
+		track_memory(pRenderer, 1, (int64_t)pBuffer->mDesc.mSize, 0, 0);
+
+		*pp_buffer = pBuffer;
+	}
+
+	void removeBuffer(Renderer* pRenderer, Buffer* pBuffer)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pBuffer);
+
+		track_memory(pRenderer, -1, -(int64_t)pBuffer->mDesc.mSize, 0, 0);
+
+		SAFE_FREE(pBuffer->pNullMemory);
+		SAFE_FREE(pBuffer);
+	}
+
+	void addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTexture)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pDesc && pDesc->mWidth && pDesc->mHeight && (pDesc->mDepth || pDesc->mArraySize));
+		if (pDesc->mSampleCount > SAMPLE_COUNT_1 && pDesc->mMipLevels > 1)
+		{
+			LOGERROR("Multi-Sampled textures cannot have mip maps");
+			ASSERT(false);
+			return;
+		}
+
+		Texture* pTexture = (Texture*)conf_calloc(1, sizeof(*pTexture));
+		ASSERT(pTexture);
+
+		pTexture->pRenderer = pRenderer;
+		pTexture->mDesc = *pDesc;
+		if (!pTexture->mDesc.mMipLevels)
+			pTexture->mDesc.mMipLevels = 1;
+		// Monotonically increasing thread safe id generation
+		pTexture->mTextureId = (++gTextureIds << 8U) + Thread::GetCurrentThreadID();
+
+		// Offset one past the last mip is the size of the whole mip chain
+		pTexture->mTextureSize = getNullSubresourceOffset(pTexture, pTexture->mDesc.mMipLevels, 0);
+
+		if (pDesc->pNativeHandle && !(pDesc->mFlags & TEXTURE_CREATION_FLAG_IMPORT_BIT))
+		{
+			// Native handle of the null device is the system memory of the texture
+			pTexture->mOwnsImage = false;
+			pTexture->pNullMemory = (uint8_t*)pDesc->pNativeHandle;
+		}
+		else
+		{
+			pTexture->mOwnsImage = true;
+			pTexture->pNullMemory = (uint8_t*)conf_calloc((size_t)pTexture->mTextureSize, sizeof(uint8_t));
+			ASSERT(pTexture->pNullMemory);
+			track_memory(pRenderer, 0, 0, 1, (int64_t)pTexture->mTextureSize);
+		}
+
+		if (pTexture->mDesc.mHostVisible)
+			pTexture->pCpuMappedAddress = pTexture->pNullMemory;
+
+		pTexture->mCurrentState = RESOURCE_STATE_UNDEFINED;
+
+		*ppTexture = pTexture;
+	}
+
+	void addRenderTarget(Renderer* pRenderer, const RenderTargetDesc* pDesc, RenderTarget** ppRenderTarget, void* pNativeHandle /* = NULL */)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pDesc);
+		ASSERT(ppRenderTarget);
+
+		RenderTarget* pRenderTarget = (RenderTarget*)conf_calloc(1, sizeof(*pRenderTarget));
+		pRenderTarget->mDesc = *pDesc;
+
+		TextureDesc textureDesc = {};
+		textureDesc.mBaseArrayLayer = pDesc->mBaseArrayLayer;
+		textureDesc.mArraySize = pDesc->mArraySize;
+		textureDesc.mClearValue = pDesc->mClearValue;
+		textureDesc.mDepth = pDesc->mDepth;
+		textureDesc.mFlags = pDesc->mFlags;
+		textureDesc.mFormat = pDesc->mFormat;
+		textureDesc.mHeight = pDesc->mHeight;
+		textureDesc.mHostVisible = false;
+		textureDesc.mBaseMipLevel = pDesc->mBaseMipLevel;
+		textureDesc.mMipLevels = 1;
+		textureDesc.mSampleCount = pDesc->mSampleCount;
+		textureDesc.mSampleQuality = pDesc->mSampleQuality;
+		textureDesc.mStartState = (pDesc->mUsage == RENDER_TARGET_USAGE_COLOR) ? RESOURCE_STATE_RENDER_TARGET : RESOURCE_STATE_DEPTH_WRITE;
+		// Set this by default to be able to sample the rendertarget in shader
+		textureDesc.mUsage = TEXTURE_USAGE_SAMPLED_IMAGE;
+		textureDesc.mWidth = pDesc->mWidth;
+		textureDesc.pNativeHandle = pNativeHandle;
+		textureDesc.mSrgb = pDesc->mSrgb;
+
+		switch (pDesc->mType)
+		{
+		case RENDER_TARGET_TYPE_1D:
+			textureDesc.mType = TEXTURE_TYPE_1D;
+			break;
+		case RENDER_TARGET_TYPE_2D:
+			textureDesc.mType = TEXTURE_TYPE_2D;
+			break;
+		case RENDER_TARGET_TYPE_3D:
+			textureDesc.mType = TEXTURE_TYPE_3D;
+			break;
+		default:
+			break;
+		}
+
+		addTexture(pRenderer, &textureDesc, &pRenderTarget->pTexture);
+
+		*ppRenderTarget = pRenderTarget;
+	}
+
+	void removeTexture(Renderer* pRenderer, Texture* pTexture)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pTexture);
+
+		if (pTexture->mOwnsImage)
+		{
+			track_memory(pRenderer, 0, 0, -1, -(int64_t)pTexture->mTextureSize);
+			SAFE_FREE(pTexture->pNullMemory);
+		}
+
+		SAFE_FREE(pTexture);
+	}
+
+	void removeRenderTarget(Renderer* pRenderer, RenderTarget* pRenderTarget)
+	{
+		removeTexture(pRenderer, pRenderTarget->pTexture);
+		SAFE_FREE(pRenderTarget);
+	}
+
+	void addSampler(Renderer* pRenderer, Sampler** pp_sampler, FilterType minFilter, FilterType magFilter, MipMapMode  mipMapMode, AddressMode addressU, AddressMode addressV, AddressMode addressW, float mipLosBias, float maxAnisotropy)
+	{
+		ASSERT(pRenderer);
+
+		Sampler* pSampler = (Sampler*)conf_calloc(1, sizeof(*pSampler));
+		ASSERT(pSampler);
+		pSampler->pRenderer = pRenderer;
+
+		pSampler->mMinFilter = minFilter;
+		pSampler->mMagFilter = magFilter;
+		pSampler->mMipMapMode = mipMapMode;
+		pSampler->mAddressU = addressU;
+		pSampler->mAddressV = addressV;
+		pSampler->mAddressW = addressW;
+		pSampler->mMipLodBias = mipLosBias;
+		pSampler->mMaxAnisotropy = maxAnisotropy;
+
+		pSampler->mSamplerId = (++gSamplerIds << 8U) + Thread::GetCurrentThreadID();
+
+		*pp_sampler = pSampler;
+	}
+
+	void removeSampler(Renderer* pRenderer, Sampler* pSampler)
+	{
+		UNREF_PARAM(pRenderer);
+		ASSERT(pRenderer);
+		ASSERT(pSampler);
+
+		SAFE_FREE(pSampler);
+	}
+
+	// Stage reflection is cached as <spv path>.refl next to the byte code and keyed by the hash of the code
+	// The null renderer consumes the same SPIR-V as the Vulkan renderer so root signatures get the real descriptor layout
+	static void create_cached_shader_reflection(const ShaderStageDesc* pStageDesc, ShaderStage stage, ShaderReflection* pOutReflection)
+	{
+		const uint8_t* pCode = (const uint8_t*)pStageDesc->mCode.c_str();
+		const uint32_t codeSize = pStageDesc->mCode.getLength();
+		const uint64_t codeHash = XXHash64(pCode, codeSize);
+
+		tinystl::string cachePath;
+		if (pStageDesc->mName.size())
+		{
+			cachePath = pStageDesc->mName + ".refl";
+			if (loadShaderReflectionFile(cachePath.c_str(), codeHash, pOutReflection) && pOutReflection->mShaderStage == stage)
+				return;
+			destroyShaderReflection(pOutReflection);
+		}
+
+		createShaderReflection(pCode, codeSize, stage, pOutReflection);
+
+		if (cachePath.size())
+			saveShaderReflectionFile(cachePath.c_str(), codeHash, pOutReflection);
+	}
+
+	void addShader(Renderer* pRenderer, const ShaderDesc* pDesc, Shader** ppShaderProgram)
+	{
+		ASSERT(pRenderer);
+
+		Shader* pShaderProgram = (Shader*)conf_calloc(1, sizeof(*pShaderProgram));
+		pShaderProgram->pRenderer = pRenderer;
+		pShaderProgram->mStages = pDesc->mStages;
+
+		uint32_t counter = 0;
+		ShaderReflection stageReflections[SHADER_STAGE_COUNT];
+
+		for (uint32_t i = 0; i < SHADER_STAGE_COUNT; ++i) {
+			ShaderStage stage_mask = (ShaderStage)(1 << i);
+			if (stage_mask != (pShaderProgram->mStages & stage_mask))
+				continue;
+
+			const ShaderStageDesc* pStageDesc = NULL;
+			switch (stage_mask) {
+			case SHADER_STAGE_VERT: pStageDesc = &pDesc->mVert; break;
+			case SHADER_STAGE_TESC: pStageDesc = &pDesc->mHull; break;
+			case SHADER_STAGE_TESE: pStageDesc = &pDesc->mDomain; break;
+			case SHADER_STAGE_GEOM: pStageDesc = &pDesc->mGeom; break;
+			case SHADER_STAGE_FRAG: pStageDesc = &pDesc->mFrag; break;
+			case SHADER_STAGE_COMP: pStageDesc = &pDesc->mComp; break;
+			default: break;
+			}
+
+			if (!pStageDesc)
+				continue;
+
+			create_cached_shader_reflection(pStageDesc, stage_mask, &stageReflections[counter++]);
+
+			if (stage_mask == SHADER_STAGE_TESC)
+				memcpy(&pShaderProgram->mNumControlPoint, &stageReflections[counter - 1].mNumControlPoint, sizeof(pShaderProgram->mNumControlPoint));
+			else if (stage_mask == SHADER_STAGE_COMP)
+				memcpy(pShaderProgram->mNumThreadsPerGroup, stageReflections[counter - 1].mNumThreadsPerGroup, sizeof(pShaderProgram->mNumThreadsPerGroup));
+
+			pShaderProgram->mContentHash = hashShaderStage(stage_mask, pStageDesc->mCode.c_str(), (uint32_t)pStageDesc->mCode.size(), pStageDesc->mEntryPoint.c_str(), pShaderProgram->mContentHash);
+		}
+
+		createPipelineReflection(stageReflections, counter, &pShaderProgram->mReflection);
+
+		*ppShaderProgram = pShaderProgram;
+	}
+
+	void removeShader(Renderer* pRenderer, Shader* pShaderProgram)
+	{
+		UNREF_PARAM(pRenderer);
+		ASSERT(pRenderer);
+
+		destroyPipelineReflection(&pShaderProgram->mReflection);
+
+		SAFE_FREE(pShaderProgram);
+	}
+
+	/// Default root signature description - Used when no description is provided in addRootSignature
+	RootSignatureDesc gDefaultRootSignatureDesc = {};
+
+	void addRootSignature(Renderer* pRenderer, uint32_t numShaders, Shader* const* ppShaders, RootSignature** ppRootSignature, const RootSignatureDesc* pRootDesc)
+	{
+		UNREF_PARAM(pRenderer);
+		RootSignature* pRootSignature = (RootSignature*)conf_calloc(1, sizeof(*pRootSignature));
+
+		tinystl::vector<tinystl::vector<DescriptorInfo*> > layouts(DESCRIPTOR_UPDATE_FREQ_COUNT);
+		tinystl::vector<uint32_t> pushConstantDescriptors;
+		tinystl::vector<ShaderResource const*> shaderResources;
+		const RootSignatureDesc* pRootSignatureDesc = pRootDesc ? pRootDesc : &gDefaultRootSignatureDesc;
+
+		conf_placement_new<tinystl::unordered_map<uint32_t, uint32_t> >(&pRootSignature->pDescriptorNameToIndexMap);
+
+		// Collect all unique shader resources in the given shaders
+		// Resources are parsed by name (two resources named "XYZ" in two shaders will be considered the same resource)
+		for (uint32_t sh = 0; sh < numShaders; ++sh)
+		{
+			PipelineReflection const* pReflection = &ppShaders[sh]->mReflection;
+
+			if (pReflection->mShaderStages & SHADER_STAGE_COMP)
+				pRootSignature->mPipelineType = PIPELINE_TYPE_COMPUTE;
+			else
+				pRootSignature->mPipelineType = PIPELINE_TYPE_GRAPHICS;
+
+			for (uint32_t i = 0; i < pReflection->mShaderResourceCount; ++i)
+			{
+				ShaderResource const* pRes = &pReflection->pShaderResources[i];
+
+				if (pRootSignature->pDescriptorNameToIndexMap.find(tinystl::hash(pRes->name)).node == 0)
+				{
+					pRootSignature->pDescriptorNameToIndexMap.insert({ tinystl::hash(pRes->name), shaderResources.getCount() });
+					shaderResources.emplace_back(pRes);
+				}
+			}
+		}
+
+		if (shaderResources.getCount())
+		{
+			pRootSignature->mDescriptorCount = shaderResources.getCount();
+			pRootSignature->pDescriptors = (DescriptorInfo*)conf_calloc(pRootSignature->mDescriptorCount, sizeof(DescriptorInfo));
+		}
+
+		// Fill the descriptor array to be stored in the root signature
+		for (uint32_t i = 0; i < shaderResources.getCount(); ++i)
+		{
+			DescriptorInfo* pDesc = &pRootSignature->pDescriptors[i];
+			ShaderResource const* pRes = shaderResources[i];
+			uint32_t setIndex = pRes->set;
+
+			// Copy the binding information generated from the shader reflection into the descriptor
+			pDesc->mDesc.reg = pRes->reg;
+			pDesc->mDesc.set = pRes->set;
+			pDesc->mDesc.size = pRes->size;
+			pDesc->mDesc.type = pRes->type;
+			pDesc->mDesc.used_stages = pRes->used_stages;
+			pDesc->mDesc.name_size = pRes->name_size;
+			pDesc->mDesc.name = (const char*)conf_calloc(pDesc->mDesc.name_size + 1, sizeof(char));
+			memcpy((char*)pDesc->mDesc.name, pRes->name, pRes->name_size);
+
+			if (pDesc->mDesc.type == DESCRIPTOR_TYPE_ROOT_CONSTANT)
+			{
+				pDesc->mDesc.set = 0;
+				pushConstantDescriptors.emplace_back(i);
+				continue;
+			}
+
+			if (setIndex >= DESCRIPTOR_UPDATE_FREQ_COUNT)
+			{
+				LOGERRORF("Descriptor (%s) : set (%u) is out of range. Using DESCRIPTOR_UPDATE_FREQ_NONE", pDesc->mDesc.name, setIndex);
+				setIndex = DESCRIPTOR_UPDATE_FREQ_NONE;
+			}
+			pDesc->mUpdateFrquency = (DescriptorUpdateFrequency)setIndex;
+
+			// Find if the given descriptor is a static sampler
+			if (pRootSignatureDesc->mStaticSamplers.find(pDesc->mDesc.name).node)
+			{
+				LOGINFOF("Descriptor (%s) : User specified Static Sampler", pDesc->mDesc.name);
+
+				// Set the index to an invalid value so we can use this later for error checking if user tries to update a static sampler
+				pDesc->mIndexInParent = -1;
+			}
+			else
+			{
+				layouts[setIndex].emplace_back(pDesc);
+			}
+		}
+
+		pRootSignature->mRootConstantCount = pushConstantDescriptors.getCount();
+		if (pRootSignature->mRootConstantCount)
+			pRootSignature->pRootConstantLayouts = (RootConstantLayout*)conf_calloc(pRootSignature->mRootConstantCount, sizeof(*pRootSignature->pRootConstantLayouts));
+
+		for (uint32_t i = 0; i < pRootSignature->mRootConstantCount; ++i)
+		{
+			pRootSignature->pDescriptors[pushConstantDescriptors[i]].mIndexInParent = i;
+			pRootSignature->pRootConstantLayouts[i].mDescriptorIndex = pushConstantDescriptors[i];
+		}
+
+		pRootSignature->pDescriptorSetLayouts = (DescriptorSetLayout*)conf_calloc(DESCRIPTOR_UPDATE_FREQ_COUNT, sizeof(*pRootSignature->pDescriptorSetLayouts));
+
+		// Descriptors of one update frequency are laid out one after the other, arrays take one slot per element
+		for (uint32_t setIndex = 0; setIndex < DESCRIPTOR_UPDATE_FREQ_COUNT; ++setIndex)
+		{
+			const tinystl::vector<DescriptorInfo*>& layout = layouts[setIndex];
+			DescriptorSetLayout& table = pRootSignature->pDescriptorSetLayouts[setIndex];
+			if (!layout.getCount())
+				continue;
+
+			table.mDescriptorCount = layout.getCount();
+			table.pDescriptorIndices = (uint32_t*)conf_calloc(table.mDescriptorCount, sizeof(uint32_t));
+
+			for (uint32_t descIndex = 0; descIndex < layout.getCount(); ++descIndex)
+			{
+				DescriptorInfo* pDesc = layout[descIndex];
+				pDesc->mIndexInParent = descIndex;
+				pDesc->mHandleIndex = table.mCumulativeDescriptorCount;
+				table.mCumulativeDescriptorCount += pDesc->mDesc.size;
+				table.pDescriptorIndices[descIndex] = (uint32_t)(pDesc - pRootSignature->pDescriptors);
+			}
+		}
+
+		conf_placement_new<RootSignature::ThreadLocalDescriptorManager>(&pRootSignature->pDescriptorManagerMap);
+
+		*ppRootSignature = pRootSignature;
+	}
+
+	void removeRootSignature(Renderer* pRenderer, RootSignature* pRootSignature)
+	{
+		UNREF_PARAM(pRenderer);
+		pRootSignature->pDescriptorManagerMap.~unordered_map();
+
+		for (uint32_t i = 0; i < DESCRIPTOR_UPDATE_FREQ_COUNT; ++i)
+		{
+			SAFE_FREE(pRootSignature->pDescriptorSetLayouts[i].pDescriptorIndices);
+		}
+
+		for (uint32_t i = 0; i < pRootSignature->mDescriptorCount; ++i)
+		{
+			SAFE_FREE(pRootSignature->pDescriptors[i].mDesc.name);
+		}
+
+		SAFE_FREE(pRootSignature->pRootConstantLayouts);
+		SAFE_FREE(pRootSignature->pDescriptors);
+		SAFE_FREE(pRootSignature->pDescriptorSetLayouts);
+
+		// Need delete since the destructor frees allocated memory
+		pRootSignature->pDescriptorNameToIndexMap.~unordered_map();
+
+		SAFE_FREE(pRootSignature);
+	}
+
+	const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const DescriptorData* pParam, uint32_t* pIndex)
+	{
+		// Slot resolved up front through getDescriptorIndexFromName - no string hashing required
+		if (pParam->mIndex != (uint32_t)-1)
+		{
+			if (pParam->mIndex >= pRootSignature->mDescriptorCount)
+			{
+				LOGERRORF("Invalid descriptor index (%u). Root signature has (%u) descriptors", pParam->mIndex, pRootSignature->mDescriptorCount);
+				return NULL;
+			}
+
+			*pIndex = pParam->mIndex;
+			return &pRootSignature->pDescriptors[pParam->mIndex];
+		}
+
+		tinystl::unordered_map<uint32_t, uint32_t>::const_iterator it = pRootSignature->pDescriptorNameToIndexMap.find(tinystl::hash(pParam->pName));
+		if (it.node)
+		{
+			*pIndex = it.node->second;
+			return &pRootSignature->pDescriptors[it.node->second];
+		}
+		else
+		{
+			LOGERRORF("Invalid descriptor param (%s)", pParam->pName);
+			return NULL;
+		}
+	}
+
+	uint32_t getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName)
+	{
+		ASSERT(pRootSignature);
+		ASSERT(pName);
+
+		tinystl::unordered_map<uint32_t, uint32_t>::const_iterator it = pRootSignature->pDescriptorNameToIndexMap.find(tinystl::hash(pName));
+		if (it.node)
+			return it.node->second;
+
+		LOGERRORF("Invalid descriptor param (%s)", pName);
+		return (uint32_t)-1;
+	}
+
+	void addPipeline(Renderer* pRenderer, const GraphicsPipelineDesc* pDesc, Pipeline** ppPipeline)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pDesc);
+		ASSERT(pDesc->pShaderProgram);
+		ASSERT(pDesc->pRootSignature);
+
+		Pipeline* pPipeline = (Pipeline*)conf_calloc(1, sizeof(*pPipeline));
+		ASSERT(pPipeline);
+
+		pPipeline->pRenderer = pRenderer;
+		memcpy(&(pPipeline->mGraphics), pDesc, sizeof(*pDesc));
+		pPipeline->mType = PIPELINE_TYPE_GRAPHICS;
+
+		*ppPipeline = pPipeline;
+	}
+
+	void addComputePipeline(Renderer* pRenderer, const ComputePipelineDesc* pDesc, Pipeline** ppPipeline)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pDesc);
+		ASSERT(pDesc->pShaderProgram);
+		ASSERT(pDesc->pRootSignature);
+		ASSERT(pDesc->pShaderProgram->mStages & SHADER_STAGE_COMP);
+
+		Pipeline* pPipeline = (Pipeline*)conf_calloc(1, sizeof(*pPipeline));
+		ASSERT(pPipeline);
+
+		pPipeline->pRenderer = pRenderer;
+		memcpy(&(pPipeline->mCompute), pDesc, sizeof(*pDesc));
+		pPipeline->mType = PIPELINE_TYPE_COMPUTE;
+
+		*ppPipeline = pPipeline;
+	}
+
+	void removePipeline(Renderer* pRenderer, Pipeline* pPipeline)
+	{
+		UNREF_PARAM(pRenderer);
+		ASSERT(pRenderer);
+		ASSERT(pPipeline);
+
+		SAFE_FREE(pPipeline);
+	}
+
+	void addBlendState(BlendState** ppBlendState,
+		BlendConstant srcFactor, BlendConstant destFactor,
+		BlendConstant srcAlphaFactor, BlendConstant destAlphaFactor,
+		BlendMode blendMode /*= BlendMode::BM_REPLACE*/, BlendMode blendAlphaMode /*= BlendMode::BM_REPLACE*/,
+		const int mask /*= ALL*/, const int MRTRenderTargetNumber /*= eBlendStateMRTRenderTarget0*/, const bool alphaToCoverage /*= false*/)
+	{
+		ASSERT(srcFactor < BlendConstant::MAX_BLEND_CONSTANTS);
+		ASSERT(destFactor < BlendConstant::MAX_BLEND_CONSTANTS);
+		ASSERT(srcAlphaFactor < BlendConstant::MAX_BLEND_CONSTANTS);
+		ASSERT(destAlphaFactor < BlendConstant::MAX_BLEND_CONSTANTS);
+		ASSERT(blendMode < BlendMode::MAX_BLEND_MODES);
+		ASSERT(blendAlphaMode < BlendMode::MAX_BLEND_MODES);
+
+		BlendState blendState = {};
+		blendState.mSrcFactor = srcFactor;
+		blendState.mDestFactor = destFactor;
+		blendState.mSrcAlphaFactor = srcAlphaFactor;
+		blendState.mDestAlphaFactor = destAlphaFactor;
+		blendState.mBlendMode = blendMode;
+		blendState.mBlendAlphaMode = blendAlphaMode;
+		blendState.mMask = mask;
+		blendState.mRenderTargetMask = MRTRenderTargetNumber;
+		blendState.mAlphaToCoverage = alphaToCoverage;
+
+		*ppBlendState = (BlendState*)conf_malloc(sizeof(blendState));
+		memcpy(*ppBlendState, &blendState, sizeof(blendState));
+	}
+
+	void removeBlendState(BlendState* pBlendState)
+	{
+		SAFE_FREE(pBlendState);
+	}
+
+	void addDepthState(Renderer* pRenderer, DepthState** ppDepthState, const bool depthTest, const bool depthWrite,
+		const CompareMode depthFunc /*= CompareMode::CMP_LEQUAL*/,
+		const bool stencilTest /*= false*/,
+		const uint8 stencilReadMask /*= 0xFF*/,
+		const uint8 stencilWriteMask /*= 0xFF*/,
+		const CompareMode stencilFrontFunc /*= CompareMode::CMP_ALWAYS*/,
+		const StencilOp stencilFrontFail /*= StencilOp::STENCIL_OP_KEEP*/,
+		const StencilOp depthFrontFail /*= StencilOp::STENCIL_OP_KEEP*/,
+		const StencilOp stencilFrontPass /*= StencilOp::STENCIL_OP_KEEP*/,
+		const CompareMode stencilBackFunc /*= CompareMode::CMP_ALWAYS*/,
+		const StencilOp stencilBackFail /*= StencilOp::STENCIL_OP_KEEP*/,
+		const StencilOp depthBackFail /*= StencilOp::STENCIL_OP_KEEP*/,
+		const StencilOp stencilBackPass /*= StencilOp::STENCIL_OP_KEEP*/)
+	{
+		UNREF_PARAM(pRenderer);
+		ASSERT(depthFunc < CompareMode::MAX_COMPARE_MODES);
+		ASSERT(stencilFrontFunc < CompareMode::MAX_COMPARE_MODES);
+		ASSERT(stencilFrontFail < StencilOp::MAX_STENCIL_OPS);
+		ASSERT(depthFrontFail < StencilOp::MAX_STENCIL_OPS);
+		ASSERT(stencilFrontPass < StencilOp::MAX_STENCIL_OPS);
+		ASSERT(stencilBackFunc < CompareMode::MAX_COMPARE_MODES);
+		ASSERT(stencilBackFail < StencilOp::MAX_STENCIL_OPS);
+		ASSERT(depthBackFail < StencilOp::MAX_STENCIL_OPS);
+		ASSERT(stencilBackPass < StencilOp::MAX_STENCIL_OPS);
+
+		DepthState depthState = {};
+		depthState.mDepthTest = depthTest;
+		depthState.mDepthWrite = depthWrite;
+		depthState.mDepthFunc = depthFunc;
+		depthState.mStencilTest = stencilTest;
+		depthState.mStencilReadMask = stencilReadMask;
+		depthState.mStencilWriteMask = stencilWriteMask;
+		depthState.mStencilFrontFunc = stencilFrontFunc;
+		depthState.mStencilFrontFail = stencilFrontFail;
+		depthState.mDepthFrontFail = depthFrontFail;
+		depthState.mStencilFrontPass = stencilFrontPass;
+		depthState.mStencilBackFunc = stencilBackFunc;
+		depthState.mStencilBackFail = stencilBackFail;
+		depthState.mDepthBackFail = depthBackFail;
+		depthState.mStencilBackPass = stencilBackPass;
+
+		*ppDepthState = (DepthState*)conf_malloc(sizeof(depthState));
+		memcpy(*ppDepthState, &depthState, sizeof(depthState));
+	}
+
+	void removeDepthState(DepthState* pDepthState)
+	{
+		SAFE_FREE(pDepthState);
+	}
+
+	void addRasterizerState(RasterizerState** ppRasterizerState,
+		const CullMode cullMode,
+		const int depthBias /*= 0*/,
+		const float slopeScaledDepthBias /*= 0*/,
+		const FillMode fillMode /*= FillMode::FILL_MODE_SOLID*/,
+		const bool multiSample /*= false*/,
+		const bool scissor /*= false*/)
+	{
+		ASSERT(fillMode < FillMode::MAX_FILL_MODES);
+		ASSERT(cullMode < CullMode::MAX_CULL_MODES);
+
+		RasterizerState rasterizerState = {};
+		rasterizerState.mCullMode = cullMode;
+		rasterizerState.mDepthBias = depthBias;
+		rasterizerState.mSlopeScaledDepthBias = slopeScaledDepthBias;
+		rasterizerState.mFillMode = fillMode;
+		rasterizerState.mMultiSample = multiSample;
+		rasterizerState.mScissor = scissor;
+
+		*ppRasterizerState = (RasterizerState*)conf_malloc(sizeof(rasterizerState));
+		memcpy(*ppRasterizerState, &rasterizerState, sizeof(rasterizerState));
+	}
+
+	void removeRasterizerState(RasterizerState* pRasterizerState)
+	{
+		SAFE_FREE(pRasterizerState);
+	}
+	// -------------------------------------------------------------------------------------------------
+	// Buffer functions
+	// -------------------------------------------------------------------------------------------------
+	void mapBuffer(Renderer* pRenderer, Buffer* pBuffer, ReadRange* pRange = NULL)
+	{
+		UNREF_PARAM(pRenderer);
+		ASSERT(pBuffer->mDesc.mMemoryUsage != RESOURCE_MEMORY_USAGE_GPU_ONLY && "Trying to map non-cpu accessible resource");
+
+		uint64_t offset = 0;
+		if (pRange)
+		{
+			ASSERT(pRange->mOffset + pRange->mSize <= pBuffer->mDesc.mSize);
+			offset = pRange->mOffset;
+		}
+
+		pBuffer->pCpuMappedAddress = pBuffer->pNullMemory + offset;
+	}
+
+	void unmapBuffer(Renderer* pRenderer, Buffer* pBuffer)
+	{
+		UNREF_PARAM(pRenderer);
+		ASSERT(pBuffer->mDesc.mMemoryUsage != RESOURCE_MEMORY_USAGE_GPU_ONLY && "Trying to unmap non-cpu accessible resource");
+
+		pBuffer->pCpuMappedAddress = NULL;
+	}
+	// -------------------------------------------------------------------------------------------------
+	// Command buffer functions
+	// -------------------------------------------------------------------------------------------------
+	void beginCmd(Cmd* pCmd)
+	{
+		ASSERT(pCmd);
+
+		NullCommandStream* pStream = pCmd->pNullStream;
+		pStream->mCommands.clear();
+		pStream->mObjects.clear();
+		pStream->mData.clear();
+		pStream->mErrorCount = 0;
+		pStream->mBatchedBarrierCount = 0;
+
+		pCmd->pBoundRootSignature = NULL;
+	}
+
+	void endCmd(Cmd* pCmd)
+	{
+		ASSERT(pCmd);
+
+		cmdFlushBarriers(pCmd);
+	}
+
+	void cmdBeginRender(Cmd* pCmd, uint32_t renderTargetCount, RenderTarget** ppRenderTargets, RenderTarget* pDepthStencil, const LoadActionsDesc* pLoadActions/* = NULL*/)
+	{
+		ASSERT(pCmd);
+		ASSERT(renderTargetCount <= MAX_RENDER_TARGET_ATTACHMENTS);
+
+		const void* pTextures[MAX_RENDER_TARGET_ATTACHMENTS + 1] = {};
+		uint32_t textureCount = 0;
+		for (uint32_t i = 0; i < renderTargetCount; ++i)
+			pTextures[textureCount++] = ppRenderTargets[i]->pTexture;
+		if (pDepthStencil)
+			pTextures[textureCount++] = pDepthStencil->pTexture;
+
+		NullCommand* pCommand = record_command(pCmd, NULL_CMD_BEGIN_RENDER, textureCount, pTextures, pLoadActions, pLoadActions ? (uint32_t)sizeof(*pLoadActions) : 0);
+		pCommand->mArgs[0] = renderTargetCount;
+		pCommand->mArgs[1] = pDepthStencil ? 1 : 0;
+	}
+
+	void cmdEndRender(Cmd* pCmd, uint32_t renderTargetCount, RenderTarget** ppRenderTargets, RenderTarget* pDepthStencil)
+	{
+		UNREF_PARAM(ppRenderTargets);
+		ASSERT(pCmd);
+
+		NullCommand* pCommand = record_command(pCmd, NULL_CMD_END_RENDER);
+		pCommand->mArgs[0] = renderTargetCount;
+		pCommand->mArgs[1] = pDepthStencil ? 1 : 0;
+	}
+
+	void cmdSetViewport(Cmd* pCmd, float x, float y, float width, float height, float minDepth, float maxDepth)
+	{
+		ASSERT(pCmd);
+
+		NullCommand* pCommand = record_command(pCmd, NULL_CMD_SET_VIEWPORT);
+		pCommand->mFloatArgs[0] = x;
+		pCommand->mFloatArgs[1] = y;
+		pCommand->mFloatArgs[2] = width;
+		pCommand->mFloatArgs[3] = height;
+		pCommand->mFloatArgs[4] = minDepth;
+		pCommand->mFloatArgs[5] = maxDepth;
+	}
+
+	void cmdSetScissor(Cmd* pCmd, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+	{
+		ASSERT(pCmd);
+
+		NullCommand* pCommand = record_command(pCmd, NULL_CMD_SET_SCISSOR);
+		pCommand->mArgs[0] = x;
+		pCommand->mArgs[1] = y;
+		pCommand->mArgs[2] = width;
+		pCommand->mArgs[3] = height;
+	}
+
+	void cmdBindPipeline(Cmd* pCmd, Pipeline* pPipeline)
+	{
+		ASSERT(pCmd);
+		ASSERT(pPipeline);
+
+		const void* pObject = pPipeline;
+		record_command(pCmd, NULL_CMD_BIND_PIPELINE, 1, &pObject);
+	}
+
+	// Validation matches the Vulkan renderer so descriptor binding bugs show up without a GPU.
+	// Every rejected parameter is logged and counted in NullCommandStream::mErrorCount
+	void cmdBindDescriptors(Cmd* pCmd, RootSignature* pRootSignature, uint32_t numDescriptors, DescriptorData* pDescParams)
+	{
+		ASSERT(pCmd);
+		ASSERT(pRootSignature);
+
+		NullCommandStream* pStream = pCmd->pNullStream;
+		pCmd->pBoundRootSignature = pRootSignature;
+
+		for (uint32_t i = 0; i < numDescriptors; ++i)
+		{
+			const DescriptorData* pParam = &pDescParams[i];
+			ASSERT(pParam);
+			if (!pParam->pName && pParam->mIndex == (uint32_t)-1)
+			{
+				LOGERRORF("Name and index of Descriptor at index (%u) are both unset", i);
+				++pStream->mErrorCount;
+				return;
+			}
+
+			uint32_t descIndex = -1;
+			const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pParam, &descIndex);
+			if (!pDesc)
+			{
+				++pStream->mErrorCount;
+				continue;
+			}
+			// Name used for error reporting. pParam->pName may be NULL when binding by index
+			const char* pDescName = pDesc->mDesc.name;
+			const void* pRootSignatureObject = pRootSignature;
+
+			// If input param is a root constant no need to do any further checks
+			if (pDesc->mDesc.type == DESCRIPTOR_TYPE_ROOT_CONSTANT)
+			{
+				NullCommand* pCommand = record_command(pCmd, NULL_CMD_BIND_ROOT_CONSTANT, 1, &pRootSignatureObject, pParam->pRootConstant, pDesc->mDesc.size);
+				pCommand->mArgs[0] = descIndex;
+				continue;
+			}
+
+			if (pDesc->mDesc.type == DESCRIPTOR_TYPE_SAMPLER && pDesc->mIndexInParent == (uint32_t)-1)
+			{
+				LOGERRORF("Trying to bind a static sampler (%s). All static samplers must be bound in addRootSignature through RootSignatureDesc::mStaticSamplers", pDescName);
+				++pStream->mErrorCount;
+				continue;
+			}
+
+			if (pParam->mCount > pDesc->mDesc.size)
+			{
+				LOGERRORF("Descriptor (%s) : binding (%u) resources to an array of size (%u)", pDescName, pParam->mCount, pDesc->mDesc.size);
+				++pStream->mErrorCount;
+				continue;
+			}
+
+			// Textures, samplers and buffers share the same pointer array layout so they are recorded the same way
+			const void* const* ppResources = (const void* const*)pParam->ppTextures;
+			if (!ppResources)
+			{
+				LOGERRORF("Descriptor (%s) is NULL", pDescName);
+				++pStream->mErrorCount;
+				return;
+			}
+
+			for (uint32_t arr = 0; arr < pParam->mCount; ++arr)
+			{
+				if (!ppResources[arr])
+				{
+					LOGERRORF("Descriptor (%s) at array index (%u) is NULL", pDescName, arr);
+					++pStream->mErrorCount;
+					return;
+				}
+			}
+
+			NullCommand* pCommand = record_command(pCmd, NULL_CMD_BIND_DESCRIPTOR, 1, &pRootSignatureObject);
+			for (uint32_t arr = 0; arr < pParam->mCount; ++arr)
+				pStream->mObjects.push_back(ppResources[arr]);
+			pCommand->mObjectCount += pParam->mCount;
+			pCommand->mArgs[0] = descIndex;
+			pCommand->mArgs[1] = pDesc->mUpdateFrquency;
+			pCommand->mArgs[2] = pParam->mOffset;
+			pCommand->mArgs[3] = pDesc->mHandleIndex;
+		}
+	}
+
+	void cmdBindIndexBuffer(Cmd* pCmd, Buffer* pBuffer)
+	{
+		ASSERT(pCmd);
+		ASSERT(pBuffer);
+
+		const void* pObject = pBuffer;
+		record_command(pCmd, NULL_CMD_BIND_INDEX_BUFFER, 1, &pObject);
+	}
+
+	void cmdBindVertexBuffer(Cmd* pCmd, uint32_t bufferCount, Buffer** ppBuffers)
+	{
+		ASSERT(pCmd);
+		ASSERT(0 != bufferCount);
+		ASSERT(ppBuffers);
+
+		record_command(pCmd, NULL_CMD_BIND_VERTEX_BUFFER, bufferCount, (const void* const*)ppBuffers);
+	}
+
+	static void record_draw(Cmd* pCmd, NullCommandType type, uint32_t count, uint32_t first, uint32_t instanceCount)
+	{
+		ASSERT(pCmd);
+
+		NullCommand* pCommand = record_command(pCmd, type);
+		pCommand->mArgs[0] = count;
+		pCommand->mArgs[1] = first;
+		pCommand->mArgs[2] = instanceCount;
+	}
+
+	void cmdDraw(Cmd* pCmd, uint32_t vertexCount, uint32_t firstVertex)
+	{
+		record_draw(pCmd, NULL_CMD_DRAW, vertexCount, firstVertex, 1);
+	}
+
+	void cmdDrawInstanced(Cmd* pCmd, uint32_t vertexCount, uint32_t firstVertex, uint32_t instanceCount)
+	{
+		record_draw(pCmd, NULL_CMD_DRAW_INSTANCED, vertexCount, firstVertex, instanceCount);
+	}
+
+	void cmdDrawIndexed(Cmd* pCmd, uint32_t indexCount, uint32_t firstIndex)
+	{
+		record_draw(pCmd, NULL_CMD_DRAW_INDEXED, indexCount, firstIndex, 1);
+	}
+
+	void cmdDrawIndexedInstanced(Cmd* pCmd, uint32_t indexCount, uint32_t firstIndex, uint32_t instanceCount)
+	{
+		record_draw(pCmd, NULL_CMD_DRAW_INDEXED_INSTANCED, indexCount, firstIndex, instanceCount);
+	}
+
+	void cmdDispatch(Cmd* pCmd, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+	{
+		ASSERT(pCmd);
+
+		NullCommand* pCommand = record_command(pCmd, NULL_CMD_DISPATCH);
+		pCommand->mArgs[0] = groupCountX;
+		pCommand->mArgs[1] = groupCountY;
+		pCommand->mArgs[2] = groupCountZ;
+	}
+
+	// Same rule as the Vulkan renderer: only transition when the new state is not already part of the current one
+	void cmdResourceBarrier(Cmd* pCmd, uint32_t numBufferBarriers, BufferBarrier* pBufferBarriers, uint32_t numTextureBarriers, TextureBarrier* pTextureBarriers, bool batch)
+	{
+		ASSERT(pCmd);
+
+		NullCommandStream* pStream = pCmd->pNullStream;
+		const uint32_t objectOffset = (uint32_t)pStream->mObjects.size();
+		tinystl::vector<ResourceState> newStates;
+
+		uint32_t bufferCount = 0;
+		for (uint32_t i = 0; i < numBufferBarriers; ++i)
+		{
+			BufferBarrier* pTrans = &pBufferBarriers[i];
+			Buffer* pBuffer = pTrans->pBuffer;
+			if (!(pTrans->mNewState & pBuffer->mCurrentState))
+			{
+				pStream->mObjects.push_back(pBuffer);
+				newStates.push_back(pTrans->mNewState);
+				pBuffer->mCurrentState = pTrans->mNewState;
+				++bufferCount;
+			}
+		}
+
+		uint32_t textureCount = 0;
+		for (uint32_t i = 0; i < numTextureBarriers; ++i)
+		{
+			TextureBarrier* pTrans = &pTextureBarriers[i];
+			Texture* pTexture = pTrans->pTexture;
+			if (!(pTrans->mNewState & pTexture->mCurrentState))
+			{
+				pStream->mObjects.push_back(pTexture);
+				newStates.push_back(pTrans->mNewState);
+				pTexture->mCurrentState = pTrans->mNewState;
+				++textureCount;
+			}
+		}
+
+		if (!bufferCount && !textureCount)
+			return;
+
+		NullCommand* pCommand = record_command(pCmd, NULL_CMD_RESOURCE_BARRIER, 0, NULL, newStates.data(), (uint32_t)(newStates.size() * sizeof(ResourceState)));
+		pCommand->mObjectOffset = objectOffset;
+		pCommand->mObjectCount = bufferCount + textureCount;
+		pCommand->mArgs[0] = bufferCount;
+		pCommand->mArgs[1] = textureCount;
+		pCommand->mArgs[2] = batch;
+
+		if (batch)
+			pStream->mBatchedBarrierCount += bufferCount + textureCount;
+	}
+
+	void cmdSynchronizeResources(Cmd* pCmd, uint32_t numBuffers, Buffer** ppBuffers, uint32_t numTextures, Texture** ppTextures, bool batch)
+	{
+		ASSERT(pCmd);
+
+		NullCommand* pCommand = record_command(pCmd, NULL_CMD_SYNCHRONIZE_RESOURCES, numBuffers, (const void* const*)ppBuffers);
+		for (uint32_t i = 0; i < numTextures; ++i)
+			pCmd->pNullStream->mObjects.push_back(ppTextures[i]);
+		pCommand->mObjectCount += numTextures;
+		pCommand->mArgs[0] = numBuffers;
+		pCommand->mArgs[1] = numTextures;
+		pCommand->mArgs[2] = batch;
+
+		if (batch)
+			pCmd->pNullStream->mBatchedBarrierCount += numBuffers + numTextures;
+	}
+
+	void cmdFlushBarriers(Cmd* pCmd)
+	{
+		ASSERT(pCmd);
+
+		NullCommandStream* pStream = pCmd->pNullStream;
+		if (pStream->mBatchedBarrierCount)
+		{
+			NullCommand* pCommand = record_command(pCmd, NULL_CMD_FLUSH_BARRIERS);
+			pCommand->mArgs[0] = pStream->mBatchedBarrierCount;
+			pStream->mBatchedBarrierCount = 0;
+		}
+	}
+
+	void cmdUpdateBuffer(Cmd* pCmd, uint64_t srcOffset, uint64_t dstOffset, uint64_t size, Buffer* pSrcBuffer, Buffer* pBuffer)
+	{
+		ASSERT(pCmd);
+		ASSERT(pSrcBuffer);
+		ASSERT(pSrcBuffer->pNullMemory);
+		ASSERT(pBuffer);
+		ASSERT(pBuffer->pNullMemory);
+		ASSERT(srcOffset + size <= pSrcBuffer->mDesc.mSize);
+		ASSERT(dstOffset + size <= pBuffer->mDesc.mSize);
+
+		const void* pObjects[] = { pSrcBuffer, pBuffer };
+		NullCommand* pCommand = record_command(pCmd, NULL_CMD_UPDATE_BUFFER, 2, pObjects);
+		pCommand->mArgs[0] = srcOffset;
+		pCommand->mArgs[1] = dstOffset;
+		pCommand->mArgs[2] = size;
+	}
+
+	void cmdUpdateSubresources(Cmd* pCmd, uint32_t startSubresource, uint32_t numSubresources, SubresourceDataDesc* pSubresources, Buffer* pIntermediate, uint64_t intermediateOffset, Texture* pTexture)
+	{
+		UNREF_PARAM(intermediateOffset);
+		ASSERT(pCmd);
+		ASSERT(pIntermediate);
+		ASSERT(pTexture);
+
+		// SubresourceDataDesc::mBufferOffset is absolute in pIntermediate so intermediateOffset is not needed (same as Vulkan)
+		const void* pObjects[] = { pIntermediate, pTexture };
+		NullCommand* pCommand = record_command(pCmd, NULL_CMD_UPDATE_SUBRESOURCES, 2, pObjects, pSubresources + startSubresource, numSubresources * (uint32_t)sizeof(SubresourceDataDesc));
+		pCommand->mArgs[0] = numSubresources;
+	}
+	// -------------------------------------------------------------------------------------------------
+	// Query functions
+	// -------------------------------------------------------------------------------------------------
+	void getTimestampFrequency(Queue* pQueue, double* pFrequency)
+	{
+		UNREF_PARAM(pQueue);
+		ASSERT(pQueue);
+		ASSERT(pFrequency);
+
+		*pFrequency = NULL_TIMESTAMP_FREQUENCY;
+	}
+
+	void addQueryHeap(Renderer* pRenderer, const QueryHeapDesc* pDesc, QueryHeap** ppQueryHeap)
+	{
+		UNREF_PARAM(pRenderer);
+		QueryHeap* pQueryHeap = (QueryHeap*)conf_calloc(1, sizeof(*pQueryHeap));
+		pQueryHeap->mDesc = *pDesc;
+		pQueryHeap->pNullQueryData = (uint64_t*)conf_calloc(pDesc->mQueryCount, sizeof(uint64_t));
+
+		*ppQueryHeap = pQueryHeap;
+	}
+
+	void removeQueryHeap(Renderer* pRenderer, QueryHeap* pQueryHeap)
+	{
+		UNREF_PARAM(pRenderer);
+		SAFE_FREE(pQueryHeap->pNullQueryData);
+		SAFE_FREE(pQueryHeap);
+	}
+
+	void cmdBeginQuery(Cmd* pCmd, QueryHeap* pQueryHeap, QueryDesc* pQuery)
+	{
+		ASSERT(pQuery->mIndex < pQueryHeap->mDesc.mQueryCount);
+
+		const void* pObject = pQueryHeap;
+		NullCommand* pCommand = record_command(pCmd, NULL_CMD_BEGIN_QUERY, 1, &pObject);
+		pCommand->mArgs[0] = pQuery->mIndex;
+	}
+
+	void cmdEndQuery(Cmd* pCmd, QueryHeap* pQueryHeap, QueryDesc* pQuery)
+	{
+		ASSERT(pQuery->mIndex < pQueryHeap->mDesc.mQueryCount);
+
+		const void* pObject = pQueryHeap;
+		NullCommand* pCommand = record_command(pCmd, NULL_CMD_END_QUERY, 1, &pObject);
+		pCommand->mArgs[0] = pQuery->mIndex;
+	}
+
+	void cmdResolveQuery(Cmd* pCmd, QueryHeap* pQueryHeap, Buffer* pReadbackBuffer, uint32_t startQuery, uint32_t queryCount)
+	{
+		ASSERT(startQuery + queryCount <= pQueryHeap->mDesc.mQueryCount);
+
+		const void* pObjects[] = { pQueryHeap, pReadbackBuffer };
+		NullCommand* pCommand = record_command(pCmd, NULL_CMD_RESOLVE_QUERY, 2, pObjects);
+		pCommand->mArgs[0] = startQuery;
+		pCommand->mArgs[1] = queryCount;
+	}
+	// -------------------------------------------------------------------------------------------------
+	// Queue / fence / swapchain functions
+	// -------------------------------------------------------------------------------------------------
+	void acquireNextImage(Renderer* pRenderer, SwapChain* pSwapChain, Semaphore* pSignalSemaphore, Fence* pFence, uint32_t* pImageIndex)
+	{
+		UNREF_PARAM(pRenderer);
+		ASSERT(pRenderer);
+		ASSERT(pSwapChain);
+		ASSERT(pSignalSemaphore || pFence);
+
+		pSwapChain->mImageIndex = (pSwapChain->mImageIndex + 1) % pSwapChain->mDesc.mImageCount;
+		*pImageIndex = pSwapChain->mImageIndex;
+
+		if (pSignalSemaphore)
+			pSignalSemaphore->mSignaled = true;
+		if (pFence)
+			pFence->mSubmitted = true;
+	}
+
+	// Submission is synchronous: recorded copies and queries are executed before returning
+	void queueSubmit(Queue* pQueue, uint32_t cmdCount, Cmd** ppCmds, Fence* pFence, uint32_t waitSemaphoreCount, Semaphore** ppWaitSemaphores, uint32_t signalSemaphoreCount, Semaphore** ppSignalSemaphores)
+	{
+		ASSERT(pQueue);
+		ASSERT(cmdCount > 0);
+		ASSERT(ppCmds);
+
+		for (uint32_t i = 0; i < waitSemaphoreCount; ++i)
+		{
+			if (ppWaitSemaphores[i]->mSignaled)
+				ppWaitSemaphores[i]->mSignaled = false;
+		}
+
+		uint64_t executedCommandCount = 0;
+		for (uint32_t i = 0; i < cmdCount; ++i)
+		{
+			execute_command_stream(ppCmds[i]->pNullStream);
+			executedCommandCount += ppCmds[i]->pNullStream->mCommands.size();
+		}
+
+		for (uint32_t i = 0; i < signalSemaphoreCount; ++i)
+		{
+			if (!ppSignalSemaphores[i]->mSignaled)
+				ppSignalSemaphores[i]->mSignaled = true;
+		}
+
+		if (pFence)
+			pFence->mSubmitted = true;
+
+		++pQueue->mNullSubmitCount;
+
+		NullDeviceStats* pStats = pQueue->pRenderer->pNullStats;
+		MutexLock lock(pStats->mMutex);
+		pStats->mExecutedCommandCount += executedCommandCount;
+	}
+
+	void queuePresent(Queue* pQueue, SwapChain* pSwapChain, uint32_t swapChainImageIndex, uint32_t waitSemaphoreCount, Semaphore** ppWaitSemaphores)
+	{
+		UNREF_PARAM(pQueue);
+		UNREF_PARAM(swapChainImageIndex);
+		ASSERT(pQueue);
+		ASSERT(pSwapChain);
+		ASSERT(swapChainImageIndex < pSwapChain->mDesc.mImageCount);
+
+		for (uint32_t i = 0; i < waitSemaphoreCount; ++i)
+		{
+			if (ppWaitSemaphores[i]->mSignaled)
+				ppWaitSemaphores[i]->mSignaled = false;
+		}
+
+		++pSwapChain->mPresentCount;
+	}
+
+	void waitForFences(Queue* pQueue, uint32_t fenceCount, Fence** ppFences)
+	{
+		UNREF_PARAM(pQueue);
+		ASSERT(pQueue);
+		ASSERT(fenceCount);
+		ASSERT(ppFences);
+
+		// Work is complete as soon as queueSubmit returns
+		for (uint32_t i = 0; i < fenceCount; ++i)
+			ppFences[i]->mSubmitted = false;
+	}
+
+	void getFenceStatus(Fence* pFence, FenceStatus* pFenceStatus)
+	{
+		ASSERT(pFence);
+		ASSERT(pFenceStatus);
+
+		pFence->mSubmitted = false;
+		*pFenceStatus = FENCE_STATUS_COMPLETE;
+	}
+
+	void getRawTextureHandle(Renderer* pRenderer, Texture* pTexture, void** ppHandle)
+	{
+		UNREF_PARAM(pRenderer);
+		ASSERT(pRenderer);
+		ASSERT(pTexture);
+		ASSERT(ppHandle);
+
+		*ppHandle = pTexture->pNullMemory;
+	}
+	// -------------------------------------------------------------------------------------------------
+	// Utility functions
+	// -------------------------------------------------------------------------------------------------
+	bool isImageFormatSupported(ImageFormat::Enum format)
+	{
+		bool result = false;
+		switch (format) {
+			// 1 channel
+		case ImageFormat::R8: result = true; break;
+		case ImageFormat::R16: result = true; break;
+		case ImageFormat::R16F: result = true; break;
+		case ImageFormat::R32UI: result = true; break;
+		case ImageFormat::R32F: result = true; break;
+			// 2 channel
+		case ImageFormat::RG8: result = true; break;
+		case ImageFormat::RG16: result = true; break;
+		case ImageFormat::RG16F: result = true; break;
+		case ImageFormat::RG32UI: result = true; break;
+		case ImageFormat::RG32F: result = true; break;
+			// 3 channel
+		case ImageFormat::RGB8: result = true; break;
+		case ImageFormat::RGB16: result = true; break;
+		case ImageFormat::RGB16F: result = true; break;
+		case ImageFormat::RGB32UI: result = true; break;
+		case ImageFormat::RGB32F: result = true; break;
+			// 4 channel
+		case ImageFormat::BGRA8: result = true; break;
+		case ImageFormat::RGBA16: result = true; break;
+		case ImageFormat::RGBA16F: result = true; break;
+		case ImageFormat::RGBA32UI: result = true; break;
+		case ImageFormat::RGBA32F: result = true; break;
+		default: break;
+		}
+		return result;
+	}
+
+	uint32_t calculateVertexLayoutStride(const VertexLayout* pVertexLayout)
+	{
+		ASSERT(pVertexLayout);
+
+		uint32_t result = 0;
+		for (uint32_t i = 0; i < pVertexLayout->mAttribCount; ++i) {
+			result += calculateImageFormatStride(pVertexLayout->mAttribs[i].mFormat);
+		}
+		return result;
+	}
+	/************************************************************************/
+	// Execute Indirect Implementation
+	/************************************************************************/
+	void addIndirectCommandSignature(Renderer* pRenderer, const CommandSignatureDesc* pDesc, CommandSignature** ppCommandSignature)
+	{
+		UNREF_PARAM(pRenderer);
+		CommandSignature* pCommandSignature = (CommandSignature*)conf_calloc(1, sizeof(CommandSignature));
+		pCommandSignature->mDesc = *pDesc;
+		pCommandSignature->mIndirectArgDescCounts = pDesc->mIndirectArgCount;
+		pCommandSignature->mDrawCommandStride = 0;
+
+		for (uint32_t i = 0; i < pDesc->mIndirectArgCount; ++i)
+		{
+			switch (pDesc->pArgDescs[i].mType)
+			{
+			case INDIRECT_DRAW:
+				pCommandSignature->mDrawType = INDIRECT_DRAW;
+				pCommandSignature->mDrawCommandStride += sizeof(IndirectDrawArguments);
+				break;
+			case INDIRECT_DRAW_INDEX:
+				pCommandSignature->mDrawType = INDIRECT_DRAW_INDEX;
+				pCommandSignature->mDrawCommandStride += sizeof(IndirectDrawIndexArguments);
+				break;
+			case INDIRECT_DISPATCH:
+				pCommandSignature->mDrawType = INDIRECT_DISPATCH;
+				pCommandSignature->mDrawCommandStride += sizeof(IndirectDispatchArguments);
+				break;
+			default:
+				LOGERROR("Null renderer only supports IndirectDraw, IndirectDrawIndex and IndirectDispatch");
+				break;
+			}
+		}
+
+		pCommandSignature->mDrawCommandStride = round_up(pCommandSignature->mDrawCommandStride, 16);
+
+		*ppCommandSignature = pCommandSignature;
+	}
+
+	void removeIndirectCommandSignature(Renderer* pRenderer, CommandSignature* pCommandSignature)
+	{
+		UNREF_PARAM(pRenderer);
+		SAFE_FREE(pCommandSignature);
+	}
+
+	void cmdExecuteIndirect(Cmd* pCmd, CommandSignature* pCommandSignature, uint maxCommandCount, Buffer* pIndirectBuffer, uint64_t bufferOffset, Buffer* pCounterBuffer, uint64_t counterBufferOffset)
+	{
+		ASSERT(pCmd);
+		ASSERT(pCommandSignature);
+		ASSERT(pIndirectBuffer);
+
+		const void* pObjects[] = { pCommandSignature, pIndirectBuffer, pCounterBuffer };
+		NullCommand* pCommand = record_command(pCmd, NULL_CMD_EXECUTE_INDIRECT, 3, pObjects);
+		pCommand->mArgs[0] = maxCommandCount;
+		pCommand->mArgs[1] = bufferOffset;
+		pCommand->mArgs[2] = counterBufferOffset;
+		pCommand->mArgs[3] = pCommandSignature->mDrawCommandStride;
+	}
+	/************************************************************************/
+	// Memory Stats Implementation
+	/************************************************************************/
+	void calculateMemoryStats(Renderer* pRenderer, char** stats)
+	{
+		NullDeviceStats* pStats = pRenderer->pNullStats;
+		MutexLock lock(pStats->mMutex);
+
+		char buffer[256];
+		int length = snprintf(buffer, sizeof(buffer), "Null device\n  Buffers: %u (%llu bytes)\n  Textures: %u (%llu bytes)\n",
+			pStats->mBufferCount, (unsigned long long)pStats->mBufferMemory, pStats->mTextureCount, (unsigned long long)pStats->mTextureMemory);
+
+		*stats = (char*)conf_malloc(length + 1);
+		memcpy(*stats, buffer, length + 1);
+	}
+
+	void freeMemoryStats(Renderer* pRenderer, char* stats)
+	{
+		UNREF_PARAM(pRenderer);
+		SAFE_FREE(stats);
+	}
+	/************************************************************************/
+	// Debug Marker Implementation
+	/************************************************************************/
+	void cmdBeginDebugMarker(Cmd* pCmd, float r, float g, float b, const char* pName)
+	{
+		record_debug_marker(pCmd, NULL_CMD_BEGIN_DEBUG_MARKER, r, g, b, pName);
+	}
+
+	void cmdBeginDebugMarkerf(Cmd* pCmd, float r, float g, float b, const char* pFormat, ...)
+	{
+		va_list argptr;
+		va_start(argptr, pFormat);
+		char buffer[65536];
+		vsnprintf(buffer, sizeof(buffer), pFormat, argptr);
+		va_end(argptr);
+		cmdBeginDebugMarker(pCmd, r, g, b, buffer);
+	}
+
+	void cmdEndDebugMarker(Cmd* pCmd)
+	{
+		record_debug_marker(pCmd, NULL_CMD_END_DEBUG_MARKER, 0.0f, 0.0f, 0.0f, NULL);
+	}
+
+	void cmdAddDebugMarker(Cmd* pCmd, float r, float g, float b, const char* pName)
+	{
+		record_debug_marker(pCmd, NULL_CMD_ADD_DEBUG_MARKER, r, g, b, pName);
+	}
+
+	void cmdAddDebugMarkerf(Cmd* pCmd, float r, float g, float b, const char* pFormat, ...)
+	{
+		va_list argptr;
+		va_start(argptr, pFormat);
+		char buffer[65536];
+		vsnprintf(buffer, sizeof(buffer), pFormat, argptr);
+		va_end(argptr);
+		cmdAddDebugMarker(pCmd, r, g, b, buffer);
+	}
+#endif // RENDERER_IMPLEMENTATION
+
+#if defined(__cplusplus) && defined(RENDERER_CPP_NAMESPACE)
+} // namespace RENDERER_CPP_NAMESPACE
+#endif
+
+#endif
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+// Null renderer backend
+// Buffers and textures live in system memory and every cmd* call is recorded into a NullCommandStream
+// owned by the Cmd. Nothing is rasterized: copies and queries are executed in queueSubmit, everything
+// else is only recorded so tests can inspect the stream after submission.
+
+typedef enum NullCommandType
+{
+	NULL_CMD_BEGIN_RENDER = 0,
+	NULL_CMD_END_RENDER,
+	NULL_CMD_SET_VIEWPORT,
+	NULL_CMD_SET_SCISSOR,
+	NULL_CMD_BIND_PIPELINE,
+	NULL_CMD_BIND_DESCRIPTOR,
+	NULL_CMD_BIND_ROOT_CONSTANT,
+	NULL_CMD_BIND_INDEX_BUFFER,
+	NULL_CMD_BIND_VERTEX_BUFFER,
+	NULL_CMD_DRAW,
+	NULL_CMD_DRAW_INSTANCED,
+	NULL_CMD_DRAW_INDEXED,
+	NULL_CMD_DRAW_INDEXED_INSTANCED,
+	NULL_CMD_DISPATCH,
+	NULL_CMD_EXECUTE_INDIRECT,
+	NULL_CMD_RESOURCE_BARRIER,
+	NULL_CMD_SYNCHRONIZE_RESOURCES,
+	NULL_CMD_FLUSH_BARRIERS,
+	NULL_CMD_UPDATE_BUFFER,
+	NULL_CMD_UPDATE_SUBRESOURCES,
+	NULL_CMD_BEGIN_QUERY,
+	NULL_CMD_END_QUERY,
+	NULL_CMD_RESOLVE_QUERY,
+	NULL_CMD_BEGIN_DEBUG_MARKER,
+	NULL_CMD_END_DEBUG_MARKER,
+	NULL_CMD_ADD_DEBUG_MARKER,
+	NULL_CMD_COUNT,
+} NullCommandType;
+
+/// One recorded command. Objects and payload bytes are stored out of line in the owning NullCommandStream
+///
+/// NULL_CMD_BEGIN_RENDER			objects: render target textures then the depth texture, args: { render target count, has depth }, data: LoadActionsDesc (if given)
+/// NULL_CMD_END_RENDER				args: { render target count, has depth }
+/// NULL_CMD_SET_VIEWPORT			floats: { x, y, width, height, min depth, max depth }
+/// NULL_CMD_SET_SCISSOR			args: { x, y, width, height }
+/// NULL_CMD_BIND_PIPELINE			objects: pipeline
+/// NULL_CMD_BIND_DESCRIPTOR		objects: root signature then the bound textures / buffers / samplers, args: { descriptor index, update frequency, offset, handle index }
+/// NULL_CMD_BIND_ROOT_CONSTANT		objects: root signature, args: { descriptor index }, data: constant bytes
+/// NULL_CMD_BIND_INDEX_BUFFER		objects: buffer
+/// NULL_CMD_BIND_VERTEX_BUFFER		objects: buffers
+/// NULL_CMD_DRAW*					args: { vertex / index count, first vertex / index, instance count }
+/// NULL_CMD_DISPATCH				args: { group count x, y, z }
+/// NULL_CMD_EXECUTE_INDIRECT		objects: signature, indirect buffer, counter buffer (may be NULL), args: { max command count, buffer offset, counter offset, stride }
+/// NULL_CMD_RESOURCE_BARRIER		objects: transitioned buffers then textures, args: { buffer count, texture count, batch }, data: new states
+/// NULL_CMD_FLUSH_BARRIERS			args: { number of batched barriers flushed }
+/// NULL_CMD_SYNCHRONIZE_RESOURCES	objects: buffers then textures, args: { buffer count, texture count, batch }
+/// NULL_CMD_UPDATE_BUFFER			objects: source, destination, args: { source offset, destination offset, size }
+/// NULL_CMD_UPDATE_SUBRESOURCES	objects: intermediate buffer, texture, args: { subresource count }, data: SubresourceDataDesc array
+/// NULL_CMD_*_QUERY				objects: query heap, args: { index } or { start, count } and readback buffer as second object for resolve
+/// NULL_CMD_*_DEBUG_MARKER			floats: { r, g, b }, data: zero terminated name
+typedef struct NullCommand
+{
+	NullCommandType		mType;
+	uint32_t			mObjectOffset;
+	uint32_t			mObjectCount;
+	uint32_t			mDataOffset;
+	uint32_t			mDataSize;
+	uint64_t			mArgs[4];
+	float				mFloatArgs[6];
+} NullCommand;
+
+typedef struct NullCommandStream
+{
+	tinystl::vector<NullCommand>	mCommands;
+	tinystl::vector<const void*>	mObjects;
+	tinystl::vector<uint8_t>		mData;
+	/// Number of invalid calls rejected while recording (unknown descriptors, NULL resources,...)
+	uint32_t						mErrorCount;
+	/// Barriers recorded with batch = true since the last NULL_CMD_FLUSH_BARRIERS
+	uint32_t						mBatchedBarrierCount;
+} NullCommandStream;
+
+typedef struct NullDeviceStats
+{
+	Mutex		mMutex;
+	uint32_t	mBufferCount;
+	uint32_t	mTextureCount;
+	uint64_t	mBufferMemory;
+	uint64_t	mTextureMemory;
+	uint64_t	mExecutedCommandCount;
+} NullDeviceStats;
+
+/// Byte offset of a subresource in Texture::pNullMemory. Mips are stored one after the other, each holding all array layers (cube faces count as layers)
+uint64_t getNullSubresourceOffset(const Texture* pTexture, uint32_t mipLevel, uint32_t arrayLayer);
+/// Byte size of one array layer of the given mip level
+uint64_t getNullSubresourceSize(const Texture* pTexture, uint32_t mipLevel);
+const char* getNullCommandName(NullCommandType type);
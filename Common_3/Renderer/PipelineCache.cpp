@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "PipelineCache.h"
+#include "../OS/Core/ContentHash.h"
+#include "../OS/Interfaces/IFileSystem.h"
+#include "../OS/Interfaces/ILogManager.h"
+#include "../OS/Interfaces/IMemoryManager.h"
+
+/************************************************************************/
+// Pipeline desc hashing
+/************************************************************************/
+template <typename T>
+static inline void HashValue(ContentHasher& hasher, const T& value)
+{
+	hasher.Update(&value, sizeof(value));
+}
+
+static int CompareHashes(const void* pLhs, const void* pRhs)
+{
+	uint64_t a = *(const uint64_t*)pLhs;
+	uint64_t b = *(const uint64_t*)pRhs;
+	return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+// Order independent combination: element hashes are sorted before they are hashed together
+static void HashSorted(ContentHasher& hasher, tinystl::vector<uint64_t>& hashes)
+{
+	if (hashes.size() > 1)
+		qsort(hashes.data(), hashes.size(), sizeof(uint64_t), CompareHashes);
+	HashValue(hasher, (uint32_t)hashes.size());
+	if (hashes.size())
+		hasher.Update(hashes.data(), hashes.size() * sizeof(uint64_t));
+}
+
+// Fixed function states are plain values without pointers, so hashing their bytes is stable
+template <typename T>
+static void HashState(ContentHasher& hasher, const T* pState)
+{
+	HashValue(hasher, (uint32_t)(pState != NULL));
+	if (pState)
+		hasher.Update(pState, sizeof(T));
+}
+
+static void HashRenderTarget(ContentHasher& hasher, const RenderTarget* pRenderTarget)
+{
+	HashValue(hasher, (uint32_t)(pRenderTarget != NULL));
+	if (!pRenderTarget)
+		return;
+
+	HashValue(hasher, (uint32_t)pRenderTarget->mDesc.mFormat);
+	HashValue(hasher, (uint32_t)pRenderTarget->mDesc.mSampleCount);
+	HashValue(hasher, pRenderTarget->mDesc.mSampleQuality);
+	HashValue(hasher, (uint32_t)pRenderTarget->mDesc.mSrgb);
+}
+
+static uint64_t HashShader(const Shader* pShader)
+{
+	// Backends that do not hash their byte code fall back to identity, which is still correct within one run
+	return pShader->mContentHash ? pShader->mContentHash : (uint64_t)(uintptr_t)pShader;
+}
+
+uint64_t hashShaderStage(ShaderStage stage, const void* pCode, uint32_t codeSize, const char* pEntryPoint, uint64_t seed)
+{
+	ContentHasher hasher(seed);
+	HashValue(hasher, (uint32_t)stage);
+	HashValue(hasher, codeSize);
+	hasher.Update(pCode, codeSize);
+	if (pEntryPoint)
+		hasher.Update(pEntryPoint, strlen(pEntryPoint));
+	return hasher.Digest64();
+}
+
+uint64_t hashRootSignatureLayout(const RootSignature* pRootSignature)
+{
+	ASSERT(pRootSignature);
+
+	tinystl::vector<uint64_t> descriptorHashes(pRootSignature->mDescriptorCount);
+	for (uint32_t i = 0; i < pRootSignature->mDescriptorCount; ++i)
+	{
+		const DescriptorInfo* pDescriptor = &pRootSignature->pDescriptors[i];
+		ContentHasher hasher;
+		HashValue(hasher, (uint32_t)pDescriptor->mDesc.type);
+		HashValue(hasher, pDescriptor->mDesc.set);
+		HashValue(hasher, pDescriptor->mDesc.reg);
+		HashValue(hasher, pDescriptor->mDesc.size);
+		HashValue(hasher, (uint32_t)pDescriptor->mDesc.used_stages);
+		HashValue(hasher, (uint32_t)pDescriptor->mUpdateFrquency);
+		if (pDescriptor->mDesc.name)
+			hasher.Update(pDescriptor->mDesc.name, pDescriptor->mDesc.name_size);
+		descriptorHashes[i] = hasher.Digest64();
+	}
+
+	ContentHasher hasher;
+	HashValue(hasher, (uint32_t)pRootSignature->mPipelineType);
+	HashValue(hasher, pRootSignature->mRootConstantCount);
+	HashSorted(hasher, descriptorHashes);
+	return hasher.Digest64();
+}
+
+uint64_t hashVertexLayout(const VertexLayout* pVertexLayout)
+{
+	if (!pVertexLayout)
+		return 0;
+
+	uint32_t attribCount = min(pVertexLayout->mAttribCount, (uint32_t)MAX_VERTEX_ATTRIBS);
+	tinystl::vector<uint64_t> attribHashes(attribCount);
+	for (uint32_t i = 0; i < attribCount; ++i)
+	{
+		const VertexAttrib* pAttrib = &pVertexLayout->mAttribs[i];
+		ContentHasher hasher;
+		HashValue(hasher, (uint32_t)pAttrib->mSemantic);
+		HashValue(hasher, (uint32_t)pAttrib->mFormat);
+		HashValue(hasher, pAttrib->mBinding);
+		HashValue(hasher, pAttrib->mLocation);
+		HashValue(hasher, pAttrib->mOffset);
+		hasher.Update(pAttrib->mSemanticName, min(pAttrib->mSemanticNameLength, (uint32_t)MAX_SEMANTIC_NAME_LENGTH));
+		attribHashes[i] = hasher.Digest64();
+	}
+
+	ContentHasher hasher;
+	HashSorted(hasher, attribHashes);
+	return hasher.Digest64();
+}
+
+uint64_t hashGraphicsPipelineDesc(const Renderer* pRenderer, const GraphicsPipelineDesc* pDesc)
+{
+	ASSERT(pDesc);
+	ASSERT(pDesc->pShaderProgram);
+	ASSERT(pDesc->pRootSignature);
+
+	const BlendState* pBlendState = pDesc->pBlendState ? pDesc->pBlendState : (pRenderer ? pRenderer->pDefaultBlendState : NULL);
+	const DepthState* pDepthState = pDesc->pDepthState ? pDesc->pDepthState : (pRenderer ? pRenderer->pDefaultDepthState : NULL);
+	const RasterizerState* pRasterizerState = pDesc->pRasterizerState ? pDesc->pRasterizerState : (pRenderer ? pRenderer->pDefaultRasterizerState : NULL);
+
+	ContentHasher hasher;
+	HashValue(hasher, (uint32_t)PIPELINE_TYPE_GRAPHICS);
+	HashValue(hasher, HashShader(pDesc->pShaderProgram));
+	HashValue(hasher, hashRootSignatureLayout(pDesc->pRootSignature));
+	HashValue(hasher, hashVertexLayout(pDesc->pVertexLayout));
+	HashValue(hasher, (uint32_t)pDesc->mPrimitiveTopo);
+	// Attachment order is part of the pipeline interface, so render targets are hashed in order
+	HashValue(hasher, pDesc->mRenderTargetCount);
+	for (uint32_t i = 0; i < pDesc->mRenderTargetCount; ++i)
+		HashRenderTarget(hasher, pDesc->ppRenderTargets[i]);
+	HashRenderTarget(hasher, pDesc->pDepthStencil);
+	HashState(hasher, pBlendState);
+	HashState(hasher, pDepthState);
+	HashState(hasher, pRasterizerState);
+	return hasher.Digest64();
+}
+
+uint64_t hashComputePipelineDesc(const ComputePipelineDesc* pDesc)
+{
+	ASSERT(pDesc);
+	ASSERT(pDesc->pShaderProgram);
+	ASSERT(pDesc->pRootSignature);
+
+	ContentHasher hasher;
+	HashValue(hasher, (uint32_t)PIPELINE_TYPE_COMPUTE);
+	HashValue(hasher, HashShader(pDesc->pShaderProgram));
+	HashValue(hasher, hashRootSignatureLayout(pDesc->pRootSignature));
+	return hasher.Digest64();
+}
+
+/************************************************************************/
+// Pipeline cache blob
+/************************************************************************/
+uint64_t getPipelineCacheBlobSize(uint64_t dataSize)
+{
+	return sizeof(PipelineCacheHeader) + dataSize;
+}
+
+void writePipelineCacheBlob(const PipelineCacheDeviceInfo* pDevice, const void* pData, uint64_t dataSize, void* pBlob)
+{
+	ASSERT(pDevice);
+	ASSERT(pBlob);
+	ASSERT(pData || !dataSize);
+
+	PipelineCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	header.mMagic = PIPELINE_CACHE_MAGIC;
+	header.mVersion = PIPELINE_CACHE_VERSION;
+	header.mHeaderSize = sizeof(PipelineCacheHeader);
+	header.mDataChecksum = Crc32c(pData, (size_t)dataSize);
+	header.mDataSize = dataSize;
+	header.mDevice = *pDevice;
+
+	memcpy(pBlob, &header, sizeof(header));
+	if (dataSize)
+		memcpy((uint8_t*)pBlob + sizeof(header), pData, (size_t)dataSize);
+}
+
+bool readPipelineCacheBlob(const PipelineCacheDeviceInfo* pDevice, const void* pBlob, uint64_t blobSize, const void** ppData, uint64_t* pDataSize)
+{
+	ASSERT(pDevice);
+	ASSERT(ppData);
+	ASSERT(pDataSize);
+
+	*ppData = NULL;
+	*pDataSize = 0;
+
+	if (!pBlob || blobSize < sizeof(PipelineCacheHeader))
+		return false;
+
+	PipelineCacheHeader header;
+	memcpy(&header, pBlob, sizeof(header));
+	if (header.mMagic != PIPELINE_CACHE_MAGIC)
+		return false;
+	if (header.mVersion != PIPELINE_CACHE_VERSION || header.mHeaderSize != sizeof(PipelineCacheHeader))
+	{
+		LOGINFOF("Discarding pipeline cache of version %u, expected %u", header.mVersion, PIPELINE_CACHE_VERSION);
+		return false;
+	}
+	// The driver data is only valid for the exact device and driver it came from
+	if (header.mDevice.mVendorId != pDevice->mVendorId || header.mDevice.mDeviceId != pDevice->mDeviceId ||
+		header.mDevice.mDriverVersion != pDevice->mDriverVersion ||
+		memcmp(header.mDevice.mCacheUUID, pDevice->mCacheUUID, PIPELINE_CACHE_UUID_SIZE) != 0)
+	{
+		LOGINFO("Discarding pipeline cache created by a different device or driver");
+		return false;
+	}
+	if (header.mDataSize > blobSize - sizeof(PipelineCacheHeader))
+	{
+		LOGWARNINGF("Pipeline cache is truncated (%llu of %llu bytes)", (unsigned long long)(blobSize - sizeof(PipelineCacheHeader)), (unsigned long long)header.mDataSize);
+		return false;
+	}
+
+	const void* pData = (const uint8_t*)pBlob + sizeof(PipelineCacheHeader);
+	// Drivers do not necessarily survive corrupt cache data, so it is never passed on unchecked
+	if (Crc32c(pData, (size_t)header.mDataSize) != header.mDataChecksum)
+	{
+		LOGWARNING("Pipeline cache checksum mismatch");
+		return false;
+	}
+
+	*ppData = pData;
+	*pDataSize = header.mDataSize;
+	return true;
+}
+
+bool loadPipelineCacheFile(const char* fileName, FSRoot root, const PipelineCacheDeviceInfo* pDevice, tinystl::vector<uint8_t>* pOutData)
+{
+	ASSERT(fileName);
+	ASSERT(pOutData);
+	pOutData->clear();
+
+	if (!FileSystem::FileExists(fileName, root))
+		return false;
+
+	File file;
+	if (!file.Open(fileName, FM_ReadBinary, root))
+		return false;
+
+	tinystl::vector<uint8_t> blob(file.GetSize());
+	unsigned bytesRead = blob.size() ? file.Read(blob.data(), (unsigned)blob.size()) : 0;
+	file.Close();
+
+	const void* pData = NULL;
+	uint64_t dataSize = 0;
+	if (!readPipelineCacheBlob(pDevice, blob.data(), bytesRead, &pData, &dataSize))
+		return false;
+
+	pOutData->resize((size_t)dataSize);
+	if (dataSize)
+		memcpy(pOutData->data(), pData, (size_t)dataSize);
+	return true;
+}
+
+bool savePipelineCacheFile(const char* fileName, FSRoot root, const PipelineCacheDeviceInfo* pDevice, const void* pData, uint64_t dataSize)
+{
+	ASSERT(fileName);
+
+	tinystl::vector<uint8_t> blob((size_t)getPipelineCacheBlobSize(dataSize));
+	writePipelineCacheBlob(pDevice, pData, dataSize, blob.data());
+
+	File file;
+	if (!file.Open(fileName, FM_WriteBinary, root))
+	{
+		LOGERRORF("Could not write pipeline cache %s", fileName);
+		return false;
+	}
+	unsigned written = file.Write(blob.data(), (unsigned)blob.size());
+	file.Close();
+	return written == blob.size();
+}
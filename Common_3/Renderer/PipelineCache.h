@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "IRenderer.h"
+#include "../ThirdParty/OpenSource/TinySTL/vector.h"
+
+/************************************************************************/
+// Pipeline desc hashing
+/************************************************************************/
+/// Referenced objects are hashed by content instead of by address, so the hash of a desc is stable across runs:
+/// shaders by Shader::mContentHash, root signatures by their descriptor layout, render targets by format and
+/// sample count, fixed function states by value. Vertex attributes and root signature descriptors are sorted
+/// before hashing so declaration order does not matter.
+/// NULL fixed function states hash like the renderer defaults (pRenderer may be NULL when there is no device).
+uint64_t hashGraphicsPipelineDesc(const Renderer* pRenderer, const GraphicsPipelineDesc* pDesc);
+uint64_t hashComputePipelineDesc(const ComputePipelineDesc* pDesc);
+uint64_t hashRootSignatureLayout(const RootSignature* pRootSignature);
+uint64_t hashVertexLayout(const VertexLayout* pVertexLayout);
+/// Hash of one shader stage, accumulate stages with the previous result as seed
+uint64_t hashShaderStage(ShaderStage stage, const void* pCode, uint32_t codeSize, const char* pEntryPoint, uint64_t seed);
+
+/************************************************************************/
+// Pipeline cache blob
+/************************************************************************/
+#define PIPELINE_CACHE_FILE_NAME "PipelineCache.bin"
+#define PIPELINE_CACHE_MAGIC 0x43505346 // 'FSPC'
+/// Bump when the header layout changes
+#define PIPELINE_CACHE_VERSION 1
+#define PIPELINE_CACHE_UUID_SIZE 16
+
+/// Identifies the device and driver that produced the driver cache data. Data from any other device is discarded
+typedef struct PipelineCacheDeviceInfo
+{
+	uint32_t	mVendorId;
+	uint32_t	mDeviceId;
+	uint32_t	mDriverVersion;
+	uint8_t		mCacheUUID[PIPELINE_CACHE_UUID_SIZE];
+} PipelineCacheDeviceInfo;
+
+typedef struct PipelineCacheHeader
+{
+	uint32_t				mMagic;
+	uint32_t				mVersion;
+	uint32_t				mHeaderSize;
+	uint32_t				mDataChecksum;
+	uint64_t				mDataSize;
+	PipelineCacheDeviceInfo	mDevice;
+} PipelineCacheHeader;
+
+/// Size of the blob storing dataSize bytes of driver cache data
+uint64_t getPipelineCacheBlobSize(uint64_t dataSize);
+/// Writes header and data to pBlob which must hold getPipelineCacheBlobSize(dataSize) bytes
+void writePipelineCacheBlob(const PipelineCacheDeviceInfo* pDevice, const void* pData, uint64_t dataSize, void* pBlob);
+/// Validates magic, version, device, size and checksum. On success ppData points at the driver data inside pBlob
+bool readPipelineCacheBlob(const PipelineCacheDeviceInfo* pDevice, const void* pBlob, uint64_t blobSize, const void** ppData, uint64_t* pDataSize);
+
+/// Loads the driver data of a cache file. Returns false and leaves pOutData empty if the file is missing or invalid
+bool loadPipelineCacheFile(const char* fileName, FSRoot root, const PipelineCacheDeviceInfo* pDevice, tinystl::vector<uint8_t>* pOutData);
+bool savePipelineCacheFile(const char* fileName, FSRoot root, const PipelineCacheDeviceInfo* pDevice, const void* pData, uint64_t dataSize);
@@ -0,0 +1,703 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "RenderGraph.h"
+#include "../OS/Interfaces/ILogManager.h"
+#include "../OS/Interfaces/IMemoryManager.h"
+
+/************************************************************************/
+// Resource state helpers
+/************************************************************************/
+static const ResourceState gWriteStates = RESOURCE_STATE_RENDER_TARGET | RESOURCE_STATE_UNORDERED_ACCESS |
+	RESOURCE_STATE_DEPTH_WRITE | RESOURCE_STATE_STREAM_OUT | RESOURCE_STATE_COPY_DEST;
+/// Read states that can be combined into one state without changing how the resource is accessed. Textures only
+/// combine states sharing an image layout on Vulkan, buffers have no layout and combine any read state
+static const ResourceState gTextureMergeableReadStates = RESOURCE_STATE_SHADER_RESOURCE | RESOURCE_STATE_DEPTH_READ;
+static const ResourceState gBufferMergeableReadStates = RESOURCE_STATE_GENERIC_READ;
+
+static inline bool is_read_state(ResourceState state)
+{
+	return !(state & gWriteStates);
+}
+
+/// True if a resource in state current can be accessed in state without a transition
+static inline bool covers_state(ResourceState current, ResourceState state)
+{
+	return (current & state) == state;
+}
+
+static inline ResourceState get_mergeable_read_states(const RenderGraphResource* pResource)
+{
+	return pResource->mType == RENDER_GRAPH_RESOURCE_BUFFER ? gBufferMergeableReadStates : gTextureMergeableReadStates;
+}
+
+/// Combined state of all accesses of a pass to a resource, UNDEFINED if the pass does not touch it
+static ResourceState get_pass_state(const RenderGraphPass* pPass, uint32_t resource)
+{
+	ResourceState state = RESOURCE_STATE_UNDEFINED;
+	for (uint32_t i = 0; i < (uint32_t)pPass->mAccesses.size(); ++i)
+	{
+		if (pPass->mAccesses[i].mResource == resource)
+			state |= pPass->mAccesses[i].mState;
+	}
+	return state;
+}
+
+static ResourceState get_current_state(const RenderGraphResource* pResource)
+{
+	if (pResource->pBuffer)
+		return pResource->pBuffer->mCurrentState;
+	if (pResource->pTexture)
+		return pResource->pTexture->mCurrentState;
+	return RESOURCE_STATE_UNDEFINED;
+}
+
+/************************************************************************/
+// Physical render target helpers
+/************************************************************************/
+static uint32_t get_bytes_per_pixel(ImageFormat::Enum format)
+{
+	switch (format)
+	{
+	case ImageFormat::BGRA8: return 4;
+	case ImageFormat::S8: return 1;
+	case ImageFormat::D16S8: return 4;
+	case ImageFormat::D32S8:
+	case ImageFormat::X8D24PAX32: return 8;
+	default:
+		return format <= ImageFormat::D32F ? (uint32_t)ImageFormat::GetBytesPerPixel(format) : 4;
+	}
+}
+
+static uint64_t get_render_target_size(const RenderTargetDesc* pDesc)
+{
+	const uint64_t sampleCount = pDesc->mSampleCount ? (uint64_t)pDesc->mSampleCount : 1;
+	const uint64_t depth = pDesc->mDepth ? pDesc->mDepth : 1;
+	const uint64_t arraySize = pDesc->mArraySize ? pDesc->mArraySize : 1;
+	return (uint64_t)pDesc->mWidth * pDesc->mHeight * depth * arraySize * sampleCount * get_bytes_per_pixel(pDesc->mFormat);
+}
+
+/// Render targets can only be shared if every creation parameter matches, including the optimized clear value
+static bool is_render_target_desc_equal(const RenderTargetDesc* pA, const RenderTargetDesc* pB)
+{
+	return pA->mType == pB->mType && pA->mFlags == pB->mFlags && pA->mWidth == pB->mWidth &&
+		pA->mHeight == pB->mHeight && pA->mDepth == pB->mDepth && pA->mBaseArrayLayer == pB->mBaseArrayLayer &&
+		pA->mArraySize == pB->mArraySize && pA->mBaseMipLevel == pB->mBaseMipLevel &&
+		pA->mSampleCount == pB->mSampleCount && pA->mFormat == pB->mFormat && pA->mUsage == pB->mUsage &&
+		pA->mSampleQuality == pB->mSampleQuality && pA->mSrgb == pB->mSrgb &&
+		memcmp(&pA->mClearValue, &pB->mClearValue, sizeof(ClearValue)) == 0;
+}
+
+/************************************************************************/
+// Graph declaration
+/************************************************************************/
+void initRenderGraph(RenderGraph** ppGraph)
+{
+	ASSERT(ppGraph);
+	RenderGraph* pGraph = conf_placement_new<RenderGraph>(conf_calloc(1, sizeof(RenderGraph)));
+	*ppGraph = pGraph;
+}
+
+void exitRenderGraph(Renderer* pRenderer, RenderGraph* pGraph)
+{
+	ASSERT(pGraph);
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mPhysical.size(); ++i)
+	{
+		if (pGraph->mPhysical[i].pRenderTarget)
+		{
+			ASSERT(pRenderer);
+			removeRenderTarget(pRenderer, pGraph->mPhysical[i].pRenderTarget);
+		}
+	}
+	pGraph->~RenderGraph();
+	conf_free(pGraph);
+}
+
+void resetRenderGraph(RenderGraph* pGraph)
+{
+	ASSERT(pGraph);
+	pGraph->mResources.clear();
+	pGraph->mPasses.clear();
+	pGraph->mExecutionOrder.clear();
+	pGraph->mBarriers.clear();
+	pGraph->mFinalBarrierOffset = 0;
+	pGraph->mFinalBarrierCount = 0;
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mPhysical.size(); ++i)
+		pGraph->mPhysical[i].mUsed = false;
+	memset(&pGraph->mStats, 0, sizeof(pGraph->mStats));
+	pGraph->mCompiled = false;
+}
+
+static uint32_t add_resource(RenderGraph* pGraph, const char* pName, RenderGraphResourceType type)
+{
+	RenderGraphResource resource = {};
+	resource.pName = pName;
+	resource.mType = type;
+	resource.mFirstUse = RENDER_GRAPH_INVALID_HANDLE;
+	resource.mLastUse = RENDER_GRAPH_INVALID_HANDLE;
+	resource.mPhysical = RENDER_GRAPH_INVALID_HANDLE;
+	pGraph->mResources.push_back(resource);
+	pGraph->mCompiled = false;
+	return (uint32_t)pGraph->mResources.size() - 1;
+}
+
+uint32_t addRenderGraphRenderTarget(RenderGraph* pGraph, const char* pName, const RenderTargetDesc* pDesc)
+{
+	ASSERT(pGraph && pDesc);
+	const uint32_t index = add_resource(pGraph, pName, RENDER_GRAPH_RESOURCE_RENDER_TARGET);
+	RenderGraphResource* pResource = &pGraph->mResources[index];
+	pResource->mDesc = *pDesc;
+	pResource->mSize = get_render_target_size(pDesc);
+	return index;
+}
+
+uint32_t importRenderGraphRenderTarget(RenderGraph* pGraph, const char* pName, RenderTarget* pRenderTarget, ResourceState initialState, ResourceState finalState)
+{
+	ASSERT(pGraph && pRenderTarget);
+	const uint32_t index = add_resource(pGraph, pName, RENDER_GRAPH_RESOURCE_RENDER_TARGET);
+	RenderGraphResource* pResource = &pGraph->mResources[index];
+	pResource->mDesc = pRenderTarget->mDesc;
+	pResource->pRenderTarget = pRenderTarget;
+	pResource->pTexture = pRenderTarget->pTexture;
+	pResource->mInitialState = initialState;
+	pResource->mFinalState = finalState;
+	pResource->mImported = true;
+	return index;
+}
+
+uint32_t importRenderGraphTexture(RenderGraph* pGraph, const char* pName, Texture* pTexture, ResourceState initialState, ResourceState finalState)
+{
+	ASSERT(pGraph && pTexture);
+	const uint32_t index = add_resource(pGraph, pName, RENDER_GRAPH_RESOURCE_TEXTURE);
+	RenderGraphResource* pResource = &pGraph->mResources[index];
+	pResource->pTexture = pTexture;
+	pResource->mInitialState = initialState;
+	pResource->mFinalState = finalState;
+	pResource->mImported = true;
+	return index;
+}
+
+uint32_t importRenderGraphBuffer(RenderGraph* pGraph, const char* pName, Buffer* pBuffer, ResourceState initialState, ResourceState finalState)
+{
+	ASSERT(pGraph && pBuffer);
+	const uint32_t index = add_resource(pGraph, pName, RENDER_GRAPH_RESOURCE_BUFFER);
+	RenderGraphResource* pResource = &pGraph->mResources[index];
+	pResource->pBuffer = pBuffer;
+	pResource->mInitialState = initialState;
+	pResource->mFinalState = finalState;
+	pResource->mImported = true;
+	return index;
+}
+
+uint32_t addRenderGraphPass(RenderGraph* pGraph, const char* pName, RenderGraphPassFunc pfnExecute, void* pUserData, RenderGraphPassFlags flags)
+{
+	ASSERT(pGraph);
+	pGraph->mPasses.push_back(RenderGraphPass());
+	RenderGraphPass* pPass = &pGraph->mPasses.back();
+	pPass->pName = pName;
+	pPass->pfnExecute = pfnExecute;
+	pPass->pUserData = pUserData;
+	pPass->mFlags = flags;
+	pPass->mCulled = false;
+	pPass->mBarrierOffset = 0;
+	pPass->mBarrierCount = 0;
+	pGraph->mCompiled = false;
+	return (uint32_t)pGraph->mPasses.size() - 1;
+}
+
+static void add_access(RenderGraph* pGraph, uint32_t pass, uint32_t resource, ResourceState state, bool write)
+{
+	ASSERT(pGraph);
+	ASSERT(pass < (uint32_t)pGraph->mPasses.size());
+	ASSERT(resource < (uint32_t)pGraph->mResources.size());
+	ASSERT(state != RESOURCE_STATE_UNDEFINED);
+	RenderGraphAccess access = { resource, state, write };
+	pGraph->mPasses[pass].mAccesses.push_back(access);
+	pGraph->mCompiled = false;
+}
+
+void renderGraphRead(RenderGraph* pGraph, uint32_t pass, uint32_t resource, ResourceState state)
+{
+	ASSERT(is_read_state(state));
+	add_access(pGraph, pass, resource, state, false);
+}
+
+void renderGraphWrite(RenderGraph* pGraph, uint32_t pass, uint32_t resource, ResourceState state)
+{
+	add_access(pGraph, pass, resource, state, true);
+}
+
+/************************************************************************/
+// Graph compilation
+/************************************************************************/
+typedef struct RenderGraphEdge
+{
+	uint32_t	mFrom;
+	uint32_t	mTo;
+	/// Read after write. Only these carry data, write after read and write after write edges only order passes
+	bool		mData;
+} RenderGraphEdge;
+
+typedef struct RenderGraphInterval
+{
+	uint32_t	mFirst;
+	uint32_t	mResource;
+} RenderGraphInterval;
+
+static int CompareIntervalFirst(const void* pLhs, const void* pRhs)
+{
+	const RenderGraphInterval* pA = (const RenderGraphInterval*)pLhs;
+	const RenderGraphInterval* pB = (const RenderGraphInterval*)pRhs;
+	if (pA->mFirst != pB->mFirst)
+		return pA->mFirst < pB->mFirst ? -1 : 1;
+	return pA->mResource < pB->mResource ? -1 : (pA->mResource > pB->mResource ? 1 : 0);
+}
+
+/// Builds the dependency edges implied by declaration order. Fails if a transient resource is read before any write.
+/// Culled passes can be skipped so passes around them still get ordered against each other
+static bool build_edges(RenderGraph* pGraph, bool skipCulled, tinystl::vector<RenderGraphEdge>& edges)
+{
+	const uint32_t resourceCount = (uint32_t)pGraph->mResources.size();
+	tinystl::vector<uint32_t> lastWriter(resourceCount, RENDER_GRAPH_INVALID_HANDLE);
+	// Readers since the last write of each resource, as an intrusive list through readerNext
+	tinystl::vector<uint32_t> readerHead(resourceCount, RENDER_GRAPH_INVALID_HANDLE);
+	tinystl::vector<uint32_t> readerPass;
+	tinystl::vector<uint32_t> readerNext;
+
+	for (uint32_t p = 0; p < (uint32_t)pGraph->mPasses.size(); ++p)
+	{
+		const RenderGraphPass* pPass = &pGraph->mPasses[p];
+		if (skipCulled && pPass->mCulled)
+			continue;
+		// Reads first so a pass that reads and writes the same resource depends on the previous writer only
+		for (uint32_t a = 0; a < (uint32_t)pPass->mAccesses.size(); ++a)
+		{
+			const RenderGraphAccess* pAccess = &pPass->mAccesses[a];
+			if (pAccess->mWrite)
+				continue;
+
+			const uint32_t r = pAccess->mResource;
+			if (lastWriter[r] != RENDER_GRAPH_INVALID_HANDLE)
+			{
+				RenderGraphEdge edge = { lastWriter[r], p, true };
+				edges.push_back(edge);
+			}
+			else if (!pGraph->mResources[r].mImported)
+			{
+				LOGERRORF("Render graph pass '%s' reads transient resource '%s' before it is written", pPass->pName, pGraph->mResources[r].pName);
+				return false;
+			}
+			readerPass.push_back(p);
+			readerNext.push_back(readerHead[r]);
+			readerHead[r] = (uint32_t)readerPass.size() - 1;
+		}
+		for (uint32_t a = 0; a < (uint32_t)pPass->mAccesses.size(); ++a)
+		{
+			const RenderGraphAccess* pAccess = &pPass->mAccesses[a];
+			if (!pAccess->mWrite)
+				continue;
+
+			const uint32_t r = pAccess->mResource;
+			if (lastWriter[r] != RENDER_GRAPH_INVALID_HANDLE && lastWriter[r] != p)
+			{
+				RenderGraphEdge edge = { lastWriter[r], p, false };
+				edges.push_back(edge);
+			}
+			for (uint32_t it = readerHead[r]; it != RENDER_GRAPH_INVALID_HANDLE; it = readerNext[it])
+			{
+				if (readerPass[it] != p)
+				{
+					RenderGraphEdge edge = { readerPass[it], p, false };
+					edges.push_back(edge);
+				}
+			}
+			readerHead[r] = RENDER_GRAPH_INVALID_HANDLE;
+			lastWriter[r] = p;
+		}
+	}
+	return true;
+}
+
+/// Keeps passes with side effects or writes to imported resources, and everything they transitively read from
+static void cull_passes(RenderGraph* pGraph, const tinystl::vector<RenderGraphEdge>& edges)
+{
+	const uint32_t passCount = (uint32_t)pGraph->mPasses.size();
+	tinystl::vector<uint32_t> stack;
+	for (uint32_t p = 0; p < passCount; ++p)
+	{
+		RenderGraphPass* pPass = &pGraph->mPasses[p];
+		bool root = (pPass->mFlags & RENDER_GRAPH_PASS_FLAG_SIDE_EFFECTS) != 0;
+		for (uint32_t a = 0; a < (uint32_t)pPass->mAccesses.size() && !root; ++a)
+			root = pPass->mAccesses[a].mWrite && pGraph->mResources[pPass->mAccesses[a].mResource].mImported;
+
+		pPass->mCulled = !root;
+		if (root)
+			stack.push_back(p);
+	}
+
+	while (!stack.empty())
+	{
+		const uint32_t p = stack.back();
+		stack.pop_back();
+		for (uint32_t e = 0; e < (uint32_t)edges.size(); ++e)
+		{
+			if (edges[e].mTo == p && edges[e].mData && pGraph->mPasses[edges[e].mFrom].mCulled)
+			{
+				pGraph->mPasses[edges[e].mFrom].mCulled = false;
+				stack.push_back(edges[e].mFrom);
+			}
+		}
+	}
+}
+
+/// Topological sort of the passes left after culling. Among the passes that are ready, the one consuming the most
+/// recently executed output goes first so producers and consumers stay close, which shortens transient lifetimes.
+/// Ties keep declaration order
+static void sort_passes(RenderGraph* pGraph, const tinystl::vector<RenderGraphEdge>& edges)
+{
+	const uint32_t passCount = (uint32_t)pGraph->mPasses.size();
+	tinystl::vector<uint32_t> inDegree(passCount, 0);
+	tinystl::vector<uint32_t> latestProducer(passCount, 0);
+	tinystl::vector<bool> scheduled(passCount, false);
+	uint32_t aliveCount = 0;
+
+	for (uint32_t p = 0; p < passCount; ++p)
+		aliveCount += pGraph->mPasses[p].mCulled ? 0 : 1;
+	for (uint32_t e = 0; e < (uint32_t)edges.size(); ++e)
+	{
+		if (!pGraph->mPasses[edges[e].mFrom].mCulled && !pGraph->mPasses[edges[e].mTo].mCulled)
+			++inDegree[edges[e].mTo];
+	}
+
+	pGraph->mExecutionOrder.reserve(aliveCount);
+	while ((uint32_t)pGraph->mExecutionOrder.size() < aliveCount)
+	{
+		uint32_t next = RENDER_GRAPH_INVALID_HANDLE;
+		for (uint32_t p = 0; p < passCount; ++p)
+		{
+			if (pGraph->mPasses[p].mCulled || scheduled[p] || inDegree[p])
+				continue;
+			if (next == RENDER_GRAPH_INVALID_HANDLE || latestProducer[p] > latestProducer[next])
+				next = p;
+		}
+		// Edges always point forward in declaration order so the graph cannot have cycles
+		ASSERT(next != RENDER_GRAPH_INVALID_HANDLE);
+
+		scheduled[next] = true;
+		pGraph->mExecutionOrder.push_back(next);
+		const uint32_t position = (uint32_t)pGraph->mExecutionOrder.size();
+		for (uint32_t e = 0; e < (uint32_t)edges.size(); ++e)
+		{
+			if (edges[e].mFrom != next || pGraph->mPasses[edges[e].mTo].mCulled)
+				continue;
+			--inDegree[edges[e].mTo];
+			if (edges[e].mData)
+				latestProducer[edges[e].mTo] = position;
+		}
+	}
+}
+
+static void compute_lifetimes(RenderGraph* pGraph)
+{
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mExecutionOrder.size(); ++i)
+	{
+		const RenderGraphPass* pPass = &pGraph->mPasses[pGraph->mExecutionOrder[i]];
+		for (uint32_t a = 0; a < (uint32_t)pPass->mAccesses.size(); ++a)
+		{
+			RenderGraphResource* pResource = &pGraph->mResources[pPass->mAccesses[a].mResource];
+			if (pResource->mFirstUse == RENDER_GRAPH_INVALID_HANDLE)
+				pResource->mFirstUse = i;
+			pResource->mLastUse = i;
+		}
+	}
+}
+
+/// Greedy interval assignment in order of first use. A transient goes to the compatible physical target that was
+/// released last, keeping older targets free for resources further down the frame, and a new target is only added
+/// when no compatible one is free
+static void alias_transients(RenderGraph* pGraph)
+{
+	tinystl::vector<RenderGraphInterval> intervals;
+	for (uint32_t r = 0; r < (uint32_t)pGraph->mResources.size(); ++r)
+	{
+		const RenderGraphResource* pResource = &pGraph->mResources[r];
+		if (pResource->mImported || pResource->mFirstUse == RENDER_GRAPH_INVALID_HANDLE)
+			continue;
+		RenderGraphInterval interval = { pResource->mFirstUse, r };
+		intervals.push_back(interval);
+	}
+	if (intervals.empty())
+		return;
+	qsort(intervals.data(), intervals.size(), sizeof(RenderGraphInterval), CompareIntervalFirst);
+
+	for (uint32_t i = 0; i < (uint32_t)intervals.size(); ++i)
+	{
+		RenderGraphResource* pResource = &pGraph->mResources[intervals[i].mResource];
+		uint32_t best = RENDER_GRAPH_INVALID_HANDLE;
+		for (uint32_t t = 0; t < (uint32_t)pGraph->mPhysical.size(); ++t)
+		{
+			const RenderGraphPhysicalTarget* pTarget = &pGraph->mPhysical[t];
+			if ((pTarget->mUsed && pTarget->mLastUse >= pResource->mFirstUse) || !is_render_target_desc_equal(&pTarget->mDesc, &pResource->mDesc))
+				continue;
+			if (best == RENDER_GRAPH_INVALID_HANDLE)
+			{
+				best = t;
+				continue;
+			}
+			// Prefer targets already used this frame, then the one released last
+			const RenderGraphPhysicalTarget* pBest = &pGraph->mPhysical[best];
+			if ((pTarget->mUsed && !pBest->mUsed) || (pTarget->mUsed && pBest->mUsed && pTarget->mLastUse > pBest->mLastUse))
+				best = t;
+		}
+
+		if (best == RENDER_GRAPH_INVALID_HANDLE)
+		{
+			RenderGraphPhysicalTarget target = {};
+			target.mDesc = pResource->mDesc;
+			target.mSize = pResource->mSize;
+			pGraph->mPhysical.push_back(target);
+			best = (uint32_t)pGraph->mPhysical.size() - 1;
+		}
+
+		RenderGraphPhysicalTarget* pTarget = &pGraph->mPhysical[best];
+		if (!pTarget->mUsed)
+		{
+			pTarget->mUsed = true;
+			++pGraph->mStats.mPhysicalTargetCount;
+			pGraph->mStats.mPhysicalBytes += pTarget->mSize;
+		}
+		pTarget->mLastUse = pResource->mLastUse;
+		pResource->mPhysical = best;
+		++pGraph->mStats.mTransientCount;
+		pGraph->mStats.mTransientBytes += pResource->mSize;
+	}
+}
+
+/// Simulates the resource states over the execution order and records the transitions each pass needs as one batch.
+/// Transient resources are tracked through their physical target since aliased resources share its state
+static void build_barriers(RenderGraph* pGraph)
+{
+	const uint32_t resourceCount = (uint32_t)pGraph->mResources.size();
+	const uint32_t orderCount = (uint32_t)pGraph->mExecutionOrder.size();
+	tinystl::vector<ResourceState> resourceStates(resourceCount, RESOURCE_STATE_UNDEFINED);
+	tinystl::vector<ResourceState> physicalStates(pGraph->mPhysical.size(), RESOURCE_STATE_UNDEFINED);
+
+	for (uint32_t r = 0; r < resourceCount; ++r)
+	{
+		const RenderGraphResource* pResource = &pGraph->mResources[r];
+		if (pResource->mImported)
+			resourceStates[r] = pResource->mInitialState != RESOURCE_STATE_UNDEFINED ? pResource->mInitialState : get_current_state(pResource);
+	}
+
+	for (uint32_t i = 0; i < orderCount; ++i)
+	{
+		RenderGraphPass* pPass = &pGraph->mPasses[pGraph->mExecutionOrder[i]];
+		pPass->mBarrierOffset = (uint32_t)pGraph->mBarriers.size();
+
+		for (uint32_t a = 0; a < (uint32_t)pPass->mAccesses.size(); ++a)
+		{
+			const uint32_t r = pPass->mAccesses[a].mResource;
+			// Accesses to the same resource are combined, handle the resource at its first access only
+			bool seen = false;
+			for (uint32_t b = 0; b < a && !seen; ++b)
+				seen = pPass->mAccesses[b].mResource == r;
+			if (seen)
+				continue;
+
+			const RenderGraphResource* pResource = &pGraph->mResources[r];
+			ResourceState* pState = pResource->mPhysical != RENDER_GRAPH_INVALID_HANDLE ? &physicalStates[pResource->mPhysical] : &resourceStates[r];
+			const ResourceState required = get_pass_state(pPass, r);
+			const bool read = is_read_state(required);
+			// The first access of a transient discards whatever an aliased resource left behind
+			const ResourceState oldState = (!pResource->mImported && pResource->mFirstUse == i) ? RESOURCE_STATE_UNDEFINED : *pState;
+
+			if (covers_state(*pState, required) && (read || *pState == required))
+			{
+				if (*pState != required)
+					++pGraph->mStats.mMergedReadCount;
+				continue;
+			}
+
+			ResourceState newState = required;
+			const ResourceState mergeable = get_mergeable_read_states(pResource);
+			if (read && !(required & ~mergeable))
+			{
+				// Move straight to the combined state of all upcoming reads so they need no transitions of their own
+				for (uint32_t j = i + 1; j < orderCount && j <= pResource->mLastUse; ++j)
+				{
+					const ResourceState next = get_pass_state(&pGraph->mPasses[pGraph->mExecutionOrder[j]], r);
+					if (next == RESOURCE_STATE_UNDEFINED)
+						continue;
+					if (!is_read_state(next) || (next & ~mergeable))
+						break;
+					newState |= next;
+				}
+			}
+
+			RenderGraphBarrier barrier = { r, oldState, newState };
+			pGraph->mBarriers.push_back(barrier);
+			*pState = newState;
+		}
+
+		pPass->mBarrierCount = (uint32_t)pGraph->mBarriers.size() - pPass->mBarrierOffset;
+		pGraph->mStats.mBarrierCount += pPass->mBarrierCount;
+		pGraph->mStats.mBarrierBatchCount += pPass->mBarrierCount ? 1 : 0;
+	}
+
+	pGraph->mFinalBarrierOffset = (uint32_t)pGraph->mBarriers.size();
+	for (uint32_t r = 0; r < resourceCount; ++r)
+	{
+		const RenderGraphResource* pResource = &pGraph->mResources[r];
+		if (!pResource->mImported || pResource->mFinalState == RESOURCE_STATE_UNDEFINED || covers_state(resourceStates[r], pResource->mFinalState))
+			continue;
+		RenderGraphBarrier barrier = { r, resourceStates[r], pResource->mFinalState };
+		pGraph->mBarriers.push_back(barrier);
+	}
+	pGraph->mFinalBarrierCount = (uint32_t)pGraph->mBarriers.size() - pGraph->mFinalBarrierOffset;
+	pGraph->mStats.mBarrierCount += pGraph->mFinalBarrierCount;
+	pGraph->mStats.mBarrierBatchCount += pGraph->mFinalBarrierCount ? 1 : 0;
+}
+
+bool compileRenderGraph(RenderGraph* pGraph)
+{
+	ASSERT(pGraph);
+	pGraph->mExecutionOrder.clear();
+	pGraph->mBarriers.clear();
+	pGraph->mFinalBarrierOffset = 0;
+	pGraph->mFinalBarrierCount = 0;
+	memset(&pGraph->mStats, 0, sizeof(pGraph->mStats));
+	pGraph->mCompiled = false;
+	for (uint32_t t = 0; t < (uint32_t)pGraph->mPhysical.size(); ++t)
+		pGraph->mPhysical[t].mUsed = false;
+	for (uint32_t r = 0; r < (uint32_t)pGraph->mResources.size(); ++r)
+	{
+		RenderGraphResource* pResource = &pGraph->mResources[r];
+		pResource->mFirstUse = RENDER_GRAPH_INVALID_HANDLE;
+		pResource->mLastUse = RENDER_GRAPH_INVALID_HANDLE;
+		pResource->mPhysical = RENDER_GRAPH_INVALID_HANDLE;
+		if (!pResource->mImported)
+		{
+			pResource->pRenderTarget = NULL;
+			pResource->pTexture = NULL;
+		}
+	}
+
+	tinystl::vector<RenderGraphEdge> edges;
+	if (!build_edges(pGraph, false, edges))
+		return false;
+
+	cull_passes(pGraph, edges);
+	edges.clear();
+	build_edges(pGraph, true, edges);
+	sort_passes(pGraph, edges);
+	compute_lifetimes(pGraph);
+	alias_transients(pGraph);
+	build_barriers(pGraph);
+
+	pGraph->mStats.mPassCount = (uint32_t)pGraph->mExecutionOrder.size();
+	pGraph->mStats.mCulledPassCount = (uint32_t)pGraph->mPasses.size() - pGraph->mStats.mPassCount;
+	pGraph->mCompiled = true;
+	return true;
+}
+
+/************************************************************************/
+// Graph execution
+/************************************************************************/
+static void cmd_render_graph_barriers(Cmd* pCmd, RenderGraph* pGraph, uint32_t offset, uint32_t count,
+	tinystl::vector<BufferBarrier>& bufferBarriers, tinystl::vector<TextureBarrier>& textureBarriers)
+{
+	if (!count)
+		return;
+
+	bufferBarriers.clear();
+	textureBarriers.clear();
+	for (uint32_t i = offset; i < offset + count; ++i)
+	{
+		const RenderGraphBarrier* pBarrier = &pGraph->mBarriers[i];
+		const RenderGraphResource* pResource = &pGraph->mResources[pBarrier->mResource];
+		if (pResource->pBuffer)
+		{
+			BufferBarrier barrier = { pResource->pBuffer, pBarrier->mNewState, false };
+			bufferBarriers.push_back(barrier);
+		}
+		else
+		{
+			TextureBarrier barrier = { pResource->pTexture, pBarrier->mNewState, false };
+			textureBarriers.push_back(barrier);
+		}
+	}
+	// Everything the pass needs is already merged, no point in deferring it to the next batch flush
+	cmdResourceBarrier(pCmd, (uint32_t)bufferBarriers.size(), bufferBarriers.data(), (uint32_t)textureBarriers.size(), textureBarriers.data(), false);
+}
+
+void executeRenderGraph(Renderer* pRenderer, Cmd* pCmd, RenderGraph* pGraph)
+{
+	ASSERT(pRenderer && pCmd && pGraph);
+	ASSERT(pGraph->mCompiled);
+
+	for (uint32_t t = 0; t < (uint32_t)pGraph->mPhysical.size(); ++t)
+	{
+		RenderGraphPhysicalTarget* pTarget = &pGraph->mPhysical[t];
+		if (pTarget->mUsed && !pTarget->pRenderTarget)
+			addRenderTarget(pRenderer, &pTarget->mDesc, &pTarget->pRenderTarget);
+	}
+	for (uint32_t r = 0; r < (uint32_t)pGraph->mResources.size(); ++r)
+	{
+		RenderGraphResource* pResource = &pGraph->mResources[r];
+		if (pResource->mPhysical == RENDER_GRAPH_INVALID_HANDLE)
+			continue;
+		pResource->pRenderTarget = pGraph->mPhysical[pResource->mPhysical].pRenderTarget;
+		pResource->pTexture = pResource->pRenderTarget->pTexture;
+	}
+
+	tinystl::vector<BufferBarrier> bufferBarriers;
+	tinystl::vector<TextureBarrier> textureBarriers;
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mExecutionOrder.size(); ++i)
+	{
+		const uint32_t pass = pGraph->mExecutionOrder[i];
+		RenderGraphPass* pPass = &pGraph->mPasses[pass];
+		cmd_render_graph_barriers(pCmd, pGraph, pPass->mBarrierOffset, pPass->mBarrierCount, bufferBarriers, textureBarriers);
+		if (pPass->pfnExecute)
+			pPass->pfnExecute(pCmd, pGraph, pass, pPass->pUserData);
+	}
+	cmd_render_graph_barriers(pCmd, pGraph, pGraph->mFinalBarrierOffset, pGraph->mFinalBarrierCount, bufferBarriers, textureBarriers);
+}
+
+RenderTarget* getRenderGraphRenderTarget(RenderGraph* pGraph, uint32_t resource)
+{
+	ASSERT(pGraph && resource < (uint32_t)pGraph->mResources.size());
+	return pGraph->mResources[resource].pRenderTarget;
+}
+
+Texture* getRenderGraphTexture(RenderGraph* pGraph, uint32_t resource)
+{
+	ASSERT(pGraph && resource < (uint32_t)pGraph->mResources.size());
+	return pGraph->mResources[resource].pTexture;
+}
+
+Buffer* getRenderGraphBuffer(RenderGraph* pGraph, uint32_t resource)
+{
+	ASSERT(pGraph && resource < (uint32_t)pGraph->mResources.size());
+	return pGraph->mResources[resource].pBuffer;
+}
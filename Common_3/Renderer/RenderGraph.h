@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "IRenderer.h"
+#include "../ThirdParty/OpenSource/TinySTL/vector.h"
+
+/************************************************************************/
+// Render graph
+/************************************************************************/
+/// Passes declare the resources they read and write together with the state they need them in. Compiling the graph
+/// culls passes whose results are never used, orders the rest, merges all transitions a pass needs into one barrier
+/// batch and lets transient render targets with the same desc and disjoint lifetimes share one physical render target.
+/// Compilation only touches CPU data so it can run and be inspected without a device. executeRenderGraph then creates
+/// the physical render targets, records the barrier batches and calls the pass callbacks.
+#define RENDER_GRAPH_INVALID_HANDLE 0xFFFFFFFF
+
+typedef struct RenderGraph RenderGraph;
+
+/// Records the commands of one pass. Resources of the graph are looked up with getRenderGraphTexture and friends
+typedef void(*RenderGraphPassFunc)(Cmd* pCmd, RenderGraph* pGraph, uint32_t pass, void* pUserData);
+
+typedef enum RenderGraphResourceType
+{
+	RENDER_GRAPH_RESOURCE_RENDER_TARGET = 0,
+	RENDER_GRAPH_RESOURCE_TEXTURE,
+	RENDER_GRAPH_RESOURCE_BUFFER,
+} RenderGraphResourceType;
+
+typedef enum RenderGraphPassFlags
+{
+	RENDER_GRAPH_PASS_FLAG_NONE = 0,
+	/// Never culled even if nothing reads its output (readbacks, uploads, debug passes)
+	RENDER_GRAPH_PASS_FLAG_SIDE_EFFECTS = 0x1,
+} RenderGraphPassFlags;
+MAKE_ENUM_FLAG(uint32_t, RenderGraphPassFlags)
+
+typedef struct RenderGraphAccess
+{
+	uint32_t		mResource;
+	ResourceState	mState;
+	bool			mWrite;
+} RenderGraphAccess;
+
+typedef struct RenderGraphResource
+{
+	const char*				pName;
+	RenderGraphResourceType	mType;
+	/// Desc of a transient render target, only valid for RENDER_GRAPH_RESOURCE_RENDER_TARGET
+	RenderTargetDesc		mDesc;
+	/// Imported resources, NULL for transient render targets until the graph is executed
+	RenderTarget*			pRenderTarget;
+	Texture*				pTexture;
+	Buffer*					pBuffer;
+	/// State of an imported resource when the frame starts and the state it is left in (UNDEFINED keeps the last state)
+	ResourceState			mInitialState;
+	ResourceState			mFinalState;
+	bool					mImported;
+
+	/// Compiled data. Lifetime is the range of execution order indices using the resource
+	uint32_t				mFirstUse;
+	uint32_t				mLastUse;
+	/// Index into RenderGraph::mPhysical for transient render targets
+	uint32_t				mPhysical;
+	uint64_t				mSize;
+} RenderGraphResource;
+
+typedef struct RenderGraphPass
+{
+	const char*							pName;
+	RenderGraphPassFunc					pfnExecute;
+	void*								pUserData;
+	RenderGraphPassFlags				mFlags;
+	tinystl::vector<RenderGraphAccess>	mAccesses;
+
+	/// Compiled data
+	bool								mCulled;
+	/// Range of RenderGraph::mBarriers submitted before the pass runs
+	uint32_t							mBarrierOffset;
+	uint32_t							mBarrierCount;
+} RenderGraphPass;
+
+typedef struct RenderGraphBarrier
+{
+	uint32_t		mResource;
+	/// State assumed before the barrier, UNDEFINED when the previous contents are discarded
+	ResourceState	mOldState;
+	ResourceState	mNewState;
+} RenderGraphBarrier;
+
+/// Render target shared by all transient resources aliased onto it. Kept alive across frames
+typedef struct RenderGraphPhysicalTarget
+{
+	RenderTargetDesc	mDesc;
+	RenderTarget*		pRenderTarget;
+	uint64_t			mSize;
+	/// Last execution order index using the target during compilation
+	uint32_t			mLastUse;
+	/// Set while the target is assigned in the compiled graph
+	bool				mUsed;
+} RenderGraphPhysicalTarget;
+
+typedef struct RenderGraphStats
+{
+	uint32_t	mPassCount;
+	uint32_t	mCulledPassCount;
+	/// Transitions recorded, and how many cmdResourceBarrier calls they were merged into
+	uint32_t	mBarrierCount;
+	uint32_t	mBarrierBatchCount;
+	/// Reads that needed no transition because an earlier read already moved the resource to a combined read state
+	uint32_t	mMergedReadCount;
+	uint32_t	mTransientCount;
+	uint32_t	mPhysicalTargetCount;
+	/// Bytes of all transient render targets, and of the physical targets backing them
+	uint64_t	mTransientBytes;
+	uint64_t	mPhysicalBytes;
+} RenderGraphStats;
+
+typedef struct RenderGraph
+{
+	tinystl::vector<RenderGraphResource>		mResources;
+	tinystl::vector<RenderGraphPass>			mPasses;
+	/// Compiled data
+	tinystl::vector<uint32_t>					mExecutionOrder;
+	tinystl::vector<RenderGraphBarrier>			mBarriers;
+	/// Transitions of imported resources to their final state, submitted after the last pass
+	uint32_t									mFinalBarrierOffset;
+	uint32_t									mFinalBarrierCount;
+	tinystl::vector<RenderGraphPhysicalTarget>	mPhysical;
+	RenderGraphStats							mStats;
+	bool										mCompiled;
+} RenderGraph;
+
+void initRenderGraph(RenderGraph** ppGraph);
+/// Removes the physical render targets. pRenderer may be NULL if the graph was never executed
+void exitRenderGraph(Renderer* pRenderer, RenderGraph* pGraph);
+/// Clears passes and resources for the next frame. Physical render targets stay alive for reuse
+void resetRenderGraph(RenderGraph* pGraph);
+
+/// Declares a render target that only lives within the frame. Its contents are undefined before its first write
+uint32_t addRenderGraphRenderTarget(RenderGraph* pGraph, const char* pName, const RenderTargetDesc* pDesc);
+uint32_t importRenderGraphRenderTarget(RenderGraph* pGraph, const char* pName, RenderTarget* pRenderTarget, ResourceState initialState, ResourceState finalState);
+uint32_t importRenderGraphTexture(RenderGraph* pGraph, const char* pName, Texture* pTexture, ResourceState initialState, ResourceState finalState);
+uint32_t importRenderGraphBuffer(RenderGraph* pGraph, const char* pName, Buffer* pBuffer, ResourceState initialState, ResourceState finalState);
+
+uint32_t addRenderGraphPass(RenderGraph* pGraph, const char* pName, RenderGraphPassFunc pfnExecute, void* pUserData, RenderGraphPassFlags flags = RENDER_GRAPH_PASS_FLAG_NONE);
+/// Reads see the result of the last pass declared before this one that writes the resource
+void renderGraphRead(RenderGraph* pGraph, uint32_t pass, uint32_t resource, ResourceState state);
+void renderGraphWrite(RenderGraph* pGraph, uint32_t pass, uint32_t resource, ResourceState state);
+
+/// Builds execution order, barrier batches and physical render target assignment. Returns false on invalid graphs
+bool compileRenderGraph(RenderGraph* pGraph);
+/// Records the compiled graph into pCmd, creating physical render targets on first use
+void executeRenderGraph(Renderer* pRenderer, Cmd* pCmd, RenderGraph* pGraph);
+
+RenderTarget* getRenderGraphRenderTarget(RenderGraph* pGraph, uint32_t resource);
+Texture* getRenderGraphTexture(RenderGraph* pGraph, uint32_t resource);
+Buffer* getRenderGraphBuffer(RenderGraph* pGraph, uint32_t resource);
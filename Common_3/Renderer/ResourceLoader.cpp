@@ -27,6 +27,7 @@
 #include "../OS/Interfaces/ILogManager.h"
 #include "../OS/Interfaces/IMemoryManager.h"
 
+COMMAND_CAPTURE_LAYER_BEGIN
 // buffer functions
 extern void addBuffer(Renderer* pRenderer, const BufferDesc* desc, Buffer** pp_buffer);
 extern void removeBuffer(Renderer* pRenderer, Buffer* p_buffer);
@@ -38,11 +39,12 @@ extern void unmapBuffer(Renderer* pRenderer, Buffer* pBuffer);
 extern void addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** pp_texture);
 extern void removeTexture(Renderer* pRenderer, Texture*p_texture);
 
-extern void mapTexture(Renderer* pRenderer, Texture* pTexture);
-extern void unmapTexture(Renderer* pRenderer, Texture* pTexture);
-
 extern void cmdUpdateBuffer(Cmd* p_cmd, uint64_t srcOffset, uint64_t dstOffset, uint64_t size, Buffer* p_src_buffer, Buffer* p_buffer);
 extern void cmdUpdateSubresources(Cmd* pCmd, uint32_t startSubresource, uint32_t numSubresources, SubresourceDataDesc* pSubresources, Buffer* pIntermediate, uint64_t intermediateOffset, Texture* pTexture);
+COMMAND_CAPTURE_LAYER_END
+
+extern void mapTexture(Renderer* pRenderer, Texture* pTexture);
+extern void unmapTexture(Renderer* pRenderer, Texture* pTexture);
 //////////////////////////////////////////////////////////////////////////
 // Resource Loader Defines
 //////////////////////////////////////////////////////////////////////////
@@ -337,7 +339,7 @@ static void upload_texture_data(TextureLoadDesc* pTextureFileDesc, const Image&
 	ASSERT(pTexture);
 
 	// Only need transition for vulkan and durango since resource will auto promote to copy dest on copy queue in PC dx12
-#if defined(VULKAN) || defined(_DURANGO)
+#if defined(VULKAN) || defined(_DURANGO) || defined(NULL_RENDERER)
 	TextureBarrier barrier = { pTexture, RESOURCE_STATE_COPY_DEST };
 	cmdResourceBarrier(pLoader->pCopyCmd, 0, NULL, 1, &barrier, false);
 #endif
@@ -418,7 +420,7 @@ static void upload_texture_data(TextureLoadDesc* pTextureFileDesc, const Image&
 	cmdUpdateSubresources(pLoader->pCopyCmd, 0, numSubresources, texData, range.pBuffer, range.mOffset, pTexture);
 
 	// Only need transition for vulkan and durango since resource will decay to srv on graphics queue in PC dx12
-#if defined(VULKAN) || defined(_DURANGO)
+#if defined(VULKAN) || defined(_DURANGO) || defined(NULL_RENDERER)
 	barrier = { pTexture, util_determine_resource_start_state(pTexture->mDesc.mUsage) };
 	cmdResourceBarrier(pLoader->pCopyCmd, 0, NULL, 1, &barrier, true);
 #endif
@@ -451,7 +453,7 @@ static void cmdLoadEmptyTexture(TextureLoadDesc* pEmptyTexture, ResourceLoader*
 	addTexture(pLoader->pRenderer, pEmptyTexture->pDesc, pEmptyTexture->ppTexture);
 
 	// Only need transition for vulkan and durango since resource will decay to srv on graphics queue in PC dx12
-#if defined(VULKAN) || defined(_DURANGO)
+#if defined(VULKAN) || defined(_DURANGO) || defined(NULL_RENDERER)
 	TextureBarrier barrier = { *pEmptyTexture->ppTexture, pEmptyTexture->pDesc->mStartState };
 	cmdResourceBarrier(pLoader->pCopyCmd, 0, NULL, 1, &barrier, true);
 #endif
@@ -0,0 +1,542 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "TlsfAllocator.h"
+
+#include "../OS/Interfaces/ILogManager.h"
+#include "../OS/Interfaces/IMemoryManager.h"
+
+#define TLSF_RANGE_CHUNK_SIZE 256
+
+/************************************************************************/
+// Range pool
+/************************************************************************/
+static TlsfRange* acquire_range(TlsfBlock* pBlock)
+{
+	if (!pBlock->pRangePool)
+	{
+		TlsfRange* pChunk = (TlsfRange*)conf_malloc(sizeof(TlsfRange) * TLSF_RANGE_CHUNK_SIZE);
+		for (uint32_t i = 0; i < TLSF_RANGE_CHUNK_SIZE; ++i)
+			pChunk[i].pNextFree = (i + 1 < TLSF_RANGE_CHUNK_SIZE) ? &pChunk[i + 1] : NULL;
+		pBlock->mRangeChunks.push_back(pChunk);
+		pBlock->pRangePool = pChunk;
+	}
+
+	TlsfRange* pRange = pBlock->pRangePool;
+	pBlock->pRangePool = pRange->pNextFree;
+	memset(pRange, 0, sizeof(TlsfRange));
+	return pRange;
+}
+
+static void release_range(TlsfBlock* pBlock, TlsfRange* pRange)
+{
+	pRange->pNextFree = pBlock->pRangePool;
+	pBlock->pRangePool = pRange;
+}
+
+/************************************************************************/
+// Physical list
+/************************************************************************/
+static void insert_range_before(TlsfBlock* pBlock, TlsfRange* pRange, TlsfRange* pNext)
+{
+	pRange->pNextPhysical = pNext;
+	pRange->pPrevPhysical = pNext->pPrevPhysical;
+	if (pNext->pPrevPhysical)
+		pNext->pPrevPhysical->pNextPhysical = pRange;
+	else
+		pBlock->pFirstRange = pRange;
+	pNext->pPrevPhysical = pRange;
+}
+
+static void insert_range_after(TlsfBlock* pBlock, TlsfRange* pRange, TlsfRange* pPrev)
+{
+	pRange->pPrevPhysical = pPrev;
+	pRange->pNextPhysical = pPrev->pNextPhysical;
+	if (pPrev->pNextPhysical)
+		pPrev->pNextPhysical->pPrevPhysical = pRange;
+	else
+		pBlock->pLastRange = pRange;
+	pPrev->pNextPhysical = pRange;
+}
+
+static void unlink_range(TlsfBlock* pBlock, TlsfRange* pRange)
+{
+	if (pRange->pPrevPhysical)
+		pRange->pPrevPhysical->pNextPhysical = pRange->pNextPhysical;
+	else
+		pBlock->pFirstRange = pRange->pNextPhysical;
+	if (pRange->pNextPhysical)
+		pRange->pNextPhysical->pPrevPhysical = pRange->pPrevPhysical;
+	else
+		pBlock->pLastRange = pRange->pPrevPhysical;
+}
+
+/************************************************************************/
+// Block
+/************************************************************************/
+static inline uint64_t align_up(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static inline bool range_fits(const TlsfRange* pRange, uint64_t size, uint64_t alignment)
+{
+	return pRange->mSize >= size && align_up(pRange->mOffset, alignment) + size <= pRange->mOffset + pRange->mSize;
+}
+
+// Turns [offset, offset + size) of the free range into an allocation, the leftovers on both sides stay free
+static TlsfRange* carve_range(TlsfBlock* pBlock, TlsfRange* pRange, uint64_t offset, uint64_t size, void* pUserData)
+{
+	ASSERT(pRange->mFree);
+	ASSERT(offset >= pRange->mOffset && offset + size <= pRange->mOffset + pRange->mSize);
+	pBlock->mFreeLists.Remove(pRange);
+
+	const uint64_t paddingBegin = offset - pRange->mOffset;
+	const uint64_t paddingEnd = pRange->mSize - paddingBegin - size;
+
+	if (paddingBegin)
+	{
+		TlsfRange* pPadding = acquire_range(pBlock);
+		pPadding->mOffset = pRange->mOffset;
+		pPadding->mSize = paddingBegin;
+		pPadding->mFree = true;
+		insert_range_before(pBlock, pPadding, pRange);
+		pBlock->mFreeLists.Insert(pPadding);
+	}
+
+	if (paddingEnd)
+	{
+		TlsfRange* pPadding = acquire_range(pBlock);
+		pPadding->mOffset = offset + size;
+		pPadding->mSize = paddingEnd;
+		pPadding->mFree = true;
+		insert_range_after(pBlock, pPadding, pRange);
+		pBlock->mFreeLists.Insert(pPadding);
+	}
+
+	pRange->mOffset = offset;
+	pRange->mSize = size;
+	pRange->mFree = false;
+	pRange->pUserData = pUserData;
+	pBlock->mFreeBytes -= size;
+	++pBlock->mAllocationCount;
+	return pRange;
+}
+
+void initTlsfBlock(TlsfBlock* pBlock, uint64_t size)
+{
+	ASSERT(pBlock);
+	ASSERT(size);
+
+	pBlock->mSize = size;
+	pBlock->mFreeBytes = size;
+	pBlock->mAllocationCount = 0;
+	pBlock->pRangePool = NULL;
+	pBlock->mRangeChunks.clear();
+	pBlock->mFreeLists.Reset();
+
+	TlsfRange* pRange = acquire_range(pBlock);
+	pRange->mSize = size;
+	pRange->mFree = true;
+	pBlock->pFirstRange = pRange;
+	pBlock->pLastRange = pRange;
+	pBlock->mFreeLists.Insert(pRange);
+}
+
+void exitTlsfBlock(TlsfBlock* pBlock)
+{
+	ASSERT(pBlock);
+
+	for (uint32_t i = 0; i < (uint32_t)pBlock->mRangeChunks.size(); ++i)
+		conf_free(pBlock->mRangeChunks[i]);
+	pBlock->mRangeChunks.clear();
+	pBlock->pRangePool = NULL;
+	pBlock->pFirstRange = NULL;
+	pBlock->pLastRange = NULL;
+	pBlock->mFreeLists.Reset();
+	pBlock->mSize = 0;
+	pBlock->mFreeBytes = 0;
+	pBlock->mAllocationCount = 0;
+}
+
+TlsfRange* tlsfAllocate(TlsfBlock* pBlock, uint64_t size, uint64_t alignment, void* pUserData)
+{
+	ASSERT(pBlock);
+	ASSERT(size);
+	ASSERT(alignment && !(alignment & (alignment - 1)));
+
+	if (size > pBlock->mFreeBytes)
+		return NULL;
+
+	// Tightest bin first, placed resources are usually aligned already
+	TlsfRange* pRange = pBlock->mFreeLists.FindFree(size);
+	if (pRange && range_fits(pRange, size, alignment))
+		return carve_range(pBlock, pRange, align_up(pRange->mOffset, alignment), size, pUserData);
+
+	// Anything in these bins fits even with worst case padding
+	if (alignment > 1)
+	{
+		pRange = pBlock->mFreeLists.FindFree(size + alignment - 1);
+		if (pRange)
+			return carve_range(pBlock, pRange, align_up(pRange->mOffset, alignment), size, pUserData);
+	}
+
+	// Only ranges smaller than size + alignment - 1 are left, including the ones sharing the bin of size.
+	// Whether they fit depends on their offset
+	uint32_t fl, sl;
+	tlsfMapInsert(size, &fl, &sl);
+	while (pBlock->mFreeLists.FindBin(&fl, &sl))
+	{
+		for (TlsfRange* pCandidate = pBlock->mFreeLists.GetHead(fl, sl); pCandidate; pCandidate = pCandidate->pNextFree)
+		{
+			if (range_fits(pCandidate, size, alignment))
+				return carve_range(pBlock, pCandidate, align_up(pCandidate->mOffset, alignment), size, pUserData);
+		}
+
+		if (++sl == TLSF_SL_COUNT)
+		{
+			sl = 0;
+			++fl;
+		}
+	}
+
+	return NULL;
+}
+
+TlsfRange* tlsfAllocateAt(TlsfBlock* pBlock, uint64_t offset, uint64_t size, void* pUserData)
+{
+	ASSERT(pBlock);
+	ASSERT(size);
+
+	if (offset + size > pBlock->mSize)
+		return NULL;
+
+	TlsfRange* pRange = pBlock->pLastRange;
+	while (pRange && pRange->mOffset > offset)
+		pRange = pRange->pPrevPhysical;
+
+	if (!pRange || !pRange->mFree || offset + size > pRange->mOffset + pRange->mSize)
+	{
+		LOGERRORF("TLSF block range [%llu, %llu) is not free", (unsigned long long)offset, (unsigned long long)(offset + size));
+		return NULL;
+	}
+
+	return carve_range(pBlock, pRange, offset, size, pUserData);
+}
+
+void tlsfFree(TlsfBlock* pBlock, TlsfRange* pRange)
+{
+	ASSERT(pBlock);
+	ASSERT(pRange && !pRange->mFree);
+
+	pBlock->mFreeBytes += pRange->mSize;
+	--pBlock->mAllocationCount;
+	pRange->mFree = true;
+	pRange->pUserData = NULL;
+
+	TlsfRange* pNext = pRange->pNextPhysical;
+	if (pNext && pNext->mFree)
+	{
+		pBlock->mFreeLists.Remove(pNext);
+		pRange->mSize += pNext->mSize;
+		unlink_range(pBlock, pNext);
+		release_range(pBlock, pNext);
+	}
+
+	TlsfRange* pPrev = pRange->pPrevPhysical;
+	if (pPrev && pPrev->mFree)
+	{
+		pBlock->mFreeLists.Remove(pPrev);
+		pPrev->mSize += pRange->mSize;
+		unlink_range(pBlock, pRange);
+		release_range(pBlock, pRange);
+		pRange = pPrev;
+	}
+
+	pBlock->mFreeLists.Insert(pRange);
+}
+
+static uint64_t get_largest_free_range(const TlsfBlock* pBlock)
+{
+	uint32_t fl, sl;
+	if (!pBlock->mFreeLists.GetLastBin(&fl, &sl))
+		return 0;
+
+	uint64_t largest = 0;
+	for (const TlsfRange* pRange = pBlock->mFreeLists.GetHead(fl, sl); pRange; pRange = pRange->pNextFree)
+		largest = pRange->mSize > largest ? pRange->mSize : largest;
+	return largest;
+}
+
+static float get_fragmentation(uint64_t largestFreeRange, uint64_t freeBytes)
+{
+	return freeBytes ? 1.0f - (float)((double)largestFreeRange / (double)freeBytes) : 0.0f;
+}
+
+void getTlsfBlockStats(const TlsfBlock* pBlock, TlsfBlockStats* pStats)
+{
+	ASSERT(pBlock && pStats);
+
+	pStats->mUsedBytes = pBlock->mSize - pBlock->mFreeBytes;
+	pStats->mFreeBytes = pBlock->mFreeBytes;
+	pStats->mLargestFreeRange = get_largest_free_range(pBlock);
+	pStats->mAllocationCount = pBlock->mAllocationCount;
+	pStats->mFreeRangeCount = pBlock->mFreeLists.GetCount();
+	pStats->mFragmentation = get_fragmentation(pStats->mLargestFreeRange, pStats->mFreeBytes);
+}
+
+bool validateTlsfBlock(const TlsfBlock* pBlock)
+{
+	ASSERT(pBlock);
+
+	if (!pBlock->pFirstRange || pBlock->pFirstRange->pPrevPhysical || pBlock->pLastRange->pNextPhysical)
+		return false;
+
+	uint64_t offset = 0;
+	uint64_t freeBytes = 0;
+	uint32_t freeCount = 0;
+	uint32_t allocationCount = 0;
+	const TlsfRange* pPrev = NULL;
+	for (const TlsfRange* pRange = pBlock->pFirstRange; pRange; pRange = pRange->pNextPhysical)
+	{
+		// Ranges must tile the block, free neighbours must have been merged
+		if (pRange->mOffset != offset || !pRange->mSize || pRange->pPrevPhysical != pPrev)
+			return false;
+		if (pPrev && pPrev->mFree && pRange->mFree)
+			return false;
+
+		if (pRange->mFree)
+		{
+			freeBytes += pRange->mSize;
+			++freeCount;
+		}
+		else
+		{
+			++allocationCount;
+		}
+
+		offset += pRange->mSize;
+		pPrev = pRange;
+	}
+
+	return pPrev == pBlock->pLastRange &&
+		offset == pBlock->mSize &&
+		freeBytes == pBlock->mFreeBytes &&
+		freeCount == pBlock->mFreeLists.GetCount() &&
+		allocationCount == pBlock->mAllocationCount &&
+		pBlock->mFreeLists.Validate();
+}
+
+/************************************************************************/
+// Defragmentation planning
+/************************************************************************/
+struct DefragSortEntry
+{
+	uint64_t	mKey;
+	uint64_t	mOffset;
+	uint32_t	mIndex;
+};
+
+// Ascending key, then descending offset
+static int CompareDefragEntries(const void* pLhs, const void* pRhs)
+{
+	const DefragSortEntry* pA = (const DefragSortEntry*)pLhs;
+	const DefragSortEntry* pB = (const DefragSortEntry*)pRhs;
+	if (pA->mKey != pB->mKey)
+		return pA->mKey < pB->mKey ? -1 : 1;
+	if (pA->mOffset != pB->mOffset)
+		return pA->mOffset > pB->mOffset ? -1 : 1;
+	return pA->mIndex < pB->mIndex ? -1 : (pA->mIndex > pB->mIndex ? 1 : 0);
+}
+
+// Free bytes outside the largest range of their block over all free bytes. Emptied blocks count as unfragmented
+static float get_heap_fragmentation(TlsfBlock* const* ppBlocks, uint32_t blockCount)
+{
+	uint64_t freeBytes = 0;
+	uint64_t largestSum = 0;
+	for (uint32_t i = 0; i < blockCount; ++i)
+	{
+		largestSum += get_largest_free_range(ppBlocks[i]);
+		freeBytes += ppBlocks[i]->mFreeBytes;
+	}
+	return get_fragmentation(largestSum, freeBytes);
+}
+
+// Lowest offset range below maxOffset that fits, so allocations only ever move down inside a block
+static TlsfRange* find_lower_range(TlsfBlock* pBlock, uint64_t size, uint64_t alignment, uint64_t maxOffset)
+{
+	for (TlsfRange* pRange = pBlock->pFirstRange; pRange && pRange->mOffset < maxOffset; pRange = pRange->pNextPhysical)
+	{
+		if (pRange->mFree && range_fits(pRange, size, alignment) && align_up(pRange->mOffset, alignment) < maxOffset)
+			return pRange;
+	}
+	return NULL;
+}
+
+void planDefragmentation(const DefragmentationPlanDesc* pDesc, tinystl::vector<DefragmentationMove>* pMoves, DefragmentationStats* pStats)
+{
+	ASSERT(pDesc && pMoves && pStats);
+	ASSERT(pDesc->pBlockSizes || !pDesc->mBlockCount);
+	ASSERT(pDesc->pAllocations || !pDesc->mAllocationCount);
+
+	const uint32_t blockCount = pDesc->mBlockCount;
+	const uint32_t allocationCount = pDesc->mAllocationCount;
+	pMoves->clear();
+	memset(pStats, 0, sizeof(DefragmentationStats));
+	if (!blockCount)
+		return;
+
+	// Mirror the heap: allocations sorted by block, placed in increasing offset order
+	tinystl::vector<TlsfBlock*> blocks(blockCount);
+	for (uint32_t i = 0; i < blockCount; ++i)
+	{
+		blocks[i] = conf_placement_new<TlsfBlock>(conf_calloc(1, sizeof(TlsfBlock)));
+		initTlsfBlock(blocks[i], pDesc->pBlockSizes[i]);
+	}
+
+	tinystl::vector<DefragSortEntry> order(allocationCount);
+	for (uint32_t i = 0; i < allocationCount; ++i)
+	{
+		const DefragmentationAllocation& allocation = pDesc->pAllocations[i];
+		ASSERT(allocation.mBlockIndex < blockCount);
+		order[i].mKey = allocation.mBlockIndex;
+		// Complemented so the descending offset order of the comparison places them front to back
+		order[i].mOffset = ~allocation.mOffset;
+		order[i].mIndex = i;
+	}
+	if (allocationCount)
+		qsort(order.data(), order.size(), sizeof(DefragSortEntry), CompareDefragEntries);
+
+	tinystl::vector<TlsfRange*> ranges(allocationCount);
+	for (uint32_t i = 0; i < allocationCount; ++i)
+	{
+		const DefragmentationAllocation& allocation = pDesc->pAllocations[order[i].mIndex];
+		ranges[order[i].mIndex] = tlsfAllocateAt(blocks[allocation.mBlockIndex], allocation.mOffset, allocation.mSize, NULL);
+	}
+
+	pStats->mFragmentationBefore = get_heap_fragmentation(blocks.data(), blockCount);
+
+	// Most used blocks first. Blocks are emptied from the back into the ones in front of them
+	tinystl::vector<DefragSortEntry> blockOrder(blockCount);
+	tinystl::vector<bool> wasUsed(blockCount);
+	for (uint32_t i = 0; i < blockCount; ++i)
+	{
+		blockOrder[i].mKey = blocks[i]->mFreeBytes;
+		blockOrder[i].mOffset = 0;
+		blockOrder[i].mIndex = i;
+		wasUsed[i] = blocks[i]->mAllocationCount != 0;
+	}
+	qsort(blockOrder.data(), blockOrder.size(), sizeof(DefragSortEntry), CompareDefragEntries);
+
+	// Movable allocations of each block, highest offset first
+	tinystl::vector<DefragSortEntry> candidates;
+	tinystl::vector<bool> hasPinned(blockCount);
+	for (uint32_t i = 0; i < allocationCount; ++i)
+	{
+		const DefragmentationAllocation& allocation = pDesc->pAllocations[i];
+		if (!allocation.mMovable || !ranges[i])
+		{
+			hasPinned[allocation.mBlockIndex] = true;
+			continue;
+		}
+		DefragSortEntry entry = { allocation.mBlockIndex, allocation.mOffset, i };
+		candidates.push_back(entry);
+	}
+	if (!candidates.empty())
+		qsort(candidates.data(), candidates.size(), sizeof(DefragSortEntry), CompareDefragEntries);
+
+	tinystl::vector<uint32_t> firstCandidate(blockCount + 1, (uint32_t)candidates.size());
+	for (uint32_t i = (uint32_t)candidates.size(); i--; )
+		firstCandidate[(uint32_t)candidates[i].mKey] = i;
+	for (uint32_t i = blockCount; i--; )
+		firstCandidate[i] = firstCandidate[i] < firstCandidate[i + 1] ? firstCandidate[i] : firstCandidate[i + 1];
+
+	bool budgetLeft = true;
+	for (uint32_t srcOrder = blockCount; srcOrder-- && budgetLeft; )
+	{
+		const uint32_t srcIndex = blockOrder[srcOrder].mIndex;
+		TlsfBlock* pSrc = blocks[srcIndex];
+		// A block which keeps an immovable allocation can never be released. Moving only part of it into the holes
+		// of other blocks trades their free space for new holes in this one, so it is only compacted in place
+		const uint32_t dstOrderEnd = hasPinned[srcIndex] ? 0 : srcOrder;
+
+		for (uint32_t c = firstCandidate[srcIndex]; c < firstCandidate[srcIndex + 1]; ++c)
+		{
+			if (pDesc->mMaxMoves && pStats->mMoveCount >= pDesc->mMaxMoves)
+			{
+				budgetLeft = false;
+				break;
+			}
+
+			const uint32_t allocationIndex = candidates[c].mIndex;
+			const DefragmentationAllocation& allocation = pDesc->pAllocations[allocationIndex];
+			if (pDesc->mMaxBytesToMove && pStats->mBytesMoved + allocation.mSize > pDesc->mMaxBytesToMove)
+				continue;
+
+			const uint64_t alignment = allocation.mAlignment ? allocation.mAlignment : 1;
+			TlsfRange* pDst = NULL;
+			uint32_t dstIndex = srcIndex;
+			for (uint32_t dstOrder = 0; dstOrder < dstOrderEnd && !pDst; ++dstOrder)
+			{
+				dstIndex = blockOrder[dstOrder].mIndex;
+				pDst = tlsfAllocate(blocks[dstIndex], allocation.mSize, alignment, allocation.pUserData);
+			}
+
+			if (!pDst)
+			{
+				dstIndex = srcIndex;
+				TlsfRange* pLower = find_lower_range(pSrc, allocation.mSize, alignment, ranges[allocationIndex]->mOffset);
+				if (pLower)
+					pDst = carve_range(pSrc, pLower, align_up(pLower->mOffset, alignment), allocation.mSize, allocation.pUserData);
+			}
+
+			if (!pDst)
+				continue;
+
+			DefragmentationMove move = {};
+			move.mSrcBlockIndex = srcIndex;
+			move.mDstBlockIndex = dstIndex;
+			move.mSrcOffset = ranges[allocationIndex]->mOffset;
+			move.mDstOffset = pDst->mOffset;
+			move.mSize = allocation.mSize;
+			move.pUserData = allocation.pUserData;
+			pMoves->push_back(move);
+
+			tlsfFree(pSrc, ranges[allocationIndex]);
+			ranges[allocationIndex] = pDst;
+			pStats->mBytesMoved += allocation.mSize;
+			++pStats->mMoveCount;
+		}
+	}
+
+	pStats->mFragmentationAfter = get_heap_fragmentation(blocks.data(), blockCount);
+	for (uint32_t i = 0; i < blockCount; ++i)
+	{
+		if (wasUsed[i] && !blocks[i]->mAllocationCount)
+			++pStats->mBlocksFreed;
+		exitTlsfBlock(blocks[i]);
+		blocks[i]->~TlsfBlock();
+		conf_free(blocks[i]);
+	}
+}
@@ -0,0 +1,365 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "../ThirdParty/OpenSource/TinySTL/vector.h"
+#include "../OS/Interfaces/ILogManager.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/************************************************************************/
+// Two-level segregated fit (TLSF) free lists
+/************************************************************************/
+/// Free ranges are binned by size. The first level is the index of the highest set bit, the second level splits
+/// every power of two into TLSF_SL_COUNT linear steps. Sizes below TLSF_SL_COUNT get one bin each.
+/// A bitmap per level makes finding the first non-empty bin for a size a couple of bit scans.
+#define TLSF_SL_INDEX_BITS 4
+#define TLSF_SL_COUNT (1u << TLSF_SL_INDEX_BITS)
+#define TLSF_FL_COUNT (64 - TLSF_SL_INDEX_BITS + 1)
+
+static inline uint32_t tlsfFindMsb(uint64_t value)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return (uint32_t)index;
+#else
+	return 63u - (uint32_t)__builtin_clzll(value);
+#endif
+}
+
+static inline uint32_t tlsfFindLsb(uint64_t value)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return (uint32_t)index;
+#else
+	return (uint32_t)__builtin_ctzll(value);
+#endif
+}
+
+/// Bin holding a free range of this size
+static inline void tlsfMapInsert(uint64_t size, uint32_t* pFl, uint32_t* pSl)
+{
+	if (size < TLSF_SL_COUNT)
+	{
+		*pFl = 0;
+		*pSl = (uint32_t)size;
+		return;
+	}
+
+	const uint32_t msb = tlsfFindMsb(size);
+	*pFl = msb - TLSF_SL_INDEX_BITS + 1;
+	*pSl = (uint32_t)(size >> (msb - TLSF_SL_INDEX_BITS)) ^ TLSF_SL_COUNT;
+}
+
+/// First bin whose ranges are all at least this size
+static inline void tlsfMapSearch(uint64_t size, uint32_t* pFl, uint32_t* pSl)
+{
+	if (size >= TLSF_SL_COUNT)
+	{
+		const uint64_t round = (1ull << (tlsfFindMsb(size) - TLSF_SL_INDEX_BITS)) - 1;
+		size = (size > UINT64_MAX - round) ? UINT64_MAX : size + round;
+	}
+	tlsfMapInsert(size, pFl, pSl);
+}
+
+/// Intrusive free lists over nodes owned by the caller. Traits must provide
+///   typedef ... Node;
+///   static uint64_t GetSize(const Node*);
+///   static Node* GetPrevFree(const Node*);  static void SetPrevFree(Node*, Node*);
+///   static Node* GetNextFree(const Node*);  static void SetNextFree(Node*, Node*);
+/// The size of a node must not change while it is inserted.
+template <typename Traits>
+class TlsfFreeLists
+{
+public:
+	typedef typename Traits::Node Node;
+
+	TlsfFreeLists() { Reset(); }
+
+	void Reset()
+	{
+		mFlBitmap = 0;
+		mCount = 0;
+		memset(mSlBitmaps, 0, sizeof(mSlBitmaps));
+		memset(mHeads, 0, sizeof(mHeads));
+	}
+
+	void Insert(Node* pNode)
+	{
+		uint32_t fl, sl;
+		tlsfMapInsert(Traits::GetSize(pNode), &fl, &sl);
+
+		Node* pHead = mHeads[fl][sl];
+		Traits::SetPrevFree(pNode, NULL);
+		Traits::SetNextFree(pNode, pHead);
+		if (pHead)
+			Traits::SetPrevFree(pHead, pNode);
+		mHeads[fl][sl] = pNode;
+		mFlBitmap |= 1ull << fl;
+		mSlBitmaps[fl] |= 1u << sl;
+		++mCount;
+	}
+
+	void Remove(Node* pNode)
+	{
+		uint32_t fl, sl;
+		tlsfMapInsert(Traits::GetSize(pNode), &fl, &sl);
+
+		Node* pPrev = Traits::GetPrevFree(pNode);
+		Node* pNext = Traits::GetNextFree(pNode);
+		if (pNext)
+			Traits::SetPrevFree(pNext, pPrev);
+		if (pPrev)
+		{
+			Traits::SetNextFree(pPrev, pNext);
+		}
+		else
+		{
+			ASSERT(mHeads[fl][sl] == pNode);
+			mHeads[fl][sl] = pNext;
+			if (!pNext)
+			{
+				mSlBitmaps[fl] &= ~(1u << sl);
+				if (!mSlBitmaps[fl])
+					mFlBitmap &= ~(1ull << fl);
+			}
+		}
+		Traits::SetPrevFree(pNode, NULL);
+		Traits::SetNextFree(pNode, NULL);
+		--mCount;
+	}
+
+	/// Moves (fl, sl) to the first non-empty bin at or above it. Returns false if there is none
+	bool FindBin(uint32_t* pFl, uint32_t* pSl) const
+	{
+		if (*pFl >= TLSF_FL_COUNT)
+			return false;
+
+		uint32_t slMap = (*pSl < TLSF_SL_COUNT) ? (mSlBitmaps[*pFl] & (~0u << *pSl)) : 0;
+		if (!slMap)
+		{
+			const uint64_t flMap = (*pFl + 1 < 64) ? (mFlBitmap & (~0ull << (*pFl + 1))) : 0;
+			if (!flMap)
+				return false;
+			*pFl = tlsfFindLsb(flMap);
+			slMap = mSlBitmaps[*pFl];
+		}
+		*pSl = tlsfFindLsb(slMap);
+		return true;
+	}
+
+	/// Moves (fl, sl) to the last non-empty bin at or below it. Returns false if there is none
+	bool FindBinReverse(uint32_t* pFl, uint32_t* pSl) const
+	{
+		uint32_t slMap = mSlBitmaps[*pFl] & (0xFFFFFFFFu >> (31 - *pSl));
+		if (!slMap)
+		{
+			const uint64_t flMap = *pFl ? (mFlBitmap & ((1ull << *pFl) - 1)) : 0;
+			if (!flMap)
+				return false;
+			*pFl = tlsfFindMsb(flMap);
+			slMap = mSlBitmaps[*pFl];
+		}
+		*pSl = tlsfFindMsb(slMap);
+		return true;
+	}
+
+	/// Returns a free node of at least size bytes in constant time, or NULL. Not necessarily the best fit
+	Node* FindFree(uint64_t size) const
+	{
+		uint32_t fl, sl;
+		tlsfMapSearch(size, &fl, &sl);
+		return FindBin(&fl, &sl) ? mHeads[fl][sl] : NULL;
+	}
+
+	/// Highest non-empty bin. Returns false when the lists are empty
+	bool GetLastBin(uint32_t* pFl, uint32_t* pSl) const
+	{
+		if (!mFlBitmap)
+			return false;
+		*pFl = tlsfFindMsb(mFlBitmap);
+		*pSl = tlsfFindMsb(mSlBitmaps[*pFl]);
+		return true;
+	}
+
+	Node* GetHead(uint32_t fl, uint32_t sl) const { return mHeads[fl][sl]; }
+	uint32_t GetCount() const { return mCount; }
+
+	/// Checks bitmaps, links and that every node sits in the bin of its size
+	bool Validate() const
+	{
+		uint32_t count = 0;
+		for (uint32_t fl = 0; fl < TLSF_FL_COUNT; ++fl)
+		{
+			if (((mFlBitmap >> fl) & 1) != (mSlBitmaps[fl] ? 1u : 0u))
+				return false;
+
+			for (uint32_t sl = 0; sl < TLSF_SL_COUNT; ++sl)
+			{
+				if (((mSlBitmaps[fl] >> sl) & 1) != (mHeads[fl][sl] ? 1u : 0u))
+					return false;
+
+				const Node* pPrev = NULL;
+				for (const Node* pNode = mHeads[fl][sl]; pNode; pNode = Traits::GetNextFree(pNode))
+				{
+					uint32_t nodeFl, nodeSl;
+					tlsfMapInsert(Traits::GetSize(pNode), &nodeFl, &nodeSl);
+					if (nodeFl != fl || nodeSl != sl || Traits::GetPrevFree(pNode) != pPrev)
+						return false;
+					pPrev = pNode;
+					++count;
+				}
+			}
+		}
+		return count == mCount;
+	}
+
+private:
+	uint64_t	mFlBitmap;
+	uint32_t	mSlBitmaps[TLSF_FL_COUNT];
+	Node*		mHeads[TLSF_FL_COUNT][TLSF_SL_COUNT];
+	uint32_t	mCount;
+};
+
+/************************************************************************/
+// Standalone block metadata
+/************************************************************************/
+/// Offset-only suballocator for a block of any size. Nothing is read or written through the offsets, so it is
+/// used to simulate heaps on the CPU (defragmentation planning, allocator stress tests) on every platform.
+typedef struct TlsfRange
+{
+	uint64_t			mOffset;
+	uint64_t			mSize;
+	struct TlsfRange*	pPrevPhysical;
+	struct TlsfRange*	pNextPhysical;
+	struct TlsfRange*	pPrevFree;
+	struct TlsfRange*	pNextFree;
+	void*				pUserData;
+	bool				mFree;
+} TlsfRange;
+
+struct TlsfRangeTraits
+{
+	typedef TlsfRange Node;
+	static uint64_t GetSize(const TlsfRange* pRange) { return pRange->mSize; }
+	static TlsfRange* GetPrevFree(const TlsfRange* pRange) { return pRange->pPrevFree; }
+	static TlsfRange* GetNextFree(const TlsfRange* pRange) { return pRange->pNextFree; }
+	static void SetPrevFree(TlsfRange* pRange, TlsfRange* pPrev) { pRange->pPrevFree = pPrev; }
+	static void SetNextFree(TlsfRange* pRange, TlsfRange* pNext) { pRange->pNextFree = pNext; }
+};
+
+typedef struct TlsfBlock
+{
+	uint64_t						mSize;
+	uint64_t						mFreeBytes;
+	uint32_t						mAllocationCount;
+	TlsfRange*						pFirstRange;
+	TlsfRange*						pLastRange;
+	/// Unused range structs, linked through pNextFree
+	TlsfRange*						pRangePool;
+	tinystl::vector<TlsfRange*>		mRangeChunks;
+	TlsfFreeLists<TlsfRangeTraits>	mFreeLists;
+} TlsfBlock;
+
+typedef struct TlsfBlockStats
+{
+	uint64_t	mUsedBytes;
+	uint64_t	mFreeBytes;
+	uint64_t	mLargestFreeRange;
+	uint32_t	mAllocationCount;
+	uint32_t	mFreeRangeCount;
+	/// 1 - largest free range / free bytes. 0 when all free memory is one range
+	float		mFragmentation;
+} TlsfBlockStats;
+
+void initTlsfBlock(TlsfBlock* pBlock, uint64_t size);
+void exitTlsfBlock(TlsfBlock* pBlock);
+/// Constant time unless the only ranges that fit need alignment padding and are smaller than size + alignment - 1.
+/// Returns NULL if the block has no room
+TlsfRange* tlsfAllocate(TlsfBlock* pBlock, uint64_t size, uint64_t alignment, void* pUserData);
+/// Places an allocation at a known offset, the range must be free. Fastest when called in increasing offset order
+TlsfRange* tlsfAllocateAt(TlsfBlock* pBlock, uint64_t offset, uint64_t size, void* pUserData);
+/// Constant time, merges with free neighbours
+void tlsfFree(TlsfBlock* pBlock, TlsfRange* pRange);
+void getTlsfBlockStats(const TlsfBlock* pBlock, TlsfBlockStats* pStats);
+bool validateTlsfBlock(const TlsfBlock* pBlock);
+
+/************************************************************************/
+// Defragmentation planning
+/************************************************************************/
+typedef struct DefragmentationAllocation
+{
+	uint32_t	mBlockIndex;
+	uint64_t	mOffset;
+	uint64_t	mSize;
+	/// Power of two
+	uint64_t	mAlignment;
+	void*		pUserData;
+	bool		mMovable;
+} DefragmentationAllocation;
+
+typedef struct DefragmentationPlanDesc
+{
+	const uint64_t*						pBlockSizes;
+	uint32_t							mBlockCount;
+	const DefragmentationAllocation*	pAllocations;
+	uint32_t							mAllocationCount;
+	/// 0 means no limit
+	uint64_t							mMaxBytesToMove;
+	uint32_t							mMaxMoves;
+} DefragmentationPlanDesc;
+
+typedef struct DefragmentationMove
+{
+	uint32_t	mSrcBlockIndex;
+	uint32_t	mDstBlockIndex;
+	uint64_t	mSrcOffset;
+	uint64_t	mDstOffset;
+	uint64_t	mSize;
+	void*		pUserData;
+} DefragmentationMove;
+
+typedef struct DefragmentationStats
+{
+	uint64_t	mBytesMoved;
+	uint32_t	mMoveCount;
+	/// Blocks the moves empty completely, they can be released once the moves are done
+	uint32_t	mBlocksFreed;
+	/// 1 - sum of the largest free range of every block / free bytes of all blocks
+	float		mFragmentationBefore;
+	float		mFragmentationAfter;
+} DefragmentationStats;
+
+/// Plans moves that empty the least used blocks into holes of the more used ones and compact every block towards
+/// offset 0. Blocks holding an immovable allocation are only compacted in place. Nothing is copied. The moves must be executed in order: a destination can be memory that an earlier
+/// move vacated, but it never overlaps the source of the same move.
+void planDefragmentation(const DefragmentationPlanDesc* pDesc, tinystl::vector<DefragmentationMove>* pMoves, DefragmentationStats* pStats);
@@ -0,0 +1,1028 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#if defined(VULKAN) || defined(NULL_RENDERER)
+
+#include "SpirvReflector.h"
+
+#include <string.h>
+#include <ctype.h>
+
+#include "../../ThirdParty/OpenSource/SPIRV_Cross/spirv.hpp"
+#include "../../ThirdParty/OpenSource/TinySTL/vector.h"
+#include "../../ThirdParty/OpenSource/TinySTL/unordered_map.h"
+#include "../../ThirdParty/OpenSource/TinySTL/unordered_set.h"
+#include "../../OS/Interfaces/ILogManager.h"
+#include "../../OS/Interfaces/IMemoryManager.h"
+
+// Minimal SPIR-V module walker.
+// Only the subset of the module required for resource reflection is decoded: names, decorations, types,
+// global variables, scalar constants, entry points / execution modes and the instruction streams of the functions
+// reachable from the entry point. The classification rules follow SPIRV-Cross so both reflection paths agree.
+
+enum SpirvBaseType
+{
+	SPIRV_BASE_TYPE_UNKNOWN = 0,
+	SPIRV_BASE_TYPE_VOID,
+	SPIRV_BASE_TYPE_BOOLEAN,
+	SPIRV_BASE_TYPE_NUMERIC,
+	SPIRV_BASE_TYPE_ATOMIC_COUNTER,
+	SPIRV_BASE_TYPE_IMAGE,
+	SPIRV_BASE_TYPE_SAMPLED_IMAGE,
+	SPIRV_BASE_TYPE_SAMPLER,
+	SPIRV_BASE_TYPE_STRUCT,
+};
+
+enum SpirvIdKind
+{
+	SPIRV_ID_NONE = 0,
+	SPIRV_ID_TYPE,
+	SPIRV_ID_VARIABLE,
+	SPIRV_ID_CONSTANT,
+	SPIRV_ID_FUNCTION,
+};
+
+// Composite types inherit every field from the type they are built from, including mSelf for pointers and arrays.
+// This way decorations of the underlying struct can be found from a pointer-to-array-of-struct type
+struct SpirvType
+{
+	uint32_t	mBaseType;
+	uint32_t	mWidth;
+	uint32_t	mVecSize;
+	uint32_t	mColumns;
+	uint32_t	mSelf;
+	uint32_t	mStorage;
+	uint32_t	mImageDim;
+	uint32_t	mImageSampled;
+	uint32_t	mFirstMember;
+	uint32_t	mMemberCount;
+	uint32_t	mFirstArrayDim;
+	uint32_t	mArrayDimCount;
+	bool		mPointer;
+};
+
+struct SpirvDecoration
+{
+	uint64_t	mFlags;
+	uint32_t	mSet;
+	uint32_t	mBinding;
+	uint32_t	mLocation;
+	uint32_t	mOffset;
+	uint32_t	mArrayStride;
+	uint32_t	mMatrixStride;
+	uint32_t	mNameOffset;
+	uint32_t	mNameSize;
+};
+
+struct SpirvId
+{
+	uint32_t		mKind;
+	// Type index for types, pointer type id for variables, scalar value for constants, body offset for functions
+	uint32_t		mData;
+	// Storage class for variables, specialization flag for constants, body end for functions
+	uint32_t		mData2;
+	SpirvDecoration	mDecoration;
+};
+
+struct SpirvEntryPoint
+{
+	uint32_t	mFunction;
+	uint32_t	mNameOffset;
+	uint32_t	mNameSize;
+	uint32_t	mFirstInterface;
+	uint32_t	mInterfaceCount;
+	uint32_t	mWorkGroupSize[3];
+	uint32_t	mOutputVertexCount;
+};
+
+struct SpirvModule
+{
+	const uint32_t*								pCode;
+	uint32_t									mWordCount;
+	uint32_t									mBound;
+	SpirvId*									pIds;
+	tinystl::vector<SpirvType>					mTypes;
+	tinystl::vector<uint32_t>					mMemberTypes;
+	tinystl::vector<uint32_t>					mArrayDims;
+	tinystl::vector<uint32_t>					mInterfaces;
+	tinystl::vector<SpirvEntryPoint>			mEntryPoints;
+	tinystl::vector<char>						mNames;
+	// Key is (struct id << 32) | member index
+	tinystl::unordered_map<uint64_t, SpirvDecoration>	mMemberDecorations;
+};
+
+static const uint64_t SPIRV_DECORATION_BUILTIN_BIT = 1ull << spv::DecorationBuiltIn;
+
+static inline bool spirv_is_interface_storage(uint32_t storage)
+{
+	switch (storage)
+	{
+	case spv::StorageClassInput:
+	case spv::StorageClassOutput:
+	case spv::StorageClassUniform:
+	case spv::StorageClassUniformConstant:
+	case spv::StorageClassAtomicCounter:
+	case spv::StorageClassPushConstant:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void spirv_set_decoration(SpirvDecoration* pDecoration, uint32_t decoration, uint32_t argument)
+{
+	// Vendor decorations are numbered in the thousands and are of no interest for reflection
+	if (decoration >= 64)
+		return;
+
+	pDecoration->mFlags |= 1ull << decoration;
+	switch (decoration)
+	{
+	case spv::DecorationDescriptorSet: pDecoration->mSet = argument; break;
+	case spv::DecorationBinding: pDecoration->mBinding = argument; break;
+	case spv::DecorationLocation: pDecoration->mLocation = argument; break;
+	case spv::DecorationOffset: pDecoration->mOffset = argument; break;
+	case spv::DecorationArrayStride: pDecoration->mArrayStride = argument; break;
+	case spv::DecorationMatrixStride: pDecoration->mMatrixStride = argument; break;
+	default: break;
+	}
+}
+
+// Literal strings are nul terminated and padded to a whole number of words
+static const char* spirv_read_string(const SpirvModule* pModule, uint32_t wordOffset, uint32_t wordEnd, uint32_t* pLength, uint32_t* pWordCount)
+{
+	const char* pString = (const char*)(pModule->pCode + wordOffset);
+	const uint32_t maxLength = (wordEnd - wordOffset) * sizeof(uint32_t);
+	uint32_t length = 0;
+	while (length < maxLength && pString[length])
+		++length;
+
+	*pLength = length;
+	*pWordCount = (length + 1 + 3) / 4;
+	return pString;
+}
+
+// Same sanitization SPIRV-Cross applies to OpName / OpMemberName so names compare equal across both paths
+static void spirv_set_name(SpirvModule* pModule, const char* pName, uint32_t length, uint32_t* pNameOffset, uint32_t* pNameSize)
+{
+	*pNameOffset = 0;
+	*pNameSize = 0;
+
+	// Names of the form _<digit>... are reserved for temporaries
+	if (length == 0 || (pName[0] == '_' && length >= 2 && isdigit((unsigned char)pName[1])))
+		return;
+
+	// glslang mangles function names as name(<signature>
+	for (uint32_t i = 0; i < length; ++i)
+	{
+		if (pName[i] == '(')
+		{
+			length = i;
+			break;
+		}
+	}
+
+	*pNameOffset = (uint32_t)pModule->mNames.size();
+	*pNameSize = length;
+	for (uint32_t i = 0; i < length; ++i)
+	{
+		char c = pName[i];
+		if (i == 0 || (pName[0] == '_' && i == 1))
+			c = isalpha((unsigned char)c) ? c : '_';
+		else
+			c = isalnum((unsigned char)c) ? c : '_';
+		pModule->mNames.push_back(c);
+	}
+}
+
+static SpirvDecoration* spirv_get_member_decoration(SpirvModule* pModule, uint32_t id, uint32_t member)
+{
+	const uint64_t key = ((uint64_t)id << 32) | member;
+	tinystl::unordered_hash_node<uint64_t, SpirvDecoration>* pNode = pModule->mMemberDecorations.find(key).node;
+	if (pNode)
+		return &pNode->second;
+
+	SpirvDecoration decoration = {};
+	return &pModule->mMemberDecorations.insert({ key, decoration }).first.node->second;
+}
+
+static const SpirvDecoration* spirv_find_member_decoration(const SpirvModule* pModule, uint32_t id, uint32_t member)
+{
+	const uint64_t key = ((uint64_t)id << 32) | member;
+	const tinystl::unordered_hash_node<uint64_t, SpirvDecoration>* pNode = pModule->mMemberDecorations.find(key).node;
+	return pNode ? &pNode->second : NULL;
+}
+
+static const SpirvType* spirv_get_type(const SpirvModule* pModule, uint32_t id)
+{
+	if (id >= pModule->mBound || pModule->pIds[id].mKind != SPIRV_ID_TYPE)
+		return NULL;
+	return &pModule->mTypes[pModule->pIds[id].mData];
+}
+
+// Creates the type id as a copy of its base type - the SPIR-V equivalent of inheritance for composite types
+static SpirvType* spirv_add_type(SpirvModule* pModule, uint32_t id, uint32_t baseId)
+{
+	if (id >= pModule->mBound)
+		return NULL;
+
+	SpirvType type = {};
+	const SpirvType* pBase = baseId ? spirv_get_type(pModule, baseId) : NULL;
+	if (pBase)
+		type = *pBase;
+	else
+		type.mSelf = id;
+
+	pModule->pIds[id].mKind = SPIRV_ID_TYPE;
+	pModule->pIds[id].mData = (uint32_t)pModule->mTypes.size();
+	pModule->mTypes.push_back(type);
+	return &pModule->mTypes.back();
+}
+
+static void spirv_add_array_dim(SpirvModule* pModule, SpirvType* pType, uint32_t dim)
+{
+	const uint32_t first = (uint32_t)pModule->mArrayDims.size();
+	for (uint32_t i = 0; i < pType->mArrayDimCount; ++i)
+		pModule->mArrayDims.push_back(pModule->mArrayDims[pType->mFirstArrayDim + i]);
+	pModule->mArrayDims.push_back(dim);
+	pType->mFirstArrayDim = first;
+	++pType->mArrayDimCount;
+}
+
+static bool spirv_parse_module(SpirvModule* pModule)
+{
+	const uint32_t* pCode = pModule->pCode;
+	uint32_t currentFunction = 0;
+	uint32_t offset = 5;
+
+	while (offset < pModule->mWordCount)
+	{
+		const uint32_t op = pCode[offset] & 0xffff;
+		const uint32_t count = pCode[offset] >> 16;
+		if (count == 0 || offset + count > pModule->mWordCount)
+		{
+			LOGERRORF("SPIR-V reflection : Malformed instruction at word %u", offset);
+			return false;
+		}
+
+		const uint32_t* ops = pCode + offset + 1;
+		const uint32_t length = count - 1;
+		const uint32_t end = offset + count;
+
+		switch (op)
+		{
+		case spv::OpEntryPoint:
+		{
+			if (length < 3)
+				return false;
+			SpirvEntryPoint entry = {};
+			entry.mFunction = ops[1];
+			uint32_t nameLength = 0, nameWords = 0;
+			const char* pName = spirv_read_string(pModule, offset + 3, end, &nameLength, &nameWords);
+			entry.mNameOffset = (uint32_t)pModule->mNames.size();
+			entry.mNameSize = nameLength;
+			pModule->mNames.insert(pModule->mNames.end(), pName, pName + nameLength);
+			entry.mFirstInterface = (uint32_t)pModule->mInterfaces.size();
+			for (uint32_t i = 2 + nameWords; i < length; ++i)
+				pModule->mInterfaces.push_back(ops[i]);
+			entry.mInterfaceCount = (uint32_t)pModule->mInterfaces.size() - entry.mFirstInterface;
+			pModule->mEntryPoints.push_back(entry);
+			break;
+		}
+		case spv::OpExecutionMode:
+		{
+			if (length < 2)
+				return false;
+			for (uint32_t i = 0; i < (uint32_t)pModule->mEntryPoints.size(); ++i)
+			{
+				SpirvEntryPoint* pEntry = &pModule->mEntryPoints[i];
+				if (pEntry->mFunction != ops[0])
+					continue;
+				if (ops[1] == spv::ExecutionModeLocalSize && length >= 5)
+				{
+					pEntry->mWorkGroupSize[0] = ops[2];
+					pEntry->mWorkGroupSize[1] = ops[3];
+					pEntry->mWorkGroupSize[2] = ops[4];
+				}
+				else if (ops[1] == spv::ExecutionModeOutputVertices && length >= 3)
+				{
+					pEntry->mOutputVertexCount = ops[2];
+				}
+			}
+			break;
+		}
+		case spv::OpName:
+		{
+			if (length < 1 || ops[0] >= pModule->mBound)
+				break;
+			uint32_t nameLength = 0, nameWords = 0;
+			const char* pName = spirv_read_string(pModule, offset + 2, end, &nameLength, &nameWords);
+			SpirvDecoration* pDecoration = &pModule->pIds[ops[0]].mDecoration;
+			spirv_set_name(pModule, pName, nameLength, &pDecoration->mNameOffset, &pDecoration->mNameSize);
+			break;
+		}
+		case spv::OpMemberName:
+		{
+			if (length < 2)
+				break;
+			uint32_t nameLength = 0, nameWords = 0;
+			const char* pName = spirv_read_string(pModule, offset + 3, end, &nameLength, &nameWords);
+			SpirvDecoration* pDecoration = spirv_get_member_decoration(pModule, ops[0], ops[1]);
+			spirv_set_name(pModule, pName, nameLength, &pDecoration->mNameOffset, &pDecoration->mNameSize);
+			break;
+		}
+		case spv::OpDecorate:
+		{
+			if (length < 2 || ops[0] >= pModule->mBound)
+				break;
+			spirv_set_decoration(&pModule->pIds[ops[0]].mDecoration, ops[1], length >= 3 ? ops[2] : 0);
+			break;
+		}
+		case spv::OpMemberDecorate:
+		{
+			if (length < 3)
+				break;
+			spirv_set_decoration(spirv_get_member_decoration(pModule, ops[0], ops[1]), ops[2], length >= 4 ? ops[3] : 0);
+			break;
+		}
+		case spv::OpTypeVoid:
+		{
+			SpirvType* pType = spirv_add_type(pModule, ops[0], 0);
+			if (pType)
+				pType->mBaseType = SPIRV_BASE_TYPE_VOID;
+			break;
+		}
+		case spv::OpTypeBool:
+		{
+			SpirvType* pType = spirv_add_type(pModule, ops[0], 0);
+			if (pType)
+			{
+				pType->mBaseType = SPIRV_BASE_TYPE_BOOLEAN;
+				pType->mWidth = 1;
+			}
+			break;
+		}
+		case spv::OpTypeInt:
+		case spv::OpTypeFloat:
+		{
+			SpirvType* pType = spirv_add_type(pModule, ops[0], 0);
+			if (pType)
+			{
+				pType->mBaseType = SPIRV_BASE_TYPE_NUMERIC;
+				pType->mWidth = ops[1];
+				pType->mVecSize = 1;
+				pType->mColumns = 1;
+			}
+			break;
+		}
+		case spv::OpTypeVector:
+		case spv::OpTypeMatrix:
+		{
+			SpirvType* pType = spirv_add_type(pModule, ops[0], ops[1]);
+			if (pType)
+			{
+				if (op == spv::OpTypeVector)
+					pType->mVecSize = ops[2];
+				else
+					pType->mColumns = ops[2];
+				pType->mSelf = ops[0];
+			}
+			break;
+		}
+		case spv::OpTypeArray:
+		case spv::OpTypeRuntimeArray:
+		{
+			SpirvType* pType = spirv_add_type(pModule, ops[0], ops[1]);
+			if (pType)
+			{
+				// Specialization constant sizes are recorded as the id of the constant, same as SPIRV-Cross
+				uint32_t dim = 0;
+				if (op == spv::OpTypeArray)
+				{
+					const uint32_t lengthId = ops[2];
+					const bool literal = lengthId < pModule->mBound && pModule->pIds[lengthId].mKind == SPIRV_ID_CONSTANT && !pModule->pIds[lengthId].mData2;
+					dim = literal ? pModule->pIds[lengthId].mData : lengthId;
+				}
+				spirv_add_array_dim(pModule, pType, dim);
+			}
+			break;
+		}
+		case spv::OpTypeImage:
+		{
+			SpirvType* pType = spirv_add_type(pModule, ops[0], 0);
+			if (pType)
+			{
+				pType->mBaseType = SPIRV_BASE_TYPE_IMAGE;
+				pType->mImageDim = ops[2];
+				pType->mImageSampled = ops[6];
+			}
+			break;
+		}
+		case spv::OpTypeSampledImage:
+		{
+			SpirvType* pType = spirv_add_type(pModule, ops[0], ops[1]);
+			if (pType)
+			{
+				pType->mBaseType = SPIRV_BASE_TYPE_SAMPLED_IMAGE;
+				pType->mSelf = ops[0];
+			}
+			break;
+		}
+		case spv::OpTypeSampler:
+		{
+			SpirvType* pType = spirv_add_type(pModule, ops[0], 0);
+			if (pType)
+				pType->mBaseType = SPIRV_BASE_TYPE_SAMPLER;
+			break;
+		}
+		case spv::OpTypePointer:
+		{
+			SpirvType* pType = spirv_add_type(pModule, ops[0], ops[2]);
+			if (pType)
+			{
+				pType->mPointer = true;
+				pType->mStorage = ops[1];
+				if (pType->mStorage == spv::StorageClassAtomicCounter)
+					pType->mBaseType = SPIRV_BASE_TYPE_ATOMIC_COUNTER;
+			}
+			break;
+		}
+		case spv::OpTypeStruct:
+		{
+			SpirvType* pType = spirv_add_type(pModule, ops[0], 0);
+			if (pType)
+			{
+				pType->mBaseType = SPIRV_BASE_TYPE_STRUCT;
+				pType->mFirstMember = (uint32_t)pModule->mMemberTypes.size();
+				pType->mMemberCount = length - 1;
+				pModule->mMemberTypes.insert(pModule->mMemberTypes.end(), ops + 1, ops + length);
+			}
+			break;
+		}
+		case spv::OpConstant:
+		case spv::OpSpecConstant:
+		case spv::OpConstantTrue:
+		case spv::OpConstantFalse:
+		case spv::OpSpecConstantTrue:
+		case spv::OpSpecConstantFalse:
+		{
+			if (length < 2 || ops[1] >= pModule->mBound)
+				break;
+			SpirvId* pId = &pModule->pIds[ops[1]];
+			pId->mKind = SPIRV_ID_CONSTANT;
+			if (op == spv::OpConstant || op == spv::OpSpecConstant)
+				pId->mData = length >= 3 ? ops[2] : 0;
+			else
+				pId->mData = (op == spv::OpConstantTrue || op == spv::OpSpecConstantTrue) ? 1 : 0;
+			pId->mData2 = (op == spv::OpSpecConstant || op == spv::OpSpecConstantTrue || op == spv::OpSpecConstantFalse);
+			break;
+		}
+		case spv::OpVariable:
+		{
+			if (length < 3 || ops[1] >= pModule->mBound)
+				break;
+			SpirvId* pId = &pModule->pIds[ops[1]];
+			pId->mKind = SPIRV_ID_VARIABLE;
+			pId->mData = ops[0];
+			pId->mData2 = ops[2];
+			break;
+		}
+		case spv::OpFunction:
+		{
+			if (length < 2 || ops[1] >= pModule->mBound)
+				return false;
+			currentFunction = ops[1];
+			pModule->pIds[currentFunction].mKind = SPIRV_ID_FUNCTION;
+			pModule->pIds[currentFunction].mData = end;
+			break;
+		}
+		case spv::OpFunctionParameter:
+		{
+			// Parameters are function scope variables and are never reflected
+			if (length >= 2 && ops[1] < pModule->mBound)
+			{
+				pModule->pIds[ops[1]].mKind = SPIRV_ID_VARIABLE;
+				pModule->pIds[ops[1]].mData = ops[0];
+				pModule->pIds[ops[1]].mData2 = spv::StorageClassFunction;
+			}
+			break;
+		}
+		case spv::OpFunctionEnd:
+		{
+			if (currentFunction)
+				pModule->pIds[currentFunction].mData2 = offset;
+			currentFunction = 0;
+			break;
+		}
+		default:
+			break;
+		}
+
+		offset = end;
+	}
+
+	return currentFunction == 0;
+}
+
+static bool spirv_is_builtin_variable(const SpirvModule* pModule, uint32_t id)
+{
+	if (pModule->pIds[id].mDecoration.mFlags & SPIRV_DECORATION_BUILTIN_BIT)
+		return true;
+
+	// Blocks such as gl_PerVertex are builtin if any of their members is
+	const SpirvType* pType = spirv_get_type(pModule, pModule->pIds[id].mData);
+	const SpirvType* pSelf = pType ? spirv_get_type(pModule, pType->mSelf) : NULL;
+	if (pSelf && pSelf->mBaseType == SPIRV_BASE_TYPE_STRUCT)
+	{
+		for (uint32_t m = 0; m < pSelf->mMemberCount; ++m)
+		{
+			const SpirvDecoration* pDecoration = spirv_find_member_decoration(pModule, pType->mSelf, m);
+			if (pDecoration && (pDecoration->mFlags & SPIRV_DECORATION_BUILTIN_BIT))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+static bool spirv_is_in_entry_point_interface(const SpirvModule* pModule, uint32_t id)
+{
+	// Single entry point modules are assumed to use every interface variable (old glslang did not list them properly)
+	if (pModule->mEntryPoints.size() <= 1)
+		return true;
+
+	const SpirvEntryPoint* pEntry = &pModule->mEntryPoints[0];
+	for (uint32_t i = 0; i < pEntry->mInterfaceCount; ++i)
+	{
+		if (pModule->mInterfaces[pEntry->mFirstInterface + i] == id)
+			return true;
+	}
+	return false;
+}
+
+static void spirv_mark_interface_variable(const SpirvModule* pModule, uint32_t id, tinystl::unordered_set<uint32_t>* pActiveVariables)
+{
+	if (id < pModule->mBound && pModule->pIds[id].mKind == SPIRV_ID_VARIABLE && spirv_is_interface_storage(pModule->pIds[id].mData2))
+		pActiveVariables->insert(id);
+}
+
+// Walks every function reachable from the entry point and records
+// - interface variables that are accessed (loads, stores, access chains, atomics, function call arguments)
+// - struct members of buffer blocks accessed through a constant access chain index
+static void spirv_find_active_variables(const SpirvModule* pModule, tinystl::unordered_set<uint32_t>* pActiveVariables, tinystl::unordered_set<uint64_t>* pActiveMembers)
+{
+	if (pModule->mEntryPoints.empty())
+		return;
+
+	const uint32_t* pCode = pModule->pCode;
+	tinystl::unordered_set<uint32_t> visited;
+	tinystl::vector<uint32_t> functions;
+	functions.push_back(pModule->mEntryPoints[0].mFunction);
+	visited.insert(pModule->mEntryPoints[0].mFunction);
+
+	while (!functions.empty())
+	{
+		const uint32_t function = functions.back();
+		functions.pop_back();
+		if (function >= pModule->mBound || pModule->pIds[function].mKind != SPIRV_ID_FUNCTION)
+			continue;
+
+		uint32_t offset = pModule->pIds[function].mData;
+		const uint32_t end = pModule->pIds[function].mData2;
+		while (offset < end)
+		{
+			const uint32_t op = pCode[offset] & 0xffff;
+			const uint32_t count = pCode[offset] >> 16;
+			const uint32_t* ops = pCode + offset + 1;
+			const uint32_t length = count - 1;
+			offset += count;
+
+			switch (op)
+			{
+			case spv::OpFunctionCall:
+			{
+				if (length < 3)
+					break;
+				for (uint32_t i = 3; i < length; ++i)
+					spirv_mark_interface_variable(pModule, ops[i], pActiveVariables);
+				if (visited.find(ops[2]) == visited.end())
+				{
+					visited.insert(ops[2]);
+					functions.push_back(ops[2]);
+				}
+				break;
+			}
+			case spv::OpStore:
+			case spv::OpAtomicStore:
+			{
+				if (length >= 1)
+					spirv_mark_interface_variable(pModule, ops[0], pActiveVariables);
+				break;
+			}
+			case spv::OpAccessChain:
+			case spv::OpInBoundsAccessChain:
+			{
+				if (length < 3)
+					break;
+				spirv_mark_interface_variable(pModule, ops[2], pActiveVariables);
+				if (length >= 4 && ops[3] < pModule->mBound && pModule->pIds[ops[3]].mKind == SPIRV_ID_CONSTANT)
+					pActiveMembers->insert(((uint64_t)ops[2] << 32) | pModule->pIds[ops[3]].mData);
+				break;
+			}
+			case spv::OpLoad:
+			case spv::OpCopyObject:
+			case spv::OpImageTexelPointer:
+			case spv::OpAtomicLoad:
+			case spv::OpAtomicExchange:
+			case spv::OpAtomicCompareExchange:
+			case spv::OpAtomicCompareExchangeWeak:
+			case spv::OpAtomicIIncrement:
+			case spv::OpAtomicIDecrement:
+			case spv::OpAtomicIAdd:
+			case spv::OpAtomicISub:
+			case spv::OpAtomicSMin:
+			case spv::OpAtomicUMin:
+			case spv::OpAtomicSMax:
+			case spv::OpAtomicUMax:
+			case spv::OpAtomicAnd:
+			case spv::OpAtomicOr:
+			case spv::OpAtomicXor:
+			{
+				if (length >= 3)
+					spirv_mark_interface_variable(pModule, ops[2], pActiveVariables);
+				break;
+			}
+			default:
+				break;
+			}
+		}
+	}
+}
+
+static uint32_t spirv_get_declared_struct_size(const SpirvModule* pModule, const SpirvType* pStruct);
+
+static uint32_t spirv_get_declared_struct_member_size(const SpirvModule* pModule, const SpirvType* pStruct, uint32_t index)
+{
+	const uint32_t memberTypeId = pModule->mMemberTypes[pStruct->mFirstMember + index];
+	const SpirvType* pMember = spirv_get_type(pModule, memberTypeId);
+	const SpirvDecoration* pMemberDecoration = spirv_find_member_decoration(pModule, pStruct->mSelf, index);
+	const uint64_t flags = pMemberDecoration ? pMemberDecoration->mFlags : 0;
+
+	if (!pMember)
+		return 0;
+
+	switch (pMember->mBaseType)
+	{
+	case SPIRV_BASE_TYPE_NUMERIC:
+	case SPIRV_BASE_TYPE_STRUCT:
+		break;
+	default:
+		LOGWARNING("SPIR-V reflection : Querying size for object with opaque size");
+		return 0;
+	}
+
+	if (pMember->mArrayDimCount)
+	{
+		// ArrayStride is a decoration of the array type, not of the member
+		const SpirvDecoration* pArrayDecoration = &pModule->pIds[memberTypeId].mDecoration;
+		if (!(pArrayDecoration->mFlags & (1ull << spv::DecorationArrayStride)))
+		{
+			LOGWARNING("SPIR-V reflection : Struct member does not have ArrayStride set");
+			return 0;
+		}
+		return pArrayDecoration->mArrayStride * pModule->mArrayDims[pMember->mFirstArrayDim + pMember->mArrayDimCount - 1];
+	}
+	else if (pMember->mBaseType == SPIRV_BASE_TYPE_STRUCT)
+	{
+		return spirv_get_declared_struct_size(pModule, pMember);
+	}
+	else if (pMember->mColumns == 1)
+	{
+		return pMember->mVecSize * (pMember->mWidth / 8);
+	}
+	else
+	{
+		const uint32_t matrixStride = pMemberDecoration ? pMemberDecoration->mMatrixStride : 0;
+		if (flags & (1ull << spv::DecorationRowMajor))
+			return matrixStride * pMember->mVecSize;
+		else if (flags & (1ull << spv::DecorationColMajor))
+			return matrixStride * pMember->mColumns;
+
+		LOGWARNING("SPIR-V reflection : Either row-major or column-major must be declared for matrices");
+		return 0;
+	}
+}
+
+static uint32_t spirv_get_declared_struct_size(const SpirvModule* pModule, const SpirvType* pStruct)
+{
+	if (pStruct->mMemberCount == 0)
+		return 0;
+
+	const uint32_t last = pStruct->mMemberCount - 1;
+	const SpirvDecoration* pDecoration = spirv_find_member_decoration(pModule, pStruct->mSelf, last);
+	const uint32_t offset = pDecoration ? pDecoration->mOffset : 0;
+	return offset + spirv_get_declared_struct_member_size(pModule, pStruct, last);
+}
+
+static void spirv_get_name(const SpirvModule* pModule, const SpirvDecoration* pDecoration, const char** ppName, uint32_t* pNameSize)
+{
+	*ppName = pDecoration && pDecoration->mNameSize ? &pModule->mNames[pDecoration->mNameOffset] : "";
+	*pNameSize = pDecoration ? pDecoration->mNameSize : 0;
+}
+
+// Stage interface blocks report the block name, buffer blocks fall back to it for anonymous instances
+// and everything else uses the variable name
+static void spirv_get_resource_name(const SpirvModule* pModule, uint32_t id, uint32_t category, const char** ppName, uint32_t* pNameSize)
+{
+	const SpirvType* pType = spirv_get_type(pModule, pModule->pIds[id].mData);
+	const SpirvDecoration* pSelfDecoration = pType->mSelf < pModule->mBound ? &pModule->pIds[pType->mSelf].mDecoration : NULL;
+	const bool block = pSelfDecoration && (pSelfDecoration->mFlags & (1ull << spv::DecorationBlock));
+
+	if ((category == SPIRV_TYPE_STAGE_INPUTS || category == SPIRV_TYPE_STAGE_OUTPUTS) && block)
+	{
+		spirv_get_name(pModule, pSelfDecoration, ppName, pNameSize);
+		return;
+	}
+
+	spirv_get_name(pModule, &pModule->pIds[id].mDecoration, ppName, pNameSize);
+	if (!*pNameSize && (category == SPIRV_TYPE_UNIFORM_BUFFERS || category == SPIRV_TYPE_STORAGE_BUFFERS))
+		spirv_get_name(pModule, pSelfDecoration, ppName, pNameSize);
+}
+
+// Resource category of a global variable following the SPIRV-Cross get_shader_resources rules
+static uint32_t spirv_classify_variable(const SpirvModule* pModule, uint32_t id)
+{
+	const SpirvId* pId = &pModule->pIds[id];
+	const SpirvType* pType = spirv_get_type(pModule, pId->mData);
+	const uint32_t storage = pId->mData2;
+
+	if (!pType || storage == spv::StorageClassFunction || !pType->mPointer || spirv_is_builtin_variable(pModule, id))
+		return SPIRV_TYPE_COUNT;
+
+	const uint64_t selfFlags = pType->mSelf < pModule->mBound ? pModule->pIds[pType->mSelf].mDecoration.mFlags : 0;
+
+	if (storage == spv::StorageClassInput && spirv_is_in_entry_point_interface(pModule, id))
+		return SPIRV_TYPE_STAGE_INPUTS;
+	if (storage == spv::StorageClassUniformConstant && pType->mImageDim == spv::DimSubpassData)
+		return SPIRV_TYPE_SUBPASS_INPUTS;
+	if (storage == spv::StorageClassOutput && spirv_is_in_entry_point_interface(pModule, id))
+		return SPIRV_TYPE_STAGE_OUTPUTS;
+	if (pType->mStorage == spv::StorageClassUniform && (selfFlags & (1ull << spv::DecorationBlock)))
+		return SPIRV_TYPE_UNIFORM_BUFFERS;
+	if (pType->mStorage == spv::StorageClassUniform && (selfFlags & (1ull << spv::DecorationBufferBlock)))
+		return SPIRV_TYPE_STORAGE_BUFFERS;
+	if (pType->mStorage == spv::StorageClassPushConstant)
+		return SPIRV_TYPE_PUSH_CONSTANT;
+	if (pType->mStorage == spv::StorageClassUniformConstant && pType->mBaseType == SPIRV_BASE_TYPE_IMAGE && pType->mImageSampled == 2)
+		return SPIRV_TYPE_STORAGE_IMAGES;
+	if (pType->mStorage == spv::StorageClassUniformConstant && pType->mBaseType == SPIRV_BASE_TYPE_IMAGE && pType->mImageSampled == 1)
+		return SPIRV_TYPE_IMAGES;
+	if (pType->mStorage == spv::StorageClassUniformConstant && pType->mBaseType == SPIRV_BASE_TYPE_SAMPLER)
+		return SPIRV_TYPE_SAMPLERS;
+
+	// Combined image samplers and atomic counters are not reflected
+	return SPIRV_TYPE_COUNT;
+}
+
+bool createSpirvReflection(const uint32_t* pCode, uint32_t wordCount, SpirvReflection* pOutReflection)
+{
+	ASSERT(pOutReflection);
+	memset(pOutReflection, 0, sizeof(*pOutReflection));
+
+	if (!pCode || wordCount < 5)
+	{
+		LOGERROR("SPIR-V reflection : Module too small");
+		return false;
+	}
+
+	// Byte swapped modules are converted to host order on a private copy
+	uint32_t* pSwapped = NULL;
+	if (pCode[0] != spv::MagicNumber)
+	{
+		const uint32_t swappedMagic = ((spv::MagicNumber & 0xff) << 24) | ((spv::MagicNumber & 0xff00) << 8) | ((spv::MagicNumber >> 8) & 0xff00) | (spv::MagicNumber >> 24);
+		if (pCode[0] != swappedMagic)
+		{
+			LOGERROR("SPIR-V reflection : Invalid magic number");
+			return false;
+		}
+
+		pSwapped = (uint32_t*)conf_malloc(wordCount * sizeof(uint32_t));
+		for (uint32_t i = 0; i < wordCount; ++i)
+		{
+			const uint32_t w = pCode[i];
+			pSwapped[i] = (w << 24) | ((w & 0xff00) << 8) | ((w >> 8) & 0xff00) | (w >> 24);
+		}
+		pCode = pSwapped;
+	}
+
+	SpirvModule module;
+	module.pCode = pCode;
+	module.mWordCount = wordCount;
+	module.mBound = pCode[3];
+	module.pIds = (SpirvId*)conf_calloc(module.mBound ? module.mBound : 1, sizeof(SpirvId));
+
+	bool success = spirv_parse_module(&module);
+	if (!success)
+		LOGERROR("SPIR-V reflection : Failed to parse module");
+
+	if (success)
+	{
+		tinystl::unordered_set<uint32_t> activeVariables;
+		tinystl::unordered_set<uint64_t> activeMembers;
+		spirv_find_active_variables(&module, &activeVariables, &activeMembers);
+
+		// Bucket the global variables by resource category. Ids are visited in increasing order so every bucket is sorted by id
+		tinystl::vector<uint32_t> resourceIds[SPIRV_TYPE_COUNT];
+		for (uint32_t id = 0; id < module.mBound; ++id)
+		{
+			if (module.pIds[id].mKind != SPIRV_ID_VARIABLE)
+				continue;
+			const uint32_t category = spirv_classify_variable(&module, id);
+			if (category != SPIRV_TYPE_COUNT)
+				resourceIds[category].push_back(id);
+		}
+
+		static const SPIRV_Resource_Type gResourceOrder[] =
+		{
+			SPIRV_TYPE_STAGE_INPUTS,
+			SPIRV_TYPE_STAGE_OUTPUTS,
+			SPIRV_TYPE_UNIFORM_BUFFERS,
+			SPIRV_TYPE_STORAGE_BUFFERS,
+			SPIRV_TYPE_STORAGE_IMAGES,
+			SPIRV_TYPE_IMAGES,
+			SPIRV_TYPE_SAMPLERS,
+			SPIRV_TYPE_SUBPASS_INPUTS,
+			SPIRV_TYPE_PUSH_CONSTANT,
+		};
+
+		// Count resources, block members and name pool size up front so everything lives in three allocations
+		uint32_t resourceCount = 0;
+		uint32_t variableCount = 0;
+		uint32_t namePoolSize = 0;
+		for (uint32_t c = 0; c < SPIRV_TYPE_COUNT; ++c)
+		{
+			const SPIRV_Resource_Type category = gResourceOrder[c];
+			for (uint32_t r = 0; r < (uint32_t)resourceIds[category].size(); ++r)
+			{
+				const uint32_t id = resourceIds[category][r];
+				const SpirvType* pType = spirv_get_type(&module, module.pIds[id].mData);
+				const char* pName = NULL;
+				uint32_t nameSize = 0;
+				spirv_get_resource_name(&module, id, category, &pName, &nameSize);
+				namePoolSize += nameSize + 1;
+				++resourceCount;
+
+				if (category == SPIRV_TYPE_UNIFORM_BUFFERS || category == SPIRV_TYPE_PUSH_CONSTANT)
+				{
+					for (uint32_t m = 0; m < pType->mMemberCount; ++m)
+					{
+						spirv_get_name(&module, spirv_find_member_decoration(&module, pType->mSelf, m), &pName, &nameSize);
+						namePoolSize += nameSize + 1;
+						++variableCount;
+					}
+				}
+			}
+		}
+
+		pOutReflection->pNamePool = namePoolSize ? (char*)conf_calloc(namePoolSize, 1) : NULL;
+		pOutReflection->pShaderResources = resourceCount ? (SPIRV_Resource*)conf_calloc(resourceCount, sizeof(SPIRV_Resource)) : NULL;
+		pOutReflection->pUniformVariables = variableCount ? (SPIRV_Variable*)conf_calloc(variableCount, sizeof(SPIRV_Variable)) : NULL;
+		pOutReflection->mShaderResourceCount = resourceCount;
+		pOutReflection->mUniformVariableCount = variableCount;
+
+		char* pCurrentName = pOutReflection->pNamePool;
+		uint32_t currentResource = 0;
+		for (uint32_t c = 0; c < SPIRV_TYPE_COUNT; ++c)
+		{
+			const SPIRV_Resource_Type category = gResourceOrder[c];
+			for (uint32_t r = 0; r < (uint32_t)resourceIds[category].size(); ++r)
+			{
+				const uint32_t id = resourceIds[category][r];
+				const SpirvId* pId = &module.pIds[id];
+				const SpirvType* pType = spirv_get_type(&module, pId->mData);
+				const SpirvDecoration* pDecoration = &pId->mDecoration;
+
+				SPIRV_Resource* pResource = &pOutReflection->pShaderResources[currentResource++];
+				pResource->SPIRV_code.id = id;
+				pResource->SPIRV_code.type_id = pId->mData;
+				pResource->SPIRV_code.base_type_id = pType->mSelf;
+				pResource->type = category;
+				pResource->is_used = activeVariables.find(id) != activeVariables.end();
+
+				const char* pName = NULL;
+				uint32_t nameSize = 0;
+				spirv_get_resource_name(&module, id, category, &pName, &nameSize);
+				memcpy(pCurrentName, pName, nameSize);
+				pResource->name = pCurrentName;
+				pResource->name_size = nameSize;
+				pCurrentName += nameSize + 1;
+
+				switch (category)
+				{
+				case SPIRV_TYPE_STAGE_INPUTS:
+				case SPIRV_TYPE_STAGE_OUTPUTS:
+					pResource->set = (uint32_t)-1;
+					pResource->binding = (pDecoration->mFlags & (1ull << spv::DecorationLocation)) ? pDecoration->mLocation : 0;
+					pResource->size = (pType->mWidth / 8) * pType->mVecSize;
+					break;
+				case SPIRV_TYPE_PUSH_CONSTANT:
+					pResource->set = (uint32_t)-1;
+					pResource->binding = (uint32_t)-1;
+					pResource->size = spirv_get_declared_struct_size(&module, pType);
+					break;
+				default:
+					pResource->set = (pDecoration->mFlags & (1ull << spv::DecorationDescriptorSet)) ? pDecoration->mSet : 0;
+					pResource->binding = (pDecoration->mFlags & (1ull << spv::DecorationBinding)) ? pDecoration->mBinding : 0;
+					pResource->size = pType->mArrayDimCount ? module.mArrayDims[pType->mFirstArrayDim] : 1;
+					break;
+				}
+			}
+		}
+
+		uint32_t currentVariable = 0;
+		for (uint32_t i = 0; i < resourceCount; ++i)
+		{
+			const SPIRV_Resource* pResource = &pOutReflection->pShaderResources[i];
+			if (pResource->type != SPIRV_TYPE_UNIFORM_BUFFERS && pResource->type != SPIRV_TYPE_PUSH_CONSTANT)
+				continue;
+
+			const SpirvType* pType = spirv_get_type(&module, pResource->SPIRV_code.type_id);
+			for (uint32_t m = 0; m < pType->mMemberCount; ++m)
+			{
+				const SpirvDecoration* pMemberDecoration = spirv_find_member_decoration(&module, pType->mSelf, m);
+				SPIRV_Variable* pVariable = &pOutReflection->pUniformVariables[currentVariable++];
+				pVariable->SPIRV_type_id = module.mMemberTypes[pType->mFirstMember + m];
+				pVariable->parent_SPIRV_code = pResource->SPIRV_code;
+				pVariable->parent_index = i;
+				pVariable->is_used = activeMembers.find(((uint64_t)pResource->SPIRV_code.id << 32) | m) != activeMembers.end();
+				pVariable->size = spirv_get_declared_struct_member_size(&module, pType, m);
+				pVariable->offset = (pMemberDecoration && (pMemberDecoration->mFlags & (1ull << spv::DecorationOffset))) ? pMemberDecoration->mOffset : 0;
+
+				const char* pName = NULL;
+				uint32_t nameSize = 0;
+				spirv_get_name(&module, pMemberDecoration, &pName, &nameSize);
+				memcpy(pCurrentName, pName, nameSize);
+				pVariable->name = pCurrentName;
+				pVariable->name_size = nameSize;
+				pCurrentName += nameSize + 1;
+			}
+		}
+
+		// Execution modes are looked up on the "main" entry point, falling back to the first one
+		const SpirvEntryPoint* pMain = module.mEntryPoints.empty() ? NULL : &module.mEntryPoints[0];
+		for (uint32_t i = 0; i < (uint32_t)module.mEntryPoints.size(); ++i)
+		{
+			const SpirvEntryPoint* pEntry = &module.mEntryPoints[i];
+			if (pEntry->mNameSize == 4 && strncmp(&module.mNames[pEntry->mNameOffset], "main", 4) == 0)
+			{
+				pMain = pEntry;
+				break;
+			}
+		}
+		if (pMain)
+		{
+			pOutReflection->mWorkGroupSize[0] = pMain->mWorkGroupSize[0];
+			pOutReflection->mWorkGroupSize[1] = pMain->mWorkGroupSize[1];
+			pOutReflection->mWorkGroupSize[2] = pMain->mWorkGroupSize[2];
+			pOutReflection->mOutputVertexCount = pMain->mOutputVertexCount;
+		}
+	}
+
+	conf_free(module.pIds);
+	conf_free(pSwapped);
+	return success;
+}
+
+void destroySpirvReflection(SpirvReflection* pReflection)
+{
+	if (!pReflection)
+		return;
+
+	conf_free(pReflection->pShaderResources);
+	conf_free(pReflection->pUniformVariables);
+	conf_free(pReflection->pNamePool);
+	memset(pReflection, 0, sizeof(*pReflection));
+}
+
+#endif // #if defined(VULKAN) || defined(NULL_RENDERER)
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "../../Tools/SpirvTools/SpirvTools.h"
+
+/// Reflection data produced by the native SPIR-V parser.
+/// The layout mirrors what the SPIRV-Cross based CrossCompiler reports (same resource ordering, usage flags, sizes and names)
+/// so createShaderReflection can consume either source without changes.
+struct SpirvReflection
+{
+	/// Stage inputs, stage outputs, uniform buffers, storage buffers, storage images, separate images,
+	/// separate samplers, subpass inputs and push constants - in that order, each group sorted by SPIR-V id
+	SPIRV_Resource*	pShaderResources;
+	uint32_t		mShaderResourceCount;
+
+	/// Members of uniform buffers and push constant blocks
+	SPIRV_Variable*	pUniformVariables;
+	uint32_t		mUniformVariableCount;
+
+	/// LocalSize execution mode of the "main" entry point
+	uint32_t		mWorkGroupSize[3];
+	/// OutputVertices execution mode of the "main" entry point
+	uint32_t		mOutputVertexCount;
+
+	/// Single allocation holding all resource and variable names
+	char*			pNamePool;
+};
+
+/// Parses a SPIR-V module and fills pOutReflection. Returns false if the module is malformed
+bool createSpirvReflection(const uint32_t* pCode, uint32_t wordCount, SpirvReflection* pOutReflection);
+void destroySpirvReflection(SpirvReflection* pReflection);
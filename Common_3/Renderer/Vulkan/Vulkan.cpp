@@ -44,7 +44,9 @@ namespace RENDERER_CPP_NAMESPACE {
 #endif
 
 #include "../IRenderer.h"
+#include "../PipelineCache.h"
 #include "../../ThirdParty/OpenSource/TinySTL/hash.h"
+#include "../../OS/Core/ContentHash.h"
 #include "../../OS/Interfaces/ILogManager.h"
 #include "../IMemoryAllocator.h"
 #include "../../OS/Interfaces/IMemoryManager.h"
@@ -695,9 +697,22 @@ namespace RENDERER_CPP_NAMESPACE {
 	  }
   }
 
-  const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const char* pResName, uint32_t* pIndex)
+  const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const DescriptorData* pParam, uint32_t* pIndex)
   {
-	  DescriptorNameToIndexMap::const_iterator it = pRootSignature->pDescriptorNameToIndexMap.find(tinystl::hash(pResName));
+	  // Slot resolved up front through getDescriptorIndexFromName - no string hashing required
+	  if (pParam->mIndex != (uint32_t)-1)
+	  {
+		  if (pParam->mIndex >= pRootSignature->mDescriptorCount)
+		  {
+			  LOGERRORF("Invalid descriptor index (%u). Root signature has (%u) descriptors", pParam->mIndex, pRootSignature->mDescriptorCount);
+			  return NULL;
+		  }
+
+		  *pIndex = pParam->mIndex;
+		  return &pRootSignature->pDescriptors[pParam->mIndex];
+	  }
+
+	  DescriptorNameToIndexMap::const_iterator it = pRootSignature->pDescriptorNameToIndexMap.find(tinystl::hash(pParam->pName));
 	  if (it.node)
 	  {
 		  *pIndex = it.node->second;
@@ -705,11 +720,24 @@ namespace RENDERER_CPP_NAMESPACE {
 	  }
 	  else
 	  {
-		  LOGERRORF("Invalid descriptor param (%s)", pResName);
+		  LOGERRORF("Invalid descriptor param (%s)", pParam->pName);
 		  return NULL;
 	  }
   }
 
+  uint32_t getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName)
+  {
+	  ASSERT(pRootSignature);
+	  ASSERT(pName);
+
+	  DescriptorNameToIndexMap::const_iterator it = pRootSignature->pDescriptorNameToIndexMap.find(tinystl::hash(pName));
+	  if (it.node)
+		  return it.node->second;
+
+	  LOGERRORF("Invalid descriptor param (%s)", pName);
+	  return (uint32_t)-1;
+  }
+
   VkPipelineBindPoint gPipelineBindPoint[PIPELINE_TYPE_COUNT] =
   {
 	  VK_PIPELINE_BIND_POINT_MAX_ENUM,
@@ -739,23 +767,25 @@ namespace RENDERER_CPP_NAMESPACE {
 	  // This value will be later used as look up to find if a descriptor set with the given hash already exists
 	  // This way we will call updateDescriptorSet for a particular set of descriptors only once
 	  // Then we only need to do a look up into the mDescriptorSetMap with pHash[setIndex] as the key and retrieve the DescriptorSet* value
-	  uint64_t* pHash = (uint64_t*)alloca(setCount * sizeof(uint64_t));
+	  uint64_t pHash[setCount] = {};
 
 	  // Loop through input params to check for new data
 	  for (uint32_t i = 0; i < numDescriptors; ++i)
 	  {
 		  const DescriptorData* pParam = &pDescParams[i];
 		  ASSERT(pParam);
-		  if (!pParam->pName)
+		  if (!pParam->pName && pParam->mIndex == (uint32_t)-1)
 		  {
-			  LOGERRORF("Name of Descriptor at index (%u) is NULL", i);
+			  LOGERRORF("Name and index of Descriptor at index (%u) are both unset", i);
 			  return;
 		  }
 
 		  uint32_t descIndex = -1;
-		  const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pParam->pName, &descIndex);
+		  const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pParam, &descIndex);
 		  if (!pDesc)
 			  continue;
+		  // Name used for error reporting. pParam->pName may be NULL when binding by index
+		  const char* pDescName = pDesc->mDesc.name;
 
 		  // Find the update frequency of the descriptor
 		  // This is also the set index to be used in vkCmdBindDescriptorSets
@@ -773,17 +803,17 @@ namespace RENDERER_CPP_NAMESPACE {
 		  {
 			  if (pDesc->mIndexInParent == -1)
 			  {
-				  LOGERRORF("Trying to bind a static sampler (%s). All static samplers must be bound in addRootSignature through RootSignatureDesc::mStaticSamplers", pParam->pName);
+				  LOGERRORF("Trying to bind a static sampler (%s). All static samplers must be bound in addRootSignature through RootSignatureDesc::mStaticSamplers", pDescName);
 				  continue;
 			  }
 			  if (!pParam->ppSamplers) {
-				  LOGERRORF("Sampler descriptor (%s) is NULL", pParam->pName);
+				  LOGERRORF("Sampler descriptor (%s) is NULL", pDescName);
 				  return;
 			  }
 			  for (uint32_t i = 0; i < pParam->mCount; ++i)
 			  {
 				  if (!pParam->ppSamplers[i]) {
-					  LOGERRORF("Sampler descriptor (%s) at array index (%u) is NULL", pParam->pName, i);
+					  LOGERRORF("Sampler descriptor (%s) at array index (%u) is NULL", pDescName, i);
 					  return;
 				  }
 				  pHash[setIndex] = tinystl::hash_state(&pParam->ppSamplers[i]->mSamplerId, 1, pHash[setIndex]);
@@ -793,13 +823,13 @@ namespace RENDERER_CPP_NAMESPACE {
 		  else if (pDesc->mDesc.type == DESCRIPTOR_TYPE_TEXTURE || pDesc->mDesc.type == DESCRIPTOR_TYPE_RW_TEXTURE)
 		  {
 			  if (!pParam->ppTextures) {
-				  LOGERRORF("Texture descriptor (%s) is NULL", pParam->pName);
+				  LOGERRORF("Texture descriptor (%s) is NULL", pDescName);
 				  return;
 			  }
 			  for (uint32_t i = 0; i < pParam->mCount; ++i)
 			  {
 				  if (!pParam->ppBuffers[i]) {
-					  LOGERRORF("Texture descriptor (%s) at array index (%u) is NULL", pParam->pName, i);
+					  LOGERRORF("Texture descriptor (%s) at array index (%u) is NULL", pDescName, i);
 					  return;
 				  }
 
@@ -817,13 +847,13 @@ namespace RENDERER_CPP_NAMESPACE {
 		  else
 		  {
 			  if (!pParam->ppBuffers) {
-				  LOGERRORF("Buffer descriptor (%s) is NULL", pParam->pName);
+				  LOGERRORF("Buffer descriptor (%s) is NULL", pDescName);
 				  return;
 			  }
 			  for (uint32_t i = 0; i < pParam->mCount; ++i)
 			  {
 				  if (!pParam->ppBuffers[i]) {
-					  LOGERRORF("Buffer descriptor (%s) at array index (%u) is NULL", pParam->pName, i);
+					  LOGERRORF("Buffer descriptor (%s) at array index (%u) is NULL", pDescName, i);
 					  return;
 				  }
 				  pHash[setIndex] = tinystl::hash_state(&pParam->ppBuffers[i]->mBufferId, 1, pHash[setIndex]);
@@ -1289,6 +1319,113 @@ namespace RENDERER_CPP_NAMESPACE {
 		return ImageFormat::BGRA8;
 	}
 	/************************************************************************/
+	// Pipeline Cache
+	/************************************************************************/
+	typedef struct PipelineRegistry
+	{
+		Mutex										mMutex;
+		tinystl::unordered_map<uint64_t, Pipeline*>	mPipelines;
+	} PipelineRegistry;
+
+	static const char* util_get_pipeline_cache_file_name(Renderer* pRenderer)
+	{
+		return pRenderer->mSettings.pPipelineCacheFileName ? pRenderer->mSettings.pPipelineCacheFileName : PIPELINE_CACHE_FILE_NAME;
+	}
+
+	static void util_get_pipeline_cache_device_info(Renderer* pRenderer, PipelineCacheDeviceInfo* pInfo)
+	{
+		memset(pInfo, 0, sizeof(*pInfo));
+		pInfo->mVendorId = pRenderer->pVkActiveGPUProperties->vendorID;
+		pInfo->mDeviceId = pRenderer->pVkActiveGPUProperties->deviceID;
+		pInfo->mDriverVersion = pRenderer->pVkActiveGPUProperties->driverVersion;
+		memcpy(pInfo->mCacheUUID, pRenderer->pVkActiveGPUProperties->pipelineCacheUUID, PIPELINE_CACHE_UUID_SIZE);
+	}
+
+	void add_pipeline_cache(Renderer* pRenderer)
+	{
+		tinystl::vector<uint8_t> initialData;
+		if (!pRenderer->mSettings.mDisablePipelineCache)
+		{
+			PipelineCacheDeviceInfo deviceInfo;
+			util_get_pipeline_cache_device_info(pRenderer, &deviceInfo);
+			loadPipelineCacheFile(util_get_pipeline_cache_file_name(pRenderer), FSR_OtherFiles, &deviceInfo, &initialData);
+		}
+
+		DECLARE_ZERO(VkPipelineCacheCreateInfo, create_info);
+		create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		create_info.pNext = NULL;
+		create_info.flags = 0;
+		create_info.initialDataSize = initialData.size();
+		create_info.pInitialData = initialData.size() ? initialData.data() : NULL;
+		VkResult vk_res = vkCreatePipelineCache(pRenderer->pDevice, &create_info, NULL, &pRenderer->pPipelineCache);
+		if (VK_SUCCESS != vk_res && create_info.initialDataSize)
+		{
+			// Fall back to an empty cache if the driver rejects the data after all
+			create_info.initialDataSize = 0;
+			create_info.pInitialData = NULL;
+			vk_res = vkCreatePipelineCache(pRenderer->pDevice, &create_info, NULL, &pRenderer->pPipelineCache);
+		}
+		ASSERT(VK_SUCCESS == vk_res);
+
+		pRenderer->pPipelineRegistry = conf_placement_new<PipelineRegistry>(conf_calloc(1, sizeof(PipelineRegistry)));
+	}
+
+	void remove_pipeline_cache(Renderer* pRenderer)
+	{
+		if (pRenderer->pPipelineRegistry->mPipelines.size())
+			LOGWARNINGF("%u pipelines were not removed before removeRenderer", (uint32_t)pRenderer->pPipelineRegistry->mPipelines.size());
+		pRenderer->pPipelineRegistry->~PipelineRegistry();
+		SAFE_FREE(pRenderer->pPipelineRegistry);
+
+		if (!pRenderer->mSettings.mDisablePipelineCache)
+		{
+			size_t dataSize = 0;
+			VkResult vk_res = vkGetPipelineCacheData(pRenderer->pDevice, pRenderer->pPipelineCache, &dataSize, NULL);
+			if (VK_SUCCESS == vk_res && dataSize)
+			{
+				tinystl::vector<uint8_t> data(dataSize);
+				vk_res = vkGetPipelineCacheData(pRenderer->pDevice, pRenderer->pPipelineCache, &dataSize, data.data());
+				if (VK_SUCCESS == vk_res)
+				{
+					PipelineCacheDeviceInfo deviceInfo;
+					util_get_pipeline_cache_device_info(pRenderer, &deviceInfo);
+					savePipelineCacheFile(util_get_pipeline_cache_file_name(pRenderer), FSR_OtherFiles, &deviceInfo, data.data(), dataSize);
+				}
+			}
+		}
+
+		vkDestroyPipelineCache(pRenderer->pDevice, pRenderer->pPipelineCache, NULL);
+	}
+
+	/// Returns a live pipeline created from an identical desc with an added reference, NULL if there is none
+	static Pipeline* acquire_registered_pipeline(Renderer* pRenderer, uint64_t hash, const RootSignature* pRootSignature)
+	{
+		MutexLock lock(pRenderer->pPipelineRegistry->mMutex);
+		tinystl::unordered_map<uint64_t, Pipeline*>::iterator it = pRenderer->pPipelineRegistry->mPipelines.find(hash);
+		if (it == pRenderer->pPipelineRegistry->mPipelines.end())
+			return NULL;
+
+		// Root signatures are hashed by layout only. Static samplers are not part of it, so require the same object
+		Pipeline* pPipeline = it->second;
+		const RootSignature* pExistingRootSignature = pPipeline->mType == PIPELINE_TYPE_GRAPHICS ? pPipeline->mGraphics.pRootSignature : pPipeline->mCompute.pRootSignature;
+		if (pExistingRootSignature != pRootSignature)
+			return NULL;
+
+		++pPipeline->mRefCount;
+		return pPipeline;
+	}
+
+	static void register_pipeline(Renderer* pRenderer, Pipeline* pPipeline, uint64_t hash)
+	{
+		pPipeline->mPipelineHash = hash;
+		pPipeline->mRefCount = 1;
+
+		MutexLock lock(pRenderer->pPipelineRegistry->mMutex);
+		// If another thread registered the same desc in the meantime this one simply stays unshared
+		if (pRenderer->pPipelineRegistry->mPipelines.find(hash) == pRenderer->pPipelineRegistry->mPipelines.end())
+			pRenderer->pPipelineRegistry->mPipelines.insert({ hash, pPipeline });
+	}
+	/************************************************************************/
 	// Globals
 	/************************************************************************/
 	static volatile uint64_t gBufferIds = 0;
@@ -1331,6 +1468,7 @@ namespace RENDERER_CPP_NAMESPACE {
 			vmaCreateAllocator(&createInfo, &pRenderer->pVmaAllocator);
 
 			add_descriptor_heap(pRenderer, gDefaultDescriptorSets, 0, gDescriptorHeapPoolSizes, VK_DESCRIPTOR_TYPE_RANGE_SIZE, &pRenderer->pDescriptorPool);
+			add_pipeline_cache(pRenderer);
 		}
 
 		create_default_resources(pRenderer);
@@ -1346,6 +1484,7 @@ namespace RENDERER_CPP_NAMESPACE {
 		destroy_default_resources(pRenderer);
 
 		// Destroy the Vulkan bits
+		remove_pipeline_cache(pRenderer);
 		remove_descriptor_heap(pRenderer, pRenderer->pDescriptorPool);
 		vmaDestroyAllocator(pRenderer->pVmaAllocator);
 
@@ -2339,6 +2478,29 @@ namespace RENDERER_CPP_NAMESPACE {
 		SAFE_FREE(pSampler);
 	}
 
+	// Stage reflection is cached as <spv path>.refl next to the byte code and keyed by the hash of the code
+	// Writing the cache is best effort, shader directories may be read-only
+	static void create_cached_shader_reflection(const ShaderStageDesc* pStageDesc, ShaderStage stage, ShaderReflection* pOutReflection)
+	{
+		const uint8_t* pCode = (const uint8_t*)pStageDesc->mCode.c_str();
+		const uint32_t codeSize = pStageDesc->mCode.getLength();
+		const uint64_t codeHash = XXHash64(pCode, codeSize);
+
+		tinystl::string cachePath;
+		if (pStageDesc->mName.size())
+		{
+			cachePath = pStageDesc->mName + ".refl";
+			if (loadShaderReflectionFile(cachePath.c_str(), codeHash, pOutReflection) && pOutReflection->mShaderStage == stage)
+				return;
+			destroyShaderReflection(pOutReflection);
+		}
+
+		createShaderReflection(pCode, codeSize, stage, pOutReflection);
+
+		if (cachePath.size())
+			saveShaderReflectionFile(cachePath.c_str(), codeHash, pOutReflection);
+	}
+
 	void addShader(Renderer* pRenderer, const ShaderDesc* pDesc, Shader** ppShaderProgram)
 	{
 		Shader* pShaderProgram = (Shader*)conf_calloc(1, sizeof(*pShaderProgram));
@@ -2358,7 +2520,7 @@ namespace RENDERER_CPP_NAMESPACE {
 				create_info.flags = 0;
 				switch (stage_mask) {
 				case SHADER_STAGE_VERT: {
-					createShaderReflection((const uint8_t*)pDesc->mVert.mCode.c_str(), pDesc->mVert.mCode.getLength(), SHADER_STAGE_VERT, &stageReflections[counter++]);
+					create_cached_shader_reflection(&pDesc->mVert, SHADER_STAGE_VERT, &stageReflections[counter++]);
 
 					create_info.codeSize = pDesc->mVert.mCode.size();
 					create_info.pCode = (const uint32_t*)pDesc->mVert.mCode.c_str();
@@ -2367,9 +2529,10 @@ namespace RENDERER_CPP_NAMESPACE {
 
 					pShaderProgram->pVertEntryPoint = (char*)conf_calloc(pDesc->mVert.mEntryPoint.size() + 1, sizeof(char));
 					memcpy(pShaderProgram->pVertEntryPoint, pDesc->mVert.mEntryPoint, pDesc->mVert.mEntryPoint.size());
+					pShaderProgram->mContentHash = hashShaderStage(SHADER_STAGE_VERT, create_info.pCode, (uint32_t)create_info.codeSize, pShaderProgram->pVertEntryPoint, pShaderProgram->mContentHash);
 				} break;
 				case SHADER_STAGE_TESC: {
-					createShaderReflection((const uint8_t*)pDesc->mHull.mCode.c_str(), pDesc->mHull.mCode.getLength(), SHADER_STAGE_TESC, &stageReflections[counter++]);
+					create_cached_shader_reflection(&pDesc->mHull, SHADER_STAGE_TESC, &stageReflections[counter++]);
 
 					memcpy(&pShaderProgram->mNumControlPoint, &stageReflections[counter - 1].mNumControlPoint, sizeof(pShaderProgram->mNumControlPoint));
 
@@ -2380,9 +2543,10 @@ namespace RENDERER_CPP_NAMESPACE {
 
 					pShaderProgram->pTescEntryPoint = (char*)conf_calloc(pDesc->mHull.mEntryPoint.size() + 1, sizeof(char));
 					memcpy(pShaderProgram->pTescEntryPoint, pDesc->mHull.mEntryPoint, pDesc->mHull.mEntryPoint.size());
+					pShaderProgram->mContentHash = hashShaderStage(SHADER_STAGE_TESC, create_info.pCode, (uint32_t)create_info.codeSize, pShaderProgram->pTescEntryPoint, pShaderProgram->mContentHash);
 				} break;
 				case SHADER_STAGE_TESE: {
-					createShaderReflection((const uint8_t*)pDesc->mDomain.mCode.c_str(), pDesc->mDomain.mCode.getLength(), SHADER_STAGE_TESE, &stageReflections[counter++]);
+					create_cached_shader_reflection(&pDesc->mDomain, SHADER_STAGE_TESE, &stageReflections[counter++]);
 
 					create_info.codeSize = pDesc->mDomain.mCode.size();
 					create_info.pCode = (const uint32_t*)pDesc->mDomain.mCode.c_str();
@@ -2391,9 +2555,10 @@ namespace RENDERER_CPP_NAMESPACE {
 
 					pShaderProgram->pTeseEntryPoint = (char*)conf_calloc(pDesc->mDomain.mEntryPoint.size() + 1, sizeof(char));
 					memcpy(pShaderProgram->pTeseEntryPoint, pDesc->mDomain.mEntryPoint, pDesc->mDomain.mEntryPoint.size());
+					pShaderProgram->mContentHash = hashShaderStage(SHADER_STAGE_TESE, create_info.pCode, (uint32_t)create_info.codeSize, pShaderProgram->pTeseEntryPoint, pShaderProgram->mContentHash);
 				} break;
 				case SHADER_STAGE_GEOM: {
-					createShaderReflection((const uint8_t*)pDesc->mGeom.mCode.c_str(), pDesc->mGeom.mCode.getLength(), SHADER_STAGE_GEOM, &stageReflections[counter++]);
+					create_cached_shader_reflection(&pDesc->mGeom, SHADER_STAGE_GEOM, &stageReflections[counter++]);
 
 					create_info.codeSize = pDesc->mGeom.mCode.size();
 					create_info.pCode = (const uint32_t*)pDesc->mGeom.mCode.c_str();
@@ -2402,9 +2567,10 @@ namespace RENDERER_CPP_NAMESPACE {
 
 					pShaderProgram->pGeomEntryPoint = (char*)conf_calloc(pDesc->mGeom.mEntryPoint.size() + 1, sizeof(char));
 					memcpy(pShaderProgram->pGeomEntryPoint, pDesc->mGeom.mEntryPoint, pDesc->mGeom.mEntryPoint.size());
+					pShaderProgram->mContentHash = hashShaderStage(SHADER_STAGE_GEOM, create_info.pCode, (uint32_t)create_info.codeSize, pShaderProgram->pGeomEntryPoint, pShaderProgram->mContentHash);
 				} break;
 				case SHADER_STAGE_FRAG: {
-					createShaderReflection((const uint8_t*)pDesc->mFrag.mCode.c_str(), pDesc->mFrag.mCode.getLength(), SHADER_STAGE_FRAG, &stageReflections[counter++]);
+					create_cached_shader_reflection(&pDesc->mFrag, SHADER_STAGE_FRAG, &stageReflections[counter++]);
 
 					create_info.codeSize = pDesc->mFrag.mCode.size();
 					create_info.pCode = (const uint32_t*)pDesc->mFrag.mCode.c_str();
@@ -2413,9 +2579,10 @@ namespace RENDERER_CPP_NAMESPACE {
 
 					pShaderProgram->pFragEntryPoint = (char*)conf_calloc(pDesc->mFrag.mEntryPoint.size() + 1, sizeof(char));
 					memcpy(pShaderProgram->pFragEntryPoint, pDesc->mFrag.mEntryPoint, pDesc->mFrag.mEntryPoint.size());
+					pShaderProgram->mContentHash = hashShaderStage(SHADER_STAGE_FRAG, create_info.pCode, (uint32_t)create_info.codeSize, pShaderProgram->pFragEntryPoint, pShaderProgram->mContentHash);
 				} break;
 				case SHADER_STAGE_COMP: {
-					createShaderReflection((const uint8_t*)pDesc->mComp.mCode.c_str(), pDesc->mComp.mCode.getLength(), SHADER_STAGE_COMP, &stageReflections[counter++]);
+					create_cached_shader_reflection(&pDesc->mComp, SHADER_STAGE_COMP, &stageReflections[counter++]);
 
 					memcpy(pShaderProgram->mNumThreadsPerGroup, stageReflections[counter - 1].mNumThreadsPerGroup, sizeof(pShaderProgram->mNumThreadsPerGroup));
 
@@ -2426,6 +2593,7 @@ namespace RENDERER_CPP_NAMESPACE {
 
 					pShaderProgram->pCompEntryPoint = (char*)conf_calloc(pDesc->mComp.mEntryPoint.size() + 1, sizeof(char));
 					memcpy(pShaderProgram->pCompEntryPoint, pDesc->mComp.mEntryPoint, pDesc->mComp.mEntryPoint.size());
+					pShaderProgram->mContentHash = hashShaderStage(SHADER_STAGE_COMP, create_info.pCode, (uint32_t)create_info.codeSize, pShaderProgram->pCompEntryPoint, pShaderProgram->mContentHash);
 				} break;
 				}
 			}
@@ -2767,6 +2935,14 @@ namespace RENDERER_CPP_NAMESPACE {
 		ASSERT(pDesc->pShaderProgram);
 		ASSERT(pDesc->pRootSignature);
 
+		uint64_t pipelineHash = hashGraphicsPipelineDesc(pRenderer, pDesc);
+		Pipeline* pExisting = acquire_registered_pipeline(pRenderer, pipelineHash, pDesc->pRootSignature);
+		if (pExisting)
+		{
+			*ppPipeline = pExisting;
+			return;
+		}
+
 		Pipeline* pPipeline = (Pipeline*)conf_calloc(1, sizeof(*pPipeline));
 		ASSERT(pPipeline);
 
@@ -3003,12 +3179,13 @@ namespace RENDERER_CPP_NAMESPACE {
 			add_info.subpass = 0;
 			add_info.basePipelineHandle = VK_NULL_HANDLE;
 			add_info.basePipelineIndex = -1;
-			VkResult vk_res = vkCreateGraphicsPipelines(pRenderer->pDevice, VK_NULL_HANDLE, 1, &add_info, NULL, &(pPipeline->pVkPipeline));
+			VkResult vk_res = vkCreateGraphicsPipelines(pRenderer->pDevice, pRenderer->pPipelineCache, 1, &add_info, NULL, &(pPipeline->pVkPipeline));
 			ASSERT(VK_SUCCESS == vk_res);
 
 			removeRenderPass(pRenderer, pRenderPass);
 		}
 
+		register_pipeline(pRenderer, pPipeline, pipelineHash);
 		*ppPipeline = pPipeline;
 	}
 
@@ -3021,6 +3198,14 @@ namespace RENDERER_CPP_NAMESPACE {
 		ASSERT(pRenderer->pDevice != VK_NULL_HANDLE);
 		ASSERT(pDesc->pShaderProgram->pVkComp != VK_NULL_HANDLE);
 
+		uint64_t pipelineHash = hashComputePipelineDesc(pDesc);
+		Pipeline* pExisting = acquire_registered_pipeline(pRenderer, pipelineHash, pDesc->pRootSignature);
+		if (pExisting)
+		{
+			*ppPipeline = pExisting;
+			return;
+		}
+
 		Pipeline* pPipeline = (Pipeline*)conf_calloc(1, sizeof(*pPipeline));
 		ASSERT(pPipeline);
 
@@ -3046,10 +3231,11 @@ namespace RENDERER_CPP_NAMESPACE {
 			create_info.layout = pDesc->pRootSignature->pPipelineLayout;
 			create_info.basePipelineHandle = 0;
 			create_info.basePipelineIndex = 0;
-			VkResult vk_res = vkCreateComputePipelines(pRenderer->pDevice, VK_NULL_HANDLE, 1, &create_info, NULL, &(pPipeline->pVkPipeline));
+			VkResult vk_res = vkCreateComputePipelines(pRenderer->pDevice, pRenderer->pPipelineCache, 1, &create_info, NULL, &(pPipeline->pVkPipeline));
 			ASSERT(VK_SUCCESS == vk_res);
 		}
 
+		register_pipeline(pRenderer, pPipeline, pipelineHash);
 		*ppPipeline = pPipeline;
 	}
 
@@ -3060,6 +3246,17 @@ namespace RENDERER_CPP_NAMESPACE {
 		ASSERT(VK_NULL_HANDLE != pRenderer->pDevice);
 		ASSERT(VK_NULL_HANDLE != pPipeline->pVkPipeline);
 
+		{
+			MutexLock lock(pRenderer->pPipelineRegistry->mMutex);
+			ASSERT(pPipeline->mRefCount);
+			if (--pPipeline->mRefCount)
+				return;
+
+			tinystl::unordered_map<uint64_t, Pipeline*>::iterator it = pRenderer->pPipelineRegistry->mPipelines.find(pPipeline->mPipelineHash);
+			if (it != pRenderer->pPipelineRegistry->mPipelines.end() && it->second == pPipeline)
+				pRenderer->pPipelineRegistry->mPipelines.erase(it);
+		}
+
 		vkDestroyPipeline(pRenderer->pDevice, pPipeline->pVkPipeline, NULL);
 
 		SAFE_FREE(pPipeline);
@@ -22,11 +22,13 @@
  * under the License.
 */
 
-#ifdef VULKAN
+#if defined(VULKAN) || defined(NULL_RENDERER)
 
 #include "../IRenderer.h"
 
 #include "../../Tools/SpirvTools/SpirvTools.h"
+#include "SpirvReflector.h"
+#include "../../OS/Interfaces/ILogManager.h"
 #include "../../OS/Interfaces/IMemoryManager.h"
 
 static DescriptorType sSPIRV_TO_DESCRIPTOR[SPIRV_TYPE_COUNT] =
@@ -70,6 +72,13 @@ void createShaderReflection(const uint8_t* shaderCode, uint32_t shaderSize, Shad
       return; // TODO: error msg
    }
 
+   SPIRV_Resource* pSpirvResources = NULL;
+   uint32_t spirvResourceCount = 0;
+   SPIRV_Variable* pSpirvVariables = NULL;
+   uint32_t spirvVariableCount = 0;
+
+#if defined(USE_SPIRV_CROSS_REFLECTION)
+   // Reference path through SPIRV-Cross. Kept around to validate the native reflector against
    CrossCompiler cc;
 
    CreateCrossCompiler((const uint32_t*)shaderCode, shaderSize / sizeof(uint32_t), &cc);
@@ -89,15 +98,44 @@ void createShaderReflection(const uint8_t* shaderCode, uint32_t shaderSize, Shad
 	   ReflectHullShaderControlPoint(&cc, &pOutReflection->mNumControlPoint);
    }
 
+   pSpirvResources = cc.pShaderResouces;
+   spirvResourceCount = cc.ShaderResourceCount;
+   pSpirvVariables = cc.pUniformVariables;
+   spirvVariableCount = cc.UniformVariablesCount;
+#else
+   SpirvReflection spirv;
+   if (!createSpirvReflection((const uint32_t*)shaderCode, shaderSize / sizeof(uint32_t), &spirv))
+   {
+      LOGERROR("Failed to reflect SPIR-V shader code");
+      return;
+   }
+
+   if (shaderStage == SHADER_STAGE_COMP)
+   {
+      pOutReflection->mNumThreadsPerGroup[0] = spirv.mWorkGroupSize[0];
+      pOutReflection->mNumThreadsPerGroup[1] = spirv.mWorkGroupSize[1];
+      pOutReflection->mNumThreadsPerGroup[2] = spirv.mWorkGroupSize[2];
+   }
+   else if (shaderStage == SHADER_STAGE_TESC)
+   {
+      pOutReflection->mNumControlPoint = spirv.mOutputVertexCount;
+   }
+
+   pSpirvResources = spirv.pShaderResources;
+   spirvResourceCount = spirv.mShaderResourceCount;
+   pSpirvVariables = spirv.pUniformVariables;
+   spirvVariableCount = spirv.mUniformVariableCount;
+#endif
+
    // lets find out the size of the name pool we need
    // also get number of resources while we are at it
    uint32_t namePoolSize      = 0;
    uint32_t vertexInputCount  = 0;
    uint32_t resouceCount      = 0;
    uint32_t variablesCount    = 0;
-   for(uint32_t i = 0; i < cc.ShaderResourceCount; ++i)
+   for(uint32_t i = 0; i < spirvResourceCount; ++i)
    {
-      SPIRV_Resource* resource = cc.pShaderResouces + i;
+      SPIRV_Resource* resource = pSpirvResources + i;
 
       // filter out what we don't use
       if(!filterResouce(resource, shaderStage))
@@ -115,12 +153,12 @@ void createShaderReflection(const uint8_t* shaderCode, uint32_t shaderSize, Shad
       }
    }
 
-   for(uint32_t i = 0; i < cc.UniformVariablesCount; ++i)
+   for(uint32_t i = 0; i < spirvVariableCount; ++i)
    {
-      SPIRV_Variable* variable = cc.pUniformVariables + i;
+      SPIRV_Variable* variable = pSpirvVariables + i;
 
       // check if parent buffer was filtered out
-      bool parentFiltered = filterResouce(cc.pShaderResouces + variable->parent_index, shaderStage);
+      bool parentFiltered = filterResouce(pSpirvResources + variable->parent_index, shaderStage);
 
       // filter out what we don't use
       // TODO: log warning
@@ -144,9 +182,9 @@ void createShaderReflection(const uint8_t* shaderCode, uint32_t shaderSize, Shad
       pVertexInputs = (VertexInput*)conf_malloc(sizeof(VertexInput) * vertexInputCount);
 
       uint32_t j = 0;
-      for(uint32_t i = 0; i < cc.ShaderResourceCount; ++i)
+      for(uint32_t i = 0; i < spirvResourceCount; ++i)
       {
-         SPIRV_Resource* resource = cc.pShaderResouces + i;
+         SPIRV_Resource* resource = pSpirvResources + i;
 
          // filter out what we don't use
          if(!filterResouce(resource, shaderStage) && resource->type == SPIRV_Resource_Type::SPIRV_TYPE_STAGE_INPUTS)
@@ -167,16 +205,16 @@ void createShaderReflection(const uint8_t* shaderCode, uint32_t shaderSize, Shad
    // continue with resources
    if(resouceCount)
    {
-      indexRemap = (uint32_t*)conf_malloc(sizeof(uint32_t) * cc.ShaderResourceCount);
+      indexRemap = (uint32_t*)conf_malloc(sizeof(uint32_t) * spirvResourceCount);
       pResources = (ShaderResource*)conf_malloc(sizeof(ShaderResource) * resouceCount);
 
       uint32_t j = 0;
-      for(uint32_t i = 0; i < cc.ShaderResourceCount; ++i)
+      for(uint32_t i = 0; i < spirvResourceCount; ++i)
       {
          // set index remap
          indexRemap[i] = (uint32_t)-1;
 
-         SPIRV_Resource* resource = cc.pShaderResouces + i;
+         SPIRV_Resource* resource = pSpirvResources + i;
 
          // filter out what we don't use
          if(!filterResouce(resource, shaderStage) && resource->type != SPIRV_Resource_Type::SPIRV_TYPE_STAGE_INPUTS)
@@ -207,12 +245,12 @@ void createShaderReflection(const uint8_t* shaderCode, uint32_t shaderSize, Shad
       pVariables = (ShaderVariable*)conf_malloc(sizeof(ShaderVariable) * variablesCount);
 
       uint32_t j = 0;
-      for(uint32_t i = 0; i < cc.UniformVariablesCount; ++i)
+      for(uint32_t i = 0; i < spirvVariableCount; ++i)
       {
-         SPIRV_Variable* variable = cc.pUniformVariables + i;
+         SPIRV_Variable* variable = pSpirvVariables + i;
 
          // check if parent buffer was filtered out
-         bool parentFiltered = filterResouce(cc.pShaderResouces + variable->parent_index, shaderStage);
+         bool parentFiltered = filterResouce(pSpirvResources + variable->parent_index, shaderStage);
 
          // filter out what we don't use
          if(variable->is_used && !parentFiltered)
@@ -232,7 +270,11 @@ void createShaderReflection(const uint8_t* shaderCode, uint32_t shaderSize, Shad
    }
 
    conf_free(indexRemap);
+#if defined(USE_SPIRV_CROSS_REFLECTION)
    DestroyCrossCompiler(&cc);
+#else
+   destroySpirvReflection(&spirv);
+#endif
 
    // all refection structs should be built now
    pOutReflection->mShaderStage = shaderStage;
@@ -249,4 +291,4 @@ void createShaderReflection(const uint8_t* shaderCode, uint32_t shaderSize, Shad
    pOutReflection->pVariables = pVariables;
    pOutReflection->mVariableCount = variablesCount;
 }
-#endif // #ifdef VULKAN
\ No newline at end of file
+#endif // #if defined(VULKAN) || defined(NULL_RENDERER)
\ No newline at end of file
@@ -29,6 +29,20 @@
     #endif // __SSE__
 #endif // _MSC_VER
 
+// libstdc++ only declares the float variants of the C math functions in the global namespace
+#include <cmath>
+#if defined(__GLIBCXX__)
+namespace std
+{
+    using ::acosf;
+    using ::cosf;
+    using ::fabsf;
+    using ::sinf;
+    using ::sqrtf;
+    using ::tanf;
+}
+#endif // __GLIBCXX__
+
 // Sony's library includes:
 #define VECTORMATH_FORCE_SCALAR_MODE 0
 
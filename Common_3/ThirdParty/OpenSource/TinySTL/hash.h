@@ -35,7 +35,7 @@
 #endif
 #include "../Nothings/stb_hash.h"
 
-#ifdef __APPLE__
+#if defined(__APPLE__) || defined(__linux__)
 #define __forceinline inline
 #endif
 
@@ -33,6 +33,7 @@ typedef long long unsigned int size_t;
 typedef unsigned int size_t;
 #elif defined (__linux__) && defined(__SIZE_TYPE__)
 typedef __SIZE_TYPE__ size_t;
+typedef __PTRDIFF_TYPE__ ptrdiff_t;
 #else
 #	include <stddef.h>
 #endif
@@ -0,0 +1,426 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "AssetPipeline.h"
+#include "../AssimpImporter/AssimpImporter.h"
+#include "../MeshOptimizer/MeshOptimizer.h"
+#include "../../ThirdParty/OpenSource/TinySTL/unordered_map.h"
+#include "../../OS/Interfaces/ILogManager.h" //NOTE: this should be the last include in a .cpp
+#include "../../OS/Interfaces/IMemoryManager.h" //NOTE: this should be the last include in a .cpp
+
+// Bump whenever the cooked output of any asset type changes so stale cache entries are rebuilt
+#define ASSET_COOK_VERSION 3
+
+static const char* gCookedExtensions[ASSET_TYPE_COUNT] =
+{
+	".dds",	// ASSET_TYPE_TEXTURE
+	".mesh",	// ASSET_TYPE_MESH
+};
+
+/************************************************************************/
+// Helpers
+/************************************************************************/
+struct CookManifestEntry
+{
+	String		mKey;
+	String		mCookedName;
+	Hash128		mContentKey;
+	uint64_t	mStamp;
+};
+
+enum CookResult
+{
+	COOK_RESULT_UP_TO_DATE = 0,
+	COOK_RESULT_CACHE_HIT,
+	COOK_RESULT_COOKED,
+	COOK_RESULT_FAILED,
+	// Content key computed but missing from the cache, resolved by the cook pass
+	COOK_RESULT_DIRTY,
+};
+
+struct CookTask
+{
+	const AssetCookDesc*		pDesc;
+	const String*				pCacheDir;
+	const CookManifestEntry*	pPrevious;
+	/// Index of the task in this run, makes the temporary output name unique
+	uint32_t					mIndex;
+	String						mSourcePath;
+	CookManifestEntry			mEntry;
+	CookResult					mResult;
+};
+
+static bool IsAbsolutePath(const String& path)
+{
+	return path.getLength() > 1 && (path[1U] == ':' || path[0U] == '/');
+}
+
+static bool ReadManifest(const String& fileName, tinystl::unordered_map<String, CookManifestEntry>* pEntries)
+{
+	if (!FileSystem::FileExists(fileName, FSR_Absolute))
+		return false;
+
+	File file;
+	if (!file.Open(fileName, FM_ReadBinary, FSR_Absolute))
+		return false;
+
+	if (file.ReadUInt() != COOK_MANIFEST_MAGIC || file.ReadUInt() != COOK_MANIFEST_VERSION)
+		return false;
+
+	unsigned entryCount = file.ReadUInt();
+	for (unsigned i = 0; i < entryCount && !file.IsEof(); ++i)
+	{
+		CookManifestEntry entry;
+		entry.mKey = file.ReadString();
+		entry.mCookedName = file.ReadString();
+		entry.mContentKey.mLow = (uint64_t)file.ReadInt64();
+		entry.mContentKey.mHigh = (uint64_t)file.ReadInt64();
+		entry.mStamp = (uint64_t)file.ReadInt64();
+		(*pEntries)[entry.mKey] = entry;
+	}
+	return true;
+}
+
+static bool WriteManifest(const String& fileName, const tinystl::unordered_map<String, CookManifestEntry>& entries)
+{
+	// Same as the cooked outputs: an interrupted write must not leave a truncated manifest behind for the next run
+	String tempName = fileName + ".tmp";
+	File file;
+	if (!file.Open(tempName, FM_WriteBinary, FSR_Absolute))
+		return false;
+
+	file.WriteUInt(COOK_MANIFEST_MAGIC);
+	file.WriteUInt(COOK_MANIFEST_VERSION);
+	file.WriteUInt((unsigned)entries.size());
+	for (tinystl::unordered_map<String, CookManifestEntry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+	{
+		const CookManifestEntry& entry = it->second;
+		file.WriteString(entry.mKey);
+		file.WriteString(entry.mCookedName);
+		file.WriteInt64((int64_t)entry.mContentKey.mLow);
+		file.WriteInt64((int64_t)entry.mContentKey.mHigh);
+		file.WriteInt64((int64_t)entry.mStamp);
+	}
+	file.Close();
+
+	if (!FileSystem::Rename(tempName, fileName))
+	{
+		FileSystem::Delete(tempName);
+		return false;
+	}
+	return true;
+}
+
+static uint64_t HashValue(uint64_t hash, uint64_t value)
+{
+	return XXHash64(&value, sizeof(value), hash);
+}
+
+static uint64_t HashFloat(uint64_t hash, float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return HashValue(hash, bits);
+}
+
+// Everything besides the source bytes which changes the cooked output
+static uint64_t HashCookParameters(const AssetCookDesc* pDesc)
+{
+	uint64_t hash = HashValue(0, ASSET_COOK_VERSION);
+	hash = HashValue(hash, pDesc->mType);
+	if (pDesc->mType == ASSET_TYPE_TEXTURE)
+	{
+		hash = HashValue(hash, pDesc->mMipLevels);
+	}
+	else if (pDesc->mType == ASSET_TYPE_MESH)
+	{
+		if (pDesc->pOptimizerDesc)
+		{
+			const MeshOptimizerDesc* pOpt = pDesc->pOptimizerDesc;
+			hash = HashValue(hash, pOpt->mVertexCacheAlgorithm);
+			hash = HashValue(hash, pOpt->mCacheSize);
+			hash = HashFloat(hash, pOpt->mOverdrawThreshold);
+			hash = HashValue(hash, pOpt->mOptimizeVertexFetch);
+		}
+		if (pDesc->pLodDesc)
+		{
+			const MeshLodDesc* pLod = pDesc->pLodDesc;
+			hash = HashValue(hash, pLod->mLodCount);
+			hash = HashFloat(hash, pLod->mReductionPerLod);
+			hash = HashFloat(hash, pLod->mMaxRelativeError);
+		}
+	}
+	return hash;
+}
+
+// Source and dependency paths resolved against their root (dependencies share the root of the source)
+static void GetInputPaths(const AssetCookDesc* pDesc, tinystl::vector<String>* pOutPaths)
+{
+	pOutPaths->push_back(FileSystem::FixPath(pDesc->mSource, pDesc->mRoot));
+	for (uint32_t i = 0; i < (uint32_t)pDesc->mDependencies.size(); ++i)
+		pOutPaths->push_back(FileSystem::FixPath(pDesc->mDependencies[i], pDesc->mRoot));
+}
+
+static bool CookTexture(const String& sourcePath, const String& cookedPath, const AssetCookDesc* pDesc)
+{
+	Image image;
+	if (!image.loadImage(sourcePath.c_str(), true, NULL, NULL, FSR_Absolute))
+		return false;
+
+	if (image.GetMipMapCount() <= 1 && pDesc->mMipLevels > 1 && !image.GenerateMipMaps(pDesc->mMipLevels))
+		LOGWARNINGF("Could not generate mips for %s, cooking the top level only", sourcePath.c_str());
+
+	bool result = image.iSaveDDS(cookedPath.c_str());
+	image.Destroy();
+	return result;
+}
+
+static bool CookMesh(const String& sourcePath, const String& cookedPath, const AssetCookDesc* pDesc)
+{
+	File file;
+	if (!file.Open(cookedPath, FM_WriteBinary, FSR_Absolute))
+		return false;
+
+	// Assets are already cooked in parallel so the import itself runs on this thread
+	Model model;
+	bool result = AssimpImporter::ImportModel(sourcePath.c_str(), &model, pDesc->pOptimizerDesc, pDesc->pLodDesc, NULL, &file);
+	file.Close();
+	return result;
+}
+
+static void HashAsset(void* pData)
+{
+	CookTask* pTask = (CookTask*)pData;
+	const AssetCookDesc* pDesc = pTask->pDesc;
+
+	tinystl::vector<String> inputs;
+	GetInputPaths(pDesc, &inputs);
+
+	// Cheap stamp from timestamps and sizes: identical to the last cook means nothing needs to be read
+	uint64_t paramHash = HashCookParameters(pDesc);
+	uint64_t stamp = paramHash;
+	tinystl::vector<File> files(inputs.size());
+	for (uint32_t i = 0; i < (uint32_t)inputs.size(); ++i)
+	{
+		if (!files[i].Open(inputs[i], FM_ReadBinary, FSR_Absolute))
+		{
+			pTask->mResult = COOK_RESULT_FAILED;
+			return;
+		}
+		stamp = HashValue(stamp, FileSystem::GetLastModifiedTime(inputs[i]));
+		stamp = HashValue(stamp, files[i].GetSize());
+	}
+
+	const CookManifestEntry* pPrevious = pTask->pPrevious;
+	if (pPrevious && pPrevious->mStamp == stamp && FileSystem::FileExists(*pTask->pCacheDir + pPrevious->mCookedName, FSR_Absolute))
+	{
+		pTask->mEntry = *pPrevious;
+		pTask->mResult = COOK_RESULT_UP_TO_DATE;
+		return;
+	}
+
+	// Content key from the actual bytes, streamed so large sources are never fully resident
+	ContentHasher hasher(paramHash);
+	tinystl::vector<uint8_t> block(CONTENT_HASH_BLOCK_SIZE);
+	for (uint32_t i = 0; i < (uint32_t)files.size(); ++i)
+	{
+		uint64_t size = files[i].GetSize();
+		hasher.Update(&size, sizeof(size));
+		while (!files[i].IsEof())
+		{
+			unsigned readBytes = files[i].Read(block.data(), CONTENT_HASH_BLOCK_SIZE);
+			if (!readBytes)
+				break;
+			hasher.Update(block.data(), readBytes);
+		}
+		files[i].Close();
+	}
+	Hash128 contentKey = hasher.Digest128();
+
+	String cookedName;
+	cookedName.sprintf("%016llx%016llx%s", (unsigned long long)contentKey.mHigh, (unsigned long long)contentKey.mLow, gCookedExtensions[pDesc->mType]);
+
+	pTask->mSourcePath = inputs[0];
+	pTask->mEntry.mCookedName = cookedName;
+	pTask->mEntry.mContentKey = contentKey;
+	pTask->mEntry.mStamp = stamp;
+	pTask->mResult = FileSystem::FileExists(*pTask->pCacheDir + cookedName, FSR_Absolute) ? COOK_RESULT_CACHE_HIT : COOK_RESULT_DIRTY;
+}
+
+static void CookAsset(void* pData)
+{
+	CookTask* pTask = (CookTask*)pData;
+	const AssetCookDesc* pDesc = pTask->pDesc;
+
+	// The output only appears under its content key once it is complete, so a crash or a concurrent cook of
+	// another process can never leave a truncated file behind that later runs would take for a cache hit
+	String cookedPath = *pTask->pCacheDir + pTask->mEntry.mCookedName;
+	String tempPath;
+	tempPath.sprintf("%s.%u.tmp", cookedPath.c_str(), pTask->mIndex);
+
+	bool cooked = false;
+	switch (pDesc->mType)
+	{
+		case ASSET_TYPE_TEXTURE: cooked = CookTexture(pTask->mSourcePath, tempPath, pDesc); break;
+		case ASSET_TYPE_MESH: cooked = CookMesh(pTask->mSourcePath, tempPath, pDesc); break;
+		default: ASSERT(false); break;
+	}
+
+	if (cooked && !FileSystem::Rename(tempPath, cookedPath))
+	{
+		LOGERRORF("Could not move %s to %s", tempPath.c_str(), cookedPath.c_str());
+		cooked = false;
+	}
+
+	if (!cooked)
+	{
+		// Only the temporary file belongs to this task, the cooked path may hold a valid output of another cook
+		LOGERRORF("Failed to cook %s", pTask->mSourcePath.c_str());
+		FileSystem::Delete(tempPath);
+		pTask->mResult = COOK_RESULT_FAILED;
+		return;
+	}
+
+	LOGINFOF("Cooked %s -> %s", pTask->mSourcePath.c_str(), pTask->mEntry.mCookedName.c_str());
+	pTask->mResult = COOK_RESULT_COOKED;
+}
+
+static void RunCookTasks(CookTask** ppTasks, uint32_t taskCount, void (*pFunc)(void*), ThreadPool* pThreadPool)
+{
+	if (!pThreadPool || taskCount < 2)
+	{
+		for (uint32_t i = 0; i < taskCount; ++i)
+			pFunc(ppTasks[i]);
+		return;
+	}
+
+	tinystl::vector<WorkItem> workItems(taskCount);
+	for (uint32_t i = 0; i < taskCount; ++i)
+	{
+		workItems[i].pFunc = pFunc;
+		workItems[i].pData = ppTasks[i];
+		pThreadPool->AddWorkItem(&workItems[i]);
+	}
+	pThreadPool->Complete(0);
+}
+
+/************************************************************************/
+// AssetPipeline
+/************************************************************************/
+bool AssetPipeline::Cook(const char* pCacheDir, const AssetCookDesc* pAssets, uint32_t assetCount, ThreadPool* pThreadPool, AssetCookStatistics* pOutStats)
+{
+	// iSaveDDS and FixPath only leave absolute paths alone
+	String cacheDir = FileSystem::GetInternalPath(pCacheDir);
+	if (!IsAbsolutePath(cacheDir))
+		cacheDir = FileSystem::GetCurrentDir() + cacheDir;
+	cacheDir = FileSystem::AddTrailingSlash(cacheDir);
+
+	if (!FileSystem::DirExists(cacheDir) && !FileSystem::CreateDir(cacheDir))
+	{
+		LOGERRORF("Could not create asset cache directory %s", cacheDir.c_str());
+		return false;
+	}
+
+	const String manifestPath = cacheDir + COOK_MANIFEST_FILE_NAME;
+	tinystl::unordered_map<String, CookManifestEntry> manifest;
+	ReadManifest(manifestPath, &manifest);
+
+	tinystl::vector<CookTask> tasks(assetCount);
+	tinystl::vector<CookTask*> pendingTasks(assetCount);
+	for (uint32_t i = 0; i < assetCount; ++i)
+	{
+		CookTask& task = tasks[i];
+		task.pDesc = &pAssets[i];
+		task.pCacheDir = &cacheDir;
+		task.mIndex = i;
+		task.mEntry.mKey = FileSystem::GetCookManifestKey(pAssets[i].mSource, pAssets[i].mRoot);
+		tinystl::unordered_map<String, CookManifestEntry>::iterator it = manifest.find(task.mEntry.mKey);
+		task.pPrevious = it != manifest.end() ? &it->second : NULL;
+		task.mResult = COOK_RESULT_FAILED;
+		pendingTasks[i] = &task;
+	}
+
+	RunCookTasks(pendingTasks.data(), assetCount, HashAsset, pThreadPool);
+
+	// Assets with equal content keys (copies, the same source listed twice) produce the same output.
+	// Only the first one is cooked, the others pick up its result afterwards
+	tinystl::unordered_map<String, CookTask*> cookTasksByKey;
+	tinystl::vector<CookTask*> duplicateTasks;
+	pendingTasks.clear();
+	for (uint32_t i = 0; i < assetCount; ++i)
+	{
+		if (tasks[i].mResult != COOK_RESULT_DIRTY)
+			continue;
+
+		tinystl::unordered_map<String, CookTask*>::iterator it = cookTasksByKey.find(tasks[i].mEntry.mCookedName);
+		if (it != cookTasksByKey.end())
+		{
+			duplicateTasks.push_back(&tasks[i]);
+			continue;
+		}
+		cookTasksByKey[tasks[i].mEntry.mCookedName] = &tasks[i];
+		pendingTasks.push_back(&tasks[i]);
+	}
+
+	RunCookTasks(pendingTasks.data(), (uint32_t)pendingTasks.size(), CookAsset, pThreadPool);
+
+	for (uint32_t i = 0; i < (uint32_t)duplicateTasks.size(); ++i)
+	{
+		const CookTask* pOwner = cookTasksByKey[duplicateTasks[i]->mEntry.mCookedName];
+		duplicateTasks[i]->mResult = pOwner->mResult == COOK_RESULT_COOKED ? COOK_RESULT_CACHE_HIT : COOK_RESULT_FAILED;
+	}
+
+	// Entries of assets which were not part of this run are kept so partial cooks stay incremental
+	AssetCookStatistics stats = {};
+	for (uint32_t i = 0; i < assetCount; ++i)
+	{
+		switch (tasks[i].mResult)
+		{
+			case COOK_RESULT_UP_TO_DATE: ++stats.mUpToDate; break;
+			case COOK_RESULT_CACHE_HIT: ++stats.mCacheHits; break;
+			case COOK_RESULT_COOKED: ++stats.mCooked; break;
+			default: ++stats.mFailed; break;
+		}
+
+		tinystl::unordered_map<String, CookManifestEntry>::iterator it = manifest.find(tasks[i].mEntry.mKey);
+		if (tasks[i].mResult != COOK_RESULT_FAILED)
+			manifest[tasks[i].mEntry.mKey] = tasks[i].mEntry;
+		else if (it != manifest.end())
+			manifest.erase(it);
+	}
+
+	if (!WriteManifest(manifestPath, manifest))
+	{
+		LOGERRORF("Could not write cook manifest %s", manifestPath.c_str());
+		return false;
+	}
+
+	LOGINFOF("Asset cook: %u up to date, %u cache hits, %u cooked, %u failed",
+		stats.mUpToDate, stats.mCacheHits, stats.mCooked, stats.mFailed);
+
+	if (pOutStats)
+		*pOutStats = stats;
+
+	return stats.mFailed == 0;
+}
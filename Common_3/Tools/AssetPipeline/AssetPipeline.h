@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../../ThirdParty/OpenSource/TinySTL/string.h"
+#include "../../ThirdParty/OpenSource/TinySTL/vector.h"
+
+#include "../../OS/Interfaces/IOperatingSystem.h"
+#include "../../OS/Interfaces/IFileSystem.h"
+#include "../../OS/Interfaces/IThread.h"
+#include "../../OS/Image/Image.h"
+
+struct MeshOptimizerDesc;
+struct MeshLodDesc;
+
+enum AssetType
+{
+	/// Any stb / EXR readable image, cooked to DDS with a full mip chain
+	ASSET_TYPE_TEXTURE = 0,
+	/// Any Assimp readable scene, cooked to an AssimpImporter mesh stream (see AssimpImporter::ReadMesh)
+	ASSET_TYPE_MESH,
+	ASSET_TYPE_COUNT,
+};
+
+struct AssetCookDesc
+{
+	String						mSource;
+	FSRoot						mRoot = FSR_Textures;
+	AssetType					mType = ASSET_TYPE_TEXTURE;
+	/// Texture: number of mip levels to generate (ALL_MIPLEVELS for a full chain)
+	uint32_t					mMipLevels = ALL_MIPLEVELS;
+	/// Mesh: optional MeshOptimizer pass applied while cooking
+	const MeshOptimizerDesc*	pOptimizerDesc = NULL;
+	/// Mesh: optional LOD chain generated after the optimizer pass, stored in the cooked mesh
+	const MeshLodDesc*			pLodDesc = NULL;
+	/// Additional files read by the source (material libraries, textures referenced by a scene...).
+	/// They are part of the content key so changing them rebuilds the asset
+	tinystl::vector<String>		mDependencies;
+};
+
+struct AssetCookStatistics
+{
+	/// Source and dependencies unchanged since the last cook, nothing was read
+	uint32_t	mUpToDate;
+	/// Source changed but its content key is already in the cache (reverted edits, touched files, copies)
+	uint32_t	mCacheHits;
+	uint32_t	mCooked;
+	uint32_t	mFailed;
+};
+
+/// Incremental asset cook pipeline.
+/// Every asset gets a 128 bit content key (ContentHasher) built from its source bytes, its dependencies and its cook parameters.
+/// Cooked outputs are stored by content key in a local cache directory together with a manifest (COOK_MANIFEST_FILE_NAME).
+/// Assets whose source and dependency timestamps did not change are skipped without being read,
+/// everything else is hashed and only cooked when its key is missing from the cache. Dirty assets are cooked in parallel,
+/// once per content key, to a temporary file which is renamed into place when complete.
+/// At runtime FileSystem::LoadCookManifest loads the manifest and FileSystem::GetCookedPath returns the cooked output of a source.
+class AssetPipeline
+{
+public:
+	/// pCacheDir is created if needed. Returns false if any asset failed to cook
+	static bool Cook(const char* pCacheDir, const AssetCookDesc* pAssets, uint32_t assetCount, ThreadPool* pThreadPool = NULL, AssetCookStatistics* pOutStats = NULL);
+};
@@ -43,6 +43,7 @@
 #include "../../ThirdParty/OpenSource/assimp/3.3.1/include/assimp/DefaultLogger.hpp"
 
 #include "AssimpImporter.h"
+#include "../MeshOptimizer/MeshOptimizer.h"
 #include "../../OS/Interfaces/ILogManager.h" //NOTE: this should be the last include in a .cpp
 #include "../../OS/Interfaces/IMemoryManager.h" //NOTE: this should be the last include in a .cpp
 
@@ -85,138 +86,270 @@ static void GetNameFromAiString(tinystl::unordered_map<tinystl::string, size_t>*
 	}
 }
 
-static void CalculateBoundingBox(const aiMesh* mesh, float& minX, float& minY, float& minZ, float& maxX, float& maxY, float& maxZ)
+// Mesh blocks written by ImportModel when a mesh stream is given
+#define MESH_STREAM_MAGIC 0x4853454D // 'MESH'
+#define MESH_STREAM_VERSION 2
+
+enum MeshStreamFlags
 {
-#define aisgl_min(x,y) (x<y?x:y)
-#define aisgl_max(x,y) (y>x?y:x)
-	for (size_t t = 0; t < mesh->mNumVertices; ++t)
-	{
-		aiVector3D tmp = mesh->mVertices[t];
-		minX = aisgl_min(minX, tmp.x);
-		minY = aisgl_min(minY, tmp.y);
-		minZ = aisgl_min(minZ, tmp.z);
-
-		maxX = aisgl_max(maxX, tmp.x);
-		maxY = aisgl_max(maxY, tmp.y);
-		maxZ = aisgl_max(maxZ, tmp.z);
-	}
-#undef aisgl_min
-#undef aisgl_max
-}
+	MESH_STREAM_NORMALS = 0x1,
+	MESH_STREAM_TANGENTS = 0x2,
+	MESH_STREAM_UVS = 0x4,
+};
 
-static void CreateGeom(const aiMesh* mesh, const char* name, Mesh* pMesh)
+static void CreateGeom(const aiMesh* mesh, Mesh* pMesh)
 {
-	float minX = 0.0f, minY = 0.0f, minZ = 0.0f, maxX = 0.0f, maxY = 0.0f, maxZ = 0.0f;
-	CalculateBoundingBox(mesh, minX, minY, minZ, maxX, maxY, maxZ);
-
-	//transform.bLocked = false;
-	////calculate an offset to keep the mesh centered around the transformation to make adjustments easier.
-	float offsetX = 0.0f;//(maxX - minX) * 0.5f;
-	float offsetY = 0.0f;//(maxY - minY) * 0.5f;
-	float offsetZ = 0.0f;//(maxZ - minZ) * 0.5f;
-						 //transform.mLocalTransform.setTranslation(vec3(offsetX, offsetY, offsetZ));
-
-	BoundingBox BB; //Corrected Bounding Box
-	BB.vMin = float3(minX - offsetX, minY - offsetY, minZ - offsetZ);
-	BB.vMax = float3(maxX - offsetX, maxY - offsetY, maxZ - offsetZ);
-
-	const int sizeVerts = mesh->mNumVertices * 3;
-	const int sizeNorm = mesh->mNumVertices * 3;
-	const int sizeTang = mesh->mNumVertices * 3;
-	const int sizeBino = mesh->mNumVertices * 3;
-	const int sizeUV = mesh->HasTextureCoords(0) ? mesh->mNumVertices * 2 : 0;
-	const int sizeInde = mesh->mNumFaces * 3;
-
-	//generate non-congruant buffers first
-	//INDICES/////////////////////////////////////////////////////////////////
-	unsigned int* indexBuffer = (unsigned int*)conf_calloc(sizeInde, sizeof(unsigned int));
-	if (sizeInde > 0)
+	static_assert(sizeof(aiVector3D) == sizeof(float3), "aiVector3D and float3 need to match to copy streams directly");
+
+	const uint32_t vertexCount = mesh->mNumVertices;
+
+	// Size every stream once and write straight into the final storage
+	pMesh->mPositions.resize(vertexCount);
+	pMesh->mIndices.resize(mesh->mNumFaces * 3);
+
+	//POSITIONS + BOUNDS//////////////////////////////////////////////////////
+	// Bounds are accumulated with the SIMD vector types while the data is hot in the cache
+	vec3 minBounds(0.0f);
+	vec3 maxBounds(0.0f);
+	if (vertexCount)
 	{
-		for (unsigned int i = 0; i < mesh->mNumFaces; i++)
-		{
-			const aiFace& face = mesh->mFaces[i];
-			unsigned int j = i * 3;
-			memcpy(&indexBuffer[j], face.mIndices, sizeof(unsigned int) * 3);
-		}
+		const aiVector3D& first = mesh->mVertices[0];
+		minBounds = vec3(first.x, first.y, first.z);
+		maxBounds = minBounds;
 	}
-	//TEXTURE COORDS//////////////////////////////////////////////////////////
-	float* uvBuffer = (float*)conf_calloc(sizeUV, sizeof(float));
-	if (sizeUV > 0)
+
+	float3* pPositions = pMesh->mPositions.data();
+	for (uint32_t i = 0; i < vertexCount; ++i)
 	{
-		for (unsigned int i = 0; i < mesh->mNumVertices; i++)
-		{
-			aiVector3D uv = mesh->mTextureCoords[0][i];
-			unsigned int j = i * 2;
-			memcpy(&uvBuffer[j], &uv, sizeof(float) * 2);
-		}
+		const aiVector3D& pos = mesh->mVertices[i];
+		const vec3 v(pos.x, pos.y, pos.z);
+		minBounds = minPerElem(minBounds, v);
+		maxBounds = maxPerElem(maxBounds, v);
+		memcpy(&pPositions[i], &pos, sizeof(float3));
 	}
 
-	pMesh->mPositions.resize(mesh->mNumVertices);
-	for (uint32_t i = 0; i < mesh->mNumVertices; ++i)
+	pMesh->mBounds.vMin = float3(minBounds.getX(), minBounds.getY(), minBounds.getZ());
+	pMesh->mBounds.vMax = float3(maxBounds.getX(), maxBounds.getY(), maxBounds.getZ());
+
+	//INDICES/////////////////////////////////////////////////////////////////
+	// aiProcess_Triangulate and aiProcess_SortByPType leave only triangles, anything else would corrupt the index buffer
+	uint32_t* pIndices = pMesh->mIndices.data();
+	uint32_t indexCount = 0;
+	for (uint32_t i = 0; i < mesh->mNumFaces; ++i)
 	{
-		pMesh->mPositions[i] = float3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+		const aiFace& face = mesh->mFaces[i];
+		if (face.mNumIndices != 3)
+			continue;
+		memcpy(&pIndices[indexCount], face.mIndices, sizeof(uint32_t) * 3);
+		indexCount += 3;
 	}
+	pMesh->mIndices.resize(indexCount);
 
+	//NORMALS + TANGENTS//////////////////////////////////////////////////////
 	if (mesh->HasNormals())
 	{
-		pMesh->mNormals.resize(mesh->mNumVertices);
-		for (uint32_t i = 0; i < mesh->mNumVertices; ++i)
-		{
-			pMesh->mNormals[i] = float3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
-		}
+		pMesh->mNormals.resize(vertexCount);
+		memcpy(pMesh->mNormals.data(), mesh->mNormals, vertexCount * sizeof(float3));
 	}
 
 	if (mesh->HasTangentsAndBitangents())
 	{
-		pMesh->mTangents.resize(mesh->mNumVertices);
-		pMesh->mBitangents.resize(mesh->mNumVertices);
-
-		for (uint32_t i = 0; i < mesh->mNumVertices; ++i)
-		{
-			pMesh->mTangents[i] = float3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
-			pMesh->mBitangents[i] = float3(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
-		}
+		pMesh->mTangents.resize(vertexCount);
+		pMesh->mBitangents.resize(vertexCount);
+		memcpy(pMesh->mTangents.data(), mesh->mTangents, vertexCount * sizeof(float3));
+		memcpy(pMesh->mBitangents.data(), mesh->mBitangents, vertexCount * sizeof(float3));
 	}
 
+	//TEXTURE COORDS//////////////////////////////////////////////////////////
 	if (mesh->HasTextureCoords(0))
 	{
-		pMesh->mUvs.resize(mesh->mNumVertices);
-		memcpy(pMesh->mUvs.data(), uvBuffer, mesh->mNumVertices * sizeof(float2));
+		pMesh->mUvs.resize(vertexCount);
+		float2* pUvs = pMesh->mUvs.data();
+		const aiVector3D* pSrc = mesh->mTextureCoords[0];
+		for (uint32_t i = 0; i < vertexCount; ++i)
+			memcpy(&pUvs[i], &pSrc[i], sizeof(float2));
+	}
+}
+
+struct ImportMeshTask
+{
+	const aiMesh*				pAiMesh;
+	Mesh*						pMesh;
+	const MeshOptimizerDesc*	pOptimizerDesc;
+	const MeshLodDesc*			pLodDesc;
+};
+
+static void ImportMesh(void* pData)
+{
+	ImportMeshTask* pTask = (ImportMeshTask*)pData;
+
+	CreateGeom(pTask->pAiMesh, pTask->pMesh);
+	pTask->pMesh->mMaterialId = pTask->pAiMesh->mMaterialIndex;
+
+	if (pTask->pOptimizerDesc)
+		AssimpImporter::OptimizeMesh(pTask->pMesh, pTask->pOptimizerDesc);
+
+	if (pTask->pLodDesc)
+		AssimpImporter::GenerateLods(pTask->pMesh, pTask->pLodDesc);
+}
+
+static void RunImportMeshTasks(ImportMeshTask* pTasks, uint32_t taskCount, ThreadPool* pThreadPool)
+{
+	if (!pThreadPool || taskCount < 2)
+	{
+		for (uint32_t i = 0; i < taskCount; ++i)
+			ImportMesh(&pTasks[i]);
+		return;
 	}
 
-	pMesh->mIndices.resize(sizeInde);
-	memcpy(pMesh->mIndices.data(), indexBuffer, sizeInde * sizeof(unsigned int));
+	tinystl::vector<WorkItem> workItems(taskCount);
+	for (uint32_t i = 0; i < taskCount; ++i)
+	{
+		workItems[i].pFunc = ImportMesh;
+		workItems[i].pData = &pTasks[i];
+		pThreadPool->AddWorkItem(&workItems[i]);
+	}
 
-	pMesh->mBounds = BB;
+	// The calling thread takes part in the work and returns once every mesh is done
+	pThreadPool->Complete(0);
+}
 
-	if (indexBuffer)
+static void WriteMesh(Serializer* pStream, const Mesh* pMesh)
+{
+	const uint32_t vertexCount = (uint32_t)pMesh->mPositions.size();
+	const uint32_t indexCount = (uint32_t)pMesh->mIndices.size();
+	const uint32_t lodCount = (uint32_t)pMesh->mLods.size();
+	uint32_t flags = 0;
+	if (!pMesh->mNormals.empty())
+		flags |= MESH_STREAM_NORMALS;
+	if (!pMesh->mTangents.empty())
+		flags |= MESH_STREAM_TANGENTS;
+	if (!pMesh->mUvs.empty())
+		flags |= MESH_STREAM_UVS;
+
+	pStream->WriteUInt(MESH_STREAM_MAGIC);
+	pStream->WriteUInt(MESH_STREAM_VERSION);
+	pStream->WriteUInt(pMesh->mMaterialId);
+	pStream->WriteUInt(flags);
+	pStream->WriteUInt(vertexCount);
+	pStream->WriteUInt(indexCount);
+	pStream->WriteUInt(lodCount);
+	pStream->WriteVector3(pMesh->mBounds.vMin);
+	pStream->WriteVector3(pMesh->mBounds.vMax);
+
+	pStream->Write(pMesh->mLods.data(), lodCount * sizeof(MeshLod));
+	pStream->Write(pMesh->mIndices.data(), indexCount * sizeof(uint32_t));
+	pStream->Write(pMesh->mPositions.data(), vertexCount * sizeof(float3));
+	if (flags & MESH_STREAM_NORMALS)
+		pStream->Write(pMesh->mNormals.data(), vertexCount * sizeof(float3));
+	if (flags & MESH_STREAM_TANGENTS)
 	{
-		conf_free(indexBuffer);
+		pStream->Write(pMesh->mTangents.data(), vertexCount * sizeof(float3));
+		pStream->Write(pMesh->mBitangents.data(), vertexCount * sizeof(float3));
 	}
-	if (uvBuffer)
+	if (flags & MESH_STREAM_UVS)
+		pStream->Write(pMesh->mUvs.data(), vertexCount * sizeof(float2));
+}
+
+bool AssimpImporter::ReadMesh(Deserializer* pStream, Mesh* pMesh)
+{
+	if (pStream->ReadUInt() != MESH_STREAM_MAGIC || pStream->ReadUInt() != MESH_STREAM_VERSION)
 	{
-		conf_free(uvBuffer);
+		LOGERRORF("%s is not a mesh stream or was written by a different version", pStream->GetName().c_str());
+		return false;
 	}
+
+	pMesh->mMaterialId = pStream->ReadUInt();
+	const uint32_t flags = pStream->ReadUInt();
+	const uint32_t vertexCount = pStream->ReadUInt();
+	const uint32_t indexCount = pStream->ReadUInt();
+	const uint32_t lodCount = pStream->ReadUInt();
+	pMesh->mBounds.vMin = pStream->ReadVector3();
+	pMesh->mBounds.vMax = pStream->ReadVector3();
+
+	if (lodCount > MESH_MAX_LODS)
+	{
+		LOGERRORF("%s holds a mesh with %u LODs, at most %u are supported", pStream->GetName().c_str(), lodCount, MESH_MAX_LODS);
+		return false;
+	}
+
+	pMesh->mLods.resize(lodCount);
+	pMesh->mIndices.resize(indexCount);
+	pMesh->mPositions.resize(vertexCount);
+	pStream->Read(pMesh->mLods.data(), lodCount * sizeof(MeshLod));
+	pStream->Read(pMesh->mIndices.data(), indexCount * sizeof(uint32_t));
+	pStream->Read(pMesh->mPositions.data(), vertexCount * sizeof(float3));
+	if (flags & MESH_STREAM_NORMALS)
+	{
+		pMesh->mNormals.resize(vertexCount);
+		pStream->Read(pMesh->mNormals.data(), vertexCount * sizeof(float3));
+	}
+	if (flags & MESH_STREAM_TANGENTS)
+	{
+		pMesh->mTangents.resize(vertexCount);
+		pMesh->mBitangents.resize(vertexCount);
+		pStream->Read(pMesh->mTangents.data(), vertexCount * sizeof(float3));
+		pStream->Read(pMesh->mBitangents.data(), vertexCount * sizeof(float3));
+	}
+	if (flags & MESH_STREAM_UVS)
+	{
+		pMesh->mUvs.resize(vertexCount);
+		pStream->Read(pMesh->mUvs.data(), vertexCount * sizeof(float2));
+	}
+
+	return true;
 }
 
-static void CollectMeshes(const aiScene* pScene, Model* pModel, tinystl::unordered_map<tinystl::string, size_t>* pMap)
+static void CollectMeshes(const aiScene* pScene, Model* pModel, tinystl::unordered_map<tinystl::string, size_t>* pMap,
+	const MeshOptimizerDesc* pOptimizerDesc, const MeshLodDesc* pLodDesc, ThreadPool* pThreadPool, Serializer* pMeshStream)
 {
 	//Set the size of the geometryList
 	pModel->mGeometryNameList.resize(pScene->mNumMeshes);
 
+	//Naming touches the shared name map so it stays on the calling thread
 	for (uint32_t i = 0; i < pScene->mNumMeshes; i++)
 	{
-		pModel->mMeshArray.push_back(Mesh());
-		//Get the mesh name
 		tinystl::string meshName = "";
 		GetNameFromAiString(pMap, pScene->mMeshes[i]->mName, meshName, pModel->mSceneName + "_mesh");
+		pModel->mGeometryNameList[i] = meshName;
+	}
+
+	if (!pMeshStream)
+	{
+		//parse geometry information of all meshes at once
+		pModel->mMeshArray.resize(pScene->mNumMeshes);
 
-		//parse geometry information
-		CreateGeom(pScene->mMeshes[i], (char*)meshName.c_str(), &pModel->mMeshArray.back());
-		pModel->mMeshArray.back().mMaterialId = pScene->mMeshes[i]->mMaterialIndex;
+		tinystl::vector<ImportMeshTask> tasks(pScene->mNumMeshes);
+		for (uint32_t i = 0; i < pScene->mNumMeshes; i++)
+			tasks[i] = { pScene->mMeshes[i], &pModel->mMeshArray[i], pOptimizerDesc, pLodDesc };
 
-		//Add the geometry component in the geometryList
-		pModel->mGeometryNameList[i] = meshName;
+		RunImportMeshTasks(tasks.data(), (uint32_t)tasks.size(), pThreadPool);
+		return;
+	}
+
+	//Streaming: only keep one batch of meshes alive, write it out in order and recycle the slots
+	const uint32_t batchSize = pThreadPool ? max(1U, pThreadPool->GetNumThreads() + 1) * 2 : 1;
+	tinystl::vector<Mesh> batch(batchSize);
+	tinystl::vector<ImportMeshTask> tasks(batchSize);
+
+	pMeshStream->WriteUInt(pScene->mNumMeshes);
+
+	for (uint32_t first = 0; first < pScene->mNumMeshes; first += batchSize)
+	{
+		const uint32_t count = min(batchSize, pScene->mNumMeshes - first);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			batch[i] = Mesh();
+			tasks[i] = { pScene->mMeshes[first + i], &batch[i], pOptimizerDesc, pLodDesc };
+		}
+
+		RunImportMeshTasks(tasks.data(), count, pThreadPool);
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			WriteMesh(pMeshStream, &batch[i]);
+			batch[i] = Mesh();
+		}
 	}
 }
 
@@ -276,7 +409,117 @@ static void CollectMaterials(const aiScene* pScene, Model* pModel, tinystl::unor
 	}
 }
 
-bool AssimpImporter::ImportModel(const char* filename, Model* pModel)
+void AssimpImporter::OptimizeMesh(Mesh* pMesh, const MeshOptimizerDesc* pOptimizerDesc)
+{
+	tinystl::vector<float3>* attributes[] = { &pMesh->mNormals, &pMesh->mTangents, &pMesh->mBitangents };
+
+	// Positions always go first so that mPositionStream can stay at zero
+	VertexStream streams[5] = {};
+	uint32_t streamCount = 0;
+	streams[streamCount++] = { pMesh->mPositions.data(), sizeof(float3) };
+	for (uint32_t i = 0; i < sizeof(attributes) / sizeof(attributes[0]); ++i)
+	{
+		if (!attributes[i]->empty())
+			streams[streamCount++] = { attributes[i]->data(), sizeof(float3) };
+	}
+	if (!pMesh->mUvs.empty())
+		streams[streamCount++] = { pMesh->mUvs.data(), sizeof(float2) };
+
+	MeshOptimizerDesc desc = *pOptimizerDesc;
+	desc.mPositionStream = 0;
+
+	uint32_t vertexCount = (uint32_t)pMesh->mPositions.size();
+	MeshOptimizerStatistics stats = {};
+	MeshOptimizer::OptimizeMesh(&desc, pMesh->mIndices.data(), (uint32_t)pMesh->mIndices.size(), streams, streamCount, &vertexCount, &stats);
+
+	// Streams were compacted in place, drop the unreferenced tail
+	pMesh->mPositions.resize(vertexCount);
+	for (uint32_t i = 0; i < sizeof(attributes) / sizeof(attributes[0]); ++i)
+	{
+		if (!attributes[i]->empty())
+			attributes[i]->resize(vertexCount);
+	}
+	if (!pMesh->mUvs.empty())
+		pMesh->mUvs.resize(vertexCount);
+
+	LOGINFOF("ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, vertices %u -> %u",
+		stats.mBefore.mACMR, stats.mAfter.mACMR, stats.mBefore.mATVR, stats.mAfter.mATVR, stats.mVertexCountBefore, stats.mVertexCountAfter);
+}
+
+void AssimpImporter::GenerateLods(Mesh* pMesh, const MeshLodDesc* pLodDesc)
+{
+	if (pMesh->mPositions.empty() || pMesh->mIndices.empty())
+		return;
+
+	MeshLod lods[MESH_MAX_LODS];
+	tinystl::vector<uint32_t> indices;
+	indices.reserve(pMesh->mIndices.size() * 2);
+
+	uint32_t lodCount = MeshSimplifier::GenerateLods(pLodDesc, pMesh->mIndices.data(), (uint32_t)pMesh->mIndices.size(),
+		&pMesh->mPositions[0].x, sizeof(float3), (uint32_t)pMesh->mPositions.size(), &indices, lods);
+
+	// Simplified LODs lose the vertex cache order of the source
+	for (uint32_t i = 1; i < lodCount; ++i)
+	{
+		uint32_t* pLodIndices = indices.data() + lods[i].mIndexOffset;
+		MeshOptimizer::OptimizeVertexCacheForsyth(pLodIndices, pLodIndices, lods[i].mIndexCount, (uint32_t)pMesh->mPositions.size());
+	}
+
+	pMesh->mIndices.swap(indices);
+	pMesh->mLods.resize(lodCount);
+	for (uint32_t i = 0; i < lodCount; ++i)
+	{
+		pMesh->mLods[i] = lods[i];
+		LOGINFOF("LOD %u: %u triangles, error %f", i, lods[i].mIndexCount / 3, lods[i].mError);
+	}
+}
+
+struct GenerateLodsTask
+{
+	Mesh*				pMesh;
+	const MeshLodDesc*	pLodDesc;
+};
+
+static void GenerateMeshLods(void* pData)
+{
+	GenerateLodsTask* pTask = (GenerateLodsTask*)pData;
+	AssimpImporter::GenerateLods(pTask->pMesh, pTask->pLodDesc);
+}
+
+void AssimpImporter::GenerateLods(Model* pModel, const MeshLodDesc* pLodDesc, ThreadPool* pThreadPool)
+{
+	// pTriangleMaterials indexes the triangles of a single mesh, it cannot be shared by all meshes of the model.
+	// Every Mesh has one material anyway so there are no material borders to preserve inside a mesh
+	MeshLodDesc lodDesc = *pLodDesc;
+	lodDesc.pTriangleMaterials = NULL;
+
+	const uint32_t meshCount = (uint32_t)pModel->mMeshArray.size();
+	tinystl::vector<GenerateLodsTask> tasks(meshCount);
+	for (uint32_t i = 0; i < meshCount; ++i)
+	{
+		tasks[i].pMesh = &pModel->mMeshArray[i];
+		tasks[i].pLodDesc = &lodDesc;
+	}
+
+	if (!pThreadPool || meshCount < 2)
+	{
+		for (uint32_t i = 0; i < meshCount; ++i)
+			GenerateMeshLods(&tasks[i]);
+		return;
+	}
+
+	tinystl::vector<WorkItem> workItems(meshCount);
+	for (uint32_t i = 0; i < meshCount; ++i)
+	{
+		workItems[i].pFunc = GenerateMeshLods;
+		workItems[i].pData = &tasks[i];
+		pThreadPool->AddWorkItem(&workItems[i]);
+	}
+	pThreadPool->Complete(0);
+}
+
+bool AssimpImporter::ImportModel(const char* filename, Model* pModel, const MeshOptimizerDesc* pOptimizerDesc, const MeshLodDesc* pLodDesc,
+	ThreadPool* pThreadPool, Serializer* pMeshStream)
 {
 	aiPropertyStore* propertyStore = aiCreatePropertyStore();
 	tinystl::unordered_map<tinystl::string, size_t> uniqueNameMap;
@@ -293,6 +536,9 @@ bool AssimpImporter::ImportModel(const char* filename, Model* pModel)
 	aiSetImportPropertyInteger(propertyStore, AI_CONFIG_PP_PTV_NORMALIZE, 1);
 
 	unsigned int flags = aiProcess_CalcTangentSpace | // calculate tangents and bitangents if possible
+		aiProcess_Triangulate | // split polygons, CreateGeom only reads triangles
+		aiProcess_JoinIdenticalVertices | // build an indexed mesh, formats like OBJ and STL come in unindexed
+		aiProcess_SortByPType | // required for AI_CONFIG_PP_SBP_REMOVE to drop the points and lines
 		aiProcess_ValidateDataStructure;
 
 	const aiScene* pScene = aiImportFileExWithProperties(filename, flags, nullptr, propertyStore);
@@ -303,7 +549,15 @@ bool AssimpImporter::ImportModel(const char* filename, Model* pModel)
 	pModel->mSceneName = ExtractSceneNameFromFileName(filename);
 
 	CollectMaterials(pScene, pModel, &uniqueNameMap);
-	CollectMeshes(pScene, pModel, &uniqueNameMap);
+	// Same as GenerateLods(Model*): pTriangleMaterials cannot describe the triangles of every mesh
+	MeshLodDesc lodDesc;
+	if (pLodDesc)
+	{
+		lodDesc = *pLodDesc;
+		lodDesc.pTriangleMaterials = NULL;
+	}
+
+	CollectMeshes(pScene, pModel, &uniqueNameMap, pOptimizerDesc, pLodDesc ? &lodDesc : NULL, pThreadPool, pMeshStream);
 
 	if (pScene)
 	{
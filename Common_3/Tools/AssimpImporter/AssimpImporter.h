@@ -41,6 +41,11 @@
 #include "../../OS/Math/MathTypes.h"
 
 #include "../../OS/Interfaces/IOperatingSystem.h"
+#include "../../OS/Interfaces/IFileSystem.h"
+#include "../../OS/Interfaces/IThread.h"
+#include "../MeshOptimizer/MeshSimplifier.h"
+
+struct MeshOptimizerDesc;
 
 struct BoundingBox
 {
@@ -189,7 +194,9 @@ struct Mesh
 	tinystl::vector <float3>	mTangents;
 	tinystl::vector <float3>	mBitangents;
 	tinystl::vector <float2>	mUvs;
+	/// Holds every LOD back to back when mLods is not empty (LOD 0 first)
 	tinystl::vector <uint32_t>	mIndices;
+	tinystl::vector <MeshLod>	mLods;
 	BoundingBox					mBounds;
 	uint32_t					mMaterialId;
 };
@@ -208,5 +215,19 @@ struct Model
 class AssimpImporter
 {
 public:
-	static bool ImportModel(const char* filename, Model* outModel);
+	/// Optionally runs the MeshOptimizer pipeline on every imported mesh (vertex cache, overdraw and vertex fetch order)
+	/// followed by GenerateLods when a LOD description is given (pLodDesc->pTriangleMaterials is ignored).
+	/// With a thread pool the meshes are imported concurrently.
+	/// With a mesh stream the meshes are written out batch by batch (mesh count followed by one block per mesh, see ReadMesh)
+	/// instead of being kept in outModel->mMeshArray, which keeps peak memory bounded for very large scenes.
+	static bool ImportModel(const char* filename, Model* outModel, const MeshOptimizerDesc* pOptimizerDesc = NULL, const MeshLodDesc* pLodDesc = NULL,
+		ThreadPool* pThreadPool = NULL, Serializer* pMeshStream = NULL);
+	static void OptimizeMesh(Mesh* pMesh, const MeshOptimizerDesc* pOptimizerDesc);
+	/// Replaces mIndices with a LOD chain sharing the mesh vertices and fills mLods. Run it after OptimizeMesh
+	static void GenerateLods(Mesh* pMesh, const MeshLodDesc* pLodDesc);
+	/// Generates the LOD chains of all meshes, one work item per mesh when a thread pool is given.
+	/// pLodDesc->pTriangleMaterials is ignored since it describes the triangles of a single mesh
+	static void GenerateLods(Model* pModel, const MeshLodDesc* pLodDesc, ThreadPool* pThreadPool = NULL);
+	/// Reads one mesh block written by ImportModel to a mesh stream
+	static bool ReadMesh(Deserializer* pStream, Mesh* pOutMesh);
 };
\ No newline at end of file
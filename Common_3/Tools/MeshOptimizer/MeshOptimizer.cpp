@@ -0,0 +1,633 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include <algorithm>
+
+#include "MeshOptimizer.h"
+#include "../../OS/Interfaces/ILogManager.h" //NOTE: this should be the last include in a .cpp
+#include "../../OS/Interfaces/IMemoryManager.h" //NOTE: this should be the last include in a .cpp
+
+#define FORSYTH_CACHE_SIZE 32
+#define FORSYTH_CACHE_DECAY_POWER 1.5f
+#define FORSYTH_LAST_TRI_SCORE 0.75f
+#define FORSYTH_VALENCE_BOOST_SCALE 2.0f
+#define FORSYTH_VALENCE_BOOST_POWER 0.5f
+
+/************************************************************************/
+// Helpers
+/************************************************************************/
+// Triangle adjacency in CSR layout: the triangles using vertex v are pTriangles[pOffsets[v] .. pOffsets[v] + pCounts[v]]
+struct TriangleAdjacency
+{
+	tinystl::vector<uint32_t> mCounts;
+	tinystl::vector<uint32_t> mOffsets;
+	tinystl::vector<uint32_t> mTriangles;
+};
+
+static void BuildTriangleAdjacency(TriangleAdjacency* pAdjacency, const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount)
+{
+	pAdjacency->mCounts.resize(vertexCount, 0);
+	pAdjacency->mOffsets.resize(vertexCount);
+	pAdjacency->mTriangles.resize(indexCount);
+
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		ASSERT(pIndices[i] < vertexCount);
+		++pAdjacency->mCounts[pIndices[i]];
+	}
+
+	uint32_t offset = 0;
+	for (uint32_t v = 0; v < vertexCount; ++v)
+	{
+		pAdjacency->mOffsets[v] = offset;
+		offset += pAdjacency->mCounts[v];
+	}
+
+	// Fill using the offsets as cursors and rewind them afterwards
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t v = pIndices[i];
+		pAdjacency->mTriangles[pAdjacency->mOffsets[v]++] = i / 3;
+	}
+
+	for (uint32_t v = 0; v < vertexCount; ++v)
+		pAdjacency->mOffsets[v] -= pAdjacency->mCounts[v];
+}
+
+// Returns a pointer to the source indices that stays valid while pDst is being written
+static const uint32_t* GetSourceIndices(uint32_t* pDst, const uint32_t* pIndices, uint32_t indexCount, tinystl::vector<uint32_t>& copy)
+{
+	if (pDst != pIndices)
+		return pIndices;
+
+	copy.resize(indexCount);
+	memcpy(copy.data(), pIndices, indexCount * sizeof(uint32_t));
+	return copy.data();
+}
+
+static inline float3 GetPosition(const float* pPositions, uint32_t positionStride, uint32_t index)
+{
+	const float* p = (const float*)((const uint8_t*)pPositions + (size_t)index * positionStride);
+	return float3(p[0], p[1], p[2]);
+}
+
+static inline float3 Cross(const float3& a, const float3& b)
+{
+	return float3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+static inline float Dot(const float3& a, const float3& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+/************************************************************************/
+// Statistics
+/************************************************************************/
+VertexCacheStatistics MeshOptimizer::AnalyzeVertexCache(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+{
+	ASSERT(indexCount % 3 == 0);
+
+	VertexCacheStatistics stats = {};
+	if (!indexCount)
+		return stats;
+
+	// FIFO cache: a vertex is resident as long as less than cacheSize misses happened since it was loaded
+	tinystl::vector<uint32_t> cacheTimestamps(vertexCount, 0U);
+	uint32_t timestamp = cacheSize + 1;
+	uint32_t referencedVertices = 0;
+
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t v = pIndices[i];
+		ASSERT(v < vertexCount);
+
+		if (!cacheTimestamps[v])
+			++referencedVertices;
+
+		if (timestamp - cacheTimestamps[v] > cacheSize)
+		{
+			cacheTimestamps[v] = timestamp++;
+			++stats.mVerticesTransformed;
+		}
+	}
+
+	stats.mACMR = (float)stats.mVerticesTransformed / (float)(indexCount / 3);
+	stats.mATVR = (float)stats.mVerticesTransformed / (float)referencedVertices;
+
+	return stats;
+}
+/************************************************************************/
+// Forsyth
+/************************************************************************/
+struct ForsythScoreTable
+{
+	float mCache[FORSYTH_CACHE_SIZE];
+	float mValence[FORSYTH_CACHE_SIZE];
+
+	ForsythScoreTable()
+	{
+		for (uint32_t i = 0; i < FORSYTH_CACHE_SIZE; ++i)
+		{
+			// The last triangle's vertices get a fixed score so that fans/strips are not strictly preferred over their neighbours
+			mCache[i] = i < 3 ? FORSYTH_LAST_TRI_SCORE :
+				powf(1.0f - (float)(i - 3) / (float)(FORSYTH_CACHE_SIZE - 3), FORSYTH_CACHE_DECAY_POWER);
+			// Boost vertices with few remaining triangles to get rid of lone triangles early
+			mValence[i] = i == 0 ? 0.0f : FORSYTH_VALENCE_BOOST_SCALE * powf((float)i, -FORSYTH_VALENCE_BOOST_POWER);
+		}
+	}
+};
+
+static inline float ForsythVertexScore(const ForsythScoreTable& table, int cachePosition, uint32_t liveTriangles)
+{
+	if (liveTriangles == 0)
+		return -1.0f;
+
+	float score = cachePosition >= 0 ? table.mCache[cachePosition] : 0.0f;
+	return score + table.mValence[min(liveTriangles, (uint32_t)FORSYTH_CACHE_SIZE - 1)];
+}
+
+void MeshOptimizer::OptimizeVertexCacheForsyth(uint32_t* pDst, const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount)
+{
+	ASSERT(indexCount % 3 == 0);
+
+	static const ForsythScoreTable table;
+
+	tinystl::vector<uint32_t> indexCopy;
+	pIndices = GetSourceIndices(pDst, pIndices, indexCount, indexCopy);
+
+	const uint32_t triangleCount = indexCount / 3;
+	if (!triangleCount)
+		return;
+
+	TriangleAdjacency adjacency;
+	BuildTriangleAdjacency(&adjacency, pIndices, indexCount, vertexCount);
+
+	// mCounts now tracks the live (not yet emitted) triangles of each vertex
+	tinystl::vector<uint32_t>& liveTriangles = adjacency.mCounts;
+	tinystl::vector<int> cachePositions(vertexCount, -1);
+	tinystl::vector<float> vertexScores(vertexCount);
+	tinystl::vector<float> triangleScores(triangleCount);
+	tinystl::vector<bool> emitted(triangleCount, false);
+
+	for (uint32_t v = 0; v < vertexCount; ++v)
+		vertexScores[v] = ForsythVertexScore(table, -1, liveTriangles[v]);
+
+	for (uint32_t t = 0; t < triangleCount; ++t)
+		triangleScores[t] = vertexScores[pIndices[t * 3 + 0]] + vertexScores[pIndices[t * 3 + 1]] + vertexScores[pIndices[t * 3 + 2]];
+
+	uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+	uint32_t newCache[FORSYTH_CACHE_SIZE + 3];
+	uint32_t cacheCount = 0;
+
+	uint32_t bestTriangle = 0;
+	float bestScore = triangleScores[0];
+	for (uint32_t t = 1; t < triangleCount; ++t)
+	{
+		if (triangleScores[t] > bestScore)
+		{
+			bestScore = triangleScores[t];
+			bestTriangle = t;
+		}
+	}
+
+	uint32_t inputCursor = 0;
+	uint32_t outputTriangle = 0;
+
+	while (outputTriangle < triangleCount)
+	{
+		const uint32_t* tri = &pIndices[bestTriangle * 3];
+
+		pDst[outputTriangle * 3 + 0] = tri[0];
+		pDst[outputTriangle * 3 + 1] = tri[1];
+		pDst[outputTriangle * 3 + 2] = tri[2];
+		++outputTriangle;
+
+		emitted[bestTriangle] = true;
+		triangleScores[bestTriangle] = -1.0f;
+
+		// Remove the triangle from the live lists of its vertices
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			uint32_t v = tri[k];
+			uint32_t* pList = &adjacency.mTriangles[adjacency.mOffsets[v]];
+			uint32_t count = liveTriangles[v];
+			for (uint32_t j = 0; j < count; ++j)
+			{
+				if (pList[j] == bestTriangle)
+				{
+					pList[j] = pList[count - 1];
+					break;
+				}
+			}
+			--liveTriangles[v];
+		}
+
+		// Move the triangle's vertices to the front of the LRU cache
+		uint32_t newCacheCount = 0;
+		newCache[newCacheCount++] = tri[0];
+		newCache[newCacheCount++] = tri[1];
+		newCache[newCacheCount++] = tri[2];
+		for (uint32_t i = 0; i < cacheCount; ++i)
+		{
+			uint32_t v = cache[i];
+			if (v != tri[0] && v != tri[1] && v != tri[2])
+				newCache[newCacheCount++] = v;
+		}
+
+		// Vertices falling out of the cache lose their position score
+		for (uint32_t i = FORSYTH_CACHE_SIZE; i < newCacheCount; ++i)
+		{
+			uint32_t v = newCache[i];
+			cachePositions[v] = -1;
+			vertexScores[v] = ForsythVertexScore(table, -1, liveTriangles[v]);
+		}
+
+		cacheCount = min(newCacheCount, (uint32_t)FORSYTH_CACHE_SIZE);
+		memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+
+		for (uint32_t i = 0; i < cacheCount; ++i)
+		{
+			uint32_t v = cache[i];
+			cachePositions[v] = (int)i;
+			vertexScores[v] = ForsythVertexScore(table, (int)i, liveTriangles[v]);
+		}
+
+		// Only triangles touching the cache can have changed their score, the best one is among them in almost every case
+		bestScore = -1.0f;
+		for (uint32_t i = 0; i < cacheCount; ++i)
+		{
+			uint32_t v = cache[i];
+			const uint32_t* pList = &adjacency.mTriangles[adjacency.mOffsets[v]];
+			for (uint32_t j = 0; j < liveTriangles[v]; ++j)
+			{
+				uint32_t t = pList[j];
+				const uint32_t* other = &pIndices[t * 3];
+				float score = vertexScores[other[0]] + vertexScores[other[1]] + vertexScores[other[2]];
+				triangleScores[t] = score;
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = t;
+				}
+			}
+		}
+
+		// Dead end: continue with the next unprocessed triangle in input order
+		if (bestScore < 0.0f)
+		{
+			while (inputCursor < triangleCount && emitted[inputCursor])
+				++inputCursor;
+			bestTriangle = inputCursor;
+		}
+	}
+}
+/************************************************************************/
+// Tipsify
+/************************************************************************/
+void MeshOptimizer::OptimizeVertexCacheTipsify(uint32_t* pDst, const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+{
+	ASSERT(indexCount % 3 == 0);
+
+	tinystl::vector<uint32_t> indexCopy;
+	pIndices = GetSourceIndices(pDst, pIndices, indexCount, indexCopy);
+
+	const uint32_t triangleCount = indexCount / 3;
+	if (!triangleCount)
+		return;
+
+	TriangleAdjacency adjacency;
+	BuildTriangleAdjacency(&adjacency, pIndices, indexCount, vertexCount);
+
+	tinystl::vector<uint32_t> liveTriangles(adjacency.mCounts);
+	tinystl::vector<uint32_t> cacheTimestamps(vertexCount, 0U);
+	tinystl::vector<bool> emitted(triangleCount, false);
+	tinystl::vector<uint32_t> deadEndStack;
+	tinystl::vector<uint32_t> candidates;
+	deadEndStack.reserve(indexCount);
+
+	uint32_t timestamp = cacheSize + 1;
+	uint32_t inputCursor = 0;
+	uint32_t outputIndex = 0;
+	int fanningVertex = (int)pIndices[0];
+
+	while (fanningVertex >= 0)
+	{
+		candidates.clear();
+
+		// Emit all remaining triangles around the fanning vertex
+		const uint32_t* pList = &adjacency.mTriangles[adjacency.mOffsets[fanningVertex]];
+		for (uint32_t j = 0; j < adjacency.mCounts[fanningVertex]; ++j)
+		{
+			uint32_t t = pList[j];
+			if (emitted[t])
+				continue;
+
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				uint32_t v = pIndices[t * 3 + k];
+				pDst[outputIndex++] = v;
+				deadEndStack.push_back(v);
+				candidates.push_back(v);
+				--liveTriangles[v];
+
+				if (timestamp - cacheTimestamps[v] > cacheSize)
+					cacheTimestamps[v] = timestamp++;
+			}
+
+			emitted[t] = true;
+		}
+
+		// Pick the candidate which will still be in the cache after its remaining triangles have been emitted and is the oldest
+		int nextVertex = -1;
+		int bestPriority = -1;
+		for (uint32_t i = 0; i < (uint32_t)candidates.size(); ++i)
+		{
+			uint32_t v = candidates[i];
+			if (!liveTriangles[v])
+				continue;
+
+			int priority = 0;
+			if (timestamp - cacheTimestamps[v] + 2 * liveTriangles[v] <= cacheSize)
+				priority = (int)(timestamp - cacheTimestamps[v]);
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				nextVertex = (int)v;
+			}
+		}
+
+		// Dead end: go back to recently used vertices first, then scan the input
+		while (nextVertex < 0 && !deadEndStack.empty())
+		{
+			uint32_t v = deadEndStack.back();
+			deadEndStack.pop_back();
+			if (liveTriangles[v])
+				nextVertex = (int)v;
+		}
+
+		while (nextVertex < 0 && inputCursor < vertexCount)
+		{
+			if (liveTriangles[inputCursor])
+				nextVertex = (int)inputCursor;
+			else
+				++inputCursor;
+		}
+
+		fanningVertex = nextVertex;
+	}
+
+	ASSERT(outputIndex == indexCount);
+}
+/************************************************************************/
+// Overdraw
+/************************************************************************/
+struct OverdrawCluster
+{
+	uint32_t	mFirstTriangle;
+	uint32_t	mTriangleCount;
+	float		mSortKey;
+};
+
+static inline uint32_t SimulateTriangle(const uint32_t* tri, uint32_t* pCacheTimestamps, uint32_t& timestamp, uint32_t cacheSize)
+{
+	uint32_t misses = 0;
+	for (uint32_t k = 0; k < 3; ++k)
+	{
+		if (timestamp - pCacheTimestamps[tri[k]] > cacheSize)
+		{
+			pCacheTimestamps[tri[k]] = timestamp++;
+			++misses;
+		}
+	}
+	return misses;
+}
+
+void MeshOptimizer::OptimizeOverdraw(uint32_t* pDst, const uint32_t* pIndices, uint32_t indexCount, const float* pPositions, uint32_t positionStride, uint32_t vertexCount, uint32_t cacheSize, float threshold)
+{
+	ASSERT(indexCount % 3 == 0);
+	ASSERT(pPositions);
+
+	tinystl::vector<uint32_t> indexCopy;
+	pIndices = GetSourceIndices(pDst, pIndices, indexCount, indexCopy);
+
+	const uint32_t triangleCount = indexCount / 3;
+	if (!triangleCount)
+		return;
+
+	// Hard boundaries: triangles where the cache had to be refilled completely. Reordering at those points costs nothing
+	tinystl::vector<uint32_t> hardBoundaries;
+	tinystl::vector<uint32_t> cacheTimestamps(vertexCount, 0U);
+	uint32_t timestamp = cacheSize + 1;
+
+	for (uint32_t t = 0; t < triangleCount; ++t)
+	{
+		uint32_t misses = SimulateTriangle(&pIndices[t * 3], cacheTimestamps.data(), timestamp, cacheSize);
+		if (t == 0 || misses == 3)
+			hardBoundaries.push_back(t);
+	}
+	hardBoundaries.push_back(triangleCount);
+
+	// Soft boundaries: split hard clusters further while the local ACMR stays within threshold of the cluster ACMR
+	tinystl::vector<OverdrawCluster> clusters;
+	for (uint32_t h = 0; h + 1 < (uint32_t)hardBoundaries.size(); ++h)
+	{
+		const uint32_t start = hardBoundaries[h];
+		const uint32_t end = hardBoundaries[h + 1];
+
+		timestamp += cacheSize + 1;
+		uint32_t clusterMisses = 0;
+		for (uint32_t t = start; t < end; ++t)
+			clusterMisses += SimulateTriangle(&pIndices[t * 3], cacheTimestamps.data(), timestamp, cacheSize);
+
+		const float clusterThreshold = threshold * (float)clusterMisses / (float)(end - start);
+
+		timestamp += cacheSize + 1;
+		uint32_t runningMisses = 0;
+		uint32_t clusterStart = start;
+		for (uint32_t t = start; t < end; ++t)
+		{
+			runningMisses += SimulateTriangle(&pIndices[t * 3], cacheTimestamps.data(), timestamp, cacheSize);
+
+			if ((float)runningMisses / (float)(t + 1 - clusterStart) <= clusterThreshold || t + 1 == end)
+			{
+				OverdrawCluster cluster = { clusterStart, t + 1 - clusterStart, 0.0f };
+				clusters.push_back(cluster);
+
+				clusterStart = t + 1;
+				runningMisses = 0;
+				timestamp += cacheSize + 1;
+			}
+		}
+	}
+
+	// Area weighted mesh centroid
+	float3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	for (uint32_t t = 0; t < triangleCount; ++t)
+	{
+		float3 p0 = GetPosition(pPositions, positionStride, pIndices[t * 3 + 0]);
+		float3 p1 = GetPosition(pPositions, positionStride, pIndices[t * 3 + 1]);
+		float3 p2 = GetPosition(pPositions, positionStride, pIndices[t * 3 + 2]);
+		float3 n = Cross(p1 - p0, p2 - p0);
+		float area = sqrtf(Dot(n, n));
+		meshCentroid += (p0 + p1 + p2) * (area / 3.0f);
+		meshArea += area;
+	}
+	meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : float3(0.0f);
+
+	// Clusters facing away from the centroid are the likely occluders from most view points so they go first
+	for (uint32_t c = 0; c < (uint32_t)clusters.size(); ++c)
+	{
+		OverdrawCluster& cluster = clusters[c];
+		float3 centroid(0.0f);
+		float3 normal(0.0f);
+		float area = 0.0f;
+
+		for (uint32_t t = cluster.mFirstTriangle; t < cluster.mFirstTriangle + cluster.mTriangleCount; ++t)
+		{
+			float3 p0 = GetPosition(pPositions, positionStride, pIndices[t * 3 + 0]);
+			float3 p1 = GetPosition(pPositions, positionStride, pIndices[t * 3 + 1]);
+			float3 p2 = GetPosition(pPositions, positionStride, pIndices[t * 3 + 2]);
+			float3 n = Cross(p1 - p0, p2 - p0);
+			float triangleArea = sqrtf(Dot(n, n));
+			centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+			normal += n;
+			area += triangleArea;
+		}
+
+		centroid = area > 0.0f ? centroid / area : centroid;
+		float normalLength = sqrtf(Dot(normal, normal));
+		normal = normalLength > 0.0f ? normal / normalLength : normal;
+
+		cluster.mSortKey = Dot(centroid - meshCentroid, normal);
+	}
+
+	std::sort(clusters.begin(), clusters.end(), [](const OverdrawCluster& a, const OverdrawCluster& b)
+	{
+		// Tie break on the original position to keep the result deterministic across platforms
+		return a.mSortKey > b.mSortKey || (a.mSortKey == b.mSortKey && a.mFirstTriangle < b.mFirstTriangle);
+	});
+
+	uint32_t outputIndex = 0;
+	for (uint32_t c = 0; c < (uint32_t)clusters.size(); ++c)
+	{
+		const OverdrawCluster& cluster = clusters[c];
+		memcpy(&pDst[outputIndex], &pIndices[cluster.mFirstTriangle * 3], cluster.mTriangleCount * 3 * sizeof(uint32_t));
+		outputIndex += cluster.mTriangleCount * 3;
+	}
+
+	ASSERT(outputIndex == indexCount);
+}
+/************************************************************************/
+// Vertex fetch
+/************************************************************************/
+uint32_t MeshOptimizer::GenerateVertexFetchRemap(uint32_t* pRemap, const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount)
+{
+	memset(pRemap, 0xFF, vertexCount * sizeof(uint32_t));
+
+	uint32_t nextVertex = 0;
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t v = pIndices[i];
+		ASSERT(v < vertexCount);
+
+		if (pRemap[v] == ~0u)
+			pRemap[v] = nextVertex++;
+	}
+
+	return nextVertex;
+}
+
+void MeshOptimizer::RemapIndexBuffer(uint32_t* pDst, const uint32_t* pIndices, uint32_t indexCount, const uint32_t* pRemap)
+{
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		ASSERT(pRemap[pIndices[i]] != ~0u);
+		pDst[i] = pRemap[pIndices[i]];
+	}
+}
+
+void MeshOptimizer::RemapVertexStream(VertexStream* pStream, uint32_t vertexCount, const uint32_t* pRemap)
+{
+	const uint32_t stride = pStream->mStride;
+	uint8_t* pData = (uint8_t*)pStream->pData;
+
+	tinystl::vector<uint8_t> copy((size_t)vertexCount * stride);
+	memcpy(copy.data(), pData, (size_t)vertexCount * stride);
+
+	for (uint32_t v = 0; v < vertexCount; ++v)
+	{
+		if (pRemap[v] != ~0u)
+			memcpy(pData + (size_t)pRemap[v] * stride, copy.data() + (size_t)v * stride, stride);
+	}
+}
+/************************************************************************/
+// Pipeline
+/************************************************************************/
+void MeshOptimizer::OptimizeMesh(const MeshOptimizerDesc* pDesc, uint32_t* pIndices, uint32_t indexCount, VertexStream* pStreams, uint32_t streamCount, uint32_t* pVertexCount, MeshOptimizerStatistics* pOutStats)
+{
+	ASSERT(pDesc);
+	ASSERT(pVertexCount);
+
+	const uint32_t vertexCount = *pVertexCount;
+	MeshOptimizerStatistics stats = {};
+	stats.mVertexCountBefore = vertexCount;
+	stats.mBefore = AnalyzeVertexCache(pIndices, indexCount, vertexCount, pDesc->mCacheSize);
+
+	switch (pDesc->mVertexCacheAlgorithm)
+	{
+	case VERTEX_CACHE_FORSYTH:
+		OptimizeVertexCacheForsyth(pIndices, pIndices, indexCount, vertexCount);
+		break;
+	case VERTEX_CACHE_TIPSIFY:
+		OptimizeVertexCacheTipsify(pIndices, pIndices, indexCount, vertexCount, pDesc->mCacheSize);
+		break;
+	default:
+		break;
+	}
+
+	if (pDesc->mOverdrawThreshold > 0.0f && pDesc->mPositionStream < streamCount)
+	{
+		const VertexStream& positions = pStreams[pDesc->mPositionStream];
+		OptimizeOverdraw(pIndices, pIndices, indexCount, (const float*)positions.pData, positions.mStride, vertexCount, pDesc->mCacheSize, pDesc->mOverdrawThreshold);
+	}
+
+	uint32_t newVertexCount = vertexCount;
+	if (pDesc->mOptimizeVertexFetch)
+	{
+		tinystl::vector<uint32_t> remap(vertexCount);
+		newVertexCount = GenerateVertexFetchRemap(remap.data(), pIndices, indexCount, vertexCount);
+		RemapIndexBuffer(pIndices, pIndices, indexCount, remap.data());
+		for (uint32_t i = 0; i < streamCount; ++i)
+			RemapVertexStream(&pStreams[i], vertexCount, remap.data());
+	}
+
+	stats.mVertexCountAfter = newVertexCount;
+	stats.mAfter = AnalyzeVertexCache(pIndices, indexCount, newVertexCount, pDesc->mCacheSize);
+
+	*pVertexCount = newVertexCount;
+	if (pOutStats)
+		*pOutStats = stats;
+}
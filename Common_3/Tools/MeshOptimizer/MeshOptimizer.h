@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../../ThirdParty/OpenSource/TinySTL/vector.h"
+#include "../../OS/Math/MathTypes.h"
+
+#define MESH_OPTIMIZER_DEFAULT_CACHE_SIZE 16U
+
+enum VertexCacheAlgorithm
+{
+	/// Tom Forsyth's "Linear-Speed Vertex Cache Optimisation" (LRU cache model)
+	VERTEX_CACHE_FORSYTH = 0,
+	/// Sander et al. "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (FIFO cache model)
+	VERTEX_CACHE_TIPSIFY,
+	VERTEX_CACHE_NONE,
+};
+
+/// Post-transform vertex cache statistics of an indexed triangle list simulated with a FIFO cache
+struct VertexCacheStatistics
+{
+	uint32_t	mVerticesTransformed;
+	/// Average cache miss ratio: transformed vertices per triangle (0.5 is optimal for large grids, 3.0 is worst)
+	float		mACMR;
+	/// Average transformed vertex ratio: transformed vertices per referenced vertex (1.0 is optimal)
+	float		mATVR;
+};
+
+struct MeshOptimizerStatistics
+{
+	VertexCacheStatistics	mBefore;
+	VertexCacheStatistics	mAfter;
+	uint32_t				mVertexCountBefore;
+	uint32_t				mVertexCountAfter;
+};
+
+/// Interleaved or planar vertex attribute stream which gets reordered together with the positions
+struct VertexStream
+{
+	void*		pData;
+	uint32_t	mStride;
+};
+
+struct MeshOptimizerDesc
+{
+	VertexCacheAlgorithm	mVertexCacheAlgorithm = VERTEX_CACHE_FORSYTH;
+	/// Size of the simulated FIFO cache used by Tipsify, overdraw clustering and statistics
+	uint32_t				mCacheSize = MESH_OPTIMIZER_DEFAULT_CACHE_SIZE;
+	/// Maximum allowed ACMR degradation when splitting clusters for overdraw sorting (1.05 = 5%). 0 disables the overdraw pass
+	float					mOverdrawThreshold = 1.05f;
+	/// Reorder (and compact) all vertex streams in the order they are first referenced by the index buffer
+	bool					mOptimizeVertexFetch = true;
+	/// Index into the stream array of the stream holding the positions (three floats at offset zero)
+	uint32_t				mPositionStream = 0;
+};
+
+/// Offline / load time index and vertex reordering. All functions work on 32 bit indexed triangle lists.
+/// Destination and source index buffers are allowed to alias.
+class MeshOptimizer
+{
+public:
+	static VertexCacheStatistics AnalyzeVertexCache(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize = MESH_OPTIMIZER_DEFAULT_CACHE_SIZE);
+
+	static void OptimizeVertexCacheForsyth(uint32_t* pDst, const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount);
+	static void OptimizeVertexCacheTipsify(uint32_t* pDst, const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize = MESH_OPTIMIZER_DEFAULT_CACHE_SIZE);
+
+	/// Splits an already cache optimized index buffer into clusters and sorts them front-to-back relative to the mesh centroid
+	/// so that outward facing clusters are drawn first and occlude the rest from most view directions
+	static void OptimizeOverdraw(uint32_t* pDst, const uint32_t* pIndices, uint32_t indexCount, const float* pPositions, uint32_t positionStride, uint32_t vertexCount, uint32_t cacheSize = MESH_OPTIMIZER_DEFAULT_CACHE_SIZE, float threshold = 1.05f);
+
+	/// Fills pRemap with the new location of every vertex in order of first use. Unreferenced vertices get ~0u.
+	/// Returns the number of referenced vertices
+	static uint32_t GenerateVertexFetchRemap(uint32_t* pRemap, const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount);
+	static void RemapIndexBuffer(uint32_t* pDst, const uint32_t* pIndices, uint32_t indexCount, const uint32_t* pRemap);
+	static void RemapVertexStream(VertexStream* pStream, uint32_t vertexCount, const uint32_t* pRemap);
+
+	/// Runs the complete pipeline (vertex cache -> overdraw -> vertex fetch) on one mesh.
+	/// pVertexCount is updated with the number of vertices left after compacting the streams.
+	static void OptimizeMesh(const MeshOptimizerDesc* pDesc, uint32_t* pIndices, uint32_t indexCount, VertexStream* pStreams, uint32_t streamCount, uint32_t* pVertexCount, MeshOptimizerStatistics* pOutStats = NULL);
+};
@@ -0,0 +1,668 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include <algorithm>
+#include <float.h>
+
+#include "MeshSimplifier.h"
+#include "../../OS/Interfaces/ILogManager.h" //NOTE: this should be the last include in a .cpp
+#include "../../OS/Interfaces/IMemoryManager.h" //NOTE: this should be the last include in a .cpp
+
+// Faces whose normal rotates further than this (cosine) by a collapse are considered flipped
+#define SIMPLIFIER_FLIP_COS_THRESHOLD 0.25f
+// Open / seam edges get a perpendicular plane quadric scaled by this factor so they are not eroded
+#define SIMPLIFIER_BORDER_WEIGHT 10.0
+
+/************************************************************************/
+// Helpers
+/************************************************************************/
+enum SimplifierVertexKind
+{
+	// Interior vertex with a single attribute set: can collapse along any edge
+	VERTEX_KIND_MANIFOLD = 0,
+	// Vertex on a single open / material border: can only collapse along that border
+	VERTEX_KIND_BORDER,
+	// Vertex with two attribute sets on a single seam: can only collapse along the seam, both sides at once
+	VERTEX_KIND_SEAM,
+	// Anything more complex (corners, non manifold fans, seam ends)
+	VERTEX_KIND_LOCKED,
+};
+
+// Open addressing hash table for directed edges (a << 32 | b) -> triangle index
+class EdgeHashTable
+{
+public:
+	void Init(uint32_t count)
+	{
+		uint32_t capacity = 16;
+		while (capacity < count * 2)
+			capacity *= 2;
+		mKeys.clear();
+		mKeys.resize(capacity, ~0ULL);
+		mValues.resize(capacity);
+		mMask = capacity - 1;
+	}
+
+	void Insert(uint32_t a, uint32_t b, uint32_t value)
+	{
+		uint64_t key = Key(a, b);
+		uint32_t slot = Find(key);
+		mKeys[slot] = key;
+		mValues[slot] = value;
+	}
+
+	bool Lookup(uint32_t a, uint32_t b, uint32_t* pValue = NULL) const
+	{
+		uint64_t key = Key(a, b);
+		uint32_t slot = Find(key);
+		if (mKeys[slot] != key)
+			return false;
+		if (pValue)
+			*pValue = mValues[slot];
+		return true;
+	}
+
+private:
+	static uint64_t Key(uint32_t a, uint32_t b) { return ((uint64_t)a << 32) | b; }
+
+	uint32_t Find(uint64_t key) const
+	{
+		uint64_t h = key * 0x9E3779B97F4A7C15ULL;
+		uint32_t slot = (uint32_t)(h >> 32) & mMask;
+		while (mKeys[slot] != ~0ULL && mKeys[slot] != key)
+			slot = (slot + 1) & mMask;
+		return slot;
+	}
+
+	tinystl::vector<uint64_t>	mKeys;
+	tinystl::vector<uint32_t>	mValues;
+	uint32_t					mMask;
+};
+
+// Symmetric 4x4 quadric stored as the upper triangle of A, the vector b and the constant c, plus the accumulated weight
+struct Quadric
+{
+	double a00, a11, a22, a01, a02, a12;
+	double b0, b1, b2;
+	double c;
+	double w;
+};
+
+static void QuadricFromPlane(Quadric* q, double nx, double ny, double nz, double d, double weight)
+{
+	q->a00 = nx * nx * weight; q->a11 = ny * ny * weight; q->a22 = nz * nz * weight;
+	q->a01 = nx * ny * weight; q->a02 = nx * nz * weight; q->a12 = ny * nz * weight;
+	q->b0 = nx * d * weight; q->b1 = ny * d * weight; q->b2 = nz * d * weight;
+	q->c = d * d * weight;
+	q->w = weight;
+}
+
+static void QuadricAdd(Quadric* q, const Quadric& r)
+{
+	q->a00 += r.a00; q->a11 += r.a11; q->a22 += r.a22;
+	q->a01 += r.a01; q->a02 += r.a02; q->a12 += r.a12;
+	q->b0 += r.b0; q->b1 += r.b1; q->b2 += r.b2;
+	q->c += r.c;
+	q->w += r.w;
+}
+
+// Weighted mean squared distance of p to the planes accumulated in q
+static float QuadricError(const Quadric& q, const float* p)
+{
+	double x = p[0], y = p[1], z = p[2];
+	double rx = q.a00 * x + q.a01 * y + q.a02 * z + q.b0;
+	double ry = q.a01 * x + q.a11 * y + q.a12 * z + q.b1;
+	double rz = q.a02 * x + q.a12 * y + q.a22 * z + q.b2;
+	double r = x * rx + y * ry + z * rz + (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+	return q.w > 0.0 ? (float)(fabs(r) / q.w) : 0.0f;
+}
+
+static inline const float* GetPosition(const float* pPositions, uint32_t stride, uint32_t v)
+{
+	return (const float*)((const uint8_t*)pPositions + (size_t)v * stride);
+}
+
+static void TriangleNormal(const float* a, const float* b, const float* c, float* n)
+{
+	float e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+	float e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+	n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+	n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+	n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+}
+
+struct PositionKey
+{
+	float x, y, z;
+	uint32_t vertex;
+};
+
+static bool ComparePositionKey(const PositionKey& a, const PositionKey& b)
+{
+	if (a.x != b.x) return a.x < b.x;
+	if (a.y != b.y) return a.y < b.y;
+	if (a.z != b.z) return a.z < b.z;
+	return a.vertex < b.vertex;
+}
+
+// pRemap[v] = lowest vertex index with a bitwise equal position, pWedge links all vertices sharing a position in a cycle
+static void BuildPositionRemap(uint32_t* pRemap, uint32_t* pWedge, const float* pPositions, uint32_t stride, uint32_t vertexCount)
+{
+	tinystl::vector<PositionKey> keys(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; ++v)
+	{
+		const float* p = GetPosition(pPositions, stride, v);
+		PositionKey key = { p[0], p[1], p[2], v };
+		keys[v] = key;
+	}
+	std::sort(keys.begin(), keys.end(), ComparePositionKey);
+
+	for (uint32_t i = 0; i < vertexCount;)
+	{
+		uint32_t j = i + 1;
+		while (j < vertexCount && keys[j].x == keys[i].x && keys[j].y == keys[i].y && keys[j].z == keys[i].z)
+			++j;
+		for (uint32_t k = i; k < j; ++k)
+		{
+			pRemap[keys[k].vertex] = keys[i].vertex;
+			pWedge[keys[k].vertex] = keys[k + 1 < j ? k + 1 : i].vertex;
+		}
+		i = j;
+	}
+}
+
+struct SimplifierContext
+{
+	const float*				pPositions;
+	uint32_t					mStride;
+	uint32_t					mVertexCount;
+	tinystl::vector<uint32_t>	mRemap;
+	tinystl::vector<uint32_t>	mWedge;
+	tinystl::vector<uint8_t>	mKind;
+	// Directed open / material border edges in position space
+	EdgeHashTable				mOpenEdges;
+	// Directed seam edges in vertex space
+	EdgeHashTable				mSeamEdges;
+	tinystl::vector<Quadric>	mQuadrics;
+};
+
+static bool IsMaterialBorder(const uint32_t* pTriangleMaterials, uint32_t triangle, uint32_t opposite)
+{
+	return pTriangleMaterials && pTriangleMaterials[triangle] != pTriangleMaterials[opposite];
+}
+
+static void ClassifyVertices(SimplifierContext* pContext, const uint32_t* pIndices, uint32_t indexCount, const uint32_t* pTriangleMaterials)
+{
+	const uint32_t vertexCount = pContext->mVertexCount;
+	const uint32_t* remap = pContext->mRemap.data();
+
+	EdgeHashTable vertexEdges;
+	EdgeHashTable positionEdges;
+	vertexEdges.Init(indexCount);
+	positionEdges.Init(indexCount);
+	pContext->mOpenEdges.Init(indexCount);
+	pContext->mSeamEdges.Init(indexCount);
+
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t a = pIndices[i];
+		uint32_t b = pIndices[i % 3 == 2 ? i - 2 : i + 1];
+		vertexEdges.Insert(a, b, i / 3);
+		positionEdges.Insert(remap[a], remap[b], i / 3);
+	}
+
+	tinystl::vector<uint32_t> openOut(vertexCount, 0), openIn(vertexCount, 0);
+	tinystl::vector<uint32_t> seamOut(vertexCount, 0), seamIn(vertexCount, 0);
+
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t a = pIndices[i];
+		uint32_t b = pIndices[i % 3 == 2 ? i - 2 : i + 1];
+		uint32_t ra = remap[a], rb = remap[b];
+		uint32_t opposite = 0;
+
+		if (!positionEdges.Lookup(rb, ra, &opposite) || IsMaterialBorder(pTriangleMaterials, i / 3, opposite))
+		{
+			pContext->mOpenEdges.Insert(ra, rb, i / 3);
+			++openOut[ra];
+			++openIn[rb];
+		}
+		else if (!vertexEdges.Lookup(b, a))
+		{
+			pContext->mSeamEdges.Insert(a, b, i / 3);
+			++seamOut[a];
+			++seamIn[b];
+		}
+	}
+
+	pContext->mKind.resize(vertexCount, VERTEX_KIND_LOCKED);
+	for (uint32_t v = 0; v < vertexCount; ++v)
+	{
+		if (remap[v] != v)
+			continue;
+
+		uint32_t wedgeCount = 0;
+		bool singleSeam = true;
+		bool anySeam = false;
+		for (uint32_t w = v;;)
+		{
+			++wedgeCount;
+			singleSeam = singleSeam && seamOut[w] == 1 && seamIn[w] == 1;
+			anySeam = anySeam || seamOut[w] || seamIn[w];
+			w = pContext->mWedge[w];
+			if (w == v)
+				break;
+		}
+
+		uint8_t kind = VERTEX_KIND_LOCKED;
+		if (wedgeCount == 1 && !anySeam && openOut[v] == 0 && openIn[v] == 0)
+			kind = VERTEX_KIND_MANIFOLD;
+		else if (wedgeCount == 1 && !anySeam && openOut[v] == 1 && openIn[v] == 1)
+			kind = VERTEX_KIND_BORDER;
+		else if (wedgeCount == 2 && singleSeam && openOut[v] == 0 && openIn[v] == 0)
+			kind = VERTEX_KIND_SEAM;
+
+		pContext->mKind[v] = kind;
+	}
+}
+
+static void ComputeQuadrics(SimplifierContext* pContext, const uint32_t* pIndices, uint32_t indexCount)
+{
+	const uint32_t* remap = pContext->mRemap.data();
+	Quadric zero = {};
+	pContext->mQuadrics.resize(pContext->mVertexCount, zero);
+
+	for (uint32_t i = 0; i < indexCount; i += 3)
+	{
+		uint32_t v[3] = { remap[pIndices[i]], remap[pIndices[i + 1]], remap[pIndices[i + 2]] };
+		const float* p[3];
+		for (uint32_t k = 0; k < 3; ++k)
+			p[k] = GetPosition(pContext->pPositions, pContext->mStride, v[k]);
+
+		float n[3];
+		TriangleNormal(p[0], p[1], p[2], n);
+		double length = sqrt((double)n[0] * n[0] + (double)n[1] * n[1] + (double)n[2] * n[2]);
+		if (length <= 0.0)
+			continue;
+		double nx = n[0] / length, ny = n[1] / length, nz = n[2] / length;
+		double d = -(nx * p[0][0] + ny * p[0][1] + nz * p[0][2]);
+
+		// Area weighting keeps tiny slivers from dominating the error
+		Quadric q;
+		QuadricFromPlane(&q, nx, ny, nz, d, length * 0.5);
+		for (uint32_t k = 0; k < 3; ++k)
+			QuadricAdd(&pContext->mQuadrics[v[k]], q);
+
+		// Constrain open borders, material borders and seams with a plane through the edge perpendicular to the face
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			uint32_t a = pIndices[i + k];
+			uint32_t b = pIndices[i + (k + 1) % 3];
+			if (!pContext->mOpenEdges.Lookup(v[k], v[(k + 1) % 3]) && !pContext->mSeamEdges.Lookup(a, b))
+				continue;
+
+			const float* p0 = p[k];
+			const float* p1 = p[(k + 1) % 3];
+			double e[3] = { (double)p1[0] - p0[0], (double)p1[1] - p0[1], (double)p1[2] - p0[2] };
+			double edgeLength = sqrt(e[0] * e[0] + e[1] * e[1] + e[2] * e[2]);
+			if (edgeLength <= 0.0)
+				continue;
+
+			// Perpendicular = edge x normal
+			double px = e[1] * nz - e[2] * ny;
+			double py = e[2] * nx - e[0] * nz;
+			double pz = e[0] * ny - e[1] * nx;
+			double plength = sqrt(px * px + py * py + pz * pz);
+			px /= plength; py /= plength; pz /= plength;
+			double pd = -(px * p0[0] + py * p0[1] + pz * p0[2]);
+
+			Quadric bq;
+			QuadricFromPlane(&bq, px, py, pz, pd, edgeLength * edgeLength * SIMPLIFIER_BORDER_WEIGHT);
+			QuadricAdd(&pContext->mQuadrics[v[k]], bq);
+			QuadricAdd(&pContext->mQuadrics[v[(k + 1) % 3]], bq);
+		}
+	}
+}
+
+struct Collapse
+{
+	// Position space endpoints: v0 is removed and replaced by v1
+	uint32_t	v0;
+	uint32_t	v1;
+	float		mError;
+};
+
+static bool CompareCollapse(const Collapse& a, const Collapse& b)
+{
+	return a.mError < b.mError;
+}
+
+static bool CanCollapse(const SimplifierContext* pContext, uint32_t v0, uint32_t v1)
+{
+	switch (pContext->mKind[v0])
+	{
+		case VERTEX_KIND_MANIFOLD:
+			return true;
+		case VERTEX_KIND_BORDER:
+			return pContext->mOpenEdges.Lookup(v0, v1) || pContext->mOpenEdges.Lookup(v1, v0);
+		case VERTEX_KIND_SEAM:
+		{
+			if (pContext->mKind[v1] == VERTEX_KIND_MANIFOLD || pContext->mKind[v1] == VERTEX_KIND_BORDER)
+				return false;
+			// One of the wedges must run along the seam towards v1
+			for (uint32_t w0 = v0;;)
+			{
+				for (uint32_t w1 = v1;;)
+				{
+					if (pContext->mSeamEdges.Lookup(w0, w1) || pContext->mSeamEdges.Lookup(w1, w0))
+						return true;
+					w1 = pContext->mWedge[w1];
+					if (w1 == v1)
+						break;
+				}
+				w0 = pContext->mWedge[w0];
+				if (w0 == v0)
+					break;
+			}
+			return false;
+		}
+		default:
+			return false;
+	}
+}
+
+// Finds the wedge of position v1 connected to vertex w0 by an edge of the current index buffer
+static uint32_t FindTargetWedge(const SimplifierContext* pContext, const EdgeHashTable& edges, uint32_t w0, uint32_t v1)
+{
+	for (uint32_t w1 = v1;;)
+	{
+		if (edges.Lookup(w0, w1) || edges.Lookup(w1, w0))
+			return w1;
+		w1 = pContext->mWedge[w1];
+		if (w1 == v1)
+			break;
+	}
+	return ~0u;
+}
+
+// Rejects collapses which would flip or degenerate any of the faces around v0 that survive the collapse
+static bool HasFlippedFaces(const SimplifierContext* pContext, const uint32_t* pIndices, const uint32_t* pAdjacencyOffsets, const uint32_t* pAdjacency, uint32_t v0, uint32_t v1)
+{
+	const uint32_t* remap = pContext->mRemap.data();
+	const float* p1 = GetPosition(pContext->pPositions, pContext->mStride, v1);
+
+	for (uint32_t i = pAdjacencyOffsets[v0]; i < pAdjacencyOffsets[v0 + 1]; ++i)
+	{
+		const uint32_t* tri = pIndices + pAdjacency[i] * 3;
+		uint32_t a = remap[tri[0]], b = remap[tri[1]], c = remap[tri[2]];
+		if (a == v1 || b == v1 || c == v1)
+			continue;
+
+		const float* pa = GetPosition(pContext->pPositions, pContext->mStride, a);
+		const float* pb = GetPosition(pContext->pPositions, pContext->mStride, b);
+		const float* pc = GetPosition(pContext->pPositions, pContext->mStride, c);
+
+		float before[3], after[3];
+		TriangleNormal(pa, pb, pc, before);
+		TriangleNormal(a == v0 ? p1 : pa, b == v0 ? p1 : pb, c == v0 ? p1 : pc, after);
+
+		float dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+		float lengths = sqrtf((before[0] * before[0] + before[1] * before[1] + before[2] * before[2]) *
+			(after[0] * after[0] + after[1] * after[1] + after[2] * after[2]));
+		if (dot <= SIMPLIFIER_FLIP_COS_THRESHOLD * lengths)
+			return true;
+	}
+	return false;
+}
+
+// Runs one round of independent collapses. Returns the new index count
+static uint32_t SimplifyPass(SimplifierContext* pContext, uint32_t* pIndices, uint32_t indexCount, uint32_t targetIndexCount, float maxError, float* pResultError)
+{
+	const uint32_t vertexCount = pContext->mVertexCount;
+	const uint32_t* remap = pContext->mRemap.data();
+
+	// Position space triangle adjacency of the current index buffer
+	tinystl::vector<uint32_t> offsets(vertexCount + 1, 0);
+	tinystl::vector<uint32_t> adjacency(indexCount);
+	for (uint32_t i = 0; i < indexCount; ++i)
+		++offsets[remap[pIndices[i]] + 1];
+	for (uint32_t v = 0; v < vertexCount; ++v)
+		offsets[v + 1] += offsets[v];
+	{
+		tinystl::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (uint32_t i = 0; i < indexCount; ++i)
+			adjacency[fill[remap[pIndices[i]]]++] = i / 3;
+	}
+
+	EdgeHashTable edges;
+	edges.Init(indexCount);
+	for (uint32_t i = 0; i < indexCount; ++i)
+		edges.Insert(pIndices[i], pIndices[i % 3 == 2 ? i - 2 : i + 1], i / 3);
+
+	// Rank the cheapest valid direction of every edge
+	tinystl::vector<Collapse> collapses;
+	collapses.reserve(indexCount);
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t a = remap[pIndices[i]];
+		uint32_t b = remap[pIndices[i % 3 == 2 ? i - 2 : i + 1]];
+		// Each interior edge is seen from both triangles, only process it once
+		if (a == b || (a > b && edges.Lookup(pIndices[i % 3 == 2 ? i - 2 : i + 1], pIndices[i])))
+			continue;
+
+		Collapse best = { 0, 0, FLT_MAX };
+		if (CanCollapse(pContext, a, b))
+		{
+			Collapse c = { a, b, QuadricError(pContext->mQuadrics[a], GetPosition(pContext->pPositions, pContext->mStride, b)) };
+			best = c;
+		}
+		if (CanCollapse(pContext, b, a))
+		{
+			float error = QuadricError(pContext->mQuadrics[b], GetPosition(pContext->pPositions, pContext->mStride, a));
+			if (error < best.mError)
+			{
+				Collapse c = { b, a, error };
+				best = c;
+			}
+		}
+		if (best.mError != FLT_MAX && best.mError <= maxError * maxError)
+			collapses.push_back(best);
+	}
+
+	if (collapses.empty())
+		return indexCount;
+
+	std::sort(collapses.begin(), collapses.end(), CompareCollapse);
+
+	tinystl::vector<uint32_t> vertexRemap(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; ++v)
+		vertexRemap[v] = v;
+	tinystl::vector<uint8_t> touched(vertexCount, 0);
+
+	// Every collapse removes two triangles on average
+	uint32_t triangleBudget = (indexCount - targetIndexCount) / 3;
+	uint32_t trianglesRemoved = 0;
+	uint32_t wedges[2][2];
+
+	for (uint32_t i = 0; i < (uint32_t)collapses.size() && trianglesRemoved < triangleBudget; ++i)
+	{
+		const Collapse& c = collapses[i];
+		if (touched[c.v0] || touched[c.v1])
+			continue;
+
+		// Map every wedge of v0 onto the wedge of v1 it is connected to so attributes stay on their side of a seam
+		uint32_t wedgeCount = 0;
+		bool valid = true;
+		for (uint32_t w0 = c.v0;;)
+		{
+			uint32_t w1 = FindTargetWedge(pContext, edges, w0, c.v1);
+			if (w1 == ~0u || wedgeCount == 2)
+			{
+				valid = false;
+				break;
+			}
+			wedges[wedgeCount][0] = w0;
+			wedges[wedgeCount][1] = w1;
+			++wedgeCount;
+			w0 = pContext->mWedge[w0];
+			if (w0 == c.v0)
+				break;
+		}
+		if (!valid || HasFlippedFaces(pContext, pIndices, offsets.data(), adjacency.data(), c.v0, c.v1))
+			continue;
+
+		for (uint32_t w = 0; w < wedgeCount; ++w)
+			vertexRemap[wedges[w][0]] = wedges[w][1];
+
+		QuadricAdd(&pContext->mQuadrics[c.v1], pContext->mQuadrics[c.v0]);
+		// HasFlippedFaces only saw the current positions of the ring around v0, none of them may move in this pass
+		for (uint32_t k = offsets[c.v0]; k < offsets[c.v0 + 1]; ++k)
+		{
+			const uint32_t* tri = pIndices + adjacency[k] * 3;
+			touched[remap[tri[0]]] = 1;
+			touched[remap[tri[1]]] = 1;
+			touched[remap[tri[2]]] = 1;
+		}
+		trianglesRemoved += 2;
+		*pResultError = max(*pResultError, c.mError);
+	}
+
+	// Rewrite the index buffer and drop the triangles which became degenerate
+	uint32_t writeCount = 0;
+	for (uint32_t i = 0; i < indexCount; i += 3)
+	{
+		uint32_t a = vertexRemap[pIndices[i]], b = vertexRemap[pIndices[i + 1]], c = vertexRemap[pIndices[i + 2]];
+		if (remap[a] == remap[b] || remap[b] == remap[c] || remap[c] == remap[a])
+			continue;
+		pIndices[writeCount + 0] = a;
+		pIndices[writeCount + 1] = b;
+		pIndices[writeCount + 2] = c;
+		writeCount += 3;
+	}
+	return writeCount;
+}
+
+/************************************************************************/
+// MeshSimplifier
+/************************************************************************/
+uint32_t MeshSimplifier::Simplify(uint32_t* pDst, const uint32_t* pIndices, uint32_t indexCount, const float* pPositions, uint32_t positionStride, uint32_t vertexCount,
+	uint32_t targetIndexCount, float maxError, const uint32_t* pTriangleMaterials, float* pOutError)
+{
+	ASSERT(indexCount % 3 == 0);
+	ASSERT(positionStride >= sizeof(float) * 3);
+
+	if (pDst != pIndices)
+		memcpy(pDst, pIndices, indexCount * sizeof(uint32_t));
+
+	float resultError = 0.0f;
+	if (indexCount > targetIndexCount)
+	{
+		SimplifierContext context;
+		context.pPositions = pPositions;
+		context.mStride = positionStride;
+		context.mVertexCount = vertexCount;
+		context.mRemap.resize(vertexCount);
+		context.mWedge.resize(vertexCount);
+		BuildPositionRemap(context.mRemap.data(), context.mWedge.data(), pPositions, positionStride, vertexCount);
+		ClassifyVertices(&context, pIndices, indexCount, pTriangleMaterials);
+		ComputeQuadrics(&context, pIndices, indexCount);
+
+		while (indexCount > targetIndexCount)
+		{
+			uint32_t newCount = SimplifyPass(&context, pDst, indexCount, targetIndexCount, maxError, &resultError);
+			if (newCount == indexCount)
+				break;
+			indexCount = newCount;
+		}
+	}
+
+	if (pOutError)
+		*pOutError = sqrtf(resultError);
+
+	return indexCount;
+}
+
+uint32_t MeshSimplifier::GenerateLods(const MeshLodDesc* pDesc, const uint32_t* pIndices, uint32_t indexCount, const float* pPositions, uint32_t positionStride, uint32_t vertexCount,
+	tinystl::vector<uint32_t>* pOutIndices, MeshLod* pOutLods)
+{
+	ASSERT(pDesc && pOutIndices && pOutLods);
+	ASSERT(pDesc->mLodCount >= 1 && pDesc->mLodCount <= MESH_MAX_LODS);
+
+	// Convert the relative error limit to object space
+	float3 minBounds = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float3 maxBounds = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (uint32_t v = 0; v < vertexCount; ++v)
+	{
+		const float* p = GetPosition(pPositions, positionStride, v);
+		minBounds = float3(min(minBounds.x, p[0]), min(minBounds.y, p[1]), min(minBounds.z, p[2]));
+		maxBounds = float3(max(maxBounds.x, p[0]), max(maxBounds.y, p[1]), max(maxBounds.z, p[2]));
+	}
+	float3 extent = vertexCount ? maxBounds - minBounds : float3(0.0f, 0.0f, 0.0f);
+	float maxError = sqrtf(extent.x * extent.x + extent.y * extent.y + extent.z * extent.z) * pDesc->mMaxRelativeError;
+
+	uint32_t baseOffset = (uint32_t)pOutIndices->size();
+	pOutIndices->resize(baseOffset + indexCount);
+	memcpy(pOutIndices->data() + baseOffset, pIndices, indexCount * sizeof(uint32_t));
+
+	MeshLod lod0 = { baseOffset, indexCount, 0.0f };
+	pOutLods[0] = lod0;
+	uint32_t lodCount = 1;
+
+	// Every LOD is simplified from the source so errors do not compound across levels
+	tinystl::vector<uint32_t> lodIndices(indexCount);
+	float targetRatio = 1.0f;
+	for (; lodCount < pDesc->mLodCount; ++lodCount)
+	{
+		targetRatio *= pDesc->mReductionPerLod;
+		uint32_t targetIndexCount = (uint32_t)(indexCount * targetRatio) / 3 * 3;
+		float error = 0.0f;
+		uint32_t lodIndexCount = Simplify(lodIndices.data(), pIndices, indexCount, pPositions, positionStride, vertexCount,
+			targetIndexCount, maxError, pDesc->pTriangleMaterials, &error);
+
+		// No progress over the previous LOD means the error limit or the topology stopped the simplifier
+		const MeshLod& previous = pOutLods[lodCount - 1];
+		if (lodIndexCount == 0 || lodIndexCount >= previous.mIndexCount)
+			break;
+
+		MeshLod lod = { (uint32_t)pOutIndices->size(), lodIndexCount, max(error, previous.mError) };
+		pOutIndices->insert(pOutIndices->end(), lodIndices.data(), lodIndices.data() + lodIndexCount);
+		pOutLods[lodCount] = lod;
+	}
+
+	return lodCount;
+}
+
+uint32_t MeshSimplifier::SelectLod(const MeshLod* pLods, uint32_t lodCount, float distance, float projectionScale, float pixelThreshold)
+{
+	ASSERT(lodCount > 0);
+	uint32_t selected = 0;
+	for (uint32_t i = 1; i < lodCount; ++i)
+	{
+		float pixelError = pLods[i].mError * projectionScale / max(distance, 1e-6f);
+		if (pixelError > pixelThreshold)
+			break;
+		selected = i;
+	}
+	return selected;
+}
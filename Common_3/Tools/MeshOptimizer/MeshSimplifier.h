@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../../ThirdParty/OpenSource/TinySTL/vector.h"
+#include "../../OS/Math/MathTypes.h"
+
+#define MESH_MAX_LODS 8
+
+/// One level of detail inside a shared index buffer
+struct MeshLod
+{
+	uint32_t	mIndexOffset;
+	uint32_t	mIndexCount;
+	/// Largest geometric deviation from LOD 0 in object space units. Project it to screen space to pick a LOD at runtime
+	float		mError;
+};
+
+struct MeshLodDesc
+{
+	/// Number of levels including the source mesh (LOD 0)
+	uint32_t		mLodCount = 4;
+	/// Target index count of every LOD relative to the previous one
+	float			mReductionPerLod = 0.5f;
+	/// Stop simplifying once the error exceeds this fraction of the mesh bounding box diagonal
+	float			mMaxRelativeError = 0.05f;
+	/// Optional per triangle material id. Edges between different materials are treated like open borders
+	const uint32_t*	pTriangleMaterials = NULL;
+};
+
+/// Quadric error metric edge collapse simplification (Garland / Heckbert).
+/// Vertices are only ever collapsed onto existing vertices so every LOD can share the source vertex buffer.
+/// Attribute seams (vertices split at equal positions), open borders and material borders are kept intact:
+/// vertices on them can only slide along the seam / border and complex vertices are locked.
+class MeshSimplifier
+{
+public:
+	/// Writes at most indexCount indices to pDst (may alias pIndices) and returns the new index count.
+	/// pOutError receives the object space error of the result
+	static uint32_t Simplify(uint32_t* pDst, const uint32_t* pIndices, uint32_t indexCount, const float* pPositions, uint32_t positionStride, uint32_t vertexCount,
+		uint32_t targetIndexCount, float maxError, const uint32_t* pTriangleMaterials = NULL, float* pOutError = NULL);
+
+	/// Appends LOD 0 (the source indices) followed by progressively simplified LODs to pOutIndices.
+	/// Returns the number of LODs written to pOutLods (at most pDesc->mLodCount); generation stops early when the error limit is reached
+	static uint32_t GenerateLods(const MeshLodDesc* pDesc, const uint32_t* pIndices, uint32_t indexCount, const float* pPositions, uint32_t positionStride, uint32_t vertexCount,
+		tinystl::vector<uint32_t>* pOutIndices, MeshLod* pOutLods);
+
+	/// Picks the first LOD whose error projected to the screen stays below the threshold (in pixels)
+	static uint32_t SelectLod(const MeshLod* pLods, uint32_t lodCount, float distance, float projectionScale, float pixelThreshold);
+};
@@ -35,7 +35,9 @@
 
 #include <stdint.h>
 
-#ifdef API_EXPORT
+#if !defined(_WIN32)
+#define SPIRV_INTERFACE extern
+#elif defined(API_EXPORT)
 #define SPIRV_INTERFACE extern __declspec( dllexport )
 #else
 #define SPIRV_INTERFACE  extern __declspec( dllimport )
@@ -0,0 +1,529 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include <float.h>
+
+#include "VertexCompression.h"
+#include "../../OS/Math/half.h"
+#include "../../OS/Interfaces/ILogManager.h" //NOTE: this should be the last include in a .cpp
+#include "../../OS/Interfaces/IMemoryManager.h" //NOTE: this should be the last include in a .cpp
+
+/************************************************************************/
+// Helpers
+/************************************************************************/
+static inline float SignNotZero(float v)
+{
+	return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+static inline float Dot(const float3& a, const float3& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static inline float3 Cross(const float3& a, const float3& b)
+{
+	return float3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+static inline float3 Normalize(const float3& v)
+{
+	float lengthSqr = Dot(v, v);
+	return lengthSqr > 0.0f ? v / sqrtf(lengthSqr) : float3(0.0f, 0.0f, 1.0f);
+}
+
+static inline float AngleBetween(const float3& a, const float3& b)
+{
+	// atan2 stays accurate for the tiny angles we are interested in, acos does not
+	float3 c = Cross(a, b);
+	return atan2f(sqrtf(Dot(c, c)), Dot(a, b));
+}
+
+static inline int16_t QuantizeSnorm16(float v)
+{
+	return (int16_t)roundf(clamp(v, -1.0f, 1.0f) * 32767.0f);
+}
+
+static inline float DequantizeSnorm16(int16_t q)
+{
+	return max((float)q / 32767.0f, -1.0f);
+}
+
+static inline uint16_t QuantizeUnorm16(float v, float offset, float scale)
+{
+	if (scale <= 0.0f)
+		return 0;
+	return (uint16_t)roundf(clamp((v - offset) / scale, 0.0f, 1.0f) * 65535.0f);
+}
+
+static inline float DequantizeUnorm16(uint16_t q, float offset, float scale)
+{
+	return offset + ((float)q / 65535.0f) * scale;
+}
+
+static inline uint32_t PackSnorm16x2(int16_t x, int16_t y)
+{
+	return (uint32_t)(uint16_t)x | ((uint32_t)(uint16_t)y << 16);
+}
+
+static inline float3 OctahedralToDir(float x, float y)
+{
+	float3 dir(x, y, 1.0f - fabsf(x) - fabsf(y));
+	if (dir.z < 0.0f)
+	{
+		dir.x = (1.0f - fabsf(y)) * SignNotZero(x);
+		dir.y = (1.0f - fabsf(x)) * SignNotZero(y);
+	}
+	return Normalize(dir);
+}
+/************************************************************************/
+// Octahedral encoding
+/************************************************************************/
+uint32_t VertexCompression::EncodeOctahedral16(const float3& dir)
+{
+	float l1 = fabsf(dir.x) + fabsf(dir.y) + fabsf(dir.z);
+	if (l1 <= 0.0f)
+		return PackSnorm16x2(0, 0);
+
+	float x = dir.x / l1;
+	float y = dir.y / l1;
+	if (dir.z < 0.0f)
+	{
+		float oldX = x;
+		x = (1.0f - fabsf(y)) * SignNotZero(oldX);
+		y = (1.0f - fabsf(oldX)) * SignNotZero(y);
+	}
+
+	// Rounding each coordinate independently is not always the closest direction on the sphere,
+	// so pick the best of the four surrounding quantization points
+	const float3 source = Normalize(dir);
+	const float fx = floorf(clamp(x, -1.0f, 1.0f) * 32767.0f);
+	const float fy = floorf(clamp(y, -1.0f, 1.0f) * 32767.0f);
+
+	int16_t bestX = QuantizeSnorm16(x);
+	int16_t bestY = QuantizeSnorm16(y);
+	float bestDot = Dot(source, OctahedralToDir(DequantizeSnorm16(bestX), DequantizeSnorm16(bestY)));
+
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		float qx = clamp(fx + (float)(i & 1), -32767.0f, 32767.0f);
+		float qy = clamp(fy + (float)(i >> 1), -32767.0f, 32767.0f);
+		float d = Dot(source, OctahedralToDir(qx / 32767.0f, qy / 32767.0f));
+		if (d > bestDot)
+		{
+			bestDot = d;
+			bestX = (int16_t)qx;
+			bestY = (int16_t)qy;
+		}
+	}
+
+	return PackSnorm16x2(bestX, bestY);
+}
+
+float3 VertexCompression::DecodeOctahedral16(uint32_t packed)
+{
+	float x = DequantizeSnorm16((int16_t)(packed & 0xFFFF));
+	float y = DequantizeSnorm16((int16_t)(packed >> 16));
+	return OctahedralToDir(x, y);
+}
+/************************************************************************/
+// Strides and layout
+/************************************************************************/
+uint32_t VertexCompression::GetPositionStride(VertexPositionFormat format)
+{
+	return format == VERTEX_POSITION_UNORM16 ? 4 * sizeof(uint16_t) : 3 * sizeof(float);
+}
+
+uint32_t VertexCompression::GetNormalStride(VertexNormalFormat format)
+{
+	return format == VERTEX_NORMAL_OCT16 ? sizeof(uint32_t) : 3 * sizeof(float);
+}
+
+uint32_t VertexCompression::GetTangentStride(VertexTangentFormat format)
+{
+	return format == VERTEX_TANGENT_OCT16_SIGN ? 4 * sizeof(int16_t) : 6 * sizeof(float);
+}
+
+uint32_t VertexCompression::GetTexCoordStride(VertexTexCoordFormat format)
+{
+	return format == VERTEX_TEXCOORD_FLOAT32 ? 2 * sizeof(float) : 2 * sizeof(uint16_t);
+}
+
+static void AddVertexAttrib(VertexLayout* pLayout, ShaderSemantic semantic, ImageFormat::Enum format, uint32_t offset)
+{
+	ASSERT(pLayout->mAttribCount < MAX_VERTEX_ATTRIBS);
+
+	const uint32_t binding = pLayout->mAttribCount ? pLayout->mAttribs[pLayout->mAttribCount - 1].mBinding + (offset ? 0 : 1) : 0;
+	VertexAttrib* pAttrib = &pLayout->mAttribs[pLayout->mAttribCount];
+	pAttrib->mSemantic = semantic;
+	pAttrib->mFormat = format;
+	pAttrib->mBinding = binding;
+	pAttrib->mLocation = pLayout->mAttribCount;
+	pAttrib->mOffset = offset;
+	++pLayout->mAttribCount;
+}
+
+void VertexCompression::GetVertexLayout(const CompressedVertexStreams* pStreams, VertexLayout* pOutLayout)
+{
+	ASSERT(pStreams);
+	ASSERT(pOutLayout);
+
+	memset(pOutLayout, 0, sizeof(*pOutLayout));
+	const VertexCompressionDesc& desc = pStreams->mDesc;
+
+	AddVertexAttrib(pOutLayout, SEMANTIC_POSITION, desc.mPositionFormat == VERTEX_POSITION_UNORM16 ? ImageFormat::RGBA16 : ImageFormat::RGB32F, 0);
+
+	if (!pStreams->mNormals.empty())
+		AddVertexAttrib(pOutLayout, SEMANTIC_NORMAL, desc.mNormalFormat == VERTEX_NORMAL_OCT16 ? ImageFormat::RG16S : ImageFormat::RGB32F, 0);
+
+	if (!pStreams->mTangents.empty())
+	{
+		if (desc.mTangentFormat == VERTEX_TANGENT_OCT16_SIGN)
+		{
+			AddVertexAttrib(pOutLayout, SEMANTIC_TANGENT, ImageFormat::RGBA16S, 0);
+		}
+		else
+		{
+			// Tangent and bitangent share the binding
+			AddVertexAttrib(pOutLayout, SEMANTIC_TANGENT, ImageFormat::RGB32F, 0);
+			AddVertexAttrib(pOutLayout, SEMANTIC_BITANGENT, ImageFormat::RGB32F, 3 * sizeof(float));
+		}
+	}
+
+	if (!pStreams->mTexCoords.empty())
+	{
+		ImageFormat::Enum format = ImageFormat::RG32F;
+		if (desc.mTexCoordFormat == VERTEX_TEXCOORD_HALF)
+			format = ImageFormat::RG16F;
+		else if (desc.mTexCoordFormat == VERTEX_TEXCOORD_UNORM16)
+			format = ImageFormat::RG16;
+
+		AddVertexAttrib(pOutLayout, SEMANTIC_TEXCOORD0, format, 0);
+	}
+}
+/************************************************************************/
+// Compression
+/************************************************************************/
+void VertexCompression::Compress(const VertexCompressionDesc* pDesc, uint32_t vertexCount, const float3* pPositions, const float3* pNormals,
+	const float3* pTangents, const float3* pBitangents, const float2* pTexCoords, CompressedVertexStreams* pOut)
+{
+	ASSERT(pDesc);
+	ASSERT(pPositions);
+	ASSERT(pOut);
+
+	pOut->mDesc = *pDesc;
+	pOut->mVertexCount = vertexCount;
+	pOut->mPositionOffset = float3(0.0f);
+	pOut->mPositionScale = float3(1.0f);
+	pOut->mTexCoordOffset = float2(0.0f, 0.0f);
+	pOut->mTexCoordScale = float2(1.0f, 1.0f);
+	pOut->mPositions.clear();
+	pOut->mNormals.clear();
+	pOut->mTangents.clear();
+	pOut->mTexCoords.clear();
+
+	if (!vertexCount)
+		return;
+
+	// Positions
+	pOut->mPositions.resize((size_t)vertexCount * GetPositionStride(pDesc->mPositionFormat));
+	if (pDesc->mPositionFormat == VERTEX_POSITION_UNORM16)
+	{
+		float3 minBounds = pPositions[0];
+		float3 maxBounds = pPositions[0];
+		for (uint32_t i = 1; i < vertexCount; ++i)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				minBounds[c] = min(minBounds[c], pPositions[i][c]);
+				maxBounds[c] = max(maxBounds[c], pPositions[i][c]);
+			}
+		}
+
+		pOut->mPositionOffset = minBounds;
+		pOut->mPositionScale = maxBounds - minBounds;
+
+		uint16_t* pDst = (uint16_t*)pOut->mPositions.data();
+		for (uint32_t i = 0; i < vertexCount; ++i, pDst += 4)
+		{
+			for (int c = 0; c < 3; ++c)
+				pDst[c] = QuantizeUnorm16(pPositions[i][c], pOut->mPositionOffset[c], pOut->mPositionScale[c]);
+			pDst[3] = 0;
+		}
+	}
+	else
+	{
+		memcpy(pOut->mPositions.data(), pPositions, (size_t)vertexCount * sizeof(float3));
+	}
+
+	// Normals
+	if (pNormals)
+	{
+		pOut->mNormals.resize((size_t)vertexCount * GetNormalStride(pDesc->mNormalFormat));
+		if (pDesc->mNormalFormat == VERTEX_NORMAL_OCT16)
+		{
+			uint32_t* pDst = (uint32_t*)pOut->mNormals.data();
+			for (uint32_t i = 0; i < vertexCount; ++i)
+				pDst[i] = EncodeOctahedral16(pNormals[i]);
+		}
+		else
+		{
+			memcpy(pOut->mNormals.data(), pNormals, (size_t)vertexCount * sizeof(float3));
+		}
+	}
+
+	// Tangents
+	if (pTangents)
+	{
+		pOut->mTangents.resize((size_t)vertexCount * GetTangentStride(pDesc->mTangentFormat));
+		if (pDesc->mTangentFormat == VERTEX_TANGENT_OCT16_SIGN)
+		{
+			int16_t* pDst = (int16_t*)pOut->mTangents.data();
+			for (uint32_t i = 0; i < vertexCount; ++i, pDst += 4)
+			{
+				uint32_t packed = EncodeOctahedral16(pTangents[i]);
+				float sign = 1.0f;
+				if (pNormals && pBitangents)
+					sign = SignNotZero(Dot(Cross(pNormals[i], pTangents[i]), pBitangents[i]));
+
+				pDst[0] = (int16_t)(packed & 0xFFFF);
+				pDst[1] = (int16_t)(packed >> 16);
+				pDst[2] = 0;
+				pDst[3] = sign > 0.0f ? 32767 : -32767;
+			}
+		}
+		else
+		{
+			float* pDst = (float*)pOut->mTangents.data();
+			for (uint32_t i = 0; i < vertexCount; ++i, pDst += 6)
+			{
+				float3 bitangent = pBitangents ? pBitangents[i] : (pNormals ? Cross(pNormals[i], pTangents[i]) : float3(0.0f));
+				memcpy(pDst, &pTangents[i], sizeof(float3));
+				memcpy(pDst + 3, &bitangent, sizeof(float3));
+			}
+		}
+	}
+
+	// Texture coordinates
+	if (pTexCoords)
+	{
+		pOut->mTexCoords.resize((size_t)vertexCount * GetTexCoordStride(pDesc->mTexCoordFormat));
+		if (pDesc->mTexCoordFormat == VERTEX_TEXCOORD_UNORM16)
+		{
+			float2 minBounds = pTexCoords[0];
+			float2 maxBounds = pTexCoords[0];
+			for (uint32_t i = 1; i < vertexCount; ++i)
+			{
+				minBounds = float2(min(minBounds.x, pTexCoords[i].x), min(minBounds.y, pTexCoords[i].y));
+				maxBounds = float2(max(maxBounds.x, pTexCoords[i].x), max(maxBounds.y, pTexCoords[i].y));
+			}
+
+			pOut->mTexCoordOffset = minBounds;
+			pOut->mTexCoordScale = float2(maxBounds.x - minBounds.x, maxBounds.y - minBounds.y);
+
+			uint16_t* pDst = (uint16_t*)pOut->mTexCoords.data();
+			for (uint32_t i = 0; i < vertexCount; ++i, pDst += 2)
+			{
+				pDst[0] = QuantizeUnorm16(pTexCoords[i].x, pOut->mTexCoordOffset.x, pOut->mTexCoordScale.x);
+				pDst[1] = QuantizeUnorm16(pTexCoords[i].y, pOut->mTexCoordOffset.y, pOut->mTexCoordScale.y);
+			}
+		}
+		else if (pDesc->mTexCoordFormat == VERTEX_TEXCOORD_HALF)
+		{
+			floatToHalf((const float*)pTexCoords, (half*)pOut->mTexCoords.data(), (size_t)vertexCount * 2);
+		}
+		else
+		{
+			memcpy(pOut->mTexCoords.data(), pTexCoords, (size_t)vertexCount * sizeof(float2));
+		}
+	}
+}
+/************************************************************************/
+// Decoding
+/************************************************************************/
+float3 VertexCompression::DecodePosition(const CompressedVertexStreams* pStreams, uint32_t index)
+{
+	ASSERT(index < pStreams->mVertexCount);
+
+	if (pStreams->mDesc.mPositionFormat == VERTEX_POSITION_UNORM16)
+	{
+		const uint16_t* pSrc = (const uint16_t*)pStreams->mPositions.data() + (size_t)index * 4;
+		return float3(
+			DequantizeUnorm16(pSrc[0], pStreams->mPositionOffset.x, pStreams->mPositionScale.x),
+			DequantizeUnorm16(pSrc[1], pStreams->mPositionOffset.y, pStreams->mPositionScale.y),
+			DequantizeUnorm16(pSrc[2], pStreams->mPositionOffset.z, pStreams->mPositionScale.z));
+	}
+
+	const float* pSrc = (const float*)pStreams->mPositions.data() + (size_t)index * 3;
+	return float3(pSrc[0], pSrc[1], pSrc[2]);
+}
+
+float3 VertexCompression::DecodeNormal(const CompressedVertexStreams* pStreams, uint32_t index)
+{
+	ASSERT(index < pStreams->mVertexCount);
+	ASSERT(!pStreams->mNormals.empty());
+
+	if (pStreams->mDesc.mNormalFormat == VERTEX_NORMAL_OCT16)
+		return DecodeOctahedral16(((const uint32_t*)pStreams->mNormals.data())[index]);
+
+	const float* pSrc = (const float*)pStreams->mNormals.data() + (size_t)index * 3;
+	return float3(pSrc[0], pSrc[1], pSrc[2]);
+}
+
+void VertexCompression::DecodeTangent(const CompressedVertexStreams* pStreams, uint32_t index, float3* pOutTangent, float3* pOutBitangent)
+{
+	ASSERT(index < pStreams->mVertexCount);
+	ASSERT(!pStreams->mTangents.empty());
+
+	if (pStreams->mDesc.mTangentFormat == VERTEX_TANGENT_OCT16_SIGN)
+	{
+		const int16_t* pSrc = (const int16_t*)pStreams->mTangents.data() + (size_t)index * 4;
+		float3 tangent = DecodeOctahedral16(PackSnorm16x2(pSrc[0], pSrc[1]));
+		if (pOutTangent)
+			*pOutTangent = tangent;
+		if (pOutBitangent)
+		{
+			float3 normal = pStreams->mNormals.empty() ? float3(0.0f, 0.0f, 1.0f) : DecodeNormal(pStreams, index);
+			*pOutBitangent = Cross(normal, tangent) * SignNotZero((float)pSrc[3]);
+		}
+		return;
+	}
+
+	const float* pSrc = (const float*)pStreams->mTangents.data() + (size_t)index * 6;
+	if (pOutTangent)
+		*pOutTangent = float3(pSrc[0], pSrc[1], pSrc[2]);
+	if (pOutBitangent)
+		*pOutBitangent = float3(pSrc[3], pSrc[4], pSrc[5]);
+}
+
+float2 VertexCompression::DecodeTexCoord(const CompressedVertexStreams* pStreams, uint32_t index)
+{
+	ASSERT(index < pStreams->mVertexCount);
+	ASSERT(!pStreams->mTexCoords.empty());
+
+	if (pStreams->mDesc.mTexCoordFormat == VERTEX_TEXCOORD_UNORM16)
+	{
+		const uint16_t* pSrc = (const uint16_t*)pStreams->mTexCoords.data() + (size_t)index * 2;
+		return float2(
+			DequantizeUnorm16(pSrc[0], pStreams->mTexCoordOffset.x, pStreams->mTexCoordScale.x),
+			DequantizeUnorm16(pSrc[1], pStreams->mTexCoordOffset.y, pStreams->mTexCoordScale.y));
+	}
+	else if (pStreams->mDesc.mTexCoordFormat == VERTEX_TEXCOORD_HALF)
+	{
+		const half* pSrc = (const half*)pStreams->mTexCoords.data() + (size_t)index * 2;
+		return float2((float)pSrc[0], (float)pSrc[1]);
+	}
+
+	const float* pSrc = (const float*)pStreams->mTexCoords.data() + (size_t)index * 2;
+	return float2(pSrc[0], pSrc[1]);
+}
+
+// Error bound of a value dequantized as offset + unorm16 * scale. Besides the half step of the format,
+// the float math of the reconstruction adds a few ulps of the largest magnitude involved
+static inline float Unorm16ErrorBound(float offset, float scale)
+{
+	return scale * VERTEX_UNORM16_MAX_ERROR + 4.0f * FLT_EPSILON * (fabsf(offset) + fabsf(scale));
+}
+
+// Half floats round to nearest with an 11 bit significand. Below the normal range the absolute error is half of the smallest subnormal
+static inline float HalfErrorBound(float value)
+{
+	return max(fabsf(value) * VERTEX_HALF_MAX_RELATIVE_ERROR, 1.0f / (float)(1 << 25));
+}
+
+VertexCompressionError VertexCompression::MeasureError(const CompressedVertexStreams* pStreams, const float3* pPositions, const float3* pNormals,
+	const float3* pTangents, const float3* pBitangents, const float2* pTexCoords)
+{
+	ASSERT(pStreams);
+
+	const VertexCompressionDesc& desc = pStreams->mDesc;
+	VertexCompressionError error = {};
+
+	for (uint32_t i = 0; i < pStreams->mVertexCount; ++i)
+	{
+		if (pPositions)
+		{
+			float3 p = DecodePosition(pStreams, i);
+			for (int c = 0; c < 3; ++c)
+			{
+				float componentError = fabsf(p[c] - pPositions[i][c]);
+				float bound = desc.mPositionFormat == VERTEX_POSITION_UNORM16 ? Unorm16ErrorBound(pStreams->mPositionOffset[c], pStreams->mPositionScale[c]) : 0.0f;
+				error.mPosition = max(error.mPosition, componentError);
+				if (!(componentError <= bound))
+					++error.mOutOfBoundsCount;
+			}
+		}
+
+		if (pNormals && !pStreams->mNormals.empty())
+		{
+			float3 normal = DecodeNormal(pStreams, i);
+			float angle = AngleBetween(Normalize(pNormals[i]), normal);
+			error.mNormal = max(error.mNormal, angle);
+			if (desc.mNormalFormat == VERTEX_NORMAL_OCT16 ? !(angle <= VERTEX_OCT16_MAX_ANGLE_ERROR) : memcmp(&normal, &pNormals[i], sizeof(float3)) != 0)
+				++error.mOutOfBoundsCount;
+		}
+
+		if (pTangents && !pStreams->mTangents.empty())
+		{
+			float3 tangent;
+			float3 bitangent;
+			DecodeTangent(pStreams, i, &tangent, &bitangent);
+			float angle = AngleBetween(Normalize(pTangents[i]), Normalize(tangent));
+			error.mTangent = max(error.mTangent, angle);
+			if (desc.mTangentFormat == VERTEX_TANGENT_OCT16_SIGN ? !(angle <= VERTEX_OCT16_MAX_ANGLE_ERROR) : memcmp(&tangent, &pTangents[i], sizeof(float3)) != 0)
+				++error.mOutOfBoundsCount;
+			if (pBitangents && Dot(bitangent, pBitangents[i]) < 0.0f)
+			{
+				++error.mBitangentSignMismatches;
+				++error.mOutOfBoundsCount;
+			}
+		}
+
+		if (pTexCoords && !pStreams->mTexCoords.empty())
+		{
+			float2 uv = DecodeTexCoord(pStreams, i);
+			for (int c = 0; c < 2; ++c)
+			{
+				float source = c ? pTexCoords[i].y : pTexCoords[i].x;
+				float componentError = fabsf((c ? uv.y : uv.x) - source);
+				float bound = 0.0f;
+				if (desc.mTexCoordFormat == VERTEX_TEXCOORD_UNORM16)
+					bound = Unorm16ErrorBound(c ? pStreams->mTexCoordOffset.y : pStreams->mTexCoordOffset.x, c ? pStreams->mTexCoordScale.y : pStreams->mTexCoordScale.x);
+				else if (desc.mTexCoordFormat == VERTEX_TEXCOORD_HALF)
+					bound = HalfErrorBound(source);
+				error.mTexCoord = max(error.mTexCoord, componentError);
+				if (!(componentError <= bound))
+					++error.mOutOfBoundsCount;
+			}
+		}
+	}
+
+	if (error.mOutOfBoundsCount)
+	{
+		LOGWARNINGF("%u compressed vertex values exceed the error bound of their format (position %g, normal %g rad, tangent %g rad, texcoord %g, %u bitangent sign flips)",
+			error.mOutOfBoundsCount, error.mPosition, error.mNormal, error.mTangent, error.mTexCoord, error.mBitangentSignMismatches);
+	}
+
+	return error;
+}
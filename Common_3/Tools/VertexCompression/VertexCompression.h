@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../../Renderer/IRenderer.h"
+#include "../../ThirdParty/OpenSource/TinySTL/vector.h"
+#include "../../OS/Math/MathTypes.h"
+
+// Worst case reconstruction errors of the quantized formats
+// Positions / unorm16 texcoords: half a quantization step of the per-mesh bounds extent per axis (plus float rounding of the source)
+#define VERTEX_UNORM16_MAX_ERROR (0.5f / 65535.0f)
+// Octahedral snorm16 directions: maximum angle between the source and the decoded unit vector (radians)
+#define VERTEX_OCT16_MAX_ANGLE_ERROR 1.5e-4f
+// Half texcoords: relative error of the 11 bit mantissa
+#define VERTEX_HALF_MAX_RELATIVE_ERROR (1.0f / 2048.0f)
+
+typedef enum VertexPositionFormat
+{
+	VERTEX_POSITION_FLOAT32 = 0,	// RGB32F, 12 bytes
+	VERTEX_POSITION_UNORM16,		// RGBA16 relative to the mesh bounds (w unused), 8 bytes
+} VertexPositionFormat;
+
+typedef enum VertexNormalFormat
+{
+	VERTEX_NORMAL_FLOAT32 = 0,		// RGB32F, 12 bytes
+	VERTEX_NORMAL_OCT16,			// RG16S octahedral, 4 bytes
+} VertexNormalFormat;
+
+typedef enum VertexTangentFormat
+{
+	VERTEX_TANGENT_FLOAT32 = 0,		// tangent and bitangent as RGB32F, 24 bytes
+	VERTEX_TANGENT_OCT16_SIGN,		// RGBA16S: octahedral tangent in xy, bitangent sign in w, 8 bytes
+} VertexTangentFormat;
+
+typedef enum VertexTexCoordFormat
+{
+	VERTEX_TEXCOORD_FLOAT32 = 0,	// RG32F, 8 bytes
+	VERTEX_TEXCOORD_HALF,			// RG16F, 4 bytes
+	VERTEX_TEXCOORD_UNORM16,		// RG16 relative to the mesh texcoord bounds, 4 bytes
+} VertexTexCoordFormat;
+
+typedef struct VertexCompressionDesc
+{
+	VertexPositionFormat	mPositionFormat = VERTEX_POSITION_UNORM16;
+	VertexNormalFormat		mNormalFormat = VERTEX_NORMAL_OCT16;
+	VertexTangentFormat		mTangentFormat = VERTEX_TANGENT_OCT16_SIGN;
+	VertexTexCoordFormat	mTexCoordFormat = VERTEX_TEXCOORD_HALF;
+} VertexCompressionDesc;
+
+/// Planar vertex streams, one vertex buffer binding per attribute in the order position, normal, tangent, texcoord.
+/// Absent attributes have an empty stream and are skipped in the vertex layout
+typedef struct CompressedVertexStreams
+{
+	VertexCompressionDesc		mDesc;
+	uint32_t					mVertexCount;
+	/// Dequantization parameters to be passed to the shaders: value = offset + unorm * scale
+	float3						mPositionOffset;
+	float3						mPositionScale;
+	float2						mTexCoordOffset;
+	float2						mTexCoordScale;
+	tinystl::vector<uint8_t>	mPositions;
+	tinystl::vector<uint8_t>	mNormals;
+	tinystl::vector<uint8_t>	mTangents;
+	tinystl::vector<uint8_t>	mTexCoords;
+} CompressedVertexStreams;
+
+typedef struct VertexCompressionError
+{
+	/// Largest absolute per component error in object space units
+	float mPosition;
+	/// Largest angle between source and decoded direction in radians
+	float mNormal;
+	float mTangent;
+	/// Number of vertices whose decoded bitangent points into the other hemisphere
+	uint32_t mBitangentSignMismatches;
+	/// Largest absolute per component texcoord error
+	float mTexCoord;
+	/// Number of decoded values outside the VERTEX_*_MAX_ERROR bound of their format, plus bitangent sign mismatches.
+	/// Float32 streams must round trip exactly. Zero means the streams are within the documented error bounds
+	uint32_t mOutOfBoundsCount;
+} VertexCompressionError;
+
+class VertexCompression
+{
+public:
+	/// Any of the attribute pointers except positions can be NULL. Bitangents are only needed to derive the handedness sign
+	static void Compress(const VertexCompressionDesc* pDesc, uint32_t vertexCount, const float3* pPositions, const float3* pNormals,
+		const float3* pTangents, const float3* pBitangents, const float2* pTexCoords, CompressedVertexStreams* pOut);
+
+	static uint32_t GetPositionStride(VertexPositionFormat format);
+	static uint32_t GetNormalStride(VertexNormalFormat format);
+	static uint32_t GetTangentStride(VertexTangentFormat format);
+	static uint32_t GetTexCoordStride(VertexTexCoordFormat format);
+
+	/// Fills the layout with one binding per non empty stream. Binding and location are assigned in stream order
+	static void GetVertexLayout(const CompressedVertexStreams* pStreams, VertexLayout* pOutLayout);
+
+	/// CPU side decoding for tools, collision and picking
+	static float3 DecodePosition(const CompressedVertexStreams* pStreams, uint32_t index);
+	static float3 DecodeNormal(const CompressedVertexStreams* pStreams, uint32_t index);
+	/// The bitangent is reconstructed as sign * cross(normal, tangent)
+	static void DecodeTangent(const CompressedVertexStreams* pStreams, uint32_t index, float3* pOutTangent, float3* pOutBitangent);
+	static float2 DecodeTexCoord(const CompressedVertexStreams* pStreams, uint32_t index);
+
+	/// Decodes every vertex, compares against the source data and checks each value against the error bound of its format.
+	/// Logs a warning when mOutOfBoundsCount is not zero
+	static VertexCompressionError MeasureError(const CompressedVertexStreams* pStreams, const float3* pPositions, const float3* pNormals,
+		const float3* pTangents, const float3* pBitangents, const float2* pTexCoords);
+
+	/// Octahedral mapping of a unit vector to two snorm16 values (x in the low half)
+	static uint32_t EncodeOctahedral16(const float3& dir);
+	static float3 DecodeOctahedral16(uint32_t packed);
+};
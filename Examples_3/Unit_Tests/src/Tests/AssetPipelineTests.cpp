@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Cooks a texture through AssetPipeline several times and checks that unchanged inputs are skipped and changed cook
+// parameters produce a new output.
+
+#include "../../../../Common_3/Tools/AssetPipeline/AssetPipeline.h"
+#include "../../../../Common_3/Tools/AssimpImporter/AssimpImporter.h"
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+#define ASSET_PIPELINE_TEST_SOURCE "AssetPipelineTests.dds"
+#define ASSET_PIPELINE_TEST_CACHE "AssetPipelineTestCache/"
+
+// Assimp has no Linux library so AssimpImporter.cpp is not part of the runner. Mesh cooking is not covered here,
+// this only satisfies the reference from AssetPipeline.cpp
+bool AssimpImporter::ImportModel(const char*, Model*, const MeshOptimizerDesc*, const MeshLodDesc*, ThreadPool*, Serializer*)
+{
+	return false;
+}
+
+static bool assetPipelineWriteSource()
+{
+	Image image;
+	uint8_t* pPixels = image.Create(ImageFormat::RGBA8, 64, 64, 1, 1);
+	for (uint32_t i = 0; i < 64 * 64 * 4; ++i)
+		pPixels[i] = (uint8_t)(i * 7);
+	// iSaveDDS resolves relative paths against FSR_Textures
+	String path = FileSystem::GetCurrentDir() + FileSystem::FixPath(ASSET_PIPELINE_TEST_SOURCE, FSR_OtherFiles);
+	bool result = image.iSaveDDS(path.c_str());
+	image.Destroy();
+	return result;
+}
+
+static bool assetPipelineCook(const String& cacheDir, uint32_t mipLevels, AssetCookStatistics* pOutStats)
+{
+	AssetCookDesc desc;
+	desc.mSource = ASSET_PIPELINE_TEST_SOURCE;
+	desc.mRoot = FSR_OtherFiles;
+	desc.mType = ASSET_TYPE_TEXTURE;
+	desc.mMipLevels = mipLevels;
+	return AssetPipeline::Cook(cacheDir.c_str(), &desc, 1, NULL, pOutStats);
+}
+
+// Cooked output the manifest currently points to
+static String assetPipelineGetCookedPath(const String& cacheDir)
+{
+	String cookedPath;
+	if (FileSystem::LoadCookManifest(cacheDir + COOK_MANIFEST_FILE_NAME, FSR_Absolute))
+		cookedPath = FileSystem::GetCookedPath(ASSET_PIPELINE_TEST_SOURCE, FSR_OtherFiles);
+	// Image::loadImage would read the cooked output instead of the source in the next cook
+	FileSystem::ClearCookManifest();
+	return cookedPath;
+}
+
+UNIT_TEST(AssetPipelineCookIsIncremental)
+{
+	const String cacheDir = FileSystem::FixPath(ASSET_PIPELINE_TEST_CACHE, FSR_OtherFiles);
+	const String manifestPath = cacheDir + COOK_MANIFEST_FILE_NAME;
+	UNIT_CHECK(assetPipelineWriteSource());
+
+	AssetCookStatistics stats;
+	UNIT_CHECK(assetPipelineCook(cacheDir, ALL_MIPLEVELS, &stats));
+	UNIT_CHECK(stats.mCooked == 1 && stats.mUpToDate == 0 && stats.mCacheHits == 0 && stats.mFailed == 0);
+	// The manifest is written next to the outputs and moved into place, nothing temporary is left behind
+	UNIT_CHECK(!FileSystem::FileExists(manifestPath + ".tmp", FSR_Absolute));
+	const String allMipsPath = assetPipelineGetCookedPath(cacheDir);
+	UNIT_CHECK(!allMipsPath.isEmpty() && FileSystem::FileExists(allMipsPath, FSR_Absolute));
+
+	// Nothing changed: the stamp matches, the source is not even read
+	UNIT_CHECK(assetPipelineCook(cacheDir, ALL_MIPLEVELS, &stats));
+	UNIT_CHECK(stats.mUpToDate == 1 && stats.mCooked == 0 && stats.mCacheHits == 0 && stats.mFailed == 0);
+	UNIT_CHECK(assetPipelineGetCookedPath(cacheDir) == allMipsPath);
+
+	// A different cook parameter is a different output
+	UNIT_CHECK(assetPipelineCook(cacheDir, 1, &stats));
+	UNIT_CHECK(stats.mCooked == 1 && stats.mUpToDate == 0 && stats.mCacheHits == 0 && stats.mFailed == 0);
+	const String topMipPath = assetPipelineGetCookedPath(cacheDir);
+	UNIT_CHECK(!topMipPath.isEmpty() && topMipPath != allMipsPath);
+	UNIT_CHECK(FileSystem::FileExists(topMipPath, FSR_Absolute) && FileSystem::FileExists(allMipsPath, FSR_Absolute));
+
+	// Switching back finds the first output in the cache instead of cooking it again
+	UNIT_CHECK(assetPipelineCook(cacheDir, ALL_MIPLEVELS, &stats));
+	UNIT_CHECK(stats.mCacheHits == 1 && stats.mCooked == 0 && stats.mUpToDate == 0 && stats.mFailed == 0);
+	UNIT_CHECK(assetPipelineGetCookedPath(cacheDir) == allMipsPath);
+
+	FileSystem::Delete(allMipsPath);
+	FileSystem::Delete(topMipPath);
+	FileSystem::Delete(manifestPath);
+	FileSystem::Delete(FileSystem::FixPath(ASSET_PIPELINE_TEST_SOURCE, FSR_OtherFiles));
+}
@@ -0,0 +1,376 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Tests for the asynchronous file queue: 64 bit ranges, priorities, cancellation and errors.
+
+#include "../../../../Common_3/OS/Interfaces/IAsyncFileSystem.h"
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+#define ASYNC_FILE_TEST_SIZE (64 * 1024)
+
+static uint8_t getAsyncFileTestByte(uint64_t offset)
+{
+	return (uint8_t)((offset * 2654435761ULL) >> 13);
+}
+
+static bool writeAsyncFileTestFile(const char* pFileName)
+{
+	File file;
+	if (!file.Open(pFileName, FM_WriteBinary, FSR_OtherFiles))
+		return false;
+	for (uint32_t i = 0; i < ASYNC_FILE_TEST_SIZE; ++i)
+		file.WriteUByte(getAsyncFileTestByte(i));
+	file.Close();
+	return true;
+}
+
+static void deleteAsyncFileTestFile(const char* pFileName)
+{
+	FileSystem::Delete(FileSystem::FixPath(pFileName, FSR_OtherFiles));
+}
+
+// Holds the single I/O thread inside the callback of a request so the following submissions queue up behind it
+struct AsyncFileTestGate
+{
+	Mutex				mMutex;
+	ConditionVariable	mCondition;
+	bool				mEntered = false;
+	bool				mOpen = false;
+};
+
+static void asyncFileTestGateCallback(AsyncReadHandle, AsyncReadStatus, void* pUserData)
+{
+	AsyncFileTestGate* pGate = (AsyncFileTestGate*)pUserData;
+	MutexLock lock(pGate->mMutex);
+	pGate->mEntered = true;
+	pGate->mCondition.SetAll();
+	while (!pGate->mOpen)
+		pGate->mCondition.Wait(pGate->mMutex);
+}
+
+static AsyncReadHandle closeAsyncFileTestGate(AsyncFileQueue* pQueue, AsyncFileTestGate* pGate, const char* pFileName)
+{
+	AsyncReadDesc desc;
+	desc.pFileName = pFileName;
+	desc.mSize = 16;
+	desc.pCallback = asyncFileTestGateCallback;
+	desc.pUserData = pGate;
+	AsyncReadHandle handle = pQueue->Submit(&desc);
+
+	MutexLock lock(pGate->mMutex);
+	while (!pGate->mEntered)
+		pGate->mCondition.Wait(pGate->mMutex);
+	return handle;
+}
+
+static void openAsyncFileTestGate(AsyncFileTestGate* pGate)
+{
+	MutexLock lock(pGate->mMutex);
+	pGate->mOpen = true;
+	pGate->mCondition.SetAll();
+}
+
+struct AsyncFileTestLog
+{
+	Mutex				mMutex;
+	uint32_t			mOrder[16];
+	AsyncReadStatus		mStatus[16];
+	uint32_t			mCount = 0;
+};
+
+struct AsyncFileTestRequest
+{
+	AsyncFileTestLog*	pLog;
+	uint32_t			mTag;
+};
+
+static void asyncFileTestLogCallback(AsyncReadHandle, AsyncReadStatus status, void* pUserData)
+{
+	AsyncFileTestRequest* pRequest = (AsyncFileTestRequest*)pUserData;
+	MutexLock lock(pRequest->pLog->mMutex);
+	pRequest->pLog->mOrder[pRequest->pLog->mCount] = pRequest->mTag;
+	pRequest->pLog->mStatus[pRequest->pLog->mCount] = status;
+	++pRequest->pLog->mCount;
+}
+
+UNIT_TEST(AsyncFileQueueReadsPast4GB)
+{
+	// Sparse file, only the pages around the two written ranges take disk space
+	const char* pFileName = "AsyncFileSystemTestsLarge.bin";
+	const uint64_t offset = (5ULL << 30) + 12345;
+	uint8_t data[4096];
+	for (uint32_t i = 0; i < sizeof(data); ++i)
+		data[i] = getAsyncFileTestByte(offset + i);
+
+	const String path = FileSystem::FixPath(pFileName, FSR_OtherFiles);
+	FileHandle handle = _openFile(path.c_str(), "wb");
+	UNIT_CHECK(handle);
+	// _writeFile returns the item count on some platforms and the byte count on others
+	bool written = _writeFile(data, 16, handle) != 0;
+	written = written && _seekFile64(handle, (int64_t)offset, SEEK_SET);
+	written = written && _writeFile(data, sizeof(data), handle) != 0;
+	_closeFile(handle);
+	if (!written)
+		deleteAsyncFileTestFile(pFileName);
+	UNIT_CHECK(written);
+
+	AsyncFileQueue queue;
+	queue.Init(2);
+
+	// A range starting past 4GB lands at the right position and reports every byte
+	uint8_t readBack[sizeof(data)] = {};
+	AsyncReadDesc desc;
+	desc.pFileName = pFileName;
+	desc.mOffset = offset;
+	desc.mSize = sizeof(readBack);
+	desc.pDestination = readBack;
+	AsyncReadHandle range = queue.Submit(&desc);
+
+	// The whole file size is computed with 64 bits as well
+	AsyncReadDesc tailDesc;
+	tailDesc.pFileName = pFileName;
+	tailDesc.mOffset = offset - 100;
+	AsyncReadHandle tail = queue.Submit(&tailDesc);
+
+	const AsyncReadStatus rangeStatus = queue.Wait(range);
+	const uint64_t rangeBytes = queue.GetBytesRead(range);
+	const AsyncReadStatus tailStatus = queue.Wait(tail);
+	const uint64_t tailBytes = queue.GetBytesRead(tail);
+	const uint8_t* pTail = (const uint8_t*)queue.GetData(tail);
+	const bool tailMatches = tailBytes == sizeof(data) + 100 && pTail[99] == 0 && memcmp(pTail + 100, data, sizeof(data)) == 0;
+	queue.Release(range);
+	queue.Release(tail);
+	queue.Exit();
+	deleteAsyncFileTestFile(pFileName);
+
+	UNIT_CHECK(rangeStatus == ASYNC_READ_STATUS_COMPLETED);
+	UNIT_CHECK(rangeBytes == sizeof(data));
+	UNIT_CHECK(memcmp(readBack, data, sizeof(data)) == 0);
+	UNIT_CHECK(tailStatus == ASYNC_READ_STATUS_COMPLETED);
+	UNIT_CHECK(tailMatches);
+}
+
+UNIT_TEST(AsyncFileQueueServesHighestPriorityFirst)
+{
+	const char* pFileName = "AsyncFileSystemTestsPriority.bin";
+	UNIT_CHECK(writeAsyncFileTestFile(pFileName));
+
+	AsyncFileQueue queue;
+	queue.Init(1);
+	AsyncFileTestGate gate;
+	AsyncReadHandle gateHandle = closeAsyncFileTestGate(&queue, &gate, pFileName);
+
+	// Submitted out of order while the I/O thread is busy, FIFO within a priority
+	const AsyncReadPriority priorities[] = {
+		ASYNC_READ_PRIORITY_LOW, ASYNC_READ_PRIORITY_NORMAL, ASYNC_READ_PRIORITY_CRITICAL,
+		ASYNC_READ_PRIORITY_HIGH, ASYNC_READ_PRIORITY_NORMAL, ASYNC_READ_PRIORITY_CRITICAL, ASYNC_READ_PRIORITY_LOW,
+	};
+	const uint32_t expectedOrder[] = { 2, 5, 3, 1, 4, 0, 6 };
+	const uint32_t requestCount = sizeof(priorities) / sizeof(priorities[0]);
+	AsyncFileTestLog log;
+	AsyncFileTestRequest requests[requestCount];
+	AsyncReadHandle handles[requestCount];
+	for (uint32_t i = 0; i < requestCount; ++i)
+	{
+		requests[i].pLog = &log;
+		requests[i].mTag = i;
+		AsyncReadDesc desc;
+		desc.pFileName = pFileName;
+		desc.mOffset = i * 1000;
+		desc.mSize = 1000;
+		desc.mPriority = priorities[i];
+		desc.pCallback = asyncFileTestLogCallback;
+		desc.pUserData = &requests[i];
+		handles[i] = queue.Submit(&desc);
+	}
+	const uint32_t pendingCount = queue.GetPendingCount();
+
+	openAsyncFileTestGate(&gate);
+	queue.WaitIdle();
+	bool dataMatches = true;
+	for (uint32_t i = 0; i < requestCount; ++i)
+	{
+		const uint8_t* pData = (const uint8_t*)queue.GetData(handles[i]);
+		for (uint32_t j = 0; j < 1000; ++j)
+			dataMatches = dataMatches && pData[j] == getAsyncFileTestByte(i * 1000 + j);
+		queue.Release(handles[i]);
+	}
+	queue.Release(gateHandle);
+	queue.Exit();
+	deleteAsyncFileTestFile(pFileName);
+
+	UNIT_CHECK(pendingCount == requestCount);
+	UNIT_CHECK(log.mCount == requestCount);
+	for (uint32_t i = 0; i < requestCount; ++i)
+	{
+		UNIT_CHECK(log.mOrder[i] == expectedOrder[i]);
+		UNIT_CHECK(log.mStatus[i] == ASYNC_READ_STATUS_COMPLETED);
+	}
+	UNIT_CHECK(dataMatches);
+}
+
+UNIT_TEST(AsyncFileQueueCancelsQueuedRequest)
+{
+	const char* pFileName = "AsyncFileSystemTestsCancel.bin";
+	UNIT_CHECK(writeAsyncFileTestFile(pFileName));
+
+	AsyncFileQueue queue;
+	queue.Init(1);
+	AsyncFileTestGate gate;
+	AsyncReadHandle gateHandle = closeAsyncFileTestGate(&queue, &gate, pFileName);
+
+	AsyncFileTestLog log;
+	AsyncFileTestRequest requests[2] = { { &log, 0 }, { &log, 1 } };
+	AsyncReadHandle handles[2];
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		AsyncReadDesc desc;
+		desc.pFileName = pFileName;
+		desc.pCallback = asyncFileTestLogCallback;
+		desc.pUserData = &requests[i];
+		handles[i] = queue.Submit(&desc);
+	}
+
+	// The queued request finishes right away on the calling thread and never reaches the I/O thread
+	const bool canceled = queue.Cancel(handles[0]);
+	const AsyncReadStatus canceledStatus = queue.GetStatus(handles[0]);
+	const uint32_t pendingCount = queue.GetPendingCount();
+	const uint32_t logCount = log.mCount;
+
+	openAsyncFileTestGate(&gate);
+	const AsyncReadStatus keptStatus = queue.Wait(handles[1]);
+	const bool canceledAgain = queue.Cancel(handles[0]);
+	const uint64_t canceledBytes = queue.GetBytesRead(handles[0]);
+	const void* pCanceledData = queue.GetData(handles[0]);
+	const uint64_t keptBytes = queue.GetBytesRead(handles[1]);
+	queue.Release(handles[0]);
+	queue.Release(handles[1]);
+	queue.Release(gateHandle);
+	queue.Exit();
+	deleteAsyncFileTestFile(pFileName);
+
+	UNIT_CHECK(canceled);
+	UNIT_CHECK(canceledStatus == ASYNC_READ_STATUS_CANCELED);
+	UNIT_CHECK(pendingCount == 1);
+	UNIT_CHECK(logCount == 1);
+	UNIT_CHECK(!canceledAgain);
+	UNIT_CHECK(canceledBytes == 0 && pCanceledData == NULL);
+	UNIT_CHECK(keptStatus == ASYNC_READ_STATUS_COMPLETED && keptBytes == ASYNC_FILE_TEST_SIZE);
+	UNIT_CHECK(log.mCount == 2);
+	UNIT_CHECK(log.mOrder[0] == 0 && log.mStatus[0] == ASYNC_READ_STATUS_CANCELED);
+	UNIT_CHECK(log.mOrder[1] == 1 && log.mStatus[1] == ASYNC_READ_STATUS_COMPLETED);
+}
+
+UNIT_TEST(AsyncFileQueueReportsMissingFile)
+{
+	const char* pFileName = "AsyncFileSystemTestsShort.bin";
+	UNIT_CHECK(writeAsyncFileTestFile(pFileName));
+
+	AsyncFileQueue queue;
+	queue.Init(1);
+	AsyncFileTestLog log;
+	AsyncFileTestRequest requests[2] = { { &log, 0 }, { &log, 1 } };
+
+	AsyncReadDesc missingDesc;
+	missingDesc.pFileName = "AsyncFileSystemTestsMissing.bin";
+	missingDesc.pCallback = asyncFileTestLogCallback;
+	missingDesc.pUserData = &requests[0];
+	AsyncReadHandle missing = queue.Submit(&missingDesc);
+
+	// A range running past the end of the file fails as well, after reading what is there
+	AsyncReadDesc shortDesc;
+	shortDesc.pFileName = pFileName;
+	shortDesc.mOffset = ASYNC_FILE_TEST_SIZE - 100;
+	shortDesc.mSize = 200;
+	shortDesc.pCallback = asyncFileTestLogCallback;
+	shortDesc.pUserData = &requests[1];
+	AsyncReadHandle truncated = queue.Submit(&shortDesc);
+
+	const AsyncReadStatus missingStatus = queue.Wait(missing);
+	const uint64_t missingBytes = queue.GetBytesRead(missing);
+	const AsyncReadStatus truncatedStatus = queue.Wait(truncated);
+	const uint64_t truncatedBytes = queue.GetBytesRead(truncated);
+	queue.Release(missing);
+	queue.Release(truncated);
+	queue.Exit();
+	deleteAsyncFileTestFile(pFileName);
+
+	UNIT_CHECK(missingStatus == ASYNC_READ_STATUS_FAILED && missingBytes == 0);
+	UNIT_CHECK(truncatedStatus == ASYNC_READ_STATUS_FAILED && truncatedBytes == 100);
+	UNIT_CHECK(log.mCount == 2);
+	UNIT_CHECK(log.mStatus[0] == ASYNC_READ_STATUS_FAILED && log.mStatus[1] == ASYNC_READ_STATUS_FAILED);
+}
+
+UNIT_TEST(AsyncFileQueueWaitIdleDrainsAllThreads)
+{
+	const char* pFileName = "AsyncFileSystemTestsIdle.bin";
+	UNIT_CHECK(writeAsyncFileTestFile(pFileName));
+
+	AsyncFileQueue queue;
+	queue.Init(4);
+	AsyncFileTestLog log;
+	const uint32_t requestCount = 16;
+	AsyncFileTestRequest requests[requestCount];
+	AsyncReadHandle handles[requestCount];
+	uint8_t destinations[requestCount][4096];
+	for (uint32_t i = 0; i < requestCount; ++i)
+	{
+		requests[i].pLog = &log;
+		requests[i].mTag = i;
+		AsyncReadDesc desc;
+		desc.pFileName = pFileName;
+		desc.mOffset = i * 4096;
+		desc.mSize = 4096;
+		desc.pDestination = destinations[i];
+		desc.mPriority = (AsyncReadPriority)(i % ASYNC_READ_PRIORITY_COUNT);
+		desc.pCallback = asyncFileTestLogCallback;
+		desc.pUserData = &requests[i];
+		handles[i] = queue.Submit(&desc);
+	}
+
+	// Every callback ran and every status is final once WaitIdle returns, without waiting on the handles
+	queue.WaitIdle();
+	const uint32_t pendingCount = queue.GetPendingCount();
+	const uint32_t logCount = log.mCount;
+	bool completed = true;
+	for (uint32_t i = 0; i < requestCount; ++i)
+		completed = completed && queue.GetStatus(handles[i]) == ASYNC_READ_STATUS_COMPLETED && queue.GetBytesRead(handles[i]) == 4096;
+
+	// Idle queue returns right away
+	queue.WaitIdle();
+	for (uint32_t i = 0; i < requestCount; ++i)
+		queue.Release(handles[i]);
+	queue.Exit();
+	deleteAsyncFileTestFile(pFileName);
+
+	UNIT_CHECK(pendingCount == 0);
+	UNIT_CHECK(logCount == requestCount);
+	UNIT_CHECK(completed);
+	for (uint32_t i = 0; i < requestCount; ++i)
+		for (uint32_t j = 0; j < 4096; j += 97)
+			UNIT_CHECK(destinations[i][j] == getAsyncFileTestByte(i * 4096 + j));
+}
@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Tests for the command capture layer: capturing the same calls twice gives the same file and replaying a capture
+// while capturing again reproduces it.
+
+// Calls made in this file go through the capture layer, like in an application built with ENABLE_COMMAND_CAPTURE
+#ifndef ENABLE_COMMAND_CAPTURE
+#define ENABLE_COMMAND_CAPTURE
+#endif
+
+#include "../../../../Common_3/Renderer/IRenderer.h"
+#include "../../../../Common_3/Renderer/CommandCapture.h"
+#include "../../../../Common_3/OS/Interfaces/IFileSystem.h"
+#include "../../../../Common_3/OS/UI/UIShaders.h"
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+COMMAND_CAPTURE_LAYER_BEGIN
+extern void addBuffer(Renderer* pRenderer, const BufferDesc* desc, Buffer** pp_buffer);
+extern void removeBuffer(Renderer* pRenderer, Buffer* p_buffer);
+extern void mapBuffer(Renderer* pRenderer, Buffer* pBuffer, ReadRange* pRange);
+extern void unmapBuffer(Renderer* pRenderer, Buffer* pBuffer);
+extern void addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** pp_texture);
+extern void removeTexture(Renderer* pRenderer, Texture*p_texture);
+extern void cmdUpdateBuffer(Cmd* p_cmd, uint64_t srcOffset, uint64_t dstOffset, uint64_t size, Buffer* p_src_buffer, Buffer* p_buffer);
+COMMAND_CAPTURE_LAYER_END
+
+static const uint32_t gCaptureTestFrameCount = 4;
+/// beginCmd, cmdBeginDebugMarker, cmdBeginRender, cmdSetViewport, cmdSetScissor, cmdBindPipeline, cmdBindDescriptors,
+/// cmdBindVertexBuffer, cmdDraw, cmdDrawInstanced, cmdEndRender, cmdEndDebugMarker, endCmd
+static const uint32_t gCaptureTestFrameCommandCount = 13;
+/// beginCmd, cmdUpdateBuffer, endCmd of the vertex upload
+static const uint32_t gCaptureTestUploadCommandCount = 3;
+
+static String captureTestSpirv(const uint32_t* pCode, size_t size)
+{
+	String code;
+	code.resize((uint32_t)size);
+	memcpy(code.begin(), pCode, size);
+	return code;
+}
+
+static void submitCaptureTestCmd(Queue* pQueue, Cmd* pCmd, Fence* pFence)
+{
+	queueSubmit(pQueue, 1, &pCmd, pFence, 0, NULL, 0, NULL);
+	waitForFences(pQueue, 1, &pFence);
+}
+
+// Creates a small scene, draws a few frames with per frame uniform data and destroys everything again
+static void drawCaptureTestScene()
+{
+	Renderer* pRenderer = NULL;
+	RendererDesc settings = {};
+	initRenderer("CommandCaptureTests", &settings, &pRenderer);
+	QueueDesc queueDesc = {};
+	queueDesc.mType = CMD_POOL_DIRECT;
+	Queue* pQueue = NULL;
+	addQueue(pRenderer, &queueDesc, &pQueue);
+	CmdPool* pCmdPool = NULL;
+	addCmdPool(pRenderer, pQueue, false, &pCmdPool);
+	Cmd* pCmd = NULL;
+	addCmd(pCmdPool, false, &pCmd);
+	Fence* pFence = NULL;
+	addFence(pRenderer, &pFence);
+
+	RenderTargetDesc renderTargetDesc = {};
+	renderTargetDesc.mType = RENDER_TARGET_TYPE_2D;
+	renderTargetDesc.mWidth = 64;
+	renderTargetDesc.mHeight = 32;
+	renderTargetDesc.mDepth = 1;
+	renderTargetDesc.mArraySize = 1;
+	renderTargetDesc.mSampleCount = SAMPLE_COUNT_1;
+	renderTargetDesc.mFormat = ImageFormat::RGBA8;
+	renderTargetDesc.mUsage = RENDER_TARGET_USAGE_COLOR;
+	RenderTarget* pRenderTarget = NULL;
+	addRenderTarget(pRenderer, &renderTargetDesc, &pRenderTarget);
+
+	TextureDesc textureDesc = {};
+	textureDesc.mType = TEXTURE_TYPE_2D;
+	textureDesc.mWidth = 4;
+	textureDesc.mHeight = 4;
+	textureDesc.mDepth = 1;
+	textureDesc.mArraySize = 1;
+	textureDesc.mMipLevels = 1;
+	textureDesc.mSampleCount = SAMPLE_COUNT_1;
+	textureDesc.mFormat = ImageFormat::RGBA8;
+	textureDesc.mUsage = TEXTURE_USAGE_SAMPLED_IMAGE;
+	Texture* pTexture = NULL;
+	addTexture(pRenderer, &textureDesc, &pTexture);
+
+	ShaderDesc shaderDesc = {};
+	shaderDesc.mStages = SHADER_STAGE_VERT | SHADER_STAGE_FRAG;
+	shaderDesc.mVert.mCode = captureTestSpirv(builtin_textured_vert, sizeof(builtin_textured_vert));
+	shaderDesc.mVert.mEntryPoint = "main";
+	shaderDesc.mFrag.mCode = captureTestSpirv(builtin_textured_frag, sizeof(builtin_textured_frag));
+	shaderDesc.mFrag.mEntryPoint = "main";
+	Shader* pShader = NULL;
+	addShader(pRenderer, &shaderDesc, &pShader);
+	Sampler* pSampler = NULL;
+	addSampler(pRenderer, &pSampler);
+	RootSignature* pRootSignature = NULL;
+	addRootSignature(pRenderer, 1, &pShader, &pRootSignature);
+	RasterizerState* pRasterizerState = NULL;
+	addRasterizerState(&pRasterizerState, CULL_MODE_NONE);
+
+	VertexLayout vertexLayout = {};
+	vertexLayout.mAttribCount = 2;
+	vertexLayout.mAttribs[0].mSemantic = SEMANTIC_POSITION;
+	vertexLayout.mAttribs[0].mFormat = ImageFormat::RG32F;
+	vertexLayout.mAttribs[0].mLocation = 0;
+	vertexLayout.mAttribs[0].mOffset = 0;
+	vertexLayout.mAttribs[1].mSemantic = SEMANTIC_TEXCOORD0;
+	vertexLayout.mAttribs[1].mFormat = ImageFormat::RG32F;
+	vertexLayout.mAttribs[1].mLocation = 1;
+	vertexLayout.mAttribs[1].mOffset = 2 * sizeof(float);
+	GraphicsPipelineDesc pipelineDesc = {};
+	pipelineDesc.pShaderProgram = pShader;
+	pipelineDesc.pRootSignature = pRootSignature;
+	pipelineDesc.pVertexLayout = &vertexLayout;
+	pipelineDesc.ppRenderTargets = &pRenderTarget;
+	pipelineDesc.mRenderTargetCount = 1;
+	pipelineDesc.mPrimitiveTopo = PRIMITIVE_TOPO_TRI_LIST;
+	pipelineDesc.pRasterizerState = pRasterizerState;
+	Pipeline* pPipeline = NULL;
+	addPipeline(pRenderer, &pipelineDesc, &pPipeline);
+
+	// Vertices go through a staging buffer, the uniform buffer stays mapped and is rewritten every frame
+	const float vertices[] = { -1.0f, -1.0f, 0.0f, 1.0f, 3.0f, -1.0f, 2.0f, 1.0f, -1.0f, 3.0f, 0.0f, -1.0f };
+	BufferDesc stagingDesc = {};
+	stagingDesc.mUsage = BUFFER_USAGE_UPLOAD;
+	stagingDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_ONLY;
+	stagingDesc.mSize = sizeof(vertices);
+	Buffer* pStagingBuffer = NULL;
+	addBuffer(pRenderer, &stagingDesc, &pStagingBuffer);
+	mapBuffer(pRenderer, pStagingBuffer, NULL);
+	memcpy(pStagingBuffer->pCpuMappedAddress, vertices, sizeof(vertices));
+	unmapBuffer(pRenderer, pStagingBuffer);
+
+	BufferDesc vertexDesc = {};
+	vertexDesc.mUsage = BUFFER_USAGE_VERTEX;
+	vertexDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+	vertexDesc.mStartState = RESOURCE_STATE_COMMON;
+	vertexDesc.mSize = sizeof(vertices);
+	vertexDesc.mVertexStride = 4 * sizeof(float);
+	Buffer* pVertexBuffer = NULL;
+	addBuffer(pRenderer, &vertexDesc, &pVertexBuffer);
+	beginCmd(pCmd);
+	cmdUpdateBuffer(pCmd, 0, 0, sizeof(vertices), pStagingBuffer, pVertexBuffer);
+	endCmd(pCmd);
+	submitCaptureTestCmd(pQueue, pCmd, pFence);
+
+	BufferDesc uniformDesc = {};
+	uniformDesc.mUsage = BUFFER_USAGE_UNIFORM;
+	uniformDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+	uniformDesc.mSize = 16 * sizeof(float);
+	Buffer* pUniformBuffer = NULL;
+	addBuffer(pRenderer, &uniformDesc, &pUniformBuffer);
+	mapBuffer(pRenderer, pUniformBuffer, NULL);
+
+	for (uint32_t frame = 0; frame < gCaptureTestFrameCount; ++frame)
+	{
+		float* pUniforms = (float*)pUniformBuffer->pCpuMappedAddress;
+		for (uint32_t i = 0; i < 16; ++i)
+			pUniforms[i] = (float)(frame * 16 + i) * 0.25f;
+
+		beginCmd(pCmd);
+		cmdBeginDebugMarkerf(pCmd, 1.0f, 0.5f, 0.0f, "Frame %u", frame);
+		cmdBeginRender(pCmd, 1, &pRenderTarget, NULL, NULL);
+		cmdSetViewport(pCmd, 0.0f, 0.0f, 64.0f, 32.0f, 0.0f, 1.0f);
+		cmdSetScissor(pCmd, 0, 0, 64, 32);
+		cmdBindPipeline(pCmd, pPipeline);
+		DescriptorData params[3];
+		params[0].pName = "uniformBlockVS";
+		params[0].ppBuffers = &pUniformBuffer;
+		params[1].pName = "uTex0";
+		params[1].ppTextures = &pTexture;
+		params[2].pName = "uSampler0";
+		params[2].ppSamplers = &pSampler;
+		cmdBindDescriptors(pCmd, pRootSignature, 3, params);
+		cmdBindVertexBuffer(pCmd, 1, &pVertexBuffer);
+		cmdDraw(pCmd, 3, 0);
+		cmdDrawInstanced(pCmd, 3, 0, frame + 1);
+		cmdEndRender(pCmd, 1, &pRenderTarget, NULL);
+		cmdEndDebugMarker(pCmd);
+		endCmd(pCmd);
+		submitCaptureTestCmd(pQueue, pCmd, pFence);
+	}
+
+	unmapBuffer(pRenderer, pUniformBuffer);
+	removeBuffer(pRenderer, pUniformBuffer);
+	removeBuffer(pRenderer, pVertexBuffer);
+	removeBuffer(pRenderer, pStagingBuffer);
+	removePipeline(pRenderer, pPipeline);
+	removeRasterizerState(pRasterizerState);
+	removeRootSignature(pRenderer, pRootSignature);
+	removeSampler(pRenderer, pSampler);
+	removeShader(pRenderer, pShader);
+	removeTexture(pRenderer, pTexture);
+	removeRenderTarget(pRenderer, pRenderTarget);
+	removeFence(pRenderer, pFence);
+	removeCmd(pCmdPool, pCmd);
+	removeCmdPool(pRenderer, pCmdPool);
+	removeQueue(pQueue);
+	removeRenderer(pRenderer);
+}
+
+static void readCaptureTestFile(const char* pFileName, tinystl::vector<uint8_t>* pData)
+{
+	pData->clear();
+	File file;
+	if (!file.Open(pFileName, FM_ReadBinary, FSR_OtherFiles))
+		return;
+	pData->resize(file.GetSize());
+	file.Read(pData->data(), (unsigned)pData->size());
+	file.Close();
+}
+
+static uint32_t countCaptureTestLines(const tinystl::vector<uint8_t>& listing, const char* pOp)
+{
+	// Lines are "<record index> <op><fields>"
+	uint32_t count = 0;
+	size_t opLength = strlen(pOp);
+	for (size_t lineStart = 0; lineStart < listing.size();)
+	{
+		size_t lineEnd = lineStart;
+		while (lineEnd < listing.size() && listing[lineEnd] != '\n')
+			++lineEnd;
+		size_t op = lineStart;
+		while (op < lineEnd && listing[op] != ' ')
+			++op;
+		++op;
+		if (op + opLength <= lineEnd && memcmp(&listing[op], pOp, opLength) == 0 &&
+			(op + opLength == lineEnd || listing[op + opLength] == ' '))
+			++count;
+		lineStart = lineEnd + 1;
+	}
+	return count;
+}
+
+static void deleteCaptureTestFile(const char* pFileName)
+{
+	FileSystem::Delete(FileSystem::FixPath(pFileName, FSR_OtherFiles));
+}
+
+UNIT_TEST(CommandCaptureIsDeterministic)
+{
+	beginCommandCapture("CommandCaptureTestsA.bin", FSR_OtherFiles);
+	bool active = isCommandCaptureActive();
+	drawCaptureTestScene();
+	endCommandCapture();
+	beginCommandCapture("CommandCaptureTestsB.bin", FSR_OtherFiles);
+	drawCaptureTestScene();
+	endCommandCapture();
+
+	tinystl::vector<uint8_t> first;
+	tinystl::vector<uint8_t> second;
+	readCaptureTestFile("CommandCaptureTestsA.bin", &first);
+	readCaptureTestFile("CommandCaptureTestsB.bin", &second);
+
+	CommandReplayDesc replayDesc = {};
+	replayDesc.pFileName = "CommandCaptureTestsA.bin";
+	replayDesc.mRoot = FSR_OtherFiles;
+	replayDesc.pListingFileName = "CommandCaptureTestsA.txt";
+	replayDesc.mListingRoot = FSR_OtherFiles;
+	replayDesc.mListingOnly = true;
+	CommandReplayStats stats = {};
+	bool listed = replayCommandCapture(&replayDesc, &stats);
+	tinystl::vector<uint8_t> listing;
+	readCaptureTestFile("CommandCaptureTestsA.txt", &listing);
+
+	deleteCaptureTestFile("CommandCaptureTestsA.bin");
+	deleteCaptureTestFile("CommandCaptureTestsB.bin");
+	deleteCaptureTestFile("CommandCaptureTestsA.txt");
+
+	UNIT_CHECK(active);
+	UNIT_CHECK(!isCommandCaptureActive());
+	UNIT_CHECK(first.size() > 8);
+	UNIT_CHECK(first.size() == second.size() && memcmp(first.data(), second.data(), first.size()) == 0);
+	UNIT_CHECK(listed);
+	UNIT_CHECK(stats.mCommandCount == gCaptureTestUploadCommandCount + gCaptureTestFrameCount * gCaptureTestFrameCommandCount);
+	UNIT_CHECK(countCaptureTestLines(listing, "cmdDraw") == gCaptureTestFrameCount);
+	UNIT_CHECK(countCaptureTestLines(listing, "cmdDrawInstanced") == gCaptureTestFrameCount);
+	UNIT_CHECK(countCaptureTestLines(listing, "queueSubmit") == gCaptureTestFrameCount + 1);
+	// The staging buffer is written once and the uniform buffer once per frame
+	UNIT_CHECK(countCaptureTestLines(listing, "bufferData") == gCaptureTestFrameCount + 1);
+}
+
+// Replay re-issues the calls through the capture layer, so capturing a replay has to give back the original file,
+// uploaded buffer contents included
+UNIT_TEST(CommandReplayRecapturesCapture)
+{
+	beginCommandCapture("CommandCaptureTestsA.bin", FSR_OtherFiles);
+	drawCaptureTestScene();
+	endCommandCapture();
+
+	CommandReplayDesc replayDesc = {};
+	replayDesc.pFileName = "CommandCaptureTestsA.bin";
+	replayDesc.mRoot = FSR_OtherFiles;
+	CommandReplayStats stats = {};
+	beginCommandCapture("CommandCaptureTestsB.bin", FSR_OtherFiles);
+	bool replayed = replayCommandCapture(&replayDesc, &stats);
+	endCommandCapture();
+
+	tinystl::vector<uint8_t> capture;
+	tinystl::vector<uint8_t> recapture;
+	readCaptureTestFile("CommandCaptureTestsA.bin", &capture);
+	readCaptureTestFile("CommandCaptureTestsB.bin", &recapture);
+
+	// Replaying twice has to issue the same calls both times
+	CommandReplayStats secondStats = {};
+	bool replayedAgain = replayCommandCapture(&replayDesc, &secondStats);
+
+	deleteCaptureTestFile("CommandCaptureTestsA.bin");
+	deleteCaptureTestFile("CommandCaptureTestsB.bin");
+
+	UNIT_CHECK(replayed);
+	UNIT_CHECK(replayedAgain);
+	UNIT_CHECK(capture.size() > 8);
+	UNIT_CHECK(capture.size() == recapture.size() && memcmp(capture.data(), recapture.data(), capture.size()) == 0);
+	UNIT_CHECK(stats.mSubmitCount == gCaptureTestFrameCount + 1);
+	UNIT_CHECK(stats.mUploadedBytes >= sizeof(float) * (12 + 16 * gCaptureTestFrameCount));
+	UNIT_CHECK(secondStats.mRecordCount == stats.mRecordCount);
+	UNIT_CHECK(secondStats.mSubmitCount == stats.mSubmitCount);
+	UNIT_CHECK(secondStats.mUploadedBytes == stats.mUploadedBytes);
+}
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Tests for CRC32C and XXHash64: published vectors, the SSE4.2 path against the table path, streaming and File checksums.
+
+#include "../../../../Common_3/OS/Core/ContentHash.h"
+#include "../../../../Common_3/OS/Interfaces/IFileSystem.h"
+#include "../../../../Common_3/ThirdParty/OpenSource/TinySTL/vector.h"
+
+#include <string.h>
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+// Bit by bit CRC32C, independent of the slicing tables
+static uint32_t getContentHashTestCrc32c(const uint8_t* pData, size_t size)
+{
+	uint32_t crc = ~0u;
+	for (size_t i = 0; i < size; ++i)
+	{
+		crc ^= pData[i];
+		for (uint32_t k = 0; k < 8; ++k)
+			crc = crc & 1 ? (crc >> 1) ^ 0x82F63B78U : crc >> 1;
+	}
+	return ~crc;
+}
+
+static void fillContentHashTestData(uint8_t* pData, size_t size, uint32_t seed)
+{
+	uint32_t state = seed;
+	for (size_t i = 0; i < size; ++i)
+		pData[i] = (uint8_t)unitTestRandom(&state);
+}
+
+UNIT_TEST(Crc32cMatchesPublishedVectors)
+{
+	// RFC 3720 (iSCSI) appendix B.4 and the check value of the CRC-32C catalogue entry
+	uint8_t zeros[32], ones[32], ascending[32], descending[32];
+	for (uint32_t i = 0; i < 32; ++i)
+	{
+		zeros[i] = 0;
+		ones[i] = 0xFF;
+		ascending[i] = (uint8_t)i;
+		descending[i] = (uint8_t)(31 - i);
+	}
+	const char* pCheck = "123456789";
+
+	const bool hardware = IsCrc32cHardwareAccelerated();
+	for (uint32_t path = 0; path < 2; ++path)
+	{
+		SetCrc32cHardwareAccelerated(path == 0 && hardware);
+		UNIT_CHECK(Crc32c(pCheck, 9) == 0xE3069283);
+		UNIT_CHECK(Crc32c(zeros, 32) == 0x8A9136AA);
+		UNIT_CHECK(Crc32c(ones, 32) == 0x62A8AB43);
+		UNIT_CHECK(Crc32c(ascending, 32) == 0x46DD794E);
+		UNIT_CHECK(Crc32c(descending, 32) == 0x113FDB5C);
+		UNIT_CHECK(Crc32c(pCheck, 0) == 0);
+
+		// A running checksum continues where the previous block stopped
+		UNIT_CHECK(Crc32c(pCheck + 4, 5, Crc32c(pCheck, 4)) == 0xE3069283);
+	}
+	UNIT_CHECK(SetCrc32cHardwareAccelerated(true) == hardware);
+}
+
+UNIT_TEST(Crc32cPathsAgree)
+{
+	// Long enough for the three way interleaving of both block sizes, offsets cover every alignment of the head loop
+	const uint32_t maxSize = 3 * 8192 * 4 + 100;
+	tinystl::vector<uint8_t> data(maxSize + 16);
+	fillContentHashTestData(data.data(), data.size(), 0x2F6B);
+
+	const bool hardware = IsCrc32cHardwareAccelerated();
+	if (!hardware)
+		printf("    SSE4.2 is not available, only the table path is checked\n");
+
+	uint32_t state = 0x51D3;
+	for (uint32_t i = 0; i < 2000; ++i)
+	{
+		const uint32_t offset = unitTestRandom(&state) % 16;
+		uint32_t size = unitTestRandom(&state);
+		// Mostly short sizes around the block boundaries, some up to the full buffer
+		size = (i % 4) ? size % (3 * 256 * 2 + 40) : size % maxSize;
+		const uint32_t seed = (i % 3) ? 0 : unitTestRandom(&state);
+		const uint8_t* pData = data.data() + offset;
+
+		SetCrc32cHardwareAccelerated(false);
+		const uint32_t table = Crc32c(pData, size, seed);
+		SetCrc32cHardwareAccelerated(true);
+		const uint32_t accelerated = Crc32c(pData, size, seed);
+		UNIT_CHECK(table == accelerated);
+		if (!seed && size < 4096)
+			UNIT_CHECK(table == getContentHashTestCrc32c(pData, size));
+	}
+	UNIT_CHECK(Crc32c(data.data(), maxSize) == getContentHashTestCrc32c(data.data(), maxSize));
+}
+
+UNIT_TEST(XXHash64MatchesReference)
+{
+	// Digests of the reference XXH64 algorithm
+	const char* pFox = "The quick brown fox jumps over the lazy dog";
+	UNIT_CHECK(XXHash64("", 0) == 0xEF46DB3751D8E999ULL);
+	UNIT_CHECK(XXHash64("a", 1) == 0xD24EC4F1A98C6E5BULL);
+	UNIT_CHECK(XXHash64("abc", 3) == 0x44BC2CF5AD770999ULL);
+	UNIT_CHECK(XXHash64("123456789", 9) == 0x8CB841DB40E6AE83ULL);
+	UNIT_CHECK(XXHash64(pFox, strlen(pFox)) == 0x0B242D361FDA71BCULL);
+	UNIT_CHECK(XXHash64("abc", 3, 0x9E3779B97F4A7C15ULL) == 0x2ED0F59D6B43AC8BULL);
+
+	uint8_t bytes[1024];
+	for (uint32_t i = 0; i < sizeof(bytes); ++i)
+		bytes[i] = (uint8_t)i;
+	UNIT_CHECK(XXHash64(bytes, sizeof(bytes)) == 0x6F3914F18FE4DF57ULL);
+}
+
+UNIT_TEST(ContentHasherStreamingMatchesOneShot)
+{
+	const uint32_t maxSize = 200 * 1024;
+	tinystl::vector<uint8_t> data(maxSize);
+	fillContentHashTestData(data.data(), data.size(), 0x7A11);
+
+	uint32_t state = 0x3C9E;
+	ContentHasher streamed;
+	for (uint32_t i = 0; i < 500; ++i)
+	{
+		// Sizes around the 32 byte stripe and the small tail cases, a few large ones
+		const uint32_t size = (i % 10) ? (i < 200 ? i : unitTestRandom(&state) % 300) : unitTestRandom(&state) % maxSize;
+		const uint64_t seed = (i % 2) ? ((uint64_t)unitTestRandom(&state) << 32 | unitTestRandom(&state)) : 0;
+
+		ContentHasher oneShot(seed);
+		oneShot.Update(data.data(), size);
+
+		// Chunks from empty to a few stripes so the partial stripe buffer is filled, flushed and bypassed
+		streamed.Reset(seed);
+		for (uint32_t position = 0; position < size;)
+		{
+			uint32_t chunk = unitTestRandom(&state) % ((i % 3) ? 9 : 100);
+			chunk = min(chunk, size - position);
+			streamed.Update(data.data() + position, chunk);
+			position += chunk;
+		}
+
+		UNIT_CHECK(streamed.Digest64() == XXHash64(data.data(), size, seed));
+		UNIT_CHECK(streamed.Digest64() == oneShot.Digest64());
+		UNIT_CHECK(streamed.Digest128() == oneShot.Digest128());
+		UNIT_CHECK(oneShot.Digest128().mLow == oneShot.Digest64());
+	}
+
+	// Both halves change with a single flipped bit
+	ContentHasher a, b;
+	a.Update(data.data(), 1000);
+	data[500] ^= 4;
+	b.Update(data.data(), 1000);
+	UNIT_CHECK(a.Digest128().mLow != b.Digest128().mLow && a.Digest128().mHigh != b.Digest128().mHigh);
+}
+
+UNIT_TEST(FileChecksumIsCrc32c)
+{
+	// Larger than CONTENT_HASH_BLOCK_SIZE so the checksum runs over several blocks
+	const char* pFileName = "ContentHashTests.bin";
+	const uint32_t size = CONTENT_HASH_BLOCK_SIZE * 3 + 1234;
+	tinystl::vector<uint8_t> data(size);
+	fillContentHashTestData(data.data(), size, 0xC0DE);
+
+	File file;
+	UNIT_CHECK(file.Open(pFileName, FM_WriteBinary, FSR_OtherFiles));
+	UNIT_CHECK(file.Write(data.data(), size) == size);
+	file.Close();
+
+	UNIT_CHECK(file.Open(pFileName, FM_ReadBinary, FSR_OtherFiles));
+	UNIT_CHECK(file.Seek(100) == 100);
+	const unsigned checksum = file.GetChecksum();
+	const unsigned position = file.GetPosition();
+	const Hash128 contentHash = file.GetContentHash();
+	file.Close();
+	FileSystem::Delete(FileSystem::FixPath(pFileName, FSR_OtherFiles));
+
+	UNIT_CHECK(checksum == Crc32c(data.data(), size));
+	UNIT_CHECK(position == 100);
+	ContentHasher hasher;
+	hasher.Update(data.data(), size);
+	UNIT_CHECK(contentHash == hasher.Digest128());
+
+	MemoryBuffer buffer(data.data(), size);
+	UNIT_CHECK(buffer.GetChecksum() == checksum);
+	UNIT_CHECK(buffer.GetContentHash() == contentHash);
+}
+
+UNIT_BENCHMARK(ContentHashThroughput)
+{
+	// 1GB is far larger than any cache, every hash reads 4GB from memory
+	const size_t size = 1ULL << 30;
+	const uint32_t passCount = 4;
+	uint8_t* pData = (uint8_t*)conf_malloc(size);
+	UNIT_CHECK(pData);
+	for (size_t i = 0; i < size; i += sizeof(uint64_t))
+	{
+		const uint64_t value = i * 0x9E3779B97F4A7C15ULL;
+		memcpy(pData + i, &value, sizeof(value));
+	}
+
+	// The results are printed so the loops can not be optimized out
+	const bool hardware = IsCrc32cHardwareAccelerated();
+	uint32_t crc = 0;
+	int64_t start;
+	if (hardware)
+	{
+		start = getUSec();
+		for (uint32_t i = 0; i < passCount; ++i)
+			crc = Crc32c(pData, size, crc);
+		UNIT_BENCHMARK_REPORT_BYTES("Crc32c SSE4.2", getUSec() - start, size * passCount);
+	}
+
+	SetCrc32cHardwareAccelerated(false);
+	start = getUSec();
+	for (uint32_t i = 0; i < passCount; ++i)
+		crc = Crc32c(pData, size, crc);
+	UNIT_BENCHMARK_REPORT_BYTES("Crc32c table", getUSec() - start, size * passCount);
+	SetCrc32cHardwareAccelerated(true);
+
+	uint64_t hash = 0;
+	start = getUSec();
+	for (uint32_t i = 0; i < passCount; ++i)
+		hash ^= XXHash64(pData, size, i);
+	UNIT_BENCHMARK_REPORT_BYTES("XXHash64", getUSec() - start, size * passCount);
+
+	ContentHasher hasher;
+	start = getUSec();
+	for (uint32_t i = 0; i < passCount; ++i)
+		for (size_t offset = 0; offset < size; offset += CONTENT_HASH_BLOCK_SIZE)
+			hasher.Update(pData + offset, CONTENT_HASH_BLOCK_SIZE);
+	const Hash128 digest = hasher.Digest128();
+	UNIT_BENCHMARK_REPORT_BYTES("ContentHasher 64KB blocks", getUSec() - start, size * passCount);
+
+	printf("    (crc %08x, hash %016llx, digest %016llx)\n", crc, (unsigned long long)hash, (unsigned long long)digest.mLow);
+	conf_free(pData);
+}
@@ -0,0 +1,521 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Tests for the Fontstash glyph atlas: prewarming, batched texture uploads, atlas growth and distance field text. A UIRenderer
+// on top of the null renderer stands in for the GPU, uploads and the draws recorded for text are read back from it.
+
+#include "../../../../Common_3/OS/Interfaces/IThread.h"
+#include "../../../../Common_3/OS/UI/Fontstash.h"
+#include "../../../../Common_3/OS/UI/UIRenderer.h"
+#include "../../../../Common_3/Renderer/IRenderer.h"
+#include "../../../../Common_3/Renderer/Null/NullRenderer.h"
+#include "../../../../Common_3/Renderer/ResourceLoader.h"
+#include "../../../../Common_3/ThirdParty/OpenSource/Fontstash/src/stb_truetype.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+static const char* gFontstashTestStrings[] = {
+	"Frame time: 16.67 ms",
+	"The quick brown fox jumps over the lazy dog",
+	"THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG",
+	"0123456789 +-*/=()[]{}<>",
+	"Shadow map resolution",
+	"Screen space ambient occlusion",
+	"Exposure: 1.25, Gamma: 2.2",
+	"!\"#$%&'@^_`|~;:,.?",
+	"Hello, World!",
+	"Visibility Buffer",
+};
+static const uint32_t gFontstashTestStringCount = sizeof(gFontstashTestStrings) / sizeof(gFontstashTestStrings[0]);
+
+struct FontstashTestContext
+{
+	Renderer*		pRenderer;
+	Queue*			pQueue;
+	CmdPool*		pCmdPool;
+	Cmd*			pCmd;
+	RenderTarget*	pRenderTarget;
+	UIRenderer*		pUIRenderer;
+};
+
+// A text draw as recorded by UIRenderer::drawTexturedR8: the atlas and the vertex buffer holding the TexVertex quads
+struct FontstashTestDraw
+{
+	const Texture*	pTexture;
+	const Buffer*	pVertexBuffer;
+	uint32_t		mVertexCount;
+};
+
+static void initFontstashTestContext(FontstashTestContext* pContext)
+{
+	RendererDesc settings = {};
+	initRenderer("FontstashTests", &settings, &pContext->pRenderer);
+	QueueDesc queueDesc = {};
+	queueDesc.mType = CMD_POOL_DIRECT;
+	addQueue(pContext->pRenderer, &queueDesc, &pContext->pQueue);
+	addCmdPool(pContext->pRenderer, pContext->pQueue, false, &pContext->pCmdPool);
+	addCmd(pContext->pCmdPool, false, &pContext->pCmd);
+	initResourceLoaderInterface(pContext->pRenderer, 16 * 1024 * 1024, false);
+
+	RenderTargetDesc desc = {};
+	desc.mType = RENDER_TARGET_TYPE_2D;
+	desc.mWidth = 1280;
+	desc.mHeight = 720;
+	desc.mDepth = 1;
+	desc.mArraySize = 1;
+	desc.mSampleCount = SAMPLE_COUNT_1;
+	desc.mFormat = ImageFormat::RGBA8;
+	desc.mUsage = RENDER_TARGET_USAGE_COLOR;
+	addRenderTarget(pContext->pRenderer, &desc, &pContext->pRenderTarget);
+
+	pContext->pUIRenderer = conf_placement_new<UIRenderer>(conf_calloc(1, sizeof(UIRenderer)), pContext->pRenderer);
+}
+
+static void exitFontstashTestContext(FontstashTestContext* pContext)
+{
+	pContext->pUIRenderer->~UIRenderer();
+	conf_free(pContext->pUIRenderer);
+	removeRenderTarget(pContext->pRenderer, pContext->pRenderTarget);
+	removeResourceLoaderInterface(pContext->pRenderer);
+	removeCmd(pContext->pCmdPool, pContext->pCmd);
+	removeCmdPool(pContext->pRenderer, pContext->pCmdPool);
+	removeQueue(pContext->pQueue);
+	removeRenderer(pContext->pRenderer);
+}
+
+static Fontstash* addFontstashTestFont(FontstashTestContext* pContext, uint32_t width, uint32_t height, int* pFontID, bool distanceField = false)
+{
+	Fontstash* pFontstash = pContext->pUIRenderer->getFontstash(pContext->pUIRenderer->addFontstash(width, height, distanceField));
+	*pFontID = pFontstash->defineFont("Titillium", "TitilliumText/TitilliumText-Bold.ttf", FSR_Builtin_Fonts);
+	return pFontstash;
+}
+
+static void beginFontstashTestFrame(FontstashTestContext* pContext)
+{
+	beginCmd(pContext->pCmd);
+	pContext->pUIRenderer->beginRender(pContext->pCmd, 1, &pContext->pRenderTarget, NULL);
+}
+
+// Submits the frame and returns the texture bound by each text draw in pTextures, and the draws themselves in pDraws
+static void endFontstashTestFrame(FontstashTestContext* pContext, tinystl::vector<const Texture*>* pTextures, tinystl::vector<FontstashTestDraw>* pDraws = NULL)
+{
+	endCmd(pContext->pCmd);
+	queueSubmit(pContext->pQueue, 1, &pContext->pCmd, NULL, 0, NULL, 0, NULL);
+	finishResourceLoading();
+
+	pTextures->clear();
+	if (pDraws)
+		pDraws->clear();
+	const NullCommandStream* pStream = pContext->pCmd->pNullStream;
+	UNIT_CHECK(pStream->mErrorCount == 0);
+	FontstashTestDraw draw = {};
+	for (uint32_t i = 0; i < pStream->mCommands.size(); ++i)
+	{
+		const NullCommand& command = pStream->mCommands[i];
+		if (command.mType == NULL_CMD_BIND_VERTEX_BUFFER)
+		{
+			draw.pVertexBuffer = (const Buffer*)pStream->mObjects[command.mObjectOffset];
+		}
+		else if (command.mType == NULL_CMD_DRAW)
+		{
+			draw.mVertexCount = command.mArgs[0];
+			if (pDraws)
+				pDraws->push_back(draw);
+		}
+		else if (command.mType == NULL_CMD_BIND_DESCRIPTOR)
+		{
+			const RootSignature* pRootSignature = (const RootSignature*)pStream->mObjects[command.mObjectOffset];
+			if (strcmp(pRootSignature->pDescriptors[command.mArgs[0]].mDesc.name, "uTex0") == 0)
+			{
+				draw.pTexture = (const Texture*)pStream->mObjects[command.mObjectOffset + 1];
+				pTextures->push_back(draw.pTexture);
+			}
+		}
+	}
+}
+
+static uint32_t getFontstashTestTextureCount(const FontstashTestContext* pContext)
+{
+	return pContext->pRenderer->pNullStats->mTextureCount;
+}
+
+static bool equalFontstashTestTextures(const Texture* pA, const Texture* pB)
+{
+	return pA->mDesc.mWidth == pB->mDesc.mWidth && pA->mDesc.mHeight == pB->mDesc.mHeight &&
+		memcmp(pA->pNullMemory, pB->pNullMemory, (size_t)getNullSubresourceSize(pA, 0)) == 0;
+}
+
+// Bilinear filtered fetch from an R8 atlas with clamped addressing, like uSampler0
+static float sampleFontstashTestTexture(const Texture* pTexture, float s, float t)
+{
+	const int width = (int)pTexture->mDesc.mWidth;
+	const int height = (int)pTexture->mDesc.mHeight;
+	const float x = s * width - 0.5f;
+	const float y = t * height - 0.5f;
+	const int x0 = (int)floorf(x);
+	const int y0 = (int)floorf(y);
+	const float fx = x - x0;
+	const float fy = y - y0;
+
+	float texels[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		const int tx = min(max(x0 + (i & 1), 0), width - 1);
+		const int ty = min(max(y0 + (i >> 1), 0), height - 1);
+		texels[i] = pTexture->pNullMemory[tx + ty * width] / 255.0f;
+	}
+	return (texels[0] * (1.0f - fx) + texels[1] * fx) * (1.0f - fy) + (texels[2] * (1.0f - fx) + texels[3] * fx) * fy;
+}
+
+static float smoothstepFontstashTest(float edge0, float edge1, float x)
+{
+	if (edge1 <= edge0)
+		return x >= edge0 ? 1.0f : 0.0f;
+	const float t = min(max((x - edge0) / (edge1 - edge0), 0.0f), 1.0f);
+	return t * t * (3.0f - 2.0f * t);
+}
+
+// Software version of the text pixel shaders. Rasterizes the recorded quads at pixel centers and blends their alpha into pCoverage.
+// fwidth() of the distance field shader is the difference to the neighbouring pixels to the right and below.
+static void rasterizeFontstashTestDraws(const tinystl::vector<FontstashTestDraw>& draws, bool distanceField, uint32_t width, uint32_t height, float* pCoverage)
+{
+	memset(pCoverage, 0, width * height * sizeof(float));
+	for (uint32_t d = 0; d < draws.size(); ++d)
+	{
+		const TexVertex* pVertices = (const TexVertex*)draws[d].pVertexBuffer->pNullMemory;
+		const Texture* pTexture = draws[d].pTexture;
+		UNIT_CHECK(draws[d].mVertexCount % 6 == 0);
+		for (uint32_t q = 0; q < draws[d].mVertexCount; q += 6)
+		{
+			// Fontstash emits axis aligned quads as (x0, y0), (x1, y1), (x1, y0), (x0, y0), (x0, y1), (x1, y1)
+			const TexVertex& v0 = pVertices[q];
+			const TexVertex& v1 = pVertices[q + 1];
+			UNIT_CHECK(pVertices[q + 4].position.x == v0.position.x && pVertices[q + 4].position.y == v1.position.y);
+			const float x0 = v0.position.x, y0 = v0.position.y, x1 = v1.position.x, y1 = v1.position.y;
+			if (x1 <= x0 || y1 <= y0)
+				continue;
+			const float dsdx = (v1.texCoord.x - v0.texCoord.x) / (x1 - x0);
+			const float dtdy = (v1.texCoord.y - v0.texCoord.y) / (y1 - y0);
+
+			const int px0 = max((int)ceilf(x0 - 0.5f), 0);
+			const int py0 = max((int)ceilf(y0 - 0.5f), 0);
+			const int px1 = min((int)ceilf(x1 - 0.5f), (int)width);
+			const int py1 = min((int)ceilf(y1 - 0.5f), (int)height);
+			for (int py = py0; py < py1; ++py)
+			{
+				for (int px = px0; px < px1; ++px)
+				{
+					const float s = v0.texCoord.x + (px + 0.5f - x0) * dsdx;
+					const float t = v0.texCoord.y + (py + 0.5f - y0) * dtdy;
+					float alpha = sampleFontstashTestTexture(pTexture, s, t);
+					if (distanceField)
+					{
+						const float ddx = sampleFontstashTestTexture(pTexture, s + dsdx, t) - alpha;
+						const float ddy = sampleFontstashTestTexture(pTexture, s, t + dtdy) - alpha;
+						const float w = (fabsf(ddx) + fabsf(ddy)) * 0.5f;
+						alpha = smoothstepFontstashTest(0.5f - w, 0.5f + w, alpha);
+					}
+					float& coverage = pCoverage[px + py * width];
+					coverage += alpha * (1.0f - coverage);
+				}
+			}
+		}
+	}
+}
+
+UNIT_TEST(FontstashPrewarmBatchesUploads)
+{
+	FontstashTestContext context;
+	initFontstashTestContext(&context);
+	tinystl::vector<const Texture*> textures;
+	const float size = 24.0f;
+
+	// Drawing without prewarming uploads the atlas again whenever a string brings new glyphs
+	int lazyFont = -1;
+	Fontstash* pLazy = addFontstashTestFont(&context, 512, 512, &lazyFont);
+	UNIT_CHECK(lazyFont != -1);
+	uint32_t textureCount = getFontstashTestTextureCount(&context);
+	beginFontstashTestFrame(&context);
+	for (uint32_t i = 0; i < gFontstashTestStringCount; ++i)
+		pLazy->drawText(gFontstashTestStrings[i], 10.0f, 30.0f * i, lazyFont, 0xffffffff, size);
+	endFontstashTestFrame(&context, &textures);
+
+	FontstashAtlasStats lazyStats = {};
+	pLazy->getAtlasStats(&lazyStats);
+	UNIT_CHECK(textures.size() == gFontstashTestStringCount);
+	UNIT_CHECK(lazyStats.mTextureUpdates > 1);
+	UNIT_CHECK(getFontstashTestTextureCount(&context) - textureCount == lazyStats.mTextureUpdates);
+	const Texture* pLazyTexture = textures.back();
+
+	// Prewarming the same strings uploads them once, the draws afterwards don't touch the texture
+	int warmFont = -1;
+	Fontstash* pWarm = addFontstashTestFont(&context, 512, 512, &warmFont);
+	UNIT_CHECK(warmFont != -1);
+	textureCount = getFontstashTestTextureCount(&context);
+	for (uint32_t i = 0; i < gFontstashTestStringCount; ++i)
+		UNIT_CHECK(pWarm->prewarm(gFontstashTestStrings[i], warmFont, &size, 1) == 0);
+
+	FontstashAtlasStats warmStats = {};
+	pWarm->getAtlasStats(&warmStats);
+	UNIT_CHECK(warmStats.mTextureUpdates == 0);
+	UNIT_CHECK(warmStats.mGlyphCount == lazyStats.mGlyphCount);
+	pWarm->updateTexture();
+	pWarm->updateTexture();
+	UNIT_CHECK(getFontstashTestTextureCount(&context) - textureCount == 1);
+
+	beginFontstashTestFrame(&context);
+	for (uint32_t i = 0; i < gFontstashTestStringCount; ++i)
+		pWarm->drawText(gFontstashTestStrings[i], 10.0f, 30.0f * i, warmFont, 0xffffffff, size);
+	endFontstashTestFrame(&context, &textures);
+
+	pWarm->getAtlasStats(&warmStats);
+	UNIT_CHECK(warmStats.mTextureUpdates == 1);
+	UNIT_CHECK(getFontstashTestTextureCount(&context) - textureCount == 1);
+	UNIT_CHECK(textures.size() == gFontstashTestStringCount);
+	for (uint32_t i = 1; i < textures.size(); ++i)
+		UNIT_CHECK(textures[i] == textures[0]);
+
+	// Glyphs were packed in the same order, so the single upload has to match the result of all the lazy ones
+	UNIT_CHECK(equalFontstashTestTextures(textures[0], pLazyTexture));
+
+	// A new size is rasterized lazily again, once for the whole frame when prewarmed first
+	const float newSize = 31.0f;
+	pWarm->prewarm(gFontstashTestStrings[1], warmFont, &newSize, 1);
+	beginFontstashTestFrame(&context);
+	pWarm->drawText(gFontstashTestStrings[0], 10.0f, 30.0f, warmFont, 0xffffffff, size);
+	pWarm->drawText(gFontstashTestStrings[1], 10.0f, 60.0f, warmFont, 0xffffffff, newSize);
+	endFontstashTestFrame(&context, &textures);
+	pWarm->getAtlasStats(&warmStats);
+	UNIT_CHECK(warmStats.mTextureUpdates == 2);
+	UNIT_CHECK(textures.size() == 2 && textures[0] == textures[1]);
+
+	exitFontstashTestContext(&context);
+}
+
+UNIT_TEST(FontstashAtlasGrowsOnDemand)
+{
+	FontstashTestContext context;
+	initFontstashTestContext(&context);
+	tinystl::vector<const Texture*> textures;
+
+	uint32_t codepoints[286];
+	for (uint32_t i = 0; i < 95; ++i)
+		codepoints[i] = 32 + i;
+	for (uint32_t i = 95; i < 286; ++i)
+		codepoints[i] = 0xA0 + (i - 95);
+
+	// Far more glyphs than the initial atlas holds
+	int fontID = -1;
+	Fontstash* pFontstash = addFontstashTestFont(&context, 128, 128, &fontID);
+	UNIT_CHECK(fontID != -1);
+	const float sizes[] = { 12.0f, 16.0f, 24.0f, 32.0f, 48.0f };
+	UNIT_CHECK(pFontstash->prewarm(codepoints, 286, fontID, sizes, 5) == 0);
+
+	FontstashAtlasStats stats = {};
+	pFontstash->getAtlasStats(&stats);
+	UNIT_CHECK(stats.mWidth > 128 && stats.mHeight > 128);
+	UNIT_CHECK(stats.mGlyphCount > 0 && stats.mGlyphCount <= 286 * 5);
+	UNIT_CHECK(stats.mGlyphPixels <= stats.mSkylinePixels && stats.mSkylinePixels <= stats.mWidth * stats.mHeight);
+	UNIT_CHECK(stats.mOccupancy > 0.2f && stats.mOccupancy <= 1.0f);
+
+	// The upload has the grown size
+	beginFontstashTestFrame(&context);
+	pFontstash->drawText(gFontstashTestStrings[1], 10.0f, 30.0f, fontID, 0xffffffff, 48.0f);
+	endFontstashTestFrame(&context, &textures);
+	UNIT_CHECK(textures.size() == 1);
+	UNIT_CHECK(textures[0]->mDesc.mWidth == stats.mWidth && textures[0]->mDesc.mHeight == stats.mHeight);
+	pFontstash->getAtlasStats(&stats);
+	UNIT_CHECK(stats.mTextureUpdates == 1);
+
+	// Past FONTSTASH_MAX_ATLAS_SIZE glyphs are reported as dropped instead of corrupting the atlas
+	const float hugeSizes[] = { 700.0f, 900.0f };
+	const uint32_t failed = pFontstash->prewarm(codepoints, 95, fontID, hugeSizes, 2);
+	pFontstash->getAtlasStats(&stats);
+	UNIT_CHECK(failed > 0 && failed < 95 * 2);
+	UNIT_CHECK(stats.mWidth == 4096 && stats.mHeight == 4096);
+	UNIT_CHECK(pFontstash->prewarm(codepoints, 95, fontID, hugeSizes, 2) == failed);
+
+	exitFontstashTestContext(&context);
+}
+
+// Ascent of the test font in units of the text size, computed like fonsAddFontMem does
+static void getFontstashTestAscender(float* pAscender)
+{
+	File file = {};
+	UNIT_CHECK(file.Open("TitilliumText/TitilliumText-Bold.ttf", FileMode::FM_ReadBinary, FSR_Builtin_Fonts));
+	const unsigned size = file.GetSize();
+	tinystl::vector<unsigned char> data(size);
+	UNIT_CHECK(file.Read(data.data(), size) == size);
+	file.Close();
+
+	stbtt_fontinfo font = {};
+	UNIT_CHECK(stbtt_InitFont(&font, data.data(), 0));
+	int ascent, descent, lineGap;
+	stbtt_GetFontVMetrics(&font, &ascent, &descent, &lineGap);
+	*pAscender = (float)ascent / (float)(ascent - descent);
+}
+
+// Draws the printable ASCII glyphs one by one on a grid. The bitmap path snaps the pen to whole pixels after adding the ascent,
+// the pen is placed so that the baseline is a whole pixel already and both paths put the glyphs at the same position.
+static void drawFontstashTestGlyphGrid(Fontstash* pFontstash, int fontID, float size, float ascender, uint32_t width)
+{
+	const float cell = ceilf(size * 1.5f);
+	const uint32_t columns = (uint32_t)((width - 20) / cell);
+	// Keeps the truncation in fons__getQuad from rounding the baseline down to the pixel above
+	const float bias = 1.0f / 64.0f;
+	for (uint32_t c = 33; c < 127; ++c)
+	{
+		const char message[2] = { (char)c, 0 };
+		const uint32_t i = c - 33;
+		const float baseline = 10.0f + cell * (i / columns) + ceilf(ascender * size);
+		pFontstash->drawText(message, 10.0f + cell * (i % columns), baseline - ascender * size + bias, fontID, 0xffffffff, size);
+	}
+}
+
+// The bitmap path rasterizes every size exactly and serves as the golden image, distance field text has to cover the same pixels
+UNIT_TEST(FontstashDistanceFieldMatchesBitmap)
+{
+	FontstashTestContext context;
+	initFontstashTestContext(&context);
+	tinystl::vector<const Texture*> textures;
+	tinystl::vector<FontstashTestDraw> draws;
+
+	int bitmapFont = -1;
+	int sdfFont = -1;
+	Fontstash* pBitmap = addFontstashTestFont(&context, 512, 512, &bitmapFont);
+	Fontstash* pDistanceField = addFontstashTestFont(&context, 512, 512, &sdfFont, true);
+	UNIT_CHECK(bitmapFont != -1 && sdfFont != -1);
+	float ascender = 0.0f;
+	getFontstashTestAscender(&ascender);
+	UNIT_CHECK(ascender > 0.5f && ascender < 1.0f);
+
+	const uint32_t width = context.pRenderTarget->mDesc.mWidth;
+	const uint32_t height = context.pRenderTarget->mDesc.mHeight;
+	tinystl::vector<float> golden(width * height);
+	tinystl::vector<float> coverage(width * height);
+
+	// Small sizes are minified from the FONTSTASH_SDF_BASE_SIZE field and lose the hinting detail of the bitmap rasterizer
+	struct
+	{
+		float	mSize;
+		float	mMinOverlap;
+		float	mMaxInkError;
+	} const cases[] = {
+		{ 12.0f, 0.86f, 0.08f },
+		{ 16.0f, 0.90f, 0.06f },
+		{ 24.0f, 0.95f, 0.04f },
+		{ 32.0f, 0.95f, 0.03f },
+		{ 48.0f, 0.95f, 0.03f },
+	};
+	for (uint32_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c)
+	{
+		beginFontstashTestFrame(&context);
+		drawFontstashTestGlyphGrid(pBitmap, bitmapFont, cases[c].mSize, ascender, width);
+		endFontstashTestFrame(&context, &textures, &draws);
+		UNIT_CHECK(draws.size() == 94);
+		rasterizeFontstashTestDraws(draws, false, width, height, golden.data());
+
+		beginFontstashTestFrame(&context);
+		drawFontstashTestGlyphGrid(pDistanceField, sdfFont, cases[c].mSize, ascender, width);
+		endFontstashTestFrame(&context, &textures, &draws);
+		UNIT_CHECK(draws.size() == 94);
+		rasterizeFontstashTestDraws(draws, true, width, height, coverage.data());
+
+		// Overlap of the pixels at least half covered, the total ink, and solid pixels with nothing around them in the other image
+		uint32_t both = 0, either = 0, stray = 0;
+		double goldenInk = 0.0, ink = 0.0;
+		const float* pImages[2] = { golden.data(), coverage.data() };
+		for (uint32_t y = 1; y < height - 1; ++y)
+		{
+			for (uint32_t x = 1; x < width - 1; ++x)
+			{
+				const uint32_t i = x + y * width;
+				const bool a = golden[i] >= 0.5f;
+				const bool b = coverage[i] >= 0.5f;
+				both += a && b;
+				either += a || b;
+				goldenInk += golden[i];
+				ink += coverage[i];
+				for (uint32_t k = 0; k < 2; ++k)
+				{
+					if (pImages[k][i] < 0.5f)
+						continue;
+					float neighbourhood = 0.0f;
+					for (int dy = -1; dy <= 1; ++dy)
+						for (int dx = -1; dx <= 1; ++dx)
+							neighbourhood = max(neighbourhood, pImages[1 - k][i + dx + dy * (int)width]);
+					stray += neighbourhood < 0.25f;
+				}
+			}
+		}
+		UNIT_CHECK(either > 0 && goldenInk > 0.0);
+		UNIT_CHECK((float)both / either >= cases[c].mMinOverlap);
+		UNIT_CHECK(fabs(ink / goldenInk - 1.0) <= cases[c].mMaxInkError);
+		UNIT_CHECK(stray == 0);
+	}
+
+	exitFontstashTestContext(&context);
+}
+
+// Generating the distance fields on a thread pool writes the same atlas as generating them on the calling thread
+UNIT_TEST(FontstashDistanceFieldThreadPoolIsDeterministic)
+{
+	FontstashTestContext context;
+	initFontstashTestContext(&context);
+	tinystl::vector<const Texture*> textures;
+
+	uint32_t codepoints[286];
+	for (uint32_t i = 0; i < 95; ++i)
+		codepoints[i] = 32 + i;
+	for (uint32_t i = 95; i < 286; ++i)
+		codepoints[i] = 0xA0 + (i - 95);
+
+	ThreadPool threadPool;
+	threadPool.CreateThreads(4);
+	const float size = 32.0f;
+	const Texture* pAtlases[2] = {};
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		int fontID = -1;
+		Fontstash* pFontstash = addFontstashTestFont(&context, 128, 128, &fontID, true);
+		UNIT_CHECK(fontID != -1);
+		pFontstash->setThreadPool(i ? &threadPool : NULL);
+		UNIT_CHECK(pFontstash->prewarm(codepoints, 286, fontID, &size, 1) == 0);
+
+		beginFontstashTestFrame(&context);
+		pFontstash->drawText(gFontstashTestStrings[1], 10.0f, 30.0f, fontID, 0xffffffff, size);
+		endFontstashTestFrame(&context, &textures);
+		UNIT_CHECK(textures.size() == 1);
+		pAtlases[i] = textures[0];
+	}
+	UNIT_CHECK(pAtlases[0] != pAtlases[1]);
+	UNIT_CHECK(equalFontstashTestTextures(pAtlases[0], pAtlases[1]));
+
+	exitFontstashTestContext(&context);
+}
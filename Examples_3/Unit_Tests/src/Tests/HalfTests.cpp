@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// The half conversions checked exhaustively: every one of the 65536 halves, and the rounding at every midpoint between two
+// halves. Each instruction set path of the bulk conversions has to give the same bits as the per value conversion.
+
+#include "../../../../Common_3/OS/Math/half.h"
+#include "../../../../Common_3/OS/Interfaces/IOperatingSystem.h"
+#include "../../../../Common_3/ThirdParty/OpenSource/TinySTL/vector.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+static const HalfConversionPath gHalfTestPaths[] = { HALF_CONVERSION_SCALAR, HALF_CONVERSION_SSE2, HALF_CONVERSION_F16C };
+static const char* gHalfTestPathNames[] = { "scalar", "SSE2", "F16C" };
+static const uint32_t gHalfTestPathCount = sizeof(gHalfTestPaths) / sizeof(gHalfTestPaths[0]);
+
+static uint32_t halfTestFloatBits(float f)
+{
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+
+static float halfTestBitsFloat(uint32_t bits)
+{
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+// IEEE 754 binary16 decoded in double precision, independent of the code under test. NaNs are handled by the callers.
+static double halfTestValue(uint32_t h)
+{
+	const int exponent = (int)((h >> 10) & 0x1F);
+	const double mantissa = (double)(h & 0x3FF);
+	const double value = exponent ? ldexp(1024.0 + mantissa, exponent - 25) : ldexp(mantissa, -24);
+	return (h & 0x8000) ? -value : value;
+}
+
+// Float bits F16C gives for a half: exact values, Inf, and NaNs with their payload and the quiet bit set
+static uint32_t halfTestExpectedFloatBits(uint32_t h)
+{
+	if ((h & 0x7C00) == 0x7C00)
+		return ((h & 0x8000) << 16) | 0x7F800000 | ((h & 0x3FF) << 13) | ((h & 0x3FF) ? 0x00400000 : 0);
+	return halfTestFloatBits((float)halfTestValue(h));
+}
+
+// Converts the inputs with the bulk conversion of the current path and checks every result
+static void checkFloatToHalf(const tinystl::vector<float>& input, const tinystl::vector<unsigned short>& expected)
+{
+	tinystl::vector<half> output(input.size());
+	floatToHalf(input.data(), output.data(), input.size());
+	for (uint32_t i = 0; i < input.size(); ++i)
+		UNIT_CHECK(output[i].sh == expected[i]);
+
+	// Odd start and count, so the vector loops end with a scalar tail
+	for (uint32_t i = 0; i < output.size(); ++i)
+		output[i].sh = 0;
+	floatToHalf(input.data() + 1, output.data() + 1, input.size() - 2);
+	UNIT_CHECK(output[0].sh == 0 && output[output.size() - 1].sh == 0);
+	for (uint32_t i = 1; i < input.size() - 1; ++i)
+		UNIT_CHECK(output[i].sh == expected[i]);
+}
+
+static void checkHalfToFloat(const tinystl::vector<half>& input, const tinystl::vector<uint32_t>& expected)
+{
+	tinystl::vector<float> output(input.size());
+	halfToFloat(input.data(), output.data(), input.size());
+	for (uint32_t i = 0; i < input.size(); ++i)
+		UNIT_CHECK(halfTestFloatBits(output[i]) == expected[i]);
+
+	memset(output.data(), 0, output.size() * sizeof(float));
+	halfToFloat(input.data() + 1, output.data() + 1, input.size() - 2);
+	UNIT_CHECK(halfTestFloatBits(output[0]) == 0 && halfTestFloatBits(output[output.size() - 1]) == 0);
+	for (uint32_t i = 1; i < input.size() - 1; ++i)
+		UNIT_CHECK(halfTestFloatBits(output[i]) == expected[i]);
+}
+
+UNIT_TEST(HalfToFloatExhaustive)
+{
+	tinystl::vector<half> input(65536);
+	tinystl::vector<uint32_t> expected(65536);
+	for (uint32_t h = 0; h < 65536; ++h)
+	{
+		input[h].sh = (unsigned short)h;
+		expected[h] = halfTestExpectedFloatBits(h);
+		UNIT_CHECK(halfTestFloatBits((float)input[h]) == expected[h]);
+	}
+
+	for (uint32_t p = 0; p < gHalfTestPathCount; ++p)
+	{
+		if (setHalfConversionPath(gHalfTestPaths[p]) == gHalfTestPaths[p])
+			checkHalfToFloat(input, expected);
+	}
+	setHalfConversionPath(HALF_CONVERSION_F16C);
+}
+
+UNIT_TEST(FloatToHalfExhaustive)
+{
+	// Every half exactly, NaNs come back quieted
+	tinystl::vector<float> input;
+	tinystl::vector<unsigned short> expected;
+	for (uint32_t h = 0; h < 65536; ++h)
+	{
+		input.push_back(halfTestBitsFloat(halfTestExpectedFloatBits(h)));
+		expected.push_back((unsigned short)(((h & 0x7C00) == 0x7C00 && (h & 0x3FF)) ? h | 0x0200 : h));
+	}
+
+	// The midpoint to the next half in magnitude ties to the even one, the floats right next to it round to the nearer half.
+	// Past 65504 the next step is Inf, 65520 and up overflow.
+	for (uint32_t h = 0; h < 0x7C00; ++h)
+	{
+		const uint32_t exponent = (h >> 10) & 0x1F;
+		const double low = halfTestValue(h);
+		const double high = low + ldexp(1.0, exponent ? (int)exponent - 25 : -24);
+		const float midpoint = (float)((low + high) * 0.5);
+		UNIT_CHECK((double)midpoint == (low + high) * 0.5);
+		for (uint32_t sign = 0; sign <= 0x8000; sign += 0x8000)
+		{
+			const float s = sign ? -1.0f : 1.0f;
+			input.push_back(s * midpoint);
+			expected.push_back((unsigned short)(sign | ((h & 1) ? h + 1 : h)));
+			input.push_back(s * nextafterf(midpoint, 0.0f));
+			expected.push_back((unsigned short)(sign | h));
+			input.push_back(s * nextafterf(midpoint, INFINITY));
+			expected.push_back((unsigned short)(sign | (h + 1)));
+		}
+	}
+
+	// Overflow, and NaNs whose payload only has bits below the half mantissa
+	const float specials[] = { 65519.99f, 65520.0f, 1e10f, 3.4e38f, INFINITY, halfTestBitsFloat(0x7F800001), halfTestBitsFloat(0x7FC00000) };
+	const unsigned short specialHalves[] = { 0x7BFF, 0x7C00, 0x7C00, 0x7C00, 0x7C00, 0x7E00, 0x7E00 };
+	for (uint32_t i = 0; i < sizeof(specials) / sizeof(specials[0]); ++i)
+	{
+		input.push_back(specials[i]);
+		expected.push_back(specialHalves[i]);
+		input.push_back(-specials[i]);
+		expected.push_back((unsigned short)(0x8000 | specialHalves[i]));
+	}
+
+	for (uint32_t i = 0; i < input.size(); ++i)
+		UNIT_CHECK(half(input[i]).sh == expected[i]);
+
+	for (uint32_t p = 0; p < gHalfTestPathCount; ++p)
+	{
+		if (setHalfConversionPath(gHalfTestPaths[p]) == gHalfTestPaths[p])
+			checkFloatToHalf(input, expected);
+	}
+	setHalfConversionPath(HALF_CONVERSION_F16C);
+}
+
+// Random bit patterns cover the float range the exhaustive tests step over, including NaN payloads and denormal floats
+UNIT_TEST(FloatToHalfPathsAgree)
+{
+	uint32_t state = 0x4A1F;
+	tinystl::vector<float> input(1 << 20);
+	tinystl::vector<unsigned short> expected(input.size());
+	for (uint32_t i = 0; i < input.size(); ++i)
+	{
+		input[i] = halfTestBitsFloat(unitTestRandom(&state));
+		expected[i] = half(input[i]).sh;
+	}
+
+	for (uint32_t p = 0; p < gHalfTestPathCount; ++p)
+	{
+		if (setHalfConversionPath(gHalfTestPaths[p]) == gHalfTestPaths[p])
+			checkFloatToHalf(input, expected);
+	}
+	setHalfConversionPath(HALF_CONVERSION_F16C);
+}
+
+UNIT_TEST(HalfConversionPathClamps)
+{
+	const HalfConversionPath best = setHalfConversionPath(HALF_CONVERSION_F16C);
+	UNIT_CHECK(getHalfConversionPath() == best);
+	UNIT_CHECK(setHalfConversionPath(HALF_CONVERSION_SCALAR) == HALF_CONVERSION_SCALAR);
+	UNIT_CHECK(getHalfConversionPath() == HALF_CONVERSION_SCALAR);
+#if defined(_M_X64) || defined(__x86_64__)
+	UNIT_CHECK(best >= HALF_CONVERSION_SSE2);
+#endif
+	setHalfConversionPath(HALF_CONVERSION_F16C);
+}
+
+UNIT_BENCHMARK(HalfConversion)
+{
+	// 16K values stay in the L1/L2 cache, the conversion itself is measured rather than memory bandwidth
+	const uint32_t count = 16 * 1024;
+	const uint32_t iterationCount = 2000;
+	uint32_t state = 0x7C3B;
+	tinystl::vector<float> floats(count);
+	tinystl::vector<half> halves(count);
+	for (uint32_t i = 0; i < count; ++i)
+		floats[i] = unitTestRandomFloat(&state, -1000.0f, 1000.0f);
+
+	char label[128];
+	int64_t start = getUSec();
+	for (uint32_t i = 0; i < iterationCount; ++i)
+		for (uint32_t v = 0; v < count; ++v)
+			halves[v] = floats[v];
+	UNIT_BENCHMARK_REPORT("half(float) per value", getUSec() - start, iterationCount, count);
+
+	start = getUSec();
+	for (uint32_t i = 0; i < iterationCount; ++i)
+		for (uint32_t v = 0; v < count; ++v)
+			floats[v] = halves[v];
+	UNIT_BENCHMARK_REPORT("half::operator float per value", getUSec() - start, iterationCount, count);
+
+	for (uint32_t p = 0; p < gHalfTestPathCount; ++p)
+	{
+		if (setHalfConversionPath(gHalfTestPaths[p]) != gHalfTestPaths[p])
+			continue;
+
+		start = getUSec();
+		for (uint32_t i = 0; i < iterationCount; ++i)
+			floatToHalf(floats.data(), halves.data(), count);
+		sprintf(label, "floatToHalf %s", gHalfTestPathNames[p]);
+		UNIT_BENCHMARK_REPORT(label, getUSec() - start, iterationCount, count);
+
+		start = getUSec();
+		for (uint32_t i = 0; i < iterationCount; ++i)
+			halfToFloat(halves.data(), floats.data(), count);
+		sprintf(label, "halfToFloat %s", gHalfTestPathNames[p]);
+		UNIT_BENCHMARK_REPORT(label, getUSec() - start, iterationCount, count);
+	}
+	setHalfConversionPath(HALF_CONVERSION_F16C);
+}
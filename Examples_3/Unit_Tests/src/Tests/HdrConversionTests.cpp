@@ -0,0 +1,362 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// The batch RGBE8 / RGB9E5 conversions in FloatUtil and the Image::Convert / Image::Unpack paths built on them have to give
+// the same bits as the per pixel helpers. The per pixel helpers are checked against exact decodes and round trips first.
+
+#include "../../../../Common_3/OS/Image/Image.h"
+#include "../../../../Common_3/OS/Interfaces/IOperatingSystem.h"
+#include "../../../../Common_3/OS/Interfaces/IThread.h"
+#include "../../../../Common_3/OS/Math/FloatUtil.h"
+#include "../../../../Common_3/ThirdParty/OpenSource/TinySTL/vector.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+// Written after the last pixel to catch stores past the end of a row
+static const uint32_t gHdrTestGuard = 0xDEADBEEF;
+
+static uint32_t hdrTestFloatBits(float f)
+{
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+
+static float hdrTestBitsFloat(uint32_t bits)
+{
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+static uint32_t rgbToRGBE8Scalar(const float* pRGB)
+{
+	return rgbToRGBE8(vec3(pRGB[0], pRGB[1], pRGB[2]));
+}
+
+static uint32_t rgbToRGB9E5Scalar(const float* pRGB)
+{
+	return rgbToRGB9E5(vec3(pRGB[0], pRGB[1], pRGB[2]));
+}
+
+// Compares the batch packer to the scalar one with 3 and 4 channel rows. The batch runs from pixel 1, once with a count that
+// ends in a scalar tail after the SSE loop and once with a multiple of 4 so the last SSE iteration ends at the guard.
+static void checkHdrPack(const tinystl::vector<float>& rgb, bool rgb9e5)
+{
+	const uint32_t pixelCount = (uint32_t)(rgb.size() / 3);
+	tinystl::vector<uint32_t> expected(pixelCount);
+	tinystl::vector<float> rgba(pixelCount * 4);
+	for (uint32_t i = 0; i < pixelCount; ++i)
+	{
+		expected[i] = rgb9e5 ? rgbToRGB9E5Scalar(&rgb[i * 3]) : rgbToRGBE8Scalar(&rgb[i * 3]);
+		memcpy(&rgba[i * 4], &rgb[i * 3], 3 * sizeof(float));
+		rgba[i * 4 + 3] = hdrTestBitsFloat(0x7FC00000);
+	}
+
+	const uint32_t alignedCount = (pixelCount - 2) & ~3u;
+	const uint32_t counts[] = { alignedCount - 1, alignedCount };
+	for (uint32_t channelCount = 3; channelCount <= 4; ++channelCount)
+	{
+		for (uint32_t n = 0; n < 2; ++n)
+		{
+			const uint32_t count = counts[n];
+			const float* pSrc = (channelCount == 3 ? rgb.data() : rgba.data()) + channelCount;
+			tinystl::vector<uint32_t> packed(pixelCount, gHdrTestGuard);
+			if (rgb9e5)
+				rgbToRGB9E5(pSrc, channelCount, packed.data() + 1, count);
+			else
+				rgbToRGBE8(pSrc, channelCount, packed.data() + 1, count);
+			UNIT_CHECK(packed[0] == gHdrTestGuard && packed[count + 1] == gHdrTestGuard);
+			for (uint32_t i = 1; i <= count; ++i)
+				UNIT_CHECK(packed[i] == expected[i]);
+		}
+	}
+}
+
+// Every mantissa / exponent combination. Each channel decodes exactly to m * 2^(e - 136), and to 0 for e = 0.
+UNIT_TEST(RgbeUnpackExhaustive)
+{
+	const uint32_t pixelCount = 65536;
+	tinystl::vector<unsigned char> rgbe(pixelCount * 4);
+	for (uint32_t i = 0; i < pixelCount; ++i)
+	{
+		rgbe[i * 4 + 0] = (unsigned char)(i & 0xFF);
+		rgbe[i * 4 + 1] = (unsigned char)(255 - (i & 0xFF));
+		rgbe[i * 4 + 2] = (unsigned char)((i & 0xFF) ^ 0x5A);
+		rgbe[i * 4 + 3] = (unsigned char)(i >> 8);
+	}
+
+	tinystl::vector<float> expected(pixelCount * 3);
+	for (uint32_t i = 0; i < pixelCount; ++i)
+	{
+		const int e = rgbe[i * 4 + 3];
+		const vec3 rgb = rgbeToRGB(&rgbe[i * 4]);
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			expected[i * 3 + c] = e ? (float)ldexp((double)rgbe[i * 4 + c], e - 136) : 0.0f;
+			UNIT_CHECK(hdrTestFloatBits((float)rgb[c]) == hdrTestFloatBits(expected[i * 3 + c]));
+		}
+	}
+
+	// From pixel 1, ending in a scalar tail and ending with an SSE iteration right before the guard
+	const uint32_t counts[] = { pixelCount - 3, pixelCount - 4 };
+	for (uint32_t channelCount = 3; channelCount <= 4; ++channelCount)
+	{
+		for (uint32_t n = 0; n < 2; ++n)
+		{
+			const uint32_t count = counts[n];
+			tinystl::vector<float> unpacked(pixelCount * channelCount, hdrTestBitsFloat(gHdrTestGuard));
+			rgbeToRGB(&rgbe[4], unpacked.data() + channelCount, channelCount, count);
+			for (uint32_t c = 0; c < channelCount; ++c)
+			{
+				UNIT_CHECK(hdrTestFloatBits(unpacked[c]) == gHdrTestGuard);
+				UNIT_CHECK(hdrTestFloatBits(unpacked[(count + 1) * channelCount + c]) == gHdrTestGuard);
+			}
+			for (uint32_t i = 1; i <= count; ++i)
+			{
+				for (uint32_t c = 0; c < 3; ++c)
+					UNIT_CHECK(hdrTestFloatBits(unpacked[i * channelCount + c]) == hdrTestFloatBits(expected[i * 3 + c]));
+				if (channelCount == 4)
+					UNIT_CHECK(unpacked[i * channelCount + 3] == 1.0f);
+			}
+		}
+	}
+}
+
+// Decoding a normalized encoding (largest mantissa at least half the range) and packing it again gives the same bits,
+// for every exponent and largest mantissa. Values under the packers' thresholds are stored as 0.
+UNIT_TEST(HdrPackRoundTrip)
+{
+	uint32_t state = 0x6E5D;
+	tinystl::vector<float> rgbe8;
+	tinystl::vector<uint32_t> rgbe8Expected;
+	for (uint32_t e = 1; e < 256; ++e)
+	{
+		for (uint32_t m = 128; m < 256; ++m)
+		{
+			const uint32_t channels[3] = { m, unitTestRandom(&state) % (m + 1), unitTestRandom(&state) % (m + 1) };
+			const uint32_t rotation = unitTestRandom(&state) % 3;
+			uint32_t bits = e << 24;
+			for (uint32_t c = 0; c < 3; ++c)
+			{
+				const uint32_t value = channels[(c + rotation) % 3];
+				rgbe8.push_back((float)ldexp((double)value, (int)e - 136));
+				bits |= value << (c * 8);
+			}
+			rgbe8Expected.push_back(ldexp((double)m, (int)e - 136) < 1e-32 ? 0 : bits);
+		}
+	}
+	for (uint32_t i = 0; i < rgbe8Expected.size(); ++i)
+		UNIT_CHECK(rgbToRGBE8Scalar(&rgbe8[i * 3]) == rgbe8Expected[i]);
+	checkHdrPack(rgbe8, false);
+
+	tinystl::vector<float> rgb9e5;
+	tinystl::vector<uint32_t> rgb9e5Expected;
+	for (uint32_t e = 0; e < 32; ++e)
+	{
+		for (uint32_t m = 256; m < 512; ++m)
+		{
+			const uint32_t channels[3] = { m, unitTestRandom(&state) % (m + 1), unitTestRandom(&state) % (m + 1) };
+			const uint32_t rotation = unitTestRandom(&state) % 3;
+			uint32_t bits = e << 27;
+			for (uint32_t c = 0; c < 3; ++c)
+			{
+				const uint32_t value = channels[(c + rotation) % 3];
+				rgb9e5.push_back((float)ldexp((double)value, (int)e - 24));
+				bits |= value << (c * 9);
+			}
+			rgb9e5Expected.push_back(bits);
+		}
+	}
+	// Below 2^-16 everything is 0, from 65536 on the channels saturate at the largest exponent
+	const float limits[][3] = { { 1.52587e-5f, 0.0f, 0.0f }, { 65536.0f, 1e20f, 128.0f }, { -1.0f, -0.0f, 0.0f } };
+	const uint32_t limitBits[] = { 0, (31u << 27) | 0x1FF | (0x1FF << 9) | (1 << 18), 0 };
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		rgb9e5.insert(rgb9e5.end(), limits[i], limits[i] + 3);
+		rgb9e5Expected.push_back(limitBits[i]);
+	}
+	for (uint32_t i = 0; i < rgb9e5Expected.size(); ++i)
+		UNIT_CHECK(rgbToRGB9E5Scalar(&rgb9e5[i * 3]) == rgb9e5Expected[i]);
+	checkHdrPack(rgb9e5, true);
+}
+
+// The batch packers against the scalar ones on finite floats: random bit patterns (negatives and denormals included),
+// values spread over the whole RGBE8 range, and values around the rounding and clamping thresholds of each format
+UNIT_TEST(HdrPackBatchMatchesScalar)
+{
+	uint32_t state = 0x91E5;
+	const uint32_t pixelCount = 1 << 18;
+	tinystl::vector<float> rgb(pixelCount * 3);
+	const float thresholds[] = { 1e-32f, 1.52587890625e-5f, 65536.0f, 65408.0f, 1.0f, 0.5f, 255.5f, 511.5f };
+	for (uint32_t i = 0; i < pixelCount * 3; ++i)
+	{
+		const uint32_t kind = (i / 3) % 3;
+		if (kind == 0)
+		{
+			uint32_t bits = unitTestRandom(&state);
+			if ((bits & 0x7F800000) == 0x7F800000)
+				bits &= ~0x00800000;
+			rgb[i] = hdrTestBitsFloat(bits);
+		}
+		else if (kind == 1)
+		{
+			rgb[i] = ldexpf(unitTestRandomFloat(&state, 0.0f, 1.0f), (int)(unitTestRandom(&state) % 250) - 125);
+		}
+		else
+		{
+			const float threshold = thresholds[unitTestRandom(&state) % (sizeof(thresholds) / sizeof(thresholds[0]))];
+			rgb[i] = hdrTestBitsFloat(hdrTestFloatBits(threshold) + (unitTestRandom(&state) % 9) - 4);
+		}
+	}
+
+	checkHdrPack(rgb, false);
+	checkHdrPack(rgb, true);
+}
+
+// Image::Convert and Image::Unpack give the per pixel results, on the calling thread and split across a pool
+UNIT_TEST(ImageHdrConvertMatchesScalar)
+{
+	ThreadPool* pThreadPool = conf_placement_new<ThreadPool>(conf_calloc(1, sizeof(ThreadPool)));
+	pThreadPool->CreateThreads(3);
+
+	// Large enough to be split into several tasks, with a size that does not divide evenly
+	const int width = 301;
+	const int height = 229;
+	const uint32_t pixelCount = width * height;
+	uint32_t state = 0x2F0D;
+	tinystl::vector<float> rgba(pixelCount * 4);
+	for (uint32_t i = 0; i < pixelCount * 4; ++i)
+		rgba[i] = ldexpf(unitTestRandomFloat(&state, -0.1f, 1.0f), (int)(unitTestRandom(&state) % 60) - 30);
+
+	tinystl::vector<uint32_t> rgbe8(pixelCount);
+	tinystl::vector<uint32_t> rgb9e5(pixelCount);
+	tinystl::vector<float> unpacked(pixelCount * 3);
+	for (uint32_t i = 0; i < pixelCount; ++i)
+	{
+		rgbe8[i] = rgbToRGBE8Scalar(&rgba[i * 4]);
+		rgb9e5[i] = rgbToRGB9E5Scalar(&rgba[i * 4]);
+		const vec3 rgb = rgbeToRGB((unsigned char*)&rgbe8[i]);
+		for (uint32_t c = 0; c < 3; ++c)
+			unpacked[i * 3 + c] = rgb[c];
+	}
+
+	for (uint32_t t = 0; t < 2; ++t)
+	{
+		ThreadPool* pPool = t ? pThreadPool : NULL;
+
+		Image image;
+		memcpy(image.Create(ImageFormat::RGBA32F, width, height, 1, 1), rgba.data(), rgba.size() * sizeof(float));
+		UNIT_CHECK(image.Convert(ImageFormat::RGBE8, pPool));
+		UNIT_CHECK(image.getFormat() == ImageFormat::RGBE8);
+		UNIT_CHECK(memcmp(image.GetPixels(), rgbe8.data(), pixelCount * 4) == 0);
+
+		// RGBE8 back to floats, with and without alpha
+		UNIT_CHECK(image.Convert(ImageFormat::RGBA32F, pPool));
+		const float* pPixels = (const float*)image.GetPixels();
+		for (uint32_t i = 0; i < pixelCount; ++i)
+		{
+			UNIT_CHECK(memcmp(&pPixels[i * 4], &unpacked[i * 3], 3 * sizeof(float)) == 0);
+			UNIT_CHECK(pPixels[i * 4 + 3] == 1.0f);
+		}
+		image.Destroy();
+
+		memcpy(image.Create(ImageFormat::RGBE8, width, height, 1, 1), rgbe8.data(), pixelCount * 4);
+		UNIT_CHECK(image.Unpack(pPool));
+		UNIT_CHECK(image.getFormat() == ImageFormat::RGB32F);
+		UNIT_CHECK(memcmp(image.GetPixels(), unpacked.data(), unpacked.size() * sizeof(float)) == 0);
+
+		// 3 channel source, packed to RGB9E5
+		UNIT_CHECK(image.Convert(ImageFormat::RGB9E5, pPool));
+		const uint32_t* pPacked = (const uint32_t*)image.GetPixels();
+		for (uint32_t i = 0; i < pixelCount; ++i)
+			UNIT_CHECK(pPacked[i] == rgbToRGB9E5Scalar(&unpacked[i * 3]));
+		image.Destroy();
+
+		memcpy(image.Create(ImageFormat::RGBA32F, width, height, 1, 1), rgba.data(), rgba.size() * sizeof(float));
+		UNIT_CHECK(image.Convert(ImageFormat::RGB9E5, pPool));
+		UNIT_CHECK(memcmp(image.GetPixels(), rgb9e5.data(), pixelCount * 4) == 0);
+		image.Destroy();
+	}
+
+	pThreadPool->~ThreadPool();
+	conf_free(pThreadPool);
+}
+
+UNIT_BENCHMARK(HdrConversion)
+{
+	const uint32_t pixelCount = 1 << 20;
+	const uint32_t iterationCount = 10;
+	uint32_t state = 0x3AD1;
+	tinystl::vector<float> rgb(pixelCount * 3);
+	for (uint32_t i = 0; i < pixelCount * 3; ++i)
+		rgb[i] = ldexpf(unitTestRandomFloat(&state, 0.0f, 1.0f), (int)(unitTestRandom(&state) % 40) - 20);
+	tinystl::vector<uint32_t> packed(pixelCount);
+
+	int64_t start = getUSec();
+	for (uint32_t i = 0; i < iterationCount; ++i)
+		for (uint32_t p = 0; p < pixelCount; ++p)
+			packed[p] = rgbToRGBE8Scalar(&rgb[p * 3]);
+	UNIT_BENCHMARK_REPORT("rgbToRGBE8 per pixel", getUSec() - start, iterationCount, pixelCount);
+
+	start = getUSec();
+	for (uint32_t i = 0; i < iterationCount; ++i)
+		rgbToRGBE8(rgb.data(), 3, packed.data(), pixelCount);
+	UNIT_BENCHMARK_REPORT("rgbToRGBE8 batch", getUSec() - start, iterationCount, pixelCount);
+
+	start = getUSec();
+	for (uint32_t i = 0; i < iterationCount; ++i)
+		for (uint32_t p = 0; p < pixelCount; ++p)
+			packed[p] = rgbToRGB9E5Scalar(&rgb[p * 3]);
+	UNIT_BENCHMARK_REPORT("rgbToRGB9E5 per pixel", getUSec() - start, iterationCount, pixelCount);
+
+	start = getUSec();
+	for (uint32_t i = 0; i < iterationCount; ++i)
+		rgbToRGB9E5(rgb.data(), 3, packed.data(), pixelCount);
+	UNIT_BENCHMARK_REPORT("rgbToRGB9E5 batch", getUSec() - start, iterationCount, pixelCount);
+
+	rgbToRGBE8(rgb.data(), 3, packed.data(), pixelCount);
+	start = getUSec();
+	for (uint32_t i = 0; i < iterationCount; ++i)
+	{
+		for (uint32_t p = 0; p < pixelCount; ++p)
+		{
+			const vec3 value = rgbeToRGB((unsigned char*)&packed[p]);
+			rgb[p * 3 + 0] = value.getX();
+			rgb[p * 3 + 1] = value.getY();
+			rgb[p * 3 + 2] = value.getZ();
+		}
+	}
+	UNIT_BENCHMARK_REPORT("rgbeToRGB per pixel", getUSec() - start, iterationCount, pixelCount);
+
+	start = getUSec();
+	for (uint32_t i = 0; i < iterationCount; ++i)
+		rgbeToRGB((const unsigned char*)packed.data(), rgb.data(), 3, pixelCount);
+	UNIT_BENCHMARK_REPORT("rgbeToRGB batch", getUSec() - start, iterationCount, pixelCount);
+}
@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Tests and benchmarks for the CPU light clustering of Visibility_Buffer. Clusters are checked against a double
+// precision evaluation of the tile and depth slice tests of the cluster_lights shader.
+
+#include "../../../../Examples_3/Visibility_Buffer/src/LightClustering.h"
+#include "../../../../Common_3/OS/Interfaces/IOperatingSystem.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+// Relative slack of the reference comparisons, decisions closer than this to the boundary may go either way
+#define LIGHT_CLUSTER_TEST_EPSILON 1e-4
+
+struct LightClusterTestScene
+{
+	LightData	mLights[LIGHT_COUNT];
+	uint32_t	mLightCount;
+	mat4		mMvp;
+	float		mAspectRatio;
+};
+
+// Lights around a camera looking in a random direction, some of them behind it or closer than LIGHT_SIZE
+static void buildLightClusterTestScene(uint32_t* pState, LightClusterTestScene* pScene)
+{
+	const float aspectRatios[] = { 1.0f, 16.0f / 9.0f, 4.0f / 3.0f, 0.5f };
+	pScene->mAspectRatio = aspectRatios[unitTestRandom(pState) % 4];
+	pScene->mLightCount = unitTestRandom(pState) % (LIGHT_COUNT + 1);
+	for (uint32_t i = 0; i < pScene->mLightCount; ++i)
+	{
+		pScene->mLights[i].position = float4(unitTestRandomFloat(pState, -2000.0f, 2000.0f), unitTestRandomFloat(pState, 0.0f, 300.0f),
+			unitTestRandomFloat(pState, -2000.0f, 2000.0f), 1.0f);
+		pScene->mLights[i].color = float4(1.0f);
+	}
+
+	const mat4 projection = mat4::perspective(unitTestRandomFloat(pState, 0.8f, 1.6f), 1.0f / pScene->mAspectRatio, 10.0f, 3000.0f);
+	const mat4 view = mat4::rotationY(unitTestRandomFloat(pState, 0.0f, 6.28f)) *
+		mat4::translation(vec3(unitTestRandomFloat(pState, -500.0f, 500.0f), -150.0f, unitTestRandomFloat(pState, -500.0f, 500.0f)));
+	pScene->mMvp = projection * view;
+}
+
+static int32_t referenceLightSlice(const LightClusterGrid* pGrid, double z)
+{
+	if (!(z > pGrid->mNearZ))
+		return 0;
+	const double slice = log(z / pGrid->mNearZ) * ((double)pGrid->mSliceCount / log((double)pGrid->mFarZ / pGrid->mNearZ));
+	return slice < (double)(pGrid->mSliceCount - 1) ? (int32_t)slice : (int32_t)pGrid->mSliceCount - 1;
+}
+
+// Slices a light may be added to in [pAllowed[0], pAllowed[1]] and has to be added to in [pRequired[0], pRequired[1]]
+static void referenceLightSlices(const LightClusterGrid* pGrid, double w, int32_t* pAllowed, int32_t* pRequired)
+{
+	if (pGrid->mSliceCount == 1)
+	{
+		pAllowed[0] = pAllowed[1] = pRequired[0] = pRequired[1] = 0;
+		return;
+	}
+
+	const double zMin = w - LIGHT_SIZE;
+	const double zMax = w + LIGHT_SIZE;
+	const double slackMin = fabs(zMin) * LIGHT_CLUSTER_TEST_EPSILON + 1e-3;
+	const double slackMax = fabs(zMax) * LIGHT_CLUSTER_TEST_EPSILON + 1e-3;
+	pAllowed[0] = referenceLightSlice(pGrid, zMin - slackMin);
+	pAllowed[1] = referenceLightSlice(pGrid, zMax + slackMax);
+	pRequired[0] = referenceLightSlice(pGrid, zMin + slackMin);
+	pRequired[1] = referenceLightSlice(pGrid, zMax - slackMax);
+}
+
+// Checks every cluster of pGrid, pAmbiguousCount is increased by the light and cluster pairs too close to call
+static void checkLightClusters(const LightClusterGrid* pGrid, const LightClusterTestScene* pScene, uint32_t* pAmbiguousCount)
+{
+	const double aspectRatio = pScene->mAspectRatio;
+
+	for (uint32_t l = 0; l < pScene->mLightCount; ++l)
+	{
+		const float4& p = pScene->mLights[l].position;
+		double clip[4];
+		for (int c = 0; c < 4; ++c)
+		{
+			clip[c] = (double)pScene->mMvp.getCol(0)[c] * p.x + (double)pScene->mMvp.getCol(1)[c] * p.y +
+				(double)pScene->mMvp.getCol(2)[c] * p.z + (double)pScene->mMvp.getCol(3)[c];
+		}
+
+		// Lights with a depth right at the camera plane may be rejected or not
+		const double depth = clip[2] / clip[3];
+		const bool rejectAmbiguous = fabs(depth) < LIGHT_CLUSTER_TEST_EPSILON;
+		const bool rejected = !rejectAmbiguous && depth < 0.0;
+		const double x = clip[0] / clip[3] * aspectRatio;
+		const double y = clip[1] / clip[3];
+		const double radius = LIGHT_SIZE / clip[3] / 0.5;
+
+		int32_t allowedSlices[2];
+		int32_t requiredSlices[2];
+		referenceLightSlices(pGrid, clip[3], allowedSlices, requiredSlices);
+
+		for (uint32_t iy = 0; iy < LIGHT_CLUSTER_HEIGHT; ++iy)
+		{
+			for (uint32_t ix = 0; ix < LIGHT_CLUSTER_WIDTH; ++ix)
+			{
+				const double left = ((double)ix / LIGHT_CLUSTER_WIDTH * 2.0 - 1.0) * aspectRatio;
+				const double right = ((double)(ix + 1) / LIGHT_CLUSTER_WIDTH * 2.0 - 1.0) * aspectRatio;
+				const double top = (double)iy / LIGHT_CLUSTER_HEIGHT * 2.0 - 1.0;
+				const double bottom = (double)(iy + 1) / LIGHT_CLUSTER_HEIGHT * 2.0 - 1.0;
+				const double tileRadius = sqrt((right - left) * (right - left) + (bottom - top) * (bottom - top)) * 0.5;
+				const double dx = (left + right) * 0.5 - x;
+				const double dy = (top + bottom) * 0.5 - y;
+				const double distance = sqrt(dx * dx + dy * dy);
+				const double margin = distance - (radius + tileRadius);
+				const double slack = (distance + fabs(radius) + tileRadius) * LIGHT_CLUSTER_TEST_EPSILON;
+				const bool overlapAmbiguous = rejectAmbiguous || fabs(margin) <= slack;
+				const bool overlap = !rejected && margin < 0.0;
+
+				for (uint32_t s = 0; s < pGrid->mSliceCount; ++s)
+				{
+					const uint32_t clusterPos = LIGHT_CLUSTER_COUNT_POS(ix, iy) + s * LIGHT_CLUSTER_SLICE_SIZE;
+					const uint32_t* pIndices = pGrid->pLightIndices + clusterPos * LIGHT_COUNT;
+					const uint32_t count = pGrid->pLightCounts[clusterPos];
+					bool present = false;
+					for (uint32_t n = 0; n < count && !present; ++n)
+						present = pIndices[n] == l;
+
+					const bool sliceAllowed = (int32_t)s >= allowedSlices[0] && (int32_t)s <= allowedSlices[1];
+					const bool sliceRequired = (int32_t)s >= requiredSlices[0] && (int32_t)s <= requiredSlices[1];
+					if (overlapAmbiguous || sliceAllowed != sliceRequired)
+					{
+						++*pAmbiguousCount;
+						UNIT_CHECK(!present || rejectAmbiguous || (!rejected && sliceAllowed));
+						continue;
+					}
+					UNIT_CHECK(present == (overlap && sliceRequired));
+				}
+			}
+		}
+	}
+
+	// Clusters hold valid light indices in ascending order
+	for (uint32_t c = 0; c < pGrid->mSliceCount * LIGHT_CLUSTER_SLICE_SIZE; ++c)
+	{
+		const uint32_t count = pGrid->pLightCounts[c];
+		UNIT_CHECK(count <= pScene->mLightCount);
+		for (uint32_t n = 0; n < count && n < LIGHT_COUNT; ++n)
+		{
+			UNIT_CHECK(pGrid->pLightIndices[c * LIGHT_COUNT + n] < pScene->mLightCount);
+			UNIT_CHECK(n == 0 || pGrid->pLightIndices[c * LIGHT_COUNT + n] > pGrid->pLightIndices[c * LIGHT_COUNT + n - 1]);
+		}
+	}
+}
+
+static bool equalLightClusters(const LightClusterGrid* pA, const LightClusterGrid* pB)
+{
+	const uint32_t clusterCount = pA->mSliceCount * LIGHT_CLUSTER_SLICE_SIZE;
+	if (memcmp(pA->pLightCounts, pB->pLightCounts, clusterCount * sizeof(uint32_t)) != 0)
+		return false;
+	for (uint32_t c = 0; c < clusterCount; ++c)
+	{
+		if (memcmp(pA->pLightIndices + c * LIGHT_COUNT, pB->pLightIndices + c * LIGHT_COUNT, pA->pLightCounts[c] * sizeof(uint32_t)) != 0)
+			return false;
+	}
+	return true;
+}
+
+struct LightClusterTestGridDesc
+{
+	uint32_t	mSliceCount;
+	float		mNearZ;
+	float		mFarZ;
+};
+
+static const LightClusterTestGridDesc gLightClusterTestGrids[] = {
+	{ 1, 0.0f, 0.0f },
+	{ 16, 10.0f, 8000.0f },
+	{ LIGHT_CLUSTER_MAX_SLICES, 1.0f, 3000.0f },
+};
+
+UNIT_TEST(LightClusteringMatchesReference)
+{
+	LightClusterTestScene* pScene = (LightClusterTestScene*)conf_calloc(1, sizeof(LightClusterTestScene));
+	uint32_t state = 0x11C7;
+	uint32_t decisionCount = 0;
+	uint32_t ambiguousCount = 0;
+	uint32_t addedCount = 0;
+
+	for (uint32_t g = 0; g < sizeof(gLightClusterTestGrids) / sizeof(gLightClusterTestGrids[0]); ++g)
+	{
+		const LightClusterTestGridDesc& desc = gLightClusterTestGrids[g];
+		LightClusterGrid* pGrid = NULL;
+		addLightClusterGrid(desc.mSliceCount, desc.mNearZ, desc.mFarZ, &pGrid);
+
+		for (uint32_t i = 0; i < 40; ++i)
+		{
+			buildLightClusterTestScene(&state, pScene);
+			clusterLights(pGrid, pScene->mMvp, pScene->mAspectRatio, pScene->mLights, pScene->mLightCount);
+			checkLightClusters(pGrid, pScene, &ambiguousCount);
+			decisionCount += pScene->mLightCount * desc.mSliceCount * LIGHT_CLUSTER_SLICE_SIZE;
+			for (uint32_t c = 0; c < desc.mSliceCount * LIGHT_CLUSTER_SLICE_SIZE; ++c)
+				addedCount += pGrid->pLightCounts[c];
+		}
+
+		removeLightClusterGrid(pGrid);
+	}
+	conf_free(pScene);
+
+	// The slack only covers float rounding, nearly every decision has to be checked
+	UNIT_CHECK(ambiguousCount * 100 < decisionCount);
+	UNIT_CHECK(addedCount > 0);
+}
+
+UNIT_TEST(LightClusteringBinsMatchSingleBin)
+{
+	LightClusterTestScene* pScene = (LightClusterTestScene*)conf_calloc(1, sizeof(LightClusterTestScene));
+	uint32_t state = 0xB175;
+
+	for (uint32_t g = 0; g < sizeof(gLightClusterTestGrids) / sizeof(gLightClusterTestGrids[0]); ++g)
+	{
+		const LightClusterTestGridDesc& desc = gLightClusterTestGrids[g];
+		LightClusterGrid* pReference = NULL;
+		LightClusterGrid* pBinned = NULL;
+		addLightClusterGrid(desc.mSliceCount, desc.mNearZ, desc.mFarZ, &pReference);
+		addLightClusterGrid(desc.mSliceCount, desc.mNearZ, desc.mFarZ, &pBinned);
+
+		for (uint32_t i = 0; i < 10; ++i)
+		{
+			buildLightClusterTestScene(&state, pScene);
+			clusterLights(pReference, pScene->mMvp, pScene->mAspectRatio, pScene->mLights, pScene->mLightCount);
+
+			for (uint32_t binCount = 2; binCount <= 7; ++binCount)
+			{
+				// Stale contents from an earlier frame have to be cleared by the bins
+				memset(pBinned->pLightCounts, 0x5A, desc.mSliceCount * LIGHT_CLUSTER_SLICE_SIZE * sizeof(uint32_t));
+				for (uint32_t bin = 0; bin < binCount; ++bin)
+				{
+					clusterLights(pBinned, pScene->mMvp, pScene->mAspectRatio, pScene->mLights, pScene->mLightCount, bin, binCount);
+					// Rows of the bins still to run are left alone
+					for (uint32_t iy = 0; iy < LIGHT_CLUSTER_HEIGHT; ++iy)
+						UNIT_CHECK(iy % binCount <= bin || pBinned->pLightCounts[LIGHT_CLUSTER_COUNT_POS(0, iy)] == 0x5A5A5A5A);
+				}
+				UNIT_CHECK(equalLightClusters(pReference, pBinned));
+			}
+		}
+
+		removeLightClusterGrid(pBinned);
+		removeLightClusterGrid(pReference);
+	}
+	conf_free(pScene);
+}
+
+UNIT_BENCHMARK(LightClustering)
+{
+	LightClusterTestScene* pScene = (LightClusterTestScene*)conf_calloc(1, sizeof(LightClusterTestScene));
+	uint32_t state = 0x7E57;
+	do
+	{
+		buildLightClusterTestScene(&state, pScene);
+	} while (pScene->mLightCount != LIGHT_COUNT);
+
+	for (uint32_t g = 0; g < 2; ++g)
+	{
+		const LightClusterTestGridDesc& desc = gLightClusterTestGrids[g];
+		LightClusterGrid* pGrid = NULL;
+		addLightClusterGrid(desc.mSliceCount, desc.mNearZ, desc.mFarZ, &pGrid);
+
+		const uint32_t iterationCount = 1000;
+		const int64_t start = getUSec();
+		for (uint32_t i = 0; i < iterationCount; ++i)
+			clusterLights(pGrid, pScene->mMvp, pScene->mAspectRatio, pScene->mLights, pScene->mLightCount);
+		const int64_t usec = getUSec() - start;
+
+		removeLightClusterGrid(pGrid);
+		UNIT_BENCHMARK_REPORT(desc.mSliceCount == 1 ? "cluster 128 lights, 1 slice" : "cluster 128 lights, 16 slices", usec, iterationCount, LIGHT_COUNT);
+	}
+	conf_free(pScene);
+}
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Runs the MeshOptimizer passes on a shuffled sphere grid. Every pass may only reorder triangles, the vertex cache passes
+// may not raise the ACMR, and remapping the vertex streams has to keep the attributes of every triangle.
+
+#include <algorithm>
+#include <string.h>
+
+#include "../../../../Common_3/Tools/MeshOptimizer/MeshOptimizer.h"
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+#define MESH_OPTIMIZER_TEST_SIZE 48
+#define MESH_OPTIMIZER_TEST_STRIDE (sizeof(float) * 3)
+
+struct MeshOptimizerTestVertex
+{
+	float		mUv[2];
+	uint32_t	mSource;
+};
+
+struct MeshOptimizerTestMesh
+{
+	tinystl::vector<float>						mPositions;
+	tinystl::vector<MeshOptimizerTestVertex>	mVertices;
+	tinystl::vector<uint32_t>					mIndices;
+	uint32_t									mVertexCount;
+};
+
+// Latitude / longitude sphere with its triangles shuffled and rotated, plus one vertex no triangle references
+static void meshOptimizerCreateSphere(MeshOptimizerTestMesh* pMesh, uint32_t size, uint32_t seed)
+{
+	const uint32_t rowLength = size + 1;
+	for (uint32_t y = 0; y <= size; ++y)
+	{
+		for (uint32_t x = 0; x <= size; ++x)
+		{
+			float u = (float)x / (float)size;
+			float v = (float)y / (float)size;
+			float theta = u * 2.0f * PI;
+			float phi = v * PI;
+			pMesh->mPositions.push_back(cosf(theta) * sinf(phi));
+			pMesh->mPositions.push_back(cosf(phi));
+			pMesh->mPositions.push_back(sinf(theta) * sinf(phi));
+
+			MeshOptimizerTestVertex vertex = { { u, v }, y * rowLength + x };
+			pMesh->mVertices.push_back(vertex);
+		}
+	}
+
+	float unused[3] = { 2.0f, 2.0f, 2.0f };
+	pMesh->mPositions.insert(pMesh->mPositions.end(), unused, unused + 3);
+	MeshOptimizerTestVertex unusedVertex = { { -1.0f, -1.0f }, rowLength * rowLength };
+	pMesh->mVertices.push_back(unusedVertex);
+	pMesh->mVertexCount = rowLength * rowLength + 1;
+
+	for (uint32_t y = 0; y < size; ++y)
+	{
+		for (uint32_t x = 0; x < size; ++x)
+		{
+			uint32_t v00 = y * rowLength + x, v10 = v00 + 1, v01 = v00 + rowLength, v11 = v01 + 1;
+			uint32_t quad[6] = { v00, v01, v11, v00, v11, v10 };
+			pMesh->mIndices.insert(pMesh->mIndices.end(), quad, quad + 6);
+		}
+	}
+
+	uint32_t state = seed;
+	const uint32_t triangleCount = (uint32_t)pMesh->mIndices.size() / 3;
+	uint32_t* pIndices = pMesh->mIndices.data();
+	for (uint32_t t = triangleCount - 1; t > 0; --t)
+	{
+		uint32_t other = unitTestRandom(&state) % (t + 1);
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			uint32_t temp = pIndices[t * 3 + k];
+			pIndices[t * 3 + k] = pIndices[other * 3 + k];
+			pIndices[other * 3 + k] = temp;
+		}
+	}
+	for (uint32_t t = 0; t < triangleCount; ++t)
+	{
+		uint32_t rotation = unitTestRandom(&state) % 3;
+		uint32_t tri[3] = { pIndices[t * 3], pIndices[t * 3 + 1], pIndices[t * 3 + 2] };
+		for (uint32_t k = 0; k < 3; ++k)
+			pIndices[t * 3 + k] = tri[(k + rotation) % 3];
+	}
+}
+
+// Sorted list of the triangles with their smallest index rotated to the front, so it only depends on the set of triangles
+// and their winding. pVertexMap translates the indices back to source vertices when given
+static void meshOptimizerGetTriangles(const uint32_t* pIndices, uint32_t indexCount, const uint32_t* pVertexMap, tinystl::vector<uint64_t>* pOutTriangles)
+{
+	pOutTriangles->clear();
+	for (uint32_t i = 0; i < indexCount; i += 3)
+	{
+		uint32_t tri[3];
+		for (uint32_t k = 0; k < 3; ++k)
+			tri[k] = pVertexMap ? pVertexMap[pIndices[i + k]] : pIndices[i + k];
+		uint32_t first = tri[0] < tri[1] ? (tri[0] < tri[2] ? 0 : 2) : (tri[1] < tri[2] ? 1 : 2);
+		uint64_t key = ((uint64_t)tri[first] << 42) | ((uint64_t)tri[(first + 1) % 3] << 21) | (uint64_t)tri[(first + 2) % 3];
+		pOutTriangles->push_back(key);
+	}
+	std::sort(pOutTriangles->begin(), pOutTriangles->end());
+}
+
+static bool meshOptimizerSameTriangles(const tinystl::vector<uint64_t>& reference, const uint32_t* pIndices, uint32_t indexCount, const uint32_t* pVertexMap = NULL)
+{
+	tinystl::vector<uint64_t> triangles;
+	meshOptimizerGetTriangles(pIndices, indexCount, pVertexMap, &triangles);
+	return triangles.size() == reference.size() && memcmp(triangles.data(), reference.data(), triangles.size() * sizeof(uint64_t)) == 0;
+}
+
+UNIT_TEST(MeshOptimizerPassesKeepTriangles)
+{
+	MeshOptimizerTestMesh mesh;
+	meshOptimizerCreateSphere(&mesh, MESH_OPTIMIZER_TEST_SIZE, 0x1234);
+	const uint32_t indexCount = (uint32_t)mesh.mIndices.size();
+	const uint32_t vertexCount = mesh.mVertexCount;
+
+	tinystl::vector<uint64_t> reference;
+	meshOptimizerGetTriangles(mesh.mIndices.data(), indexCount, NULL, &reference);
+
+	tinystl::vector<uint32_t> forsyth(indexCount);
+	MeshOptimizer::OptimizeVertexCacheForsyth(forsyth.data(), mesh.mIndices.data(), indexCount, vertexCount);
+	UNIT_CHECK(meshOptimizerSameTriangles(reference, forsyth.data(), indexCount));
+
+	// Destination and source may alias
+	tinystl::vector<uint32_t> inPlace(mesh.mIndices);
+	MeshOptimizer::OptimizeVertexCacheForsyth(inPlace.data(), inPlace.data(), indexCount, vertexCount);
+	UNIT_CHECK(memcmp(inPlace.data(), forsyth.data(), indexCount * sizeof(uint32_t)) == 0);
+
+	tinystl::vector<uint32_t> tipsify(indexCount);
+	MeshOptimizer::OptimizeVertexCacheTipsify(tipsify.data(), mesh.mIndices.data(), indexCount, vertexCount);
+	UNIT_CHECK(meshOptimizerSameTriangles(reference, tipsify.data(), indexCount));
+
+	tinystl::vector<uint32_t> overdraw(indexCount);
+	MeshOptimizer::OptimizeOverdraw(overdraw.data(), tipsify.data(), indexCount, mesh.mPositions.data(), MESH_OPTIMIZER_TEST_STRIDE, vertexCount);
+	UNIT_CHECK(meshOptimizerSameTriangles(reference, overdraw.data(), indexCount));
+
+	tinystl::vector<uint32_t> remap(vertexCount);
+	uint32_t usedCount = MeshOptimizer::GenerateVertexFetchRemap(remap.data(), overdraw.data(), indexCount, vertexCount);
+	UNIT_CHECK(usedCount == vertexCount - 1);
+	UNIT_CHECK(remap[vertexCount - 1] == ~0u);
+
+	// The remap has to be a permutation of the referenced vertices
+	tinystl::vector<uint32_t> inverse(usedCount, ~0u);
+	for (uint32_t v = 0; v < vertexCount - 1; ++v)
+	{
+		UNIT_CHECK(remap[v] < usedCount && inverse[remap[v]] == ~0u);
+		inverse[remap[v]] = v;
+	}
+
+	tinystl::vector<uint32_t> fetch(indexCount);
+	MeshOptimizer::RemapIndexBuffer(fetch.data(), overdraw.data(), indexCount, remap.data());
+	UNIT_CHECK(meshOptimizerSameTriangles(reference, fetch.data(), indexCount, inverse.data()));
+
+	// Vertices are numbered in order of first use
+	uint32_t nextVertex = 0;
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		UNIT_CHECK(fetch[i] <= nextVertex);
+		if (fetch[i] == nextVertex)
+			++nextVertex;
+	}
+	UNIT_CHECK(nextVertex == usedCount);
+}
+
+UNIT_TEST(MeshOptimizerDoesNotRaiseACMR)
+{
+	MeshOptimizerTestMesh mesh;
+	meshOptimizerCreateSphere(&mesh, MESH_OPTIMIZER_TEST_SIZE, 0x5678);
+	const uint32_t indexCount = (uint32_t)mesh.mIndices.size();
+	const uint32_t vertexCount = mesh.mVertexCount;
+
+	const VertexCacheStatistics shuffled = MeshOptimizer::AnalyzeVertexCache(mesh.mIndices.data(), indexCount, vertexCount);
+	// A shuffled grid misses the cache for nearly every vertex
+	UNIT_CHECK(shuffled.mACMR > 2.0f);
+
+	tinystl::vector<uint32_t> forsyth(indexCount);
+	MeshOptimizer::OptimizeVertexCacheForsyth(forsyth.data(), mesh.mIndices.data(), indexCount, vertexCount);
+	const VertexCacheStatistics forsythStats = MeshOptimizer::AnalyzeVertexCache(forsyth.data(), indexCount, vertexCount);
+	UNIT_CHECK(forsythStats.mACMR <= shuffled.mACMR);
+	UNIT_CHECK(forsythStats.mACMR < 1.0f);
+
+	tinystl::vector<uint32_t> tipsify(indexCount);
+	MeshOptimizer::OptimizeVertexCacheTipsify(tipsify.data(), mesh.mIndices.data(), indexCount, vertexCount);
+	const VertexCacheStatistics tipsifyStats = MeshOptimizer::AnalyzeVertexCache(tipsify.data(), indexCount, vertexCount);
+	UNIT_CHECK(tipsifyStats.mACMR <= shuffled.mACMR);
+	UNIT_CHECK(tipsifyStats.mACMR < 1.0f);
+
+	// Overdraw clustering trades some cache efficiency, bounded by the threshold, for the draw order
+	const float threshold = 1.05f;
+	tinystl::vector<uint32_t> overdraw(indexCount);
+	MeshOptimizer::OptimizeOverdraw(overdraw.data(), tipsify.data(), indexCount, mesh.mPositions.data(), MESH_OPTIMIZER_TEST_STRIDE, vertexCount,
+		MESH_OPTIMIZER_DEFAULT_CACHE_SIZE, threshold);
+	const VertexCacheStatistics overdrawStats = MeshOptimizer::AnalyzeVertexCache(overdraw.data(), indexCount, vertexCount);
+	UNIT_CHECK(overdrawStats.mACMR <= shuffled.mACMR);
+
+	// The whole pipeline reports the same numbers it produces
+	MeshOptimizerDesc desc;
+	VertexStream stream = { mesh.mPositions.data(), MESH_OPTIMIZER_TEST_STRIDE };
+	uint32_t optimizedVertexCount = vertexCount;
+	MeshOptimizerStatistics stats;
+	MeshOptimizer::OptimizeMesh(&desc, mesh.mIndices.data(), indexCount, &stream, 1, &optimizedVertexCount, &stats);
+	UNIT_CHECK(stats.mBefore.mACMR == shuffled.mACMR);
+	UNIT_CHECK(stats.mAfter.mACMR <= stats.mBefore.mACMR);
+	UNIT_CHECK(stats.mAfter.mATVR <= stats.mBefore.mATVR);
+	UNIT_CHECK(stats.mAfter.mACMR == MeshOptimizer::AnalyzeVertexCache(mesh.mIndices.data(), indexCount, optimizedVertexCount).mACMR);
+}
+
+UNIT_TEST(MeshOptimizerRemapKeepsVertexAttributes)
+{
+	MeshOptimizerTestMesh mesh;
+	meshOptimizerCreateSphere(&mesh, MESH_OPTIMIZER_TEST_SIZE, 0x9abc);
+	const MeshOptimizerTestMesh source = mesh;
+	const uint32_t indexCount = (uint32_t)mesh.mIndices.size();
+
+	tinystl::vector<uint64_t> reference;
+	meshOptimizerGetTriangles(source.mIndices.data(), indexCount, NULL, &reference);
+
+	const VertexCacheAlgorithm algorithms[] = { VERTEX_CACHE_FORSYTH, VERTEX_CACHE_TIPSIFY };
+	for (uint32_t a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); ++a)
+	{
+		mesh = source;
+
+		MeshOptimizerDesc desc;
+		desc.mVertexCacheAlgorithm = algorithms[a];
+		VertexStream streams[2] =
+		{
+			{ mesh.mPositions.data(), MESH_OPTIMIZER_TEST_STRIDE },
+			{ mesh.mVertices.data(), sizeof(MeshOptimizerTestVertex) },
+		};
+		uint32_t vertexCount = mesh.mVertexCount;
+		MeshOptimizer::OptimizeMesh(&desc, mesh.mIndices.data(), indexCount, streams, 2, &vertexCount);
+		UNIT_CHECK(vertexCount == source.mVertexCount - 1);
+
+		// Every stream moved together: the position and uv of each slot belong to the vertex it came from
+		tinystl::vector<uint32_t> sourceVertex(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; ++v)
+		{
+			const MeshOptimizerTestVertex& vertex = mesh.mVertices[v];
+			UNIT_CHECK(vertex.mSource < source.mVertexCount - 1);
+			UNIT_CHECK(memcmp(&mesh.mPositions[v * 3], &source.mPositions[vertex.mSource * 3], MESH_OPTIMIZER_TEST_STRIDE) == 0);
+			UNIT_CHECK(memcmp(&vertex, &source.mVertices[vertex.mSource], sizeof(vertex)) == 0);
+			sourceVertex[v] = vertex.mSource;
+		}
+
+		// Translated back through the moved attributes the index buffer describes the source triangles
+		UNIT_CHECK(meshOptimizerSameTriangles(reference, mesh.mIndices.data(), indexCount, sourceVertex.data()));
+	}
+}
@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Checks the LOD chains of MeshSimplifier: rising error with falling triangle counts, intact seams and material borders,
+// and identical output whether the meshes are simplified on the calling thread or on a ThreadPool.
+
+#include <float.h>
+#include <string.h>
+
+#include "../../../../Common_3/Tools/MeshOptimizer/MeshSimplifier.h"
+#include "../../../../Common_3/OS/Interfaces/IThread.h"
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+#define SIMPLIFIER_TEST_STRIDE (sizeof(float) * 3)
+#define SIMPLIFIER_TEST_MESH_COUNT 8
+
+struct SimplifierTestMesh
+{
+	tinystl::vector<float>		mPositions;
+	tinystl::vector<uint32_t>	mIndices;
+	tinystl::vector<uint32_t>	mMaterials;
+	uint32_t					mSize;
+	uint32_t					mVertexCount;
+};
+
+// size x size quads in the xy plane displaced along z by a wave. With splitSeam the vertices on x == size / 2 are duplicated
+// for the quads right of it like a UV seam would, and the quads above y == size / 2 get material 1
+static void simplifierCreateGrid(SimplifierTestMesh* pMesh, uint32_t size, float frequency, float amplitude, bool splitSeam)
+{
+	const uint32_t rowLength = size + 1;
+	const uint32_t half = size / 2;
+	pMesh->mSize = size;
+
+	for (uint32_t y = 0; y <= size; ++y)
+	{
+		for (uint32_t x = 0; x <= size; ++x)
+		{
+			pMesh->mPositions.push_back((float)x);
+			pMesh->mPositions.push_back((float)y);
+			pMesh->mPositions.push_back(amplitude * sinf(x * frequency) * cosf(y * frequency * 0.7f));
+		}
+	}
+	if (splitSeam)
+	{
+		// Seam copy of row y is vertex rowLength * rowLength + y
+		for (uint32_t y = 0; y <= size; ++y)
+		{
+			const float* p = &pMesh->mPositions[(y * rowLength + half) * 3];
+			float copy[3] = { p[0], p[1], p[2] };
+			pMesh->mPositions.insert(pMesh->mPositions.end(), copy, copy + 3);
+		}
+	}
+	pMesh->mVertexCount = (uint32_t)pMesh->mPositions.size() / 3;
+
+	for (uint32_t y = 0; y < size; ++y)
+	{
+		for (uint32_t x = 0; x < size; ++x)
+		{
+			uint32_t v[4] = { y * rowLength + x, y * rowLength + x + 1, (y + 1) * rowLength + x, (y + 1) * rowLength + x + 1 };
+			if (splitSeam && x >= half)
+			{
+				for (uint32_t k = 0; k < 4; ++k)
+				{
+					if (v[k] % rowLength == half)
+						v[k] = rowLength * rowLength + v[k] / rowLength;
+				}
+			}
+			uint32_t quad[6] = { v[0], v[1], v[3], v[0], v[3], v[2] };
+			pMesh->mIndices.insert(pMesh->mIndices.end(), quad, quad + 6);
+
+			uint32_t material = splitSeam && y >= half ? 1 : 0;
+			pMesh->mMaterials.push_back(material);
+			pMesh->mMaterials.push_back(material);
+		}
+	}
+}
+
+static const float* simplifierGetPosition(const SimplifierTestMesh* pMesh, uint32_t vertex)
+{
+	return &pMesh->mPositions[vertex * 3];
+}
+
+static float simplifierGetDiagonal(const SimplifierTestMesh* pMesh)
+{
+	float minBounds[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float maxBounds[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (uint32_t v = 0; v < pMesh->mVertexCount; ++v)
+	{
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			minBounds[k] = min(minBounds[k], simplifierGetPosition(pMesh, v)[k]);
+			maxBounds[k] = max(maxBounds[k], simplifierGetPosition(pMesh, v)[k]);
+		}
+	}
+	float3 extent(maxBounds[0] - minBounds[0], maxBounds[1] - minBounds[1], maxBounds[2] - minBounds[2]);
+	return sqrtf(extent.x * extent.x + extent.y * extent.y + extent.z * extent.z);
+}
+
+static uint32_t simplifierGenerateLods(const SimplifierTestMesh* pMesh, const MeshLodDesc* pDesc, tinystl::vector<uint32_t>* pOutIndices, MeshLod* pOutLods)
+{
+	return MeshSimplifier::GenerateLods(pDesc, pMesh->mIndices.data(), (uint32_t)pMesh->mIndices.size(), pMesh->mPositions.data(), SIMPLIFIER_TEST_STRIDE,
+		pMesh->mVertexCount, pOutIndices, pOutLods);
+}
+
+UNIT_TEST(MeshSimplifierLodErrorRisesAndTrianglesFall)
+{
+	SimplifierTestMesh mesh;
+	simplifierCreateGrid(&mesh, 48, 0.35f, 2.0f, false);
+	const uint32_t indexCount = (uint32_t)mesh.mIndices.size();
+
+	MeshLodDesc desc;
+	desc.mLodCount = 5;
+	desc.mReductionPerLod = 0.5f;
+	desc.mMaxRelativeError = 0.05f;
+	const float maxError = simplifierGetDiagonal(&mesh) * desc.mMaxRelativeError;
+
+	tinystl::vector<uint32_t> indices;
+	MeshLod lods[MESH_MAX_LODS];
+	uint32_t lodCount = simplifierGenerateLods(&mesh, &desc, &indices, lods);
+	UNIT_CHECK(lodCount == desc.mLodCount);
+
+	UNIT_CHECK(lods[0].mIndexOffset == 0 && lods[0].mIndexCount == indexCount && lods[0].mError == 0.0f);
+	UNIT_CHECK(memcmp(indices.data(), mesh.mIndices.data(), indexCount * sizeof(uint32_t)) == 0);
+
+	for (uint32_t i = 1; i < lodCount; ++i)
+	{
+		UNIT_CHECK(lods[i].mIndexOffset == lods[i - 1].mIndexOffset + lods[i - 1].mIndexCount);
+		UNIT_CHECK(lods[i].mIndexCount % 3 == 0);
+		UNIT_CHECK(lods[i].mIndexCount < lods[i - 1].mIndexCount);
+		UNIT_CHECK(lods[i].mError > 0.0f && lods[i].mError >= lods[i - 1].mError && lods[i].mError <= maxError);
+
+		const uint32_t* pLod = indices.data() + lods[i].mIndexOffset;
+		for (uint32_t t = 0; t < lods[i].mIndexCount; t += 3)
+		{
+			UNIT_CHECK(pLod[t] < mesh.mVertexCount && pLod[t + 1] < mesh.mVertexCount && pLod[t + 2] < mesh.mVertexCount);
+			UNIT_CHECK(pLod[t] != pLod[t + 1] && pLod[t + 1] != pLod[t + 2] && pLod[t + 2] != pLod[t]);
+		}
+	}
+	UNIT_CHECK(indices.size() == lods[lodCount - 1].mIndexOffset + lods[lodCount - 1].mIndexCount);
+
+	// GenerateLods clamps every error to the one of the previous LOD, the raw errors of the simplifier have to rise on their own
+	tinystl::vector<uint32_t> simplified(indexCount);
+	uint32_t previousCount = indexCount;
+	float previousError = 0.0f;
+	for (uint32_t target = indexCount / 2; target >= indexCount / 16; target /= 2)
+	{
+		float error = 0.0f;
+		uint32_t count = MeshSimplifier::Simplify(simplified.data(), mesh.mIndices.data(), indexCount, mesh.mPositions.data(), SIMPLIFIER_TEST_STRIDE,
+			mesh.mVertexCount, target / 3 * 3, maxError, NULL, &error);
+		UNIT_CHECK(count < previousCount);
+		UNIT_CHECK(error >= previousError && error <= maxError);
+		previousCount = count;
+		previousError = error;
+	}
+}
+
+UNIT_TEST(MeshSimplifierKeepsSeamsAndMaterialBorders)
+{
+	// A flat grid costs nothing to simplify, only the seam at x == half and the material border at y == half hold it back
+	SimplifierTestMesh mesh;
+	simplifierCreateGrid(&mesh, 32, 0.0f, 0.0f, true);
+	const uint32_t size = mesh.mSize;
+	const uint32_t half = size / 2;
+	const uint32_t seamStart = (size + 1) * (size + 1);
+
+	MeshLodDesc desc;
+	desc.mLodCount = 4;
+	desc.mMaxRelativeError = 1.0f;
+	desc.pTriangleMaterials = mesh.mMaterials.data();
+
+	tinystl::vector<uint32_t> indices;
+	MeshLod lods[MESH_MAX_LODS];
+	uint32_t lodCount = simplifierGenerateLods(&mesh, &desc, &indices, lods);
+	UNIT_CHECK(lodCount == desc.mLodCount);
+	UNIT_CHECK(lods[lodCount - 1].mIndexCount * 8 <= lods[0].mIndexCount);
+
+	for (uint32_t i = 0; i < lodCount; ++i)
+	{
+		// Quadrant = side of the seam * 2 + side of the material border
+		double area[4] = {};
+		tinystl::vector<uint8_t> seamUse[2] = { tinystl::vector<uint8_t>(size + 1, 0), tinystl::vector<uint8_t>(size + 1, 0) };
+		tinystl::vector<uint8_t> borderUse[2] = { tinystl::vector<uint8_t>(size + 1, 0), tinystl::vector<uint8_t>(size + 1, 0) };
+
+		const uint32_t* pLod = indices.data() + lods[i].mIndexOffset;
+		for (uint32_t t = 0; t < lods[i].mIndexCount; t += 3)
+		{
+			const float* p[3];
+			uint32_t rightCount = 0;
+			uint32_t upperCount = 0;
+			uint32_t lowerCount = 0;
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				p[k] = simplifierGetPosition(&mesh, pLod[t + k]);
+				// Left of the seam uses the original seam vertices, right of it the copies
+				rightCount += pLod[t + k] >= seamStart || p[k][0] > (float)half;
+				upperCount += p[k][1] >= (float)half;
+				lowerCount += p[k][1] <= (float)half;
+			}
+			// No triangle may cross the seam or the material border
+			UNIT_CHECK(rightCount == 0 || rightCount == 3);
+			UNIT_CHECK(upperCount == 3 || lowerCount == 3);
+			const uint32_t right = rightCount ? 1 : 0;
+			const uint32_t upper = lowerCount == 3 ? 0 : 1;
+
+			double signedArea = 0.5 * ((double)(p[1][0] - p[0][0]) * (p[2][1] - p[0][1]) - (double)(p[2][0] - p[0][0]) * (p[1][1] - p[0][1]));
+			UNIT_CHECK(signedArea > 0.0);
+			area[right * 2 + upper] += signedArea;
+
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				if (p[k][0] == (float)half)
+					seamUse[right][(uint32_t)p[k][1]] = 1;
+				if (p[k][1] == (float)half)
+					borderUse[upper][(uint32_t)p[k][0]] = 1;
+			}
+		}
+
+		// Unflipped triangles covering each quadrant exactly means no seam or border vertex moved off its line
+		for (uint32_t q = 0; q < 4; ++q)
+			UNIT_CHECK(fabs(area[q] - (double)(half * half)) < 1e-3);
+
+		// Both sides have to agree on the vertices left on the seam and the border or there would be cracks
+		UNIT_CHECK(memcmp(seamUse[0].data(), seamUse[1].data(), size + 1) == 0);
+		UNIT_CHECK(memcmp(borderUse[0].data(), borderUse[1].data(), size + 1) == 0);
+
+		// The seam is simplified too, by sliding both sides along it at once
+		if (i == lodCount - 1)
+		{
+			uint32_t seamVertices = 0;
+			for (uint32_t y = 0; y <= size; ++y)
+				seamVertices += seamUse[0][y];
+			UNIT_CHECK(seamVertices < size + 1);
+		}
+	}
+}
+
+struct SimplifierTestTask
+{
+	const SimplifierTestMesh*	pMesh;
+	MeshLodDesc					mDesc;
+	tinystl::vector<uint32_t>	mIndices;
+	MeshLod						mLods[MESH_MAX_LODS];
+	uint32_t					mLodCount;
+};
+
+static void simplifierRunTask(void* pData)
+{
+	SimplifierTestTask* pTask = (SimplifierTestTask*)pData;
+	pTask->mLodCount = simplifierGenerateLods(pTask->pMesh, &pTask->mDesc, &pTask->mIndices, pTask->mLods);
+}
+
+UNIT_TEST(MeshSimplifierThreadPoolMatchesSingleThread)
+{
+	SimplifierTestMesh meshes[SIMPLIFIER_TEST_MESH_COUNT];
+	SimplifierTestTask serialTasks[SIMPLIFIER_TEST_MESH_COUNT];
+	SimplifierTestTask poolTasks[SIMPLIFIER_TEST_MESH_COUNT];
+	for (uint32_t i = 0; i < SIMPLIFIER_TEST_MESH_COUNT; ++i)
+	{
+		bool splitSeam = (i & 1) != 0;
+		simplifierCreateGrid(&meshes[i], 24 + i * 4, 0.2f + 0.05f * i, 1.0f + 0.25f * i, splitSeam);
+
+		MeshLodDesc desc;
+		desc.mLodCount = 6;
+		desc.mMaxRelativeError = 0.1f;
+		desc.pTriangleMaterials = splitSeam ? meshes[i].mMaterials.data() : NULL;
+		serialTasks[i].pMesh = &meshes[i];
+		serialTasks[i].mDesc = desc;
+		poolTasks[i].pMesh = &meshes[i];
+		poolTasks[i].mDesc = desc;
+	}
+
+	for (uint32_t i = 0; i < SIMPLIFIER_TEST_MESH_COUNT; ++i)
+		simplifierRunTask(&serialTasks[i]);
+
+	WorkItem workItems[SIMPLIFIER_TEST_MESH_COUNT];
+	{
+		ThreadPool pool;
+		pool.CreateThreads(4);
+		for (uint32_t i = 0; i < SIMPLIFIER_TEST_MESH_COUNT; ++i)
+		{
+			workItems[i].pFunc = simplifierRunTask;
+			workItems[i].pData = &poolTasks[i];
+			pool.AddWorkItem(&workItems[i]);
+		}
+		pool.Complete(0);
+	}
+
+	for (uint32_t i = 0; i < SIMPLIFIER_TEST_MESH_COUNT; ++i)
+	{
+		const SimplifierTestTask& serial = serialTasks[i];
+		const SimplifierTestTask& pooled = poolTasks[i];
+		UNIT_CHECK(serial.mLodCount > 1);
+		UNIT_CHECK(pooled.mLodCount == serial.mLodCount);
+		UNIT_CHECK(memcmp(pooled.mLods, serial.mLods, serial.mLodCount * sizeof(MeshLod)) == 0);
+		UNIT_CHECK(pooled.mIndices.size() == serial.mIndices.size());
+		UNIT_CHECK(memcmp(pooled.mIndices.data(), serial.mIndices.data(), serial.mIndices.size() * sizeof(uint32_t)) == 0);
+	}
+}
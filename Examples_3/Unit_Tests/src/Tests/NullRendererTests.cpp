@@ -0,0 +1,335 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Headless tests for the null renderer: uploads through the ResourceLoader, root signatures built from SPIR-V
+// and the recorded command stream.
+
+#include "../../../../Common_3/Renderer/IRenderer.h"
+#include "../../../../Common_3/Renderer/Null/NullRenderer.h"
+#include "../../../../Common_3/Renderer/ResourceLoader.h"
+#include "../../../../Common_3/Renderer/GpuProfiler.h"
+#include "../../../../Common_3/OS/Image/Image.h"
+#include "../../../../Common_3/OS/UI/UIShaders.h"
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+COMMAND_CAPTURE_LAYER_BEGIN
+extern void addBuffer(Renderer* pRenderer, const BufferDesc* desc, Buffer** pp_buffer);
+extern void removeBuffer(Renderer* pRenderer, Buffer* p_buffer);
+extern void mapBuffer(Renderer* pRenderer, Buffer* pBuffer, ReadRange* pRange);
+extern void unmapBuffer(Renderer* pRenderer, Buffer* pBuffer);
+COMMAND_CAPTURE_LAYER_END
+
+struct NullContext
+{
+	Renderer*	pRenderer;
+	Queue*		pQueue;
+	CmdPool*	pCmdPool;
+	Cmd*		pCmd;
+};
+
+static void initNullContext(NullContext* pContext)
+{
+	RendererDesc settings = {};
+	initRenderer("NullRendererTests", &settings, &pContext->pRenderer);
+	QueueDesc queueDesc = {};
+	queueDesc.mType = CMD_POOL_DIRECT;
+	addQueue(pContext->pRenderer, &queueDesc, &pContext->pQueue);
+	addCmdPool(pContext->pRenderer, pContext->pQueue, false, &pContext->pCmdPool);
+	addCmd(pContext->pCmdPool, false, &pContext->pCmd);
+	initResourceLoaderInterface(pContext->pRenderer, 16 * 1024 * 1024, false);
+}
+
+static void exitNullContext(NullContext* pContext)
+{
+	removeResourceLoaderInterface(pContext->pRenderer);
+	removeCmd(pContext->pCmdPool, pContext->pCmd);
+	removeCmdPool(pContext->pRenderer, pContext->pCmdPool);
+	removeQueue(pContext->pQueue);
+	removeRenderer(pContext->pRenderer);
+}
+
+static String spirvString(const uint32_t* pCode, size_t size)
+{
+	String code;
+	code.resize((uint32_t)size);
+	memcpy(code.begin(), pCode, size);
+	return code;
+}
+
+UNIT_TEST(NullResourceLoaderUploads)
+{
+	NullContext context;
+	initNullContext(&context);
+
+	uint32_t data[64];
+	for (uint32_t i = 0; i < 64; ++i)
+		data[i] = i * 3 + 1;
+	Buffer* pBuffer = NULL;
+	BufferLoadDesc bufferDesc = {};
+	bufferDesc.ppBuffer = &pBuffer;
+	bufferDesc.pData = data;
+	bufferDesc.mDesc.mUsage = BUFFER_USAGE_STORAGE_SRV;
+	bufferDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+	bufferDesc.mDesc.mSize = sizeof(data);
+	bufferDesc.mDesc.mElementCount = 64;
+	bufferDesc.mDesc.mStructStride = sizeof(uint32_t);
+	addResource(&bufferDesc);
+	finishResourceLoading();
+
+	Image image;
+	uint8_t* pPixels = image.Create(ImageFormat::RGBA8, 16, 8, 1, 3, 2);
+	uint32_t imageSize = image.GetMipMappedSize(0, 3) * 2;
+	for (uint32_t i = 0; i < imageSize; ++i)
+		pPixels[i] = (uint8_t)(i * 7);
+	Texture* pTexture = NULL;
+	TextureLoadDesc textureDesc = {};
+	textureDesc.ppTexture = &pTexture;
+	textureDesc.pImage = &image;
+	addResource(&textureDesc);
+	finishResourceLoading();
+
+	bool buffersMatch = memcmp(pBuffer->pNullMemory, data, sizeof(data)) == 0;
+	bool texturesMatch = true;
+	for (uint32_t mip = 0; mip < 3; ++mip)
+	{
+		for (uint32_t layer = 0; layer < 2; ++layer)
+		{
+			uint64_t offset = getNullSubresourceOffset(pTexture, mip, layer);
+			uint64_t size = getNullSubresourceSize(pTexture, mip);
+			texturesMatch = texturesMatch && memcmp(pTexture->pNullMemory + offset, image.GetPixels(mip, layer), (size_t)size) == 0;
+		}
+	}
+
+	removeResource(pTexture);
+	removeResource(pBuffer);
+	exitNullContext(&context);
+
+	UNIT_CHECK(buffersMatch);
+	UNIT_CHECK(texturesMatch);
+}
+
+UNIT_TEST(NullCommandStreamRecordsBindings)
+{
+	NullContext context;
+	initNullContext(&context);
+	Renderer* pRenderer = context.pRenderer;
+
+	ShaderDesc shaderDesc = {};
+	shaderDesc.mStages = SHADER_STAGE_VERT | SHADER_STAGE_FRAG;
+	shaderDesc.mVert.mCode = spirvString(builtin_textured_vert, sizeof(builtin_textured_vert));
+	shaderDesc.mVert.mEntryPoint = "main";
+	shaderDesc.mFrag.mCode = spirvString(builtin_textured_frag, sizeof(builtin_textured_frag));
+	shaderDesc.mFrag.mEntryPoint = "main";
+	Shader* pShader = NULL;
+	addShader(pRenderer, &shaderDesc, &pShader);
+	Sampler* pSampler = NULL;
+	addSampler(pRenderer, &pSampler);
+	RootSignature* pRootSignature = NULL;
+	addRootSignature(pRenderer, 1, &pShader, &pRootSignature);
+	uint32_t uniformIndex = getDescriptorIndexFromName(pRootSignature, "uniformBlockVS");
+
+	Buffer* pUniformBuffer = NULL;
+	BufferDesc uniformDesc = {};
+	uniformDesc.mUsage = BUFFER_USAGE_UNIFORM;
+	uniformDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+	uniformDesc.mSize = 64;
+	addBuffer(pRenderer, &uniformDesc, &pUniformBuffer);
+	mapBuffer(pRenderer, pUniformBuffer, NULL);
+	bool mappedToMemory = pUniformBuffer->pCpuMappedAddress == pUniformBuffer->pNullMemory;
+	unmapBuffer(pRenderer, pUniformBuffer);
+
+	Texture* pTexture = NULL;
+	TextureDesc textureDesc = {};
+	textureDesc.mType = TEXTURE_TYPE_2D;
+	textureDesc.mWidth = 4;
+	textureDesc.mHeight = 4;
+	textureDesc.mDepth = 1;
+	textureDesc.mArraySize = 1;
+	textureDesc.mMipLevels = 1;
+	textureDesc.mSampleCount = SAMPLE_COUNT_1;
+	textureDesc.mFormat = ImageFormat::RGBA8;
+	textureDesc.mUsage = TEXTURE_USAGE_SAMPLED_IMAGE;
+	TextureLoadDesc textureLoadDesc = {};
+	textureLoadDesc.pDesc = &textureDesc;
+	textureLoadDesc.ppTexture = &pTexture;
+	addResource(&textureLoadDesc);
+	finishResourceLoading();
+
+	GpuProfiler* pGpuProfiler = NULL;
+	addGpuProfiler(pRenderer, context.pQueue, &pGpuProfiler, 16);
+
+	Cmd* pCmd = context.pCmd;
+	beginCmd(pCmd);
+	cmdBeginGpuFrameProfile(pCmd, pGpuProfiler);
+	cmdBeginDebugMarkerf(pCmd, 1, 0, 0, "pass %d", 3);
+	DescriptorData params[4];
+	params[0].pName = "uTex0";
+	params[0].ppTextures = &pTexture;
+	params[1].mIndex = uniformIndex;
+	params[1].ppBuffers = &pUniformBuffer;
+	params[2].pName = "doesNotExist";
+	params[2].ppBuffers = &pUniformBuffer;
+	params[3].pName = "uSampler0";
+	params[3].ppSamplers = &pSampler;
+	cmdBindDescriptors(pCmd, pRootSignature, 4, params);
+	cmdDraw(pCmd, 6, 0);
+	cmdEndDebugMarker(pCmd);
+	cmdEndGpuFrameProfile(pCmd, pGpuProfiler);
+	endCmd(pCmd);
+	queueSubmit(context.pQueue, 1, &pCmd, NULL, 0, NULL, 0, NULL);
+
+	// The unknown descriptor is the only rejected parameter, the three valid ones are recorded in order
+	const NullCommandStream* pStream = pCmd->pNullStream;
+	uint32_t errorCount = pStream->mErrorCount;
+	uint32_t bindCount = 0;
+	uint32_t drawCount = 0;
+	bool markerNameMatches = false;
+	for (uint32_t i = 0; i < pStream->mCommands.size(); ++i)
+	{
+		const NullCommand& command = pStream->mCommands[i];
+		if (command.mType == NULL_CMD_BIND_DESCRIPTOR)
+			++bindCount;
+		else if (command.mType == NULL_CMD_DRAW && command.mArgs[0] == 6)
+			++drawCount;
+		else if (command.mType == NULL_CMD_BEGIN_DEBUG_MARKER && command.mDataSize)
+			markerNameMatches = markerNameMatches || strcmp((const char*)&pStream->mData[command.mDataOffset], "pass 3") == 0;
+	}
+	uint64_t submitCount = context.pQueue->mNullSubmitCount;
+
+	removeGpuProfiler(pRenderer, pGpuProfiler);
+	removeResource(pTexture);
+	removeBuffer(pRenderer, pUniformBuffer);
+	removeRootSignature(pRenderer, pRootSignature);
+	removeSampler(pRenderer, pSampler);
+	removeShader(pRenderer, pShader);
+	exitNullContext(&context);
+
+	UNIT_CHECK(mappedToMemory);
+	UNIT_CHECK(uniformIndex != (uint32_t)-1);
+	UNIT_CHECK(errorCount == 1);
+	UNIT_CHECK(bindCount == 3);
+	UNIT_CHECK(drawCount == 1);
+	UNIT_CHECK(markerNameMatches);
+	UNIT_CHECK(submitCount == 1);
+}
+
+// Resolving descriptor names to slots once per root signature against hashing the name on every bind.
+// The null renderer records each bind, so both loops include the same recording cost and differ only by the lookup
+UNIT_BENCHMARK(NullDescriptorBindingNameVsSlot)
+{
+	const uint32_t drawCount = 5000;
+	const uint32_t frameCount = 50;
+
+	NullContext context;
+	initNullContext(&context);
+	Renderer* pRenderer = context.pRenderer;
+
+	ShaderDesc shaderDesc = {};
+	shaderDesc.mStages = SHADER_STAGE_VERT | SHADER_STAGE_FRAG;
+	shaderDesc.mVert.mCode = spirvString(builtin_textured_vert, sizeof(builtin_textured_vert));
+	shaderDesc.mVert.mEntryPoint = "main";
+	shaderDesc.mFrag.mCode = spirvString(builtin_textured_frag, sizeof(builtin_textured_frag));
+	shaderDesc.mFrag.mEntryPoint = "main";
+	Shader* pShader = NULL;
+	addShader(pRenderer, &shaderDesc, &pShader);
+	Sampler* pSampler = NULL;
+	addSampler(pRenderer, &pSampler);
+	RootSignature* pRootSignature = NULL;
+	addRootSignature(pRenderer, 1, &pShader, &pRootSignature);
+
+	Buffer* pUniformBuffer = NULL;
+	BufferDesc uniformDesc = {};
+	uniformDesc.mUsage = BUFFER_USAGE_UNIFORM;
+	uniformDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+	uniformDesc.mSize = 64;
+	addBuffer(pRenderer, &uniformDesc, &pUniformBuffer);
+
+	Texture* pTexture = NULL;
+	TextureDesc textureDesc = {};
+	textureDesc.mType = TEXTURE_TYPE_2D;
+	textureDesc.mWidth = 4;
+	textureDesc.mHeight = 4;
+	textureDesc.mDepth = 1;
+	textureDesc.mArraySize = 1;
+	textureDesc.mMipLevels = 1;
+	textureDesc.mSampleCount = SAMPLE_COUNT_1;
+	textureDesc.mFormat = ImageFormat::RGBA8;
+	textureDesc.mUsage = TEXTURE_USAGE_SAMPLED_IMAGE;
+	TextureLoadDesc textureLoadDesc = {};
+	textureLoadDesc.pDesc = &textureDesc;
+	textureLoadDesc.ppTexture = &pTexture;
+	addResource(&textureLoadDesc);
+	finishResourceLoading();
+
+	DescriptorData nameParams[3];
+	nameParams[0].pName = "uTex0";
+	nameParams[0].ppTextures = &pTexture;
+	nameParams[1].pName = "uniformBlockVS";
+	nameParams[1].ppBuffers = &pUniformBuffer;
+	nameParams[2].pName = "uSampler0";
+	nameParams[2].ppSamplers = &pSampler;
+
+	DescriptorData slotParams[3];
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		slotParams[i] = nameParams[i];
+		slotParams[i].mIndex = getDescriptorIndexFromName(pRootSignature, nameParams[i].pName);
+		slotParams[i].pName = NULL;
+	}
+
+	Cmd* pCmd = context.pCmd;
+	int64_t usec[2] = {};
+	for (uint32_t mode = 0; mode < 2; ++mode)
+	{
+		DescriptorData* pParams = mode ? slotParams : nameParams;
+		for (uint32_t frame = 0; frame < frameCount; ++frame)
+		{
+			beginCmd(pCmd);
+			int64_t start = getUSec();
+			for (uint32_t draw = 0; draw < drawCount; ++draw)
+			{
+				nameParams[1].mOffset = slotParams[1].mOffset = (draw & 3) * 16;
+				cmdBindDescriptors(pCmd, pRootSignature, 3, pParams);
+				cmdDraw(pCmd, 3, 0);
+			}
+			usec[mode] += getUSec() - start;
+			endCmd(pCmd);
+		}
+	}
+	uint32_t errorCount = pCmd->pNullStream->mErrorCount;
+
+	removeResource(pTexture);
+	removeBuffer(pRenderer, pUniformBuffer);
+	removeRootSignature(pRenderer, pRootSignature);
+	removeSampler(pRenderer, pSampler);
+	removeShader(pRenderer, pShader);
+	exitNullContext(&context);
+
+	UNIT_BENCHMARK_REPORT("bind 3 descriptors by name, per draw", usec[0], frameCount, drawCount);
+	UNIT_BENCHMARK_REPORT("bind 3 descriptors by slot, per draw", usec[1], frameCount, drawCount);
+	UNIT_CHECK(errorCount == 0);
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Tests for the platform layer: files, threads and timers.
+
+#include "../../../../Common_3/OS/Interfaces/IFileSystem.h"
+#include "../../../../Common_3/OS/Interfaces/IThread.h"
+#include "../../../../Common_3/OS/Interfaces/IOperatingSystem.h"
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+UNIT_TEST(FileWriteReadSeek)
+{
+	const char* pFileName = "OSTests.bin";
+	uint8_t data[4096];
+	for (uint32_t i = 0; i < sizeof(data); ++i)
+		data[i] = (uint8_t)(i * 13 + 7);
+
+	File file;
+	UNIT_CHECK(file.Open(pFileName, FM_WriteBinary, FSR_OtherFiles));
+	UNIT_CHECK(file.Write(data, sizeof(data)) == sizeof(data));
+	UNIT_CHECK(file.WriteUInt(0xDEADBEEF));
+	file.Close();
+
+	UNIT_CHECK(FileSystem::FileExists(pFileName, FSR_OtherFiles));
+	UNIT_CHECK(FileSystem::GetLastModifiedTime(FileSystem::FixPath(pFileName, FSR_OtherFiles)) != 0);
+
+	UNIT_CHECK(file.Open(pFileName, FM_ReadBinary, FSR_OtherFiles));
+	UNIT_CHECK(file.GetSize() == sizeof(data) + sizeof(uint32_t));
+	UNIT_CHECK(file.Seek(1000) == 1000);
+	uint8_t readBack[16];
+	UNIT_CHECK(file.Read(readBack, sizeof(readBack)) == sizeof(readBack));
+	UNIT_CHECK(memcmp(readBack, data + 1000, sizeof(readBack)) == 0);
+	UNIT_CHECK(file.Seek(sizeof(data)) == sizeof(data));
+	UNIT_CHECK(file.ReadUInt() == 0xDEADBEEF);
+	UNIT_CHECK(file.IsEof());
+	file.Close();
+
+	UNIT_CHECK(FileSystem::Delete(FileSystem::FixPath(pFileName, FSR_OtherFiles)));
+	UNIT_CHECK(!FileSystem::FileExists(pFileName, FSR_OtherFiles));
+}
+
+static bool writeTestFile(const char* pFileName, uint32_t value)
+{
+	File file;
+	if (!file.Open(pFileName, FM_WriteBinary, FSR_OtherFiles))
+		return false;
+	file.WriteUInt(value);
+	file.Close();
+	return true;
+}
+
+static uint32_t readTestFile(const String& fileName, FSRoot root)
+{
+	File file;
+	if (!file.Open(fileName, FM_ReadBinary, root))
+		return 0;
+	return file.ReadUInt();
+}
+
+UNIT_TEST(FileRenameReplacesTarget)
+{
+	UNIT_CHECK(writeTestFile("OSTestsRenameSource.bin", 1));
+	UNIT_CHECK(writeTestFile("OSTestsRenameTarget.bin", 2));
+
+	const String target = FileSystem::FixPath("OSTestsRenameTarget.bin", FSR_OtherFiles);
+	UNIT_CHECK(FileSystem::Rename(FileSystem::FixPath("OSTestsRenameSource.bin", FSR_OtherFiles), target));
+	UNIT_CHECK(!FileSystem::FileExists("OSTestsRenameSource.bin", FSR_OtherFiles));
+	UNIT_CHECK(readTestFile(target, FSR_Absolute) == 1);
+	UNIT_CHECK(FileSystem::Delete(target));
+}
+
+UNIT_TEST(CookedPathsAreOptIn)
+{
+	UNIT_CHECK(writeTestFile("OSTestsSource.bin", 1));
+	UNIT_CHECK(writeTestFile("OSTestsCooked.bin", 2));
+
+	File manifest;
+	UNIT_CHECK(manifest.Open("OSTestsManifest.bin", FM_WriteBinary, FSR_OtherFiles));
+	manifest.WriteUInt(COOK_MANIFEST_MAGIC);
+	manifest.WriteUInt(COOK_MANIFEST_VERSION);
+	manifest.WriteUInt(1);
+	manifest.WriteString(FileSystem::GetCookManifestKey("OSTestsSource.bin", FSR_OtherFiles));
+	manifest.WriteString("OSTestsCooked.bin");
+	manifest.WriteInt64(0);
+	manifest.WriteInt64(0);
+	manifest.WriteInt64(0);
+	manifest.Close();
+	UNIT_CHECK(FileSystem::LoadCookManifest("OSTestsManifest.bin", FSR_OtherFiles));
+
+	// File::Open keeps reading the source, only an explicit lookup returns the cooked output
+	String cookedPath = FileSystem::GetCookedPath("OSTestsSource.bin", FSR_OtherFiles);
+	FileSystem::ClearCookManifest();
+	UNIT_CHECK(readTestFile("OSTestsSource.bin", FSR_OtherFiles) == 1);
+	UNIT_CHECK(cookedPath.size() != 0);
+	UNIT_CHECK(readTestFile(cookedPath, FSR_Absolute) == 2);
+	UNIT_CHECK(FileSystem::GetCookedPath("OSTestsSource.bin", FSR_OtherFiles).size() == 0);
+
+	FileSystem::Delete(FileSystem::FixPath("OSTestsSource.bin", FSR_OtherFiles));
+	FileSystem::Delete(FileSystem::FixPath("OSTestsCooked.bin", FSR_OtherFiles));
+	FileSystem::Delete(FileSystem::FixPath("OSTestsManifest.bin", FSR_OtherFiles));
+}
+
+struct ThreadCounter
+{
+	Mutex		mMutex;
+	uint32_t	mCount;
+};
+
+static void incrementCounter(void* pData)
+{
+	ThreadCounter* pCounter = (ThreadCounter*)pData;
+	MutexLock lock(pCounter->mMutex);
+	++pCounter->mCount;
+}
+
+UNIT_TEST(ThreadPoolCompletesAllItems)
+{
+	UNIT_CHECK(Thread::GetNumCPUCores() > 0);
+
+	ThreadCounter counter;
+	counter.mCount = 0;
+	WorkItem items[64];
+	{
+		ThreadPool pool;
+		pool.CreateThreads(4);
+		for (uint32_t i = 0; i < 64; ++i)
+		{
+			items[i].pFunc = incrementCounter;
+			items[i].pData = &counter;
+			pool.AddWorkItem(&items[i]);
+		}
+		pool.Complete(0);
+	}
+	UNIT_CHECK(counter.mCount == 64);
+}
+
+UNIT_TEST(TimerIsMonotonic)
+{
+	int64_t start = getUSec();
+	Thread::Sleep(5);
+	int64_t end = getUSec();
+	UNIT_CHECK(end - start >= 4000);
+	UNIT_CHECK(getTimerFrequency() > 0);
+}
@@ -0,0 +1,468 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Accuracy tests and benchmarks for the Visibility_Buffer software occlusion culling. The masked buffer is checked
+// against a double precision reference rasterizer sampling every buffer pixel 4x4 times.
+
+#include "../../../../Examples_3/Visibility_Buffer/src/OcclusionCulling.h"
+#include "../../../../Common_3/OS/Interfaces/IOperatingSystem.h"
+#include "../../../../Common_3/ThirdParty/OpenSource/TinySTL/vector.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+#define OCCLUSION_TEST_SAMPLES 4
+// Depth slack of the comparisons, above the bias the rasterizer adds and float rounding of the projection
+#define OCCLUSION_TEST_DEPTH_EPSILON 1e-4
+
+struct OcclusionTestScene
+{
+	tinystl::vector<float3>		mPositions;
+	tinystl::vector<uint32_t>	mIndices;
+	tinystl::vector<float3>		mBoxMin;
+	tinystl::vector<float3>		mBoxMax;
+	mat4						mMvp;
+};
+
+// Depth of the nearest occluder at every sample center, DBL_MAX where nothing covers the sample
+struct OcclusionReference
+{
+	uint32_t				mWidth;
+	uint32_t				mHeight;
+	tinystl::vector<double>	mDepth;
+};
+
+static void projectOcclusionTestPoint(const mat4& mvp, const float3& p, double width, double height, double* pClip, double* pScreen)
+{
+	for (int c = 0; c < 4; ++c)
+	{
+		pClip[c] = (double)mvp.getCol(0)[c] * p.x + (double)mvp.getCol(1)[c] * p.y + (double)mvp.getCol(2)[c] * p.z +
+			(double)mvp.getCol(3)[c];
+	}
+	pScreen[0] = (pClip[0] / pClip[3] * 0.5 + 0.5) * width;
+	pScreen[1] = (0.5 - pClip[1] / pClip[3] * 0.5) * height;
+	pScreen[2] = pClip[2] / pClip[3];
+}
+
+// Occluders and boxes in front of the camera. Perspective scenes keep every vertex beyond the near plane and inside
+// the guard band so the rasterizer accepts all triangles the reference draws
+static void buildOcclusionTestScene(uint32_t* pState, bool perspective, uint32_t triangleCount, uint32_t boxCount, OcclusionTestScene* pScene)
+{
+	pScene->mPositions.clear();
+	pScene->mIndices.clear();
+	pScene->mBoxMin.clear();
+	pScene->mBoxMax.clear();
+
+	const float rotation = unitTestRandomFloat(pState, -PI, PI);
+	const mat4 view = mat4::rotationY(rotation);
+	const mat4 invView = mat4::rotationY(-rotation);
+	const mat4 projection = perspective ? mat4::perspective(PI * 0.5f, 0.5f, 1.0f, 100.0f) : mat4::orthographic(-10.0f, 10.0f, -5.0f, 5.0f, 0.0f, 100.0f);
+	pScene->mMvp = projection * view;
+
+	for (uint32_t t = 0; t < triangleCount; ++t)
+	{
+		const float z = perspective ? unitTestRandomFloat(pState, 3.0f, 80.0f) : unitTestRandomFloat(pState, 1.0f, 99.0f);
+		const float extentX = perspective ? z * 1.2f : 12.0f;
+		const float extentY = perspective ? z * 0.6f : 6.0f;
+		const float radius = perspective ? z * unitTestRandomFloat(pState, 0.02f, 0.4f) : unitTestRandomFloat(pState, 0.2f, 6.0f);
+		const vec3 center(unitTestRandomFloat(pState, -extentX, extentX), unitTestRandomFloat(pState, -extentY, extentY), z);
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			vec3 p = center + vec3(unitTestRandomFloat(pState, -radius, radius), unitTestRandomFloat(pState, -radius, radius), unitTestRandomFloat(pState, -0.1f, 0.1f) * radius);
+			p.setZ(fmaxf(p.getZ(), 1.5f));
+			const vec4 world = invView * vec4(p, 1.0f);
+			pScene->mPositions.push_back(float3(world.getX(), world.getY(), world.getZ()));
+			pScene->mIndices.push_back((uint32_t)pScene->mPositions.size() - 1);
+		}
+	}
+
+	for (uint32_t b = 0; b < boxCount; ++b)
+	{
+		const float z = perspective ? unitTestRandomFloat(pState, 2.0f, 110.0f) : unitTestRandomFloat(pState, 0.0f, 110.0f);
+		const float extentX = perspective ? z * 1.3f : 13.0f;
+		const float extentY = perspective ? z * 0.7f : 7.0f;
+		const float size = perspective ? z * unitTestRandomFloat(pState, 0.002f, 0.1f) : unitTestRandomFloat(pState, 0.02f, 2.0f);
+		const vec3 center(unitTestRandomFloat(pState, -extentX, extentX), unitTestRandomFloat(pState, -extentY, extentY), z);
+		// Boxes are axis aligned in world space, so the view space box is rotated back and bounded again
+		float3 boxMin(FLT_MAX, FLT_MAX, FLT_MAX);
+		float3 boxMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (uint32_t c = 0; c < 8; ++c)
+		{
+			const vec3 corner = center + vec3((c & 1) ? size : -size, (c & 2) ? size : -size, (c & 4) ? size : -size);
+			const vec4 world = invView * vec4(corner, 1.0f);
+			boxMin = float3(fminf(boxMin.x, world.getX()), fminf(boxMin.y, world.getY()), fminf(boxMin.z, world.getZ()));
+			boxMax = float3(fmaxf(boxMax.x, world.getX()), fmaxf(boxMax.y, world.getY()), fmaxf(boxMax.z, world.getZ()));
+		}
+		pScene->mBoxMin.push_back(boxMin);
+		pScene->mBoxMax.push_back(boxMax);
+	}
+}
+
+static void renderOcclusionReference(const OcclusionTestScene* pScene, uint32_t width, uint32_t height, OcclusionReference* pReference)
+{
+	const uint32_t sampleWidth = width * OCCLUSION_TEST_SAMPLES;
+	const uint32_t sampleHeight = height * OCCLUSION_TEST_SAMPLES;
+	pReference->mWidth = sampleWidth;
+	pReference->mHeight = sampleHeight;
+	pReference->mDepth.clear();
+	pReference->mDepth.resize(sampleWidth * sampleHeight, DBL_MAX);
+
+	for (uint32_t t = 0; t < (uint32_t)pScene->mIndices.size() / 3; ++t)
+	{
+		double screen[3][3];
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			double clip[4];
+			projectOcclusionTestPoint(pScene->mMvp, pScene->mPositions[pScene->mIndices[t * 3 + k]], width, height, clip, screen[k]);
+		}
+		const double area2 = (screen[1][0] - screen[0][0]) * (screen[2][1] - screen[0][1]) - (screen[2][0] - screen[0][0]) * (screen[1][1] - screen[0][1]);
+		if (area2 == 0.0)
+			continue;
+
+		double minX = DBL_MAX, maxX = -DBL_MAX, minY = DBL_MAX, maxY = -DBL_MAX;
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			minX = fmin(minX, screen[k][0]);
+			maxX = fmax(maxX, screen[k][0]);
+			minY = fmin(minY, screen[k][1]);
+			maxY = fmax(maxY, screen[k][1]);
+		}
+		const int sx0 = (int)fmax(floor(minX * OCCLUSION_TEST_SAMPLES), 0.0);
+		const int sx1 = (int)fmin(ceil(maxX * OCCLUSION_TEST_SAMPLES), (double)sampleWidth);
+		const int sy0 = (int)fmax(floor(minY * OCCLUSION_TEST_SAMPLES), 0.0);
+		const int sy1 = (int)fmin(ceil(maxY * OCCLUSION_TEST_SAMPLES), (double)sampleHeight);
+		for (int sy = sy0; sy < sy1; ++sy)
+		{
+			const double py = (sy + 0.5) / OCCLUSION_TEST_SAMPLES;
+			for (int sx = sx0; sx < sx1; ++sx)
+			{
+				const double px = (sx + 0.5) / OCCLUSION_TEST_SAMPLES;
+				// Barycentric weights, all of the same sign as the area inside the triangle
+				double weights[3];
+				bool inside = true;
+				for (uint32_t k = 0; k < 3 && inside; ++k)
+				{
+					const double* a = screen[(k + 1) % 3];
+					const double* b = screen[(k + 2) % 3];
+					weights[k] = ((b[0] - a[0]) * (py - a[1]) - (px - a[0]) * (b[1] - a[1])) / area2;
+					inside = weights[k] >= 0.0;
+				}
+				if (!inside)
+					continue;
+				// z/w is affine in screen space
+				const double depth = weights[0] * screen[0][2] + weights[1] * screen[1][2] + weights[2] * screen[2][2];
+				double* pDepth = &pReference->mDepth[sy * sampleWidth + sx];
+				*pDepth = fmin(*pDepth, depth);
+			}
+		}
+	}
+}
+
+// Per pixel depth the masked buffer vouches for: pixels in the working layer use its depth, all others the reference layer
+static float getOcclusionPixelDepth(const OcclusionBuffer* pBuffer, uint32_t x, uint32_t y)
+{
+	const OcclusionTile* pTile = pBuffer->pTiles + (y / OCCLUSION_TILE_HEIGHT) * pBuffer->mTilesX + x / OCCLUSION_TILE_WIDTH;
+	const bool working = (pTile->mMask[y % OCCLUSION_TILE_HEIGHT] >> (x % OCCLUSION_TILE_WIDTH)) & 1;
+	return working ? pTile->mZMax1 : pTile->mZMax0;
+}
+
+// Number of samples covered by no occluder or by occluders farther than the depth the buffer claims for their pixel
+static uint32_t countOcclusionDepthViolations(const OcclusionBuffer* pBuffer, const OcclusionReference* pReference)
+{
+	uint32_t violations = 0;
+	for (uint32_t y = 0; y < pBuffer->mHeight; ++y)
+	{
+		for (uint32_t x = 0; x < pBuffer->mWidth; ++x)
+		{
+			const float depth = getOcclusionPixelDepth(pBuffer, x, y);
+			if (depth == FLT_MAX)
+				continue;
+			for (uint32_t s = 0; s < OCCLUSION_TEST_SAMPLES * OCCLUSION_TEST_SAMPLES; ++s)
+			{
+				const uint32_t sx = x * OCCLUSION_TEST_SAMPLES + s % OCCLUSION_TEST_SAMPLES;
+				const uint32_t sy = y * OCCLUSION_TEST_SAMPLES + s / OCCLUSION_TEST_SAMPLES;
+				if (!(pReference->mDepth[sy * pReference->mWidth + sx] <= depth + OCCLUSION_TEST_DEPTH_EPSILON))
+					++violations;
+			}
+		}
+	}
+	return violations;
+}
+
+enum OcclusionReferenceResult
+{
+	OCCLUSION_REFERENCE_VISIBLE,
+	OCCLUSION_REFERENCE_HIDDEN,
+	// Crosses the near plane, the culling code keeps these without testing
+	OCCLUSION_REFERENCE_UNDECIDED,
+};
+
+// A box is hidden if it is outside the frustum, or if the occluders at every sample inside its screen rectangle are
+// nearer than its nearest corner. Tiny rectangles containing no sample center use the sample nearest to their center.
+// Depths within the epsilon count as visible when visible is true and as hidden otherwise
+static OcclusionReferenceResult testOcclusionReferenceBox(const OcclusionReference* pReference, const mat4& mvp, const float3& boxMin, const float3& boxMax, bool visible)
+{
+	const double width = (double)pReference->mWidth / OCCLUSION_TEST_SAMPLES;
+	const double height = (double)pReference->mHeight / OCCLUSION_TEST_SAMPLES;
+	double minX = DBL_MAX, maxX = -DBL_MAX, minY = DBL_MAX, maxY = -DBL_MAX, zNear = DBL_MAX;
+	uint32_t outside[5] = {};
+	bool crossesNear = false;
+	for (uint32_t c = 0; c < 8; ++c)
+	{
+		const float3 corner((c & 1) ? boxMax.x : boxMin.x, (c & 2) ? boxMax.y : boxMin.y, (c & 4) ? boxMax.z : boxMin.z);
+		double clip[4], screen[3];
+		projectOcclusionTestPoint(mvp, corner, width, height, clip, screen);
+		outside[0] += clip[0] > clip[3];
+		outside[1] += clip[0] < -clip[3];
+		outside[2] += clip[1] > clip[3];
+		outside[3] += clip[1] < -clip[3];
+		outside[4] += clip[2] > clip[3];
+		crossesNear = crossesNear || clip[3] <= 1e-3 || clip[2] < 0.0;
+		minX = fmin(minX, screen[0]);
+		maxX = fmax(maxX, screen[0]);
+		minY = fmin(minY, screen[1]);
+		maxY = fmax(maxY, screen[1]);
+		zNear = fmin(zNear, screen[2]);
+	}
+	for (uint32_t i = 0; i < 5; ++i)
+	{
+		if (outside[i] == 8)
+			return OCCLUSION_REFERENCE_HIDDEN;
+	}
+	if (crossesNear)
+		return OCCLUSION_REFERENCE_UNDECIDED;
+
+	const double slack = visible ? OCCLUSION_TEST_DEPTH_EPSILON : -OCCLUSION_TEST_DEPTH_EPSILON;
+	int sx0 = (int)ceil(minX * OCCLUSION_TEST_SAMPLES - 0.5);
+	int sx1 = (int)floor(maxX * OCCLUSION_TEST_SAMPLES - 0.5);
+	int sy0 = (int)ceil(minY * OCCLUSION_TEST_SAMPLES - 0.5);
+	int sy1 = (int)floor(maxY * OCCLUSION_TEST_SAMPLES - 0.5);
+	if (sx0 > sx1)
+		sx0 = sx1 = (int)floor((minX + maxX) * 0.5 * OCCLUSION_TEST_SAMPLES);
+	if (sy0 > sy1)
+		sy0 = sy1 = (int)floor((minY + maxY) * 0.5 * OCCLUSION_TEST_SAMPLES);
+	for (int sy = sy0 > 0 ? sy0 : 0; sy <= sy1 && sy < (int)pReference->mHeight; ++sy)
+	{
+		for (int sx = sx0 > 0 ? sx0 : 0; sx <= sx1 && sx < (int)pReference->mWidth; ++sx)
+		{
+			if (pReference->mDepth[sy * pReference->mWidth + sx] > zNear + slack)
+				return OCCLUSION_REFERENCE_VISIBLE;
+		}
+	}
+	return OCCLUSION_REFERENCE_HIDDEN;
+}
+
+static bool isOcclusionBufferEmpty(const OcclusionBuffer* pBuffer)
+{
+	for (uint32_t i = 0; i < pBuffer->mTilesX * pBuffer->mTilesY; ++i)
+	{
+		const OcclusionTile* pTile = &pBuffer->pTiles[i];
+		if (pTile->mZMax0 != FLT_MAX || pTile->mMask[0] || pTile->mMask[1] || pTile->mMask[2] || pTile->mMask[3])
+			return false;
+	}
+	return true;
+}
+
+UNIT_TEST(OcclusionBufferMatchesReference)
+{
+	const uint32_t width = 128;
+	const uint32_t height = 64;
+	OcclusionBuffer* pBuffer = NULL;
+	addOcclusionBuffer(width, height, &pBuffer);
+	OcclusionTestScene* pScene = conf_placement_new<OcclusionTestScene>(conf_calloc(1, sizeof(OcclusionTestScene)));
+	OcclusionReference* pReference = conf_placement_new<OcclusionReference>(conf_calloc(1, sizeof(OcclusionReference)));
+
+	uint32_t state = 0x0CC1;
+	uint32_t depthViolations = 0;
+	uint32_t falseCulls = 0;
+	uint32_t hiddenCount = 0;
+	uint32_t hiddenCulledCount = 0;
+	uint32_t visibleCount = 0;
+	for (uint32_t sceneIndex = 0; sceneIndex < 60; ++sceneIndex)
+	{
+		buildOcclusionTestScene(&state, (sceneIndex & 1) == 0, 40 + sceneIndex * 2, 2000, pScene);
+		clearOcclusionBuffer(pBuffer);
+		renderOccluders(pBuffer, pScene->mMvp, pScene->mPositions.data(), pScene->mIndices.data(), (uint32_t)pScene->mIndices.size() / 3, OCCLUSION_CULL_NONE);
+		renderOcclusionReference(pScene, width, height, pReference);
+		depthViolations += countOcclusionDepthViolations(pBuffer, pReference);
+
+		for (uint32_t b = 0; b < (uint32_t)pScene->mBoxMin.size(); ++b)
+		{
+			const bool visible = isOcclusionBoxVisible(pBuffer, pScene->mMvp, pScene->mBoxMin[b], pScene->mBoxMax[b]);
+			if (!visible && testOcclusionReferenceBox(pReference, pScene->mMvp, pScene->mBoxMin[b], pScene->mBoxMax[b], true) != OCCLUSION_REFERENCE_HIDDEN)
+				++falseCulls;
+			const OcclusionReferenceResult reference = testOcclusionReferenceBox(pReference, pScene->mMvp, pScene->mBoxMin[b], pScene->mBoxMax[b], false);
+			hiddenCount += reference == OCCLUSION_REFERENCE_HIDDEN;
+			hiddenCulledCount += reference == OCCLUSION_REFERENCE_HIDDEN && !visible;
+			visibleCount += reference == OCCLUSION_REFERENCE_VISIBLE;
+		}
+	}
+
+	pReference->~OcclusionReference();
+	conf_free(pReference);
+	pScene->~OcclusionTestScene();
+	conf_free(pScene);
+	removeOcclusionBuffer(pBuffer);
+
+	// Conservative in both directions: no pixel claims a depth the occluders do not reach and no visible box is culled
+	UNIT_CHECK(depthViolations == 0);
+	UNIT_CHECK(falseCulls == 0);
+	// The scenes have to contain both outcomes, and most boxes the reference proves hidden are culled
+	UNIT_CHECK(visibleCount > 1000 && hiddenCount > 1000);
+	UNIT_CHECK(hiddenCulledCount * 10 >= hiddenCount * 8);
+}
+
+UNIT_TEST(OcclusionBinnedRenderingMatchesSingleBin)
+{
+	const uint32_t width = 256;
+	const uint32_t height = 128;
+	OcclusionBuffer* pReferenceBuffer = NULL;
+	OcclusionBuffer* pBinnedBuffer = NULL;
+	addOcclusionBuffer(width, height, &pReferenceBuffer);
+	addOcclusionBuffer(width, height, &pBinnedBuffer);
+	OcclusionTestScene* pScene = conf_placement_new<OcclusionTestScene>(conf_calloc(1, sizeof(OcclusionTestScene)));
+
+	uint32_t state = 0xB1B5;
+	uint32_t mismatchCount = 0;
+	for (uint32_t sceneIndex = 0; sceneIndex < 8; ++sceneIndex)
+	{
+		buildOcclusionTestScene(&state, (sceneIndex & 1) == 0, 500, 0, pScene);
+		const uint32_t triangleCount = (uint32_t)pScene->mIndices.size() / 3;
+		clearOcclusionBuffer(pReferenceBuffer);
+		renderOccluders(pReferenceBuffer, pScene->mMvp, pScene->mPositions.data(), pScene->mIndices.data(), triangleCount, OCCLUSION_CULL_NONE);
+
+		for (uint32_t binCount = 2; binCount <= 7; ++binCount)
+		{
+			// Fill with garbage first so tiles a bin misses show up
+			memset(pBinnedBuffer->pTiles, 0xCD, pBinnedBuffer->mTilesX * pBinnedBuffer->mTilesY * sizeof(OcclusionTile));
+			for (uint32_t bin = 0; bin < binCount; ++bin)
+			{
+				clearOcclusionBuffer(pBinnedBuffer, bin, binCount);
+				renderOccluders(pBinnedBuffer, pScene->mMvp, pScene->mPositions.data(), pScene->mIndices.data(), triangleCount, OCCLUSION_CULL_NONE, bin, binCount);
+			}
+			for (uint32_t i = 0; i < pReferenceBuffer->mTilesX * pReferenceBuffer->mTilesY; ++i)
+			{
+				const OcclusionTile* pA = &pReferenceBuffer->pTiles[i];
+				const OcclusionTile* pB = &pBinnedBuffer->pTiles[i];
+				if (memcmp(pA->mMask, pB->mMask, sizeof(pA->mMask)) || pA->mZMax0 != pB->mZMax0 || pA->mZMax1 != pB->mZMax1)
+					++mismatchCount;
+			}
+		}
+	}
+
+	pScene->~OcclusionTestScene();
+	conf_free(pScene);
+	removeOcclusionBuffer(pBinnedBuffer);
+	removeOcclusionBuffer(pReferenceBuffer);
+
+	UNIT_CHECK(mismatchCount == 0);
+}
+
+UNIT_TEST(OcclusionFaceCulling)
+{
+	OcclusionBuffer* pBuffer = NULL;
+	addOcclusionBuffer(64, 32, &pBuffer);
+	const mat4 mvp = mat4::orthographic(-1.0f, 1.0f, -1.0f, 1.0f, 0.0f, 10.0f);
+	const float3 positions[] = { float3(-0.9f, -0.9f, 5.0f), float3(0.9f, -0.9f, 5.0f), float3(0.0f, 0.9f, 5.0f) };
+	const uint32_t indices[2][3] = { { 0, 1, 2 }, { 0, 2, 1 } };
+
+	bool written[3][2] = {};
+	const OcclusionCullMode modes[] = { OCCLUSION_CULL_NONE, OCCLUSION_CULL_CW, OCCLUSION_CULL_CCW };
+	for (uint32_t m = 0; m < 3; ++m)
+	{
+		for (uint32_t w = 0; w < 2; ++w)
+		{
+			clearOcclusionBuffer(pBuffer);
+			renderOccluders(pBuffer, mvp, positions, indices[w], 1, modes[m]);
+			written[m][w] = !isOcclusionBufferEmpty(pBuffer);
+		}
+	}
+	// Winding is judged as the triangle appears on screen, so counter clockwise with y up stays counter clockwise
+	const bool centerHidden = !isOcclusionBoxVisible(pBuffer, mvp, float3(-0.05f, -0.05f, 6.0f), float3(0.05f, 0.05f, 7.0f));
+	removeOcclusionBuffer(pBuffer);
+
+	UNIT_CHECK(written[0][0] && written[0][1]);
+	UNIT_CHECK(written[1][0] && !written[1][1]);
+	UNIT_CHECK(!written[2][0] && written[2][1]);
+	// The last render used CCW culling on the clockwise winding, which was written and hides the box behind it
+	UNIT_CHECK(centerHidden);
+}
+
+UNIT_BENCHMARK(OcclusionCulling)
+{
+	const uint32_t width = 320;
+	const uint32_t height = 192;
+	const uint32_t triangleCount = 32 * 1024;
+	const uint32_t boxCount = 100 * 1000;
+	OcclusionBuffer* pBuffer = NULL;
+	addOcclusionBuffer(width, height, &pBuffer);
+	OcclusionTestScene* pScene = conf_placement_new<OcclusionTestScene>(conf_calloc(1, sizeof(OcclusionTestScene)));
+	uint32_t state = 0xBE4C;
+	buildOcclusionTestScene(&state, true, triangleCount, boxCount, pScene);
+
+	const uint32_t iterationCount = 8;
+	int64_t start = getUSec();
+	for (uint32_t i = 0; i < iterationCount; ++i)
+	{
+		clearOcclusionBuffer(pBuffer);
+		renderOccluders(pBuffer, pScene->mMvp, pScene->mPositions.data(), pScene->mIndices.data(), triangleCount, OCCLUSION_CULL_NONE);
+	}
+	const int64_t renderUSec = getUSec() - start;
+
+	// Binning repeats the triangle setup in every bin, this is the extra work when bins run one after the other
+	const uint32_t binCount = 8;
+	start = getUSec();
+	for (uint32_t i = 0; i < iterationCount; ++i)
+	{
+		for (uint32_t bin = 0; bin < binCount; ++bin)
+		{
+			clearOcclusionBuffer(pBuffer, bin, binCount);
+			renderOccluders(pBuffer, pScene->mMvp, pScene->mPositions.data(), pScene->mIndices.data(), triangleCount, OCCLUSION_CULL_NONE, bin, binCount);
+		}
+	}
+	const int64_t binnedUSec = getUSec() - start;
+
+	uint32_t visibleCount = 0;
+	start = getUSec();
+	for (uint32_t i = 0; i < iterationCount; ++i)
+	{
+		for (uint32_t b = 0; b < boxCount; ++b)
+			visibleCount += isOcclusionBoxVisible(pBuffer, pScene->mMvp, pScene->mBoxMin[b], pScene->mBoxMax[b]) ? 1 : 0;
+	}
+	const int64_t testUSec = getUSec() - start;
+
+	pScene->~OcclusionTestScene();
+	conf_free(pScene);
+	removeOcclusionBuffer(pBuffer);
+
+	UNIT_BENCHMARK_REPORT("render 32k triangles, 320x192", renderUSec, iterationCount, triangleCount);
+	UNIT_BENCHMARK_REPORT("render 32k triangles, 8 bins in sequence", binnedUSec, iterationCount, triangleCount);
+	UNIT_BENCHMARK_REPORT("test 100k boxes", testUSec, iterationCount, boxCount);
+	printf("    %u of %u boxes visible\n", visibleCount / iterationCount, boxCount);
+}
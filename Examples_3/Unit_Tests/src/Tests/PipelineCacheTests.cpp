@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Tests for the pipeline cache blob format and the content based pipeline desc hashes.
+
+#include "../../../../Common_3/Renderer/PipelineCache.h"
+#include "../../../../Common_3/OS/Interfaces/IFileSystem.h"
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+static PipelineCacheDeviceInfo getTestDevice()
+{
+	PipelineCacheDeviceInfo device = {};
+	device.mVendorId = 0x10DE;
+	device.mDeviceId = 0x1B80;
+	device.mDriverVersion = 0x01020304;
+	for (uint32_t i = 0; i < PIPELINE_CACHE_UUID_SIZE; ++i)
+		device.mCacheUUID[i] = (uint8_t)(i * 17 + 3);
+	return device;
+}
+
+static void fillDriverData(tinystl::vector<uint8_t>* pData, uint32_t size)
+{
+	uint32_t state = 0x1234567;
+	pData->resize(size);
+	for (uint32_t i = 0; i < size; ++i)
+		(*pData)[i] = (uint8_t)unitTestRandom(&state);
+}
+
+UNIT_TEST(PipelineCacheBlobRoundTrip)
+{
+	const PipelineCacheDeviceInfo device = getTestDevice();
+	tinystl::vector<uint8_t> data;
+	fillDriverData(&data, 10000);
+
+	tinystl::vector<uint8_t> blob((size_t)getPipelineCacheBlobSize(data.size()));
+	UNIT_CHECK(blob.size() == sizeof(PipelineCacheHeader) + data.size());
+	writePipelineCacheBlob(&device, data.data(), data.size(), blob.data());
+
+	const void* pData = NULL;
+	uint64_t dataSize = 0;
+	UNIT_CHECK(readPipelineCacheBlob(&device, blob.data(), blob.size(), &pData, &dataSize));
+	UNIT_CHECK(dataSize == data.size());
+	UNIT_CHECK(memcmp(pData, data.data(), data.size()) == 0);
+
+	// Empty driver data is valid too
+	tinystl::vector<uint8_t> emptyBlob((size_t)getPipelineCacheBlobSize(0));
+	writePipelineCacheBlob(&device, NULL, 0, emptyBlob.data());
+	UNIT_CHECK(readPipelineCacheBlob(&device, emptyBlob.data(), emptyBlob.size(), &pData, &dataSize));
+	UNIT_CHECK(dataSize == 0);
+}
+
+UNIT_TEST(PipelineCacheFileRoundTrip)
+{
+	const PipelineCacheDeviceInfo device = getTestDevice();
+	tinystl::vector<uint8_t> data;
+	fillDriverData(&data, 4096);
+
+	UNIT_CHECK(savePipelineCacheFile("PipelineCacheTests.bin", FSR_OtherFiles, &device, data.data(), data.size()));
+	tinystl::vector<uint8_t> loaded;
+	UNIT_CHECK(loadPipelineCacheFile("PipelineCacheTests.bin", FSR_OtherFiles, &device, &loaded));
+	UNIT_CHECK(loaded.size() == data.size());
+	UNIT_CHECK(memcmp(loaded.data(), data.data(), data.size()) == 0);
+
+	// A different device must not get the data even though the file itself is intact
+	PipelineCacheDeviceInfo otherDevice = device;
+	otherDevice.mDriverVersion++;
+	UNIT_CHECK(!loadPipelineCacheFile("PipelineCacheTests.bin", FSR_OtherFiles, &otherDevice, &loaded));
+	UNIT_CHECK(loaded.empty());
+
+	FileSystem::Delete(FileSystem::FixPath("PipelineCacheTests.bin", FSR_OtherFiles));
+	UNIT_CHECK(!loadPipelineCacheFile("PipelineCacheTests.bin", FSR_OtherFiles, &device, &loaded));
+}
+
+UNIT_TEST(PipelineCacheBlobRejectsCorruptedData)
+{
+	const PipelineCacheDeviceInfo device = getTestDevice();
+	tinystl::vector<uint8_t> data;
+	fillDriverData(&data, 1000);
+	tinystl::vector<uint8_t> blob((size_t)getPipelineCacheBlobSize(data.size()));
+	writePipelineCacheBlob(&device, data.data(), data.size(), blob.data());
+
+	const void* pData = NULL;
+	uint64_t dataSize = 0;
+
+	// Every single bit flip in the driver data has to fail the checksum
+	for (uint32_t bit = 0; bit < 8; ++bit)
+	{
+		tinystl::vector<uint8_t> corrupted = blob;
+		corrupted[sizeof(PipelineCacheHeader) + 517] ^= (uint8_t)(1 << bit);
+		UNIT_CHECK(!readPipelineCacheBlob(&device, corrupted.data(), corrupted.size(), &pData, &dataSize));
+	}
+
+	tinystl::vector<uint8_t> corrupted = blob;
+	((PipelineCacheHeader*)corrupted.data())->mDataChecksum ^= 1;
+	UNIT_CHECK(!readPipelineCacheBlob(&device, corrupted.data(), corrupted.size(), &pData, &dataSize));
+
+	corrupted = blob;
+	((PipelineCacheHeader*)corrupted.data())->mMagic ^= 1;
+	UNIT_CHECK(!readPipelineCacheBlob(&device, corrupted.data(), corrupted.size(), &pData, &dataSize));
+
+	corrupted = blob;
+	((PipelineCacheHeader*)corrupted.data())->mVersion = PIPELINE_CACHE_VERSION + 1;
+	UNIT_CHECK(!readPipelineCacheBlob(&device, corrupted.data(), corrupted.size(), &pData, &dataSize));
+
+	// Truncated files and a data size pointing past the end of the blob
+	UNIT_CHECK(!readPipelineCacheBlob(&device, blob.data(), blob.size() - 1, &pData, &dataSize));
+	UNIT_CHECK(!readPipelineCacheBlob(&device, blob.data(), sizeof(PipelineCacheHeader) - 1, &pData, &dataSize));
+	corrupted = blob;
+	((PipelineCacheHeader*)corrupted.data())->mDataSize = ~0ULL;
+	UNIT_CHECK(!readPipelineCacheBlob(&device, corrupted.data(), corrupted.size(), &pData, &dataSize));
+
+	UNIT_CHECK(readPipelineCacheBlob(&device, blob.data(), blob.size(), &pData, &dataSize));
+}
+
+UNIT_TEST(PipelineCacheBlobRejectsOtherDevices)
+{
+	const PipelineCacheDeviceInfo device = getTestDevice();
+	tinystl::vector<uint8_t> data;
+	fillDriverData(&data, 256);
+	tinystl::vector<uint8_t> blob((size_t)getPipelineCacheBlobSize(data.size()));
+	writePipelineCacheBlob(&device, data.data(), data.size(), blob.data());
+
+	const void* pData = NULL;
+	uint64_t dataSize = 0;
+	for (uint32_t i = 0; i < PIPELINE_CACHE_UUID_SIZE; ++i)
+	{
+		PipelineCacheDeviceInfo otherDevice = device;
+		otherDevice.mCacheUUID[i] ^= 0x80;
+		UNIT_CHECK(!readPipelineCacheBlob(&otherDevice, blob.data(), blob.size(), &pData, &dataSize));
+	}
+
+	PipelineCacheDeviceInfo otherDevice = device;
+	otherDevice.mVendorId = 0x1002;
+	UNIT_CHECK(!readPipelineCacheBlob(&otherDevice, blob.data(), blob.size(), &pData, &dataSize));
+	otherDevice = device;
+	otherDevice.mDeviceId++;
+	UNIT_CHECK(!readPipelineCacheBlob(&otherDevice, blob.data(), blob.size(), &pData, &dataSize));
+	otherDevice = device;
+	otherDevice.mDriverVersion++;
+	UNIT_CHECK(!readPipelineCacheBlob(&otherDevice, blob.data(), blob.size(), &pData, &dataSize));
+}
+
+UNIT_TEST(PipelineVertexLayoutHashIgnoresOrder)
+{
+	VertexLayout layout = {};
+	layout.mAttribCount = 3;
+	layout.mAttribs[0].mSemantic = SEMANTIC_POSITION;
+	layout.mAttribs[0].mFormat = ImageFormat::RGB32F;
+	layout.mAttribs[1].mSemantic = SEMANTIC_NORMAL;
+	layout.mAttribs[1].mFormat = ImageFormat::RG16S;
+	layout.mAttribs[1].mLocation = 1;
+	layout.mAttribs[1].mBinding = 1;
+	layout.mAttribs[2].mSemantic = SEMANTIC_TEXCOORD0;
+	layout.mAttribs[2].mFormat = ImageFormat::RG16F;
+	layout.mAttribs[2].mLocation = 2;
+	layout.mAttribs[2].mBinding = 2;
+
+	VertexLayout shuffled = layout;
+	shuffled.mAttribs[0] = layout.mAttribs[2];
+	shuffled.mAttribs[2] = layout.mAttribs[0];
+	UNIT_CHECK(hashVertexLayout(&layout) == hashVertexLayout(&shuffled));
+
+	shuffled.mAttribs[1].mFormat = ImageFormat::RG16F;
+	UNIT_CHECK(hashVertexLayout(&layout) != hashVertexLayout(&shuffled));
+}
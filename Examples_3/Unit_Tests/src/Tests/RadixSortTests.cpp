@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// RadixSort and RadixSortParallel checked against std::sort on (key, input index) pairs, which gives the stable order
+// the radix sort promises. Keys are compared bit for bit so signed zeros and NaN payloads have to survive the sort.
+
+#include "../../../../Common_3/OS/Core/RadixSort.h"
+#include "../../../../Common_3/OS/Interfaces/IThread.h"
+#include "../../../../Common_3/OS/Interfaces/IOperatingSystem.h"
+#include "../../../../Common_3/ThirdParty/OpenSource/TinySTL/vector.h"
+
+#include <algorithm>
+#include <float.h>
+#include <string.h>
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+typedef enum RadixTestDistribution
+{
+	RADIX_TEST_UNIFORM = 0,
+	// A handful of distinct keys, long runs of equal keys test stability
+	RADIX_TEST_FEW_KEYS,
+	// Signed zeros, infinities, denormals and NaNs of both signs mixed into ordinary values
+	RADIX_TEST_SPECIAL,
+	RADIX_TEST_SORTED,
+	RADIX_TEST_REVERSED,
+	// Every key equal, all passes are skipped
+	RADIX_TEST_CONSTANT,
+	// Keys differing only in the low byte, only the first pass runs
+	RADIX_TEST_LOW_BYTE,
+	RADIX_TEST_DISTRIBUTION_COUNT,
+} RadixTestDistribution;
+
+struct RadixTestPair
+{
+	uint32_t	mKey;
+	uint32_t	mIndex;
+
+	bool operator<(const RadixTestPair& other) const
+	{
+		return mKey != other.mKey ? mKey < other.mKey : mIndex < other.mIndex;
+	}
+};
+
+static float radixTestFloat(uint32_t bits)
+{
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static uint32_t radixTestBits(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+// Order preserving unsigned key of the float bits, inverted for descending order
+static uint32_t radixTestKey(float value, RadixSortOrder order)
+{
+	const uint32_t bits = radixTestBits(value);
+	const uint32_t key = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+	return order == RADIX_SORT_DESCENDING ? ~key : key;
+}
+
+static void generateRadixTestKeys(uint32_t* pState, RadixTestDistribution distribution, uint32_t count, float* pKeys)
+{
+	static const uint32_t specialBits[] = {
+		0x00000000u, 0x80000000u,	// +0, -0
+		0x7F800000u, 0xFF800000u,	// +inf, -inf
+		0x7FC00000u, 0xFFC00000u,	// quiet NaNs
+		0x7F800001u, 0xFFBFFFFFu,	// signalling NaN payloads
+		0x00000001u, 0x807FFFFFu,	// denormals
+		0x7F7FFFFFu, 0xFF7FFFFFu,	// +-FLT_MAX
+	};
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		switch (distribution)
+		{
+		case RADIX_TEST_UNIFORM:
+			pKeys[i] = unitTestRandomFloat(pState, -1000.0f, 1000.0f);
+			break;
+		case RADIX_TEST_FEW_KEYS:
+			pKeys[i] = (float)(unitTestRandom(pState) % 5) - 2.0f;
+			break;
+		case RADIX_TEST_SPECIAL:
+			pKeys[i] = (unitTestRandom(pState) % 3) ? radixTestFloat(specialBits[unitTestRandom(pState) % (sizeof(specialBits) / sizeof(specialBits[0]))]) :
+				radixTestFloat(unitTestRandom(pState));
+			break;
+		case RADIX_TEST_SORTED:
+			pKeys[i] = (float)i * 0.5f - 100.0f;
+			break;
+		case RADIX_TEST_REVERSED:
+			pKeys[i] = 100.0f - (float)i * 0.5f;
+			break;
+		case RADIX_TEST_CONSTANT:
+			pKeys[i] = 42.0f;
+			break;
+		default:
+			pKeys[i] = radixTestFloat(0x3F800000u | (unitTestRandom(pState) & 0xFFu));
+			break;
+		}
+	}
+}
+
+// Sorts a copy of the keys with the values set to the input index and compares with the std::sort reference
+static bool checkRadixSort(const float* pInput, uint32_t count, RadixSortOrder order, ThreadPool* pThreadPool, uint32_t taskCount)
+{
+	tinystl::vector<float> keys(count);
+	tinystl::vector<uint32_t> values(count);
+	tinystl::vector<float> tempKeys(count);
+	tinystl::vector<uint32_t> tempValues(count);
+	tinystl::vector<RadixTestPair> reference(count);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		keys[i] = pInput[i];
+		values[i] = i;
+		reference[i].mKey = radixTestKey(pInput[i], order);
+		reference[i].mIndex = i;
+	}
+
+	if (pThreadPool)
+		RadixSortParallel(keys.data(), values.data(), tempKeys.data(), tempValues.data(), count, pThreadPool, taskCount, order);
+	else
+		RadixSort(keys.data(), values.data(), tempKeys.data(), tempValues.data(), count, order);
+	std::sort(reference.begin(), reference.end());
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		if (values[i] != reference[i].mIndex || radixTestBits(keys[i]) != radixTestBits(pInput[reference[i].mIndex]))
+			return false;
+	}
+	return true;
+}
+
+UNIT_TEST(RadixSortMatchesStdSort)
+{
+	// Sizes around the insertion sort threshold and the parallel task size, plus a few odd ones
+	const uint32_t counts[] = { 0, 1, 2, 3, 63, 64, 65, 200, 1000, 4099, 16384, 40000 };
+	uint32_t state = 0x5027;
+	uint32_t failedCount = 0;
+	tinystl::vector<float> input;
+	for (uint32_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+	{
+		input.resize(counts[c] ? counts[c] : 1);
+		for (uint32_t d = 0; d < RADIX_TEST_DISTRIBUTION_COUNT; ++d)
+		{
+			generateRadixTestKeys(&state, (RadixTestDistribution)d, counts[c], input.data());
+			for (uint32_t order = 0; order < 2; ++order)
+			{
+				if (!checkRadixSort(input.data(), counts[c], (RadixSortOrder)order, NULL, 0))
+				{
+					printf("    count %u distribution %u order %u\n", counts[c], d, order);
+					++failedCount;
+				}
+			}
+		}
+	}
+	UNIT_CHECK(failedCount == 0);
+}
+
+UNIT_TEST(RadixSortParallelMatchesStdSort)
+{
+	ThreadPool* pThreadPool = conf_placement_new<ThreadPool>(conf_calloc(1, sizeof(ThreadPool)));
+	pThreadPool->CreateThreads(4);
+
+	const uint32_t counts[] = { 1000, 32768, 100003, 300000 };
+	const uint32_t taskCounts[] = { 1, 2, 3, 4, 7, 16 };
+	uint32_t state = 0x9A11;
+	uint32_t failedCount = 0;
+	tinystl::vector<float> input;
+	for (uint32_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+	{
+		input.resize(counts[c]);
+		for (uint32_t d = 0; d < RADIX_TEST_DISTRIBUTION_COUNT; ++d)
+		{
+			generateRadixTestKeys(&state, (RadixTestDistribution)d, counts[c], input.data());
+			for (uint32_t t = 0; t < sizeof(taskCounts) / sizeof(taskCounts[0]); ++t)
+			{
+				const RadixSortOrder order = (RadixSortOrder)((c + d + t) & 1);
+				if (!checkRadixSort(input.data(), counts[c], order, pThreadPool, taskCounts[t]))
+				{
+					printf("    count %u distribution %u tasks %u order %u\n", counts[c], d, taskCounts[t], order);
+					++failedCount;
+				}
+			}
+		}
+	}
+
+	pThreadPool->~ThreadPool();
+	conf_free(pThreadPool);
+
+	UNIT_CHECK(failedCount == 0);
+}
+
+UNIT_BENCHMARK(RadixSortVsStdSort)
+{
+	ThreadPool* pThreadPool = conf_placement_new<ThreadPool>(conf_calloc(1, sizeof(ThreadPool)));
+	const uint32_t threadCount = Thread::GetNumCPUCores() > 1 ? Thread::GetNumCPUCores() : 1;
+	pThreadPool->CreateThreads(threadCount);
+
+	const uint32_t counts[] = { 10000, 100000, 1000000 };
+	uint32_t state = 0xBE5C;
+	for (uint32_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+	{
+		const uint32_t count = counts[c];
+		const uint32_t iterationCount = 10000000 / count;
+		tinystl::vector<float> input(count);
+		tinystl::vector<float> keys(count);
+		tinystl::vector<uint32_t> values(count);
+		tinystl::vector<float> tempKeys(count);
+		tinystl::vector<uint32_t> tempValues(count);
+		tinystl::vector<RadixTestPair> pairs(count);
+		// View depths of scattered objects, the use case of the sort
+		generateRadixTestKeys(&state, RADIX_TEST_UNIFORM, count, input.data());
+
+		int64_t usec[3] = {};
+		for (uint32_t i = 0; i < iterationCount; ++i)
+		{
+			memcpy(keys.data(), input.data(), count * sizeof(float));
+			for (uint32_t v = 0; v < count; ++v)
+				values[v] = v;
+			int64_t start = getUSec();
+			RadixSort(keys.data(), values.data(), tempKeys.data(), tempValues.data(), count);
+			usec[0] += getUSec() - start;
+
+			memcpy(keys.data(), input.data(), count * sizeof(float));
+			for (uint32_t v = 0; v < count; ++v)
+				values[v] = v;
+			start = getUSec();
+			RadixSortParallel(keys.data(), values.data(), tempKeys.data(), tempValues.data(), count, pThreadPool, threadCount * 2);
+			usec[1] += getUSec() - start;
+
+			for (uint32_t v = 0; v < count; ++v)
+			{
+				pairs[v].mKey = radixTestKey(input[v], RADIX_SORT_ASCENDING);
+				pairs[v].mIndex = v;
+			}
+			start = getUSec();
+			std::sort(pairs.begin(), pairs.end());
+			usec[2] += getUSec() - start;
+		}
+
+		char label[64];
+		sprintf(label, "RadixSort %u keys", count);
+		UNIT_BENCHMARK_REPORT(label, usec[0], iterationCount, count);
+		sprintf(label, "RadixSortParallel %u keys, %u threads", count, threadCount);
+		UNIT_BENCHMARK_REPORT(label, usec[1], iterationCount, count);
+		sprintf(label, "std::sort %u keys", count);
+		UNIT_BENCHMARK_REPORT(label, usec[2], iterationCount, count);
+	}
+
+	pThreadPool->~ThreadPool();
+	conf_free(pThreadPool);
+}
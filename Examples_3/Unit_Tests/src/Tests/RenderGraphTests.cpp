@@ -0,0 +1,576 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Render graph tests. Compilation is checked against brute force references on random graphs, execution runs on
+// the null renderer which tracks the state of every texture and buffer like a real device would.
+
+#include "../../../../Common_3/Renderer/IRenderer.h"
+#include "../../../../Common_3/Renderer/RenderGraph.h"
+#include "../../../../Common_3/Renderer/Null/NullRenderer.h"
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+#define RENDER_GRAPH_TEST_DESC_COUNT 3
+
+static RenderTargetDesc getRenderGraphTestDesc(uint32_t index)
+{
+	RenderTargetDesc desc = {};
+	desc.mType = RENDER_TARGET_TYPE_2D;
+	desc.mWidth = index == 1 ? 960 : 1920;
+	desc.mHeight = index == 1 ? 540 : 1080;
+	desc.mDepth = 1;
+	desc.mArraySize = 1;
+	desc.mSampleCount = SAMPLE_COUNT_1;
+	desc.mFormat = index == 2 ? ImageFormat::D32F : ImageFormat::RGBA8;
+	desc.mUsage = index == 2 ? RENDER_TARGET_USAGE_DEPTH_STENCIL : RENDER_TARGET_USAGE_COLOR;
+	return desc;
+}
+
+static ResourceState getRandomReadState(uint32_t* pState, RenderGraphResourceType type)
+{
+	static const ResourceState textureStates[] = { RESOURCE_STATE_SHADER_RESOURCE, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_DEPTH_READ, RESOURCE_STATE_COPY_SOURCE };
+	static const ResourceState bufferStates[] = { RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, RESOURCE_STATE_INDEX_BUFFER, RESOURCE_STATE_INDIRECT_ARGUMENT, RESOURCE_STATE_SHADER_RESOURCE, RESOURCE_STATE_COPY_SOURCE };
+	if (type == RENDER_GRAPH_RESOURCE_BUFFER)
+		return bufferStates[unitTestRandom(pState) % (sizeof(bufferStates) / sizeof(bufferStates[0]))];
+	return textureStates[unitTestRandom(pState) % (sizeof(textureStates) / sizeof(textureStates[0]))];
+}
+
+static ResourceState getRandomWriteState(uint32_t* pState, RenderGraphResourceType type)
+{
+	static const ResourceState textureStates[] = { RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_COPY_DEST };
+	static const ResourceState bufferStates[] = { RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_COPY_DEST };
+	if (type == RENDER_GRAPH_RESOURCE_BUFFER)
+		return bufferStates[unitTestRandom(pState) % (sizeof(bufferStates) / sizeof(bufferStates[0]))];
+	return textureStates[unitTestRandom(pState) % (sizeof(textureStates) / sizeof(textureStates[0]))];
+}
+
+static ResourceState getAccessState(const RenderGraphPass* pPass, uint32_t resource)
+{
+	ResourceState state = RESOURCE_STATE_UNDEFINED;
+	for (uint32_t a = 0; a < (uint32_t)pPass->mAccesses.size(); ++a)
+	{
+		if (pPass->mAccesses[a].mResource == resource)
+			state |= pPass->mAccesses[a].mState;
+	}
+	return state;
+}
+
+static bool writesResource(const RenderGraphPass* pPass, uint32_t resource)
+{
+	for (uint32_t a = 0; a < (uint32_t)pPass->mAccesses.size(); ++a)
+	{
+		if (pPass->mAccesses[a].mResource == resource && pPass->mAccesses[a].mWrite)
+			return true;
+	}
+	return false;
+}
+
+static bool readsResource(const RenderGraphPass* pPass, uint32_t resource)
+{
+	for (uint32_t a = 0; a < (uint32_t)pPass->mAccesses.size(); ++a)
+	{
+		if (pPass->mAccesses[a].mResource == resource && !pPass->mAccesses[a].mWrite)
+			return true;
+	}
+	return false;
+}
+
+struct RenderGraphTestImports
+{
+	Texture*		pTexture;
+	Buffer*			pBuffer;
+	Texture*		pBackBufferTexture;
+	RenderTarget*	pBackBuffer;
+};
+
+// Declares a random frame: transients of a few shared descs, an imported texture, buffer and back buffer, and passes
+// reading resources that are already written and writing one or two resources each. Returns the desc index of every
+// transient, or RENDER_GRAPH_INVALID_HANDLE for imported resources
+static void buildRandomRenderGraph(uint32_t* pState, RenderGraph* pGraph, const RenderGraphTestImports* pImports, tinystl::vector<uint32_t>& descIndices)
+{
+	static const char* names[] = { "t0", "t1", "t2", "t3", "t4", "t5", "t6", "t7", "t8", "t9", "t10", "t11" };
+	static const char* passNames[] = { "p0", "p1", "p2", "p3", "p4", "p5", "p6", "p7", "p8", "p9", "p10", "p11", "p12", "p13", "p14", "p15" };
+
+	descIndices.clear();
+	importRenderGraphTexture(pGraph, "texture", pImports->pTexture, RESOURCE_STATE_SHADER_RESOURCE, (unitTestRandom(pState) & 1) ? RESOURCE_STATE_SHADER_RESOURCE : RESOURCE_STATE_UNDEFINED);
+	importRenderGraphBuffer(pGraph, "buffer", pImports->pBuffer, RESOURCE_STATE_UNORDERED_ACCESS, (unitTestRandom(pState) & 1) ? RESOURCE_STATE_INDIRECT_ARGUMENT : RESOURCE_STATE_UNDEFINED);
+	importRenderGraphRenderTarget(pGraph, "backBuffer", pImports->pBackBuffer, RESOURCE_STATE_PRESENT, RESOURCE_STATE_PRESENT);
+	for (uint32_t i = 0; i < 3; ++i)
+		descIndices.push_back(RENDER_GRAPH_INVALID_HANDLE);
+
+	const uint32_t transientCount = 2 + unitTestRandom(pState) % 10;
+	for (uint32_t i = 0; i < transientCount; ++i)
+	{
+		const uint32_t descIndex = unitTestRandom(pState) % RENDER_GRAPH_TEST_DESC_COUNT;
+		const RenderTargetDesc desc = getRenderGraphTestDesc(descIndex);
+		addRenderGraphRenderTarget(pGraph, names[i], &desc);
+		descIndices.push_back(descIndex);
+	}
+
+	const uint32_t resourceCount = (uint32_t)pGraph->mResources.size();
+	tinystl::vector<bool> written(resourceCount, false);
+	for (uint32_t r = 0; r < 3; ++r)
+		written[r] = true;
+
+	const uint32_t passCount = 3 + unitTestRandom(pState) % 14;
+	for (uint32_t p = 0; p < passCount; ++p)
+	{
+		const RenderGraphPassFlags flags = (unitTestRandom(pState) % 10) == 0 ? RENDER_GRAPH_PASS_FLAG_SIDE_EFFECTS : RENDER_GRAPH_PASS_FLAG_NONE;
+		const uint32_t pass = addRenderGraphPass(pGraph, passNames[p], NULL, NULL, flags);
+
+		const uint32_t readCount = unitTestRandom(pState) % 4;
+		for (uint32_t i = 0; i < readCount; ++i)
+		{
+			const uint32_t r = unitTestRandom(pState) % resourceCount;
+			if (written[r])
+				renderGraphRead(pGraph, pass, r, getRandomReadState(pState, pGraph->mResources[r].mType));
+		}
+
+		// The back buffer is only written by the last pass so some frames cull everything else
+		const uint32_t writeCount = 1 + unitTestRandom(pState) % 2;
+		for (uint32_t i = 0; i < writeCount; ++i)
+		{
+			const uint32_t r = (p == passCount - 1 && i == 0) ? 2 : unitTestRandom(pState) % resourceCount;
+			if (r == 2 && p != passCount - 1)
+				continue;
+			renderGraphWrite(pGraph, pass, r, getRandomWriteState(pState, pGraph->mResources[r].mType));
+			written[r] = true;
+		}
+	}
+}
+
+// Checks the compiled graph against references computed from the declarations alone
+static bool validateRenderGraph(const RenderGraph* pGraph, const tinystl::vector<uint32_t>& descIndices)
+{
+	const uint32_t passCount = (uint32_t)pGraph->mPasses.size();
+	const uint32_t resourceCount = (uint32_t)pGraph->mResources.size();
+	const uint32_t orderCount = (uint32_t)pGraph->mExecutionOrder.size();
+
+	// A pass is kept if it has side effects, writes an imported resource, or a kept pass reads what it wrote.
+	// Walking the passes backwards visits every reader before the writers it depends on
+	tinystl::vector<bool> kept(passCount, false);
+	for (uint32_t p = passCount; p-- > 0;)
+	{
+		const RenderGraphPass* pPass = &pGraph->mPasses[p];
+		bool keep = (pPass->mFlags & RENDER_GRAPH_PASS_FLAG_SIDE_EFFECTS) != 0;
+		for (uint32_t r = 0; r < resourceCount && !keep; ++r)
+			keep = pGraph->mResources[r].mImported && writesResource(pPass, r);
+		for (uint32_t q = p + 1; q < passCount && !keep; ++q)
+		{
+			if (!kept[q])
+				continue;
+			for (uint32_t r = 0; r < resourceCount && !keep; ++r)
+			{
+				if (!writesResource(pPass, r) || !readsResource(&pGraph->mPasses[q], r))
+					continue;
+				// The read sees this write only if no pass in between writes the resource again
+				bool overwritten = false;
+				for (uint32_t m = p + 1; m < q && !overwritten; ++m)
+					overwritten = writesResource(&pGraph->mPasses[m], r);
+				keep = !overwritten;
+			}
+		}
+		kept[p] = keep;
+		if (pPass->mCulled == keep)
+			return false;
+	}
+
+	// Every kept pass runs exactly once, and passes touching the same resource keep their declaration order unless both only read
+	tinystl::vector<uint32_t> position(passCount, RENDER_GRAPH_INVALID_HANDLE);
+	for (uint32_t i = 0; i < orderCount; ++i)
+	{
+		const uint32_t p = pGraph->mExecutionOrder[i];
+		if (p >= passCount || !kept[p] || position[p] != RENDER_GRAPH_INVALID_HANDLE)
+			return false;
+		position[p] = i;
+	}
+	for (uint32_t p = 0; p < passCount; ++p)
+	{
+		if (kept[p] != (position[p] != RENDER_GRAPH_INVALID_HANDLE))
+			return false;
+		for (uint32_t q = p + 1; q < passCount && kept[p]; ++q)
+		{
+			if (!kept[q])
+				continue;
+			for (uint32_t r = 0; r < resourceCount; ++r)
+			{
+				const bool conflict = (writesResource(&pGraph->mPasses[p], r) && getAccessState(&pGraph->mPasses[q], r)) ||
+					(writesResource(&pGraph->mPasses[q], r) && getAccessState(&pGraph->mPasses[p], r));
+				if (conflict && position[p] > position[q])
+					return false;
+			}
+		}
+	}
+
+	// Transients sharing a physical target have the same desc and lifetimes that do not overlap
+	tinystl::vector<uint32_t> firstUse(resourceCount, RENDER_GRAPH_INVALID_HANDLE);
+	tinystl::vector<uint32_t> lastUse(resourceCount, RENDER_GRAPH_INVALID_HANDLE);
+	for (uint32_t i = 0; i < orderCount; ++i)
+	{
+		for (uint32_t r = 0; r < resourceCount; ++r)
+		{
+			if (!getAccessState(&pGraph->mPasses[pGraph->mExecutionOrder[i]], r))
+				continue;
+			if (firstUse[r] == RENDER_GRAPH_INVALID_HANDLE)
+				firstUse[r] = i;
+			lastUse[r] = i;
+		}
+	}
+	uint64_t transientBytes = 0;
+	uint32_t transientCount = 0;
+	for (uint32_t r = 0; r < resourceCount; ++r)
+	{
+		const RenderGraphResource* pResource = &pGraph->mResources[r];
+		if (pResource->mFirstUse != firstUse[r] || pResource->mLastUse != lastUse[r])
+			return false;
+		const bool needsTarget = !pResource->mImported && firstUse[r] != RENDER_GRAPH_INVALID_HANDLE;
+		if (needsTarget != (pResource->mPhysical != RENDER_GRAPH_INVALID_HANDLE))
+			return false;
+		if (!needsTarget)
+			continue;
+		if (pResource->mPhysical >= (uint32_t)pGraph->mPhysical.size() || !pGraph->mPhysical[pResource->mPhysical].mUsed)
+			return false;
+		++transientCount;
+		transientBytes += pResource->mSize;
+		for (uint32_t s = r + 1; s < resourceCount; ++s)
+		{
+			if (pGraph->mResources[s].mPhysical != pResource->mPhysical)
+				continue;
+			if (descIndices[s] != descIndices[r] || !(lastUse[r] < firstUse[s] || lastUse[s] < firstUse[r]))
+				return false;
+		}
+	}
+	if (transientCount != pGraph->mStats.mTransientCount || transientBytes != pGraph->mStats.mTransientBytes)
+		return false;
+
+	// Replay the barriers: every recorded old state is the tracked one, and every access finds its state covered.
+	// Transients are tracked through their physical target since aliases share the memory
+	tinystl::vector<ResourceState> resourceStates(resourceCount, RESOURCE_STATE_UNDEFINED);
+	tinystl::vector<ResourceState> physicalStates(pGraph->mPhysical.size(), RESOURCE_STATE_UNDEFINED);
+	for (uint32_t r = 0; r < resourceCount; ++r)
+		resourceStates[r] = pGraph->mResources[r].mInitialState;
+
+	uint32_t barrierCount = 0;
+	uint32_t batchCount = 0;
+	for (uint32_t i = 0; i <= orderCount; ++i)
+	{
+		const RenderGraphPass* pPass = i < orderCount ? &pGraph->mPasses[pGraph->mExecutionOrder[i]] : NULL;
+		const uint32_t offset = pPass ? pPass->mBarrierOffset : pGraph->mFinalBarrierOffset;
+		const uint32_t count = pPass ? pPass->mBarrierCount : pGraph->mFinalBarrierCount;
+		if (offset + count > (uint32_t)pGraph->mBarriers.size())
+			return false;
+		barrierCount += count;
+		batchCount += count ? 1 : 0;
+
+		for (uint32_t b = offset; b < offset + count; ++b)
+		{
+			const RenderGraphBarrier* pBarrier = &pGraph->mBarriers[b];
+			const RenderGraphResource* pResource = &pGraph->mResources[pBarrier->mResource];
+			ResourceState* pState = pResource->mPhysical != RENDER_GRAPH_INVALID_HANDLE ? &physicalStates[pResource->mPhysical] : &resourceStates[pBarrier->mResource];
+			// One transition per resource and batch
+			for (uint32_t c = offset; c < b; ++c)
+			{
+				if (pGraph->mBarriers[c].mResource == pBarrier->mResource)
+					return false;
+			}
+			const bool discard = !pResource->mImported && pPass && firstUse[pBarrier->mResource] == i;
+			if (pBarrier->mOldState != (discard ? RESOURCE_STATE_UNDEFINED : *pState) || pBarrier->mNewState == RESOURCE_STATE_UNDEFINED)
+				return false;
+			// A read only moves to a combined read state, and textures only combine states sharing one image layout
+			if (pPass && !writesResource(pPass, pBarrier->mResource))
+			{
+				const ResourceState mergeable = pResource->mType == RENDER_GRAPH_RESOURCE_BUFFER ? RESOURCE_STATE_GENERIC_READ : (RESOURCE_STATE_SHADER_RESOURCE | RESOURCE_STATE_DEPTH_READ);
+				if (pBarrier->mNewState != getAccessState(pPass, pBarrier->mResource) && (pBarrier->mNewState & ~mergeable))
+					return false;
+			}
+			*pState = pBarrier->mNewState;
+		}
+
+		for (uint32_t r = 0; r < resourceCount && pPass; ++r)
+		{
+			const ResourceState required = getAccessState(pPass, r);
+			if (!required)
+				continue;
+			const RenderGraphResource* pResource = &pGraph->mResources[r];
+			const ResourceState state = pResource->mPhysical != RENDER_GRAPH_INVALID_HANDLE ? physicalStates[pResource->mPhysical] : resourceStates[r];
+			// Writes need the exact state, reads may find the resource in a combined read state
+			if (writesResource(pPass, r) ? state != required : (state & required) != required)
+				return false;
+		}
+	}
+	for (uint32_t r = 0; r < resourceCount; ++r)
+	{
+		const ResourceState finalState = pGraph->mResources[r].mFinalState;
+		if (pGraph->mResources[r].mImported && (resourceStates[r] & finalState) != finalState)
+			return false;
+	}
+	return barrierCount == pGraph->mStats.mBarrierCount && barrierCount == (uint32_t)pGraph->mBarriers.size() && batchCount == pGraph->mStats.mBarrierBatchCount;
+}
+
+UNIT_TEST(RenderGraphRandomGraphsCompile)
+{
+	// Compilation never dereferences imported resources whose initial state is given, zeroed objects are enough
+	RenderGraphTestImports imports = {};
+	imports.pTexture = (Texture*)conf_calloc(1, sizeof(Texture));
+	imports.pBuffer = (Buffer*)conf_calloc(1, sizeof(Buffer));
+	imports.pBackBufferTexture = (Texture*)conf_calloc(1, sizeof(Texture));
+	imports.pBackBuffer = (RenderTarget*)conf_calloc(1, sizeof(RenderTarget));
+	imports.pBackBuffer->mDesc = getRenderGraphTestDesc(0);
+	imports.pBackBuffer->pTexture = imports.pBackBufferTexture;
+
+	RenderGraph* pGraph = NULL;
+	initRenderGraph(&pGraph);
+	tinystl::vector<uint32_t> descIndices;
+	uint32_t state = 0x5EED;
+	uint32_t failedGraph = RENDER_GRAPH_INVALID_HANDLE;
+	uint32_t culledCount = 0;
+	uint32_t aliasedCount = 0;
+	for (uint32_t i = 0; i < 3000 && failedGraph == RENDER_GRAPH_INVALID_HANDLE; ++i)
+	{
+		resetRenderGraph(pGraph);
+		buildRandomRenderGraph(&state, pGraph, &imports, descIndices);
+		if (!compileRenderGraph(pGraph) || !validateRenderGraph(pGraph, descIndices))
+			failedGraph = i;
+		culledCount += pGraph->mStats.mCulledPassCount;
+		aliasedCount += pGraph->mStats.mTransientCount - pGraph->mStats.mPhysicalTargetCount;
+	}
+	exitRenderGraph(NULL, pGraph);
+
+	conf_free(imports.pBackBuffer);
+	conf_free(imports.pBackBufferTexture);
+	conf_free(imports.pBuffer);
+	conf_free(imports.pTexture);
+
+	UNIT_CHECK(failedGraph == RENDER_GRAPH_INVALID_HANDLE);
+	// The random frames have to exercise culling and aliasing or the checks above prove little
+	UNIT_CHECK(culledCount > 0);
+	UNIT_CHECK(aliasedCount > 0);
+}
+
+UNIT_TEST(RenderGraphRejectsReadsBeforeWrites)
+{
+	RenderGraph* pGraph = NULL;
+	initRenderGraph(&pGraph);
+	const RenderTargetDesc desc = getRenderGraphTestDesc(0);
+	const uint32_t target = addRenderGraphRenderTarget(pGraph, "target", &desc);
+	const uint32_t pass = addRenderGraphPass(pGraph, "reader", NULL, NULL, RENDER_GRAPH_PASS_FLAG_SIDE_EFFECTS);
+	renderGraphRead(pGraph, pass, target, RESOURCE_STATE_SHADER_RESOURCE);
+	const bool compiled = compileRenderGraph(pGraph);
+	exitRenderGraph(NULL, pGraph);
+
+	UNIT_CHECK(!compiled);
+}
+
+struct RenderGraphTestFrame
+{
+	uint32_t	mGBuffer;
+	uint32_t	mDepth;
+	uint32_t	mAo;
+	uint32_t	mLit;
+	uint32_t	mDebug;
+	uint32_t	mTonemapped;
+	uint32_t	mBackBuffer;
+	uint32_t	mDebugPass;
+	/// Passes in the order they ran, and accesses that found their resource in the wrong state
+	uint32_t	mExecuted[8];
+	uint32_t	mExecutedCount;
+	uint32_t	mStateErrorCount;
+};
+
+static void executeRenderGraphTestPass(Cmd* /*pCmd*/, RenderGraph* pGraph, uint32_t pass, void* pUserData)
+{
+	RenderGraphTestFrame* pFrame = (RenderGraphTestFrame*)pUserData;
+	if (pFrame->mExecutedCount < 8)
+		pFrame->mExecuted[pFrame->mExecutedCount] = pass;
+	++pFrame->mExecutedCount;
+
+	const RenderGraphPass* pPass = &pGraph->mPasses[pass];
+	for (uint32_t a = 0; a < (uint32_t)pPass->mAccesses.size(); ++a)
+	{
+		const Texture* pTexture = getRenderGraphTexture(pGraph, pPass->mAccesses[a].mResource);
+		const ResourceState required = pPass->mAccesses[a].mState;
+		if (!pTexture || (pTexture->mCurrentState & required) != required)
+			++pFrame->mStateErrorCount;
+	}
+}
+
+// G-buffer, ambient occlusion, lighting and tonemapping into an imported back buffer, plus a debug pass nothing reads
+static void buildRenderGraphTestFrame(RenderGraph* pGraph, RenderTarget* pBackBuffer, RenderGraphTestFrame* pFrame)
+{
+	const RenderTargetDesc colorDesc = getRenderGraphTestDesc(0);
+	const RenderTargetDesc depthDesc = getRenderGraphTestDesc(2);
+	pFrame->mGBuffer = addRenderGraphRenderTarget(pGraph, "gBuffer", &colorDesc);
+	pFrame->mDepth = addRenderGraphRenderTarget(pGraph, "depth", &depthDesc);
+	pFrame->mAo = addRenderGraphRenderTarget(pGraph, "ao", &colorDesc);
+	pFrame->mLit = addRenderGraphRenderTarget(pGraph, "lit", &colorDesc);
+	pFrame->mDebug = addRenderGraphRenderTarget(pGraph, "debug", &colorDesc);
+	pFrame->mTonemapped = addRenderGraphRenderTarget(pGraph, "tonemapped", &colorDesc);
+	pFrame->mBackBuffer = importRenderGraphRenderTarget(pGraph, "backBuffer", pBackBuffer, RESOURCE_STATE_PRESENT, RESOURCE_STATE_PRESENT);
+
+	uint32_t pass = addRenderGraphPass(pGraph, "gBufferPass", executeRenderGraphTestPass, pFrame);
+	renderGraphWrite(pGraph, pass, pFrame->mGBuffer, RESOURCE_STATE_RENDER_TARGET);
+	renderGraphWrite(pGraph, pass, pFrame->mDepth, RESOURCE_STATE_DEPTH_WRITE);
+
+	pass = addRenderGraphPass(pGraph, "aoPass", executeRenderGraphTestPass, pFrame);
+	renderGraphRead(pGraph, pass, pFrame->mDepth, RESOURCE_STATE_SHADER_RESOURCE);
+	renderGraphWrite(pGraph, pass, pFrame->mAo, RESOURCE_STATE_RENDER_TARGET);
+
+	pass = addRenderGraphPass(pGraph, "lightingPass", executeRenderGraphTestPass, pFrame);
+	renderGraphRead(pGraph, pass, pFrame->mGBuffer, RESOURCE_STATE_SHADER_RESOURCE);
+	renderGraphRead(pGraph, pass, pFrame->mAo, RESOURCE_STATE_SHADER_RESOURCE);
+	renderGraphRead(pGraph, pass, pFrame->mDepth, RESOURCE_STATE_DEPTH_READ);
+	renderGraphWrite(pGraph, pass, pFrame->mLit, RESOURCE_STATE_RENDER_TARGET);
+
+	pFrame->mDebugPass = addRenderGraphPass(pGraph, "debugPass", executeRenderGraphTestPass, pFrame);
+	renderGraphRead(pGraph, pFrame->mDebugPass, pFrame->mGBuffer, RESOURCE_STATE_SHADER_RESOURCE);
+	renderGraphWrite(pGraph, pFrame->mDebugPass, pFrame->mDebug, RESOURCE_STATE_RENDER_TARGET);
+
+	pass = addRenderGraphPass(pGraph, "tonemapPass", executeRenderGraphTestPass, pFrame);
+	renderGraphRead(pGraph, pass, pFrame->mLit, RESOURCE_STATE_SHADER_RESOURCE);
+	renderGraphWrite(pGraph, pass, pFrame->mTonemapped, RESOURCE_STATE_RENDER_TARGET);
+
+	pass = addRenderGraphPass(pGraph, "presentPass", executeRenderGraphTestPass, pFrame);
+	renderGraphRead(pGraph, pass, pFrame->mTonemapped, RESOURCE_STATE_SHADER_RESOURCE);
+	renderGraphWrite(pGraph, pass, pFrame->mBackBuffer, RESOURCE_STATE_RENDER_TARGET);
+}
+
+UNIT_TEST(RenderGraphMergesReadsAndAliasesTargets)
+{
+	RenderTarget* pBackBuffer = (RenderTarget*)conf_calloc(1, sizeof(RenderTarget));
+	pBackBuffer->mDesc = getRenderGraphTestDesc(0);
+	pBackBuffer->pTexture = (Texture*)conf_calloc(1, sizeof(Texture));
+
+	RenderGraph* pGraph = NULL;
+	initRenderGraph(&pGraph);
+	RenderGraphTestFrame frame = {};
+	buildRenderGraphTestFrame(pGraph, pBackBuffer, &frame);
+	const bool compiled = compileRenderGraph(pGraph);
+	const RenderGraphStats stats = pGraph->mStats;
+	const bool debugCulled = pGraph->mPasses[frame.mDebugPass].mCulled;
+	const uint32_t tonemappedTarget = pGraph->mResources[frame.mTonemapped].mPhysical;
+	const uint32_t gBufferTarget = pGraph->mResources[frame.mGBuffer].mPhysical;
+	const uint32_t aoTarget = pGraph->mResources[frame.mAo].mPhysical;
+	const uint32_t litTarget = pGraph->mResources[frame.mLit].mPhysical;
+	// The AO pass moves depth straight to the combined state of both reads, lighting needs no transition for it
+	bool depthMerged = false;
+	const RenderGraphPass* pAoPass = &pGraph->mPasses[1];
+	for (uint32_t b = pAoPass->mBarrierOffset; b < pAoPass->mBarrierOffset + pAoPass->mBarrierCount; ++b)
+	{
+		depthMerged = depthMerged || (pGraph->mBarriers[b].mResource == frame.mDepth &&
+			pGraph->mBarriers[b].mNewState == (RESOURCE_STATE_SHADER_RESOURCE | RESOURCE_STATE_DEPTH_READ));
+	}
+	exitRenderGraph(NULL, pGraph);
+	conf_free(pBackBuffer->pTexture);
+	conf_free(pBackBuffer);
+
+	UNIT_CHECK(compiled);
+	UNIT_CHECK(debugCulled);
+	UNIT_CHECK(stats.mPassCount == 5 && stats.mCulledPassCount == 1);
+	// gBuffer + depth, depth + ao, gBuffer + ao + lit, lit + tonemapped, tonemapped + back buffer, then back buffer to present
+	UNIT_CHECK(stats.mBarrierCount == 12);
+	UNIT_CHECK(stats.mBarrierBatchCount == 6);
+	UNIT_CHECK(stats.mMergedReadCount == 1);
+	UNIT_CHECK(depthMerged);
+	// Tonemapping starts after lighting consumed the g-buffer and AO, so it takes one of their targets
+	UNIT_CHECK(stats.mTransientCount == 5 && stats.mPhysicalTargetCount == 4);
+	UNIT_CHECK(tonemappedTarget != litTarget && (tonemappedTarget == gBufferTarget || tonemappedTarget == aoTarget));
+	UNIT_CHECK(stats.mPhysicalBytes < stats.mTransientBytes);
+}
+
+UNIT_TEST(RenderGraphExecutesOnNullRenderer)
+{
+	RendererDesc settings = {};
+	Renderer* pRenderer = NULL;
+	initRenderer("RenderGraphTests", &settings, &pRenderer);
+	Queue* pQueue = NULL;
+	QueueDesc queueDesc = {};
+	queueDesc.mType = CMD_POOL_DIRECT;
+	addQueue(pRenderer, &queueDesc, &pQueue);
+	CmdPool* pCmdPool = NULL;
+	addCmdPool(pRenderer, pQueue, false, &pCmdPool);
+	Cmd* pCmd = NULL;
+	addCmd(pCmdPool, false, &pCmd);
+
+	const RenderTargetDesc backBufferDesc = getRenderGraphTestDesc(0);
+	RenderTarget* pBackBuffer = NULL;
+	addRenderTarget(pRenderer, &backBufferDesc, &pBackBuffer);
+	pBackBuffer->pTexture->mCurrentState = RESOURCE_STATE_PRESENT;
+	const uint32_t textureCountBefore = pRenderer->pNullStats->mTextureCount;
+
+	RenderGraph* pGraph = NULL;
+	initRenderGraph(&pGraph);
+	uint32_t executedPasses[2][8] = {};
+	uint32_t executedCount[2] = {};
+	uint32_t stateErrorCount = 0;
+	uint32_t barrierCommandCount = 0;
+	uint32_t physicalTargetCount[2] = {};
+	uint32_t textureCount[2] = {};
+	bool compiled = true;
+	// The second frame reuses the physical targets of the first one
+	for (uint32_t frameIndex = 0; frameIndex < 2; ++frameIndex)
+	{
+		resetRenderGraph(pGraph);
+		RenderGraphTestFrame frame = {};
+		buildRenderGraphTestFrame(pGraph, pBackBuffer, &frame);
+		compiled = compileRenderGraph(pGraph) && compiled;
+
+		beginCmd(pCmd);
+		executeRenderGraph(pRenderer, pCmd, pGraph);
+		endCmd(pCmd);
+		queueSubmit(pQueue, 1, &pCmd, NULL, 0, NULL, 0, NULL);
+
+		for (uint32_t i = 0; i < (uint32_t)pCmd->pNullStream->mCommands.size(); ++i)
+			barrierCommandCount += pCmd->pNullStream->mCommands[i].mType == NULL_CMD_RESOURCE_BARRIER ? 1 : 0;
+		memcpy(executedPasses[frameIndex], frame.mExecuted, sizeof(frame.mExecuted));
+		executedCount[frameIndex] = frame.mExecutedCount;
+		stateErrorCount += frame.mStateErrorCount;
+		physicalTargetCount[frameIndex] = (uint32_t)pGraph->mPhysical.size();
+		textureCount[frameIndex] = pRenderer->pNullStats->mTextureCount - textureCountBefore;
+	}
+	const ResourceState backBufferState = pBackBuffer->pTexture->mCurrentState;
+
+	exitRenderGraph(pRenderer, pGraph);
+	const uint32_t textureCountAfterExit = pRenderer->pNullStats->mTextureCount;
+	removeRenderTarget(pRenderer, pBackBuffer);
+	removeCmd(pCmdPool, pCmd);
+	removeCmdPool(pRenderer, pCmdPool);
+	removeQueue(pQueue);
+	removeRenderer(pRenderer);
+
+	UNIT_CHECK(compiled);
+	UNIT_CHECK(executedCount[0] == 5 && executedCount[1] == 5);
+	// The debug pass (3) is culled, everything else runs in declaration order
+	const uint32_t expectedOrder[] = { 0, 1, 2, 4, 5 };
+	UNIT_CHECK(memcmp(executedPasses[0], expectedOrder, sizeof(expectedOrder)) == 0);
+	UNIT_CHECK(memcmp(executedPasses[1], expectedOrder, sizeof(expectedOrder)) == 0);
+	UNIT_CHECK(stateErrorCount == 0);
+	// At most one barrier command per batch, the null renderer drops transitions a target is already in
+	UNIT_CHECK(barrierCommandCount > 0 && barrierCommandCount <= 12);
+	UNIT_CHECK(backBufferState == RESOURCE_STATE_PRESENT);
+	UNIT_CHECK(physicalTargetCount[0] == 4 && physicalTargetCount[1] == 4);
+	UNIT_CHECK(textureCount[0] == 4 && textureCount[1] == 4);
+	UNIT_CHECK(textureCountAfterExit == textureCountBefore);
+}
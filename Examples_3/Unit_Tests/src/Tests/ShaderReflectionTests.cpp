@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Tests for shader reflection: the native SPIR-V reflector against SPIRV-Cross, the binary reflection cache
+// and the merge of stage reflections into a pipeline reflection.
+
+#include "../../../../Common_3/Renderer/IRenderer.h"
+#include "../../../../Common_3/Renderer/IShaderReflection.h"
+#include "../../../../Common_3/Renderer/Vulkan/SpirvReflector.h"
+#include "../../../../Common_3/OS/UI/UIShaders.h"
+#include "../../../../Common_3/OS/Interfaces/IFileSystem.h"
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+struct SpirvTestModule
+{
+	const char*		pName;
+	ShaderStage		mStage;
+	const uint32_t*	pCode;
+	uint32_t		mSize;
+};
+
+// Every SPIR-V module in the repository which the test runner can reach: the tessellation sample and the UI shaders
+static const char* gSpirvFiles[] = { "grass.vert.spv", "grass.tesc.spv", "grass.tese.spv", "grass.frag.spv", "compute.comp.spv" };
+static const ShaderStage gSpirvFileStages[] = { SHADER_STAGE_VERT, SHADER_STAGE_TESC, SHADER_STAGE_TESE, SHADER_STAGE_FRAG, SHADER_STAGE_COMP };
+static const uint32_t gSpirvFileCount = sizeof(gSpirvFiles) / sizeof(gSpirvFiles[0]);
+
+static bool loadSpirv(const char* pFileName, tinystl::vector<uint32_t>* pOutCode)
+{
+	File file;
+	if (!file.Open(pFileName, FM_ReadBinary, FSR_BinShaders))
+		return false;
+	pOutCode->resize(file.GetSize() / sizeof(uint32_t));
+	return file.Read(pOutCode->data(), (unsigned)(pOutCode->size() * sizeof(uint32_t))) == pOutCode->size() * sizeof(uint32_t);
+}
+
+static bool loadTestModules(tinystl::vector<tinystl::vector<uint32_t> >* pStorage, tinystl::vector<SpirvTestModule>* pOutModules)
+{
+	pStorage->resize(gSpirvFileCount);
+	for (uint32_t i = 0; i < gSpirvFileCount; ++i)
+	{
+		if (!loadSpirv(gSpirvFiles[i], &(*pStorage)[i]))
+			return false;
+		SpirvTestModule module = { gSpirvFiles[i], gSpirvFileStages[i], (*pStorage)[i].data(), (uint32_t)((*pStorage)[i].size() * sizeof(uint32_t)) };
+		pOutModules->push_back(module);
+	}
+
+	const SpirvTestModule builtinModules[] = {
+		{ "builtin_plain_vert", SHADER_STAGE_VERT, builtin_plain_vert, sizeof(builtin_plain_vert) },
+		{ "builtin_plain_frag", SHADER_STAGE_FRAG, builtin_plain_frag, sizeof(builtin_plain_frag) },
+		{ "builtin_textured_vert", SHADER_STAGE_VERT, builtin_textured_vert, sizeof(builtin_textured_vert) },
+		{ "builtin_textured_frag", SHADER_STAGE_FRAG, builtin_textured_frag, sizeof(builtin_textured_frag) },
+		{ "builtin_textured_red_alpha_frag", SHADER_STAGE_FRAG, builtin_textured_red_alpha_frag, sizeof(builtin_textured_red_alpha_frag) },
+		{ "builtin_textured_distance_field_frag", SHADER_STAGE_FRAG, builtin_textured_distance_field_frag, sizeof(builtin_textured_distance_field_frag) },
+	};
+	for (uint32_t i = 0; i < sizeof(builtinModules) / sizeof(builtinModules[0]); ++i)
+		pOutModules->push_back(builtinModules[i]);
+	return true;
+}
+
+static bool namesEqual(const char* a, uint32_t aSize, const char* b, uint32_t bSize)
+{
+	return aSize == bSize && memcmp(a, b, aSize) == 0;
+}
+
+static bool spirvResourcesEqual(const SPIRV_Resource& a, const SPIRV_Resource& b)
+{
+	return a.SPIRV_code.id == b.SPIRV_code.id && a.SPIRV_code.type_id == b.SPIRV_code.type_id &&
+		a.SPIRV_code.base_type_id == b.SPIRV_code.base_type_id && a.type == b.type && a.is_used == b.is_used &&
+		a.set == b.set && a.binding == b.binding && a.size == b.size && namesEqual(a.name, a.name_size, b.name, b.name_size);
+}
+
+static bool spirvVariablesEqual(const SPIRV_Variable& a, const SPIRV_Variable& b)
+{
+	return a.SPIRV_type_id == b.SPIRV_type_id && a.parent_SPIRV_code.id == b.parent_SPIRV_code.id && a.parent_index == b.parent_index &&
+		a.is_used == b.is_used && a.offset == b.offset && a.size == b.size && namesEqual(a.name, a.name_size, b.name, b.name_size);
+}
+
+static bool compareWithSpirvCross(const SpirvTestModule& module)
+{
+	const uint32_t wordCount = module.mSize / sizeof(uint32_t);
+	SpirvReflection native;
+	if (!createSpirvReflection(module.pCode, wordCount, &native))
+	{
+		printf("    %s: native reflection failed\n", module.pName);
+		return false;
+	}
+
+	CrossCompiler cc;
+	CreateCrossCompiler(module.pCode, wordCount, &cc);
+	ReflectShaderResources(&cc);
+	ReflectShaderVariables(&cc);
+
+	bool equal = native.mShaderResourceCount == cc.ShaderResourceCount && native.mUniformVariableCount == cc.UniformVariablesCount;
+	for (uint32_t i = 0; equal && i < native.mShaderResourceCount; ++i)
+	{
+		equal = spirvResourcesEqual(native.pShaderResources[i], cc.pShaderResouces[i]);
+		if (!equal)
+			printf("    %s: resource %u (%s) differs\n", module.pName, i, cc.pShaderResouces[i].name);
+	}
+	for (uint32_t i = 0; equal && i < native.mUniformVariableCount; ++i)
+	{
+		equal = spirvVariablesEqual(native.pUniformVariables[i], cc.pUniformVariables[i]);
+		if (!equal)
+			printf("    %s: variable %u (%s) differs\n", module.pName, i, cc.pUniformVariables[i].name);
+	}
+
+	if (equal && module.mStage == SHADER_STAGE_COMP)
+	{
+		uint32_t size[3] = {};
+		ReflectComputeShaderWorkGroupSize(&cc, &size[0], &size[1], &size[2]);
+		equal = memcmp(size, native.mWorkGroupSize, sizeof(size)) == 0;
+	}
+	else if (equal && module.mStage == SHADER_STAGE_TESC)
+	{
+		uint32_t controlPointCount = 0;
+		ReflectHullShaderControlPoint(&cc, &controlPointCount);
+		equal = controlPointCount == native.mOutputVertexCount;
+	}
+	if (!equal)
+		printf("    %s: %u/%u resources, %u/%u variables (native/SPIRV-Cross)\n", module.pName,
+			native.mShaderResourceCount, cc.ShaderResourceCount, native.mUniformVariableCount, cc.UniformVariablesCount);
+
+	DestroyCrossCompiler(&cc);
+	destroySpirvReflection(&native);
+	return equal;
+}
+
+UNIT_TEST(SpirvReflectorMatchesSpirvCross)
+{
+	tinystl::vector<tinystl::vector<uint32_t> > storage;
+	tinystl::vector<SpirvTestModule> modules;
+	UNIT_CHECK(loadTestModules(&storage, &modules));
+
+	uint32_t mismatchCount = 0;
+	for (uint32_t i = 0; i < (uint32_t)modules.size(); ++i)
+		mismatchCount += compareWithSpirvCross(modules[i]) ? 0 : 1;
+	UNIT_CHECK(mismatchCount == 0);
+}
+
+UNIT_TEST(SpirvReflectorRejectsMalformedModules)
+{
+	tinystl::vector<uint32_t> code;
+	UNIT_CHECK(loadSpirv("grass.frag.spv", &code));
+
+	SpirvReflection reflection;
+	UNIT_CHECK(!createSpirvReflection(code.data(), 4, &reflection));
+
+	tinystl::vector<uint32_t> badMagic = code;
+	badMagic[0] = ~badMagic[0];
+	UNIT_CHECK(!createSpirvReflection(badMagic.data(), (uint32_t)badMagic.size(), &reflection));
+
+	// Cutting the module in the middle of an instruction must be detected instead of reading past the end
+	uint32_t truncatedFailures = 0;
+	for (uint32_t wordCount = 6; wordCount < (uint32_t)code.size(); wordCount += 7)
+	{
+		if (createSpirvReflection(code.data(), wordCount, &reflection))
+			destroySpirvReflection(&reflection);
+		else
+			++truncatedFailures;
+	}
+	UNIT_CHECK(truncatedFailures > 0);
+}
+
+static bool shaderReflectionsEqual(const ShaderReflection& a, const ShaderReflection& b)
+{
+	if (a.mShaderStage != b.mShaderStage || a.mVertexInputsCount != b.mVertexInputsCount || a.mShaderResourceCount != b.mShaderResourceCount ||
+		a.mVariableCount != b.mVariableCount || memcmp(a.mNumThreadsPerGroup, b.mNumThreadsPerGroup, sizeof(a.mNumThreadsPerGroup)) != 0 ||
+		a.mNumControlPoint != b.mNumControlPoint)
+		return false;
+
+	for (uint32_t i = 0; i < a.mVertexInputsCount; ++i)
+	{
+		const VertexInput& va = a.pVertexInputs[i];
+		const VertexInput& vb = b.pVertexInputs[i];
+		if (va.size != vb.size || !namesEqual(va.name, va.name_size, vb.name, vb.name_size))
+			return false;
+	}
+	for (uint32_t i = 0; i < a.mShaderResourceCount; ++i)
+	{
+		const ShaderResource& ra = a.pShaderResources[i];
+		const ShaderResource& rb = b.pShaderResources[i];
+		if (ra.type != rb.type || ra.set != rb.set || ra.reg != rb.reg || ra.size != rb.size || ra.used_stages != rb.used_stages ||
+			!namesEqual(ra.name, ra.name_size, rb.name, rb.name_size))
+			return false;
+	}
+	for (uint32_t i = 0; i < a.mVariableCount; ++i)
+	{
+		const ShaderVariable& va = a.pVariables[i];
+		const ShaderVariable& vb = b.pVariables[i];
+		if (va.parent_index != vb.parent_index || va.offset != vb.offset || va.size != vb.size || !namesEqual(va.name, va.name_size, vb.name, vb.name_size))
+			return false;
+	}
+	return true;
+}
+
+UNIT_TEST(ShaderReflectionBlobRoundTrip)
+{
+	tinystl::vector<tinystl::vector<uint32_t> > storage;
+	tinystl::vector<SpirvTestModule> modules;
+	UNIT_CHECK(loadTestModules(&storage, &modules));
+
+	for (uint32_t i = 0; i < (uint32_t)modules.size(); ++i)
+	{
+		const uint64_t codeHash = 0x1234 + i;
+		ShaderReflection reflection = {};
+		createShaderReflection((const uint8_t*)modules[i].pCode, modules[i].mSize, modules[i].mStage, &reflection);
+
+		tinystl::vector<uint8_t> blob((size_t)getShaderReflectionBlobSize(&reflection));
+		writeShaderReflectionBlob(&reflection, codeHash, blob.data());
+
+		ShaderReflection loaded = {};
+		bool readBack = readShaderReflectionBlob(blob.data(), blob.size(), codeHash, &loaded);
+		bool equal = readBack && shaderReflectionsEqual(reflection, loaded);
+		if (readBack)
+			destroyShaderReflection(&loaded);
+
+		// Blobs of other shader code and truncated blobs are rejected
+		ShaderReflection rejected = {};
+		bool otherCodeRejected = !readShaderReflectionBlob(blob.data(), blob.size(), codeHash + 1, &rejected);
+		bool truncatedRejected = !readShaderReflectionBlob(blob.data(), blob.size() - 1, codeHash, &rejected);
+		destroyShaderReflection(&reflection);
+
+		UNIT_CHECK(equal);
+		UNIT_CHECK(otherCodeRejected);
+		UNIT_CHECK(truncatedRejected);
+	}
+}
+
+static bool shaderResourcesMatch(const ShaderResource& a, const ShaderResource& b)
+{
+	return a.type == b.type && a.set == b.set && a.reg == b.reg && a.size == b.size && namesEqual(a.name, a.name_size, b.name, b.name_size);
+}
+
+static bool shaderVariablesMatch(const ShaderVariable& a, const ShaderVariable& b)
+{
+	return a.offset == b.offset && a.size == b.size && namesEqual(a.name, a.name_size, b.name, b.name_size);
+}
+
+UNIT_TEST(PipelineReflectionMergesStages)
+{
+	// The tessellation pipeline shares uniform blocks between all four stages
+	const uint32_t stageCount = 4;
+	ShaderReflection stages[stageCount];
+	tinystl::vector<uint32_t> code[stageCount];
+	for (uint32_t i = 0; i < stageCount; ++i)
+	{
+		UNIT_CHECK(loadSpirv(gSpirvFiles[i], &code[i]));
+		stages[i] = {};
+		createShaderReflection((const uint8_t*)code[i].data(), (uint32_t)(code[i].size() * sizeof(uint32_t)), gSpirvFileStages[i], &stages[i]);
+	}
+
+	PipelineReflection pipeline = {};
+	createPipelineReflection(stages, stageCount, &pipeline);
+
+	// Brute force reference merge: first occurrence wins, later stages only add their stage bits
+	tinystl::vector<ShaderResource> expectedResources;
+	tinystl::vector<ShaderVariable> expectedVariables;
+	tinystl::vector<uint32_t> expectedParents;
+	uint32_t sharedResourceCount = 0;
+	for (uint32_t s = 0; s < stageCount; ++s)
+	{
+		tinystl::vector<uint32_t> remap(stages[s].mShaderResourceCount);
+		for (uint32_t j = 0; j < stages[s].mShaderResourceCount; ++j)
+		{
+			const ShaderResource& resource = stages[s].pShaderResources[j];
+			uint32_t index = 0;
+			while (index < (uint32_t)expectedResources.size() && !shaderResourcesMatch(expectedResources[index], resource))
+				++index;
+			if (index == (uint32_t)expectedResources.size())
+				expectedResources.push_back(resource);
+			else
+			{
+				expectedResources[index].used_stages = (ShaderStage)(expectedResources[index].used_stages | resource.used_stages);
+				++sharedResourceCount;
+			}
+			remap[j] = index;
+		}
+		for (uint32_t j = 0; j < stages[s].mVariableCount; ++j)
+		{
+			const ShaderVariable& variable = stages[s].pVariables[j];
+			uint32_t index = 0;
+			while (index < (uint32_t)expectedVariables.size() && !shaderVariablesMatch(expectedVariables[index], variable))
+				++index;
+			if (index == (uint32_t)expectedVariables.size())
+			{
+				expectedVariables.push_back(variable);
+				expectedParents.push_back(remap[variable.parent_index]);
+			}
+		}
+	}
+
+	bool resourcesMatch = pipeline.mShaderResourceCount == (uint32_t)expectedResources.size();
+	for (uint32_t i = 0; resourcesMatch && i < pipeline.mShaderResourceCount; ++i)
+	{
+		resourcesMatch = shaderResourcesMatch(pipeline.pShaderResources[i], expectedResources[i]) &&
+			pipeline.pShaderResources[i].used_stages == expectedResources[i].used_stages;
+	}
+	bool variablesMatch = pipeline.mVariableCount == (uint32_t)expectedVariables.size();
+	for (uint32_t i = 0; variablesMatch && i < pipeline.mVariableCount; ++i)
+	{
+		variablesMatch = shaderVariablesMatch(pipeline.pVariables[i], expectedVariables[i]) &&
+			pipeline.pVariables[i].parent_index == expectedParents[i];
+	}
+	ShaderStage combinedStages = pipeline.mShaderStages;
+	uint32_t vertexStageIndex = pipeline.mVertexStageIndex;
+
+	// Destroys the stage reflections as well
+	destroyPipelineReflection(&pipeline);
+
+	UNIT_CHECK(sharedResourceCount > 0);
+	UNIT_CHECK(resourcesMatch);
+	UNIT_CHECK(variablesMatch);
+	UNIT_CHECK(combinedStages == (SHADER_STAGE_VERT | SHADER_STAGE_TESC | SHADER_STAGE_TESE | SHADER_STAGE_FRAG));
+	UNIT_CHECK(vertexStageIndex == 0);
+}
@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Replays a scripted camera path through the texture residency planner and checks the budget, the load order and the eviction order.
+
+#include "../../../../Common_3/OS/Image/TextureStreaming.h"
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+#define TEXTURE_STREAMING_TEST_TEXTURES 24
+#define TEXTURE_STREAMING_TEST_FRAMES 400
+#define TEXTURE_STREAMING_TEST_BUDGET (48ULL << 20)
+#define TEXTURE_STREAMING_TEST_LOW_BUDGET (20ULL << 20)
+#define TEXTURE_STREAMING_TEST_UNUSED_FRAMES 8
+
+struct TextureStreamingTestRequest
+{
+	uint32_t	mFrame;
+	MipRequest	mRequest;
+};
+
+// What the planner is expected to know about a texture, tracked from the requests alone
+struct TextureStreamingTestTexture
+{
+	StreamedTextureId	mId;
+	uint32_t			mWidth;
+	uint32_t			mHeight;
+	uint32_t			mMipCount;
+	uint32_t			mTailMip;
+	uint32_t			mResidentMip;
+	uint32_t			mPendingMip;
+	uint32_t			mLastUsedFrame;
+	float				mCoverage;
+};
+
+struct TextureStreamingTestResult
+{
+	tinystl::vector<TextureStreamingTestRequest>	mRequests;
+	TextureResidencyStatistics						mStatistics;
+	uint32_t										mResidentMips[TEXTURE_STREAMING_TEST_TEXTURES];
+	uint32_t										mFailedFrame;
+	int												mFailedLine;
+};
+
+static float getTextureStreamingTestImportance(const TextureStreamingTestTexture& texture, uint32_t frame, uint32_t mip)
+{
+	// The planner forgets the coverage of textures that were not reported for a while
+	const float coverage = frame - texture.mLastUsedFrame > TEXTURE_STREAMING_TEST_UNUSED_FRAMES ? 0.0f : texture.mCoverage;
+	const uint64_t texels = (uint64_t)max(texture.mWidth >> mip, 1u) * max(texture.mHeight >> mip, 1u);
+	return coverage / (float)texels;
+}
+
+static bool isTextureStreamingTestEvictable(const TextureStreamingTestTexture& texture)
+{
+	return texture.mPendingMip == ~0u && texture.mResidentMip < texture.mTailMip;
+}
+
+// The camera flies along a row of textures and back, coverage falls off with the squared distance
+static float getTextureStreamingTestCoverage(uint32_t frame, uint32_t texture)
+{
+	const float t = (float)(frame % 200) / 200.0f;
+	const float cameraX = -20.0f + 280.0f * (t < 0.5f ? 2.0f * t : 2.0f - 2.0f * t);
+	const float distance = cameraX - 10.0f * (float)texture;
+	if (fabsf(distance) > 60.0f)
+		return -1.0f;
+	return 4.0e6f / (1.0f + distance * distance);
+}
+
+#define TEXTURE_STREAMING_TEST_CHECK(expression) \
+	do { if (!(expression) && !pResult->mFailedLine) { pResult->mFailedFrame = frame; pResult->mFailedLine = __LINE__; } } while (0)
+
+static void runTextureStreamingTest(TextureStreamingTestResult* pResult)
+{
+	pResult->mRequests.clear();
+	pResult->mFailedFrame = 0;
+	pResult->mFailedLine = 0;
+	uint32_t frame = 0;
+
+	TextureResidencyDesc desc;
+	desc.mBudgetBytes = TEXTURE_STREAMING_TEST_BUDGET;
+	desc.mUnusedFrameCount = TEXTURE_STREAMING_TEST_UNUSED_FRAMES;
+	TextureResidencyPlanner planner;
+	planner.Init(&desc);
+
+	TextureStreamingTestTexture textures[TEXTURE_STREAMING_TEST_TEXTURES];
+	for (uint32_t i = 0; i < TEXTURE_STREAMING_TEST_TEXTURES; ++i)
+	{
+		StreamedTextureDesc textureDesc;
+		textureDesc.mWidth = 2048 >> (i % 4);
+		textureDesc.mHeight = 2048 >> ((i + 1) % 3);
+		textureDesc.mMipCount = 12 - (i % 4);
+		textureDesc.mFormat = ImageFormat::RGBA8;
+
+		TextureStreamingTestTexture& texture = textures[i];
+		texture.mId = planner.AddTexture(&textureDesc);
+		texture.mWidth = textureDesc.mWidth;
+		texture.mHeight = textureDesc.mHeight;
+		texture.mMipCount = textureDesc.mMipCount;
+		texture.mTailMip = texture.mMipCount - 1;
+		while (texture.mTailMip > 0 && (texture.mWidth >> (texture.mTailMip - 1)) <= desc.mTailSize && (texture.mHeight >> (texture.mTailMip - 1)) <= desc.mTailSize)
+			--texture.mTailMip;
+		texture.mResidentMip = texture.mMipCount;
+		texture.mPendingMip = ~0u;
+		texture.mLastUsedFrame = 0;
+		texture.mCoverage = 0.0f;
+		TEXTURE_STREAMING_TEST_CHECK(texture.mId == i);
+	}
+
+	tinystl::vector<MipRequest> requests;
+	for (frame = 0; frame < TEXTURE_STREAMING_TEST_FRAMES; ++frame)
+	{
+		// The budget shrinks halfway, loaded mips have to be evicted right away
+		if (frame == TEXTURE_STREAMING_TEST_FRAMES / 2)
+			planner.SetBudget(TEXTURE_STREAMING_TEST_LOW_BUDGET);
+
+		for (uint32_t i = 0; i < TEXTURE_STREAMING_TEST_TEXTURES; ++i)
+		{
+			const float coverage = getTextureStreamingTestCoverage(frame, i);
+			if (coverage < 0.0f)
+				continue;
+			planner.ReportUsage(textures[i].mId, coverage);
+			textures[i].mCoverage = coverage;
+			textures[i].mLastUsedFrame = frame;
+		}
+
+		requests.clear();
+		planner.Update(&requests);
+		const TextureResidencyStatistics& stats = planner.GetStatistics();
+		TEXTURE_STREAMING_TEST_CHECK(stats.mResidentBytes + stats.mPendingBytes <= stats.mBudgetBytes);
+
+		bool tailLoads = true;
+		float lastLoadImportance = 0.0f;
+		bool firstLoad = true;
+		for (uint32_t r = 0; r < (uint32_t)requests.size(); ++r)
+		{
+			const MipRequest& request = requests[r];
+			TextureStreamingTestRequest logged = { frame, request };
+			pResult->mRequests.push_back(logged);
+			TextureStreamingTestTexture& texture = textures[request.mTexture];
+
+			if (request.mType == MIP_REQUEST_LOAD)
+			{
+				TEXTURE_STREAMING_TEST_CHECK(texture.mPendingMip == ~0u);
+				if (texture.mResidentMip == texture.mMipCount)
+				{
+					// Every texture starts with its whole tail, and all tails come before the first detail mip
+					TEXTURE_STREAMING_TEST_CHECK(tailLoads);
+					TEXTURE_STREAMING_TEST_CHECK(request.mFirstMip == texture.mTailMip && request.mMipCount == texture.mMipCount - texture.mTailMip);
+				}
+				else
+				{
+					// Detail mips stream one level at a time from the smallest one up, most important first
+					tailLoads = false;
+					TEXTURE_STREAMING_TEST_CHECK(request.mFirstMip == texture.mResidentMip - 1 && request.mMipCount == 1);
+					const float importance = getTextureStreamingTestImportance(texture, frame, request.mFirstMip);
+					TEXTURE_STREAMING_TEST_CHECK(firstLoad || importance <= lastLoadImportance);
+					lastLoadImportance = importance;
+					firstLoad = false;
+				}
+				texture.mPendingMip = request.mFirstMip;
+			}
+			else
+			{
+				// The victim has the lowest screen space priority of everything that can be evicted, apart from
+				// the texture whose load the eviction makes room for
+				TEXTURE_STREAMING_TEST_CHECK(isTextureStreamingTestEvictable(texture) && request.mFirstMip == texture.mResidentMip);
+				uint32_t loadTexture = ~0u;
+				for (uint32_t n = r + 1; n < (uint32_t)requests.size() && loadTexture == ~0u; ++n)
+					if (requests[n].mType == MIP_REQUEST_LOAD)
+						loadTexture = requests[n].mTexture;
+				const float importance = getTextureStreamingTestImportance(texture, frame, texture.mResidentMip);
+				for (uint32_t i = 0; i < TEXTURE_STREAMING_TEST_TEXTURES; ++i)
+				{
+					if (i == request.mTexture || i == loadTexture || !isTextureStreamingTestEvictable(textures[i]))
+						continue;
+					TEXTURE_STREAMING_TEST_CHECK(importance <= getTextureStreamingTestImportance(textures[i], frame, textures[i].mResidentMip));
+				}
+				++texture.mResidentMip;
+			}
+		}
+
+		// Reads finish before the next frame, in the order they were requested
+		for (uint32_t r = 0; r < (uint32_t)requests.size(); ++r)
+		{
+			if (requests[r].mType != MIP_REQUEST_LOAD)
+				continue;
+			TextureStreamingTestTexture& texture = textures[requests[r].mTexture];
+			planner.OnMipLoaded(texture.mId, requests[r].mFirstMip);
+			texture.mResidentMip = requests[r].mFirstMip;
+			texture.mPendingMip = ~0u;
+		}
+		TEXTURE_STREAMING_TEST_CHECK(stats.mPendingBytes == 0);
+		TEXTURE_STREAMING_TEST_CHECK(stats.mResidentBytes <= stats.mBudgetBytes);
+		for (uint32_t i = 0; i < TEXTURE_STREAMING_TEST_TEXTURES; ++i)
+			TEXTURE_STREAMING_TEST_CHECK(planner.GetResidentMip(textures[i].mId) == textures[i].mResidentMip);
+	}
+
+	pResult->mStatistics = planner.GetStatistics();
+	for (uint32_t i = 0; i < TEXTURE_STREAMING_TEST_TEXTURES; ++i)
+		pResult->mResidentMips[i] = planner.GetResidentMip(textures[i].mId);
+	planner.Exit();
+}
+
+UNIT_TEST(TextureResidencyReplaysCameraPath)
+{
+	TextureStreamingTestResult results[2];
+	for (uint32_t run = 0; run < 2; ++run)
+	{
+		runTextureStreamingTest(&results[run]);
+		if (results[run].mFailedLine)
+			printf("    Replay %u failed at frame %u, line %d\n", run, results[run].mFailedFrame, results[run].mFailedLine);
+		UNIT_CHECK(results[run].mFailedLine == 0);
+	}
+
+	// The path has to exercise the planner: every texture streams detail mips and the budget forces evictions in both halves
+	const TextureResidencyStatistics& stats = results[0].mStatistics;
+	uint32_t evictions[2] = {};
+	uint32_t detailLoads = 0;
+	for (uint32_t r = 0; r < (uint32_t)results[0].mRequests.size(); ++r)
+	{
+		const TextureStreamingTestRequest& logged = results[0].mRequests[r];
+		if (logged.mRequest.mType == MIP_REQUEST_EVICT)
+			++evictions[logged.mFrame >= TEXTURE_STREAMING_TEST_FRAMES / 2];
+		else if (logged.mRequest.mMipCount == 1)
+			++detailLoads;
+	}
+	UNIT_CHECK(evictions[0] > 0 && evictions[1] > 0);
+	UNIT_CHECK(detailLoads > TEXTURE_STREAMING_TEST_TEXTURES);
+	UNIT_CHECK(stats.mTextureCount == TEXTURE_STREAMING_TEST_TEXTURES);
+	UNIT_CHECK(stats.mBudgetBytes == TEXTURE_STREAMING_TEST_LOW_BUDGET);
+	UNIT_CHECK(stats.mLoadedBytes - stats.mEvictedBytes == stats.mResidentBytes);
+
+	// Two replays of the same path produce the same requests in the same order
+	UNIT_CHECK(results[0].mRequests.size() == results[1].mRequests.size());
+	for (uint32_t r = 0; r < (uint32_t)results[0].mRequests.size(); ++r)
+	{
+		const TextureStreamingTestRequest& a = results[0].mRequests[r];
+		const TextureStreamingTestRequest& b = results[1].mRequests[r];
+		UNIT_CHECK(a.mFrame == b.mFrame && a.mRequest.mTexture == b.mRequest.mTexture && a.mRequest.mType == b.mRequest.mType);
+		UNIT_CHECK(a.mRequest.mFirstMip == b.mRequest.mFirstMip && a.mRequest.mMipCount == b.mRequest.mMipCount && a.mRequest.mSize == b.mRequest.mSize);
+	}
+	UNIT_CHECK(memcmp(&results[0].mStatistics, &results[1].mStatistics, sizeof(TextureResidencyStatistics)) == 0);
+	UNIT_CHECK(memcmp(results[0].mResidentMips, results[1].mResidentMips, sizeof(results[0].mResidentMips)) == 0);
+}
@@ -0,0 +1,398 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Tests for the offset-only TLSF block and the defragmentation planner. Both run on fake heaps, nothing is
+// read or written through the offsets.
+
+#include "../../../../Common_3/Renderer/TlsfAllocator.h"
+#include "../../../../Common_3/OS/Interfaces/IOperatingSystem.h"
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+struct TlsfTestAllocation
+{
+	TlsfRange*	pRange;
+	uint64_t	mSize;
+	uint64_t	mAlignment;
+};
+
+static uint64_t randomAllocationSize(uint32_t* pState, uint64_t granularity)
+{
+	// Mostly small allocations with a long tail of large ones, like resource heaps
+	const uint32_t shift = unitTestRandom(pState) % 15;
+	const uint64_t size = (uint64_t)(1 + unitTestRandom(pState) % 16) << shift;
+	return ((size * 256 + granularity - 1) / granularity) * granularity;
+}
+
+// The physical range list must tile the block without gaps and every live allocation must own exactly its range
+static bool validateTlsfAllocations(const TlsfBlock* pBlock, const tinystl::vector<TlsfTestAllocation>& allocations)
+{
+	if (!validateTlsfBlock(pBlock))
+		return false;
+
+	uint64_t offset = 0;
+	uint32_t usedRangeCount = 0;
+	const TlsfRange* pPrev = NULL;
+	for (const TlsfRange* pRange = pBlock->pFirstRange; pRange; pRange = pRange->pNextPhysical)
+	{
+		if (pRange->mOffset != offset || pRange->pPrevPhysical != pPrev || !pRange->mSize)
+			return false;
+		// Neighbouring free ranges are always merged
+		if (pRange->mFree && pPrev && pPrev->mFree)
+			return false;
+		if (!pRange->mFree)
+		{
+			const TlsfTestAllocation* pAllocation = (const TlsfTestAllocation*)pRange->pUserData;
+			if (pAllocation->pRange != pRange || pRange->mSize < pAllocation->mSize || (pRange->mOffset & (pAllocation->mAlignment - 1)))
+				return false;
+			++usedRangeCount;
+		}
+		offset += pRange->mSize;
+		pPrev = pRange;
+	}
+	return offset == pBlock->mSize && pPrev == pBlock->pLastRange && usedRangeCount == (uint32_t)allocations.size() &&
+		usedRangeCount == pBlock->mAllocationCount;
+}
+
+UNIT_TEST(TlsfBlockStress)
+{
+	const uint64_t blockSize = 256ull << 20;
+	const uint32_t operationCount = 200000;
+
+	TlsfBlock* pBlock = conf_placement_new<TlsfBlock>(conf_calloc(1, sizeof(TlsfBlock)));
+	initTlsfBlock(pBlock, blockSize);
+
+	// Allocations live in a fixed array so the user data pointers stay valid, live ones are tracked by index
+	tinystl::vector<TlsfTestAllocation> storage(operationCount);
+	tinystl::vector<TlsfTestAllocation*> live;
+	tinystl::vector<TlsfTestAllocation> liveCopy;
+	uint32_t state = 0xC0FFEE;
+	uint32_t failedAllocations = 0;
+	uint32_t validationFailures = 0;
+	for (uint32_t i = 0; i < operationCount; ++i)
+	{
+		// Keep the block around 70% full so allocations fail now and then and frees merge a lot
+		const bool allocate = live.empty() || (unitTestRandom(&state) % 100) < (pBlock->mFreeBytes > blockSize * 3 / 10 ? 60u : 40u);
+		if (allocate)
+		{
+			TlsfTestAllocation* pAllocation = &storage[i];
+			pAllocation->mSize = randomAllocationSize(&state, 1);
+			pAllocation->mAlignment = (unitTestRandom(&state) & 1) ? 64 * 1024 : 256;
+			if (!(unitTestRandom(&state) % 50))
+				pAllocation->mAlignment = 4 * 1024 * 1024;
+			pAllocation->pRange = tlsfAllocate(pBlock, pAllocation->mSize, pAllocation->mAlignment, pAllocation);
+			if (pAllocation->pRange)
+				live.push_back(pAllocation);
+			else
+				++failedAllocations;
+		}
+		else
+		{
+			const uint32_t index = unitTestRandom(&state) % (uint32_t)live.size();
+			tlsfFree(pBlock, live[index]->pRange);
+			live[index] = live.back();
+			live.pop_back();
+		}
+
+		if (!(i % 2000))
+		{
+			liveCopy.resize(live.size());
+			for (uint32_t j = 0; j < (uint32_t)live.size(); ++j)
+				liveCopy[j] = *live[j];
+			validationFailures += validateTlsfAllocations(pBlock, liveCopy) ? 0 : 1;
+		}
+	}
+
+	for (uint32_t i = 0; i < (uint32_t)live.size(); ++i)
+		tlsfFree(pBlock, live[i]->pRange);
+	TlsfBlockStats stats;
+	getTlsfBlockStats(pBlock, &stats);
+	bool emptyBlockValid = validateTlsfBlock(pBlock);
+
+	exitTlsfBlock(pBlock);
+	pBlock->~TlsfBlock();
+	conf_free(pBlock);
+
+	UNIT_CHECK(validationFailures == 0);
+	UNIT_CHECK(failedAllocations < operationCount / 10);
+	UNIT_CHECK(emptyBlockValid);
+	UNIT_CHECK(stats.mUsedBytes == 0 && stats.mFreeBytes == blockSize);
+	UNIT_CHECK(stats.mFreeRangeCount == 1 && stats.mLargestFreeRange == blockSize);
+	UNIT_CHECK(stats.mFragmentation == 0.0f);
+}
+
+UNIT_TEST(TlsfAllocateAtRejectsUsedRanges)
+{
+	TlsfBlock* pBlock = conf_placement_new<TlsfBlock>(conf_calloc(1, sizeof(TlsfBlock)));
+	initTlsfBlock(pBlock, 1 << 20);
+
+	TlsfRange* pFirst = tlsfAllocateAt(pBlock, 4096, 8192, NULL);
+	TlsfRange* pSecond = tlsfAllocateAt(pBlock, 64 * 1024, 4096, NULL);
+	TlsfRange* pOverlap = tlsfAllocateAt(pBlock, 8192, 8192, NULL);
+	TlsfRange* pOutside = tlsfAllocateAt(pBlock, (1 << 20) - 4096, 8192, NULL);
+	bool placed = pFirst && pFirst->mOffset == 4096 && pSecond && pSecond->mOffset == 64 * 1024;
+	bool valid = validateTlsfBlock(pBlock);
+
+	exitTlsfBlock(pBlock);
+	pBlock->~TlsfBlock();
+	conf_free(pBlock);
+
+	UNIT_CHECK(placed);
+	UNIT_CHECK(!pOverlap);
+	UNIT_CHECK(!pOutside);
+	UNIT_CHECK(valid);
+}
+
+/************************************************************************/
+// Defragmentation planner replay
+/************************************************************************/
+#define DEFRAG_TEST_GRANULARITY 256
+#define DEFRAG_TEST_FREE_PAGE 0xFFFFFFFFu
+
+// Page ownership map of a set of fake heaps: every DEFRAG_TEST_GRANULARITY bytes belong to one allocation or are free
+struct DefragTestHeap
+{
+	tinystl::vector<tinystl::vector<uint32_t> > mPages;
+
+	bool IsOwned(uint32_t block, uint64_t offset, uint64_t size, uint32_t owner) const
+	{
+		for (uint64_t page = offset / DEFRAG_TEST_GRANULARITY; page < (offset + size) / DEFRAG_TEST_GRANULARITY; ++page)
+		{
+			if (page >= mPages[block].size() || mPages[block][(size_t)page] != owner)
+				return false;
+		}
+		return true;
+	}
+
+	void SetOwner(uint32_t block, uint64_t offset, uint64_t size, uint32_t owner)
+	{
+		for (uint64_t page = offset / DEFRAG_TEST_GRANULARITY; page < (offset + size) / DEFRAG_TEST_GRANULARITY; ++page)
+			mPages[block][(size_t)page] = owner;
+	}
+
+	bool IsEmpty(uint32_t block) const
+	{
+		for (uint32_t page = 0; page < (uint32_t)mPages[block].size(); ++page)
+		{
+			if (mPages[block][page] != DEFRAG_TEST_FREE_PAGE)
+				return false;
+		}
+		return true;
+	}
+};
+
+// Fills the blocks through TLSF and frees a random subset, which leaves the holes a long running heap has
+static void createFragmentedHeap(uint32_t* pState, uint32_t blockCount, uint64_t blockSize, tinystl::vector<DefragmentationAllocation>* pOutAllocations)
+{
+	tinystl::vector<TlsfTestAllocation> storage(blockCount * 8192);
+	uint32_t used = 0;
+	for (uint32_t block = 0; block < blockCount; ++block)
+	{
+		TlsfBlock* pBlock = conf_placement_new<TlsfBlock>(conf_calloc(1, sizeof(TlsfBlock)));
+		initTlsfBlock(pBlock, blockSize);
+		const uint32_t first = used;
+		while (used < (uint32_t)storage.size())
+		{
+			TlsfTestAllocation* pAllocation = &storage[used];
+			pAllocation->mSize = randomAllocationSize(pState, DEFRAG_TEST_GRANULARITY);
+			pAllocation->mAlignment = (unitTestRandom(pState) % 4) ? DEFRAG_TEST_GRANULARITY : 64 * 1024;
+			pAllocation->pRange = tlsfAllocate(pBlock, pAllocation->mSize, pAllocation->mAlignment, pAllocation);
+			if (!pAllocation->pRange)
+				break;
+			++used;
+		}
+
+		// Blocks get very different fill levels so some of them can be emptied completely
+		const uint32_t keepPercent = 10 + unitTestRandom(pState) % 80;
+		for (uint32_t i = first; i < used; ++i)
+		{
+			if (unitTestRandom(pState) % 100 >= keepPercent)
+				continue;
+			DefragmentationAllocation allocation = {};
+			allocation.mBlockIndex = block;
+			allocation.mOffset = storage[i].pRange->mOffset;
+			allocation.mSize = storage[i].mSize;
+			allocation.mAlignment = storage[i].mAlignment;
+			allocation.mMovable = (unitTestRandom(pState) % 20) != 0;
+			pOutAllocations->push_back(allocation);
+		}
+
+		exitTlsfBlock(pBlock);
+		pBlock->~TlsfBlock();
+		conf_free(pBlock);
+	}
+}
+
+static bool replayDefragmentation(uint32_t seed, uint64_t maxBytesToMove, uint32_t maxMoves, DefragmentationStats* pOutStats)
+{
+	const uint32_t blockCount = 8;
+	const uint64_t blockSize = 64ull << 20;
+	uint32_t state = seed;
+
+	tinystl::vector<DefragmentationAllocation> allocations;
+	createFragmentedHeap(&state, blockCount, blockSize, &allocations);
+	for (uint32_t i = 0; i < (uint32_t)allocations.size(); ++i)
+		allocations[i].pUserData = (void*)(uintptr_t)(i + 1);
+
+	DefragTestHeap heap;
+	heap.mPages.resize(blockCount);
+	tinystl::vector<uint64_t> blockSizes(blockCount, blockSize);
+	for (uint32_t block = 0; block < blockCount; ++block)
+		heap.mPages[block].resize((size_t)(blockSize / DEFRAG_TEST_GRANULARITY), DEFRAG_TEST_FREE_PAGE);
+	for (uint32_t i = 0; i < (uint32_t)allocations.size(); ++i)
+		heap.SetOwner(allocations[i].mBlockIndex, allocations[i].mOffset, allocations[i].mSize, i);
+
+	tinystl::vector<bool> wasEmpty(blockCount);
+	for (uint32_t block = 0; block < blockCount; ++block)
+		wasEmpty[block] = heap.IsEmpty(block);
+
+	DefragmentationPlanDesc desc = {};
+	desc.pBlockSizes = blockSizes.data();
+	desc.mBlockCount = blockCount;
+	desc.pAllocations = allocations.data();
+	desc.mAllocationCount = (uint32_t)allocations.size();
+	desc.mMaxBytesToMove = maxBytesToMove;
+	desc.mMaxMoves = maxMoves;
+	tinystl::vector<DefragmentationMove> moves;
+	planDefragmentation(&desc, &moves, pOutStats);
+
+	// Execute the moves in order on the page map: the source must still hold the allocation, the destination
+	// must be free at that point and aligned, immovable allocations never move
+	tinystl::vector<uint32_t> blockOf(allocations.size());
+	tinystl::vector<uint64_t> offsetOf(allocations.size());
+	for (uint32_t i = 0; i < (uint32_t)allocations.size(); ++i)
+	{
+		blockOf[i] = allocations[i].mBlockIndex;
+		offsetOf[i] = allocations[i].mOffset;
+	}
+	uint64_t bytesMoved = 0;
+	for (uint32_t i = 0; i < (uint32_t)moves.size(); ++i)
+	{
+		const DefragmentationMove& move = moves[i];
+		const uint32_t index = (uint32_t)(uintptr_t)move.pUserData - 1;
+		if (index >= (uint32_t)allocations.size())
+			return false;
+		const DefragmentationAllocation& allocation = allocations[index];
+		if (!allocation.mMovable || move.mSize != allocation.mSize || move.mDstBlockIndex >= blockCount)
+			return false;
+		if (move.mSrcBlockIndex != blockOf[index] || move.mSrcOffset != offsetOf[index] || (move.mDstOffset & (allocation.mAlignment - 1)))
+			return false;
+		if (!heap.IsOwned(move.mSrcBlockIndex, move.mSrcOffset, move.mSize, index) ||
+			!heap.IsOwned(move.mDstBlockIndex, move.mDstOffset, move.mSize, DEFRAG_TEST_FREE_PAGE))
+			return false;
+
+		heap.SetOwner(move.mSrcBlockIndex, move.mSrcOffset, move.mSize, DEFRAG_TEST_FREE_PAGE);
+		heap.SetOwner(move.mDstBlockIndex, move.mDstOffset, move.mSize, index);
+		blockOf[index] = move.mDstBlockIndex;
+		offsetOf[index] = move.mDstOffset;
+		bytesMoved += move.mSize;
+	}
+
+	uint32_t blocksFreed = 0;
+	for (uint32_t block = 0; block < blockCount; ++block)
+		blocksFreed += (!wasEmpty[block] && heap.IsEmpty(block)) ? 1 : 0;
+
+	return pOutStats->mMoveCount == (uint32_t)moves.size() && pOutStats->mBytesMoved == bytesMoved && pOutStats->mBlocksFreed == blocksFreed &&
+		(!maxMoves || moves.size() <= maxMoves) && (!maxBytesToMove || bytesMoved <= maxBytesToMove) &&
+		pOutStats->mFragmentationAfter <= pOutStats->mFragmentationBefore;
+}
+
+UNIT_TEST(DefragmentationPlanReplay)
+{
+	uint32_t blocksFreed = 0;
+	float fragmentationBefore = 0.0f;
+	float fragmentationAfter = 0.0f;
+	for (uint32_t trial = 0; trial < 8; ++trial)
+	{
+		DefragmentationStats stats;
+		UNIT_CHECK(replayDefragmentation(0x1000 + trial * 7919, 0, 0, &stats));
+		blocksFreed += stats.mBlocksFreed;
+		fragmentationBefore += stats.mFragmentationBefore;
+		fragmentationAfter += stats.mFragmentationAfter;
+	}
+
+	// Without budgets the planner has to both release blocks and compact the remaining ones
+	UNIT_CHECK(blocksFreed > 0);
+	UNIT_CHECK(fragmentationAfter < fragmentationBefore * 0.5f);
+}
+
+UNIT_TEST(DefragmentationPlanHonoursBudgets)
+{
+	for (uint32_t trial = 0; trial < 4; ++trial)
+	{
+		DefragmentationStats stats;
+		UNIT_CHECK(replayDefragmentation(0x2000 + trial * 104729, 8ull << 20, 0, &stats));
+		UNIT_CHECK(stats.mBytesMoved <= (8ull << 20));
+		UNIT_CHECK(replayDefragmentation(0x3000 + trial * 104729, 0, 25, &stats));
+		UNIT_CHECK(stats.mMoveCount <= 25);
+	}
+}
+
+UNIT_BENCHMARK(TlsfAllocateFree)
+{
+	const uint64_t blockSize = 256ull << 20;
+	const uint32_t operationCount = 400000;
+
+	TlsfBlock* pBlock = conf_placement_new<TlsfBlock>(conf_calloc(1, sizeof(TlsfBlock)));
+	initTlsfBlock(pBlock, blockSize);
+	tinystl::vector<TlsfRange*> live;
+	live.reserve(operationCount);
+	uint32_t state = 0xBEEF;
+	uint32_t allocationCount = 0;
+	uint32_t freeCount = 0;
+	int64_t allocateUsec = 0;
+	int64_t freeUsec = 0;
+	for (uint32_t i = 0; i < operationCount; ++i)
+	{
+		if (live.empty() || (unitTestRandom(&state) % 100) < (pBlock->mFreeBytes > blockSize * 3 / 10 ? 60u : 40u))
+		{
+			const uint64_t size = randomAllocationSize(&state, 1);
+			const uint64_t alignment = (unitTestRandom(&state) & 1) ? 64 * 1024 : 256;
+			int64_t start = getUSec();
+			TlsfRange* pRange = tlsfAllocate(pBlock, size, alignment, NULL);
+			allocateUsec += getUSec() - start;
+			++allocationCount;
+			if (pRange)
+				live.push_back(pRange);
+		}
+		else
+		{
+			const uint32_t index = unitTestRandom(&state) % (uint32_t)live.size();
+			int64_t start = getUSec();
+			tlsfFree(pBlock, live[index]);
+			freeUsec += getUSec() - start;
+			++freeCount;
+			live[index] = live.back();
+			live.pop_back();
+		}
+	}
+	exitTlsfBlock(pBlock);
+	pBlock->~TlsfBlock();
+	conf_free(pBlock);
+
+	UNIT_BENCHMARK_REPORT("tlsfAllocate", allocateUsec, 1, allocationCount);
+	UNIT_BENCHMARK_REPORT("tlsfFree", freeUsec, 1, freeCount);
+}
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Tests and benchmarks for the UI property registry: lookups by description and the property file load and save.
+
+#include "../../../../Common_3/OS/UI/UI.h"
+#include "../../../../Common_3/OS/Interfaces/IFileSystem.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+#define UI_PROPERTY_TEST_NAME_SIZE 40
+#define UI_PROPERTY_TEST_TEXT_SIZE 16
+
+static const char* gUIPropertyTestEnumNames[] = { "Low", "Medium", "High", "Ultra", NULL };
+static const int gUIPropertyTestEnumValues[] = { 3, 7, -2, 100 };
+
+// Every kind of property in turn, the storage of the values and descriptions is allocated up front since the
+// properties point into it
+struct UIPropertyTestSet
+{
+	UI							mUI;
+	tinystl::vector<char>		mNames;
+	tinystl::vector<uint32_t>	mValues;
+	tinystl::vector<char>		mTexts;
+	uint32_t					mSavedCount;
+};
+
+static void uiPropertyTestButton(void* /*pUserData*/) {}
+
+static UIPropertyType getUIPropertyTestType(uint32_t index)
+{
+	return (UIPropertyType)(index % (UI_PROPERTY_TEXTINPUT + 1));
+}
+
+static void buildUIPropertyTestSet(uint32_t count, UIPropertyTestSet* pSet)
+{
+	pSet->mUI.clearProperties();
+	pSet->mNames.resize(count * UI_PROPERTY_TEST_NAME_SIZE);
+	pSet->mValues.resize(count, 0);
+	pSet->mTexts.resize(count * UI_PROPERTY_TEST_TEXT_SIZE, 0);
+	pSet->mSavedCount = 0;
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		// Descriptions share long prefixes and contain spaces like the ones of the samples
+		char* pName = pSet->mNames.data() + i * UI_PROPERTY_TEST_NAME_SIZE;
+		snprintf(pName, UI_PROPERTY_TEST_NAME_SIZE, "Panel %u Setting %u", i / 100, i);
+		uint32_t* pValue = pSet->mValues.data() + i;
+
+		switch (getUIPropertyTestType(i))
+		{
+		case UI_PROPERTY_FLOAT: pSet->mUI.addProperty(UIProperty(pName, *(float*)pValue, -1e30f, 1e30f)); break;
+		case UI_PROPERTY_INT: pSet->mUI.addProperty(UIProperty(pName, *(int*)pValue)); break;
+		case UI_PROPERTY_UINT: pSet->mUI.addProperty(UIProperty(pName, *(unsigned int*)pValue)); break;
+		case UI_PROPERTY_BOOL: pSet->mUI.addProperty(UIProperty(pName, *(bool*)pValue)); break;
+		case UI_PROPERTY_ENUM:
+			*(int*)pValue = gUIPropertyTestEnumValues[0];
+			pSet->mUI.addProperty(UIProperty(pName, *(int*)pValue, gUIPropertyTestEnumNames, gUIPropertyTestEnumValues));
+			break;
+		case UI_PROPERTY_BUTTON: pSet->mUI.addProperty(UIProperty(pName, uiPropertyTestButton, NULL)); break;
+		case UI_PROPERTY_TEXTINPUT:
+			pSet->mUI.addProperty(UIProperty(pName, pSet->mTexts.data() + i * UI_PROPERTY_TEST_TEXT_SIZE, UI_PROPERTY_TEST_TEXT_SIZE));
+			break;
+		}
+
+		if (getUIPropertyTestType(i) < UI_PROPERTY_BUTTON)
+			++pSet->mSavedCount;
+	}
+}
+
+// Values cover the whole range of every type. Floats include denormals, infinities and negative zero but no NaN since
+// those can't be compared bit for bit after a round trip
+static void randomizeUIPropertyTestSet(uint32_t* pState, UIPropertyTestSet* pSet)
+{
+	for (uint32_t i = 0; i < pSet->mValues.size(); ++i)
+	{
+		uint32_t* pValue = pSet->mValues.data() + i;
+		switch (getUIPropertyTestType(i))
+		{
+		case UI_PROPERTY_FLOAT:
+		{
+			uint32_t bits;
+			do
+			{
+				const uint32_t specials[] = { 0x80000000u, 0x7F800000u, 0xFF800000u, 0x00000001u, 0x807FFFFFu, 0x7F7FFFFFu };
+				bits = unitTestRandom(pState) % 8 == 0 ? specials[unitTestRandom(pState) % 6] : unitTestRandom(pState);
+			} while ((bits & 0x7F800000u) == 0x7F800000u && (bits & 0x007FFFFFu) != 0);
+			*pValue = bits;
+			break;
+		}
+		case UI_PROPERTY_INT:
+		case UI_PROPERTY_UINT:
+			*pValue = unitTestRandom(pState) % 4 == 0 ? 0x80000000u + unitTestRandom(pState) % 3 - 1 : unitTestRandom(pState);
+			break;
+		case UI_PROPERTY_BOOL: *(bool*)pValue = (unitTestRandom(pState) & 1) != 0; break;
+		case UI_PROPERTY_ENUM: *(int*)pValue = gUIPropertyTestEnumValues[unitTestRandom(pState) % 4]; break;
+		default: break;
+		}
+	}
+}
+
+UNIT_TEST(UIPropertyFileRoundTrip)
+{
+	const char* pFileName = "UIPropertyTests.txt";
+	UIPropertyTestSet* pSet = conf_placement_new<UIPropertyTestSet>(conf_calloc(1, sizeof(UIPropertyTestSet)));
+	uint32_t state = 0x0E1;
+
+	const uint32_t counts[] = { 1, 7, 100, 5000, 20000 };
+	for (uint32_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+	{
+		buildUIPropertyTestSet(counts[c], pSet);
+		randomizeUIPropertyTestSet(&state, pSet);
+
+		// Removed properties are not saved and keep their value on load
+		uint32_t removedCount = 0;
+		for (uint32_t i = 5; i < counts[c]; i += 11)
+		{
+			pSet->mUI.removeProperty(i);
+			removedCount += getUIPropertyTestType(i) < UI_PROPERTY_BUTTON ? 1 : 0;
+		}
+
+		UNIT_CHECK(pSet->mUI.saveProperties(pFileName));
+		const tinystl::vector<uint32_t> saved = pSet->mValues;
+		randomizeUIPropertyTestSet(&state, pSet);
+		const tinystl::vector<uint32_t> overwritten = pSet->mValues;
+		UNIT_CHECK(pSet->mUI.loadProperties(pFileName));
+
+		for (uint32_t i = 0; i < counts[c]; ++i)
+		{
+			const bool removed = i >= 5 && (i - 5) % 11 == 0;
+			if (getUIPropertyTestType(i) == UI_PROPERTY_BOOL)
+				UNIT_CHECK(*(bool*)&pSet->mValues[i] == *(bool*)(removed ? &overwritten[i] : &saved[i]));
+			else
+				UNIT_CHECK(pSet->mValues[i] == (removed ? overwritten[i] : saved[i]));
+		}
+
+		// Every saved property is applied exactly once
+		File file;
+		UNIT_CHECK(file.Open(pFileName, FM_ReadBinary, FSR_OtherFiles));
+		tinystl::vector<char> text(file.GetSize());
+		UNIT_CHECK(file.Read(text.data(), (unsigned)text.size()) == text.size());
+		file.Close();
+		UNIT_CHECK(pSet->mUI.parseProperties(text.data(), text.size()) == pSet->mSavedCount - removedCount);
+	}
+
+	UNIT_CHECK(FileSystem::Delete(FileSystem::FixPath(pFileName, FSR_OtherFiles)));
+	UNIT_CHECK(!pSet->mUI.loadProperties(pFileName));
+
+	pSet->~UIPropertyTestSet();
+	conf_free(pSet);
+}
+
+UNIT_TEST(UIPropertyParseEdgeCases)
+{
+	UI* pUI = conf_placement_new<UI>(conf_calloc(1, sizeof(UI)));
+	float f = 1.0f;
+	int i = 2;
+	unsigned int u = 3;
+	bool b = false;
+	int e = gUIPropertyTestEnumValues[0];
+	int duplicate = 4;
+	pUI->addProperty(UIProperty("Light Intensity", f, 0.0f, 10.0f));
+	pUI->addProperty(UIProperty("Sample Count", i));
+	pUI->addProperty(UIProperty("Cascade Count", u));
+	pUI->addProperty(UIProperty("Enable SSAO", b));
+	pUI->addProperty(UIProperty("Quality", e, gUIPropertyTestEnumNames, gUIPropertyTestEnumValues));
+	pUI->addProperty(UIProperty("sample count", duplicate));
+
+	// Byte order mark, case insensitive names, CRLF line ends, trailing spaces and no line end on the last line
+	const char text[] = "\xEF\xBB\xBFlight intensity=2.5  \r\nSAMPLE COUNT=-7\r\nUnknown=1\nno separator\n\nCascade Count=9\t\r\nquality=ultra\nenable ssao=TRUE";
+	UNIT_CHECK(pUI->parseProperties(text, sizeof(text) - 1) == 5);
+	UNIT_CHECK(f == 2.5f && i == -7 && u == 9 && b && e == 100);
+	// Of two properties with the same description only the first one is set
+	UNIT_CHECK(duplicate == 4);
+
+	// Malformed numbers and unknown enum names leave the values alone, values are not read past the end of the text
+	const char malformed[] = "Light Intensity=abc\nSample Count=\nCascade Count=x1\nQuality=Extreme\nEnable SSAO=1";
+	UNIT_CHECK(pUI->parseProperties(malformed, sizeof(malformed) - 1) == 1);
+	UNIT_CHECK(f == 2.5f && i == -7 && u == 9 && b && e == 100);
+	UNIT_CHECK(pUI->parseProperties("Sample Count=12345", 15) == 1);
+	UNIT_CHECK(i == 12);
+	const char ignored[] = "Enable SSAO=0\n";
+	UNIT_CHECK(pUI->parseProperties(ignored, 0) == 0);
+	UNIT_CHECK(b);
+
+	// A description containing '=' can't be loaded back, the line is split at the first one
+	UNIT_CHECK(pUI->parseProperties("Enable SSAO=false=true", 22) == 1);
+	UNIT_CHECK(!b);
+
+	pUI->~UI();
+	conf_free(pUI);
+}
+
+UNIT_TEST(UIPropertyFindAfterChanges)
+{
+	UI* pUI = conf_placement_new<UI>(conf_calloc(1, sizeof(UI)));
+	int values[4] = {};
+	const uint32_t first = pUI->addProperty(UIProperty("Exposure", values[0]));
+	const uint32_t second = pUI->addProperty(UIProperty("Gamma", values[1]));
+	const uint32_t third = pUI->addProperty(UIProperty("EXPOSURE", values[2]));
+	UNIT_CHECK(pUI->findProperty("exposure") == (int)first);
+	UNIT_CHECK(pUI->findProperty("GAMMA") == (int)second);
+	UNIT_CHECK(pUI->findProperty("Gamma ") == -1);
+	UNIT_CHECK(pUI->findProperty("Gam") == -1);
+	UNIT_CHECK(pUI->findProperty("") == -1);
+
+	// Removing the first of two duplicates makes the other one visible
+	pUI->removeProperty(first);
+	UNIT_CHECK(pUI->findProperty("Exposure") == (int)third);
+
+	// The freed slot is reused and looked up under its new description
+	UNIT_CHECK(pUI->addProperty(UIProperty("Bloom", values[3])) == first);
+	UNIT_CHECK(pUI->findProperty("bloom") == (int)first);
+	UNIT_CHECK(pUI->findProperty("Exposure") == (int)third);
+	UNIT_CHECK(pUI->getPropertyCount() == 3);
+
+	pUI->clearProperties();
+	UNIT_CHECK(pUI->findProperty("Bloom") == -1);
+	UNIT_CHECK(pUI->getPropertyCount() == 0);
+
+	// The table grows past its initial size without losing entries
+	UIPropertyTestSet* pSet = conf_placement_new<UIPropertyTestSet>(conf_calloc(1, sizeof(UIPropertyTestSet)));
+	buildUIPropertyTestSet(3000, pSet);
+	for (uint32_t i = 0; i < 3000; ++i)
+		UNIT_CHECK(pSet->mUI.findProperty(pSet->mNames.data() + i * UI_PROPERTY_TEST_NAME_SIZE) == (int)i);
+	pSet->~UIPropertyTestSet();
+	conf_free(pSet);
+
+	pUI->~UI();
+	conf_free(pUI);
+}
+
+UNIT_BENCHMARK(UIPropertyLoadSave)
+{
+	const char* pFileName = "UIPropertyTests.txt";
+	UIPropertyTestSet* pSet = conf_placement_new<UIPropertyTestSet>(conf_calloc(1, sizeof(UIPropertyTestSet)));
+	uint32_t state = 0xB0B;
+
+	const uint32_t counts[] = { 1000, 5000, 20000 };
+	for (uint32_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+	{
+		buildUIPropertyTestSet(counts[c], pSet);
+		randomizeUIPropertyTestSet(&state, pSet);
+
+		const uint32_t iterationCount = 20;
+		int64_t start = getUSec();
+		for (uint32_t i = 0; i < iterationCount; ++i)
+			pSet->mUI.saveProperties(pFileName);
+		const int64_t saveUSec = getUSec() - start;
+
+		start = getUSec();
+		for (uint32_t i = 0; i < iterationCount; ++i)
+			pSet->mUI.loadProperties(pFileName);
+		const int64_t loadUSec = getUSec() - start;
+
+		char label[64];
+		snprintf(label, sizeof(label), "save %u properties", counts[c]);
+		UNIT_BENCHMARK_REPORT(label, saveUSec, iterationCount, counts[c]);
+		snprintf(label, sizeof(label), "load %u properties", counts[c]);
+		UNIT_BENCHMARK_REPORT(label, loadUSec, iterationCount, counts[c]);
+	}
+
+	FileSystem::Delete(FileSystem::FixPath(pFileName, FSR_OtherFiles));
+	pSet->~UIPropertyTestSet();
+	conf_free(pSet);
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Runner for the tests registered with UNIT_TEST and UNIT_BENCHMARK.
+// Usage: UnitTests [--bench] [name filter]
+// The runner is started from the build directory, resource roots below are relative to it.
+
+#include <string.h>
+
+#include "../../../../Common_3/OS/Interfaces/ILogManager.h"
+#include "../../../../Common_3/OS/Interfaces/IFileSystem.h"
+#include "../../../../Common_3/OS/Interfaces/IThread.h"
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+const char* pszRoots[FSR_Count] =
+{
+	"../../src/07_Tessellation/PCVulkan/",	// FSR_BinShaders
+	"../../src/07_Tessellation/PCVulkan/",	// FSR_SrcShaders
+	"",										// FSR_BinShaders_Common
+	"",										// FSR_SrcShaders_Common
+	"../../UnitTestResources/Textures/",	// FSR_Textures
+	"../../UnitTestResources/Meshes/",		// FSR_Meshes
+	"../../UnitTestResources/Fonts/",		// FSR_Builtin_Fonts
+	"",										// FSR_OtherFiles
+};
+
+static UnitTest* pFirstTest = NULL;
+static UnitTest* pLastTest = NULL;
+static bool gCurrentTestFailed = false;
+
+UnitTest::UnitTest(const char* name, UnitTestFunction function, bool benchmark) :
+	pName(name),
+	pFunction(function),
+	mBenchmark(benchmark),
+	pNext(NULL)
+{
+	// Keep registration order so tests run in the order they appear in each file
+	if (pLastTest)
+		pLastTest->pNext = this;
+	else
+		pFirstTest = this;
+	pLastTest = this;
+}
+
+void unitTestFail(const char* file, int line, const char* expression)
+{
+	printf("    %s(%d): check failed: %s\n", file, line, expression);
+	gCurrentTestFailed = true;
+}
+
+int main(int argc, char** argv)
+{
+	LogManager logManager;
+	Thread::SetMainThread();
+
+	bool benchmarks = false;
+	const char* pFilter = NULL;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--bench") == 0)
+			benchmarks = true;
+		else
+			pFilter = argv[i];
+	}
+
+	uint32_t runCount = 0;
+	uint32_t failCount = 0;
+	for (UnitTest* pTest = pFirstTest; pTest; pTest = pTest->pNext)
+	{
+		if (pTest->mBenchmark != benchmarks)
+			continue;
+		if (pFilter && !strstr(pTest->pName, pFilter))
+			continue;
+
+		printf("[ RUN  ] %s\n", pTest->pName);
+		fflush(stdout);
+		gCurrentTestFailed = false;
+		pTest->pFunction();
+		printf("[ %s ] %s\n", gCurrentTestFailed ? "FAIL" : " OK ", pTest->pName);
+		++runCount;
+		if (gCurrentTestFailed)
+			++failCount;
+	}
+
+	printf("%u of %u %s passed\n", runCount - failCount, runCount, benchmarks ? "benchmarks" : "tests");
+	return failCount ? 1 : 0;
+}
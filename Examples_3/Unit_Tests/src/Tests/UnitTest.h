@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Minimal self registering test runner for the CPU side of Common_3.
+// Each test is a function registered with UNIT_TEST, UNIT_CHECK reports the failing expression and leaves the test.
+// Benchmarks registered with UNIT_BENCHMARK only run when the runner is started with --bench.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef void (*UnitTestFunction)();
+
+struct UnitTest
+{
+	UnitTest(const char* name, UnitTestFunction function, bool benchmark);
+
+	const char*			pName;
+	UnitTestFunction	pFunction;
+	bool				mBenchmark;
+	UnitTest*			pNext;
+};
+
+/// Marks the running test as failed and prints the location of the failure
+void unitTestFail(const char* file, int line, const char* expression);
+
+#define UNIT_TEST(name) \
+	static void name(); \
+	static UnitTest gUnitTest_##name(#name, name, false); \
+	static void name()
+
+#define UNIT_BENCHMARK(name) \
+	static void name(); \
+	static UnitTest gUnitTest_##name(#name, name, true); \
+	static void name()
+
+#define UNIT_CHECK(expression) \
+	do { if (!(expression)) { unitTestFail(__FILE__, __LINE__, #expression); return; } } while (0)
+
+/// Deterministic xorshift32 generator so failures reproduce across runs and platforms
+static inline uint32_t unitTestRandom(uint32_t* pState)
+{
+	uint32_t x = *pState;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*pState = x;
+	return x;
+}
+
+static inline float unitTestRandomFloat(uint32_t* pState, float minValue, float maxValue)
+{
+	return minValue + (maxValue - minValue) * (float)(unitTestRandom(pState) >> 8) / (float)(1 << 24);
+}
+
+/// Prints the time per iteration and per item of a benchmark loop
+#define UNIT_BENCHMARK_REPORT(label, usec, iterationCount, itemCount) \
+	printf("    %-40s %10.3f us/iter %10.2f ns/item\n", label, (double)(usec) / (double)(iterationCount), \
+		(double)(usec) * 1000.0 / ((double)(iterationCount) * (double)(itemCount)))
+
+/// Prints the throughput of a benchmark loop that processed byteCount bytes in total
+#define UNIT_BENCHMARK_REPORT_BYTES(label, usec, byteCount) \
+	printf("    %-40s %10.3f GB/s\n", label, (double)(byteCount) / ((double)(usec) * 1000.0))
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Error bound tests for the quantized vertex formats of VertexCompression.
+// Every format is fed values at the worst case of its quantization (half steps, octahedral folds, half float rounding
+// midpoints) and the decoded data is checked against the VERTEX_*_MAX_ERROR constants.
+
+#include <float.h>
+
+#include "../../../../Common_3/Tools/VertexCompression/VertexCompression.h"
+
+#include "UnitTest.h"
+
+#include "../../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+#define VERTEX_TEST_COUNT 4096
+
+struct VertexTestData
+{
+	float3 mPositions[VERTEX_TEST_COUNT];
+	float3 mNormals[VERTEX_TEST_COUNT];
+	float3 mTangents[VERTEX_TEST_COUNT];
+	float3 mBitangents[VERTEX_TEST_COUNT];
+	float2 mTexCoords[VERTEX_TEST_COUNT];
+};
+
+static float3 randomDirection(uint32_t* pState)
+{
+	for (;;)
+	{
+		float3 v(unitTestRandomFloat(pState, -1.0f, 1.0f), unitTestRandomFloat(pState, -1.0f, 1.0f), unitTestRandomFloat(pState, -1.0f, 1.0f));
+		float lengthSqr = v.x * v.x + v.y * v.y + v.z * v.z;
+		if (lengthSqr > 1e-4f && lengthSqr <= 1.0f)
+			return v / sqrtf(lengthSqr);
+	}
+}
+
+static float3 cross(const float3& a, const float3& b)
+{
+	return float3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+static float3 normalize(const float3& v)
+{
+	return v / sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+}
+
+static void fillVertexTestData(VertexTestData* pData, const float3& minBounds, const float3& maxBounds, float texCoordRange)
+{
+	uint32_t state = 0x9E3779B9;
+	const float3 extent = maxBounds - minBounds;
+
+	// Octahedral folds, poles and axis aligned directions are the classic failure points of the encoding
+	const float3 specialDirections[] = {
+		float3(0.0f, 0.0f, 1.0f), float3(0.0f, 0.0f, -1.0f), float3(1.0f, 0.0f, 0.0f), float3(-1.0f, 0.0f, 0.0f),
+		float3(0.0f, 1.0f, 0.0f), float3(0.0f, -1.0f, 0.0f), normalize(float3(1.0f, 1.0f, 0.0f)), normalize(float3(-1.0f, 1.0f, 0.0f)),
+		normalize(float3(1.0f, -1.0f, 1e-7f)), normalize(float3(1.0f, 1.0f, -1e-3f)), normalize(float3(1.0f, 1.0f, 1.0f)), normalize(float3(-1.0f, -1.0f, -1.0f)),
+	};
+	const uint32_t specialCount = sizeof(specialDirections) / sizeof(specialDirections[0]);
+
+	for (uint32_t i = 0; i < VERTEX_TEST_COUNT; ++i)
+	{
+		// Every other vertex sits exactly between two quantization steps, the worst case of unorm16 rounding
+		float3 position;
+		for (int c = 0; c < 3; ++c)
+		{
+			float t = (i & 1) ? ((float)(unitTestRandom(&state) % 65535) + 0.5f) / 65535.0f : unitTestRandomFloat(&state, 0.0f, 1.0f);
+			position[c] = minBounds[c] + t * extent[c];
+		}
+		if (i < 2)
+			position = i ? maxBounds : minBounds;
+		pData->mPositions[i] = position;
+
+		float3 normal = i < specialCount ? specialDirections[i] : randomDirection(&state);
+		float3 helper = fabsf(normal.x) < 0.9f ? float3(1.0f, 0.0f, 0.0f) : float3(0.0f, 1.0f, 0.0f);
+		float3 tangent = normalize(cross(helper, normal));
+		if (i >= specialCount && (i & 2))
+			tangent = i < 2 * specialCount ? specialDirections[i - specialCount] : tangent;
+		float3 bitangent = cross(normal, tangent) * ((unitTestRandom(&state) & 1) ? 1.0f : -1.0f);
+		pData->mNormals[i] = normal;
+		pData->mTangents[i] = tangent;
+		pData->mBitangents[i] = bitangent;
+
+		pData->mTexCoords[i] = float2(unitTestRandomFloat(&state, -texCoordRange, texCoordRange), unitTestRandomFloat(&state, -texCoordRange, texCoordRange));
+	}
+	// Half float edge cases: subnormals, the largest power of two below the mantissa limit and rounding midpoints
+	pData->mTexCoords[0] = float2(1e-6f, -3e-8f);
+	pData->mTexCoords[1] = float2(2048.0f + 1.0f, 1.0f + 1.0f / 2048.0f);
+	pData->mTexCoords[2] = float2(0.0f, -0.0f);
+}
+
+static void checkFormats(const VertexCompressionDesc& desc, const VertexTestData* pData, VertexCompressionError* pOutError)
+{
+	CompressedVertexStreams streams;
+	VertexCompression::Compress(&desc, VERTEX_TEST_COUNT, pData->mPositions, pData->mNormals, pData->mTangents, pData->mBitangents, pData->mTexCoords, &streams);
+	*pOutError = VertexCompression::MeasureError(&streams, pData->mPositions, pData->mNormals, pData->mTangents, pData->mBitangents, pData->mTexCoords);
+}
+
+UNIT_TEST(VertexCompressionQuantizedFormatsStayWithinBounds)
+{
+	VertexTestData* pData = (VertexTestData*)conf_malloc(sizeof(VertexTestData));
+	const float3 minBounds(-37.5f, 0.25f, -1000.0f);
+	const float3 maxBounds(120.0f, 0.75f, 1000.0f);
+	fillVertexTestData(pData, minBounds, maxBounds, 4.0f);
+
+	VertexCompressionDesc desc;
+	desc.mPositionFormat = VERTEX_POSITION_UNORM16;
+	desc.mNormalFormat = VERTEX_NORMAL_OCT16;
+	desc.mTangentFormat = VERTEX_TANGENT_OCT16_SIGN;
+	desc.mTexCoordFormat = VERTEX_TEXCOORD_UNORM16;
+	VertexCompressionError unormError;
+	checkFormats(desc, pData, &unormError);
+
+	desc.mTexCoordFormat = VERTEX_TEXCOORD_HALF;
+	VertexCompressionError halfError;
+	checkFormats(desc, pData, &halfError);
+	conf_free(pData);
+
+	const float3 extent = maxBounds - minBounds;
+	const float largestExtent = max(extent.x, max(extent.y, extent.z));
+	UNIT_CHECK(unormError.mOutOfBoundsCount == 0);
+	UNIT_CHECK(unormError.mPosition <= largestExtent * VERTEX_UNORM16_MAX_ERROR + 8.0f * FLT_EPSILON * 1000.0f);
+	UNIT_CHECK(unormError.mNormal <= VERTEX_OCT16_MAX_ANGLE_ERROR);
+	UNIT_CHECK(unormError.mTangent <= VERTEX_OCT16_MAX_ANGLE_ERROR);
+	UNIT_CHECK(unormError.mBitangentSignMismatches == 0);
+	// The half steps in the data must actually reach the bound, otherwise the test does not exercise the worst case
+	UNIT_CHECK(unormError.mPosition >= 0.9f * 2000.0f * VERTEX_UNORM16_MAX_ERROR);
+	UNIT_CHECK(unormError.mNormal > 0.25f * VERTEX_OCT16_MAX_ANGLE_ERROR);
+
+	UNIT_CHECK(halfError.mOutOfBoundsCount == 0);
+	UNIT_CHECK(halfError.mTexCoord <= 2049.0f * VERTEX_HALF_MAX_RELATIVE_ERROR);
+	UNIT_CHECK(halfError.mTexCoord >= 0.5f);
+}
+
+UNIT_TEST(VertexCompressionFloatFormatsAreExact)
+{
+	VertexTestData* pData = (VertexTestData*)conf_malloc(sizeof(VertexTestData));
+	fillVertexTestData(pData, float3(-1.0f), float3(1.0f), 100.0f);
+
+	VertexCompressionDesc desc;
+	desc.mPositionFormat = VERTEX_POSITION_FLOAT32;
+	desc.mNormalFormat = VERTEX_NORMAL_FLOAT32;
+	desc.mTangentFormat = VERTEX_TANGENT_FLOAT32;
+	desc.mTexCoordFormat = VERTEX_TEXCOORD_FLOAT32;
+	VertexCompressionError error;
+	checkFormats(desc, pData, &error);
+	conf_free(pData);
+
+	UNIT_CHECK(error.mOutOfBoundsCount == 0);
+	UNIT_CHECK(error.mPosition == 0.0f);
+	UNIT_CHECK(error.mTexCoord == 0.0f);
+}
+
+UNIT_TEST(VertexCompressionDetectsValuesOutsideBounds)
+{
+	VertexTestData* pData = (VertexTestData*)conf_malloc(sizeof(VertexTestData));
+	fillVertexTestData(pData, float3(0.0f), float3(10.0f), 1.0f);
+
+	VertexCompressionDesc desc;
+	CompressedVertexStreams streams;
+	VertexCompression::Compress(&desc, VERTEX_TEST_COUNT, pData->mPositions, pData->mNormals, pData->mTangents, pData->mBitangents, pData->mTexCoords, &streams);
+
+	// One quantization step off in a position, a flipped bitangent sign and a perturbed normal must all be reported
+	uint16_t* pPositions = (uint16_t*)streams.mPositions.data();
+	pPositions[4 * 100] = pPositions[4 * 100] < 65535 ? pPositions[4 * 100] + 1 : pPositions[4 * 100] - 1;
+	int16_t* pTangents = (int16_t*)streams.mTangents.data();
+	pTangents[4 * 200 + 3] = -pTangents[4 * 200 + 3];
+	uint32_t* pNormals = (uint32_t*)streams.mNormals.data();
+	pNormals[300] = VertexCompression::EncodeOctahedral16(normalize(pData->mNormals[300] + float3(0.01f, 0.0f, 0.0f)));
+
+	VertexCompressionError error = VertexCompression::MeasureError(&streams, pData->mPositions, pData->mNormals, pData->mTangents, pData->mBitangents, pData->mTexCoords);
+	conf_free(pData);
+
+	UNIT_CHECK(error.mBitangentSignMismatches == 1);
+	UNIT_CHECK(error.mOutOfBoundsCount >= 3);
+	UNIT_CHECK(error.mNormal > VERTEX_OCT16_MAX_ANGLE_ERROR);
+}
@@ -35,7 +35,7 @@
 #elif defined(DIRECT3D12) || defined(_DURANGO)
 #define NO_HLSL_DEFINITIONS
 #include "PCDX12/shader_defs.h"
-#elif defined(VULKAN)
+#elif defined(VULKAN) || defined(NULL_RENDERER)
 #define NO_GLSL_DEFINITIONS
 #include "PCVulkan/shader_defs.h"
 #endif
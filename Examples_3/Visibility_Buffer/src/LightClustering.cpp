@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "LightClustering.h"
+
+#include <emmintrin.h>
+#include <float.h>
+#include <math.h>
+
+#include "../../../Common_3/OS/Interfaces/ILogManager.h"
+#include "../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+// Lights are tested against a tile in groups of four
+#define LIGHT_CLUSTER_GROUP_COUNT ((LIGHT_COUNT + 3) / 4)
+
+// Projected lights in structure of arrays layout. Lights which can't touch the screen get a radius of -FLT_MAX so
+// they fail the tile test without a separate branch.
+typedef struct ProjectedLights
+{
+	__m128  mX[LIGHT_CLUSTER_GROUP_COUNT];
+	__m128  mY[LIGHT_CLUSTER_GROUP_COUNT];
+	__m128  mRadius[LIGHT_CLUSTER_GROUP_COUNT];
+	uint8_t mSliceMin[LIGHT_CLUSTER_GROUP_COUNT * 4];
+	uint8_t mSliceMax[LIGHT_CLUSTER_GROUP_COUNT * 4];
+} ProjectedLights;
+
+static inline uint32_t light_slice(const LightClusterGrid* pGrid, float z)
+{
+	if (!(z > pGrid->mNearZ))
+		return 0;
+
+	// NaN and depths past mFarZ end up in the last slice
+	const float slice = logf(z / pGrid->mNearZ) * pGrid->mSliceScale;
+	return slice < (float)(pGrid->mSliceCount - 1) ? (uint32_t)slice : pGrid->mSliceCount - 1;
+}
+
+// Follows the projection of the cluster_lights shader step by step so both produce the same clusters
+static void project_lights(const LightClusterGrid* pGrid, const mat4& mvp, float aspectRatio, const LightData* pLights,
+	uint32_t lightCount, ProjectedLights* pProjected)
+{
+	float* pX = (float*)pProjected->mX;
+	float* pY = (float*)pProjected->mY;
+	float* pRadius = (float*)pProjected->mRadius;
+
+	for (uint32_t i = 0; i < LIGHT_CLUSTER_GROUP_COUNT * 4; ++i)
+	{
+		pX[i] = 0.0f;
+		pY[i] = 0.0f;
+		pRadius[i] = -FLT_MAX;
+		pProjected->mSliceMin[i] = 0;
+		pProjected->mSliceMax[i] = 0;
+
+		if (i >= lightCount)
+			continue;
+
+		// The position is a float3 or a float4 depending on the shader_defs.h of the platform
+		const vec4 clip = mvp * vec4(pLights[i].position.x, pLights[i].position.y, pLights[i].position.z, 1.0f);
+		const float invW = 1.0f / clip.getW();
+
+		// Lights behind the camera are skipped
+		if (!(clip.getZ() * invW >= 0.0f))
+			continue;
+
+		pX[i] = clip.getX() * invW * aspectRatio;
+		pY[i] = clip.getY() * invW;
+		pRadius[i] = LIGHT_SIZE * invW / 0.5f;
+
+		if (pGrid->mSliceCount > 1)
+		{
+			pProjected->mSliceMin[i] = (uint8_t)light_slice(pGrid, clip.getW() - LIGHT_SIZE);
+			pProjected->mSliceMax[i] = (uint8_t)light_slice(pGrid, clip.getW() + LIGHT_SIZE);
+		}
+	}
+}
+
+void addLightClusterGrid(uint32_t sliceCount, float nearZ, float farZ, LightClusterGrid** ppGrid)
+{
+	ASSERT(ppGrid);
+	ASSERT(sliceCount && sliceCount <= LIGHT_CLUSTER_MAX_SLICES);
+	ASSERT((sliceCount == 1 || (nearZ > 0.0f && farZ > nearZ)) && "Depth slices need a valid depth range");
+
+	LightClusterGrid* pGrid = (LightClusterGrid*)conf_calloc(1, sizeof(*pGrid));
+	pGrid->mSliceCount = sliceCount;
+	pGrid->mNearZ = nearZ;
+	pGrid->mFarZ = farZ;
+	pGrid->mSliceScale = sliceCount > 1 ? (float)sliceCount / logf(farZ / nearZ) : 0.0f;
+	pGrid->pLightCounts = (uint32_t*)conf_calloc(sliceCount * LIGHT_CLUSTER_SLICE_SIZE, sizeof(uint32_t));
+	pGrid->pLightIndices = (uint32_t*)conf_calloc(sliceCount * LIGHT_CLUSTER_SLICE_SIZE * LIGHT_COUNT, sizeof(uint32_t));
+
+	*ppGrid = pGrid;
+}
+
+void removeLightClusterGrid(LightClusterGrid* pGrid)
+{
+	ASSERT(pGrid);
+
+	conf_free(pGrid->pLightIndices);
+	conf_free(pGrid->pLightCounts);
+	conf_free(pGrid);
+}
+
+void clusterLights(LightClusterGrid* pGrid, const mat4& mvp, float aspectRatio, const LightData* pLights,
+	uint32_t lightCount, uint32_t bin, uint32_t binCount)
+{
+	ASSERT(pGrid);
+	ASSERT(binCount && bin < binCount);
+	ASSERT(lightCount <= LIGHT_COUNT);
+	ASSERT(pLights || !lightCount);
+
+	// Every bin projects the lights on its own, this is cheap compared to the tile tests and avoids a sync point
+	ProjectedLights projected;
+	project_lights(pGrid, mvp, aspectRatio, pLights, lightCount, &projected);
+	const uint32_t groupCount = (lightCount + 3) / 4;
+
+	const float invClusterWidth = 1.0f / float(LIGHT_CLUSTER_WIDTH);
+	const float invClusterHeight = 1.0f / float(LIGHT_CLUSTER_HEIGHT);
+
+	for (uint32_t iy = bin; iy < LIGHT_CLUSTER_HEIGHT; iy += binCount)
+	{
+		for (uint32_t ix = 0; ix < LIGHT_CLUSTER_WIDTH; ++ix)
+		{
+			// Tile bounds in aspect corrected clip space
+			float clusterLeft = float(ix) * invClusterWidth;
+			float clusterTop = float(iy) * invClusterHeight;
+			float clusterRight = clusterLeft + invClusterWidth;
+			float clusterBottom = clusterTop + invClusterHeight;
+
+			clusterLeft = (clusterLeft * 2.0f - 1.0f) * aspectRatio;
+			clusterTop = clusterTop * 2.0f - 1.0f;
+			clusterRight = (clusterRight * 2.0f - 1.0f) * aspectRatio;
+			clusterBottom = clusterBottom * 2.0f - 1.0f;
+
+			const float clusterDX = clusterLeft - clusterRight;
+			const float clusterDY = clusterTop - clusterBottom;
+			const __m128 clusterCenterX = _mm_set1_ps((clusterLeft + clusterRight) * 0.5f);
+			const __m128 clusterCenterY = _mm_set1_ps((clusterTop + clusterBottom) * 0.5f);
+			const __m128 clusterRadius = _mm_set1_ps(sqrtf(clusterDX * clusterDX + clusterDY * clusterDY) * 0.5f);
+
+			const uint32_t tilePos = LIGHT_CLUSTER_COUNT_POS(ix, iy);
+			for (uint32_t s = 0; s < pGrid->mSliceCount; ++s)
+				pGrid->pLightCounts[tilePos + s * LIGHT_CLUSTER_SLICE_SIZE] = 0;
+
+			for (uint32_t g = 0; g < groupCount; ++g)
+			{
+				// The projected circle of the light overlaps the bounding circle of the tile
+				const __m128 dx = _mm_sub_ps(clusterCenterX, projected.mX[g]);
+				const __m128 dy = _mm_sub_ps(clusterCenterY, projected.mY[g]);
+				const __m128 distanceToCenter = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+				const int overlap = _mm_movemask_ps(_mm_cmplt_ps(distanceToCenter, _mm_add_ps(projected.mRadius[g], clusterRadius)));
+				if (!overlap)
+					continue;
+
+				for (uint32_t k = 0; k < 4; ++k)
+				{
+					if (!(overlap & (1 << k)))
+						continue;
+
+					const uint32_t lightIndex = g * 4 + k;
+					for (uint32_t s = projected.mSliceMin[lightIndex]; s <= projected.mSliceMax[lightIndex]; ++s)
+					{
+						const uint32_t clusterPos = tilePos + s * LIGHT_CLUSTER_SLICE_SIZE;
+						pGrid->pLightIndices[clusterPos * LIGHT_COUNT + pGrid->pLightCounts[clusterPos]++] = lightIndex;
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#ifndef LightClustering_h
+#define LightClustering_h
+
+#include "Geometry.h"
+
+// CPU implementation of the light clustering done by the cluster_lights compute shader.
+// Lights are binned into LIGHT_CLUSTER_WIDTH x LIGHT_CLUSTER_HEIGHT screen tiles with the same projected circle test as
+// the shader, four lights at a time. The screen tiles can optionally be split into depth slices distributed
+// exponentially between mNearZ and mFarZ, a light is added to every slice its sphere overlaps in view depth.
+// The output uses the layout of the light cluster buffers read by the shading passes: the count of tile (ix, iy) of
+// slice s is at LIGHT_CLUSTER_COUNT_POS(ix, iy) + s * LIGHT_CLUSTER_SLICE_SIZE and its light indices start at that
+// position times LIGHT_COUNT. With a single slice both arrays can be uploaded to the GPU buffers as they are.
+// Light indices of a cluster are sorted in ascending order, unlike the shader output which depends on thread timing.
+
+#define LIGHT_CLUSTER_MAX_SLICES 32
+#define LIGHT_CLUSTER_SLICE_SIZE (LIGHT_CLUSTER_WIDTH * LIGHT_CLUSTER_HEIGHT)
+
+typedef struct LightClusterGrid
+{
+	uint32_t  mSliceCount;
+	float     mNearZ;
+	float     mFarZ;
+	float     mSliceScale;		// mSliceCount / log(mFarZ / mNearZ)
+	uint32_t* pLightCounts;		// mSliceCount * LIGHT_CLUSTER_SLICE_SIZE counts
+	uint32_t* pLightIndices;	// mSliceCount * LIGHT_CLUSTER_SLICE_SIZE * LIGHT_COUNT indices
+} LightClusterGrid;
+
+// nearZ and farZ are view space depths and are ignored when sliceCount is 1
+void addLightClusterGrid(uint32_t sliceCount, float nearZ, float farZ, LightClusterGrid** ppGrid);
+void removeLightClusterGrid(LightClusterGrid* pGrid);
+
+// Rows of tiles are interleaved between binCount bins (tile row % binCount == bin) so several threads can cluster the
+// lights into the same grid without synchronization. Every bin clears its own clusters before adding lights to them.
+// aspectRatio is the render target width over its height, lightCount can't be larger than LIGHT_COUNT.
+void clusterLights(LightClusterGrid* pGrid, const mat4& mvp, float aspectRatio, const LightData* pLights,
+	uint32_t lightCount, uint32_t bin = 0, uint32_t binCount = 1);
+
+#endif
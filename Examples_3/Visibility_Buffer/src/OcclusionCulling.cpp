@@ -0,0 +1,477 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "OcclusionCulling.h"
+
+#include <emmintrin.h>
+#include <float.h>
+
+#include "../../../Common_3/OS/Interfaces/ILogManager.h"
+#include "../../../Common_3/OS/Interfaces/IMemoryManager.h"
+
+// Triangles with a vertex closer than this to the eye plane are not used as occluders since there is no near plane clipping
+#define OCCLUSION_MIN_W 1e-4f
+// Triangles reaching further than this many buffer sizes outside the viewport are rejected to keep the setup precise
+#define OCCLUSION_GUARD_BAND 4.0f
+// Inward shift in pixels applied to the triangle edges to absorb rounding errors of the span setup
+#define OCCLUSION_EDGE_EPSILON (1.0f / 64.0f)
+// Bias added to the interpolated farthest depth of a triangle inside a tile
+#define OCCLUSION_DEPTH_BIAS 1e-5f
+
+static inline void load_matrix(const mat4& m, float cols[4][4])
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		const vec4 col = m.getCol(i);
+		cols[i][0] = col.getX();
+		cols[i][1] = col.getY();
+		cols[i][2] = col.getZ();
+		cols[i][3] = col.getW();
+	}
+}
+
+// Returns (1 << n) - 1 for every lane with n in [0, 32]. 2^n is built in the float exponent and converted back since
+// SSE2 has no variable per lane shift. 2^31 and 2^32 both convert to 0x80000000 so the full mask is patched in.
+static inline __m128i low_bits_mask(__m128i n)
+{
+	const __m128i pow2 = _mm_cvttps_epi32(_mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23)));
+	return _mm_or_si128(_mm_sub_epi32(pow2, _mm_set1_epi32(1)), _mm_cmpeq_epi32(n, _mm_set1_epi32(32)));
+}
+
+static inline uint32_t low_bits_mask(uint32_t n)
+{
+	return n >= 32 ? ~0u : (1u << n) - 1;
+}
+
+static inline bool is_mask_empty(__m128i mask)
+{
+	return _mm_movemask_epi8(_mm_cmpeq_epi32(mask, _mm_setzero_si128())) == 0xFFFF;
+}
+
+static inline bool is_mask_full(__m128i mask)
+{
+	return _mm_movemask_epi8(_mm_cmpeq_epi32(mask, _mm_set1_epi32(-1))) == 0xFFFF;
+}
+
+// Merges the coverage of a triangle into the two depth layers of a tile
+static inline void update_tile(OcclusionTile* pTile, __m128i coverage, float zTri)
+{
+	if (zTri >= pTile->mZMax0)
+		return;
+
+	__m128i layer = _mm_loadu_si128((const __m128i*)pTile->mMask);
+	if (is_mask_full(coverage))
+	{
+		// The triangle becomes the new reference layer, the working layer is only kept if it is still nearer
+		pTile->mZMax0 = zTri;
+		if (pTile->mZMax1 >= zTri)
+			layer = _mm_setzero_si128();
+	}
+	else
+	{
+		// Discard the working layer when the triangle is much nearer than it, otherwise grow it
+		if (is_mask_empty(layer) || (pTile->mZMax1 - zTri) > (pTile->mZMax0 - pTile->mZMax1))
+		{
+			layer = coverage;
+			pTile->mZMax1 = zTri;
+		}
+		else
+		{
+			layer = _mm_or_si128(layer, coverage);
+			pTile->mZMax1 = pTile->mZMax1 > zTri ? pTile->mZMax1 : zTri;
+		}
+
+		// A full working layer is folded into the reference layer
+		if (is_mask_full(layer))
+		{
+			pTile->mZMax0 = pTile->mZMax1;
+			layer = _mm_setzero_si128();
+		}
+	}
+	_mm_storeu_si128((__m128i*)pTile->mMask, layer);
+}
+
+static inline uint32_t first_bin_row(uint32_t row, uint32_t bin, uint32_t binCount)
+{
+	return row + (bin + binCount - row % binCount) % binCount;
+}
+
+void addOcclusionBuffer(uint32_t width, uint32_t height, OcclusionBuffer** ppBuffer)
+{
+	ASSERT(ppBuffer);
+	ASSERT(width && height && "Occlusion buffer size must be greater than zero");
+	ASSERT(width % OCCLUSION_TILE_WIDTH == 0 && height % OCCLUSION_TILE_HEIGHT == 0 && "Occlusion buffer size must be a multiple of the tile size");
+
+	OcclusionBuffer* pBuffer = (OcclusionBuffer*)conf_calloc(1, sizeof(*pBuffer));
+	pBuffer->mWidth = width;
+	pBuffer->mHeight = height;
+	pBuffer->mTilesX = width / OCCLUSION_TILE_WIDTH;
+	pBuffer->mTilesY = height / OCCLUSION_TILE_HEIGHT;
+	pBuffer->pTiles = (OcclusionTile*)conf_calloc(pBuffer->mTilesX * pBuffer->mTilesY, sizeof(OcclusionTile));
+	clearOcclusionBuffer(pBuffer);
+
+	*ppBuffer = pBuffer;
+}
+
+void removeOcclusionBuffer(OcclusionBuffer* pBuffer)
+{
+	ASSERT(pBuffer);
+
+	conf_free(pBuffer->pTiles);
+	conf_free(pBuffer);
+}
+
+void clearOcclusionBuffer(OcclusionBuffer* pBuffer, uint32_t bin, uint32_t binCount)
+{
+	ASSERT(pBuffer);
+	ASSERT(binCount && bin < binCount);
+
+	for (uint32_t ty = bin; ty < pBuffer->mTilesY; ty += binCount)
+	{
+		OcclusionTile* pTile = pBuffer->pTiles + ty * pBuffer->mTilesX;
+		for (uint32_t tx = 0; tx < pBuffer->mTilesX; ++tx, ++pTile)
+		{
+			memset(pTile->mMask, 0, sizeof(pTile->mMask));
+			pTile->mZMax0 = FLT_MAX;
+			pTile->mZMax1 = FLT_MAX;
+		}
+	}
+}
+
+void renderOccluders(OcclusionBuffer* pBuffer, const mat4& mvp, const float3* pPositions, const uint32_t* pIndices,
+	uint32_t triangleCount, OcclusionCullMode cullMode, uint32_t bin, uint32_t binCount)
+{
+	ASSERT(pBuffer && pPositions && pIndices);
+	ASSERT(binCount && bin < binCount);
+
+	float m[4][4];
+	load_matrix(mvp, m);
+	const __m128 col0 = _mm_loadu_ps(m[0]);
+	const __m128 col1 = _mm_loadu_ps(m[1]);
+	const __m128 col2 = _mm_loadu_ps(m[2]);
+	const __m128 col3 = _mm_loadu_ps(m[3]);
+
+	const float width = (float)pBuffer->mWidth;
+	const float height = (float)pBuffer->mHeight;
+	const float guardMinX = -OCCLUSION_GUARD_BAND * width;
+	const float guardMaxX = (1.0f + OCCLUSION_GUARD_BAND) * width;
+	const float guardMinY = -OCCLUSION_GUARD_BAND * height;
+	const float guardMaxY = (1.0f + OCCLUSION_GUARD_BAND) * height;
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 widthV = _mm_set1_ps(width);
+	const __m128 tileWidthV = _mm_set1_ps((float)OCCLUSION_TILE_WIDTH);
+	const __m128 rowOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+	for (uint32_t t = 0; t < triangleCount; ++t)
+	{
+		/************************************************************************/
+		// Transform and project
+		/************************************************************************/
+		float x[3], y[3], z[3];
+		bool rejected = false;
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			const float3& p = pPositions[pIndices[t * 3 + k]];
+			__m128 clipV = _mm_add_ps(_mm_mul_ps(col0, _mm_set1_ps(p.x)), _mm_mul_ps(col1, _mm_set1_ps(p.y)));
+			clipV = _mm_add_ps(_mm_add_ps(clipV, _mm_mul_ps(col2, _mm_set1_ps(p.z))), col3);
+			float clip[4];
+			_mm_storeu_ps(clip, clipV);
+
+			if (!(clip[3] > OCCLUSION_MIN_W) || clip[2] < 0.0f)
+			{
+				rejected = true;
+				break;
+			}
+
+			const float invW = 1.0f / clip[3];
+			x[k] = (clip[0] * invW * 0.5f + 0.5f) * width;
+			y[k] = (0.5f - clip[1] * invW * 0.5f) * height;
+			z[k] = clip[2] * invW;
+			if (!(x[k] >= guardMinX && x[k] <= guardMaxX && y[k] >= guardMinY && y[k] <= guardMaxY))
+			{
+				rejected = true;
+				break;
+			}
+		}
+		if (rejected)
+			continue;
+
+		/************************************************************************/
+		// Face culling. Positive area is clockwise on screen.
+		/************************************************************************/
+		float area2 = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+		if ((cullMode == OCCLUSION_CULL_CW && area2 > 0.0f) || (cullMode == OCCLUSION_CULL_CCW && area2 < 0.0f) || area2 == 0.0f)
+			continue;
+		if (area2 < 0.0f)
+		{
+			float tmp;
+			tmp = x[1]; x[1] = x[2]; x[2] = tmp;
+			tmp = y[1]; y[1] = y[2]; y[2] = tmp;
+			tmp = z[1]; z[1] = z[2]; z[2] = tmp;
+			area2 = -area2;
+		}
+
+		/************************************************************************/
+		// Pixels fully covered by the bounding box
+		/************************************************************************/
+		const float minX = fminf(x[0], fminf(x[1], x[2]));
+		const float maxX = fmaxf(x[0], fmaxf(x[1], x[2]));
+		const float minY = fminf(y[0], fminf(y[1], y[2]));
+		const float maxY = fmaxf(y[0], fmaxf(y[1], y[2]));
+
+		const int pixelX0 = (int)fmaxf(ceilf(minX + OCCLUSION_EDGE_EPSILON), 0.0f);
+		const int pixelX1 = (int)fminf(floorf(maxX - OCCLUSION_EDGE_EPSILON), width);
+		const int pixelY0 = (int)fmaxf(ceilf(minY + OCCLUSION_EDGE_EPSILON), 0.0f);
+		const int pixelY1 = (int)fminf(floorf(maxY - OCCLUSION_EDGE_EPSILON), height);
+		if (pixelX0 >= pixelX1 || pixelY0 >= pixelY1)
+			continue;
+
+		const uint32_t tileX0 = (uint32_t)pixelX0 / OCCLUSION_TILE_WIDTH;
+		const uint32_t tileX1 = (uint32_t)(pixelX1 - 1) / OCCLUSION_TILE_WIDTH;
+		const uint32_t tileY0 = first_bin_row((uint32_t)pixelY0 / OCCLUSION_TILE_HEIGHT, bin, binCount);
+		const uint32_t tileY1 = (uint32_t)(pixelY1 - 1) / OCCLUSION_TILE_HEIGHT;
+		if (tileY0 > tileY1)
+			continue;
+
+		/************************************************************************/
+		// Edge and depth setup
+		/************************************************************************/
+		// Edges going up on screen bound the spans on the left, edges going down on the right.
+		// Horizontal edges are at the top or bottom of the triangle and already handled by the bounding box.
+		__m128 leftX[3], leftSlope[3], rightX[3], rightSlope[3];
+		uint32_t leftCount = 0, rightCount = 0;
+		for (uint32_t e = 0; e < 3; ++e)
+		{
+			const uint32_t a = e;
+			const uint32_t b = (e + 1) % 3;
+			const float dy = y[b] - y[a];
+			if (fabsf(dy) < OCCLUSION_EDGE_EPSILON)
+				continue;
+
+			// Offsetting x by the slope keeps the inward shift roughly perpendicular to the edge
+			const float dxdy = (x[b] - x[a]) / dy;
+			const float offset = OCCLUSION_EDGE_EPSILON * (1.0f + fabsf(dxdy));
+			if (dy < 0.0f)
+			{
+				leftX[leftCount] = _mm_set1_ps(x[a] - y[a] * dxdy + offset);
+				leftSlope[leftCount++] = _mm_set1_ps(dxdy);
+			}
+			else
+			{
+				rightX[rightCount] = _mm_set1_ps(x[a] - y[a] * dxdy - offset);
+				rightSlope[rightCount++] = _mm_set1_ps(dxdy);
+			}
+		}
+
+		const float dx1 = x[1] - x[0], dy1 = y[1] - y[0], dz1 = z[1] - z[0];
+		const float dx2 = x[2] - x[0], dy2 = y[2] - y[0], dz2 = z[2] - z[0];
+		const float invArea2 = 1.0f / area2;
+		const float zdx = (dz1 * dy2 - dz2 * dy1) * invArea2;
+		const float zdy = (dx1 * dz2 - dx2 * dz1) * invArea2;
+		const float zVertexMax = fmaxf(z[0], fmaxf(z[1], z[2]));
+
+		/************************************************************************/
+		// Rasterize the tiles of this bin
+		/************************************************************************/
+		const __m128 rowMin = _mm_set1_ps((float)pixelY0);
+		const __m128 rowMax = _mm_set1_ps((float)pixelY1);
+		for (uint32_t ty = tileY0; ty <= tileY1; ty += binCount)
+		{
+			const float tileTop = (float)(ty * OCCLUSION_TILE_HEIGHT);
+			const __m128 rowTop = _mm_add_ps(_mm_set1_ps(tileTop), rowOffsets);
+			const __m128 rowBottom = _mm_add_ps(rowTop, _mm_set1_ps(1.0f));
+
+			// Span of pixels fully inside the triangle for each of the 4 rows, edges are evaluated at both row boundaries
+			__m128 spanL = zero;
+			__m128 spanR = widthV;
+			for (uint32_t e = 0; e < leftCount; ++e)
+			{
+				const __m128 top = _mm_add_ps(leftX[e], _mm_mul_ps(rowTop, leftSlope[e]));
+				const __m128 bottom = _mm_add_ps(leftX[e], _mm_mul_ps(rowBottom, leftSlope[e]));
+				spanL = _mm_max_ps(spanL, _mm_max_ps(top, bottom));
+			}
+			for (uint32_t e = 0; e < rightCount; ++e)
+			{
+				const __m128 top = _mm_add_ps(rightX[e], _mm_mul_ps(rowTop, rightSlope[e]));
+				const __m128 bottom = _mm_add_ps(rightX[e], _mm_mul_ps(rowBottom, rightSlope[e]));
+				spanR = _mm_min_ps(spanR, _mm_min_ps(top, bottom));
+			}
+			spanL = _mm_min_ps(spanL, widthV);
+			spanR = _mm_max_ps(spanR, zero);
+
+			// First covered pixel is ceil(L), end is floor(R). Both are positive so truncation does the rounding.
+			__m128 spanStart = _mm_sub_ps(widthV, _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_sub_ps(widthV, spanL))));
+			__m128 spanEnd = _mm_cvtepi32_ps(_mm_cvttps_epi32(spanR));
+			const __m128 rowValid = _mm_and_ps(_mm_cmpge_ps(rowTop, rowMin), _mm_cmplt_ps(rowTop, rowMax));
+			spanEnd = _mm_and_ps(spanEnd, rowValid);
+
+			const float rectY0 = fmaxf(tileTop, (float)pixelY0);
+			const float rectY1 = fminf(tileTop + OCCLUSION_TILE_HEIGHT, (float)pixelY1);
+			const float zRectY = (zdy > 0.0f ? rectY1 : rectY0) - y[0];
+
+			OcclusionTile* pTile = pBuffer->pTiles + ty * pBuffer->mTilesX + tileX0;
+			__m128 tileX = _mm_set1_ps((float)(tileX0 * OCCLUSION_TILE_WIDTH));
+			for (uint32_t tx = tileX0; tx <= tileX1; ++tx, ++pTile, tileX = _mm_add_ps(tileX, tileWidthV))
+			{
+				const __m128i start = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_sub_ps(spanStart, tileX), zero), tileWidthV));
+				const __m128i end = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_sub_ps(spanEnd, tileX), zero), tileWidthV));
+				const __m128i coverage = _mm_andnot_si128(low_bits_mask(start), low_bits_mask(end));
+				if (is_mask_empty(coverage))
+					continue;
+
+				// Farthest depth of the triangle plane over the part of the tile inside the bounding box
+				const float tileLeft = (float)(tx * OCCLUSION_TILE_WIDTH);
+				const float rectX0 = fmaxf(tileLeft, (float)pixelX0);
+				const float rectX1 = fminf(tileLeft + OCCLUSION_TILE_WIDTH, (float)pixelX1);
+				const float zRectX = (zdx > 0.0f ? rectX1 : rectX0) - x[0];
+				const float zTri = fminf(z[0] + zdx * zRectX + zdy * zRectY + OCCLUSION_DEPTH_BIAS, zVertexMax);
+
+				update_tile(pTile, coverage, zTri);
+			}
+		}
+	}
+}
+
+bool isOcclusionBoxVisible(const OcclusionBuffer* pBuffer, const mat4& mvp, const float3& aabbMin, const float3& aabbMax)
+{
+	ASSERT(pBuffer);
+
+	float m[4][4];
+	load_matrix(mvp, m);
+
+	/************************************************************************/
+	// Transform the 8 corners, four at a time
+	/************************************************************************/
+	const __m128 cornerX = _mm_setr_ps(aabbMin.x, aabbMax.x, aabbMin.x, aabbMax.x);
+	const __m128 cornerY = _mm_setr_ps(aabbMin.y, aabbMin.y, aabbMax.y, aabbMax.y);
+	__m128 clip[4][2];
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		const __m128 cornerZ = _mm_set1_ps(i ? aabbMax.z : aabbMin.z);
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			__m128 r = _mm_add_ps(_mm_mul_ps(cornerX, _mm_set1_ps(m[0][c])), _mm_mul_ps(cornerY, _mm_set1_ps(m[1][c])));
+			clip[c][i] = _mm_add_ps(_mm_add_ps(r, _mm_mul_ps(cornerZ, _mm_set1_ps(m[2][c]))), _mm_set1_ps(m[3][c]));
+		}
+	}
+
+	/************************************************************************/
+	// Frustum test
+	/************************************************************************/
+	int outsideRight = 0xF, outsideLeft = 0xF, outsideTop = 0xF, outsideBottom = 0xF, outsideFar = 0xF, crossesNear = 0;
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		const __m128 w = clip[3][i];
+		const __m128 negW = _mm_sub_ps(_mm_setzero_ps(), w);
+		outsideRight &= _mm_movemask_ps(_mm_cmpgt_ps(clip[0][i], w));
+		outsideLeft &= _mm_movemask_ps(_mm_cmplt_ps(clip[0][i], negW));
+		outsideTop &= _mm_movemask_ps(_mm_cmpgt_ps(clip[1][i], w));
+		outsideBottom &= _mm_movemask_ps(_mm_cmplt_ps(clip[1][i], negW));
+		outsideFar &= _mm_movemask_ps(_mm_cmpgt_ps(clip[2][i], w));
+		crossesNear |= _mm_movemask_ps(_mm_or_ps(_mm_cmplt_ps(clip[2][i], _mm_setzero_ps()), _mm_cmple_ps(w, _mm_set1_ps(OCCLUSION_MIN_W))));
+	}
+	if (outsideRight == 0xF || outsideLeft == 0xF || outsideTop == 0xF || outsideBottom == 0xF || outsideFar == 0xF)
+		return false;
+	// Boxes touching the near plane can't be projected safely
+	if (crossesNear)
+		return true;
+
+	/************************************************************************/
+	// Screen rectangle and nearest depth
+	/************************************************************************/
+	const float width = (float)pBuffer->mWidth;
+	const float height = (float)pBuffer->mHeight;
+	float sx[8], sy[8], sz[8];
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		const __m128 invW = _mm_div_ps(_mm_set1_ps(1.0f), clip[3][i]);
+		const __m128 half = _mm_set1_ps(0.5f);
+		_mm_storeu_ps(sx + i * 4, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(clip[0][i], invW), half), half), _mm_set1_ps(width)));
+		_mm_storeu_ps(sy + i * 4, _mm_mul_ps(_mm_sub_ps(half, _mm_mul_ps(_mm_mul_ps(clip[1][i], invW), half)), _mm_set1_ps(height)));
+		_mm_storeu_ps(sz + i * 4, _mm_mul_ps(clip[2][i], invW));
+	}
+	float minX = sx[0], maxX = sx[0], minY = sy[0], maxY = sy[0], zNear = sz[0];
+	for (uint32_t i = 1; i < 8; ++i)
+	{
+		minX = fminf(minX, sx[i]);
+		maxX = fmaxf(maxX, sx[i]);
+		minY = fminf(minY, sy[i]);
+		maxY = fmaxf(maxY, sy[i]);
+		zNear = fminf(zNear, sz[i]);
+	}
+
+	// Every pixel the rectangle touches is tested, at least one pixel in each direction
+	float rectX0 = floorf(minX), rectX1 = ceilf(maxX);
+	float rectY0 = floorf(minY), rectY1 = ceilf(maxY);
+	if (rectX1 <= rectX0)
+		rectX1 = rectX0 + 1.0f;
+	if (rectY1 <= rectY0)
+		rectY1 = rectY0 + 1.0f;
+	const int pixelX0 = (int)fmaxf(rectX0, 0.0f);
+	const int pixelX1 = (int)fminf(rectX1, width);
+	const int pixelY0 = (int)fmaxf(rectY0, 0.0f);
+	const int pixelY1 = (int)fminf(rectY1, height);
+	if (pixelX0 >= pixelX1 || pixelY0 >= pixelY1)
+		return false;
+
+	/************************************************************************/
+	// Depth test against both layers of every tile
+	/************************************************************************/
+	const uint32_t tileX0 = (uint32_t)pixelX0 / OCCLUSION_TILE_WIDTH;
+	const uint32_t tileX1 = (uint32_t)(pixelX1 - 1) / OCCLUSION_TILE_WIDTH;
+	const uint32_t tileY0 = (uint32_t)pixelY0 / OCCLUSION_TILE_HEIGHT;
+	const uint32_t tileY1 = (uint32_t)(pixelY1 - 1) / OCCLUSION_TILE_HEIGHT;
+	for (uint32_t ty = tileY0; ty <= tileY1; ++ty)
+	{
+		uint32_t rowMask[OCCLUSION_TILE_HEIGHT];
+		for (uint32_t r = 0; r < OCCLUSION_TILE_HEIGHT; ++r)
+		{
+			const int row = (int)(ty * OCCLUSION_TILE_HEIGHT + r);
+			rowMask[r] = (row >= pixelY0 && row < pixelY1) ? ~0u : 0u;
+		}
+
+		const OcclusionTile* pTile = pBuffer->pTiles + ty * pBuffer->mTilesX + tileX0;
+		for (uint32_t tx = tileX0; tx <= tileX1; ++tx, ++pTile)
+		{
+			const int tileLeft = (int)(tx * OCCLUSION_TILE_WIDTH);
+			const uint32_t start = (uint32_t)(pixelX0 > tileLeft ? pixelX0 - tileLeft : 0);
+			const uint32_t end = (uint32_t)(pixelX1 - tileLeft < OCCLUSION_TILE_WIDTH ? pixelX1 - tileLeft : OCCLUSION_TILE_WIDTH);
+			const uint32_t columns = low_bits_mask(end) & ~low_bits_mask(start);
+
+			uint32_t outsideLayer = 0, insideLayer = 0;
+			for (uint32_t r = 0; r < OCCLUSION_TILE_HEIGHT; ++r)
+			{
+				const uint32_t rect = columns & rowMask[r];
+				outsideLayer |= rect & ~pTile->mMask[r];
+				insideLayer |= rect & pTile->mMask[r];
+			}
+
+			if ((outsideLayer && zNear <= pTile->mZMax0) || (insideLayer && zNear <= pTile->mZMax1))
+				return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2018 Confetti Interactive Inc.
+ * 
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#ifndef OcclusionCulling_h
+#define OcclusionCulling_h
+
+#include "../../../Common_3/OS/Math/MathTypes.h"
+
+// CPU masked software occlusion culling.
+// Occluder triangles are rasterized into a low resolution buffer made of 32x4 pixel tiles. Instead of a depth per pixel
+// every tile stores two layers: a reference layer covering the whole tile (mZMax0) and a working layer (mMask/mZMax1)
+// covering only the pixels set in the mask. Both depths are the farthest depth of the geometry written to that layer,
+// so the buffer always holds a conservative (never nearer than the truth) depth for each pixel.
+// Coverage is inner conservative: a pixel is only written when the triangle covers the whole pixel square, which keeps
+// the result valid no matter what resolution the GPU renders the same geometry at.
+// Depth follows the renderer convention: z/w in [0, 1] with 0 at the near plane.
+
+#define OCCLUSION_TILE_WIDTH 32
+#define OCCLUSION_TILE_HEIGHT 4
+
+typedef enum OcclusionCullMode
+{
+	OCCLUSION_CULL_NONE = 0,
+	// Winding is as seen on screen with y pointing down
+	OCCLUSION_CULL_CW,
+	OCCLUSION_CULL_CCW,
+} OcclusionCullMode;
+
+typedef struct OcclusionTile
+{
+	uint32_t mMask[OCCLUSION_TILE_HEIGHT];	// Working layer coverage, one 32 pixel row per element
+	float    mZMax0;						// Farthest depth of the reference layer
+	float    mZMax1;						// Farthest depth of the working layer
+	uint32_t mPad[2];
+} OcclusionTile;
+
+typedef struct OcclusionBuffer
+{
+	uint32_t       mWidth;
+	uint32_t       mHeight;
+	uint32_t       mTilesX;
+	uint32_t       mTilesY;
+	OcclusionTile* pTiles;
+} OcclusionBuffer;
+
+// Width must be a multiple of OCCLUSION_TILE_WIDTH and height a multiple of OCCLUSION_TILE_HEIGHT
+void addOcclusionBuffer(uint32_t width, uint32_t height, OcclusionBuffer** ppBuffer);
+void removeOcclusionBuffer(OcclusionBuffer* pBuffer);
+
+// Rows of tiles are interleaved between binCount bins (tile row % binCount == bin) so several threads can clear and
+// rasterize into the same buffer without synchronization. Use bin 0 / binCount 1 to process the whole buffer.
+void clearOcclusionBuffer(OcclusionBuffer* pBuffer, uint32_t bin = 0, uint32_t binCount = 1);
+void renderOccluders(OcclusionBuffer* pBuffer, const mat4& mvp, const float3* pPositions, const uint32_t* pIndices,
+	uint32_t triangleCount, OcclusionCullMode cullMode, uint32_t bin = 0, uint32_t binCount = 1);
+
+// Returns false if the box is outside the view frustum or fully hidden behind the rendered occluders
+bool isOcclusionBoxVisible(const OcclusionBuffer* pBuffer, const mat4& mvp, const float3& aabbMin, const float3& aabbMax);
+
+#endif
@@ -83,7 +83,7 @@
 // This function is used to get the offset of the current material base index depending
 // on the type of geometry and on the culling view.
 #ifdef NO_GLSL_DEFINITIONS
-static uint BaseMaterialBuffer(bool alpha, uint viewID)
+static inline uint BaseMaterialBuffer(bool alpha, uint viewID)
 #else
 uint BaseMaterialBuffer(bool alpha, uint viewID)
 #endif
@@ -29,6 +29,7 @@
 #include "../../../Common_3/OS/UI/UI.h"
 #include "../../../Common_3/OS/UI/UIRenderer.h"
 #include "../../../Common_3/OS/Core/RingBuffer.h"
+#include "../../../Common_3/OS/Core/RadixSort.h"
 #include "../../../Common_3/OS/Image/Image.h"
 #include "../../../Common_3/OS/Interfaces/ILogManager.h"
 #include "../../../Common_3/OS/Interfaces/IFileSystem.h"
@@ -38,6 +39,8 @@
 #include "../../../Common_3/OS/Interfaces/IUIManager.h"
 #include "../../../Common_3/OS/Interfaces/IApp.h"
 #include "Geometry.h"
+#include "OcclusionCulling.h"
+#include "LightClustering.h"
 #include "../../../Common_3/OS/Interfaces/IMemoryManager.h"
 
 #if defined(_DURANGO)
@@ -281,11 +284,19 @@ typedef struct AppSettings
 	// This variable enables or disables triangle filtering. When filtering is disabled, all the scene is rendered unconditionally.
     bool mFilterTriangles = true;
     bool mClusterCulling = true;
+#if !defined(METAL)
+	// Rejects clusters hidden behind large occluders using a CPU rasterized depth buffer, requires cluster culling
+	bool mOcclusionCulling = true;
+#endif
 
     bool mAsyncCompute = true;
 
 	// toggle rendering of local point lights
 	bool mRenderLocalLights = false;
+#if !defined(METAL)
+	// Bins the local lights into the light clusters on the CPU instead of the cluster_lights compute shader
+	bool mCpuLightClustering = false;
+#endif
 
 #if MSAASAMPLECOUNT == 1
 	bool mDrawDebugTargets = true;
@@ -454,6 +465,39 @@ FilterBatchChunk*   pFilterBatchChunk[gImageCount] = { nullptr };
 #else
 const uint32_t		gSmallBatchChunkCount = max(1U, 512U / CLUSTER_SIZE) * 16U;
 FilterBatchChunk*	pFilterBatchChunk[gImageCount][gSmallBatchChunkCount] = { nullptr };
+
+// CPU occlusion culling. Every view gets a low resolution software depth buffer filled with the largest opaque clusters
+// of the scene. The tile rows of each buffer are split into bins so the worker threads can rasterize them in parallel.
+const uint32_t		gOcclusionBufferWidth[gNumViews] = { 256, 320 };
+const uint32_t		gOcclusionBufferHeight[gNumViews] = { 256, 192 };
+const uint32_t		gOccluderTriangleBudget = 24 * 1024;
+const uint32_t		gMaxOcclusionBins = 8;
+
+typedef struct OcclusionBinData
+{
+	uint32_t mView;
+	uint32_t mBin;
+	uint32_t mFrameIdx;
+} OcclusionBinData;
+
+ThreadPool				gThreadSystem;
+uint32_t				gOcclusionBinCount = 1;
+OcclusionBuffer*		pOcclusionBuffers[gNumViews] = { nullptr };
+tinystl::vector<uint32_t>	gOccluderIndices;
+OcclusionBinData		gOcclusionBinData[gNumViews][gMaxOcclusionBins] = {};
+WorkItem				gOcclusionWorkItems[gNumViews][gMaxOcclusionBins];
+
+// CPU light clustering. Each bin handles an interleaved set of light cluster tile rows.
+typedef struct LightClusterBinData
+{
+	uint32_t mBin;
+	uint32_t mFrameIdx;
+} LightClusterBinData;
+
+LightClusterGrid*		pLightClusterGrid = nullptr;
+uint32_t				gLightClusterBinCount = 1;
+LightClusterBinData		gLightClusterBinData[LIGHT_CLUSTER_HEIGHT] = {};
+WorkItem				gLightClusterWorkItems[LIGHT_CLUSTER_HEIGHT];
 #endif
 ICameraController*	pCameraController = nullptr;
 
@@ -473,6 +517,16 @@ RootSignature*		pRootSignatureClearBuffers = nullptr;
 RootSignature*		pRootSignatureClearLightClusters = nullptr;
 RootSignature*		pRootSignatureClusterLights = nullptr;
 RootSignature*		pRootSignatureRenderTexture = nullptr;
+#if defined(METAL)
+// Per mesh descriptor slots resolved once after root signature creation so the draw loops bind by index instead of by name
+uint32_t			gShadowPassPerBatchIndex = (uint32_t)-1;
+uint32_t			gVBPassPerBatchIndex = (uint32_t)-1;
+uint32_t			gVBPassDiffuseMapIndex = (uint32_t)-1;
+uint32_t			gDeferredPassPerBatchIndex = (uint32_t)-1;
+uint32_t			gDeferredPassDiffuseMapIndex = (uint32_t)-1;
+uint32_t			gDeferredPassNormalMapIndex = (uint32_t)-1;
+uint32_t			gDeferredPassSpecularMapIndex = (uint32_t)-1;
+#endif
 RootSignature*		pRootSignaturePaniniPostProcess = nullptr;
 RootSignature*		pRootSignatureAO = nullptr;
 RootSignature*		pRootSignatureResolve = nullptr;
@@ -1331,6 +1385,11 @@ void addTriangleFilteringBuffers()
 		lightClustersDataBufferDesc.ppBuffer = &pLightClusters[frameIdx];
 		addResource(&lightClustersDataBufferDesc);
 	}
+
+#if !defined(METAL)
+	// A single depth slice matches the layout of the light cluster buffers
+	addLightClusterGrid(1, 0.0f, 0.0f, &pLightClusterGrid);
+#endif
 	/************************************************************************/
 	/************************************************************************/
 }
@@ -1585,6 +1644,109 @@ void setResourcesToComputeCompliantState(uint32_t frameIdx, bool submitAndWait)
 }
 #endif
 
+#if !defined(METAL)
+typedef struct OccluderCandidate
+{
+	float			mArea;
+	const Mesh*		pMesh;
+	const Cluster*	pCluster;
+} OccluderCandidate;
+
+// Largest surface area first
+static int CompareOccluderCandidates(const void* pLhs, const void* pRhs)
+{
+	const OccluderCandidate* pA = (const OccluderCandidate*)pLhs;
+	const OccluderCandidate* pB = (const OccluderCandidate*)pRhs;
+	if (pA->mArea != pB->mArea)
+		return pA->mArea > pB->mArea ? -1 : 1;
+	return 0;
+}
+
+// Picks the opaque clusters with the largest surface area as occluders until the triangle budget is used up
+void addOcclusionCulling()
+{
+	uint32_t maxCandidates = 0;
+	for (uint32_t i = 0; i < pScene->numMeshes; ++i)
+		maxCandidates += pScene->meshes[i].clusterCount;
+
+	OccluderCandidate* candidates = (OccluderCandidate*)conf_malloc(maxCandidates * sizeof(OccluderCandidate));
+	uint32_t candidateCount = 0;
+	for (uint32_t i = 0; i < pScene->numMeshes; ++i)
+	{
+		const Mesh* mesh = pScene->meshes + i;
+		if (pScene->materials[mesh->materialId].alphaTested)
+			continue;
+
+		for (uint32_t j = 0; j < mesh->clusterCount; ++j)
+		{
+			const Cluster* cluster = mesh->clusters + j;
+			const uint32_t* indices = pScene->indices.data() + mesh->startIndex + cluster->clusterStart * 3;
+			float area = 0.0f;
+			for (uint32_t t = 0; t < cluster->triangleCount; ++t)
+			{
+				const SceneVertexPos& p0 = pScene->positions[indices[t * 3 + 0]];
+				const SceneVertexPos& p1 = pScene->positions[indices[t * 3 + 1]];
+				const SceneVertexPos& p2 = pScene->positions[indices[t * 3 + 2]];
+				area += length(cross(vec3(p1.x - p0.x, p1.y - p0.y, p1.z - p0.z), vec3(p2.x - p0.x, p2.y - p0.y, p2.z - p0.z)));
+			}
+
+			OccluderCandidate candidate = { area, mesh, cluster };
+			candidates[candidateCount++] = candidate;
+		}
+	}
+	if (candidateCount > 1)
+		qsort(candidates, candidateCount, sizeof(OccluderCandidate), CompareOccluderCandidates);
+
+	gOccluderIndices.reserve(gOccluderTriangleBudget * 3);
+	uint32_t occluderClusters = 0;
+	for (uint32_t i = 0; i < candidateCount; ++i)
+	{
+		const Cluster* cluster = candidates[i].pCluster;
+		if (gOccluderIndices.size() / 3 + cluster->triangleCount > gOccluderTriangleBudget)
+			continue;
+
+		const uint32_t* indices = pScene->indices.data() + candidates[i].pMesh->startIndex + cluster->clusterStart * 3;
+		for (uint32_t k = 0; k < cluster->triangleCount * 3; ++k)
+			gOccluderIndices.push_back(indices[k]);
+		++occluderClusters;
+	}
+	conf_free(candidates);
+	LOGINFOF("Occluders : %u triangles from %u clusters", (uint32_t)gOccluderIndices.size() / 3, occluderClusters);
+
+	for (uint32_t i = 0; i < gNumViews; ++i)
+		addOcclusionBuffer(gOcclusionBufferWidth[i], gOcclusionBufferHeight[i], &pOcclusionBuffers[i]);
+
+	gThreadSystem.CreateThreads(Thread::GetNumCPUCores() - 1);
+	gOcclusionBinCount = min(gThreadSystem.GetNumThreads() + 1, gMaxOcclusionBins);
+	gLightClusterBinCount = min(gThreadSystem.GetNumThreads() + 1, (uint32_t)LIGHT_CLUSTER_HEIGHT);
+}
+
+void removeOcclusionCulling()
+{
+	for (uint32_t i = 0; i < gNumViews; ++i)
+		removeOcclusionBuffer(pOcclusionBuffers[i]);
+
+	gOccluderIndices.clear();
+	gOccluderIndices.shrink_to_fit();
+}
+
+// Thread pool job: clears one bin of a view's occlusion buffer and rasterizes the occluders into it
+void renderOcclusionBin(void* pData)
+{
+	const OcclusionBinData* pBinData = (const OcclusionBinData*)pData;
+	OcclusionBuffer* pBuffer = pOcclusionBuffers[pBinData->mView];
+
+	clearOcclusionBuffer(pBuffer, pBinData->mBin, gOcclusionBinCount);
+	if (gAppSettings.mOcclusionCulling)
+	{
+		// The opaque pipelines cull front faces, which are counter clockwise on screen
+		renderOccluders(pBuffer, gPerFrame[pBinData->mFrameIdx].gPerFrameUniformData.transform[pBinData->mView].mvp,
+			(const float3*)pScene->positions.data(), gOccluderIndices.data(), (uint32_t)gOccluderIndices.size() / 3,
+			OCCLUSION_CULL_CCW, pBinData->mBin, gOcclusionBinCount);
+	}
+}
+#endif
+
 // Main entry point for configuring the demo. This method sets up the renderer and all resources needed for the demo,
 // including scene and shader loading, and setup up the necessary buffers and initial states.
 bool initApp()
@@ -1744,6 +1906,9 @@ bool initApp()
 		CreateClusters(material->twoSided, pScene, mesh);
 	}
 	LOGINFOF("Load clusters : %f ms", clusterTimer.GetUSec(true) / 1000.0f);
+#if !defined(METAL)
+	addOcclusionCulling();
+#endif
 	/************************************************************************/
 	// Texture loading
 	/************************************************************************/
@@ -1899,6 +2064,16 @@ bool initApp()
 
 	addRootSignature(pRenderer, 1, &pShaderClearLightClusters, &pRootSignatureClearLightClusters);
 	addRootSignature(pRenderer, 1, &pShaderClusterLights, &pRootSignatureClusterLights);
+
+#if defined(METAL)
+	gShadowPassPerBatchIndex = getDescriptorIndexFromName(pRootSignatureShadowPass, "perBatch");
+	gVBPassPerBatchIndex = getDescriptorIndexFromName(pRootSignatureVBPass, "perBatch");
+	gVBPassDiffuseMapIndex = getDescriptorIndexFromName(pRootSignatureVBPass, "diffuseMap");
+	gDeferredPassPerBatchIndex = getDescriptorIndexFromName(pRootSignatureDeferredPass, "perBatch");
+	gDeferredPassDiffuseMapIndex = getDescriptorIndexFromName(pRootSignatureDeferredPass, "diffuseMap");
+	gDeferredPassNormalMapIndex = getDescriptorIndexFromName(pRootSignatureDeferredPass, "normalMap");
+	gDeferredPassSpecularMapIndex = getDescriptorIndexFromName(pRootSignatureDeferredPass, "specularMap");
+#endif
 	/************************************************************************/
 	// Setup indirect command signatures
 	/************************************************************************/
@@ -1910,17 +2085,17 @@ bool initApp()
 	indirectArgs[1].mType = INDIRECT_DRAW_INDEX;
 
 	CommandSignatureDesc shadowPassDesc = { pCmdPool, pRootSignatureShadowPass, 2, indirectArgs };
-	pDrawId = &pRootSignatureShadowPass->pDescriptors[pRootSignatureShadowPass->pDescriptorNameToIndexMap[tinystl::hash("indirectRootConstant")]];
+	pDrawId = &pRootSignatureShadowPass->pDescriptors[getDescriptorIndexFromName(pRootSignatureShadowPass, "indirectRootConstant")];
 	indirectArgs[0].mRootParameterIndex = pRootSignatureShadowPass->pRootConstantLayouts[pDrawId->mIndexInParent].mRootIndex;
 	addIndirectCommandSignature(pRenderer, &shadowPassDesc, &pCmdSignatureShadowPass);
 
 	CommandSignatureDesc vbPassDesc = { pCmdPool, pRootSignatureVBPass, 2, indirectArgs };
-	pDrawId = &pRootSignatureVBPass->pDescriptors[pRootSignatureVBPass->pDescriptorNameToIndexMap[tinystl::hash("indirectRootConstant")]];
+	pDrawId = &pRootSignatureVBPass->pDescriptors[getDescriptorIndexFromName(pRootSignatureVBPass, "indirectRootConstant")];
 	indirectArgs[0].mRootParameterIndex = pRootSignatureVBPass->pRootConstantLayouts[pDrawId->mIndexInParent].mRootIndex;
 	addIndirectCommandSignature(pRenderer, &vbPassDesc, &pCmdSignatureVBPass);
 
 	CommandSignatureDesc deferredPassDesc = { pCmdPool, pRootSignatureDeferredPass, 2, indirectArgs };
-	pDrawId = &pRootSignatureDeferredPass->pDescriptors[pRootSignatureDeferredPass->pDescriptorNameToIndexMap[tinystl::hash("indirectRootConstant")]];
+	pDrawId = &pRootSignatureDeferredPass->pDescriptors[getDescriptorIndexFromName(pRootSignatureDeferredPass, "indirectRootConstant")];
 	indirectArgs[0].mRootParameterIndex = pRootSignatureDeferredPass->pRootConstantLayouts[pDrawId->mIndexInParent].mRootIndex;
 	addIndirectCommandSignature(pRenderer, &deferredPassDesc, &pCmdSignatureDeferredPass);
 #else
@@ -2294,6 +2469,11 @@ bool initApp()
 
 	UIProperty localLight("Enable Random Point Lights", gAppSettings.mRenderLocalLights);
 	addProperty(pGuiWindow, &localLight);
+
+#if !defined(METAL)
+	UIProperty cpuLightClustering("CPU Light Clustering", gAppSettings.mCpuLightClustering);
+	addProperty(pGuiWindow, &cpuLightClustering);
+#endif
 	/************************************************************************/
 	// Rendering Settings
 	/************************************************************************/
@@ -2319,6 +2499,11 @@ bool initApp()
 	UIProperty cluster("Cluster Culling", gAppSettings.mClusterCulling);
 	addProperty(pGuiWindow, &cluster);
 
+#if !defined(METAL)
+	UIProperty occlusion("Occlusion Culling", gAppSettings.mOcclusionCulling);
+	addProperty(pGuiWindow, &occlusion);
+#endif
+
 	UIProperty asyncCompute("Async Compute", gAppSettings.mAsyncCompute);
 	addProperty(pGuiWindow, &asyncCompute);
 
@@ -2551,6 +2736,9 @@ void destroyTriangleFilteringBuffers()
 		removeResource(pLightClustersCount[frameIdx]);
 		removeResource(pLightClusters[frameIdx]);
 	}
+#if !defined(METAL)
+	removeLightClusterGrid(pLightClusterGrid);
+#endif
 	/************************************************************************/
 	/************************************************************************/
 }
@@ -2670,6 +2858,10 @@ void exitApp()
 	removeResource(pVertexBufferNormal);
 	removeResource(pVertexBufferTangent);
 
+#if !defined(METAL)
+	removeOcclusionCulling();
+#endif
+
 	// Destroy clusters
 	for (uint32_t i = 0; i < pScene->numMeshes; ++i)
 	{
@@ -2845,7 +3037,7 @@ void drawShadowMapPass(Cmd* cmd, GpuProfiler* pGpuProfiler, uint32_t frameIdx)
 				continue;
 
             DescriptorData meshParams[1] = {};
-            meshParams[0].pName = "perBatch";
+            meshParams[0].mIndex = gShadowPassPerBatchIndex;
             meshParams[0].ppBuffers = &gPerBatchUniformBuffers[m];
             cmdBindDescriptors(cmd, pRootSignatureShadowPass, 1, meshParams);
 			cmdExecuteIndirect(cmd, pCmdSignatureShadowPass, 1, indirectDrawArguments, m * sizeof(VisBufferIndirectCommand), nullptr, 0);
@@ -2948,9 +3140,9 @@ void drawVisibilityBufferPass(Cmd* cmd, GpuProfiler* pGpuProfiler, uint32_t fram
 				continue;
             
             DescriptorData meshParams[2] = {};
-            meshParams[0].pName = "perBatch";
+            meshParams[0].mIndex = gVBPassPerBatchIndex;
             meshParams[0].ppBuffers = &gPerBatchUniformBuffers[m];
-            meshParams[1].pName = "diffuseMap";
+            meshParams[1].mIndex = gVBPassDiffuseMapIndex;
             meshParams[1].ppTextures = &gDiffuseMaps[pScene->meshes[m].materialId];
             cmdBindDescriptors(cmd, pRootSignatureVBPass, 2, meshParams);
             cmdExecuteIndirect(cmd, pCmdSignatureVBPass, 1, indirectDrawArguments, m * sizeof(VisBufferIndirectCommand), nullptr, 0);
@@ -3144,13 +3336,13 @@ void drawDeferredPass(Cmd* cmd, GpuProfiler* pGpuProfiler, uint32_t frameIdx)
 				continue;
 
             DescriptorData meshParams[4] = {};
-            meshParams[0].pName = "perBatch";
+            meshParams[0].mIndex = gDeferredPassPerBatchIndex;
             meshParams[0].ppBuffers = &gPerBatchUniformBuffers[m];
-            meshParams[1].pName = "diffuseMap";
+            meshParams[1].mIndex = gDeferredPassDiffuseMapIndex;
             meshParams[1].ppTextures = &gDiffuseMaps[pScene->meshes[m].materialId];
-            meshParams[2].pName = "normalMap";
+            meshParams[2].mIndex = gDeferredPassNormalMapIndex;
             meshParams[2].ppTextures = &gNormalMaps[pScene->meshes[m].materialId];
-            meshParams[3].pName = "specularMap";
+            meshParams[3].mIndex = gDeferredPassSpecularMapIndex;
             meshParams[3].ppTextures = &gSpecularMaps[pScene->meshes[m].materialId];
             cmdBindDescriptors(cmd, pRootSignatureDeferredPass, 4, meshParams);
             cmdExecuteIndirect(cmd, pCmdSignatureDeferredPass, 1, indirectDrawArguments, m * sizeof(VisBufferIndirectCommand), nullptr, 0);
@@ -3403,6 +3595,38 @@ void computeLightClusters(Cmd *cmd, uint32_t frameIdx)
 	cmdDispatch(cmd, LIGHT_COUNT, 1, 1);
 }
 
+#if !defined(METAL)
+// Thread pool job: bins the lights into one bin of the light cluster tile rows
+void clusterLightsBin(void* pData)
+{
+	const LightClusterBinData* pBinData = (const LightClusterBinData*)pData;
+	const PerFrameConstants* pUniforms = &gPerFrame[pBinData->mFrameIdx].gPerFrameUniformData;
+	const float2 windowSize = pUniforms->cullingViewports[VIEW_CAMERA].windowSize;
+
+	clusterLights(pLightClusterGrid, pUniforms->transform[VIEW_CAMERA].mvp, windowSize.x / windowSize.y, gLightData,
+		gAppSettings.mRenderLocalLights ? LIGHT_COUNT : 0, pBinData->mBin, gLightClusterBinCount);
+}
+
+// Computes the light clusters on the worker threads and uploads them to the light cluster buffers of the frame.
+// This replaces both the clear and the cluster_lights compute passes.
+void computeLightClustersCPU(uint32_t frameIdx)
+{
+	for (uint32_t i = 0; i < gLightClusterBinCount; ++i)
+	{
+		gLightClusterBinData[i] = { i, frameIdx };
+		gLightClusterWorkItems[i].pFunc = clusterLightsBin;
+		gLightClusterWorkItems[i].pData = &gLightClusterBinData[i];
+		gThreadSystem.AddWorkItem(&gLightClusterWorkItems[i]);
+	}
+	gThreadSystem.Complete(0);
+
+	BufferUpdateDesc countUpdate = { pLightClustersCount[frameIdx], pLightClusterGrid->pLightCounts, 0, 0, LIGHT_CLUSTER_SLICE_SIZE * sizeof(uint32_t) };
+	updateResource(&countUpdate);
+	BufferUpdateDesc dataUpdate = { pLightClusters[frameIdx], pLightClusterGrid->pLightIndices, 0, 0, LIGHT_CLUSTER_SLICE_SIZE * LIGHT_COUNT * sizeof(uint32_t) };
+	updateResource(&dataUpdate);
+}
+#endif
+
 // Executes the compute shader that performs triangle filtering on the GPU.
 // This step performs different visibility tests per triangle to determine whether they
 // potentially affect to the final image or not.
@@ -3487,138 +3711,20 @@ bool cullCluster(const Cluster* cluster, vec3 eyes[gNumViews])
 	return false;
 }
 
-static const uint32_t pdep_lut[8] = { 0x0, 0x1, 0x4, 0x5, 0x10, 0x11, 0x14, 0x15 };
-
-static inline int genClipMask(__m128 v)
-{
-	//this checks a vertex against the 6 planes, and stores if they are inside
-	// or outside of the plane
-
-	//w contains the w component of the vector in all 4 slots
-	const __m128 w0 = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
-	const __m128 w1 = _mm_shuffle_ps(v, _mm_setzero_ps(), _MM_SHUFFLE(3, 3, 3, 3));
-
-	//subtract the vector from w, and store in a
-	const __m128 a = _mm_sub_ps(w0, v);
-	//add the vector to w, and store in b
-	const __m128 b = _mm_add_ps(w1, v);
-
-	//compare if a and b are less than zero,
-	// and store the result in fmaska, and fmaskk
-	const __m128 fmaska = _mm_cmplt_ps(a, _mm_setzero_ps());
-	const __m128 fmaskb = _mm_cmplt_ps(b, _mm_setzero_ps());
-
-	//convert those masks to integers, and spread the bits using pdep
-	//const int maska = _pdep_u32(_mm_movemask_ps(fmaska), 0x55);
-	//const int maskb = _pdep_u32(_mm_movemask_ps(fmaskb), 0xAA);
-	const int maska = pdep_lut[(_mm_movemask_ps(fmaska) & 0x7)];
-	const int maskb = pdep_lut[(_mm_movemask_ps(fmaskb) & 0x7)] << 1;
-
-	//or the masks together and and the together with all bits set to 1
-	// NOTE only the bits 0x3f are actually used
-	return (maska | maskb) & 0x3f;
-}
-
-//static inline uint32_t genClipMask(float4 f)
-//{
-//	uint32_t result = 0;
-//
-//	//X
-//	if (f.x <= f.w)  result |=  0x1;
-//	if (f.x >= -f.w) result |=  0x2;
-//
-//	//Y
-//	if (f.y <= f.w)  result |=  0x4;
-//	if (f.y >= -f.w) result |=  0x8;
-//
-//	//Z
-//	if (f.z <= f.w)  result |= 0x10;
-//	if (f.z >= 0)    result |= 0x20;
-//	return result;
-//}
-
+#if !defined(METAL)
+// Determines if the cluster can be safely culled because its bounding box is outside the frustum or hidden behind the
+// occluders rendered into the CPU occlusion buffers. Like the cone test this only culls clusters that are not visible
+// from any of the views. With occlusion culling disabled the buffers are only cleared and this is a plain frustum test.
 bool frustumCullCluster(const Cluster* cluster, Transform transforms[gNumViews])
 {
-	return false;
-
-#if 0
-	//TODO: Should we support world matrix transformations? Would be nice to have :)
-
-	//Unpack the AABB into a cube
-	float3 p0 = cluster->aabbMin;
-	float3 p1 = cluster->aabbMax;
-
-	vec3 cube[8] = {
-		vec3(p0.x, p0.y, p0.z),
-		vec3(p0.x, p0.y, p1.z),
-		vec3(p0.x, p1.y, p0.z),
-		vec3(p0.x, p1.y, p1.z),
-		vec3(p1.x, p0.y, p0.z),
-		vec3(p1.x, p0.y, p1.z),
-		vec3(p1.x, p1.y, p0.z),
-		vec3(p1.x, p1.y, p1.z),
-	};
-
-	//Generate a mask based on what verices of this cube are inside the frustums and which are not
-	uint32_t mask = 0;
 	for (uint32_t i = 0; i < gNumViews; ++i)
 	{
-		//Transform the AABB to the view's perspective
-		for (int j = 0; j < 8; ++j)
-		{
-			vec4 t = transforms[i].vp * vec4(cube[j].getX(), cube[j].getY(), cube[j].getZ(), 1);
-			mask |= genClipMask(_mm_set_ps(t.getX(), t.getY(), t.getW(), t.getZ()));
-		}
-	}
-	return mask != 0x3f;
-#endif
-}
-
-void sortClusters(Cluster** clusters, uint32_t len)
-{
-	struct StackItem { Cluster** a; uint32_t l; };
-	StackItem stack[512];
-	int stackidx = 0;
-
-	Cluster** current_a = clusters;
-	uint32_t current_l = len;
-
-	for (;;)
-	{
-		Cluster* pivot = current_a[current_l / 2];
-
-		int i, j;
-		for (i = 0, j = current_l - 1; ; ++i, --j)
-		{
-			while (current_a[i]->distanceFromCamera < pivot->distanceFromCamera) i++;
-			while (current_a[j]->distanceFromCamera > pivot->distanceFromCamera) j--;
-
-			if (i >= j) break;
-
-			Cluster* temp = current_a[i];
-			current_a[i] = current_a[j];
-			current_a[j] = temp;
-		}
-
-		if (i > 1)
-		{
-			stack[stackidx].a = current_a;
-			stack[stackidx++].l = i;
-		}
-		if (current_l - i > 1)
-		{
-			stack[stackidx].a = current_a + i;
-			stack[stackidx++].l = current_l - i;
-		}
-
-		if (stackidx == 0)
-			break;
-
-		--stackidx;
-		current_a = stack[stackidx].a;
-		current_l = stack[stackidx].l;
+		if (isOcclusionBoxVisible(pOcclusionBuffers[i], transforms[i].mvp, cluster->aabbMin, cluster->aabbMax))
+			return false;
 	}
+	return true;
 }
+#endif
 
 // This function decides how to do the triangle filtering pass, depending on the flags (hold, filter triangles)
 // - filterTriangles: enables / disables triangle filtering at all. Disabling filtering makes the CPU to set the buffer states to render the whole scene.
@@ -3705,6 +3811,22 @@ void triangleFilteringPass(Cmd* cmd, GpuProfiler* pGpuProfiler, uint32_t frameId
     // Flush the pending resource updates.
     flushResourceUpdates();
 #else
+	/************************************************************************/
+	// Rasterize the occluders on the worker threads while the GPU commands are recorded
+	/************************************************************************/
+	if (gAppSettings.mClusterCulling)
+	{
+		for (uint32_t i = 0; i < gNumViews; ++i)
+		{
+			for (uint32_t j = 0; j < gOcclusionBinCount; ++j)
+			{
+				gOcclusionBinData[i][j] = { i, j, frameIdx };
+				gOcclusionWorkItems[i][j].pFunc = renderOcclusionBin;
+				gOcclusionWorkItems[i][j].pData = &gOcclusionBinData[i][j];
+				gThreadSystem.AddWorkItem(&gOcclusionWorkItems[i][j]);
+			}
+		}
+	}
 	/************************************************************************/
 	// Barriers to transition uncompacted draw buffer to uav
 	/************************************************************************/
@@ -3773,6 +3895,10 @@ void triangleFilteringPass(Cmd* cmd, GpuProfiler* pGpuProfiler, uint32_t frameId
 	filterParams[5].pName = "uniforms";
 	filterParams[5].ppBuffers = &pPerFrameUniformBuffers[frameIdx];
 	cmdBindDescriptors(cmd, pRootSignatureTriangleFiltering, 6, filterParams);
+
+	// The occlusion buffers have to be complete before the clusters are tested
+	if (gAppSettings.mClusterCulling)
+		gThreadSystem.Complete(0);
 #if 1
 #define SORT_CLUSTERS 1
 
@@ -3783,7 +3909,12 @@ void triangleFilteringPass(Cmd* cmd, GpuProfiler* pGpuProfiler, uint32_t frameId
 		Mesh* drawBatch = &pScene->meshes[i];
 		maxClusterCount = max(maxClusterCount, drawBatch->clusterCount);
 	}
-	Cluster** temporaryClusters = (Cluster**)conf_malloc(sizeof(Cluster) * maxClusterCount);
+	Cluster** temporaryClusters = (Cluster**)conf_malloc(sizeof(Cluster*) * maxClusterCount);
+	// Sort keys are the cluster depths, sort values index into temporaryClusters
+	float* clusterKeys = (float*)conf_malloc(sizeof(float) * maxClusterCount * 2);
+	float* clusterTempKeys = clusterKeys + maxClusterCount;
+	uint32_t* clusterOrder = (uint32_t*)conf_malloc(sizeof(uint32_t) * maxClusterCount * 2);
+	uint32_t* clusterTempOrder = clusterOrder + maxClusterCount;
 #endif
 
 	for (uint32_t i = 0; i < pScene->numMeshes; ++i)
@@ -3802,8 +3933,8 @@ void triangleFilteringPass(Cmd* cmd, GpuProfiler* pGpuProfiler, uint32_t frameId
 
 			// Run cluster culling
 			if (!gAppSettings.mClusterCulling ||
-				!frustumCullCluster(clusterInfo, gPerFrame[frameIdx].gPerFrameUniformData.transform) ||
-				!cullCluster(clusterInfo, gPerFrame[frameIdx].gEyeObjectSpace))
+				!(cullCluster(clusterInfo, gPerFrame[frameIdx].gEyeObjectSpace) ||
+				frustumCullCluster(clusterInfo, gPerFrame[frameIdx].gPerFrameUniformData.transform)))
 			{
 
 
@@ -3832,6 +3963,8 @@ void triangleFilteringPass(Cmd* cmd, GpuProfiler* pGpuProfiler, uint32_t frameId
 				if (std::isnan(clusterInfo->distanceFromCamera))
 					clusterInfo->distanceFromCamera = 0;
 
+				clusterKeys[temporaryClusterCount] = clusterInfo->distanceFromCamera;
+				clusterOrder[temporaryClusterCount] = temporaryClusterCount;
 				temporaryClusters[temporaryClusterCount++] = clusterInfo;
 
 			}
@@ -3840,19 +3973,20 @@ void triangleFilteringPass(Cmd* cmd, GpuProfiler* pGpuProfiler, uint32_t frameId
 		}
 
 		//Sort the clusters
-		sortClusters(temporaryClusters, temporaryClusterCount);
+		RadixSort(clusterKeys, clusterOrder, clusterTempKeys, clusterTempOrder, temporaryClusterCount, RADIX_SORT_ASCENDING);
 
 		//Add clusters to batch chunk
 		for (uint32_t j = 0; j < temporaryClusterCount; ++j)
 		{
+			Cluster* clusterInfo = temporaryClusters[clusterOrder[j]];
 			addClusterToBatchChunk(
-				temporaryClusters[j],
+				clusterInfo,
 				batchStart,
 				accumDrawCount,
 				accumNumTrianglesAtStartOfBatch,
 				i,
 				batchChunk);
-			accumNumTriangles += temporaryClusters[j]->triangleCount;
+			accumNumTriangles += clusterInfo->triangleCount;
 
 			// check to see if we filled the batch
 			if (batchChunk->currentBatchCount >= BATCH_COUNT)
@@ -3877,8 +4011,8 @@ void triangleFilteringPass(Cmd* cmd, GpuProfiler* pGpuProfiler, uint32_t frameId
 
 			// Run cluster culling
 			if (!gAppSettings.mClusterCulling ||
-				!frustumCullCluster(clusterInfo, gPerFrame[frameIdx].gPerFrameUniformData.transform) ||
-				!cullCluster(clusterInfo, gPerFrame[frameIdx].gEyeObjectSpace))
+				!(cullCluster(clusterInfo, gPerFrame[frameIdx].gEyeObjectSpace) ||
+				frustumCullCluster(clusterInfo, gPerFrame[frameIdx].gPerFrameUniformData.transform)))
 			{
 				addClusterToBatchChunk(
 					clusterInfo,
@@ -3921,6 +4055,8 @@ void triangleFilteringPass(Cmd* cmd, GpuProfiler* pGpuProfiler, uint32_t frameId
 
 	}
 #if SORT_CLUSTERS
+	conf_free(clusterOrder);
+	conf_free(clusterKeys);
 	conf_free(temporaryClusters);
 #endif
 
@@ -3936,8 +4072,8 @@ void triangleFilteringPass(Cmd* cmd, GpuProfiler* pGpuProfiler, uint32_t frameId
 
 			// Run cluster culling
 			if (!gAppSettings.mClusterCulling ||
-				!frustumCullCluster(clusterInfo, gPerFrame[frameIdx].gPerFrameUniformData.transform) ||
-				!cullCluster(clusterInfo, gPerFrame[frameIdx].gEyeObjectSpace))
+				!(cullCluster(clusterInfo, gPerFrame[frameIdx].gEyeObjectSpace) ||
+				frustumCullCluster(clusterInfo, gPerFrame[frameIdx].gPerFrameUniformData.transform)))
 			{
 				// cluster culling passed or is turned off
 				// We will now add the cluster to the batch to be triangle filtered
@@ -4312,6 +4448,11 @@ void drawFrame(float deltaTime)
 {
     UNREF_PARAM(deltaTime);
 	uint32_t graphicsFrameIdx = ~0u;
+#if !defined(METAL)
+	const bool gpuLightClustering = !gAppSettings.mCpuLightClustering;
+#else
+	const bool gpuLightClustering = true;
+#endif
 
 	if (!gAppSettings.mAsyncCompute || gFrameCount > 0)
 	{
@@ -4361,9 +4502,10 @@ void drawFrame(float deltaTime)
 
 		triangleFilteringPass(computeCmd, pComputeGpuProfiler, computeFrameIdx);
 
-		clearLightClusters(computeCmd, computeFrameIdx);
+		if (gpuLightClustering)
+			clearLightClusters(computeCmd, computeFrameIdx);
 
-		if (gAppSettings.mRenderLocalLights)
+		if (gpuLightClustering && gAppSettings.mRenderLocalLights)
 		{
 			// Update Light clusters on the GPU
 			cmdBeginGpuTimestampQuery(computeCmd, pComputeGpuProfiler, "Compute Light Clusters");
@@ -4395,6 +4537,13 @@ void drawFrame(float deltaTime)
 		pScreenRenderTarget = pSwapChain->ppSwapchainRenderTargets[graphicsFrameIdx];
 		// Get command list to store rendering commands for this frame
 		graphicsCmd = ppCmds[graphicsFrameIdx];
+
+#if !defined(METAL)
+		// The light clusters of this frame are no longer in use by the GPU, so they can be filled from the CPU directly
+		if (!gpuLightClustering)
+			computeLightClustersCPU(graphicsFrameIdx);
+#endif
+
 		// Submit all render commands for this frame
 		beginCmd(graphicsCmd);
 
@@ -4405,10 +4554,10 @@ void drawFrame(float deltaTime)
 			triangleFilteringPass(graphicsCmd, pGraphicsGpuProfiler, graphicsFrameIdx);
 		}
 
-		if (!gAppSettings.mAsyncCompute)
+		if (!gAppSettings.mAsyncCompute && gpuLightClustering)
 			clearLightClusters(graphicsCmd, (graphicsFrameIdx + 1) % gImageCount);
 
-		if (!gAppSettings.mAsyncCompute && gAppSettings.mRenderLocalLights)
+		if (!gAppSettings.mAsyncCompute && gpuLightClustering && gAppSettings.mRenderLocalLights)
 		{
 			// Update Light clusters on the GPU
 			cmdBeginGpuTimestampQuery(graphicsCmd, pGraphicsGpuProfiler, "Compute Light Clusters");